@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+namespace facebook {
+namespace cachelib {
+
+template <typename CacheT>
+AllocClassTuner<CacheT>::AllocClassTuner(Cache& cache,
+                                         AllocClassTunerConfig config)
+    : cache_(cache), config_(std::move(config)) {}
+
+template <typename CacheT>
+AllocClassTuner<CacheT>::~AllocClassTuner() {
+  stop(std::chrono::seconds(0));
+}
+
+template <typename CacheT>
+void AllocClassTuner<CacheT>::work() {
+  for (const auto pid : cache_.getRegularPoolIds()) {
+    // finish moving away from the classes of a previous reconfiguration
+    // before considering another one.
+    if (releaseRetiredSlabs(pid)) {
+      continue;
+    }
+    tunePool(pid);
+  }
+}
+
+template <typename CacheT>
+bool AllocClassTuner<CacheT>::releaseRetiredSlabs(PoolId pid) {
+  const auto& pool = cache_.getPool(pid);
+  unsigned int numReleased = 0;
+  bool pending = false;
+  for (ClassId cid = 0; static_cast<unsigned int>(cid) < pool.getNumClassId();
+       cid++) {
+    if (pool.isActiveAllocationClass(cid)) {
+      continue;
+    }
+    while (pool.getAllocationClass(cid).getNumSlabs() > 0) {
+      if (numReleased == config_.slabsPerIteration) {
+        return true;
+      }
+      try {
+        AllocClassTunerAPIWrapper<CacheT>::releaseSlab(cache_, pid, cid);
+        ++numSlabsReleased_;
+      } catch (const exception::SlabReleaseAborted& e) {
+        XLOGF(WARN,
+              "Aborted releasing a slab of retired class {} in pool {}: {}",
+              static_cast<int>(cid), static_cast<int>(pid), e.what());
+        return true;
+      } catch (const std::exception& e) {
+        ++numSlabReleaseErrors_;
+        XLOGF(ERR, "Error releasing a slab of retired class {} in pool {}: {}",
+              static_cast<int>(cid), static_cast<int>(pid), e.what());
+        pending = true;
+        break;
+      }
+      ++numReleased;
+    }
+  }
+  return pending;
+}
+
+template <typename CacheT>
+void AllocClassTuner<CacheT>::tunePool(PoolId pid) {
+  const auto samples =
+      AllocClassTunerAPIWrapper<CacheT>::getAllocSizeSamples(cache_, pid);
+  if (samples.size() < config_.minSamples) {
+    return;
+  }
+
+  const auto& pool = cache_.getPool(pid);
+  const auto current = pool.getActiveAllocSizes();
+  const auto numClasses = config_.numClasses
+                              ? config_.numClasses
+                              : static_cast<unsigned int>(current.size());
+  const auto proposed = AllocClassOptimizer::computeAllocSizes(
+      samples, numClasses, current.back());
+
+  size_t numNewClasses = 0;
+  for (const auto size : proposed) {
+    if (!std::binary_search(current.begin(), current.end(), size)) {
+      ++numNewClasses;
+    }
+  }
+  if (numNewClasses == 0 && proposed.size() == current.size()) {
+    return;
+  }
+  if (pool.getNumClassId() + numNewClasses > MemoryPool::kMaxClasses) {
+    XLOGF(DBG, "Pool {} has no class ids left for reconfiguration",
+          static_cast<int>(pid));
+    return;
+  }
+
+  const auto wasteBefore = AllocClassOptimizer::expectedWaste(samples, current);
+  const auto wasteAfter = AllocClassOptimizer::expectedWaste(
+      samples, std::vector<uint32_t>(proposed.begin(), proposed.end()));
+  if (wasteAfter > wasteBefore * (1.0 - config_.minImprovement)) {
+    return;
+  }
+
+  try {
+    cache_.reconfigurePoolAllocSizes(pid, proposed);
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "Error reconfiguring the allocation classes of pool {}: {}",
+          static_cast<int>(pid), e.what());
+    return;
+  }
+  AllocClassTunerAPIWrapper<CacheT>::resetAllocSizeSamples(cache_, pid);
+
+  ++numReconfigurations_;
+  lastWasteBefore_.store(static_cast<uint64_t>(wasteBefore),
+                         std::memory_order_relaxed);
+  lastWasteAfter_.store(static_cast<uint64_t>(wasteAfter),
+                        std::memory_order_relaxed);
+  XLOGF(INFO,
+        "Reconfigured pool {} with {} allocation classes. Expected waste per "
+        "allocation went from {:.1f} to {:.1f} bytes",
+        static_cast<int>(pid), proposed.size(), wasteBefore, wasteAfter);
+}
+
+template <typename CacheT>
+AllocClassTunerStats AllocClassTuner<CacheT>::getStats() const noexcept {
+  AllocClassTunerStats stats;
+  stats.numReconfigurations =
+      numReconfigurations_.load(std::memory_order_relaxed);
+  stats.numSlabsReleased = numSlabsReleased_.load(std::memory_order_relaxed);
+  stats.numSlabReleaseErrors =
+      numSlabReleaseErrors_.load(std::memory_order_relaxed);
+  stats.lastWastePerAllocBefore =
+      lastWasteBefore_.load(std::memory_order_relaxed);
+  stats.lastWastePerAllocAfter =
+      lastWasteAfter_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/AllocClassTuner.h"
+
+#include <folly/Format.h>
+
+#include <limits>
+
+#include "cachelib/allocator/memory/MemoryAllocator.h"
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace {
+// bytes of slab memory an allocation of the class effectively uses,
+// including its share of the unusable tail of the slab.
+double effectiveAllocSize(uint32_t allocSize) {
+  const auto allocsPerSlab = Slab::kSize / allocSize;
+  return static_cast<double>(Slab::kSize) / static_cast<double>(allocsPerSlab);
+}
+} // namespace
+
+void AllocSizeSampler::recordSample(PoolId pid, uint32_t size) {
+  if (pid < 0 || static_cast<size_t>(pid) >= pools_.size()) {
+    return;
+  }
+
+  auto& pool = pools_[pid];
+  std::lock_guard<std::mutex> l(pool.lock);
+  ++pool.numSeen;
+  if (pool.sizes.size() < kMaxSamples) {
+    pool.sizes.push_back(size);
+    return;
+  }
+
+  // keep each size seen so far with equal probability.
+  const auto idx = folly::Random::rand64(pool.numSeen);
+  if (idx < kMaxSamples) {
+    pool.sizes[idx] = size;
+  }
+}
+
+std::vector<uint32_t> AllocSizeSampler::getSamples(PoolId pid) const {
+  if (pid < 0 || static_cast<size_t>(pid) >= pools_.size()) {
+    return {};
+  }
+
+  const auto& pool = pools_[pid];
+  std::lock_guard<std::mutex> l(pool.lock);
+  return pool.sizes;
+}
+
+void AllocSizeSampler::reset(PoolId pid) {
+  if (pid < 0 || static_cast<size_t>(pid) >= pools_.size()) {
+    return;
+  }
+
+  auto& pool = pools_[pid];
+  std::lock_guard<std::mutex> l(pool.lock);
+  pool.sizes.clear();
+  pool.numSeen = 0;
+}
+
+std::set<uint32_t> AllocClassOptimizer::computeAllocSizes(
+    std::vector<uint32_t> samples,
+    unsigned int numClasses,
+    uint32_t maxAllocSize) {
+  if (numClasses == 0) {
+    throw std::invalid_argument("Need at least one allocation class");
+  }
+  if (maxAllocSize < Slab::kMinAllocSize || maxAllocSize > Slab::kSize) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid max allocation size {}", maxAllocSize));
+  }
+
+  // round the samples up to sizes a class can have and drop the ones that
+  // can not be allocated.
+  samples.erase(std::remove_if(samples.begin(), samples.end(),
+                               [=](uint32_t s) { return s > maxAllocSize; }),
+                samples.end());
+  for (auto& size : samples) {
+    size = std::min(
+        std::max(util::getAlignedSize(size, MemoryAllocator::kAlignment),
+                 static_cast<uint32_t>(Slab::kMinAllocSize)),
+        maxAllocSize);
+  }
+  std::sort(samples.begin(), samples.end());
+
+  // candidate class sizes, along with the number of samples they would be
+  // the smallest fit for and the sum of those sizes. When there are too many
+  // distinct sizes, neighbours are grouped and the group is represented by
+  // its largest size, so that it still fits every sample in the group.
+  std::vector<uint32_t> candidates;
+  std::vector<uint64_t> counts;
+  std::vector<double> sums;
+  const uint64_t groupSize = samples.size() / kMaxCandidates + 1;
+  for (size_t i = 0; i < samples.size();) {
+    size_t j = i;
+    uint64_t count = 0;
+    double sum = 0;
+    while (j < samples.size() &&
+           (count < groupSize || samples[j] == samples[j - 1])) {
+      count++;
+      sum += samples[j];
+      j++;
+    }
+    candidates.push_back(samples[j - 1]);
+    counts.push_back(count);
+    sums.push_back(sum);
+    i = j;
+  }
+  if (candidates.empty() || candidates.back() != maxAllocSize) {
+    candidates.push_back(maxAllocSize);
+    counts.push_back(0);
+    sums.push_back(0);
+  }
+
+  // prefix sums so that the waste of serving a range of candidates with one
+  // class is computed in constant time.
+  const size_t n = candidates.size();
+  std::vector<uint64_t> prefixCount(n + 1, 0);
+  std::vector<double> prefixSum(n + 1, 0);
+  for (size_t i = 0; i < n; i++) {
+    prefixCount[i + 1] = prefixCount[i] + counts[i];
+    prefixSum[i + 1] = prefixSum[i] + sums[i];
+  }
+  // waste of serving candidates [i, j) with a class of size candidates[j-1]
+  auto waste = [&](size_t i, size_t j) {
+    return effectiveAllocSize(candidates[j - 1]) *
+               static_cast<double>(prefixCount[j] - prefixCount[i]) -
+           (prefixSum[j] - prefixSum[i]);
+  };
+
+  // best[k][j] is the least waste of serving the first j candidates with
+  // k + 1 classes, the largest of which is candidates[j-1].
+  const size_t maxClasses = std::min<size_t>(numClasses, n);
+  constexpr double kInf = std::numeric_limits<double>::infinity();
+  std::vector<std::vector<double>> best(maxClasses,
+                                        std::vector<double>(n + 1, kInf));
+  std::vector<std::vector<size_t>> prev(maxClasses,
+                                        std::vector<size_t>(n + 1, 0));
+  for (size_t j = 1; j <= n; j++) {
+    best[0][j] = waste(0, j);
+  }
+  for (size_t k = 1; k < maxClasses; k++) {
+    for (size_t j = k + 1; j <= n; j++) {
+      for (size_t i = k; i < j; i++) {
+        const double w = best[k - 1][i] + waste(i, j);
+        if (w < best[k][j]) {
+          best[k][j] = w;
+          prev[k][j] = i;
+        }
+      }
+    }
+  }
+
+  size_t bestK = 0;
+  for (size_t k = 1; k < maxClasses; k++) {
+    if (best[k][n] < best[bestK][n]) {
+      bestK = k;
+    }
+  }
+
+  std::vector<uint32_t> sizes;
+  for (size_t k = bestK + 1, j = n; k-- > 0;) {
+    sizes.push_back(candidates[j - 1]);
+    j = prev[k][j];
+  }
+  std::reverse(sizes.begin(), sizes.end());
+
+  // a class can grow up to the largest size that fits the same number of
+  // allocations in a slab at no extra cost. A class that grows into the next
+  // one is redundant.
+  std::set<uint32_t> result;
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (i + 1 == sizes.size()) {
+      result.insert(sizes[i]);
+      break;
+    }
+    const auto allocsPerSlab = static_cast<uint32_t>(Slab::kSize / sizes[i]);
+    const auto widest = static_cast<uint32_t>(Slab::kSize / allocsPerSlab) /
+                        MemoryAllocator::kAlignment *
+                        MemoryAllocator::kAlignment;
+    if (widest < sizes[i + 1]) {
+      result.insert(std::max(widest, sizes[i]));
+    }
+  }
+  return result;
+}
+
+double AllocClassOptimizer::expectedWaste(
+    const std::vector<uint32_t>& samples,
+    const std::vector<uint32_t>& allocSizes) {
+  double total = 0;
+  uint64_t count = 0;
+  for (const auto size : samples) {
+    const auto it =
+        std::lower_bound(allocSizes.begin(), allocSizes.end(), size);
+    if (it == allocSizes.end()) {
+      continue;
+    }
+    total += effectiveAllocSize(*it) - static_cast<double>(size);
+    count++;
+  }
+  return count == 0 ? 0 : total / static_cast<double>(count);
+}
+
+} // namespace cachelib
+} // namespace facebook
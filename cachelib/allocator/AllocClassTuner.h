@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Random.h>
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/memory/MemoryPoolManager.h"
+#include "cachelib/allocator/memory/Slab.h"
+#include "cachelib/common/Exceptions.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Samples the allocation sizes requested from each pool. Keeps a bounded,
+// uniform sample of the sizes per pool through reservoir sampling.
+class AllocSizeSampler {
+ public:
+  // max number of sizes kept per pool.
+  static constexpr size_t kMaxSamples = 1 << 14;
+
+  // sample one out of every _sampleRate_ allocations. 0 disables sampling.
+  void setSampleRate(uint32_t sampleRate) noexcept {
+    sampleRate_.store(sampleRate, std::memory_order_relaxed);
+  }
+
+  // record the size of an allocation from the pool if it is sampled.
+  void record(PoolId pid, uint32_t size) {
+    const auto rate = sampleRate_.load(std::memory_order_relaxed);
+    if (rate == 0 || !folly::Random::oneIn(rate)) {
+      return;
+    }
+    recordSample(pid, size);
+  }
+
+  // @return the sizes sampled for the pool since the last reset.
+  std::vector<uint32_t> getSamples(PoolId pid) const;
+
+  // drop the sizes sampled for the pool.
+  void reset(PoolId pid);
+
+ private:
+  struct PoolSamples {
+    mutable std::mutex lock;
+    std::vector<uint32_t> sizes;
+    // number of sizes offered to the reservoir.
+    uint64_t numSeen{0};
+  };
+
+  void recordSample(PoolId pid, uint32_t size);
+
+  std::atomic<uint32_t> sampleRate_{0};
+
+  std::array<PoolSamples, MemoryPoolManager::kMaxPools> pools_;
+};
+
+// Computes the allocation class sizes that waste the least memory for a
+// distribution of allocation sizes. The waste of an allocation is the
+// difference between its size and the size of its class, plus its share of
+// the slab space that is too small for another allocation of the class.
+class AllocClassOptimizer {
+ public:
+  // @param samples       observed allocation sizes
+  // @param numClasses    max number of classes to return
+  // @param maxAllocSize  the size of the largest class. It is always part of
+  //                      the result so that every size that could be
+  //                      allocated before still can be.
+  // @return  the class sizes, aligned and within the slab size limits.
+  // @throw std::invalid_argument if numClasses or maxAllocSize is invalid.
+  static std::set<uint32_t> computeAllocSizes(std::vector<uint32_t> samples,
+                                              unsigned int numClasses,
+                                              uint32_t maxAllocSize);
+
+  // @param samples     observed allocation sizes
+  // @param allocSizes  sorted class sizes
+  // @return  average number of bytes wasted per allocation. Samples larger
+  //          than the largest class are ignored.
+  static double expectedWaste(const std::vector<uint32_t>& samples,
+                              const std::vector<uint32_t>& allocSizes);
+
+ private:
+  // max number of distinct sizes considered as class sizes. Sizes beyond this
+  // are grouped so that the search stays cheap.
+  static constexpr size_t kMaxCandidates = 512;
+};
+
+struct AllocClassTunerConfig {
+  // sample one out of this many allocations.
+  uint32_t sampleRate{100};
+
+  // min number of sampled sizes in a pool before it is tuned.
+  size_t minSamples{5000};
+
+  // number of classes to use for a pool. 0 keeps the number of classes the
+  // pool currently has.
+  unsigned int numClasses{0};
+
+  // a pool is only reconfigured when the new classes reduce the expected
+  // waste by at least this fraction.
+  double minImprovement{0.1};
+
+  // number of slabs released per pool and run from classes retired by a
+  // reconfiguration.
+  unsigned int slabsPerIteration{1};
+};
+
+// wrapper that exposes the private APIs of CacheType that are specifically
+// needed for the AllocClassTuner.
+template <typename C>
+struct AllocClassTunerAPIWrapper {
+  static std::vector<uint32_t> getAllocSizeSamples(C& cache, PoolId pid) {
+    return cache.allocSizeSampler_.getSamples(pid);
+  }
+
+  static void resetAllocSizeSamples(C& cache, PoolId pid) {
+    cache.allocSizeSampler_.reset(pid);
+  }
+
+  static void releaseSlab(C& cache, PoolId pid, ClassId victim) {
+    cache.releaseSlab(pid, victim, Slab::kInvalidClassId,
+                      SlabReleaseMode::kRebalance);
+  }
+};
+
+// Periodic worker that tunes the allocation classes of each pool to the item
+// sizes it observes. When a different set of classes would waste noticeably
+// less memory, the pool is switched to it. The slabs of the classes that are
+// no longer used are then released a few at a time, moving or evicting their
+// items, and the memory goes to the new classes.
+template <typename CacheT>
+class AllocClassTuner : public PeriodicWorker {
+ public:
+  using Cache = CacheT;
+  // @param cache   instance of the cache
+  // @param config  tuning config
+  AllocClassTuner(Cache& cache, AllocClassTunerConfig config);
+
+  ~AllocClassTuner();
+
+  AllocClassTunerStats getStats() const noexcept;
+
+ private:
+  // implement logic in the virtual function in PeriodicWorker
+  void work() override final;
+
+  // release slabs from classes of the pool that are no longer active.
+  // @return true if such classes still hold slabs.
+  bool releaseRetiredSlabs(PoolId pid);
+
+  // reconfigure the pool if its sampled sizes call for different classes.
+  void tunePool(PoolId pid);
+
+  // reference to the cache
+  Cache& cache_;
+
+  const AllocClassTunerConfig config_;
+
+  std::atomic<uint64_t> numReconfigurations_{0};
+  std::atomic<uint64_t> numSlabsReleased_{0};
+  std::atomic<uint64_t> numSlabReleaseErrors_{0};
+  std::atomic<uint64_t> lastWasteBefore_{0};
+  std::atomic<uint64_t> lastWasteAfter_{0};
+};
+
+} // namespace cachelib
+} // namespace facebook
+
+#include "cachelib/allocator/AllocClassTuner-inl.h"
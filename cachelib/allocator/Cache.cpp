@@ -169,6 +169,11 @@ void CacheBase::updateCompactCacheStats(const std::string& statPrefix,
   counters_.updateDelta(prefix + "timeout.lock", stats.lockTimeout);
   counters_.updateDelta(prefix + "timeout.promote", stats.promoteTimeout);
 
+  counters_.updateDelta(prefix + "optimistic_read.retries",
+                        stats.optimisticReadRetries);
+  counters_.updateDelta(prefix + "optimistic_read.fallbacks",
+                        stats.optimisticReadFallbacks);
+
   const double hitRate =
       util::hitRatioCalc(counters_.getDelta(prefix + "get.total"),
                          counters_.getDelta(prefix + "get.miss"));
@@ -183,6 +188,13 @@ void CacheBase::updateEventTrackerStats(const std::string& statPrefix) const {
   }
 }
 
+void CacheBase::updateKeyPrefixStats(const std::string& statPrefix) const {
+  const std::string prefix = statPrefix + "key_prefix.";
+  for (const auto& kv : getKeyPrefixStatsMap()) {
+    counters_.updateDelta(prefix + kv.first, kv.second);
+  }
+}
+
 void CacheBase::updateNvmCacheStats(const std::string& statPrefix) const {
   const std::string prefix = statPrefix + "nvm.";
   auto statsMap = getNvmCacheStatsMap();
@@ -258,6 +270,14 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
                         stats.numCacheRemoveRamHits);
   counters_.updateDelta(statPrefix + "cache.evictions",
                         stats.numCacheEvictions);
+  counters_.updateDelta(statPrefix + "cache.tier.demotions",
+                        stats.numTierDemotions);
+  counters_.updateDelta(statPrefix + "cache.tier.demotion_failures",
+                        stats.numTierDemotionFailures);
+  counters_.updateDelta(statPrefix + "cache.tier.promotions",
+                        stats.numTierPromotions);
+  counters_.updateDelta(statPrefix + "cache.tier.promotion_failures",
+                        stats.numTierPromotionFailures);
   counters_.updateDelta(statPrefix + "cache.refcount_overflows",
                         stats.numRefcountOverflow);
   counters_.updateDelta(statPrefix + "cache.destructors.exceptions",
@@ -284,6 +304,17 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
   counters_.updateDelta(statPrefix + "reaper.skipped_slabs",
                         stats.numReaperSkippedSlabs);
 
+  counters_.updateDelta(statPrefix + "alloc_class_tuner.reconfigurations",
+                        stats.allocClassTunerStats.numReconfigurations);
+  counters_.updateDelta(statPrefix + "alloc_class_tuner.released_slabs",
+                        stats.allocClassTunerStats.numSlabsReleased);
+  counters_.updateDelta(statPrefix + "alloc_class_tuner.release_errors",
+                        stats.allocClassTunerStats.numSlabReleaseErrors);
+  counters_.updateCount(statPrefix + "alloc_class_tuner.waste_before_bytes",
+                        stats.allocClassTunerStats.lastWastePerAllocBefore);
+  counters_.updateCount(statPrefix + "alloc_class_tuner.waste_after_bytes",
+                        stats.allocClassTunerStats.lastWastePerAllocAfter);
+
   const auto slabReleaseStats = getSlabReleaseStats();
   counters_.updateDelta(statPrefix + "slabs.rebalancer_runs",
                         slabReleaseStats.numSlabReleaseForRebalanceAttempts);
@@ -496,6 +527,7 @@ void CacheBase::exportStats(
   updateGlobalCacheStats(statPrefix);
   updateNvmCacheStats(statPrefix);
   updateEventTrackerStats(statPrefix);
+  updateKeyPrefixStats(statPrefix);
 
   for (const auto pid : getRegularPoolIds()) {
     updatePoolStats(statPrefix, pid);
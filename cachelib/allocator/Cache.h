@@ -125,6 +125,16 @@ class CacheBase {
   virtual std::unordered_map<std::string, uint64_t> getEventTrackerStatsMap()
       const = 0;
 
+  // @return a map of <prefix>.<stat name> -> stat value for the key prefix
+  // stats. If key prefix stats are not enabled, this will be empty
+  virtual std::unordered_map<std::string, uint64_t> getKeyPrefixStatsMap()
+      const = 0;
+
+  // @param pid   pool id
+  // @return the miss ratio curve estimated for the pool. Empty if miss ratio
+  //         curve estimation is not enabled.
+  virtual PoolMissRatioCurve getPoolMissRatioCurve(PoolId pid) const = 0;
+
   // @return the Cache metadata
   virtual CacheMetadata getCacheMetadata() const noexcept = 0;
 
@@ -308,6 +318,9 @@ class CacheBase {
   // Update stats specific to the event tracker
   void updateEventTrackerStats(const std::string& statPrefix) const;
 
+  // Update stats specific to key prefixes
+  void updateKeyPrefixStats(const std::string& statPrefix) const;
+
   // Update stats specific to NvmCache
   void updateNvmCacheStats(const std::string& statPrefix) const;
 
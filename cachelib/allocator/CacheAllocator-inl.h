@@ -53,9 +53,8 @@ CacheAllocator<CacheTrait>::CacheAllocator(
     : isOnShm_{type != InitMemType::kNone ? true
                                           : config.memMonitoringEnabled()},
       config_(config.validate()),
-      tempShm_(type == InitMemType::kNone && isOnShm_
-                   ? std::make_unique<TempShmMapping>(config_.size)
-                   : nullptr),
+      tempShm_(createTempShmMapping(type, 0)),
+      lowerTierShms_(createLowerTierTempShms(type)),
       shmManager_(type != InitMemType::kNone
                       ? std::make_unique<ShmManager>(config_.cacheDir,
                                                      config_.usePosixShm)
@@ -65,14 +64,13 @@ CacheAllocator<CacheTrait>::CacheAllocator(
       metadata_{type == InitMemType::kMemAttach
                     ? deserializeCacheAllocatorMetadata(*deserializer_)
                     : serialization::CacheAllocatorMetadata{}},
-      allocator_(initAllocator(type)),
+      allocators_(initAllocators(type)),
+      allocator_(allocators_[0].get()),
       compactCacheManager_(type != InitMemType::kMemAttach
                                ? std::make_unique<CCacheManager>(*allocator_)
                                : restoreCCacheManager()),
       compressor_(createPtrCompressor()),
-      mmContainers_(type == InitMemType::kMemAttach
-                        ? deserializeMMContainers(*deserializer_, compressor_)
-                        : MMContainers{}),
+      mmContainers_(initMMContainers(type)),
       accessContainer_(initAccessContainer(
           type, detail::kShmHashTableName, config.accessConfig)),
       chainedItemAccessContainer_(
@@ -105,17 +103,61 @@ CacheAllocator<CacheTrait>::~CacheAllocator() {
 }
 
 template <typename CacheTrait>
-ShmSegmentOpts CacheAllocator<CacheTrait>::createShmCacheOpts() {
+ShmSegmentOpts CacheAllocator<CacheTrait>::createShmCacheOpts(TierId tid) {
   ShmSegmentOpts opts;
   opts.alignment = sizeof(Slab);
-  auto memoryTierConfigs = config_.getMemoryTierConfigs();
-  // TODO: we support single tier so far
-  XDCHECK_EQ(memoryTierConfigs.size(), 1ul);
-  opts.memBindNumaNodes = memoryTierConfigs[0].getMemBind();
+  const auto& tierConfig = config_.getMemoryTierConfigs()[tid];
+  opts.memBindNumaNodes = tierConfig.getMemBind();
+  opts.filePath = tierConfig.getPath();
 
   return opts;
 }
 
+template <typename CacheTrait>
+size_t CacheAllocator<CacheTrait>::getTierSize(TierId tid) const {
+  const auto& tierConfigs = config_.getMemoryTierConfigs();
+  if (tierConfigs.size() == 1) {
+    return config_.size;
+  }
+
+  size_t partitions = 0;
+  for (const auto& tierConfig : tierConfigs) {
+    partitions += tierConfig.getRatio();
+  }
+  return tierConfigs[tid].calculateTierSize(config_.size, partitions);
+}
+
+template <typename CacheTrait>
+std::unique_ptr<TempShmMapping> CacheAllocator<CacheTrait>::createTempShmMapping(
+    InitMemType type, TierId tid) {
+  if (type != InitMemType::kNone) {
+    return nullptr;
+  }
+
+  const bool isFileBacked =
+      config_.getMemoryTierConfigs()[tid].isFileBacked();
+  // the top tier is on the heap unless it is file backed or the memory
+  // monitor needs it on shm. Lower tiers always live on temporary mappings.
+  if (tid == 0 && !isOnShm_ && !isFileBacked) {
+    return nullptr;
+  }
+  return std::make_unique<TempShmMapping>(getTierSize(tid),
+                                          createShmCacheOpts(tid));
+}
+
+template <typename CacheTrait>
+std::vector<std::unique_ptr<TempShmMapping>>
+CacheAllocator<CacheTrait>::createLowerTierTempShms(InitMemType type) {
+  std::vector<std::unique_ptr<TempShmMapping>> shms;
+  shms.emplace_back(nullptr);
+  for (TierId tid = 1;
+       static_cast<size_t>(tid) < config_.getMemoryTierConfigs().size();
+       tid++) {
+    shms.push_back(createTempShmMapping(type, tid));
+  }
+  return shms;
+}
+
 template <typename CacheTrait>
 std::unique_ptr<MemoryAllocator>
 CacheAllocator<CacheTrait>::createNewMemoryAllocator() {
@@ -123,7 +165,7 @@ CacheAllocator<CacheTrait>::createNewMemoryAllocator() {
       getAllocatorConfig(config_),
       shmManager_
           ->createShm(detail::kShmCacheName, config_.size,
-                      config_.slabMemoryBaseAddr, createShmCacheOpts())
+                      config_.slabMemoryBaseAddr, createShmCacheOpts(0))
           .addr,
       config_.size);
 }
@@ -135,7 +177,7 @@ CacheAllocator<CacheTrait>::restoreMemoryAllocator() {
       deserializer_->deserialize<MemoryAllocator::SerializationType>(),
       shmManager_
           ->attachShm(detail::kShmCacheName, config_.slabMemoryBaseAddr,
-                      createShmCacheOpts())
+                      createShmCacheOpts(0))
           .addr,
       config_.size,
       config_.disableFullCoredump);
@@ -229,6 +271,11 @@ void CacheAllocator<CacheTrait>::initWorkers() {
     startNewReaper(config_.reaperInterval, config_.reaperConfig);
   }
 
+  if (config_.allocClassTuningEnabled() && !allocClassTuner_) {
+    startNewAllocClassTuner(config_.allocClassTunerInterval,
+                            config_.allocClassTunerConfig);
+  }
+
   if (config_.poolOptimizerEnabled() && !poolOptimizer_) {
     startNewPoolOptimizer(config_.regularPoolOptimizeInterval,
                           config_.compactCacheOptimizeInterval,
@@ -241,12 +288,12 @@ template <typename CacheTrait>
 std::unique_ptr<MemoryAllocator> CacheAllocator<CacheTrait>::initAllocator(
     InitMemType type) {
   if (type == InitMemType::kNone) {
-    if (isOnShm_ == true) {
+    if (tempShm_) {
       return std::make_unique<MemoryAllocator>(
-          getAllocatorConfig(config_), tempShm_->getAddr(), config_.size);
+          getAllocatorConfig(config_), tempShm_->getAddr(), getTierSize(0));
     } else {
       return std::make_unique<MemoryAllocator>(getAllocatorConfig(config_),
-                                               config_.size);
+                                               getTierSize(0));
     }
   } else if (type == InitMemType::kMemNew) {
     return createNewMemoryAllocator();
@@ -260,6 +307,41 @@ std::unique_ptr<MemoryAllocator> CacheAllocator<CacheTrait>::initAllocator(
       static_cast<int>(type)));
 }
 
+template <typename CacheTrait>
+std::unique_ptr<MemoryAllocator>
+CacheAllocator<CacheTrait>::initLowerTierAllocator(TierId tid) {
+  XDCHECK_GT(tid, 0);
+  XDCHECK(lowerTierShms_[tid]);
+  return std::make_unique<MemoryAllocator>(getAllocatorConfig(config_),
+                                           lowerTierShms_[tid]->getAddr(),
+                                           getTierSize(tid));
+}
+
+template <typename CacheTrait>
+std::vector<std::unique_ptr<MemoryAllocator>>
+CacheAllocator<CacheTrait>::initAllocators(InitMemType type) {
+  std::vector<std::unique_ptr<MemoryAllocator>> allocators;
+  allocators.push_back(initAllocator(type));
+  for (TierId tid = 1;
+       static_cast<size_t>(tid) < config_.getMemoryTierConfigs().size();
+       tid++) {
+    allocators.push_back(initLowerTierAllocator(tid));
+  }
+  return allocators;
+}
+
+template <typename CacheTrait>
+std::vector<typename CacheAllocator<CacheTrait>::MMContainers>
+CacheAllocator<CacheTrait>::initMMContainers(InitMemType type) {
+  std::vector<MMContainers> mmContainers(getNumTiers());
+  if (type == InitMemType::kMemAttach) {
+    // persistence is only supported for single tier caches
+    XDCHECK_EQ(getNumTiers(), 1u);
+    mmContainers[0] = deserializeMMContainers(*deserializer_, compressor_);
+  }
+  return mmContainers;
+}
+
 template <typename CacheTrait>
 std::unique_ptr<typename CacheAllocator<CacheTrait>::AccessContainer>
 CacheAllocator<CacheTrait>::initAccessContainer(InitMemType type,
@@ -324,26 +406,72 @@ CacheAllocator<CacheTrait>::allocateInternal(PoolId pid,
                                              typename Item::Key key,
                                              uint32_t size,
                                              uint32_t creationTime,
-                                             uint32_t expiryTime) {
+                                             uint32_t expiryTime,
+                                             bool evict) {
 #ifdef ENABLE_EXPENSIVE_TRACKING
   util::LatencyTracker tracker{stats().allocateLatency_};
 #endif
 
+  auto handle =
+      allocateInternalTier(0, pid, key, size, creationTime, expiryTime, evict);
+
+  if (UNLIKELY(keyPrefixStats_ != nullptr) && handle) {
+    keyPrefixStats_->recordAllocation(key, size);
+  }
+  if (UNLIKELY(missRatioCurves_ != nullptr) && handle) {
+    missRatioCurves_->recordAccess(pid, key, handle->getTotalSize());
+  }
+
+#ifdef ENABLE_EXPENSIVE_TRACKING
+  if (auto eventTracker = getEventTracker()) {
+    const auto result =
+        handle ? AllocatorApiResult::ALLOCATED : AllocatorApiResult::FAILED;
+    eventTracker->record(AllocatorApiEvent::ALLOCATE, key, result, size,
+                         expiryTime ? expiryTime - creationTime : 0);
+  }
+#endif
+
+  return handle;
+}
+
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::allocateInternalTier(TierId tid,
+                                                 PoolId pid,
+                                                 typename Item::Key key,
+                                                 uint32_t size,
+                                                 uint32_t creationTime,
+                                                 uint32_t expiryTime,
+                                                 bool evict) {
   SCOPE_FAIL { stats_.invalidAllocs.inc(); };
 
+  auto& allocator = *allocators_[tid];
+
   // number of bytes required for this item
   const auto requiredSize = Item::getRequiredSize(key, size);
 
   // the allocation class in our memory allocator.
-  const auto cid = allocator_->getAllocationClassId(pid, requiredSize);
+  const auto cid = allocator.getAllocationClassId(pid, requiredSize);
+
+  void* memory = allocator.allocate(pid, requiredSize);
+  if (memory == nullptr && !evict) {
+    // the caller retries with eviction. That attempt is the one sampled and
+    // counted below.
+    return WriteHandle{};
+  }
+
+  // only allocations made on behalf of the user shape the classes. The ones
+  // from moving items across tiers have been sampled already.
+  if (tid == 0) {
+    allocSizeSampler_.record(pid, requiredSize);
+  }
 
 #ifdef ENABLE_EXPENSIVE_TRACKING
   (*stats_.allocAttempts)[pid][cid].inc();
 #endif
 
-  void* memory = allocator_->allocate(pid, requiredSize);
   if (memory == nullptr) {
-    memory = findEviction(pid, cid);
+    memory = findEviction(tid, pid, cid);
   }
 
   WriteHandle handle;
@@ -354,7 +482,7 @@ CacheAllocator<CacheTrait>::allocateInternal(PoolId pid,
     // for example.
     SCOPE_FAIL {
       // free back the memory to the allocator since we failed.
-      allocator_->free(memory);
+      allocator.free(memory);
     };
 
     handle = acquire(new (memory) Item(key, size, creationTime, expiryTime));
@@ -367,20 +495,11 @@ CacheAllocator<CacheTrait>::allocateInternal(PoolId pid,
   } else { // failed to allocate memory.
     (*stats_.allocFailures)[pid][cid].inc();
     // wake up rebalancer
-    if (poolRebalancer_) {
+    if (poolRebalancer_ && tid == 0) {
       poolRebalancer_->wakeUp();
     }
   }
 
-#ifdef ENABLE_EXPENSIVE_TRACKING
-  if (auto eventTracker = getEventTracker()) {
-    const auto result =
-        handle ? AllocatorApiResult::ALLOCATED : AllocatorApiResult::FAILED;
-    eventTracker->record(AllocatorApiEvent::ALLOCATE, key, result, size,
-                         expiryTime ? expiryTime - creationTime : 0);
-  }
-#endif
-
   return handle;
 }
 
@@ -414,21 +533,27 @@ CacheAllocator<CacheTrait>::allocateChainedItemInternal(
   // number of bytes required for this item
   const auto requiredSize = ChainedItem::getRequiredSize(size);
 
-  const auto pid = allocator_->getAllocInfo(parent->getMemory()).poolId;
-  const auto cid = allocator_->getAllocationClassId(pid, requiredSize);
+  // chained items live in the same memory tier as their parent
+  const auto tid = getTierId(*parent);
+  auto& allocator = *allocators_[tid];
+  const auto pid = allocator.getAllocInfo(parent->getMemory()).poolId;
+  const auto cid = allocator.getAllocationClassId(pid, requiredSize);
+  if (tid == 0) {
+    allocSizeSampler_.record(pid, requiredSize);
+  }
 
   (*stats_.allocAttempts)[pid][cid].inc();
 
-  void* memory = allocator_->allocate(pid, requiredSize);
+  void* memory = allocator.allocate(pid, requiredSize);
   if (memory == nullptr) {
-    memory = findEviction(pid, cid);
+    memory = findEviction(tid, pid, cid);
   }
   if (memory == nullptr) {
     (*stats_.allocFailures)[pid][cid].inc();
     return WriteHandle{};
   }
 
-  SCOPE_FAIL { allocator_->free(memory); };
+  SCOPE_FAIL { allocator.free(memory); };
 
   auto child = acquire(
       new (memory) ChainedItem(compressor_.compress(parent.getInternal()), size,
@@ -738,7 +863,8 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
         folly::sformat("cannot release this item: {}", it.toString()));
   }
 
-  const auto allocInfo = allocator_->getAllocInfo(it.getMemory());
+  auto& allocator = *allocators_[getTierId(it)];
+  const auto allocInfo = allocator.getAllocInfo(it.getMemory());
 
 #ifdef ENABLE_EXPENSIVE_TRACKING
   if (ctx == RemoveContext::kEviction) {
@@ -765,7 +891,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
                          it.toString(), toRecycle->toString()));
     }
 
-    allocator_->free(&it);
+    allocator.free(&it);
     return ReleaseRes::kReleased;
   }
 
@@ -834,7 +960,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
       auto next = head->getNext(compressor_);
 
       const auto childInfo =
-          allocator_->getAllocInfo(static_cast<const void*>(head));
+          allocator.getAllocInfo(static_cast<const void*>(head));
       (*stats_.fragmentationSize)[childInfo.poolId][childInfo.classId].sub(
           util::getFragmentation(*this, *head));
 
@@ -867,7 +993,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
           XDCHECK(ReleaseRes::kReleased != res);
           res = ReleaseRes::kRecycled;
         } else {
-          allocator_->free(head);
+          allocator.free(head);
         }
       }
 
@@ -882,7 +1008,7 @@ CacheAllocator<CacheTrait>::releaseBackToAllocator(Item& it,
     res = ReleaseRes::kRecycled;
   } else {
     XDCHECK(it.isDrained());
-    allocator_->free(&it);
+    allocator.free(&it);
   }
 
   return res;
@@ -1110,8 +1236,11 @@ bool CacheAllocator<CacheTrait>::moveRegularItem(Item& oldItem,
   }
 
   XDCHECK_EQ(newItemHdl->getSize(), oldItem.getSize());
-  XDCHECK_EQ(reinterpret_cast<uintptr_t>(&getMMContainer(oldItem)),
-             reinterpret_cast<uintptr_t>(&getMMContainer(*newItemHdl)));
+  // the new item is in another class, and so another MM container, when the
+  // old one is moved out of a class retired by reconfigurePoolAllocSizes().
+  // replaceInMMContainer() moves it between the containers.
+  XDCHECK_EQ(getAllocInfo(static_cast<const void*>(&oldItem)).poolId,
+             getAllocInfo(newItemHdl->getMemory()).poolId);
 
   // take care of the flags before we expose the item to be accessed. this
   // will ensure that when another thread removes the item from RAM, we issue
@@ -1242,8 +1371,9 @@ bool CacheAllocator<CacheTrait>::moveChainedItem(ChainedItem& oldItem,
 
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::Item*
-CacheAllocator<CacheTrait>::findEviction(PoolId pid, ClassId cid) {
-  auto& mmContainer = getMMContainer(pid, cid);
+CacheAllocator<CacheTrait>::findEviction(TierId tid, PoolId pid, ClassId cid) {
+  auto& mmContainer = getMMContainer(tid, pid, cid);
+  const bool hasNextTier = static_cast<size_t>(tid) + 1 < getNumTiers();
 
   // Keep searching for a candidate until we were able to evict it
   // or until the search limit has been exhausted
@@ -1269,6 +1399,22 @@ CacheAllocator<CacheTrait>::findEviction(PoolId pid, ClassId cid) {
       continue;
     }
 
+    // items without chains are moved to the next tier instead of leaving
+    // the memory cache. Items with chains are evicted as usual.
+    if (hasNextTier && candidate == toRecycle &&
+        !candidate->hasChainedItem() && !candidate->isExpired() &&
+        tryDemoteRegularItem(tid, mmContainer, itr)) {
+      const auto ref = candidate->unmarkExclusive();
+      XDCHECK_EQ(ref, 0u);
+      if (ref == 0u) {
+        // the item lives on in the next tier. Its memory is recycled
+        // without invoking any callbacks.
+        return toRecycle;
+      }
+      itr.resetToBegin();
+      continue;
+    }
+
     // for chained items, the ownership of the parent can change. We try to
     // evict what we think as parent and see if the eviction of parent
     // recycles the child we intend to.
@@ -1297,6 +1443,9 @@ CacheAllocator<CacheTrait>::findEviction(PoolId pid, ClassId cid) {
       } else {
         (*stats_.regularItemEvictions)[pid][cid].inc();
       }
+      if (keyPrefixStats_) {
+        keyPrefixStats_->recordEviction(candidate->getKey());
+      }
 
       if (auto eventTracker = getEventTracker()) {
         eventTracker->record(AllocatorApiEvent::DRAM_EVICT, candidate->getKey(),
@@ -1325,6 +1474,123 @@ CacheAllocator<CacheTrait>::findEviction(PoolId pid, ClassId cid) {
   return nullptr;
 }
 
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::copyItemForTierMove(Item& oldItem,
+                                                     Item& newItem) {
+  XDCHECK_EQ(oldItem.getSize(), newItem.getSize());
+  XDCHECK(!oldItem.hasChainedItem());
+
+  // take care of the flags before we expose the item to be accessed. this
+  // ensures that when another thread removes the item from RAM, we issue a
+  // delete to nvm accordingly.
+  if (oldItem.isNvmClean()) {
+    newItem.markNvmClean();
+  }
+
+  if (config_.moveCb) {
+    config_.moveCb(oldItem, newItem, nullptr);
+  } else {
+    std::memcpy(newItem.getMemory(), oldItem.getMemory(), oldItem.getSize());
+  }
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::tryDemoteRegularItem(TierId tid,
+                                                      MMContainer& mmContainer,
+                                                      EvictionIterator& itr) {
+  Item& oldItem = *itr;
+  XDCHECK(oldItem.isExclusive());
+  XDCHECK(!oldItem.isChainedItem());
+
+  // Allocating in the next tier may evict from it. The lock order is always
+  // from a higher tier to a lower one, so holding the iterator is safe.
+  const auto pid =
+      allocators_[tid]->getAllocInfo(static_cast<const void*>(&oldItem)).poolId;
+  auto newItemHdl =
+      allocateInternalTier(tid + 1, pid, oldItem.getKey(), oldItem.getSize(),
+                           oldItem.getCreationTime(), oldItem.getExpiryTime());
+  if (!newItemHdl) {
+    stats_.numTierDemotionFailures.inc();
+    return false;
+  }
+
+  copyItemForTierMove(oldItem, *newItemHdl);
+
+  // This checks under the access container's lock that no one holds a handle
+  // to the old item. If someone does, we leave the item in this tier and the
+  // new item is freed when its nascent handle goes away.
+  if (!accessContainer_->replaceIf(oldItem, *newItemHdl,
+                                   itemExclusivePredicate)) {
+    stats_.numTierDemotionFailures.inc();
+    return false;
+  }
+
+  mmContainer.remove(itr);
+  XDCHECK(!oldItem.isInMMContainer());
+  XDCHECK(!oldItem.isAccessible());
+
+  // we no longer need the lock on this tier's container.
+  itr.destroy();
+
+  insertInMMContainer(*newItemHdl);
+  newItemHdl.unmarkNascent();
+  stats_.numTierDemotions.inc();
+  return true;
+}
+
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::tryPromoteItem(WriteHandle handle) {
+  Item& oldItem = *handle;
+  const auto tid = getTierId(oldItem);
+  if (tid == 0 || oldItem.isChainedItem() || oldItem.hasChainedItem() ||
+      oldItem.isExpired()) {
+    return handle;
+  }
+
+  // prevent evictions, slab releases and other promotions of this item.
+  if (!oldItem.markExclusive()) {
+    return handle;
+  }
+
+  const auto pid =
+      allocators_[tid]->getAllocInfo(static_cast<const void*>(&oldItem)).poolId;
+  auto newItemHdl =
+      allocateInternalTier(tid - 1, pid, oldItem.getKey(), oldItem.getSize(),
+                           oldItem.getCreationTime(), oldItem.getExpiryTime());
+  if (!newItemHdl) {
+    oldItem.unmarkExclusive();
+    stats_.numTierPromotionFailures.inc();
+    return handle;
+  }
+
+  copyItemForTierMove(oldItem, *newItemHdl);
+
+  // we must be the only holder of the old item.
+  if (!accessContainer_->replaceIf(oldItem, *newItemHdl,
+                                   itemSingleHandlePredicate)) {
+    oldItem.unmarkExclusive();
+    stats_.numTierPromotionFailures.inc();
+    return handle;
+  }
+
+  removeFromMMContainer(oldItem);
+  insertInMMContainer(*newItemHdl);
+  newItemHdl.unmarkNascent();
+
+  // drop our reference. The item stays alive because it is exclusive, so
+  // we can give its memory back to its tier without invoking callbacks.
+  handle.reset();
+  const auto ref = oldItem.unmarkExclusive();
+  XDCHECK_EQ(ref, 0u);
+  if (ref == 0u) {
+    allocators_[tid]->free(&oldItem);
+  }
+
+  stats_.numTierPromotions.inc();
+  return newItemHdl;
+}
+
 template <typename CacheTrait>
 folly::Range<typename CacheAllocator<CacheTrait>::ChainedItemIter>
 CacheAllocator<CacheTrait>::viewAsChainedAllocsRange(const Item& parent) const {
@@ -1576,18 +1842,44 @@ void CacheAllocator<CacheTrait>::invalidateNvm(Item& item) {
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::MMContainer&
 CacheAllocator<CacheTrait>::getMMContainer(const Item& item) const noexcept {
+  const auto tid = getTierId(item);
   const auto allocInfo =
-      allocator_->getAllocInfo(static_cast<const void*>(&item));
-  return getMMContainer(allocInfo.poolId, allocInfo.classId);
+      allocators_[tid]->getAllocInfo(static_cast<const void*>(&item));
+  return getMMContainer(tid, allocInfo.poolId, allocInfo.classId);
 }
 
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::MMContainer&
 CacheAllocator<CacheTrait>::getMMContainer(PoolId pid,
                                            ClassId cid) const noexcept {
-  XDCHECK_LT(static_cast<size_t>(pid), mmContainers_.size());
-  XDCHECK_LT(static_cast<size_t>(cid), mmContainers_[pid].size());
-  return *mmContainers_[pid][cid];
+  return getMMContainer(0, pid, cid);
+}
+
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::MMContainer&
+CacheAllocator<CacheTrait>::getMMContainer(TierId tid,
+                                           PoolId pid,
+                                           ClassId cid) const noexcept {
+  XDCHECK_LT(static_cast<size_t>(tid), mmContainers_.size());
+  XDCHECK_LT(static_cast<size_t>(pid), mmContainers_[tid].size());
+  XDCHECK_LT(static_cast<size_t>(cid), mmContainers_[tid][pid].size());
+  return *mmContainers_[tid][pid][cid];
+}
+
+template <typename CacheTrait>
+TierId CacheAllocator<CacheTrait>::getTierId(
+    const void* memory) const noexcept {
+  if (LIKELY(allocators_.size() == 1)) {
+    return 0;
+  }
+
+  for (TierId tid = 0; static_cast<size_t>(tid) < allocators_.size(); tid++) {
+    if (allocators_[tid]->isMemoryInAllocator(memory)) {
+      return tid;
+    }
+  }
+  XDCHECK(false) << "memory does not belong to any tier: " << memory;
+  return 0;
 }
 
 template <typename CacheTrait>
@@ -1636,11 +1928,25 @@ CacheAllocator<CacheTrait>::findFastInternal(typename Item::Key key,
   auto handle = findInternal(key);
 
   stats_.numCacheGets.inc();
+  if (UNLIKELY(keyPrefixStats_ != nullptr)) {
+    keyPrefixStats_->recordGet(key, handle != nullptr);
+  }
   if (UNLIKELY(!handle)) {
     stats_.numCacheGetMiss.inc();
     return handle;
   }
 
+  if (UNLIKELY(missRatioCurves_ != nullptr)) {
+    const auto pid = allocators_[getTierId(*handle)]
+                         ->getAllocInfo(handle->getMemory())
+                         .poolId;
+    missRatioCurves_->recordAccess(pid, key, handle->getTotalSize());
+  }
+
+  if (UNLIKELY(config_.promoteOnHit && getTierId(*handle) != 0)) {
+    handle = tryPromoteItem(std::move(handle));
+  }
+
   markUseful(handle, mode);
   return handle;
 }
@@ -1691,42 +1997,55 @@ CacheAllocator<CacheTrait>::findImpl(typename Item::Key key, AccessMode mode) {
   auto handle = findFastInternal(key, mode);
 
   if (handle) {
-    if (UNLIKELY(handle->isExpired())) {
-      // update cache miss stats if the item has already been expired.
-      stats_.numCacheGetMiss.inc();
-      stats_.numCacheGetExpiries.inc();
-      auto eventTracker = getEventTracker();
-      if (UNLIKELY(eventTracker != nullptr)) {
-        eventTracker->record(AllocatorApiEvent::FIND, key,
-                             AllocatorApiResult::NOT_FOUND);
-      }
-      WriteHandle ret;
-      ret.markExpired();
-      return ret;
-    }
+    return onFindInRam(key, std::move(handle));
+  }
+
+  if (nvmCache_) {
+    handle = nvmCache_->find(HashedKey{key}, mode == AccessMode::kWrite);
+  }
+  recordFindMissInRam(key);
+  return handle;
+}
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::onFindInRam(typename Item::Key key,
+                                        WriteHandle handle) {
+  XDCHECK(handle);
+  if (UNLIKELY(handle->isExpired())) {
+    // update cache miss stats if the item has already been expired.
+    stats_.numCacheGetMiss.inc();
+    stats_.numCacheGetExpiries.inc();
+    if (UNLIKELY(keyPrefixStats_ != nullptr)) {
+      keyPrefixStats_->recordMiss(key);
+    }
     auto eventTracker = getEventTracker();
     if (UNLIKELY(eventTracker != nullptr)) {
       eventTracker->record(AllocatorApiEvent::FIND, key,
-                           AllocatorApiResult::FOUND, handle->getSize(),
-                           handle->getConfiguredTTL().count());
+                           AllocatorApiResult::NOT_FOUND);
     }
-    return handle;
+    WriteHandle ret;
+    ret.markExpired();
+    return ret;
   }
 
-  auto eventResult = AllocatorApiResult::NOT_FOUND;
-
-  if (nvmCache_) {
-    handle = nvmCache_->find(HashedKey{key});
-    eventResult = AllocatorApiResult::NOT_FOUND_IN_MEMORY;
+  auto eventTracker = getEventTracker();
+  if (UNLIKELY(eventTracker != nullptr)) {
+    eventTracker->record(AllocatorApiEvent::FIND, key,
+                         AllocatorApiResult::FOUND, handle->getSize(),
+                         handle->getConfiguredTTL().count());
   }
+  return handle;
+}
 
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::recordFindMissInRam(typename Item::Key key) {
   auto eventTracker = getEventTracker();
   if (UNLIKELY(eventTracker != nullptr)) {
-    eventTracker->record(AllocatorApiEvent::FIND, key, eventResult);
+    eventTracker->record(AllocatorApiEvent::FIND, key,
+                         nvmCache_ ? AllocatorApiResult::NOT_FOUND_IN_MEMORY
+                                   : AllocatorApiResult::NOT_FOUND);
   }
-
-  return handle;
 }
 
 template <typename CacheTrait>
@@ -1749,6 +2068,53 @@ CacheAllocator<CacheTrait>::find(typename Item::Key key) {
   return findImpl(key, AccessMode::kRead);
 }
 
+template <typename CacheTrait>
+folly::SemiFuture<typename CacheAllocator<CacheTrait>::ReadHandle>
+CacheAllocator<CacheTrait>::findAsync(typename Item::Key key) {
+  return find(key).toSemiFuture();
+}
+
+template <typename CacheTrait>
+std::vector<typename CacheAllocator<CacheTrait>::ReadHandle>
+CacheAllocator<CacheTrait>::findBatch(const std::vector<Key>& keys) {
+  std::vector<ReadHandle> handles;
+  handles.reserve(keys.size());
+  // indices of the keys that missed RAM and are looked up in nvm together
+  std::vector<size_t> nvmIndices;
+  std::vector<HashedKey> nvmKeys;
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto handle = findFastInternal(keys[i], AccessMode::kRead);
+    if (handle) {
+      handles.push_back(onFindInRam(keys[i], std::move(handle)));
+      continue;
+    }
+    recordFindMissInRam(keys[i]);
+    handles.push_back(ReadHandle{});
+    if (nvmCache_) {
+      nvmIndices.push_back(i);
+      nvmKeys.push_back(HashedKey{keys[i]});
+    }
+  }
+
+  if (!nvmKeys.empty()) {
+    auto nvmHandles = nvmCache_->findBatch(
+        folly::Range<const HashedKey*>(nvmKeys.data(), nvmKeys.size()));
+    XDCHECK_EQ(nvmHandles.size(), nvmIndices.size());
+    for (size_t i = 0; i < nvmIndices.size(); i++) {
+      handles[nvmIndices[i]] = std::move(nvmHandles[i]);
+    }
+  }
+  return handles;
+}
+
+#if FOLLY_HAS_COROUTINES
+template <typename CacheTrait>
+folly::coro::Task<typename CacheAllocator<CacheTrait>::ReadHandle>
+CacheAllocator<CacheTrait>::co_find(typename Item::Key key) {
+  co_return co_await find(key).toSemiFuture();
+}
+#endif
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::markUseful(const ReadHandle& handle,
                                             AccessMode mode) {
@@ -1773,8 +2139,9 @@ void CacheAllocator<CacheTrait>::markUseful(const ReadHandle& handle,
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::recordAccessInMMContainer(Item& item,
                                                            AccessMode mode) {
+  const auto tid = getTierId(item);
   const auto allocInfo =
-      allocator_->getAllocInfo(static_cast<const void*>(&item));
+      allocators_[tid]->getAllocInfo(static_cast<const void*>(&item));
   (*stats_.cacheHits)[allocInfo.poolId][allocInfo.classId].inc();
 
   // track recently accessed items if needed
@@ -1782,14 +2149,15 @@ bool CacheAllocator<CacheTrait>::recordAccessInMMContainer(Item& item,
     ring_->trackItem(reinterpret_cast<uintptr_t>(&item), item.getSize());
   }
 
-  auto& mmContainer = getMMContainer(allocInfo.poolId, allocInfo.classId);
+  auto& mmContainer =
+      getMMContainer(tid, allocInfo.poolId, allocInfo.classId);
   return mmContainer.recordAccess(item, mode);
 }
 
 template <typename CacheTrait>
 uint32_t CacheAllocator<CacheTrait>::getUsableSize(const Item& item) const {
   const auto allocSize =
-      allocator_->getAllocInfo(static_cast<const void*>(&item)).allocSize;
+      getAllocInfo(static_cast<const void*>(&item)).allocSize;
   return item.isChainedItem()
              ? allocSize - ChainedItem::getRequiredSize(0)
              : allocSize - Item::getRequiredSize(item.getKey(), 0);
@@ -1820,7 +2188,7 @@ CacheAllocator<CacheTrait>::getSampleItem() {
     return SampleItem{false /* fromNvm */};
   }
 
-  const auto allocInfo = allocator_->getAllocInfo(item->getMemory());
+  const auto allocInfo = getAllocInfo(item->getMemory());
 
   // Convert the Item to IOBuf to make SampleItem
   auto iobuf = folly::IOBuf{
@@ -1844,15 +2212,15 @@ std::vector<std::string> CacheAllocator<CacheTrait>::dumpEvictionIterator(
     return {};
   }
 
-  if (static_cast<size_t>(pid) >= mmContainers_.size() ||
-      static_cast<size_t>(cid) >= mmContainers_[pid].size()) {
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size() ||
+      static_cast<size_t>(cid) >= mmContainers_[0][pid].size()) {
     throw std::invalid_argument(
         folly::sformat("Invalid PoolId: {} and ClassId: {}.", pid, cid));
   }
 
   std::vector<std::string> content;
 
-  auto& mm = *mmContainers_[pid][cid];
+  auto& mm = getMMContainer(pid, cid);
   auto evictItr = mm.getEvictionIterator();
   size_t i = 0;
   while (evictItr && i < numItems) {
@@ -2037,6 +2405,18 @@ PoolId CacheAllocator<CacheTrait>::addPool(
     bool ensureProvisionable) {
   folly::SharedMutex::WriteHolder w(poolsResizeAndRebalanceLock_);
   auto pid = allocator_->addPool(name, size, allocSizes, ensureProvisionable);
+  // lower tiers get a pool of the same id, scaled by the tier size relative
+  // to the top tier. Their pools are not resized or rebalanced.
+  for (TierId tid = 1; static_cast<size_t>(tid) < getNumTiers(); tid++) {
+    const size_t tierPoolSize =
+        std::min(static_cast<size_t>(static_cast<double>(size) *
+                                     getTierSize(tid) / getTierSize(0)),
+                 allocators_[tid]->getUnreservedMemorySize());
+    const auto tierPid = allocators_[tid]->addPool(name, tierPoolSize,
+                                                   allocSizes,
+                                                   ensureProvisionable);
+    XDCHECK_EQ(pid, tierPid);
+  }
   createMMContainers(pid, std::move(config));
   setRebalanceStrategy(pid, std::move(rebalanceStrategy));
   setResizeStrategy(pid, std::move(resizeStrategy));
@@ -2046,9 +2426,10 @@ PoolId CacheAllocator<CacheTrait>::addPool(
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::overridePoolRebalanceStrategy(
     PoolId pid, std::shared_ptr<RebalanceStrategy> rebalanceStrategy) {
-  if (static_cast<size_t>(pid) >= mmContainers_.size()) {
-    throw std::invalid_argument(folly::sformat(
-        "Invalid PoolId: {}, size of pools: {}", pid, mmContainers_.size()));
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid PoolId: {}, size of pools: {}", pid,
+                       mmContainers_[0].size()));
   }
   setRebalanceStrategy(pid, std::move(rebalanceStrategy));
 }
@@ -2056,9 +2437,10 @@ void CacheAllocator<CacheTrait>::overridePoolRebalanceStrategy(
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::overridePoolResizeStrategy(
     PoolId pid, std::shared_ptr<RebalanceStrategy> resizeStrategy) {
-  if (static_cast<size_t>(pid) >= mmContainers_.size()) {
-    throw std::invalid_argument(folly::sformat(
-        "Invalid PoolId: {}, size of pools: {}", pid, mmContainers_.size()));
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid PoolId: {}, size of pools: {}", pid,
+                       mmContainers_[0].size()));
   }
   setResizeStrategy(pid, std::move(resizeStrategy));
 }
@@ -2072,11 +2454,11 @@ void CacheAllocator<CacheTrait>::overridePoolOptimizeStrategy(
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::overridePoolConfig(PoolId pid,
                                                     const MMConfig& config) {
-  if (static_cast<size_t>(pid) >= mmContainers_.size()) {
-    throw std::invalid_argument(folly::sformat(
-        "Invalid PoolId: {}, size of pools: {}", pid, mmContainers_.size()));
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid PoolId: {}, size of pools: {}", pid,
+                       mmContainers_[0].size()));
   }
-
   auto& pool = allocator_->getPool(pid);
   for (unsigned int cid = 0; cid < pool.getNumClassId(); ++cid) {
     MMConfig mmConfig = config;
@@ -2085,8 +2467,68 @@ void CacheAllocator<CacheTrait>::overridePoolConfig(PoolId pid,
             ? pool.getAllocationClass(static_cast<ClassId>(cid))
                   .getAllocsPerSlab()
             : 0);
-    DCHECK_NOTNULL(mmContainers_[pid][cid].get());
-    mmContainers_[pid][cid]->setConfig(mmConfig);
+    for (TierId tid = 0; static_cast<size_t>(tid) < getNumTiers(); tid++) {
+      getMMContainer(tid, pid, static_cast<ClassId>(cid)).setConfig(mmConfig);
+    }
+  }
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::reconfigurePoolAllocSizes(
+    PoolId pid, const std::set<uint32_t>& allocSizes) {
+  if (static_cast<size_t>(pid) >= mmContainers_[0].size()) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid PoolId: {}, size of pools: {}", pid,
+                       mmContainers_[0].size()));
+  }
+  if (allocSizes.empty()) {
+    throw std::invalid_argument("Empty allocation class sizes");
+  }
+  {
+    folly::SharedMutex::ReadHolder lock(compactCachePoolsLock_);
+    if (isCompactCachePool_[pid]) {
+      throw std::invalid_argument(folly::sformat(
+          "PoolId {} backs a compact cache and can not be reconfigured", pid));
+    }
+  }
+  // keeps the rebalancer and resizer away while the classes change
+  folly::SharedMutex::WriteHolder w(poolsResizeAndRebalanceLock_);
+  std::vector<ClassId> tierCids;
+  for (TierId tid = 0; static_cast<size_t>(tid) < getNumTiers(); tid++) {
+    auto& allocator = *allocators_[tid];
+    const auto& pool = allocator.getPool(pid);
+    const auto current = pool.getActiveAllocSizes();
+    if (*allocSizes.rbegin() < current.back()) {
+      throw std::invalid_argument(folly::sformat(
+          "Largest allocation size {} is smaller than the current one {}",
+          *allocSizes.rbegin(), current.back()));
+    }
+
+    std::vector<ClassId> cids;
+    for (const auto size : allocSizes) {
+      if (std::binary_search(current.begin(), current.end(), size)) {
+        cids.push_back(pool.getAllocationClassId(size));
+        continue;
+      }
+
+      const auto cid = allocator.addAllocationClass(pid, size);
+      // the new class starts with the config the pool's containers have
+      auto mmConfig = getMMContainer(tid, pid, 0).getConfig();
+      mmConfig.addExtraConfig(
+          config_.trackTailHits
+              ? pool.getAllocationClass(cid).getAllocsPerSlab()
+              : 0);
+      mmContainers_[tid][pid][cid].reset(
+          new MMContainer(mmConfig, compressor_));
+      cids.push_back(cid);
+    }
+    allocator.setActiveAllocationClasses(pid, cids);
+
+    // every tier adds the same classes in the same order
+    if (tid == 0) {
+      tierCids = cids;
+    }
+    XDCHECK(tierCids == cids);
   }
 }
 
@@ -2100,7 +2542,9 @@ void CacheAllocator<CacheTrait>::createMMContainers(const PoolId pid,
             ? pool.getAllocationClass(static_cast<ClassId>(cid))
                   .getAllocsPerSlab()
             : 0);
-    mmContainers_[pid][cid].reset(new MMContainer(config, compressor_));
+    for (auto& tierMMContainers : mmContainers_) {
+      tierMMContainers[pid][cid].reset(new MMContainer(config, compressor_));
+    }
   }
 }
 
@@ -2208,8 +2652,6 @@ PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
   if (!isCompactCache) {
     for (const ClassId cid : classIds) {
       uint64_t classHits = (*stats_.cacheHits)[poolId][cid].get();
-      XDCHECK(mmContainers_[poolId][cid],
-              folly::sformat("Pid {}, Cid {} not initialized.", poolId, cid));
       cacheStats.insert(
           {cid,
            {allocSizes[cid], (*stats_.allocAttempts)[poolId][cid].get(),
@@ -2218,7 +2660,7 @@ PoolStats CacheAllocator<CacheTrait>::getPoolStats(PoolId poolId) const {
             (*stats_.fragmentationSize)[poolId][cid].get(), classHits,
             (*stats_.chainedItemEvictions)[poolId][cid].get(),
             (*stats_.regularItemEvictions)[poolId][cid].get(),
-            mmContainers_[poolId][cid]->getStats()}
+            getMMContainer(poolId, cid).getStats()}
 
           });
       totalHits += classHits;
@@ -2542,8 +2984,9 @@ CacheAllocator<CacheTrait>::allocateNewItemForOldItem(const Item& oldItem) {
   }
 
   XDCHECK_EQ(newItemHdl->getSize(), oldItem.getSize());
-  XDCHECK_EQ(reinterpret_cast<uintptr_t>(&getMMContainer(oldItem)),
-             reinterpret_cast<uintptr_t>(&getMMContainer(*newItemHdl)));
+  // the class of the new item differs from the old one's if the old class
+  // was retired by reconfigurePoolAllocSizes()
+  XDCHECK_EQ(allocInfo.poolId, getAllocInfo(newItemHdl->getMemory()).poolId);
 
   return newItemHdl;
 }
@@ -2623,6 +3066,9 @@ void CacheAllocator<CacheTrait>::evictForSlabRelease(
         (*stats_.regularItemEvictions)[allocInfo.poolId][allocInfo.classId]
             .inc();
       }
+      if (keyPrefixStats_) {
+        keyPrefixStats_->recordEviction(owningHandle->getKey());
+      }
 
       stats_.numEvictionSuccesses.inc();
 
@@ -3130,7 +3576,7 @@ folly::IOBufQueue CacheAllocator<CacheTrait>::saveStateToIOBuf() {
     return state;
   };
   MMSerializationTypeContainer mmContainersState =
-      serializeMMContainers(mmContainers_);
+      serializeMMContainers(mmContainers_[0]);
 
   AccessSerializationType accessContainerState = accessContainer_->saveState();
   MemoryAllocator::SerializationType allocatorState = allocator_->saveState();
@@ -3158,6 +3604,7 @@ bool CacheAllocator<CacheTrait>::stopWorkers(std::chrono::seconds timeout) {
   success &= stopPoolResizer(timeout);
   success &= stopMemMonitor(timeout);
   success &= stopReaper(timeout);
+  success &= stopAllocClassTuner(timeout);
   return success;
 }
 
@@ -3336,6 +3783,16 @@ void CacheAllocator<CacheTrait>::adjustHandleCountForThread_private(
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::initStats() {
   stats_.init();
+  if (config_.keyPrefixStatsConfig.isEnabled()) {
+    keyPrefixStats_ =
+        std::make_unique<KeyPrefixStats>(config_.keyPrefixStatsConfig);
+  }
+  if (config_.missRatioCurveEnabled()) {
+    missRatioCurves_ =
+        std::make_unique<PoolMissRatioCurves>(*config_.missRatioCurveConfig);
+  }
+  stats_.setLatencyTracking(config_.latencyTrackingSampleRate,
+                            config_.latencyTrackingClock);
 
   // deserialize the fragmentation size of each thread.
   for (const auto& pid : *metadata_.fragmentationSize()) {
@@ -3413,6 +3870,7 @@ GlobalCacheStats CacheAllocator<CacheTrait>::getGlobalCacheStats() const {
   ret.nvmUpTime = currTime - nvmCacheState_.getCreationTime();
   ret.nvmCacheEnabled = nvmCache_ ? nvmCache_->isEnabled() : false;
   ret.reaperStats = getReaperStats();
+  ret.allocClassTunerStats = getAllocClassTunerStats();
   ret.numActiveHandles = getNumActiveHandles();
 
   ret.isNewRamCache = cacheCreationTime_ == cacheInstanceCreationTime_;
@@ -3596,6 +4054,19 @@ bool CacheAllocator<CacheTrait>::startNewReaper(
   return true;
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::startNewAllocClassTuner(
+    std::chrono::milliseconds interval, AllocClassTunerConfig config) {
+  allocSizeSampler_.setSampleRate(config.sampleRate);
+  if (!startNewWorker("AllocClassTuner", allocClassTuner_, interval, config)) {
+    return false;
+  }
+
+  config_.allocClassTunerInterval = interval;
+  config_.allocClassTunerConfig = config;
+  return true;
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::stopPoolRebalancer(
     std::chrono::seconds timeout) {
@@ -3623,6 +4094,14 @@ bool CacheAllocator<CacheTrait>::stopReaper(std::chrono::seconds timeout) {
   return stopWorker("Reaper", reaper_, timeout);
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::stopAllocClassTuner(
+    std::chrono::seconds timeout) {
+  const auto success = stopWorker("AllocClassTuner", allocClassTuner_, timeout);
+  allocSizeSampler_.setSampleRate(0);
+  return success;
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::cleanupStrayShmSegments(
     const std::string& cacheDir, bool posix) {
@@ -30,5 +30,8 @@ template class CacheAllocator<SieveCacheTrait>;
 // template class CacheAllocator<SieveBufferedCacheTrait>;
 template class CacheAllocator<S3FIFOCacheTrait>;
 
+template class CacheAllocator<ClockCompactCacheTrait>;
+template class CacheAllocator<SieveCompactCacheTrait>;
+
 } // namespace cachelib
 } // namespace facebook
@@ -18,12 +18,18 @@
 
 #include <folly/CPortability.h>
 #include <folly/Likely.h>
+#include <folly/Portability.h>
 #include <folly/Random.h>
 #include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/synchronization/SanitizeThread.h>
 #include <gtest/gtest.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
 
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <memory>
@@ -31,6 +37,7 @@
 #include <optional>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -38,6 +45,7 @@
 #include <folly/Range.h>
 #pragma GCC diagnostic pop
 
+#include "cachelib/allocator/AllocClassTuner.h"
 #include "cachelib/allocator/CCacheManager.h"
 #include "cachelib/allocator/Cache.h"
 #include "cachelib/allocator/CacheAllocatorConfig.h"
@@ -50,7 +58,9 @@
 #include "cachelib/allocator/ChainedAllocs.h"
 #include "cachelib/allocator/ICompactCache.h"
 #include "cachelib/allocator/KAllocation.h"
+#include "cachelib/allocator/KeyPrefixStats.h"
 #include "cachelib/allocator/MemoryMonitor.h"
+#include "cachelib/allocator/MissRatioCurveEstimator.h"
 #include "cachelib/allocator/NvmAdmissionPolicy.h"
 #include "cachelib/allocator/NvmCacheState.h"
 #include "cachelib/allocator/PoolOptimizeStrategy.h"
@@ -522,6 +532,43 @@ class CacheAllocator : public CacheBase {
   //                  key does not exist.
   ReadHandle find(Key key);
 
+  // look up an item by its key across the nvm cache as well if enabled,
+  // without blocking the caller on the nvm read. This is find() returning
+  // ReadHandle::toSemiFuture(): the I/O itself is not asynchronous, a navy
+  // reader thread still blocks on the device read, and the future is
+  // fulfilled by the nvm fill once the item is in RAM.
+  //
+  // @param key       the key for lookup
+  //
+  // @return          a SemiFuture of the read handle for the item or a handle
+  //                  to nullptr if the key does not exist. It is already
+  //                  fulfilled if the lookup did not need to go to flash.
+  folly::SemiFuture<ReadHandle> findAsync(Key key);
+
+  // look up a batch of items by their keys across the nvm cache as well if
+  // enabled. Keys that miss RAM are looked up in the nvm cache together, so
+  // that navy resolves them in one job and shares reads between items that
+  // are close to each other on the device.
+  //
+  // @param keys      the keys for lookup
+  //
+  // @return          a read handle for each key, in the same order. Handles
+  //                  of items being read from nvm are not ready yet; use
+  //                  wait() or toSemiFuture() on them as with find().
+  std::vector<ReadHandle> findBatch(const std::vector<Key>& keys);
+
+#if FOLLY_HAS_COROUTINES
+  // coroutine version of findAsync(). The lookup starts when the task is
+  // awaited, so the key must stay valid until then. Like findAsync(), only
+  // the awaiting coroutine is suspended; navy reader threads still block.
+  //
+  // @param key       the key for lookup
+  //
+  // @return          the read handle for the item or a handle to nullptr if the
+  //                  key does not exist.
+  folly::coro::Task<ReadHandle> co_find(Key key);
+#endif
+
   // Warning: this API is synchronous today with HybridCache. This means as
   //          opposed to find(), we will block on an item being read from
   //          flash until it is loaded into DRAM-cache. In find(), if an item
@@ -787,6 +834,21 @@ class CacheAllocator : public CacheBase {
                  std::shared_ptr<RebalanceStrategy> resizeStrategy = nullptr,
                  bool ensureProvisionable = false);
 
+  // switch an existing pool to a new set of allocation classes. New
+  // allocations go to the new classes right away. Classes that are not part
+  // of the new set keep their items until their slabs are released, which
+  // moves the items to the new classes or evicts them.
+  //
+  // @param pid         pool id for the pool to be updated
+  // @param allocSizes  the new allocation class sizes. The largest one can
+  //                    not be smaller than the largest current one.
+  //
+  // @throw std::invalid_argument if the poolId or the sizes are invalid, or
+  //        if the pool backs a compact cache.
+  //        std::logic_error if the pool ran out of allocation class ids.
+  void reconfigurePoolAllocSizes(PoolId pid,
+                                 const std::set<uint32_t>& allocSizes);
+
   // update an existing pool's config
   //
   // @param pid       pool id for the pool to be updated
@@ -872,10 +934,12 @@ class CacheAllocator : public CacheBase {
   //                              RemoveCb removeCb,
   //                              ReplaceCb replaceCb,
   //                              ValidCb validCb,
-  //                              bool allowPromotions = true);
+  //                              bool allowPromotions = true,
+  //                              bool optimisticReads = false);
   //              addCompactCache(folly::StringPiece name,
   //                              size_t size,
-  //                              bool allowPromotions = true);
+  //                              bool allowPromotions = true,
+  //                              bool optimisticReads = false);
   //
   // @return pointer to CompactCache instance of the template type
   //
@@ -897,9 +961,11 @@ class CacheAllocator : public CacheBase {
   //                                 RemoveCb removeCb,
   //                                 ReplaceCb replaceCb,
   //                                 ValidCb validCb,
-  //                                 bool allowPromotions = true);
+  //                                 bool allowPromotions = true,
+  //                                 bool optimisticReads = false);
   //              attachCompactCache(folly::StringPiece name,
-  //                                 bool allowPromotions = true);
+  //                                 bool allowPromotions = true,
+  //                                 bool optimisticReads = false);
   //
   // @return  pointer to CompactCache instance of the template type.
   //
@@ -1040,6 +1106,12 @@ class CacheAllocator : public CacheBase {
   bool startNewReaper(std::chrono::milliseconds interval,
                       util::Throttler::Config reaperThrottleConfig);
 
+  // start allocation class tuner
+  // @param interval  the period this worker fires
+  // @param config    tuning config
+  bool startNewAllocClassTuner(std::chrono::milliseconds interval,
+                               AllocClassTunerConfig config);
+
   // Stop existing workers with a timeout
   bool stopPoolRebalancer(std::chrono::seconds timeout = std::chrono::seconds{
                               0});
@@ -1048,6 +1120,8 @@ class CacheAllocator : public CacheBase {
                              0});
   bool stopMemMonitor(std::chrono::seconds timeout = std::chrono::seconds{0});
   bool stopReaper(std::chrono::seconds timeout = std::chrono::seconds{0});
+  bool stopAllocClassTuner(
+      std::chrono::seconds timeout = std::chrono::seconds{0});
 
   // Set pool optimization to either true or false
   //
@@ -1062,7 +1136,16 @@ class CacheAllocator : public CacheBase {
   // @throw std::invalid_argument if the memory does not belong to this
   //        cache allocator
   AllocInfo getAllocInfo(const void* memory) const {
-    return allocator_->getAllocInfo(memory);
+    return allocators_[getTierId(memory)]->getAllocInfo(memory);
+  }
+
+  // return the number of memory tiers of this cache.
+  size_t getNumTiers() const noexcept { return allocators_.size(); }
+
+  // return the memory tier which the memory belongs to.
+  TierId getTierId(const void* memory) const noexcept;
+  TierId getTierId(const Item& item) const noexcept {
+    return getTierId(static_cast<const void*>(&item));
   }
 
   // return the ids for the set of existing pools in this cache.
@@ -1132,6 +1215,13 @@ class CacheAllocator : public CacheBase {
     return stats;
   }
 
+  // returns the allocation class tuner stats
+  AllocClassTunerStats getAllocClassTunerStats() const {
+    std::lock_guard<std::mutex> l(workersMutex_);
+    return allocClassTuner_ ? allocClassTuner_->getStats()
+                            : AllocClassTunerStats{};
+  }
+
   // return the LruType of an item
   typename MMType::LruType getItemLruType(const Item& item) const;
 
@@ -1174,6 +1264,28 @@ class CacheAllocator : public CacheBase {
     return eventTrackerStats;
   }
 
+  // return the key prefix stats map
+  std::unordered_map<std::string, uint64_t> getKeyPrefixStatsMap()
+      const override final {
+    return keyPrefixStats_ ? keyPrefixStats_->getStatsMap()
+                           : std::unordered_map<std::string, uint64_t>{};
+  }
+
+  // return the miss ratio curve estimated for the pool
+  PoolMissRatioCurve getPoolMissRatioCurve(PoolId pid) const override final {
+    return missRatioCurves_ ? missRatioCurves_->getCurve(pid)
+                            : PoolMissRatioCurve{};
+  }
+
+  // @return the counters of the heaviest key prefixes. Empty if key prefix
+  //         stats are not enabled.
+  std::unordered_map<std::string, KeyPrefixCounters> getKeyPrefixStats()
+      const {
+    return keyPrefixStats_
+               ? keyPrefixStats_->getStats()
+               : std::unordered_map<std::string, KeyPrefixCounters>{};
+  }
+
   // Whether this cache allocator was created on shared memory.
   bool isOnShm() const noexcept { return isOnShm_; }
 
@@ -1269,7 +1381,10 @@ class CacheAllocator : public CacheBase {
                  sizeof(typename RefcountWithFlags::Value) + sizeof(uint32_t) +
                  sizeof(uint32_t) + sizeof(KAllocation)) == sizeof(Item),
                 "vtable overhead");
-  static_assert(32 == sizeof(Item), "item overhead is 32 bytes");
+  static_assert(sizeof(Item) <= 32, "item overhead is at most 32 bytes");
+  // the ref count following the MM hook relies on 4 byte alignment.
+  static_assert(sizeof(typename Item::MMHook) % sizeof(uint32_t) == 0,
+                "MM hook must be a multiple of 4 bytes");
 
   // make sure there is no overhead in ChainedItem on top of a regular Item
   static_assert(sizeof(Item) == sizeof(ChainedItem),
@@ -1376,6 +1491,10 @@ class CacheAllocator : public CacheBase {
 
   MMContainer& getMMContainer(PoolId pid, ClassId cid) const noexcept;
 
+  MMContainer& getMMContainer(TierId tid,
+                              PoolId pid,
+                              ClassId cid) const noexcept;
+
   // create a new cache allocation. The allocation can be initialized
   // appropriately and made accessible through insert or insertOrReplace.
   // If the handle returned from this api is not passed on to
@@ -1391,6 +1510,8 @@ class CacheAllocator : public CacheBase {
   // @param creationTime    Timestamp when this item was created
   // @param expiryTime      set an expiry timestamp for the item (0 means no
   //                        expiration time).
+  // @param evict           if false, fail rather than evict when there is no
+  //                        free memory.
   //
   // @return      the handle for the item or an invalid handle(nullptr) if the
   //              allocation failed. Allocation can fail if one such
@@ -1401,7 +1522,20 @@ class CacheAllocator : public CacheBase {
   //          requested is invalid or if the key is invalid(key.size() == 0 or
   //          key.size() > 255)
   WriteHandle allocateInternal(PoolId id, Key key, uint32_t size,
-                               uint32_t creationTime, uint32_t expiryTime);
+                               uint32_t creationTime, uint32_t expiryTime,
+                               bool evict = true);
+
+  // Same as allocateInternal, but allocates from the given memory tier and
+  // does not record an api event.
+  //
+  // @param tid   the memory tier to allocate from
+  WriteHandle allocateInternalTier(TierId tid,
+                                   PoolId id,
+                                   Key key,
+                                   uint32_t size,
+                                   uint32_t creationTime,
+                                   uint32_t expiryTime,
+                                   bool evict = true);
 
   // Allocate a chained item
   //
@@ -1477,6 +1611,18 @@ class CacheAllocator : public CacheBase {
   //              not exist.
   FOLLY_ALWAYS_INLINE WriteHandle findImpl(Key key, AccessMode mode);
 
+  // finish a lookup that found the item in RAM: an expired item is a miss.
+  // Records the find event.
+  //
+  // @param key         the key for lookup
+  // @param handle      the handle found in RAM
+  //
+  // @return      the handle to return for the lookup
+  WriteHandle onFindInRam(Key key, WriteHandle handle);
+
+  // record the find event of a lookup that missed RAM.
+  void recordFindMissInRam(Key key);
+
   // look up an item by its key. This ignores the nvm cache and only does RAM
   // lookup.
   //
@@ -1632,13 +1778,43 @@ class CacheAllocator : public CacheBase {
   // Implementation to find a suitable eviction from the container. The
   // two parameters together identify a single container.
   //
+  // If there is a lower memory tier, regular items are demoted to it instead
+  // of being evicted, and their memory is recycled.
+  //
+  // @param  tid  the memory tier to look for evictions inside
   // @param  pid  the id of the pool to look for evictions inside
   // @param  cid  the id of the class to look for evictions inside
   // @return An evicted item or nullptr  if there is no suitable candidate.
-  Item* findEviction(PoolId pid, ClassId cid);
+  Item* findEviction(TierId tid, PoolId pid, ClassId cid);
 
   using EvictionIterator = typename MMContainer::LockedIterator;
 
+  // Try to move the regular item under the iterator to the next memory tier.
+  // The item must be marked exclusive by the caller. On success, the item is
+  // unlinked from the access and mm containers of this tier, the iterator is
+  // destroyed and the caller owns the old item's memory.
+  //
+  // @param  tid          the tier the item currently lives in
+  // @param  mmContainer  the container holding the item
+  // @param  itr          iterator holding the item
+  //
+  // @return  true if the item was demoted, false otherwise. On failure, the
+  //          iterator is left pointing to the item.
+  bool tryDemoteRegularItem(TierId tid,
+                            MMContainer& mmContainer,
+                            EvictionIterator& itr);
+
+  // Try to move a regular item found in a lower memory tier up by one tier.
+  //
+  // @param  handle   the caller's handle to the item
+  // @return  handle to the promoted item on success, otherwise the passed in
+  //          handle
+  WriteHandle tryPromoteItem(WriteHandle handle);
+
+  // copy the contents of an item into a freshly allocated item in another
+  // memory tier, using the move callback if one is configured.
+  void copyItemForTierMove(Item& oldItem, Item& newItem);
+
   // Advance the current iterator and try to evict a regular item
   //
   // @param  mmContainer  the container to look for evictions.
@@ -1833,7 +2009,7 @@ class CacheAllocator : public CacheBase {
   bool stopWorker(folly::StringPiece name, std::unique_ptr<T>& worker,
                   std::chrono::seconds timeout = std::chrono::seconds{0});
 
-  ShmSegmentOpts createShmCacheOpts();
+  ShmSegmentOpts createShmCacheOpts(TierId tid);
   std::unique_ptr<MemoryAllocator> createNewMemoryAllocator();
   std::unique_ptr<MemoryAllocator> restoreMemoryAllocator();
   std::unique_ptr<CCacheManager> restoreCCacheManager();
@@ -1856,7 +2032,7 @@ class CacheAllocator : public CacheBase {
   }
 
   typename Item::PtrCompressor createPtrCompressor() const {
-    return allocator_->createPtrCompressor<Item>();
+    return typename Item::PtrCompressor(allocators_);
   }
 
   // helper utility to throttle and optionally log.
@@ -1882,6 +2058,28 @@ class CacheAllocator : public CacheBase {
   // @return pointer to memory allocator
   // @throw std::runtime_error if type is invalid
   std::unique_ptr<MemoryAllocator> initAllocator(InitMemType type);
+
+  // @param type        the type of initialization
+  // @return the memory allocators for all the memory tiers, top tier first.
+  std::vector<std::unique_ptr<MemoryAllocator>> initAllocators(
+      InitMemType type);
+
+  // @return the memory allocator for a lower memory tier. Lower tiers are
+  //         never persisted and are always backed by temporary mappings.
+  std::unique_ptr<MemoryAllocator> initLowerTierAllocator(TierId tid);
+
+  // create the temporary mapping that backs a memory tier if it needs one.
+  std::unique_ptr<TempShmMapping> createTempShmMapping(InitMemType type,
+                                                       TierId tid);
+  std::vector<std::unique_ptr<TempShmMapping>> createLowerTierTempShms(
+      InitMemType type);
+
+  // @return the size in bytes of the given memory tier.
+  size_t getTierSize(TierId tid) const;
+
+  // @return the mm containers for all tiers, restored for the top tier when
+  //         attaching to an existing cache.
+  std::vector<MMContainers> initMMContainers(InitMemType type);
   // @param type        the type of initialization
   // @return nullptr if the type is invalid
   // @return pointer to access container
@@ -1897,6 +2095,10 @@ class CacheAllocator : public CacheBase {
     return item.getRefCount() == 0;
   }
 
+  static bool itemSingleHandlePredicate(const Item& item) {
+    return item.getRefCount() == 1;
+  }
+
   static bool itemExpiryPredicate(const Item& item) {
     return item.getRefCount() == 1 && item.isExpired();
   }
@@ -1955,6 +2157,10 @@ class CacheAllocator : public CacheBase {
   // is not persisted when cache process exits.
   std::unique_ptr<TempShmMapping> tempShm_;
 
+  // temporary mappings backing the lower memory tiers, indexed by tier id.
+  // The entry for the top tier is always empty; see tempShm_.
+  std::vector<std::unique_ptr<TempShmMapping>> lowerTierShms_;
+
   std::unique_ptr<ShmManager> shmManager_;
 
   // Deserialize data to restore cache allocator. Used only while attaching to
@@ -1967,8 +2173,13 @@ class CacheAllocator : public CacheBase {
   // configs for the access container and the mm container.
   const MMConfig mmConfig_{};
 
-  // the memory allocator for allocating out of the available memory.
-  std::unique_ptr<MemoryAllocator> allocator_;
+  // the memory allocators for allocating out of the available memory, one
+  // per memory tier with the top tier first.
+  std::vector<std::unique_ptr<MemoryAllocator>> allocators_;
+
+  // the memory allocator of the top tier. Pools are sized, resized and
+  // rebalanced using this allocator; compact caches live only in this tier.
+  MemoryAllocator* const allocator_;
 
   // compact cache allocator manager
   std::unique_ptr<CCacheManager> compactCacheManager_;
@@ -1991,8 +2202,8 @@ class CacheAllocator : public CacheBase {
 
   // container for the allocations which are currently being memory managed by
   // the cache allocator.
-  // we need mmcontainer per allocator pool/allocation class.
-  MMContainers mmContainers_;
+  // we need mmcontainer per allocator pool/allocation class, per memory tier.
+  std::vector<MMContainers> mmContainers_;
 
   // container that is used for accessing the allocations by their key.
   std::unique_ptr<AccessContainer> accessContainer_;
@@ -2029,7 +2240,7 @@ class CacheAllocator : public CacheBase {
   folly::SharedMutex compactCachePoolsLock_;
 
   // mutex protecting the creation and destruction of workers poolRebalancer_,
-  // poolResizer_, poolOptimizer_, memMonitor_, reaper_
+  // poolResizer_, poolOptimizer_, memMonitor_, reaper_, allocClassTuner_
   mutable std::mutex workersMutex_;
 
   // time when the ram cache was first created
@@ -2048,6 +2259,18 @@ class CacheAllocator : public CacheBase {
   // allocator's items reaper to evict expired items in bg checking
   std::unique_ptr<Reaper<CacheT>> reaper_;
 
+  // sizes of the allocations requested from each pool, for the tuner
+  AllocSizeSampler allocSizeSampler_;
+
+  // stats by key prefix, if enabled
+  std::unique_ptr<KeyPrefixStats> keyPrefixStats_;
+
+  // miss ratio curves of the pools, if enabled
+  std::unique_ptr<PoolMissRatioCurves> missRatioCurves_;
+
+  // tunes the allocation classes of the pools in bg
+  std::unique_ptr<AllocClassTuner<CacheT>> allocClassTuner_;
+
   class DummyTlsActiveItemRingTag {};
   folly::ThreadLocal<TlsActiveItemRing, DummyTlsActiveItemRingTag> ring_;
 
@@ -2065,6 +2288,7 @@ class CacheAllocator : public CacheBase {
   // Make this friend to give access to acquire and release
   friend ReadHandle;
   friend ReaperAPIWrapper<CacheT>;
+  friend AllocClassTunerAPIWrapper<CacheT>;
   friend class CacheAPIWrapperForNvm<CacheT>;
   friend class FbInternalRuntimeUpdateWrapper<CacheT>;
   friend class objcache2::ObjectCache<CacheT>;
@@ -2124,6 +2348,9 @@ extern template class CacheAllocator<SieveCacheTrait>;
 // extern template class CacheAllocator<SieveBufferedCacheTrait>;
 extern template class CacheAllocator<S3FIFOCacheTrait>;
 
+extern template class CacheAllocator<ClockCompactCacheTrait>;
+extern template class CacheAllocator<SieveCompactCacheTrait>;
+
 // CacheAllocator with an LRU eviction policy
 // LRU policy can be configured to act as a segmented LRU as well
 using LruAllocator = CacheAllocator<LruCacheTrait>;
@@ -2151,5 +2378,10 @@ using SieveAllocator = CacheAllocator<SieveCacheTrait>;
 // using SieveBufferedAllocator = CacheAllocator<SieveBufferedCacheTrait>;
 
 using S3FIFOAllocator = CacheAllocator<S3FIFOCacheTrait>;
+
+// Same policies as ClockAllocator and SieveAllocator, with an item header of
+// 28 bytes instead of 32. Eviction age stats are not reported.
+using ClockCompactAllocator = CacheAllocator<ClockCompactCacheTrait>;
+using SieveCompactAllocator = CacheAllocator<SieveCompactCacheTrait>;
 }  // namespace cachelib
 }  // namespace facebook
@@ -25,15 +25,20 @@
 #include <stdexcept>
 #include <string>
 
+#include "cachelib/allocator/AllocClassTuner.h"
 #include "cachelib/allocator/Cache.h"
+#include "cachelib/allocator/KeyPrefixStats.h"
 #include "cachelib/allocator/MM2Q.h"
 #include "cachelib/allocator/MemoryMonitor.h"
 #include "cachelib/allocator/MemoryTierCacheConfig.h"
+#include "cachelib/allocator/MissRatioCurveEstimator.h"
 #include "cachelib/allocator/NvmAdmissionPolicy.h"
 #include "cachelib/allocator/PoolOptimizeStrategy.h"
 #include "cachelib/allocator/RebalanceStrategy.h"
 #include "cachelib/allocator/Util.h"
+#include "cachelib/allocator/memory/CompressedPtr.h"
 #include "cachelib/common/EventInterface.h"
+#include "cachelib/common/PercentileStats.h"
 #include "cachelib/common/Throttler.h"
 
 namespace facebook {
@@ -217,6 +222,45 @@ class CacheAllocatorConfig {
   CacheAllocatorConfig& enableItemReaperInBackground(
       std::chrono::milliseconds interval, util::Throttler::Config config = {});
 
+  // This turns on a background worker that samples the sizes allocated from
+  // each pool and, when a different set of allocation classes would waste
+  // less memory for them, switches the pool to it. The slabs of the classes
+  // no longer used are released gradually.
+  //
+  // @param interval  waits for an interval between each run
+  // @param config    tuning config
+  // @throw std::invalid_argument if the config is invalid
+  CacheAllocatorConfig& enableAllocClassTuning(
+      std::chrono::milliseconds interval, AllocClassTunerConfig config = {});
+
+  // Sets how the latencies of allocations, moves and nvm operations are
+  // tracked. Only one out of every _sampleRate_ operations is timed, and the
+  // TSC can stand in for steady_clock when reading the time is too costly.
+  //
+  // @param sampleRate  time one out of this many operations
+  // @param clock       clock used to time the operations
+  // @throw std::invalid_argument if the sample rate is 0
+  // Accounts lookups, allocations and evictions by the key prefix the
+  // extractor of the config returns, for the heaviest prefixes.
+  //
+  // @param config  key prefix stats config
+  // @throw std::invalid_argument if the config has no extractor or prefixes
+  CacheAllocatorConfig& enableKeyPrefixStats(KeyPrefixStatsConfig config);
+
+  // Estimates the miss ratio curve of each pool online from a sample of the
+  // keys looked up and allocated. The curves can be read through
+  // getPoolMissRatioCurve() and drive MissRatioCurveOptimizeStrategy.
+  //
+  // @param config  sampling config
+  // @throw std::invalid_argument if the config is invalid
+  CacheAllocatorConfig& enableMissRatioCurveEstimation(
+      MissRatioCurveConfig config = {});
+
+  CacheAllocatorConfig& setLatencyTracking(
+      uint32_t sampleRate,
+      util::LatencyHistogram::Clock clock =
+          util::LatencyHistogram::Clock::kSteady);
+
   // When using free memory monitoring mode, CacheAllocator shrinks the cache
   // size when the system is under memory pressure. Cache will grow back when
   // the memory pressure goes down.
@@ -311,6 +355,10 @@ class CacheAllocatorConfig {
   // CacheAllocator::startCacheWorkers()
   CacheAllocatorConfig& setDelayCacheWorkersStart();
 
+  // With multiple memory tiers, move an item found in a lower tier back to
+  // the top tier on a hit.
+  CacheAllocatorConfig& enablePromotionOnHit();
+
   // skip promote children items in chained when parent fail to promote
   bool isSkipPromoteChildrenWhenParentFailed() const noexcept {
     return skipPromoteChildrenWhenParentFailed;
@@ -348,6 +396,16 @@ class CacheAllocatorConfig {
     return reaperInterval.count() > 0;
   }
 
+  // @return whether the miss ratio curves of the pools are estimated
+  bool missRatioCurveEnabled() const noexcept {
+    return missRatioCurveConfig.has_value();
+  }
+
+  // @return whether allocation class tuning is enabled
+  bool allocClassTuningEnabled() const noexcept {
+    return allocClassTunerInterval.count() > 0;
+  }
+
   const std::string& getCacheDir() const noexcept { return cacheDir; }
 
   const std::string& getCacheName() const noexcept { return cacheName; }
@@ -373,9 +431,10 @@ class CacheAllocatorConfig {
   // @return a map representation of the configs
   std::map<std::string, std::string> serialize() const;
 
-  // The max number of memory cache tiers
-  // TODO: increase this number when multi-tier configs are enabled
-  inline static const size_t kMaxCacheMemoryTiers = 1;
+  // The max number of memory cache tiers. Bounded by the number of tier ids
+  // that fit in a CompressedPtr.
+  inline static const size_t kMaxCacheMemoryTiers =
+      CompressedPtr::getMaxTiers();
 
   // Cache name for users to indentify their own cache.
   std::string cacheName{""};
@@ -480,6 +539,27 @@ class CacheAllocatorConfig {
   // time to sleep between each reaping period.
   std::chrono::milliseconds reaperInterval{5000};
 
+  // time to sleep between each allocation class tuning period.
+  // Set to 0 to disable allocation class tuning
+  std::chrono::milliseconds allocClassTunerInterval{0};
+
+  // config of the allocation class tuner
+  AllocClassTunerConfig allocClassTunerConfig{};
+
+  // config of the stats by key prefix. Disabled without an extractor.
+  KeyPrefixStatsConfig keyPrefixStatsConfig{};
+
+  // config of the miss ratio curve estimation. Disabled if not set.
+  folly::Optional<MissRatioCurveConfig> missRatioCurveConfig{};
+
+  // one out of this many allocations, moves and nvm operations are timed
+  // for the latency stats.
+  uint32_t latencyTrackingSampleRate{1};
+
+  // clock used to time operations for the latency stats.
+  util::LatencyHistogram::Clock latencyTrackingClock{
+      util::LatencyHistogram::Clock::kSteady};
+
   // interval during which we adjust dynamically the refresh ratio.
   std::chrono::milliseconds mmReconfigureInterval{0};
 
@@ -588,6 +668,9 @@ class CacheAllocatorConfig {
   // CacheAllocator::startCacheWorkers()
   bool delayCacheWorkersStart{false};
 
+  // If true, an item found in a lower memory tier is moved to the top tier.
+  bool promoteOnHit{false};
+
   friend CacheT;
 
  private:
@@ -1010,6 +1093,67 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setDelayCacheWorkersStart() {
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enablePromotionOnHit() {
+  promoteOnHit = true;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableAllocClassTuning(
+    std::chrono::milliseconds interval, AllocClassTunerConfig config) {
+  if (config.sampleRate == 0 || config.minSamples == 0 ||
+      config.slabsPerIteration == 0) {
+    throw std::invalid_argument(
+        "Allocation class tuning requires a non-zero sample rate, number of "
+        "samples and slabs per iteration.");
+  }
+  if (config.numClasses > MemoryAllocator::kMaxClasses / 2) {
+    throw std::invalid_argument(folly::sformat(
+        "Allocation class tuning can use at most {} classes, asked for {}",
+        MemoryAllocator::kMaxClasses / 2, config.numClasses));
+  }
+  if (config.minImprovement < 0 || config.minImprovement >= 1) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid min improvement {} for allocation class tuning",
+        config.minImprovement));
+  }
+  allocClassTunerInterval = interval;
+  allocClassTunerConfig = config;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableKeyPrefixStats(
+    KeyPrefixStatsConfig config) {
+  if (!config.isEnabled() || config.maxPrefixes == 0) {
+    throw std::invalid_argument(
+        "Key prefix stats need a prefix extractor and at least one prefix");
+  }
+  keyPrefixStatsConfig = std::move(config);
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>&
+CacheAllocatorConfig<T>::enableMissRatioCurveEstimation(
+    MissRatioCurveConfig config) {
+  config.validate();
+  missRatioCurveConfig = config;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setLatencyTracking(
+    uint32_t sampleRate, util::LatencyHistogram::Clock clock) {
+  if (sampleRate == 0) {
+    throw std::invalid_argument("Latency tracking sample rate must be > 0");
+  }
+  latencyTrackingSampleRate = sampleRate;
+  latencyTrackingClock = clock;
+  return *this;
+}
+
 template <typename T>
 const CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::validate() const {
   // we can track tail hits only if MMType is MM2Q
@@ -1058,7 +1202,9 @@ bool CacheAllocatorConfig<T>::validateStrategy(
 
   auto type = strategy->getType();
   return type != PoolOptimizeStrategy::NumTypes &&
-         (type != PoolOptimizeStrategy::MarginalHits || trackTailHits);
+         (type != PoolOptimizeStrategy::MarginalHits || trackTailHits) &&
+         (type != PoolOptimizeStrategy::MissRatioCurve ||
+          missRatioCurveEnabled());
 }
 
 template <typename T>
@@ -1076,6 +1222,22 @@ const CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::validateMemoryTiers()
     throw std::invalid_argument(
         "Sum of tier ratios must be less than total cache size.");
   }
+
+  const bool multiTier = memoryTierConfigs.size() > 1;
+  for (const auto& tierConfig : memoryTierConfigs) {
+    if ((multiTier || tierConfig.isFileBacked()) && !cacheDir.empty()) {
+      throw std::invalid_argument(
+          "Persistence is not supported with file-backed or multiple memory "
+          "tiers.");
+    }
+    if (multiTier && tierConfig.calculateTierSize(size, parts) >
+                         CompressedPtr::getMaxAddressableSizeMultiTier()) {
+      throw std::invalid_argument(folly::sformat(
+          "Memory tier size exceeds the maximum of {} bytes addressable with "
+          "multiple tiers.",
+          CompressedPtr::getMaxAddressableSizeMultiTier()));
+    }
+  }
   return *this;
 }
 
@@ -1161,6 +1323,25 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
   configMap["nvmAdmissionMinTTL"] = std::to_string(nvmAdmissionMinTTL);
   configMap["delayCacheWorkersStart"] =
       delayCacheWorkersStart ? "true" : "false";
+  configMap["promoteOnHit"] = promoteOnHit ? "true" : "false";
+  configMap["allocClassTunerInterval"] =
+      util::toString(allocClassTunerInterval);
+  configMap["allocClassTunerSampleRate"] =
+      std::to_string(allocClassTunerConfig.sampleRate);
+  configMap["allocClassTunerNumClasses"] =
+      std::to_string(allocClassTunerConfig.numClasses);
+  configMap["keyPrefixStatsMaxPrefixes"] =
+      keyPrefixStatsConfig.isEnabled()
+          ? std::to_string(keyPrefixStatsConfig.maxPrefixes)
+          : "disabled";
+  configMap["missRatioCurveSampleRate"] =
+      missRatioCurveConfig ? std::to_string(missRatioCurveConfig->sampleRate)
+                           : "disabled";
+  configMap["latencyTrackingSampleRate"] =
+      std::to_string(latencyTrackingSampleRate);
+  configMap["latencyTrackingClock"] =
+      latencyTrackingClock == util::LatencyHistogram::Clock::kTsc ? "tsc"
+                                                                  : "steady";
   mergeWithPrefix(configMap, throttleConfig.serialize(), "throttleConfig");
   mergeWithPrefix(configMap,
                   chainedItemAccessConfig.serialize(),
@@ -16,6 +16,8 @@
 
 #include "cachelib/allocator/CacheStats.h"
 
+#include <iterator>
+
 #include "cachelib/allocator/CacheStatsInternal.h"
 
 namespace facebook {
@@ -46,12 +48,22 @@ void Stats::init() {
   initToZero(*regularItemEvictions);
 }
 
+void Stats::setLatencyTracking(uint32_t sampleRate,
+                               util::LatencyHistogram::Clock clock) {
+  for (auto* histogram : {&allocateLatency_, &moveRegularLatency_,
+                          &nvmLookupLatency_, &nvmInsertLatency_,
+                          &nvmRemoveLatency_}) {
+    histogram->setSampleRate(sampleRate);
+    histogram->setClock(clock);
+  }
+}
+
 template <int>
 struct SizeVerify {};
 
 void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
 #ifndef SKIP_SIZE_VERIFY
-  SizeVerify<sizeof(Stats)> a = SizeVerify<16176>{};
+  SizeVerify<sizeof(Stats)> a = SizeVerify<38088>{};
   std::ignore = a;
 #endif
   ret.numCacheGets = numCacheGets.get();
@@ -139,6 +151,11 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numEvictionFailureFromParentMoving = evictFailParentMove.get();
   ret.numAbortedSlabReleases = numAbortedSlabReleases.get();
   ret.numReaperSkippedSlabs = numReaperSkippedSlabs.get();
+
+  ret.numTierDemotions = numTierDemotions.get();
+  ret.numTierDemotionFailures = numTierDemotionFailures.get();
+  ret.numTierPromotions = numTierPromotions.get();
+  ret.numTierPromotionFailures = numTierPromotionFailures.get();
 }
 
 } // namespace detail
@@ -283,6 +300,31 @@ uint64_t PoolStats::numActiveAllocs() const noexcept {
   return n;
 }
 
+double PoolMissRatioCurve::getMissRatio(uint64_t cacheSize) const {
+  if (points.empty()) {
+    return 1.0;
+  }
+  auto it = std::lower_bound(
+      points.begin(), points.end(), cacheSize,
+      [](const auto& point, uint64_t size) { return point.first < size; });
+  if (it == points.end()) {
+    return points.back().second;
+  }
+  if (it == points.begin()) {
+    // no reuse is short enough for caches smaller than the first point
+    if (it->first == 0) {
+      return it->second;
+    }
+    const double frac =
+        static_cast<double>(cacheSize) / static_cast<double>(it->first);
+    return 1.0 - frac * (1.0 - it->second);
+  }
+  const auto prev = std::prev(it);
+  const double frac = static_cast<double>(cacheSize - prev->first) /
+                      static_cast<double>(it->first - prev->first);
+  return prev->second + frac * (it->second - prev->second);
+}
+
 uint64_t PoolStats::minEvictionAge() const {
   if (isCompactCache) {
     return 0;
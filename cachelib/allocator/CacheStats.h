@@ -18,6 +18,8 @@
 
 #include <algorithm>
 #include <numeric>
+#include <utility>
+#include <vector>
 
 #include "cachelib/allocator/Util.h"
 #include "cachelib/allocator/memory/MemoryAllocator.h"
@@ -289,6 +291,40 @@ struct ReaperStats {
   uint64_t avgTraversalTimeMs{0};
 };
 
+// Stats for the allocation class tuner
+struct AllocClassTunerStats {
+  // number of times a pool was switched to a new set of allocation classes
+  uint64_t numReconfigurations{0};
+
+  // number of slabs released from allocation classes no longer in use
+  uint64_t numSlabsReleased{0};
+
+  uint64_t numSlabReleaseErrors{0};
+
+  // expected bytes wasted per allocation before and after the last
+  // reconfiguration
+  uint64_t lastWastePerAllocBefore{0};
+  uint64_t lastWastePerAllocAfter{0};
+};
+
+// Miss ratio curve of a pool, estimated online from a sample of its keys.
+struct PoolMissRatioCurve {
+  // cache sizes in bytes, in increasing order, and the miss ratio the pool
+  // would have with that much memory.
+  std::vector<std::pair<uint64_t, double>> points;
+
+  // estimated number of accesses the curve is built from. Older accesses
+  // count less over time.
+  uint64_t numAccesses{0};
+
+  // fraction of the keys currently sampled
+  double sampleRate{0};
+
+  // @return the miss ratio for the cache size, interpolated between the
+  //         points. 1.0 if the curve is empty.
+  double getMissRatio(uint64_t cacheSize) const;
+};
+
 // CacheMetadata type to export
 struct CacheMetadata {
   // allocator_version
@@ -380,6 +416,16 @@ struct GlobalCacheStats {
   // number of evictions where items leave both RAM and NvmCache entirely
   uint64_t numCacheEvictions{0};
 
+  // number of items moved to a lower memory tier instead of being evicted,
+  // and number of failed attempts
+  uint64_t numTierDemotions{0};
+  uint64_t numTierDemotionFailures{0};
+
+  // number of items moved to a higher memory tier on a hit, and number of
+  // failed attempts
+  uint64_t numTierPromotions{0};
+  uint64_t numTierPromotionFailures{0};
+
   // number of evictions from nvm that found an inconsistent state in RAM
   uint64_t numNvmUncleanEvict{0};
 
@@ -494,6 +540,9 @@ struct GlobalCacheStats {
   // stats related to the reaper
   ReaperStats reaperStats;
 
+  // stats related to the allocation class tuner
+  AllocClassTunerStats allocClassTunerStats;
+
   uint64_t numNvmRejectsByExpiry{};
   uint64_t numNvmRejectsByClean{};
   uint64_t numNvmRejectsByAP{};
@@ -579,6 +628,11 @@ struct CCacheStats {
   uint64_t lockTimeout;
   uint64_t promoteTimeout;
 
+  // optimistic reads that saw a concurrent write and were retried
+  uint64_t optimisticReadRetries;
+  // optimistic reads that gave up retrying and took the bucket lock
+  uint64_t optimisticReadFallbacks;
+
   double hitRatio() const;
 
   CCacheStats& operator+=(const CCacheStats& other) {
@@ -604,6 +658,9 @@ struct CCacheStats {
     lockTimeout += other.lockTimeout;
     promoteTimeout += other.promoteTimeout;
 
+    optimisticReadRetries += other.optimisticReadRetries;
+    optimisticReadFallbacks += other.optimisticReadFallbacks;
+
     return *this;
   }
 };
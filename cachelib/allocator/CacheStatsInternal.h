@@ -186,13 +186,23 @@ struct Stats {
   // allocations with invalid parameters
   AtomicCounter invalidAllocs{0};
 
-  // latency stats of various cachelib operations
-  mutable util::PercentileStats allocateLatency_;
+  // items moved to a lower memory tier instead of being evicted, and
+  // attempts that failed to do so
+  AtomicCounter numTierDemotions{0};
+  AtomicCounter numTierDemotionFailures{0};
+
+  // items moved to a higher memory tier on a hit, and attempts that failed
+  AtomicCounter numTierPromotions{0};
+  AtomicCounter numTierPromotionFailures{0};
+
+  // latency stats of various cachelib operations. The ones on hot paths
+  // are histograms that can be sampled.
+  mutable util::LatencyHistogram allocateLatency_;
   mutable util::PercentileStats moveChainedLatency_;
-  mutable util::PercentileStats moveRegularLatency_;
-  mutable util::PercentileStats nvmLookupLatency_;
-  mutable util::PercentileStats nvmInsertLatency_;
-  mutable util::PercentileStats nvmRemoveLatency_;
+  mutable util::LatencyHistogram moveRegularLatency_;
+  mutable util::LatencyHistogram nvmLookupLatency_;
+  mutable util::LatencyHistogram nvmInsertLatency_;
+  mutable util::LatencyHistogram nvmRemoveLatency_;
 
   // percentile stats for various cache statistics
   mutable util::PercentileStats ramEvictionAgeSecs_;
@@ -250,6 +260,10 @@ struct Stats {
 
   void init();
 
+  // set up how the latency histograms time operations.
+  void setLatencyTracking(uint32_t sampleRate,
+                          util::LatencyHistogram::Clock clock);
+
   void populateGlobalCacheStats(GlobalCacheStats& ret) const;
 };
 
@@ -70,6 +70,19 @@ struct SieveCacheTrait {
   using AccessTypeLocks = SharedMutexBuckets;
 };
 
+// Traits with a smaller MM hook, giving a 28 byte item header instead of 32.
+struct ClockCompactCacheTrait {
+  using MMType = MMClockCompact;
+  using AccessType = ChainedHashTable;
+  using AccessTypeLocks = SharedMutexBuckets;
+};
+
+struct SieveCompactCacheTrait {
+  using MMType = MMSieveCompact;
+  using AccessType = ChainedHashTable;
+  using AccessTypeLocks = SharedMutexBuckets;
+};
+
 // struct Sieve2CacheTrait {
 //   using MMType = MMSieve2;
 //   using AccessType = ChainedHashTable;
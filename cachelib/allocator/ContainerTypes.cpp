@@ -34,6 +34,8 @@ const int MMClock::kId = 4;
 const int MMSieve::kId = 6;
 // const int MMSieveBuffered::kId = 7;
 const int MMS3FIFO::kId = 5;
+const int MMClockCompact::kId = 8;
+const int MMSieveCompact::kId = 9;
 
 // AccessType
 const int ChainedHashTable::kId = 1;
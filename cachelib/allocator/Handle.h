@@ -395,7 +395,11 @@ struct ReadHandleImpl {
       // refcount so that alloc_.release does not decrement it to negative.
       alloc_.adjustHandleCountForThread_private(1);
       try {
-        alloc_.release(it, /* isNascent */ false);
+        // an item served by nvmcache without inserting it into the cache is
+        // still nascent and goes back to the allocator without callbacks.
+        const bool isNascent =
+            flags_ & static_cast<uint8_t>(HandleFlags::kNascent);
+        alloc_.release(it, isNascent);
       } catch (const std::exception& e) {
         XLOGF(CRITICAL, "Failed to release {:#10x} : {}",
               static_cast<void*>(it), e.what());
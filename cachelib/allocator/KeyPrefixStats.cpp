@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/KeyPrefixStats.h"
+
+#include <folly/Format.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+constexpr size_t KeyPrefixStats::kMaxPrefixLen;
+constexpr folly::StringPiece KeyPrefixStats::kOtherPrefix;
+
+KeyPrefixStats::KeyPrefixStats(KeyPrefixStatsConfig config)
+    : config_(std::move(config)),
+      tables_([this]() { return new Table(*this, config_.maxPrefixes); }) {
+  if (!config_.isEnabled()) {
+    throw std::invalid_argument("Key prefix stats need a prefix extractor");
+  }
+  if (config_.maxPrefixes == 0) {
+    throw std::invalid_argument("Key prefix stats need to track a prefix");
+  }
+}
+
+KeyPrefixStats::Table::~Table() { parent_.accumulateOnDestroy(*this); }
+
+KeyPrefixStats::Table::Entry& KeyPrefixStats::Table::findOrInsert(
+    folly::StringPiece prefix, uint64_t hash) {
+  for (size_t i = 0; i < size_; i++) {
+    auto& entry = entries_[i];
+    if (entry.hash == hash && entry.len == prefix.size() &&
+        std::memcmp(entry.prefix, prefix.data(), prefix.size()) == 0) {
+      return entry;
+    }
+  }
+
+  Entry* entry = nullptr;
+  if (size_ < entries_.size()) {
+    entry = &entries_[size_++];
+  } else {
+    // take the entry of the lightest prefix. Its weight carries over so
+    // that the new prefix is not the next one to go.
+    entry = &*std::min_element(
+        entries_.begin(), entries_.end(),
+        [](const Entry& a, const Entry& b) { return a.weight < b.weight; });
+    other_ += entry->counters;
+    entry->counters = KeyPrefixCounters{};
+  }
+  entry->hash = hash;
+  entry->len = static_cast<uint8_t>(prefix.size());
+  std::memcpy(entry->prefix, prefix.data(), prefix.size());
+  return *entry;
+}
+
+void KeyPrefixStats::Table::mergeInto(StatsMap& stats) const {
+  std::lock_guard<folly::SpinLock> l(lock_);
+  for (size_t i = 0; i < size_; i++) {
+    const auto& entry = entries_[i];
+    stats[std::string(entry.prefix, entry.len)] += entry.counters;
+  }
+  if (other_.weight() > 0) {
+    stats[kOtherPrefix.str()] += other_;
+  }
+}
+
+void KeyPrefixStats::accumulateOnDestroy(const Table& table) {
+  std::lock_guard<std::mutex> l(retiredMutex_);
+  table.mergeInto(retired_);
+  trim(retired_);
+}
+
+void KeyPrefixStats::trim(StatsMap& stats) const {
+  const auto otherKey = kOtherPrefix.str();
+  const size_t numPrefixes = stats.size() - stats.count(otherKey);
+  if (numPrefixes <= config_.maxPrefixes) {
+    return;
+  }
+
+  std::vector<std::pair<uint64_t, std::string>> weights;
+  for (const auto& [prefix, counters] : stats) {
+    if (prefix != otherKey) {
+      weights.emplace_back(counters.weight(), prefix);
+    }
+  }
+  std::nth_element(weights.begin(), weights.begin() + config_.maxPrefixes,
+                   weights.end(), std::greater<>());
+
+  KeyPrefixCounters other;
+  for (size_t i = config_.maxPrefixes; i < weights.size(); i++) {
+    auto it = stats.find(weights[i].second);
+    other += it->second;
+    stats.erase(it);
+  }
+  stats[otherKey] += other;
+}
+
+std::unordered_map<std::string, KeyPrefixCounters> KeyPrefixStats::getStats()
+    const {
+  StatsMap stats;
+  {
+    std::lock_guard<std::mutex> l(retiredMutex_);
+    stats = retired_;
+  }
+  for (const auto& table : tables_.accessAllThreads()) {
+    table.mergeInto(stats);
+  }
+  trim(stats);
+  return stats;
+}
+
+std::unordered_map<std::string, uint64_t> KeyPrefixStats::getStatsMap()
+    const {
+  std::unordered_map<std::string, uint64_t> statsMap;
+  for (const auto& [prefix, counters] : getStats()) {
+    statsMap[folly::sformat("{}.gets", prefix)] = counters.gets;
+    statsMap[folly::sformat("{}.misses", prefix)] = counters.misses;
+    statsMap[folly::sformat("{}.allocs", prefix)] = counters.allocs;
+    statsMap[folly::sformat("{}.alloc_bytes", prefix)] = counters.allocBytes;
+    statsMap[folly::sformat("{}.evictions", prefix)] = counters.evictions;
+  }
+  return statsMap;
+}
+
+} // namespace cachelib
+} // namespace facebook
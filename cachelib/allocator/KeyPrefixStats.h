@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/SpinLock.h>
+#include <folly/ThreadLocal.h>
+#include <folly/hash/Hash.h>
+
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace facebook {
+namespace cachelib {
+
+struct KeyPrefixStatsConfig {
+  // returns the prefix a key is accounted under. Keys with an empty prefix
+  // are not accounted. Called on every lookup, allocation and eviction, so
+  // it must be cheap and must not allocate.
+  std::function<folly::StringPiece(folly::StringPiece)> prefixExtractor;
+
+  // max number of prefixes tracked by each thread and reported.
+  size_t maxPrefixes{32};
+
+  // @return an extractor that takes the key up to the first occurrence of
+  //         the delimiter. Keys without the delimiter have no prefix.
+  static std::function<folly::StringPiece(folly::StringPiece)>
+  delimiterExtractor(char delimiter) {
+    return [delimiter](folly::StringPiece key) {
+      const auto pos = key.find(delimiter);
+      return pos == folly::StringPiece::npos ? folly::StringPiece{}
+                                             : key.subpiece(0, pos);
+    };
+  }
+
+  bool isEnabled() const noexcept { return static_cast<bool>(prefixExtractor); }
+};
+
+// Counters of the keys that share a prefix.
+struct KeyPrefixCounters {
+  // lookups, and the ones that did not find the key
+  uint64_t gets{0};
+  uint64_t misses{0};
+
+  // allocations and the bytes they asked for
+  uint64_t allocs{0};
+  uint64_t allocBytes{0};
+
+  // items evicted from ram
+  uint64_t evictions{0};
+
+  // number of events, used to rank the prefixes
+  uint64_t weight() const noexcept { return gets + allocs + evictions; }
+
+  KeyPrefixCounters& operator+=(const KeyPrefixCounters& other) noexcept {
+    gets += other.gets;
+    misses += other.misses;
+    allocs += other.allocs;
+    allocBytes += other.allocBytes;
+    evictions += other.evictions;
+    return *this;
+  }
+};
+
+// Accounts cache operations by key prefix, e.g. by the tenant that owns the
+// keyspace. Each thread keeps the heaviest prefixes it sees in a fixed-size
+// space-saving table: a prefix that is not tracked takes the entry of the
+// lightest one, whose counters are folded into kOtherPrefix. Recording takes
+// only the lock of the thread's own table, which readers hold briefly while
+// they merge the tables, and never allocates.
+class KeyPrefixStats {
+ public:
+  // prefixes longer than this are truncated
+  static constexpr size_t kMaxPrefixLen = 32;
+
+  // prefix that the events of prefixes dropped from the tables are reported
+  // under
+  static constexpr folly::StringPiece kOtherPrefix{"__other__"};
+
+  // @throw std::invalid_argument if the config has no prefix extractor or
+  //        no room for prefixes
+  explicit KeyPrefixStats(KeyPrefixStatsConfig config);
+
+  void recordGet(folly::StringPiece key, bool hit) {
+    record(key, [hit](KeyPrefixCounters& c) {
+      ++c.gets;
+      if (!hit) {
+        ++c.misses;
+      }
+    });
+  }
+
+  // a lookup that was already recorded turned out to be a miss
+  void recordMiss(folly::StringPiece key) {
+    record(key, [](KeyPrefixCounters& c) { ++c.misses; });
+  }
+
+  void recordAllocation(folly::StringPiece key, uint32_t size) {
+    record(key, [size](KeyPrefixCounters& c) {
+      ++c.allocs;
+      c.allocBytes += size;
+    });
+  }
+
+  void recordEviction(folly::StringPiece key) {
+    record(key, [](KeyPrefixCounters& c) { ++c.evictions; });
+  }
+
+  // @return the counters of the heaviest prefixes across all threads,
+  //         including the ones that exited. At most maxPrefixes prefixes
+  //         are returned besides kOtherPrefix.
+  std::unordered_map<std::string, KeyPrefixCounters> getStats() const;
+
+  // @return the counters as <prefix>.<counter name> -> value
+  std::unordered_map<std::string, uint64_t> getStatsMap() const;
+
+ private:
+  using StatsMap = std::unordered_map<std::string, KeyPrefixCounters>;
+
+  // space-saving table of the prefixes seen by a thread.
+  class Table {
+   public:
+    Table(KeyPrefixStats& parent, size_t capacity)
+        : parent_(parent), entries_(capacity) {}
+
+    // fold the counters into the parent when the thread exits
+    ~Table();
+
+    template <typename F>
+    void update(folly::StringPiece prefix, F&& fn) {
+      const auto hash = folly::hash::fnv64_buf(prefix.data(), prefix.size());
+      std::lock_guard<folly::SpinLock> l(lock_);
+      auto& entry = findOrInsert(prefix, hash);
+      ++entry.weight;
+      fn(entry.counters);
+    }
+
+    // add the counters of the table to the map
+    void mergeInto(StatsMap& stats) const;
+
+   private:
+    struct Entry {
+      uint64_t hash{0};
+      // estimated number of events of the prefix, which includes the ones
+      // of the prefix it took the entry from.
+      uint64_t weight{0};
+      KeyPrefixCounters counters;
+      uint8_t len{0};
+      char prefix[kMaxPrefixLen];
+    };
+
+    Entry& findOrInsert(folly::StringPiece prefix, uint64_t hash);
+
+    KeyPrefixStats& parent_;
+
+    mutable folly::SpinLock lock_;
+    std::vector<Entry> entries_;
+    size_t size_{0};
+
+    // counters of the prefixes whose entries were taken
+    KeyPrefixCounters other_;
+  };
+
+  template <typename F>
+  void record(folly::StringPiece key, F&& fn) {
+    auto prefix = config_.prefixExtractor(key);
+    if (prefix.empty()) {
+      return;
+    }
+    if (prefix.size() > kMaxPrefixLen) {
+      prefix = prefix.subpiece(0, kMaxPrefixLen);
+    }
+    tables_->update(prefix, std::forward<F>(fn));
+  }
+
+  // keep the heaviest maxPrefixes prefixes and fold the rest into
+  // kOtherPrefix
+  void trim(StatsMap& stats) const;
+
+  // called by a table of an exiting thread
+  void accumulateOnDestroy(const Table& table);
+
+  const KeyPrefixStatsConfig config_;
+
+  // counters of the threads that exited
+  mutable std::mutex retiredMutex_;
+  StatsMap retired_;
+
+  folly::ThreadLocal<Table, KeyPrefixStats> tables_;
+};
+
+} // namespace cachelib
+} // namespace facebook
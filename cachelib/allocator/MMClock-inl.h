@@ -18,7 +18,7 @@ namespace facebook {
 namespace cachelib {
 
 /* Container Interface Implementation */
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 MMClock::Container<T, HookPtr>::Container(serialization::MMClockObject object,
                                         PtrCompressor compressor)
     : compressor_(std::move(compressor)),
@@ -33,7 +33,7 @@ MMClock::Container<T, HookPtr>::Container(serialization::MMClockObject object,
                                    config_.mmReconfigureIntervalSecs.count();
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMClock::Container<T, HookPtr>::recordAccess(T& node,
                                                 AccessMode mode) noexcept {
   if ((mode == AccessMode::kWrite && !config_.updateOnWrite) ||
@@ -87,7 +87,7 @@ bool MMClock::Container<T, HookPtr>::recordAccess(T& node,
   return false;
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 cachelib::EvictionAgeStat MMClock::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLength) const noexcept {
   return lruMutex_->lock_combine([this, projectedLength]() {
@@ -95,11 +95,14 @@ cachelib::EvictionAgeStat MMClock::Container<T, HookPtr>::getEvictionAgeStat(
   });
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 cachelib::EvictionAgeStat
 MMClock::Container<T, HookPtr>::getEvictionAgeStatLocked(
     uint64_t projectedLength) const noexcept {
   EvictionAgeStat stat{};
+  if (!kTracksUpdateTime) {
+    return stat;
+  }
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
 
   const T* node = fifo_.getTail();
@@ -113,7 +116,7 @@ MMClock::Container<T, HookPtr>::getEvictionAgeStatLocked(
   return stat;
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMClock::Container<T, HookPtr>::setConfig(const Config& newConfig) {
   lruMutex_->lock_combine([this, newConfig]() {
     config_ = newConfig;
@@ -134,12 +137,12 @@ void MMClock::Container<T, HookPtr>::setConfig(const Config& newConfig) {
   });
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename MMClock::Config MMClock::Container<T, HookPtr>::getConfig() const {
   return lruMutex_->lock_combine([this]() { return config_; });
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMClock::Container<T, HookPtr>::updateLruInsertionPoint() noexcept {
   if (config_.lruInsertionPointSpec == 0) {
     return;
@@ -181,7 +184,7 @@ void MMClock::Container<T, HookPtr>::updateLruInsertionPoint() noexcept {
   insertionPoint_ = curr;
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMClock::Container<T, HookPtr>::add(T& node) noexcept {
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
 
@@ -202,7 +205,7 @@ bool MMClock::Container<T, HookPtr>::add(T& node) noexcept {
   });
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename MMClock::Container<T, HookPtr>::LockedIterator
 MMClock::Container<T, HookPtr>::getEvictionIterator() noexcept {
   LockHolder l(*lruMutex_);
@@ -210,7 +213,7 @@ MMClock::Container<T, HookPtr>::getEvictionIterator() noexcept {
   return liter;
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 template <typename F>
 void MMClock::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   if (config_.useCombinedLockForIterators) {
@@ -221,7 +224,7 @@ void MMClock::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   }
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMClock::Container<T, HookPtr>::ensureNotInsertionPoint(T& node) noexcept {
   // If we are removing the insertion point node, grow tail before we remove
   // so that insertionPoint_ is valid (or nullptr) after removal
@@ -236,7 +239,7 @@ void MMClock::Container<T, HookPtr>::ensureNotInsertionPoint(T& node) noexcept {
   }
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMClock::Container<T, HookPtr>::removeLocked(T& node) {
   ensureNotInsertionPoint(node);
   fifo_.remove(node);
@@ -250,7 +253,7 @@ void MMClock::Container<T, HookPtr>::removeLocked(T& node) {
   return;
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMClock::Container<T, HookPtr>::remove(T& node) noexcept {
   return lruMutex_->lock_combine([this, &node]() {
     if (!node.isInMMContainer()) {
@@ -269,7 +272,7 @@ bool MMClock::Container<T, HookPtr>::remove(T& node) noexcept {
 //   removeLocked(node);
 // }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMClock::Container<T, HookPtr>::remove(LockedIterator& it) noexcept {
   T& node = *it;
   XDCHECK(node.isInMMContainer());
@@ -277,7 +280,7 @@ void MMClock::Container<T, HookPtr>::remove(LockedIterator& it) noexcept {
   removeLocked(node);
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMClock::Container<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
   return lruMutex_->lock_combine([this, &oldNode, &newNode]() {
     if (!oldNode.isInMMContainer() || newNode.isInMMContainer()) {
@@ -307,7 +310,7 @@ bool MMClock::Container<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
   });
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 serialization::MMClockObject MMClock::Container<T, HookPtr>::saveState()
     const noexcept {
   serialization::MMClockConfig configObject;
@@ -325,7 +328,7 @@ serialization::MMClockObject MMClock::Container<T, HookPtr>::saveState()
   return object;
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 MMContainerStat MMClock::Container<T, HookPtr>::getStats() const noexcept {
   auto stat = lruMutex_->lock_combine([this]() {
     auto* tail = fifo_.getTail();
@@ -335,10 +338,11 @@ MMContainerStat MMClock::Container<T, HookPtr>::getStats() const noexcept {
     // it can get optimized by the implementation.
     //
     // the rest of the parameters are 0, so we don't need the critical section
-    // to return them
-    return folly::make_array(fifo_.size(),
-                             tail == nullptr ? 0 : getUpdateTime(*tail)
-                             );
+    // to return them. Without update times in the hooks, there is no tail
+    // time either.
+    return folly::make_array(
+        fifo_.size(),
+        !kTracksUpdateTime || tail == nullptr ? 0 : getUpdateTime(*tail));
   });
   return {stat[0] /* lru size */,
           stat[1] /* tail time */,
@@ -350,7 +354,7 @@ MMContainerStat MMClock::Container<T, HookPtr>::getStats() const noexcept {
           0};
 }
 
-template <typename T, MMClock::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMClock::Container<T, HookPtr>::reconfigureLocked(const Time& currTime) {
   if (currTime < nextReconfigureTime_) {
     return;
@@ -21,7 +21,7 @@ namespace facebook {
 namespace cachelib {
 
 /* Container Interface Implementation */
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 MMSieve::Container<T, HookPtr>::Container(
     serialization::MMSieveObject object, PtrCompressor compressor)
     : compressor_(std::move(compressor)),
@@ -36,7 +36,7 @@ MMSieve::Container<T, HookPtr>::Container(
                                    config_.mmReconfigureIntervalSecs.count();
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMSieve::Container<T, HookPtr>::recordAccess(
     T& node, AccessMode mode) noexcept {
   if ((mode == AccessMode::kWrite && !config_.updateOnWrite) ||
@@ -88,7 +88,7 @@ bool MMSieve::Container<T, HookPtr>::recordAccess(
   return false;
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 cachelib::EvictionAgeStat
 MMSieve::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLength) const noexcept {
@@ -97,11 +97,14 @@ MMSieve::Container<T, HookPtr>::getEvictionAgeStat(
   });
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 cachelib::EvictionAgeStat
 MMSieve::Container<T, HookPtr>::getEvictionAgeStatLocked(
     uint64_t projectedLength) const noexcept {
   EvictionAgeStat stat{};
+  if (!kTracksUpdateTime) {
+    return stat;
+  }
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
 
   const T* node = fifo_.getTail();
@@ -115,7 +118,7 @@ MMSieve::Container<T, HookPtr>::getEvictionAgeStatLocked(
   return stat;
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMSieve::Container<T, HookPtr>::setConfig(const Config& newConfig) {
   // lruMutex_->lock_combine([this, newConfig]() {
   //   config_ = newConfig;
@@ -137,7 +140,7 @@ void MMSieve::Container<T, HookPtr>::setConfig(const Config& newConfig) {
   // });
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename MMSieve::Config MMSieve::Container<T, HookPtr>::getConfig()
     const {
   return lruMutex_->lock_combine([this]() { return config_; });
@@ -186,7 +189,7 @@ typename MMSieve::Config MMSieve::Container<T, HookPtr>::getConfig()
 //   insertionPoint_ = curr;
 // }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMSieve::Container<T, HookPtr>::add(T& node) noexcept {
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
 
@@ -216,7 +219,7 @@ bool MMSieve::Container<T, HookPtr>::add(T& node) noexcept {
   // });
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename MMSieve::Container<T, HookPtr>::LockedIterator
 MMSieve::Container<T, HookPtr>::getEvictionIterator() noexcept {
   // LockHolder l(*lruMutex_);
@@ -225,7 +228,7 @@ MMSieve::Container<T, HookPtr>::getEvictionIterator() noexcept {
   return liter;
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 template <typename F>
 void MMSieve::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   if (config_.useCombinedLockForIterators) {
@@ -236,7 +239,7 @@ void MMSieve::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   }
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMSieve::Container<T, HookPtr>::ensureNotInsertionPoint(
     T& node) noexcept {
   // If we are removing the insertion point node, grow tail before we remove
@@ -252,7 +255,7 @@ void MMSieve::Container<T, HookPtr>::ensureNotInsertionPoint(
   }
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMSieve::Container<T, HookPtr>::removeLocked(T& node) {
   ensureNotInsertionPoint(node);
   fifo_.remove(node);
@@ -266,7 +269,7 @@ void MMSieve::Container<T, HookPtr>::removeLocked(T& node) {
   return;
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMSieve::Container<T, HookPtr>::remove(T& node) noexcept {
   return lruMutex_->lock_combine([this, &node]() {
     if (!node.isInMMContainer()) {
@@ -285,7 +288,7 @@ bool MMSieve::Container<T, HookPtr>::remove(T& node) noexcept {
 //   removeLocked(node);
 // }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMSieve::Container<T, HookPtr>::remove(LockedIterator& it) noexcept {
   T& node = *it;
   XDCHECK(node.isInMMContainer());
@@ -293,7 +296,7 @@ void MMSieve::Container<T, HookPtr>::remove(LockedIterator& it) noexcept {
   removeLocked(node);
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 bool MMSieve::Container<T, HookPtr>::replace(T& oldNode,
                                                    T& newNode) noexcept {
   return lruMutex_->lock_combine([this, &oldNode, &newNode]() {
@@ -327,7 +330,7 @@ bool MMSieve::Container<T, HookPtr>::replace(T& oldNode,
   });
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 serialization::MMSieveObject
 MMSieve::Container<T, HookPtr>::saveState() const noexcept {
   serialization::MMSieveConfig configObject;
@@ -345,7 +348,7 @@ MMSieve::Container<T, HookPtr>::saveState() const noexcept {
   return object;
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 MMContainerStat MMSieve::Container<T, HookPtr>::getStats()
     const noexcept {
   auto stat = lruMutex_->lock_combine([this]() {
@@ -356,16 +359,18 @@ MMContainerStat MMSieve::Container<T, HookPtr>::getStats()
     // it can get optimized by the implementation.
     //
     // the rest of the parameters are 0, so we don't need the critical section
-    // to return them
-    return folly::make_array(fifo_.size(),
-                             tail == nullptr ? 0 : getUpdateTime(*tail));
+    // to return them. Without update times in the hooks, there is no tail
+    // time either.
+    return folly::make_array(
+        fifo_.size(),
+        !kTracksUpdateTime || tail == nullptr ? 0 : getUpdateTime(*tail));
   });
   return {stat[0] /* lru size */, stat[1] /* tail time */,
           // 0,
           0, 0, 0, 0, 0};
 }
 
-template <typename T, MMSieve::Hook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void MMSieve::Container<T, HookPtr>::reconfigureLocked(
     const Time& currTime) {
   if (currTime < nextReconfigureTime_) {
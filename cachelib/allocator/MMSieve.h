@@ -18,6 +18,8 @@
 
 #include <atomic>
 #include <cstring>
+#include <type_traits>
+#include <utility>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -144,7 +146,7 @@ class MMSieve {
   // around DList, is thread safe and can be accessed from multiple threads.
   // The current implementation models an LRU using the above DList
   // implementation.
-  template <typename T, Hook<T> T::*HookPtr>
+  template <typename T, auto HookPtr>
   struct Container {
    private:
     using FRList = SieveList<T, HookPtr>;
@@ -152,6 +154,11 @@ class MMSieve {
     using LockHolder = std::unique_lock<Mutex>;
     using PtrCompressor = typename T::PtrCompressor;
     using Time = typename Hook<T>::Time;
+
+    // whether the hook of T stores the time the node was last updated. The
+    // eviction age stats are not available without it.
+    static constexpr bool kTracksUpdateTime = std::remove_reference_t<
+        decltype(std::declval<T&>().*HookPtr)>::kTracksUpdateTime;
     using CompressedPtr = typename T::CompressedPtr;
     using RefFlags = typename T::Flags;
 
@@ -444,6 +451,18 @@ class MMSieve {
     FRIEND_TEST(MMSieveTest, Reconfigure);
   };
 };
+
+// MMSieve with a hook that does not store the update time. The item header
+// is 4 bytes smaller, at the cost of the eviction age stats.
+class MMSieveCompact : public MMSieve {
+ public:
+  // unique identifier per MMType. Differs from MMSieve since the item layout
+  // is different.
+  static const int kId;
+
+  template <typename T>
+  using Hook = SieveListHook<T, false /* kTrackUpdateTime */>;
+};
 }  // namespace cachelib
 }  // namespace facebook
 
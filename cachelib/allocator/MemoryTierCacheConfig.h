@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "cachelib/shm/ShmCommon.h"
 
 namespace facebook {
@@ -23,11 +25,26 @@ namespace cachelib {
 class MemoryTierCacheConfig {
  public:
   // Creates instance of MemoryTierCacheConfig for Posix/SysV Shared memory.
-  static MemoryTierCacheConfig fromShm() {
-    // TODO: expand this method when adding support for file-mapped memory
-    return MemoryTierCacheConfig();
+  static MemoryTierCacheConfig fromShm() { return MemoryTierCacheConfig(); }
+
+  // Creates instance of MemoryTierCacheConfig for file-mapped memory. The
+  // file at _path must not exist; it is created when the cache is
+  // initialized and removed on shutdown. Place it on a tmpfs or DAX mount
+  // of the memory device backing this tier.
+  static MemoryTierCacheConfig fromFile(const std::string& _path) {
+    if (_path.empty()) {
+      throw std::invalid_argument("File path for a memory tier is empty.");
+    }
+    MemoryTierCacheConfig config;
+    config.path = _path;
+    return config;
   }
 
+  // true if this tier is backed by a file instead of shared memory.
+  bool isFileBacked() const noexcept { return !path.empty(); }
+
+  const std::string& getPath() const noexcept { return path; }
+
   // Specifies ratio of this memory tier to other tiers. Absolute size
   // of each tier can be calculated as:
   // cacheSize * tierRatio / Sum of ratios for all tiers.
@@ -49,9 +66,9 @@ class MemoryTierCacheConfig {
 
   const NumaBitMask& getMemBind() const noexcept { return numaNodes; }
 
-  size_t calculateTierSize(size_t totalCacheSize, size_t partitionNum) {
-    // TODO: Call this method when tiers are enabled in allocator
-    // to calculate tier sizes in bytes.
+  // returns the size in bytes of this tier given the total cache size and
+  // the sum of ratios of all tiers.
+  size_t calculateTierSize(size_t totalCacheSize, size_t partitionNum) const {
     if (!partitionNum) {
       throw std::invalid_argument(
           "The total number of tier ratios must be an integer number >=1.");
@@ -76,8 +93,9 @@ class MemoryTierCacheConfig {
   // Numa node(s) to bind the tier
   NumaBitMask numaNodes;
 
-  // TODO: introduce a container for tier settings when adding support for
-  // file-mapped memory
+  // Path of the file backing this tier. Empty for shared memory tiers.
+  std::string path;
+
   MemoryTierCacheConfig() = default;
 };
 } // namespace cachelib
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/MissRatioCurveEstimator.h"
+
+#include <folly/Format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+namespace {
+// sampled accesses between two decays, per sampled key that can be tracked
+constexpr uint64_t kDecayAccessesPerKey = 16;
+} // namespace
+
+void MissRatioCurveConfig::validate() const {
+  if (!(sampleRate > 0 && sampleRate <= 1)) {
+    throw std::invalid_argument(folly::sformat(
+        "Miss ratio curve sample rate must be in (0, 1], got {}",
+        sampleRate));
+  }
+  if (maxSampledKeys == 0) {
+    throw std::invalid_argument(
+        "Miss ratio curve estimation needs to sample at least one key");
+  }
+}
+
+MissRatioCurveEstimator::MissRatioCurveEstimator(MissRatioCurveConfig config)
+    : config_(std::move(config)) {
+  config_.validate();
+  threshold_.store(std::max<uint64_t>(
+      1, static_cast<uint64_t>(config_.sampleRate *
+                               static_cast<double>(kSampleModulus))));
+}
+
+size_t MissRatioCurveEstimator::getBucketIndex(uint64_t distance) noexcept {
+  constexpr uint64_t kSubBuckets = 1ULL << kSubBucketBits;
+  if (distance < kSubBuckets) {
+    return static_cast<size_t>(distance);
+  }
+  const uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(distance));
+  const uint32_t shift = msb - kSubBucketBits;
+  return static_cast<size_t>((shift + 1) * kSubBuckets +
+                             ((distance >> shift) - kSubBuckets));
+}
+
+uint64_t MissRatioCurveEstimator::getBucketUpperBound(size_t idx) noexcept {
+  constexpr uint64_t kSubBuckets = 1ULL << kSubBucketBits;
+  if (idx < kSubBuckets) {
+    return idx;
+  }
+  const uint64_t shift = idx / kSubBuckets - 1;
+  const uint64_t lower = (kSubBuckets + idx % kSubBuckets) << shift;
+  return lower + ((1ULL << shift) - 1);
+}
+
+void MissRatioCurveEstimator::addSize(uint64_t time, int64_t delta) {
+  for (; time < tree_.size(); time += time & (~time + 1)) {
+    tree_[time] += static_cast<uint64_t>(delta);
+  }
+}
+
+uint64_t MissRatioCurveEstimator::sumSizes(uint64_t time) const {
+  uint64_t sum = 0;
+  for (; time > 0; time -= time & (~time + 1)) {
+    sum += tree_[time];
+  }
+  return sum;
+}
+
+void MissRatioCurveEstimator::compact() {
+  std::vector<SampledKey*> byTime;
+  byTime.reserve(keys_.size());
+  for (auto& kv : keys_) {
+    byTime.push_back(&kv.second);
+  }
+  std::sort(byTime.begin(), byTime.end(),
+            [](const SampledKey* a, const SampledKey* b) {
+              return a->time < b->time;
+            });
+
+  std::fill(tree_.begin(), tree_.end(), 0);
+  now_ = 1;
+  for (auto* key : byTime) {
+    key->time = now_++;
+    addSize(key->time, key->size);
+  }
+}
+
+void MissRatioCurveEstimator::lowerThreshold() {
+  while (keys_.size() > config_.maxSampledKeys) {
+    // the sample bits of the largest key become the new threshold and every
+    // key at or above it is dropped.
+    const auto newThreshold =
+        std::prev(keys_.end())->first >> (64 - kSampleBits);
+    if (newThreshold == 0) {
+      return;
+    }
+    auto it = keys_.lower_bound(newThreshold << (64 - kSampleBits));
+    for (auto dropIt = it; dropIt != keys_.end(); ++dropIt) {
+      addSize(dropIt->second.time, -static_cast<int64_t>(dropIt->second.size));
+    }
+    keys_.erase(it, keys_.end());
+    threshold_.store(newThreshold, std::memory_order_relaxed);
+  }
+}
+
+void MissRatioCurveEstimator::recordAccess(uint64_t keyHash, uint32_t size) {
+  std::lock_guard<std::mutex> l(lock_);
+  if (!isSampled(keyHash)) {
+    // the threshold was lowered since the caller checked
+    return;
+  }
+  if (tree_.empty()) {
+    tree_.resize(2 * config_.maxSampledKeys + 2, 0);
+  }
+  if (now_ >= tree_.size()) {
+    compact();
+  }
+
+  // an access counts as many as the keys each sampled key stands for
+  const double weight = static_cast<double>(kSampleModulus) /
+                        static_cast<double>(threshold_.load());
+  auto [it, inserted] =
+      keys_.try_emplace(getSampleOrder(keyHash), SampledKey{now_, size});
+  if (inserted) {
+    coldAccesses_ += weight;
+  } else {
+    // bytes of the distinct keys accessed since the last access to this one
+    const auto distance = sumSizes(now_ - 1) - sumSizes(it->second.time);
+    distances_[getBucketIndex(static_cast<uint64_t>(
+        static_cast<double>(distance) * weight))] += weight;
+    addSize(it->second.time, -static_cast<int64_t>(it->second.size));
+    it->second = SampledKey{now_, size};
+  }
+  addSize(now_, size);
+  now_++;
+  totalAccesses_ += weight;
+
+  if (inserted && keys_.size() > config_.maxSampledKeys) {
+    lowerThreshold();
+  }
+
+  // halve the counts periodically so that the curve follows the workload
+  if (++accessesSinceDecay_ >= kDecayAccessesPerKey * config_.maxSampledKeys) {
+    accessesSinceDecay_ = 0;
+    for (auto& count : distances_) {
+      count /= 2;
+    }
+    coldAccesses_ /= 2;
+    totalAccesses_ /= 2;
+  }
+}
+
+PoolMissRatioCurve MissRatioCurveEstimator::getCurve() const {
+  std::lock_guard<std::mutex> l(lock_);
+  PoolMissRatioCurve curve;
+  curve.sampleRate = static_cast<double>(threshold_.load()) /
+                     static_cast<double>(kSampleModulus);
+  curve.numAccesses = static_cast<uint64_t>(totalAccesses_);
+  if (totalAccesses_ <= 0) {
+    return curve;
+  }
+
+  // an access with a reuse distance below the cache size is a hit
+  size_t last = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    if (distances_[i] > 0) {
+      last = i;
+    }
+  }
+  double hits = 0;
+  for (size_t i = 0; i <= last; i++) {
+    hits += distances_[i];
+    curve.points.emplace_back(getBucketUpperBound(i) + 1,
+                              std::max(0.0, 1.0 - hits / totalAccesses_));
+  }
+  return curve;
+}
+
+PoolMissRatioCurves::PoolMissRatioCurves(MissRatioCurveConfig config) {
+  config.validate();
+  for (auto& estimator : estimators_) {
+    estimator = std::make_unique<MissRatioCurveEstimator>(config);
+  }
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/memory/MemoryPoolManager.h"
+
+namespace facebook {
+namespace cachelib {
+
+struct MissRatioCurveConfig {
+  // fraction of the keys sampled to start with. Lowered as needed to keep
+  // the sampled keys under maxSampledKeys.
+  double sampleRate{0.01};
+
+  // max number of sampled keys tracked per pool. Bounds the memory used
+  // and the cost of an access to a sampled key.
+  size_t maxSampledKeys{1 << 16};
+
+  // @throw std::invalid_argument if the config is invalid
+  void validate() const;
+};
+
+// Estimates the miss ratio curve of an LRU cache from the accesses to it,
+// following SHARDS: only keys whose hash falls under a threshold are
+// tracked, and the reuse distance of an access to one of them, in bytes of
+// the distinct sampled keys accessed since, is scaled up by the sampling
+// rate. When the sampled keys exceed their bound, the keys with the largest
+// hashes are dropped and the threshold lowered to match.
+//
+// Reuse distances are computed with a Fenwick tree over the access times of
+// the sampled keys, which holds the size of each key at its last access.
+// Older accesses are decayed so that the curve follows the workload.
+class MissRatioCurveEstimator {
+ public:
+  // the sampling decision uses the low bits of the key hash
+  static constexpr uint32_t kSampleBits = 24;
+  static constexpr uint64_t kSampleModulus = 1ULL << kSampleBits;
+
+  // histogram of reuse distances with 4 buckets per power of two bytes
+  static constexpr uint32_t kSubBucketBits = 2;
+  static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1)
+                                        << kSubBucketBits;
+
+  // @throw std::invalid_argument if the config is invalid
+  explicit MissRatioCurveEstimator(MissRatioCurveConfig config);
+
+  // @return true if accesses to the key with this hash are tracked.
+  bool isSampled(uint64_t keyHash) const noexcept {
+    return (keyHash & (kSampleModulus - 1)) <
+           threshold_.load(std::memory_order_relaxed);
+  }
+
+  // record an access to a sampled key of the given size in bytes.
+  void recordAccess(uint64_t keyHash, uint32_t size);
+
+  PoolMissRatioCurve getCurve() const;
+
+  static size_t getBucketIndex(uint64_t distance) noexcept;
+
+  // largest distance counted in the bucket
+  static uint64_t getBucketUpperBound(size_t idx) noexcept;
+
+ private:
+  struct SampledKey {
+    // time of the last access
+    uint64_t time;
+    uint32_t size;
+  };
+
+  // sampled keys are ordered by the bits that decide sampling, so that the
+  // ones to drop when lowering the threshold are at the end.
+  static uint64_t getSampleOrder(uint64_t keyHash) noexcept {
+    return (keyHash << (64 - kSampleBits)) | (keyHash >> kSampleBits);
+  }
+
+  // Fenwick tree of the sizes of the sampled keys by access time
+  void addSize(uint64_t time, int64_t delta);
+  uint64_t sumSizes(uint64_t time) const;
+
+  // renumber the access times of the sampled keys from 1 once the tree is
+  // out of times.
+  void compact();
+
+  // drop the sampled keys with the largest hashes until within bounds.
+  void lowerThreshold();
+
+  const MissRatioCurveConfig config_;
+
+  // keys with their low hash bits under this are sampled
+  std::atomic<uint64_t> threshold_{0};
+
+  mutable std::mutex lock_;
+
+  std::map<uint64_t, SampledKey> keys_;
+
+  std::vector<uint64_t> tree_;
+  uint64_t now_{1};
+
+  // accesses by reuse distance, and the ones to keys not seen before. Each
+  // access counts as many as the sampling rate says it stands for.
+  std::array<double, kNumBuckets> distances_{};
+  double coldAccesses_{0};
+  double totalAccesses_{0};
+
+  // sampled accesses since the counts were last decayed
+  uint64_t accessesSinceDecay_{0};
+};
+
+// Miss ratio curve estimators of all the pools of a cache.
+class PoolMissRatioCurves {
+ public:
+  // @throw std::invalid_argument if the config is invalid
+  explicit PoolMissRatioCurves(MissRatioCurveConfig config);
+
+  // record an access to the key in the pool, if the key is sampled.
+  void recordAccess(PoolId pid, folly::StringPiece key, uint32_t size) {
+    const auto hash =
+        folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), kHashSeed);
+    auto& estimator = *estimators_[pid];
+    if (estimator.isSampled(hash)) {
+      estimator.recordAccess(hash, size);
+    }
+  }
+
+  // @return the curve of the pool. Empty if nothing was sampled or the pool
+  //         id is invalid.
+  PoolMissRatioCurve getCurve(PoolId pid) const {
+    if (pid < 0 || static_cast<size_t>(pid) >= estimators_.size()) {
+      return {};
+    }
+    return estimators_[pid]->getCurve();
+  }
+
+ private:
+  // seed that keeps the sampling independent of the hash table's hash
+  static constexpr uint64_t kHashSeed = 0x5a4d5243;
+
+  std::array<std::unique_ptr<MissRatioCurveEstimator>,
+             MemoryPoolManager::kMaxPools>
+      estimators_;
+};
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/MissRatioCurveOptimizeStrategy.h"
+
+#include <folly/logging/xlog.h>
+
+#include <limits>
+#include <vector>
+
+namespace facebook {
+namespace cachelib {
+
+PoolOptimizeContext
+MissRatioCurveOptimizeStrategy::pickVictimAndReceiverRegularPoolsImpl(
+    const CacheBase& cache) {
+  const auto config = getConfigCopy();
+
+  // misses each pool would save with one more slab and add with one less
+  struct PoolScore {
+    PoolId pid;
+    double gain;
+    double loss;
+    bool validVictim;
+    bool validReceiver;
+  };
+  std::vector<PoolScore> scores;
+  for (const auto pid : cache.getRegularPoolIds()) {
+    if (!cache.autoResizeEnabledForPool(pid)) {
+      continue;
+    }
+    const auto curve = cache.getPoolMissRatioCurve(pid);
+    if (curve.points.empty()) {
+      continue;
+    }
+
+    const auto poolStats = cache.getPoolStats(pid);
+    const uint64_t size = poolStats.poolSize;
+    const double accesses = static_cast<double>(curve.numAccesses);
+    const double missRatio = curve.getMissRatio(size);
+    const bool validVictim = size > config.poolMinSizeSlabs * Slab::kSize;
+    scores.push_back(PoolScore{
+        pid,
+        accesses * (missRatio - curve.getMissRatio(size + Slab::kSize)),
+        validVictim
+            ? accesses * (curve.getMissRatio(size - Slab::kSize) - missRatio)
+            : 0,
+        validVictim,
+        poolStats.mpStats.freeMemory() <
+            config.poolMaxFreeSlabs * Slab::kSize});
+  }
+
+  PoolId receiver = Slab::kInvalidPoolId;
+  double receiverGain = 0;
+  for (const auto& score : scores) {
+    if (score.validReceiver && score.gain > receiverGain) {
+      receiverGain = score.gain;
+      receiver = score.pid;
+    }
+  }
+
+  PoolId victim = Slab::kInvalidPoolId;
+  double victimLoss = std::numeric_limits<double>::max();
+  for (const auto& score : scores) {
+    if (score.validVictim && score.pid != receiver &&
+        score.loss < victimLoss) {
+      victimLoss = score.loss;
+      victim = score.pid;
+    }
+  }
+
+  if (victim == Slab::kInvalidPoolId || receiver == Slab::kInvalidPoolId ||
+      receiverGain <= victimLoss * (1 + config.minImprovement)) {
+    return kNoOpContext;
+  }
+
+  XLOGF(DBG,
+        "Optimizing: receiver = {}, misses saved = {}, victim = {}, misses "
+        "added = {}",
+        static_cast<int>(receiver), receiverGain, static_cast<int>(victim),
+        victimLoss);
+  return PoolOptimizeContext{victim, receiver};
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+
+#include "cachelib/allocator/PoolOptimizeStrategy.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Moves memory between regular pools according to their miss ratio curves,
+// which the cache estimates online (see enableMissRatioCurveEstimation).
+// The receiver is the pool that would save the most misses with one more
+// slab, and the victim the one that would add the fewest with one less.
+// Misses are the miss ratio scaled by the accesses each curve is built
+// from, so busier pools weigh more.
+class MissRatioCurveOptimizeStrategy : public PoolOptimizeStrategy {
+ public:
+  struct Config : public BaseConfig {
+    // Pools with size no more than this many slabs cannot be a victim
+    uint32_t poolMinSizeSlabs{1};
+
+    // Pools with free memory (free allocs + free slabs) no less than this
+    // size cannot be a receiver.
+    uint32_t poolMaxFreeSlabs{2};
+
+    // memory is only moved when the misses saved by the receiver exceed
+    // the misses added to the victim by this fraction.
+    double minImprovement{0.1};
+
+    Config() noexcept {}
+    Config(uint32_t minSizeSlabs,
+           uint32_t maxFreeSlabs,
+           double improvement) noexcept
+        : poolMinSizeSlabs(minSizeSlabs),
+          poolMaxFreeSlabs(maxFreeSlabs),
+          minImprovement(improvement) {}
+  };
+
+  explicit MissRatioCurveOptimizeStrategy(Config config = {})
+      : PoolOptimizeStrategy(MissRatioCurve), config_(std::move(config)) {}
+
+  // Update the config. This will not affect the current rebalancing, but
+  // will take effect in the next round
+  void updateConfig(const BaseConfig& baseConfig) override final {
+    std::lock_guard<std::mutex> l(configLock_);
+    config_ = static_cast<const Config&>(baseConfig);
+  }
+
+ protected:
+  // This returns a copy of the current config.
+  Config getConfigCopy() const {
+    std::lock_guard<std::mutex> l(configLock_);
+    return config_;
+  }
+
+  // pick victim and receiver regular pools
+  PoolOptimizeContext pickVictimAndReceiverRegularPoolsImpl(
+      const CacheBase& cache) override final;
+
+ private:
+  // Config for this strategy, this can be updated anytime.
+  // Do not access this directly, always use `getConfig()` to
+  // obtain a copy first
+  Config config_;
+  mutable std::mutex configLock_;
+};
+
+} // namespace cachelib
+} // namespace facebook
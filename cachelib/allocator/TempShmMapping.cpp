@@ -26,10 +26,14 @@ namespace facebook {
 namespace cachelib {
 
 TempShmMapping::TempShmMapping(size_t size)
+    : TempShmMapping(size, ShmSegmentOpts{}) {}
+
+TempShmMapping::TempShmMapping(size_t size, ShmSegmentOpts opts)
     : size_(size),
       tempCacheDir_(util::getUniqueTempDir("cachedir")),
       shmManager_(createShmManager(tempCacheDir_)),
-      addr_(createShmMapping(*shmManager_.get(), size, tempCacheDir_)) {}
+      addr_(createShmMapping(*shmManager_.get(), size, tempCacheDir_, opts)) {
+}
 
 TempShmMapping::~TempShmMapping() {
   try {
@@ -62,14 +66,16 @@ std::unique_ptr<ShmManager> TempShmMapping::createShmManager(
 
 void* TempShmMapping::createShmMapping(ShmManager& shmManager,
                                        size_t size,
-                                       const std::string& cacheDir) {
+                                       const std::string& cacheDir,
+                                       const ShmSegmentOpts& opts) {
   void* addr = nullptr;
   void* shmAddr = nullptr;
   try {
     addr =
         util::mmapAlignedZeroedMemory(sizeof(Slab), size, true /* readOnly */);
     shmAddr =
-        shmManager.createShm(detail::kTempShmCacheName.str(), size, addr).addr;
+        shmManager.createShm(detail::kTempShmCacheName.str(), size, addr, opts)
+            .addr;
     // Mark the shared memory segment to be removed on exit. This will ensure
     // that the segment is dropped on exit.
     auto& shm = shmManager.getShmByName(detail::kTempShmCacheName.str());
@@ -42,6 +42,9 @@ constexpr folly::StringPiece kTempShmCacheName = "temp_shm_cache";
 class TempShmMapping {
  public:
   explicit TempShmMapping(size_t size);
+  // @param opts  options for the segment, e.g. to back the mapping with a
+  //              file or bind it to numa nodes.
+  TempShmMapping(size_t size, ShmSegmentOpts opts);
   ~TempShmMapping();
   // get the start of addrress.
   void* getAddr() const { return addr_; }
@@ -51,7 +54,8 @@ class TempShmMapping {
       const std::string& cacheDir);
   static void* createShmMapping(ShmManager& shmManager,
                                 size_t size,
-                                const std::string& cacheDir);
+                                const std::string& cacheDir,
+                                const ShmSegmentOpts& opts);
 
   size_t size_{0};
   std::string tempCacheDir_;
@@ -18,7 +18,7 @@ namespace facebook {
 namespace cachelib {
 
 /* Linked list implemenation */
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::linkAtHead(T& node) noexcept {
   XDCHECK_NE(reinterpret_cast<uintptr_t>(&node),
              reinterpret_cast<uintptr_t>(head_));
@@ -36,7 +36,7 @@ void ClockList<T, HookPtr>::linkAtHead(T& node) noexcept {
   size_++;
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::linkAtTail(T& node) noexcept {
   XDCHECK_NE(reinterpret_cast<uintptr_t>(&node),
              reinterpret_cast<uintptr_t>(tail_));
@@ -54,7 +54,7 @@ void ClockList<T, HookPtr>::linkAtTail(T& node) noexcept {
   size_++;
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::insertBefore(T& nextNode, T& node) noexcept {
   XDCHECK_NE(reinterpret_cast<uintptr_t>(&nextNode),
              reinterpret_cast<uintptr_t>(&node));
@@ -78,7 +78,7 @@ void ClockList<T, HookPtr>::insertBefore(T& nextNode, T& node) noexcept {
   size_++;
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::unlink(const T& node) noexcept {
   XDCHECK_GT(size_, 0u);
   // fix head_ and tail_ if the node is either of that.
@@ -105,14 +105,14 @@ void ClockList<T, HookPtr>::unlink(const T& node) noexcept {
   size_--;
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::remove(T& node) noexcept {
   unlink(node);
   setNext(node, nullptr);
   setPrev(node, nullptr);
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
   // Update head and tail links if needed
   if (&oldNode == head_) {
@@ -144,7 +144,7 @@ void ClockList<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
   setNext(oldNode, nullptr);
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::moveToHead(T& node) noexcept {
   if (&node == head_) {
     return;
@@ -154,7 +154,7 @@ void ClockList<T, HookPtr>::moveToHead(T& node) noexcept {
 }
 
 /* Iterator Implementation */
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::Iterator::goForward() noexcept {
   if (dir_ == Direction::FROM_TAIL) {
     curr_ = ClockList_->getPrev(*curr_);
@@ -163,7 +163,7 @@ void ClockList<T, HookPtr>::Iterator::goForward() noexcept {
   }
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void ClockList<T, HookPtr>::Iterator::goBackward() noexcept {
   if (dir_ == Direction::FROM_TAIL) {
     curr_ = ClockList_->getNext(*curr_);
@@ -172,7 +172,7 @@ void ClockList<T, HookPtr>::Iterator::goBackward() noexcept {
   }
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator&
 ClockList<T, HookPtr>::Iterator::operator++() noexcept {
   XDCHECK(curr_ != nullptr);
@@ -182,7 +182,7 @@ ClockList<T, HookPtr>::Iterator::operator++() noexcept {
   return *this;
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator&
 ClockList<T, HookPtr>::Iterator::operator--() noexcept {
   XDCHECK(curr_ != nullptr);
@@ -192,35 +192,35 @@ ClockList<T, HookPtr>::Iterator::operator--() noexcept {
   return *this;
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator ClockList<T, HookPtr>::begin()
     const noexcept {
   return ClockList<T, HookPtr>::Iterator(head_, Iterator::Direction::FROM_HEAD,
                                          *this);
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator ClockList<T, HookPtr>::rbegin()
     const noexcept {
   return ClockList<T, HookPtr>::Iterator(tail_, Iterator::Direction::FROM_TAIL,
                                          *this);
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator ClockList<T, HookPtr>::end()
     const noexcept {
   return ClockList<T, HookPtr>::Iterator(nullptr,
                                          Iterator::Direction::FROM_HEAD, *this);
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator ClockList<T, HookPtr>::rend()
     const noexcept {
   return ClockList<T, HookPtr>::Iterator(nullptr,
                                          Iterator::Direction::FROM_TAIL, *this);
 }
 
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename ClockList<T, HookPtr>::Iterator
 ClockList<T, HookPtr>::evictBegin() noexcept {
   if (curr_hand_ == nullptr) {
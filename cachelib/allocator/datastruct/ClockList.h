@@ -23,66 +23,19 @@
 #include "cachelib/allocator/serialize/gen-cpp2/objects_types.h"
 #pragma GCC diagnostic pop
 
+#include "cachelib/allocator/datastruct/FIFOListHook.h"
 #include "cachelib/common/CompilerUtils.h"
 
 namespace facebook {
 namespace cachelib {
 
-// node information for the double linked list modelling the lru. It has the
-// previous, next information with the last time the item was updated in the
-// LRU.
-template <typename T>
-struct CACHELIB_PACKED_ATTR ClockListHook {
-  using Time = uint32_t;
-  using CompressedPtr = typename T::CompressedPtr;
-  using PtrCompressor = typename T::PtrCompressor;
-
-  void setNext(T* const n, const PtrCompressor& compressor) noexcept {
-    next_ = compressor.compress(n);
-  }
-
-  void setNext(CompressedPtr next) noexcept { next_ = next; }
-
-  void setPrev(T* const p, const PtrCompressor& compressor) noexcept {
-    prev_ = compressor.compress(p);
-  }
-
-  void setPrev(CompressedPtr prev) noexcept { prev_ = prev; }
-
-  CompressedPtr getNext() const noexcept { return CompressedPtr(next_); }
-
-  T* getNext(const PtrCompressor& compressor) const noexcept {
-    return compressor.unCompress(next_);
-  }
-
-  CompressedPtr getPrev() const noexcept { return CompressedPtr(prev_); }
-
-  T* getPrev(const PtrCompressor& compressor) const noexcept {
-    return compressor.unCompress(prev_);
-  }
-
-  // set and get the time when the node was updated in the lru.
-  void setUpdateTime(Time time) noexcept { updateTime_ = time; }
-
-  Time getUpdateTime() const noexcept {
-    // Suppress TSAN here because we don't care if an item is promoted twice by
-    // two get operations running concurrently. It should be very rarely and is
-    // just a minor inefficiency if it happens.
-    folly::annotate_ignore_thread_sanitizer_guard g(__FILE__, __LINE__);
-    return updateTime_;
-  }
-
- private:
-  CompressedPtr next_{};  // next node in the linked list
-  CompressedPtr prev_{};  // previous node in the linked list
-  // timestamp when this was last updated to the head of the list
-  Time updateTime_{0};
-  //   int32_t visited_{0};
-};
+// node information for the double linked list. See FIFOListHook.
+template <typename T, bool kTrackUpdateTime = true>
+using ClockListHook = FIFOListHook<T, kTrackUpdateTime>;
 
 // uses a double linked list to implement an LRU. T must be have a public
 // member of type Hook and HookPtr must point to that.
-template <typename T, ClockListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 class ClockList {
  public:
   using CompressedPtr = typename T::CompressedPtr;
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/synchronization/SanitizeThread.h>
+
+#include <cstdint>
+
+#include "cachelib/common/CompilerUtils.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace detail {
+// previous and next links of a node in a FIFO-family list.
+template <typename T>
+struct CACHELIB_PACKED_ATTR FIFOListLinks {
+  using CompressedPtr = typename T::CompressedPtr;
+  using PtrCompressor = typename T::PtrCompressor;
+
+  void setNext(T* const n, const PtrCompressor& compressor) noexcept {
+    next_ = compressor.compress(n);
+  }
+
+  void setNext(CompressedPtr next) noexcept { next_ = next; }
+
+  void setPrev(T* const p, const PtrCompressor& compressor) noexcept {
+    prev_ = compressor.compress(p);
+  }
+
+  void setPrev(CompressedPtr prev) noexcept { prev_ = prev; }
+
+  CompressedPtr getNext() const noexcept { return CompressedPtr(next_); }
+
+  T* getNext(const PtrCompressor& compressor) const noexcept {
+    return compressor.unCompress(next_);
+  }
+
+  CompressedPtr getPrev() const noexcept { return CompressedPtr(prev_); }
+
+  T* getPrev(const PtrCompressor& compressor) const noexcept {
+    return compressor.unCompress(prev_);
+  }
+
+ private:
+  CompressedPtr next_{}; // next node in the linked list
+  CompressedPtr prev_{}; // previous node in the linked list
+};
+} // namespace detail
+
+// node information for the double linked list used by the FIFO-family
+// policies (SIEVE, CLOCK). It has the previous, next information and,
+// unless kTrackUpdateTime is false, the last time the item was updated in
+// the list.
+//
+// FIFO-family policies do not need the update time to pick a victim; it is
+// only used for eviction age stats. Dropping it makes the hook and thus the
+// item header 4 bytes smaller.
+template <typename T, bool kTrackUpdateTime = true>
+struct CACHELIB_PACKED_ATTR FIFOListHook : public detail::FIFOListLinks<T> {
+  using Time = uint32_t;
+
+  static constexpr bool kTracksUpdateTime = true;
+
+  // set and get the time when the node was updated in the list.
+  void setUpdateTime(Time time) noexcept { updateTime_ = time; }
+
+  Time getUpdateTime() const noexcept {
+    // Suppress TSAN here because we don't care if an item is promoted twice by
+    // two get operations running concurrently. It should be very rarely and is
+    // just a minor inefficiency if it happens.
+    folly::annotate_ignore_thread_sanitizer_guard g(__FILE__, __LINE__);
+    return updateTime_;
+  }
+
+ private:
+  // timestamp when this was last updated in the list
+  Time updateTime_{0};
+};
+
+template <typename T>
+struct CACHELIB_PACKED_ATTR FIFOListHook<T, false>
+    : public detail::FIFOListLinks<T> {
+  using Time = uint32_t;
+
+  static constexpr bool kTracksUpdateTime = false;
+
+  // the update time is not stored. Callers must check kTracksUpdateTime
+  // before using it for stats.
+  void setUpdateTime(Time) noexcept {}
+
+  Time getUpdateTime() const noexcept { return 0; }
+};
+
+} // namespace cachelib
+} // namespace facebook
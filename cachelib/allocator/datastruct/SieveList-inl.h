@@ -23,7 +23,7 @@ namespace cachelib {
  */
 
 /* Linked list implemenation */
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::linkAtHead(T& node) noexcept {
   setPrev(node, nullptr);
 
@@ -50,7 +50,7 @@ void SieveList<T, HookPtr>::linkAtHead(T& node) noexcept {
   size_++;
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::unlink(const T& node) noexcept {
   if (mtx_->try_lock()) {
     // we should have locked the mutex
@@ -87,7 +87,7 @@ void SieveList<T, HookPtr>::unlink(const T& node) noexcept {
   size_--;
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::remove(T& node) noexcept {
   auto* const prev = getPrev(node);
   auto* const next = getNext(node);
@@ -101,7 +101,7 @@ void SieveList<T, HookPtr>::remove(T& node) noexcept {
   setPrev(node, nullptr);
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
   LockHolder l(*mtx_);
 
@@ -135,7 +135,7 @@ void SieveList<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
   setNext(oldNode, nullptr);
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::moveToHead(T& node) noexcept {
   if (&node == head_) {
     return;
@@ -144,7 +144,7 @@ void SieveList<T, HookPtr>::moveToHead(T& node) noexcept {
   linkAtHead(node);
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 T* SieveList<T, HookPtr>::getEvictionCandidate() noexcept {
   if (size_.load() == 0)
     return nullptr;
@@ -190,7 +190,7 @@ T* SieveList<T, HookPtr>::getEvictionCandidate() noexcept {
 }
 
 /* Iterator Implementation */
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::Iterator::goForward() noexcept {
   if (dir_ == Direction::FROM_TAIL) {
     curr_ = SieveList_->getPrev(*curr_);
@@ -199,7 +199,7 @@ void SieveList<T, HookPtr>::Iterator::goForward() noexcept {
   }
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 void SieveList<T, HookPtr>::Iterator::goBackward() noexcept {
   if (dir_ == Direction::FROM_TAIL) {
     curr_ = SieveList_->getNext(*curr_);
@@ -208,7 +208,7 @@ void SieveList<T, HookPtr>::Iterator::goBackward() noexcept {
   }
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename SieveList<T, HookPtr>::Iterator&
 SieveList<T, HookPtr>::Iterator::operator++() noexcept {
   XDCHECK(curr_ != nullptr);
@@ -218,7 +218,7 @@ SieveList<T, HookPtr>::Iterator::operator++() noexcept {
   return *this;
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename SieveList<T, HookPtr>::Iterator&
 SieveList<T, HookPtr>::Iterator::operator--() noexcept {
   XDCHECK(curr_ != nullptr);
@@ -228,28 +228,28 @@ SieveList<T, HookPtr>::Iterator::operator--() noexcept {
   return *this;
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename SieveList<T, HookPtr>::Iterator
 SieveList<T, HookPtr>::begin() const noexcept {
   return SieveList<T, HookPtr>::Iterator(
       head_, Iterator::Direction::FROM_HEAD, *this);
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename SieveList<T, HookPtr>::Iterator
 SieveList<T, HookPtr>::rbegin() const noexcept {
   return SieveList<T, HookPtr>::Iterator(
       tail_, Iterator::Direction::FROM_TAIL, *this);
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename SieveList<T, HookPtr>::Iterator
 SieveList<T, HookPtr>::end() const noexcept {
   return SieveList<T, HookPtr>::Iterator(
       nullptr, Iterator::Direction::FROM_HEAD, *this);
 }
 
-template <typename T, SieveListHook<T> T::*HookPtr>
+template <typename T, auto HookPtr>
 typename SieveList<T, HookPtr>::Iterator
 SieveList<T, HookPtr>::rend() const noexcept {
   return SieveList<T, HookPtr>::Iterator(
@@ -16,9 +16,11 @@
 
 #pragma once
 
+#include <folly/Format.h>
 #include <folly/logging/xlog.h>
 
 #include <memory>
+#include <stdexcept>
 
 #include "cachelib/allocator/memory/Slab.h"
 
@@ -27,6 +29,12 @@ namespace cachelib {
 
 class SlabAllocator;
 
+template <typename PtrType, typename AllocatorContainer>
+class PtrCompressor;
+
+// identifies a memory tier of the cache. Tier 0 is the top (fastest) tier.
+using TierId = int8_t;
+
 // the following are for pointer compression for the memory allocator.  We
 // compress pointers by storing the slab index and the alloc index of the
 // allocation inside the slab. With slab worth kNumSlabBits of data, if we
@@ -39,6 +47,11 @@ class SlabAllocator;
 // This CompressedPtr makes decompression fast by staying away from division and
 // modulo arithmetic and doing those during the compression time. We most often
 // decompress a CompressedPtr than compress a pointer while creating one.
+//
+// When the cache is configured with more than one memory tier, the top bit of
+// the compressed pointer holds the tier id of the allocation. This halves the
+// addressable memory per tier, but lets a single 32-bit representation refer
+// to allocations in any tier.
 class CACHELIB_PACKED_ATTR CompressedPtr {
  public:
   using PtrType = uint32_t;
@@ -67,6 +80,17 @@ class CACHELIB_PACKED_ATTR CompressedPtr {
     return static_cast<size_t>(1) << (kNumSlabIdxBits + Slab::kNumSlabBits);
   }
 
+  // maximum adressable memory per tier when the cache is multi-tiered.
+  static constexpr size_t getMaxAddressableSizeMultiTier() noexcept {
+    return static_cast<size_t>(1)
+           << (kNumSlabIdxBits - kNumTierIdxBits + Slab::kNumSlabBits);
+  }
+
+  // maximum number of tiers that can be encoded in a compressed pointer.
+  static constexpr size_t getMaxTiers() noexcept {
+    return static_cast<size_t>(1) << kNumTierIdxBits;
+  }
+
   // default construct to nullptr.
   CompressedPtr() = default;
 
@@ -89,8 +113,8 @@ class CACHELIB_PACKED_ATTR CompressedPtr {
   PtrType ptr_{kNull};
 
   // create a compressed pointer for a valid memory allocation.
-  CompressedPtr(uint32_t slabIdx, uint32_t allocIdx)
-      : ptr_(compress(slabIdx, allocIdx)) {}
+  CompressedPtr(uint32_t slabIdx, uint32_t allocIdx, bool isMultiTiered)
+      : ptr_(compress(slabIdx, allocIdx, isMultiTiered)) {}
 
   constexpr explicit CompressedPtr(PtrType ptr) noexcept : ptr_{ptr} {}
 
@@ -107,18 +131,35 @@ class CACHELIB_PACKED_ATTR CompressedPtr {
   static constexpr unsigned int kNumSlabIdxBits =
       NumBits<PtrType>::value - kNumAllocIdxBits;
 
+  // Number of bits borrowed from the slab index for the tier id when the
+  // cache is multi-tiered.
+  static constexpr unsigned int kNumTierIdxBits = 1;
+
+  // Offset of the tier id. The tier id occupies the top bit(s).
+  static constexpr unsigned int kNumTierIdxOffset =
+      NumBits<PtrType>::value - kNumTierIdxBits;
+
+  static constexpr PtrType kTierIdxMask = ~(((PtrType)1 << kNumTierIdxOffset) -
+                                            1);
+
   // Compress the given slabIdx and allocIdx into a 32-bit compressed
   // pointer.
-  static PtrType compress(uint32_t slabIdx, uint32_t allocIdx) noexcept {
+  static PtrType compress(uint32_t slabIdx,
+                          uint32_t allocIdx,
+                          bool isMultiTiered) noexcept {
     XDCHECK_LE(allocIdx, kAllocIdxMask);
-    XDCHECK_LT(slabIdx, (1u << kNumSlabIdxBits) - 1);
+    XDCHECK_LT(slabIdx,
+               (1u << (isMultiTiered ? kNumSlabIdxBits - kNumTierIdxBits
+                                     : kNumSlabIdxBits)) -
+                   1);
     return (slabIdx << kNumAllocIdxBits) + allocIdx;
   }
 
   // Get the slab index of the compressed ptr
-  uint32_t getSlabIdx() const noexcept {
+  uint32_t getSlabIdx(bool isMultiTiered) const noexcept {
     XDCHECK(!isNull());
-    return static_cast<uint32_t>(ptr_ >> kNumAllocIdxBits);
+    const auto noTierIdPtr = isMultiTiered ? ptr_ & ~kTierIdxMask : ptr_;
+    return static_cast<uint32_t>(noTierIdPtr >> kNumAllocIdxBits);
   }
 
   // Get the allocation index of the compressed ptr
@@ -127,28 +168,46 @@ class CACHELIB_PACKED_ATTR CompressedPtr {
     return static_cast<uint32_t>(ptr_ & kAllocIdxMask);
   }
 
+  // Get the tier id of the compressed ptr. Always 0 for single tier caches.
+  TierId getTierId(bool isMultiTiered) const noexcept {
+    XDCHECK(!isNull());
+    return isMultiTiered ? static_cast<TierId>(ptr_ >> kNumTierIdxOffset) : 0;
+  }
+
+  // Encode the tier id into a compressed ptr that was created without one.
+  void setTierId(TierId tid) noexcept {
+    XDCHECK(!isNull());
+    XDCHECK_LT(static_cast<size_t>(tid), getMaxTiers());
+    XDCHECK_EQ(ptr_ & kTierIdxMask, 0u);
+    ptr_ += static_cast<PtrType>(tid) << kNumTierIdxOffset;
+  }
+
   friend SlabAllocator;
+
+  template <typename CPtrType, typename AllocatorContainer>
+  friend class PtrCompressor;
 };
 
 template <typename PtrType, typename AllocatorT>
-class PtrCompressor {
+class SingleTierPtrCompressor {
  public:
-  explicit PtrCompressor(const AllocatorT& allocator) noexcept
+  explicit SingleTierPtrCompressor(const AllocatorT& allocator) noexcept
       : allocator_(allocator) {}
 
   const CompressedPtr compress(const PtrType* uncompressed) const {
-    return allocator_.compress(uncompressed);
+    return allocator_.compress(uncompressed, false /* isMultiTiered */);
   }
 
   PtrType* unCompress(const CompressedPtr compressed) const {
-    return static_cast<PtrType*>(allocator_.unCompress(compressed));
+    return static_cast<PtrType*>(
+        allocator_.unCompress(compressed, false /* isMultiTiered */));
   }
 
-  bool operator==(const PtrCompressor& rhs) const noexcept {
+  bool operator==(const SingleTierPtrCompressor& rhs) const noexcept {
     return &allocator_ == &rhs.allocator_;
   }
 
-  bool operator!=(const PtrCompressor& rhs) const noexcept {
+  bool operator!=(const SingleTierPtrCompressor& rhs) const noexcept {
     return !(*this == rhs);
   }
 
@@ -156,5 +215,62 @@ class PtrCompressor {
   // memory allocator that does the pointer compression.
   const AllocatorT& allocator_;
 };
+
+// Pointer compressor over all the memory tiers of a cache. AllocatorContainer
+// is a container of pointers to allocators indexed by tier id. With a single
+// tier, this is equivalent to the SingleTierPtrCompressor and the tier bit is
+// not used.
+template <typename PtrType, typename AllocatorContainer>
+class PtrCompressor {
+ public:
+  explicit PtrCompressor(const AllocatorContainer& allocators) noexcept
+      : allocators_(allocators) {}
+
+  const CompressedPtr compress(const PtrType* uncompressed) const {
+    if (uncompressed == nullptr) {
+      return CompressedPtr{};
+    }
+
+    const bool isMultiTiered = allocators_.size() > 1;
+    if (!isMultiTiered) {
+      return allocators_[0]->compress(uncompressed, false);
+    }
+
+    for (TierId tid = 0; static_cast<size_t>(tid) < allocators_.size();
+         tid++) {
+      if (allocators_[tid]->isMemoryInAllocator(
+              static_cast<const void*>(uncompressed))) {
+        auto cptr = allocators_[tid]->compress(uncompressed, isMultiTiered);
+        cptr.setTierId(tid);
+        return cptr;
+      }
+    }
+    throw std::invalid_argument(
+        folly::sformat("Invalid pointer ptr {}", uncompressed));
+  }
+
+  PtrType* unCompress(const CompressedPtr compressed) const {
+    if (compressed.isNull()) {
+      return nullptr;
+    }
+
+    const bool isMultiTiered = allocators_.size() > 1;
+    const auto tid = compressed.getTierId(isMultiTiered);
+    return static_cast<PtrType*>(
+        allocators_[tid]->unCompress(compressed, isMultiTiered));
+  }
+
+  bool operator==(const PtrCompressor& rhs) const noexcept {
+    return &allocators_ == &rhs.allocators_;
+  }
+
+  bool operator!=(const PtrCompressor& rhs) const noexcept {
+    return !(*this == rhs);
+  }
+
+ private:
+  // memory allocators that do the pointer compression, indexed by tier.
+  const AllocatorContainer& allocators_;
+};
 } // namespace cachelib
 } // namespace facebook
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include "cachelib/allocator/memory/AllocationClass.h"
 #include "cachelib/allocator/memory/MemoryPool.h"
@@ -72,7 +74,7 @@ class MemoryAllocator {
   using SerializationType = serialization::MemoryAllocatorObject;
 
   // maximum number of allocation classes that we support.
-  static constexpr unsigned int kMaxClasses = 1 << 7;
+  static constexpr unsigned int kMaxClasses = MemoryPool::kMaxClasses;
   static constexpr ClassId kMaxClassId = kMaxClasses - 1;
 
   // maximum number of memory pools that we support.
@@ -241,6 +243,29 @@ class MemoryAllocator {
     return memoryPoolManager_.resizePools(src, dest, bytes);
   }
 
+  // add an allocation class of _size_ to the pool. The class does not serve
+  // allocations until it is made active through setActiveAllocationClasses.
+  //
+  // @param pid   the pool id
+  // @param size  the allocation size of the new class
+  // @return      the class id of the new allocation class
+  // @throw   std::invalid_argument if the poolId or size is invalid or the
+  //          pool has run out of class ids.
+  ClassId addAllocationClass(PoolId pid, uint32_t size) {
+    return memoryPoolManager_.getPoolById(pid).addAllocationClass(size);
+  }
+
+  // change the allocation classes that new allocations of the pool are
+  // served from. See MemoryPool::setActiveAllocationClasses.
+  //
+  // @param pid       the pool id
+  // @param classIds  the classes to serve allocations from
+  // @throw   std::invalid_argument if the poolId or classIds are invalid.
+  void setActiveAllocationClasses(PoolId pid,
+                                  const std::vector<ClassId>& classIds) {
+    memoryPoolManager_.getPoolById(pid).setActiveAllocationClasses(classIds);
+  }
+
   // Start the process of releasing a slab from this allocation class id and
   // pool id. The release could be for a pool resizing or allocation class
   // rebalancing. If a valid context is returned, the caller needs to free the
@@ -514,13 +539,23 @@ class MemoryAllocator {
   serialization::MemoryAllocatorObject saveState();
 
   using CompressedPtr = facebook::cachelib::CompressedPtr;
+  // compressor over all the memory tiers of a cache, see CompressedPtr.h
+  template <typename PtrType>
+  using PtrCompressor = facebook::cachelib::
+      PtrCompressor<PtrType, std::vector<std::unique_ptr<MemoryAllocator>>>;
+
   template <typename PtrType>
-  using PtrCompressor =
-      facebook::cachelib::PtrCompressor<PtrType, SlabAllocator>;
+  using SingleTierPtrCompressor =
+      facebook::cachelib::SingleTierPtrCompressor<PtrType, SlabAllocator>;
 
   template <typename PtrType>
-  PtrCompressor<PtrType> createPtrCompressor() {
-    return slabAllocator_.createPtrCompressor<PtrType>();
+  SingleTierPtrCompressor<PtrType> createSingleTierPtrCompressor() const {
+    return slabAllocator_.createSingleTierPtrCompressor<PtrType>();
+  }
+
+  // true if the memory is part of the slab memory managed by this allocator.
+  bool isMemoryInAllocator(const void* memory) const noexcept {
+    return slabAllocator_.isMemoryInAllocator(memory);
   }
 
   // compress a given pointer to a valid allocation made out of this allocator
@@ -533,21 +568,26 @@ class MemoryAllocator {
   //                allocation.  This can be stored and decompressed as long
   //                as the original pointer is valid.
   //
+  // @param  isMultiTiered  true if the owning cache has more than one tier
+  //
   // @throw  std::invalid_argument if the ptr is invalid.
-  CompressedPtr CACHELIB_INLINE compress(const void* ptr) const {
-    return slabAllocator_.compress(ptr);
+  CompressedPtr CACHELIB_INLINE compress(const void* ptr,
+                                         bool isMultiTiered = false) const {
+    return slabAllocator_.compress(ptr, isMultiTiered);
   }
 
   // retrieve the raw pointer corresponding to the compressed pointer. This is
   // guaranteed to succeed as long as the pointer corresponding to this was
   // never freed back to the allocator.
   //
-  // @param cPtr    the compressed pointer
+  // @param cPtr           the compressed pointer
+  // @param isMultiTiered   true if the owning cache has more than one tier
   // @return        the raw pointer corresponding to this compressed pointer.
   //
   // @throw   std::invalid_argument if the compressed pointer is invalid.
-  void* CACHELIB_INLINE unCompress(const CompressedPtr cPtr) const {
-    return slabAllocator_.unCompress(cPtr);
+  void* CACHELIB_INLINE unCompress(const CompressedPtr cPtr,
+                                   bool isMultiTiered = false) const {
+    return slabAllocator_.unCompress(cPtr, isMultiTiered);
   }
 
   // a special implementation of pointer compression for benchmarking purposes.
@@ -25,42 +25,77 @@
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
 #include <folly/Format.h>
+#include <folly/synchronization/Rcu.h>
 #pragma GCC diagnostic pop
 
 using namespace facebook::cachelib;
 using LockHolder = std::unique_lock<std::mutex>;
 
-/* static */
-std::vector<uint32_t> MemoryPool::createMcSizesFromSerialized(
+template <typename Fn>
+auto MemoryPool::readActiveClasses(Fn&& fn) const {
+  // the set published at construction is never freed. A reader that does not
+  // see reconfigured_ loaded that set, since the flag is set before any
+  // other set is published.
+  const auto* active = activeClasses_.load(std::memory_order_acquire);
+  if (!reconfigured_.load(std::memory_order_acquire)) {
+    return fn(*active);
+  }
+  std::scoped_lock<folly::rcu_domain> guard(folly::rcu_default_domain());
+  return fn(*activeClasses_.load(std::memory_order_acquire));
+}
+
+void MemoryPool::createMcFromSerialized(
     const serialization::MemoryPoolObject& object) {
-  std::vector<uint32_t> acSizes;
-  for (auto size : *object.acSizes()) {
-    acSizes.push_back(static_cast<uint32_t>(size));
+  if (object.acSizes()->size() != object.ac()->size()) {
+    throw std::invalid_argument(folly::sformat(
+        "Allocation classes are not setup correctly. acSize.size = {}, but "
+        "ac.size() = {}",
+        object.acSizes()->size(), object.ac()->size()));
   }
-  return acSizes;
-}
 
-/* static */
-MemoryPool::ACVector MemoryPool::createMcFromSerialized(
-    const serialization::MemoryPoolObject& object,
-    PoolId poolId,
-    SlabAllocator& alloc) {
-  MemoryPool::ACVector ac;
+  if (object.ac()->size() > kMaxClasses) {
+    throw std::invalid_argument(
+        folly::sformat("Too many allocation classes {}", object.ac()->size()));
+  }
+
+  unsigned int numClasses = 0;
   for (const auto& allocClassObject : *object.ac()) {
-    ac.emplace_back(new AllocationClass(allocClassObject, poolId, alloc));
+    ac_[numClasses++].reset(
+        new AllocationClass(allocClassObject, getId(), slabAllocator_));
   }
-  return ac;
+  numClasses_.store(numClasses, std::memory_order_release);
+
+  for (size_t i = 0; i < numClasses; i++) {
+    const auto size = static_cast<uint32_t>(object.acSizes()[i]);
+    if (size != ac_[i]->getAllocSize()) {
+      throw std::invalid_argument(folly::sformat(
+          "Allocation Class with id {} and size {}, does not match the "
+          "allocation size we expect {}",
+          ac_[i]->getId(), ac_[i]->getAllocSize(), size));
+    }
+  }
+
+  // pools saved before reconfiguration was supported serve allocations from
+  // all of their classes.
+  std::vector<ClassId> activeClassIds;
+  if (object.activeClassIds()->empty()) {
+    for (unsigned int i = 0; i < numClasses; i++) {
+      activeClassIds.push_back(static_cast<ClassId>(i));
+    }
+  } else {
+    for (auto cid : *object.activeClassIds()) {
+      activeClassIds.push_back(static_cast<ClassId>(cid));
+    }
+  }
+  setActiveAllocationClassesLocked(activeClassIds);
 }
 
 MemoryPool::MemoryPool(PoolId id,
                        size_t poolSize,
                        SlabAllocator& alloc,
                        const std::set<uint32_t>& allocSizes)
-    : id_(id),
-      maxSize_{poolSize},
-      slabAllocator_(alloc),
-      acSizes_(allocSizes.begin(), allocSizes.end()),
-      ac_(createAllocationClasses()) {
+    : id_(id), maxSize_{poolSize}, slabAllocator_(alloc) {
+  createAllocationClasses(allocSizes);
   checkState();
 }
 
@@ -71,8 +106,6 @@ MemoryPool::MemoryPool(const serialization::MemoryPoolObject& object,
       currSlabAllocSize_(*object.currSlabAllocSize()),
       currAllocSize_(*object.currAllocSize()),
       slabAllocator_(alloc),
-      acSizes_(createMcSizesFromSerialized(object)),
-      ac_(createMcFromSerialized(object, getId(), alloc)),
       curSlabsAdvised_{static_cast<uint64_t>(*object.numSlabsAdvised())},
       nSlabResize_{static_cast<unsigned int>(*object.numSlabResize())},
       nSlabRebalance_{static_cast<unsigned int>(*object.numSlabRebalance())} {
@@ -81,6 +114,8 @@ MemoryPool::MemoryPool(const serialization::MemoryPoolObject& object,
         "Memory Pool can not be restored with this slab allocator");
   }
 
+  createMcFromSerialized(object);
+
   for (auto freeSlabIdx : *object.freeSlabIdxs()) {
     freeSlabs_.push_back(slabAllocator_.getSlabForIdx(freeSlabIdx));
   }
@@ -102,38 +137,34 @@ void MemoryPool::checkState() const {
                        currSlabAlloc));
   }
 
-  if (acSizes_.size() == 0 || ac_.size() == 0) {
+  const auto numClasses = getNumClassId();
+  const auto* active = activeClasses_.load(std::memory_order_acquire);
+  if (numClasses == 0 || active == nullptr || active->sizes.empty()) {
     throw std::invalid_argument("Empty alloc sizes");
   }
 
-  if (acSizes_.size() != ac_.size()) {
-    throw std::invalid_argument(folly::sformat(
-        "Allocation classes are not setup correctly. acSize.size = {}, but "
-        "ac.size() = {}",
-        acSizes_.size(), ac_.size()));
+  for (unsigned int i = 0; i < numClasses; i++) {
+    const auto& ac = ac_[i];
+    if (!ac || ac->getId() != static_cast<ClassId>(i) ||
+        ac->getAllocSize() < Slab::kMinAllocSize ||
+        ac->getAllocSize() > Slab::kSize) {
+      throw std::invalid_argument(folly::sformat(
+          "Allocation Class with id {} and size {} is not valid", i,
+          ac ? ac->getAllocSize() : 0));
+    }
   }
 
-  if (!std::is_sorted(acSizes_.begin(), acSizes_.end())) {
+  if (!std::is_sorted(active->sizes.begin(), active->sizes.end())) {
     throw std::invalid_argument("Allocation sizes are not sorted.");
   }
 
   const auto firstDuplicate =
-      std::adjacent_find(acSizes_.begin(), acSizes_.end());
-  if (firstDuplicate != acSizes_.end()) {
+      std::adjacent_find(active->sizes.begin(), active->sizes.end());
+  if (firstDuplicate != active->sizes.end()) {
     throw std::invalid_argument(
         folly::sformat("Duplicate allocation size: {}", *firstDuplicate));
   }
 
-  for (size_t i = 0; i < acSizes_.size(); i++) {
-    if (acSizes_[i] != ac_[i]->getAllocSize() ||
-        acSizes_[i] < Slab::kMinAllocSize || acSizes_[i] > Slab::kSize) {
-      throw std::invalid_argument(folly::sformat(
-          "Allocation Class with id {} and size {}, does not match the "
-          "allocation size we expect {}",
-          ac_[i]->getId(), ac_[i]->getAllocSize(), acSizes_[i]));
-    }
-  }
-
   for (const auto slab : freeSlabs_) {
     if (!slabAllocator_.isValidSlab(slab)) {
       throw std::invalid_argument(folly::sformat("Invalid free slab {}", slab));
@@ -141,24 +172,139 @@ void MemoryPool::checkState() const {
   }
 }
 
-MemoryPool::ACVector MemoryPool::createAllocationClasses() const {
-  ACVector ac;
+void MemoryPool::createAllocationClasses(
+    const std::set<uint32_t>& allocSizes) {
+  if (allocSizes.size() > kMaxClasses) {
+    throw std::invalid_argument(
+        folly::sformat("Too many allocation classes {}", allocSizes.size()));
+  }
+
+  std::vector<ClassId> classIds;
   ClassId id = 0;
-  for (const auto size : acSizes_) {
+  for (const auto size : allocSizes) {
     if (size < Slab::kMinAllocSize || size > Slab::kSize) {
       throw std::invalid_argument(
           folly::sformat("Invalid allocation class size {}", size));
     }
-    ac.emplace_back(new AllocationClass(id++, getId(), size, slabAllocator_));
+    ac_[id].reset(new AllocationClass(id, getId(), size, slabAllocator_));
+    classIds.push_back(id++);
+  }
+  numClasses_.store(static_cast<unsigned int>(id), std::memory_order_release);
+
+  if (!classIds.empty()) {
+    setActiveAllocationClassesLocked(classIds);
+  }
+}
+
+std::vector<uint32_t> MemoryPool::getAllocSizes() const {
+  std::vector<uint32_t> sizes;
+  const auto numClasses = getNumClassId();
+  for (unsigned int i = 0; i < numClasses; i++) {
+    sizes.push_back(ac_[i]->getAllocSize());
+  }
+  return sizes;
+}
+
+std::vector<uint32_t> MemoryPool::getActiveAllocSizes() const {
+  return readActiveClasses(
+      [](const ActiveClasses& active) { return active.sizes; });
+}
+
+bool MemoryPool::isActiveAllocationClass(ClassId cid) const noexcept {
+  if (cid < 0 || static_cast<unsigned int>(cid) >= getNumClassId()) {
+    return false;
+  }
+  return readActiveClasses(
+      [cid](const ActiveClasses& active) { return active.isActive[cid]; });
+}
+
+ClassId MemoryPool::addAllocationClass(uint32_t size) {
+  if (size < Slab::kMinAllocSize || size > Slab::kSize) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid allocation class size {}", size));
+  }
+
+  LockHolder l(lock_);
+  const auto numClasses = getNumClassId();
+  if (numClasses >= kMaxClasses) {
+    throw std::invalid_argument(folly::sformat(
+        "Pool {} has run out of allocation class ids", static_cast<int>(id_)));
+  }
+
+  const auto cid = static_cast<ClassId>(numClasses);
+  ac_[cid].reset(new AllocationClass(cid, getId(), size, slabAllocator_));
+  numClasses_.store(numClasses + 1, std::memory_order_release);
+  return cid;
+}
+
+void MemoryPool::setActiveAllocationClasses(
+    const std::vector<ClassId>& classIds) {
+  LockHolder l(lock_);
+  const auto numClasses = getNumClassId();
+  const auto maxSize =
+      activeClasses_.load(std::memory_order_acquire)->sizes.back();
+  const bool coversMaxSize =
+      std::any_of(classIds.begin(), classIds.end(), [&](ClassId cid) {
+        return cid >= 0 && static_cast<unsigned int>(cid) < numClasses &&
+               ac_[cid]->getAllocSize() >= maxSize;
+      });
+  if (!coversMaxSize) {
+    throw std::invalid_argument(folly::sformat(
+        "Active allocation classes must serve allocations of up to {} bytes",
+        maxSize));
+  }
+  setActiveAllocationClassesLocked(classIds);
+}
+
+void MemoryPool::setActiveAllocationClassesLocked(
+    const std::vector<ClassId>& classIds) {
+  if (classIds.empty()) {
+    throw std::invalid_argument("Empty alloc sizes");
+  }
+
+  auto active = std::make_unique<ActiveClasses>();
+  const auto numClasses = getNumClassId();
+  for (auto cid : classIds) {
+    if (cid < 0 || static_cast<unsigned int>(cid) >= numClasses) {
+      throw std::invalid_argument(folly::sformat("Invalid classId {}", cid));
+    }
+    if (active->isActive[cid]) {
+      throw std::invalid_argument(
+          folly::sformat("Duplicate classId {}", cid));
+    }
+    active->isActive[cid] = true;
+  }
+
+  auto sorted = classIds;
+  std::sort(sorted.begin(), sorted.end(), [this](ClassId a, ClassId b) {
+    return ac_[a]->getAllocSize() < ac_[b]->getAllocSize();
+  });
+  for (auto cid : sorted) {
+    const auto size = ac_[cid]->getAllocSize();
+    if (!active->sizes.empty() && active->sizes.back() == size) {
+      throw std::invalid_argument(
+          folly::sformat("Duplicate allocation size: {}", size));
+    }
+    active->sizes.push_back(size);
+    active->classIds.push_back(cid);
   }
-  XDCHECK(std::is_sorted(ac.begin(),
-                         ac.end(),
-                         [](const std::unique_ptr<AllocationClass>& a,
-                            const std::unique_ptr<AllocationClass>& b) {
-                           return a->getAllocSize() < b->getAllocSize();
-                         }));
 
-  return ac;
+  if (!initialActiveClasses_) {
+    activeClasses_.store(active.get(), std::memory_order_release);
+    initialActiveClasses_ = std::move(active);
+    return;
+  }
+
+  // readers that load the new set must also see the flag and read it in an
+  // RCU read side critical section
+  reconfigured_.store(true, std::memory_order_release);
+  activeClasses_.store(active.get(), std::memory_order_release);
+  auto* retired = activeClassesOwner_.release();
+  activeClassesOwner_ = std::move(active);
+  if (retired != nullptr) {
+    // readers may still be using the previous set
+    folly::rcu_retire(retired);
+  }
 }
 
 size_t MemoryPool::getCurrentUsedSize() const noexcept {
@@ -177,7 +323,7 @@ AllocationClass& MemoryPool::getAllocationClassFor(void* memory) const {
 }
 
 AllocationClass& MemoryPool::getAllocationClassFor(ClassId cid) const {
-  if (cid < static_cast<ClassId>(ac_.size())) {
+  if (cid >= 0 && static_cast<unsigned int>(cid) < getNumClassId()) {
     XDCHECK(ac_[cid] != nullptr);
     return *ac_[cid];
   }
@@ -189,20 +335,24 @@ const AllocationClass& MemoryPool::getAllocationClass(ClassId cid) const {
 }
 
 ClassId MemoryPool::getAllocationClassId(uint32_t size) const {
-  if (size > acSizes_.back() || size == 0) {
-    throw std::invalid_argument(
-        folly::sformat("Invalid size for alloc {} ", size));
-  }
+  // can operate without holding the mutex since a published set of active
+  // classes never changes and is not freed while we read it.
+  return readActiveClasses([size](const ActiveClasses& active) {
+    const auto& sizes = active.sizes;
+    if (size > sizes.back() || size == 0) {
+      throw std::invalid_argument(
+          folly::sformat("Invalid size for alloc {} ", size));
+    }
 
-  // can operate without holding the mutex since the vector does not change.
-  const auto it = std::lower_bound(acSizes_.begin(), acSizes_.end(), size);
+    const auto it = std::lower_bound(sizes.begin(), sizes.end(), size);
 
-  // we already checked for the bounds.
-  XDCHECK(it != acSizes_.end());
+    // we already checked for the bounds.
+    XDCHECK(it != sizes.end());
 
-  const auto idx = std::distance(acSizes_.begin(), it);
-  XDCHECK_LT(static_cast<size_t>(idx), ac_.size());
-  return static_cast<ClassId>(idx);
+    const auto idx = std::distance(sizes.begin(), it);
+    XDCHECK_LT(static_cast<size_t>(idx), active.classIds.size());
+    return active.classIds[idx];
+  });
 }
 
 ClassId MemoryPool::getAllocationClassId(const void* memory) const {
@@ -223,7 +373,7 @@ ClassId MemoryPool::getAllocationClassId(const void* memory) const {
   }
 
   const auto classId = header->classId;
-  if (classId >= static_cast<ClassId>(ac_.size()) || classId < 0) {
+  if (classId < 0 || static_cast<unsigned int>(classId) >= getNumClassId()) {
     // at this point, the slab indicates that it belongs to a bogus classId and
     // things are corrupt and the caller cant do anything about it. so throw an
     // exception to abort.
@@ -333,13 +483,17 @@ serialization::MemoryPoolObject MemoryPool::saveState() const {
     object.freeSlabIdxs()->push_back(slabAllocator_.slabIdx(slab));
   }
 
-  for (auto size : acSizes_) {
-    object.acSizes()->push_back(size);
+  const auto numClasses = getNumClassId();
+  for (unsigned int i = 0; i < numClasses; i++) {
+    object.acSizes()->push_back(ac_[i]->getAllocSize());
+    object.ac()->push_back(ac_[i]->saveState());
   }
 
-  for (const std::unique_ptr<AllocationClass>& allocClass : ac_) {
-    object.ac()->push_back(allocClass->saveState());
-  }
+  readActiveClasses([&object](const ActiveClasses& active) {
+    for (auto cid : active.classIds) {
+      object.activeClassIds()->push_back(cid);
+    }
+  });
 
   *object.numSlabResize() = nSlabResize_;
   *object.numSlabRebalance() = nSlabRebalance_;
@@ -379,7 +533,10 @@ void MemoryPool::releaseSlab(SlabReleaseMode mode,
     break;
 
   case SlabReleaseMode::kRebalance:
-    if (receiverClassId != Slab::kInvalidClassId) {
+    // classes that were retired by a reconfiguration only give up slabs. A
+    // slab meant for one goes back to the free list instead.
+    if (receiverClassId != Slab::kInvalidClassId &&
+        isActiveAllocationClass(receiverClassId)) {
       // Pool's current size does not change since this slab is
       // given to another allocation class within the same pool
       auto& receiverAC = getAllocationClassFor(receiverClassId);
@@ -510,7 +667,9 @@ MPStats MemoryPool::getStats() const {
   LockHolder l(lock_);
   std::unordered_map<ClassId, ACStats> acStats;
   std::set<ClassId> classIds;
-  for (const auto& ac : ac_) {
+  const auto numClasses = getNumClassId();
+  for (unsigned int i = 0; i < numClasses; i++) {
+    const auto& ac = ac_[i];
     acStats.insert({ac->getId(), ac->getStats()});
     classIds.insert(ac->getId());
   }
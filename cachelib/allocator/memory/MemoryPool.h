@@ -16,10 +16,12 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <vector>
 
 #include "cachelib/allocator/memory/AllocationClass.h"
@@ -49,6 +51,10 @@ class SlabAllocator;
 // of this memory pool from the slab allocator's perspective.
 class MemoryPool {
  public:
+  // max number of allocation classes a pool can have over its lifetime,
+  // including the ones retired by setActiveAllocationClasses.
+  static constexpr unsigned int kMaxClasses = 1 << 7;
+
   // creates a pool with the id and size.
   //
   // @param  id         the unique pool id.
@@ -95,10 +101,19 @@ class MemoryPool {
     return maxSize_ <= advisedSize ? 0 : maxSize_ - advisedSize;
   }
 
-  // returns the allocation class sizes as configured in this pool
-  const std::vector<uint32_t>& getAllocSizes() const noexcept {
-    return acSizes_;
-  }
+  // returns the allocation sizes of all the classes in this pool, indexed by
+  // their class id. Unless the pool has been reconfigured through
+  // setActiveAllocationClasses, these are the sorted sizes the pool was
+  // created with.
+  std::vector<uint32_t> getAllocSizes() const;
+
+  // returns the sorted allocation sizes that new allocations are served from.
+  std::vector<uint32_t> getActiveAllocSizes() const;
+
+  // returns true if new allocations can be served from the class. Classes
+  // that are not active only hold allocations made before the pool was
+  // reconfigured.
+  bool isActiveAllocationClass(ClassId cid) const noexcept;
 
   // returns true if the memory pools has more memory allocated than the
   // current size. This is possible because we allow resizing the pool
@@ -280,9 +295,32 @@ class MemoryPool {
   // allocation sizes that it was configured with. All allocations from this
   // pool will have ClassId from [0 .. numClassId - 1] (inclusive).
   unsigned int getNumClassId() const noexcept {
-    return static_cast<unsigned int>(acSizes_.size());
+    return numClasses_.load(std::memory_order_acquire);
   }
 
+  // adds an allocation class of the given size to this pool. The new class
+  // does not serve any allocations until it is made active through
+  // setActiveAllocationClasses.
+  //
+  // @param size  the allocation size of the class
+  // @return      the class id of the new allocation class
+  // @throw std::invalid_argument if the size is invalid or the pool has run
+  //        out of class ids.
+  ClassId addAllocationClass(uint32_t size);
+
+  // changes the set of allocation classes that new allocations are served
+  // from. Classes that are no longer active keep their slabs and
+  // allocations, but are not picked for new allocations and do not receive
+  // slabs from rebalancing. Their slabs can be released through
+  // startSlabRelease to move the memory over to the active classes.
+  //
+  // @param classIds  the classes to serve allocations from. Their sizes must
+  //                  be unique and the largest one must be at least as large
+  //                  as the largest active size, so that every size that
+  //                  could be allocated before still can be.
+  // @throw std::invalid_argument if the class ids are invalid.
+  void setActiveAllocationClasses(const std::vector<ClassId>& classIds);
+
   // Gets allocation class for a given class id and calls forEachAllocation on
   // that allocation class.
   //
@@ -309,8 +347,13 @@ class MemoryPool {
   void setNumSlabsAdvised(uint64_t value) { curSlabsAdvised_ = value; }
 
  private:
-  // container for storing a vector of AllocationClass.
-  using ACVector = std::vector<std::unique_ptr<AllocationClass>>;
+  // the allocation classes that serve new allocations, sorted by their
+  // allocation size.
+  struct ActiveClasses {
+    std::vector<uint32_t> sizes;
+    std::vector<ClassId> classIds;
+    std::array<bool, kMaxClasses> isActive{};
+  };
 
   // intended to be used by the constructor to verify the state of the memory
   // pool, specifically when we deserialize from a serialized state
@@ -322,7 +365,18 @@ class MemoryPool {
   Slab* getSlabLocked() noexcept;
 
   // create allocation classes corresponding to the pool's configuration.
-  ACVector createAllocationClasses() const;
+  void createAllocationClasses(const std::set<uint32_t>& allocSizes);
+
+  // calls @fn with the published set of active classes, keeping the set
+  // alive while @fn runs without holding lock_.
+  template <typename Fn>
+  auto readActiveClasses(Fn&& fn) const;
+
+  // builds the active classes from the class ids and publishes them to the
+  // readers. Caller must hold lock_ once the pool is constructed.
+  //
+  // @throw std::invalid_argument if the class ids are invalid.
+  void setActiveAllocationClassesLocked(const std::vector<ClassId>& classIds);
 
   // @return  AllocationClass corresponding to the memory, if it
   //          belongs to an AllocationClass
@@ -386,14 +440,29 @@ class MemoryPool {
   // not currently in use.
   std::vector<Slab*> freeSlabs_;
 
-  // sorted vector of allocation class sizes
-  const std::vector<uint32_t> acSizes_;
+  // allocation classes for this pool, indexed by their class id. Classes are
+  // only ever appended and an entry does not change once it is populated, so
+  // entries below numClasses_ can be accessed without grabbing the mutex.
+  std::array<std::unique_ptr<AllocationClass>, kMaxClasses> ac_;
+  std::atomic<unsigned int> numClasses_{0};
+
+  // the classes serving new allocations. Replaced as a whole on
+  // reconfiguration, so readers never see a partially updated set. Readers
+  // not holding lock_ go through readActiveClasses().
+  std::atomic<const ActiveClasses*> activeClasses_{nullptr};
 
-  // vector of allocation classes for this pool, sorted by their allocation
-  // sizes and indexed by their class id. This vector does not change once it
-  // is initialized inside the constructor. so this can be accessed without
-  // grabbing the mutex.
-  const ACVector ac_;
+  // set once the classes are reconfigured. Until then readers use the
+  // initial set without entering an RCU read side critical section.
+  std::atomic<bool> reconfigured_{false};
+
+  // the set published at construction. Never freed, since readers do not
+  // protect it.
+  std::unique_ptr<const ActiveClasses> initialActiveClasses_;
+
+  // owns the set published in activeClasses_ after a reconfiguration. A
+  // replaced set is retired through RCU and freed once no reader can still
+  // be using it. Guarded by lock_.
+  std::unique_ptr<const ActiveClasses> activeClassesOwner_;
 
   // Current configuration of advised away Slabs in the pool
   std::atomic<uint64_t> curSlabsAdvised_{0};
@@ -403,13 +472,8 @@ class MemoryPool {
   std::atomic<unsigned int> nSlabRebalance_{0};
   std::atomic<unsigned int> nSlabReleaseAborted_{0};
 
-  static std::vector<uint32_t> createMcSizesFromSerialized(
-      const serialization::MemoryPoolObject& object);
-
-  static ACVector createMcFromSerialized(
-      const serialization::MemoryPoolObject& object,
-      PoolId poolId,
-      SlabAllocator& alloc);
+  // restores the allocation classes and the active classes.
+  void createMcFromSerialized(const serialization::MemoryPoolObject& object);
 
   // Allow access to private members by unit tests
   friend class facebook::cachelib::tests::AllocTestBase;
@@ -49,6 +49,9 @@ constexpr uint64_t SlabAllocator::kAddressMask;
 constexpr PtrType CompressedPtr::kAllocIdxMask;
 constexpr unsigned int CompressedPtr::kNumAllocIdxBits;
 constexpr unsigned int CompressedPtr::kNumSlabIdxBits;
+constexpr unsigned int CompressedPtr::kNumTierIdxBits;
+constexpr unsigned int CompressedPtr::kNumTierIdxOffset;
+constexpr PtrType CompressedPtr::kTierIdxMask;
 
 constexpr unsigned int SlabAllocator::kLockSleepMS;
 constexpr size_t SlabAllocator::kPagesPerStep;
@@ -225,7 +225,12 @@ class SlabAllocator {
   // the corresponding memory allocator. trying to inline this just increases
   // the code size and does not move the needle on the benchmarks much.
   // Calling this with invalid input in optimized build is undefined behavior.
-  CompressedPtr CACHELIB_INLINE compress(const void* ptr) const {
+  //
+  // @param isMultiTiered  true if the cache has more than one memory tier. The
+  //                       tier id bit is left clear and filled in by the
+  //                       caller.
+  CompressedPtr CACHELIB_INLINE compress(const void* ptr,
+                                         bool isMultiTiered) const {
     if (ptr == nullptr) {
       return CompressedPtr{};
     }
@@ -246,18 +251,19 @@ class SlabAllocator {
         static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(ptr) -
                               reinterpret_cast<const uint8_t*>(slab)) /
         allocSize;
-    return CompressedPtr{slabIndex, allocIdx};
+    return CompressedPtr{slabIndex, allocIdx, isMultiTiered};
   }
 
   // uncompress the point and return the raw ptr.  This function never throws
   // in optimized build and assumes that the caller is responsible for calling
   // it with a valid compressed pointer.
-  void* CACHELIB_INLINE unCompress(const CompressedPtr ptr) const {
+  void* CACHELIB_INLINE unCompress(const CompressedPtr ptr,
+                                   bool isMultiTiered) const {
     if (ptr.isNull()) {
       return nullptr;
     }
 
-    const SlabIdx slabIndex = ptr.getSlabIdx();
+    const SlabIdx slabIndex = ptr.getSlabIdx(isMultiTiered);
     const uint32_t allocIdx = ptr.getAllocIdx();
     const Slab* slab = &slabMemoryStart_[slabIndex];
 
@@ -311,9 +317,17 @@ class SlabAllocator {
     return &slabMemoryStart_[idx];
   }
 
+  // true if the memory belongs to the slab memory of this allocator,
+  // irrespective of whether the slab is currently allocated.
+  bool isMemoryInAllocator(const void* memory) const noexcept {
+    const auto* slab = getSlabForMemory(memory);
+    return slab >= slabMemoryStart_ && slab < getSlabMemoryEnd();
+  }
+
   template <typename PtrType>
-  PtrCompressor<PtrType, SlabAllocator> createPtrCompressor() const {
-    return PtrCompressor<PtrType, SlabAllocator>(*this);
+  SingleTierPtrCompressor<PtrType, SlabAllocator> createSingleTierPtrCompressor()
+      const {
+    return SingleTierPtrCompressor<PtrType, SlabAllocator>(*this);
   }
 
  private:
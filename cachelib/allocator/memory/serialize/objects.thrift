@@ -55,6 +55,8 @@ struct MemoryPoolObject {
   9: i64 numSlabRebalance = 0;
   10: required list<i32> freeSlabIdxs;
   11: i64 numSlabsAdvised = 0;
+  // classes serving new allocations. Empty means all of them.
+  12: list<byte> activeClassIds;
 }
 
 struct MemoryPoolManagerObject {
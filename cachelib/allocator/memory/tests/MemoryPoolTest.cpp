@@ -944,3 +944,106 @@ TEST_F(MemoryPoolTest, AllocReleaseMT) {
   ASSERT_TRUE(mp.allSlabsAllocated());
   ASSERT_FALSE(mp.overLimit());
 }
+
+TEST_F(MemoryPoolTest, ReconfigureAllocationClasses) {
+  auto slabAlloc = createSlabAllocator(20);
+  auto usable = slabAlloc->getNumUsableSlabs();
+  size_t poolSize = usable * Slab::kSize;
+
+  PoolId poolId = 5;
+  std::set<uint32_t> allocSizes = {128, 256, 1024};
+  MemoryPool mp(poolId, poolSize, *slabAlloc, allocSizes);
+  ASSERT_EQ(3, mp.getNumClassId());
+
+  std::vector<void*> allocs;
+  for (int i = 0; i < 10; i++) {
+    allocs.push_back(mp.allocate(200));
+    ASSERT_EQ(1, mp.getAllocationClassId(allocs.back()));
+  }
+
+  // the new class is not used until it is active.
+  const auto newCid = mp.addAllocationClass(512);
+  ASSERT_EQ(3, newCid);
+  ASSERT_EQ(4, mp.getNumClassId());
+  ASSERT_FALSE(mp.isActiveAllocationClass(newCid));
+  ASSERT_EQ(1, mp.getAllocationClassId(200));
+
+  // the largest size must remain allocatable and sizes must be unique.
+  ASSERT_THROW(mp.setActiveAllocationClasses({0, newCid}),
+               std::invalid_argument);
+  const auto dupCid = mp.addAllocationClass(1024);
+  ASSERT_THROW(mp.setActiveAllocationClasses({0, 2, dupCid}),
+               std::invalid_argument);
+
+  mp.setActiveAllocationClasses({0, newCid, 2});
+  ASSERT_TRUE(mp.isActiveAllocationClass(newCid));
+  ASSERT_FALSE(mp.isActiveAllocationClass(1));
+  ASSERT_EQ(std::vector<uint32_t>({128, 512, 1024}), mp.getActiveAllocSizes());
+  ASSERT_EQ(std::vector<uint32_t>({128, 256, 1024, 512, 1024}),
+            mp.getAllocSizes());
+
+  auto alloc = mp.allocate(200);
+  ASSERT_NE(nullptr, alloc);
+  ASSERT_EQ(newCid, mp.getAllocationClassId(alloc));
+  ASSERT_EQ(512, slabAlloc->getSlabHeader(alloc)->allocSize);
+  mp.free(alloc);
+
+  // allocations in the retired class can still be freed, and a slab released
+  // towards the retired class goes to the free slabs instead.
+  const auto slabsBefore = mp.getStats().freeSlabs;
+  auto context = mp.startSlabRelease(1, 1, SlabReleaseMode::kRebalance,
+                                     allocs.back(), false);
+  for (auto a : allocs) {
+    mp.free(a);
+  }
+  mp.completeSlabRelease(context);
+  ASSERT_EQ(slabsBefore + 1, mp.getStats().freeSlabs);
+  ASSERT_EQ(0, mp.getAllocationClass(1).getNumSlabs());
+
+  // the reconfiguration survives serialization.
+  uint8_t buffer[SerializationBufferSize];
+  uint8_t* begin = buffer;
+  uint8_t* end = buffer + SerializationBufferSize;
+  Serializer serializer(begin, end);
+  serializer.serialize(mp.saveState());
+  Deserializer deserializer(begin, end);
+  MemoryPool mp2(deserializer.deserialize<serialization::MemoryPoolObject>(),
+                 *slabAlloc);
+  ASSERT_TRUE(isSameMemoryPool(mp, mp2));
+  ASSERT_FALSE(mp2.isActiveAllocationClass(1));
+  ASSERT_EQ(newCid, mp2.getAllocationClassId(200));
+}
+
+TEST_F(MemoryPoolTest, ReconfigureAllocationClassesConcurrently) {
+  auto slabAlloc = createSlabAllocator(20);
+  size_t poolSize = slabAlloc->getNumUsableSlabs() * Slab::kSize;
+  MemoryPool mp(0, poolSize, *slabAlloc, {128, 256, 1024});
+  const auto newCid = mp.addAllocationClass(512);
+
+  // readers keep looking up classes while the active set flips back and
+  // forth. Every replaced set is reclaimed once the readers are done with it.
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        const auto cid = mp.getAllocationClassId(200);
+        ASSERT_TRUE(cid == 1 || cid == newCid);
+        ASSERT_EQ(3, mp.getActiveAllocSizes().size());
+        mp.isActiveAllocationClass(newCid);
+      }
+    });
+  }
+  for (int i = 0; i < 10000; i++) {
+    if (i % 2 == 0) {
+      mp.setActiveAllocationClasses({0, newCid, 2});
+    } else {
+      mp.setActiveAllocationClasses({0, 1, 2});
+    }
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(1, mp.getAllocationClassId(200));
+}
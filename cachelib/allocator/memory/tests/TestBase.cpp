@@ -69,12 +69,15 @@ bool AllocTestBase::isSameMemoryPool(const MemoryPool& mp1,
       mp1.currAllocSize_ != mp2.currAllocSize_ ||
       !isSameSlabList(mp1.freeSlabs_, mp1.slabAllocator_, mp2.freeSlabs_,
                       mp2.slabAllocator_) ||
-      mp1.acSizes_ != mp2.acSizes_) {
+      mp1.getAllocSizes() != mp2.getAllocSizes() ||
+      mp1.getActiveAllocSizes() != mp2.getActiveAllocSizes()) {
     return false;
   }
 
-  if (mp1.ac_.size() != mp2.ac_.size() ||
-      !std::equal(mp1.ac_.begin(), mp1.ac_.end(), mp2.ac_.begin(),
+  const auto numClasses = mp1.getNumClassId();
+  if (numClasses != mp2.getNumClassId() ||
+      !std::equal(mp1.ac_.begin(), mp1.ac_.begin() + numClasses,
+                  mp2.ac_.begin(),
                   [](const std::unique_ptr<AllocationClass>& ac1,
                      const std::unique_ptr<AllocationClass>& ac2) {
                     return isSameAllocationClass(*ac1, *ac2);
@@ -67,6 +67,8 @@ class CacheAPIWrapperForNvm {
   // @param creationTime    Timestamp when this item was created
   // @param expiryTime      set an expiry timestamp for the item
   //                        (0 means no expiration time).
+  // @param evict           if false, fail rather than evict when there is no
+  //                        free memory.
   // @return      the handle for the item or an invalid handle(nullptr) if the
   //              allocation failed. Allocation can fail if one such
   //              allocation already exists or if we are out of memory and
@@ -80,8 +82,10 @@ class CacheAPIWrapperForNvm {
                                       Key key,
                                       uint32_t size,
                                       uint32_t creationTime,
-                                      uint32_t expiryTime) {
-    return cache.allocateInternal(id, key, size, creationTime, expiryTime);
+                                      uint32_t expiryTime,
+                                      bool evict = true) {
+    return cache.allocateInternal(
+        id, key, size, creationTime, expiryTime, evict);
   }
 
   // Insert the allocated handle into the AccessContainer from nvmcache, making
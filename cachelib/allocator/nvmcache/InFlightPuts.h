@@ -16,14 +16,16 @@
 
 #pragma once
 
-#include <folly/Hash.h>
 #include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/lang/Align.h>
 #include <folly/logging/xlog.h>
 
+#include <array>
+#include <atomic>
 #include <mutex>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace facebook {
 namespace cachelib {
@@ -32,41 +34,60 @@ namespace cachelib {
 // invalidated and can be used to execute some function if not invalidated. The
 // user guarantees that the lifetime of the token is within the lifetime of the
 // string piece with which they obtain the token.
+//
+// Puts are tracked in a few inline slots, matched by a 64-bit hash of the key
+// and then by the key itself, so acquiring and releasing a token does not
+// allocate unless more than kInlineSlots puts are in flight at once.
 class alignas(folly::hardware_destructive_interference_size) InFlightPuts {
-  using LockGuard = std::lock_guard<std::mutex>;
   using UniqueLock = std::unique_lock<std::mutex>;
 
  public:
   class PutToken;
+
+  // number of puts tracked without allocating
+  static constexpr size_t kInlineSlots = 4;
   // inserts an in-flight put into the map if none exists and acquires a
   // token. Caller can check if the token is valid to determine if they can
   // use it to complete the operation.
   PutToken tryAcquireToken(folly::StringPiece key) {
     UniqueLock l(mutex_, std::try_to_lock);
     if (!l.owns_lock()) {
+      numLockContended_.fetch_add(1, std::memory_order_relaxed);
       return PutToken{};
     }
 
-    auto ret = keys_.emplace(key, true);
+    const auto hash = hashKey(key);
     // record for same key being inflight written to nvmcache should be rare.
     // In that case, fail the latter one.
-    if (ret.second) {
-      return PutToken{key, *this};
+    if (findSlot(key, hash) != nullptr) {
+      return PutToken{};
     }
-    return PutToken{};
+    addSlot(key, hash);
+    return PutToken{key, *this};
   }
 
   // marks the token as invalidated. This will ensure that we dont execute any
   // function on this token and simply remove the token when the token gets
   // destroyed.
   void invalidateToken(folly::StringPiece key) {
-    LockGuard l(mutex_);
-    auto it = keys_.find(key);
-    if (it != keys_.end()) {
-      it->second = false;
+    const auto hash = hashKey(key);
+    auto l = lock();
+    if (auto* slot = findSlot(key, hash)) {
+      slot->valid = false;
     }
   }
 
+  // @return number of times a caller found the lock held by someone else,
+  //         including puts that were skipped because of it.
+  uint64_t getNumLockContended() const noexcept {
+    return numLockContended_.load(std::memory_order_relaxed);
+  }
+
+  // @return number of puts that did not fit in the inline slots
+  uint64_t getNumOverflows() const noexcept {
+    return numOverflows_.load(std::memory_order_relaxed);
+  }
+
   // Represents an insertion into the inflight map. this token can be used to
   // execute some action if the token was not invalidated in the mean time.
   class PutToken {
@@ -140,12 +161,13 @@ class alignas(folly::hardware_destructive_interference_size) InFlightPuts {
   //  @throw    if fn throws, token is preserved.
   template <typename F>
   bool executeIfValid(folly::StringPiece key, F&& fn) {
-    LockGuard l(mutex_);
-    auto it = keys_.find(key);
-    const bool valid = it != keys_.end() && it->second;
+    const auto hash = hashKey(key);
+    auto l = lock();
+    auto* slot = findSlot(key, hash);
+    const bool valid = slot != nullptr && slot->valid;
     if (valid) {
       fn();
-      keys_.erase(it);
+      freeSlot(slot);
       return true;
     }
     return false;
@@ -153,16 +175,85 @@ class alignas(folly::hardware_destructive_interference_size) InFlightPuts {
 
   // erases the record from inflight map.
   void removeToken(folly::StringPiece key) {
-    LockGuard l(mutex_);
-    auto res = keys_.erase(key);
-    XDCHECK_EQ(res, 1u);
+    const auto hash = hashKey(key);
+    auto l = lock();
+    auto* slot = findSlot(key, hash);
+    XDCHECK(slot != nullptr);
+    if (slot != nullptr) {
+      freeSlot(slot);
+    }
+  }
+
+  // an in-flight put and its validity. An empty key means the slot is free.
+  struct Slot {
+    uint64_t hash{0};
+    folly::StringPiece key{};
+    bool valid{false};
+  };
+
+  static uint64_t hashKey(folly::StringPiece key) noexcept {
+    return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+  }
+
+  // acquire the lock, counting the times it was held by someone else
+  UniqueLock lock() {
+    UniqueLock l(mutex_, std::try_to_lock);
+    if (!l.owns_lock()) {
+      numLockContended_.fetch_add(1, std::memory_order_relaxed);
+      l.lock();
+    }
+    return l;
   }
 
-  // map storing the presence of a token  and its validity
-  std::unordered_map<folly::StringPiece, bool, folly::Hash> keys_;
+  // @return the slot of the key, nullptr if there is none. The hash is
+  //         compared first and the key only when the hashes match.
+  Slot* findSlot(folly::StringPiece key, uint64_t hash) {
+    for (auto& slot : slots_) {
+      if (slot.hash == hash && !slot.key.empty() && slot.key == key) {
+        return &slot;
+      }
+    }
+    for (auto& slot : overflow_) {
+      if (slot.hash == hash && slot.key == key) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
 
-  // mutex protecting the map.
+  void addSlot(folly::StringPiece key, uint64_t hash) {
+    for (auto& slot : slots_) {
+      if (slot.key.empty()) {
+        slot = Slot{hash, key, true};
+        return;
+      }
+    }
+    // the overflow keeps its capacity, so this allocates only when the
+    // shard sees more puts in flight than it ever had before.
+    numOverflows_.fetch_add(1, std::memory_order_relaxed);
+    overflow_.push_back(Slot{hash, key, true});
+  }
+
+  void freeSlot(Slot* slot) {
+    const bool inOverflow = slot >= overflow_.data() &&
+                            slot < overflow_.data() + overflow_.size();
+    if (inOverflow) {
+      *slot = overflow_.back();
+      overflow_.pop_back();
+    } else {
+      *slot = Slot{};
+    }
+  }
+
+  // state of the in-flight puts
+  std::array<Slot, kInlineSlots> slots_{};
+  std::vector<Slot> overflow_;
+
+  // mutex protecting the slots.
   std::mutex mutex_;
+
+  std::atomic<uint64_t> numLockContended_{0};
+  std::atomic<uint64_t> numOverflows_{0};
 };
 
 } // namespace cachelib
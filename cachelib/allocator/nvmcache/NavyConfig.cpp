@@ -136,6 +136,26 @@ BigHashConfig& BigHashConfig::setSizePctAndMaxItemSize(
   return *this;
 }
 
+BigHashConfig& BigHashConfig::enableAdaptiveSmallItemMaxSize(
+    uint64_t minSmallItemMaxSize,
+    uint64_t maxSmallItemMaxSize,
+    uint64_t windowSize) {
+  if (minSmallItemMaxSize == 0 || minSmallItemMaxSize > maxSmallItemMaxSize) {
+    throw std::invalid_argument(folly::sformat(
+        "invalid BigHash small item max size bounds: [{}, {}]",
+        minSmallItemMaxSize,
+        maxSmallItemMaxSize));
+  }
+  if (windowSize == 0) {
+    throw std::invalid_argument(
+        "BigHash adaptive small item max size window should be non-zero");
+  }
+  minSmallItemMaxSize_ = minSmallItemMaxSize;
+  maxSmallItemMaxSize_ = maxSmallItemMaxSize;
+  adaptiveWindowSize_ = windowSize;
+  return *this;
+}
+
 // job scheduler settings
 void NavyConfig::setNavyReqOrderingShards(uint64_t navyReqOrderingShards) {
   if (navyReqOrderingShards == 0) {
@@ -145,6 +165,29 @@ void NavyConfig::setNavyReqOrderingShards(uint64_t navyReqOrderingShards) {
   navyReqOrderingShards_ = navyReqOrderingShards;
 }
 
+void NavyConfig::enableCheckpoints(std::chrono::seconds interval,
+                                   uint64_t logSize) {
+  if (interval.count() <= 0 || logSize == 0) {
+    throw std::invalid_argument(
+        folly::sformat("invalid checkpoint interval {}s or log size {}",
+                       interval.count(),
+                       logSize));
+  }
+  checkpointInterval_ = interval;
+  checkpointLogSize_ = logSize;
+}
+
+void NavyConfig::enableNegativeFilter(uint64_t sizeMB, uint32_t numHashes) {
+  if (sizeMB == 0 || numHashes == 0 || numHashes > 9) {
+    throw std::invalid_argument(
+        folly::sformat("invalid negative filter size {}MB or {} hashes",
+                       sizeMB,
+                       numHashes));
+  }
+  negativeFilterSizeMB_ = sizeMB;
+  negativeFilterNumHashes_ = numHashes;
+}
+
 std::map<std::string, std::string> EnginesConfig::serialize() const {
   auto configMap = std::map<std::string, std::string>();
 
@@ -167,6 +210,12 @@ std::map<std::string, std::string> EnginesConfig::serialize() const {
       blockCache().getDataChecksum() ? "true" : "false";
   configMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       folly::join(",", blockCache().getSFifoSegmentRatio());
+  configMap["navyConfig::blockCacheReadMerging"] =
+      blockCache().isReadMergingEnabled() ? "true" : "false";
+  configMap["navyConfig::blockCacheReadMergeWindowUs"] =
+      folly::to<std::string>(blockCache().getReadMergeWindow().count());
+  configMap["navyConfig::blockCacheReadaheadSize"] =
+      folly::to<std::string>(blockCache().getReadaheadSize());
 
   // BigHash settings
   configMap["navyConfig::bigHashSizePct"] =
@@ -177,6 +226,12 @@ std::map<std::string, std::string> EnginesConfig::serialize() const {
       folly::to<std::string>(bigHash().getBucketBfSize());
   configMap["navyConfig::bigHashSmallItemMaxSize"] =
       folly::to<std::string>(bigHash().getSmallItemMaxSize());
+  configMap["navyConfig::bigHashMinSmallItemMaxSize"] =
+      folly::to<std::string>(bigHash().getMinSmallItemMaxSize());
+  configMap["navyConfig::bigHashMaxSmallItemMaxSize"] =
+      folly::to<std::string>(bigHash().getMaxSmallItemMaxSize());
+  configMap["navyConfig::bigHashAdaptiveWindowSize"] =
+      folly::to<std::string>(bigHash().getAdaptiveWindowSize());
   return configMap;
 }
 
@@ -224,6 +279,14 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
       folly::to<std::string>(maxConcurrentInserts_);
   configMap["navyConfig::maxParcelMemoryMB"] =
       folly::to<std::string>(maxParcelMemoryMB_);
+  configMap["navyConfig::checkpointIntervalSec"] =
+      folly::to<std::string>(checkpointInterval_.count());
+  configMap["navyConfig::checkpointLogSize"] =
+      folly::to<std::string>(checkpointLogSize_);
+  configMap["navyConfig::negativeFilterSizeMB"] =
+      folly::to<std::string>(negativeFilterSizeMB_);
+  configMap["navyConfig::negativeFilterNumHashes"] =
+      folly::to<std::string>(negativeFilterNumHashes_);
 
   if (enginesConfigs_.size() > 1) {
     for (size_t idx = 0; idx < enginesConfigs_.size(); idx++) {
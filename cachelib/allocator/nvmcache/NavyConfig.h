@@ -19,6 +19,7 @@
 #include <folly/dynamic.h>
 #include <folly/logging/xlog.h>
 
+#include <chrono>
 #include <stdexcept>
 
 #include "cachelib/allocator/nvmcache/BlockCacheReinsertionPolicy.h"
@@ -239,6 +240,7 @@ class BlockCacheReinsertionConfig {
  * - set size classes
  * - set region size
  * - set data checksum
+ * - enable read merging and readahead
  * - get the values of all the above parameters
  */
 class BlockCacheConfig {
@@ -310,6 +312,18 @@ class BlockCacheConfig {
     return *this;
   }
 
+  // Enable sharing device reads among concurrent lookups of adjacent or
+  // overlapping entries. A read waits up to @mergeWindow for other reads to
+  // merge with. Reads smaller than @readaheadSize are extended to it within
+  // the region, so that entries written in sequence are read together.
+  BlockCacheConfig& enableReadMerging(std::chrono::microseconds mergeWindow,
+                                      uint32_t readaheadSize = 0) noexcept {
+    readMerging_ = true;
+    readMergeWindow_ = mergeWindow;
+    readaheadSize_ = readaheadSize;
+    return *this;
+  }
+
   bool isLruEnabled() const { return lru_; }
 
   const std::vector<unsigned int>& getSFifoSegmentRatio() const {
@@ -332,6 +346,14 @@ class BlockCacheConfig {
 
   bool isPreciseRemove() const { return preciseRemove_; }
 
+  bool isReadMergingEnabled() const { return readMerging_; }
+
+  std::chrono::microseconds getReadMergeWindow() const {
+    return readMergeWindow_;
+  }
+
+  uint32_t getReadaheadSize() const { return readaheadSize_; }
+
  private:
   // Whether Navy BlockCache will use region-based LRU eviction policy.
   bool lru_{true};
@@ -353,6 +375,12 @@ class BlockCacheConfig {
   // (false).
   bool preciseRemove_{false};
 
+  // Whether device reads are merged, how long a read waits for reads to merge
+  // with and the size small reads are extended to.
+  bool readMerging_{false};
+  std::chrono::microseconds readMergeWindow_{0};
+  uint32_t readaheadSize_{0};
+
   // Intended size of the block cache.
   // If 0, this block cache takes all the space left on the device.
   uint64_t size_{0};
@@ -395,8 +423,22 @@ class BigHashConfig {
     return *this;
   }
 
+  // Let Navy learn the max item size of BigHash from the workload instead of
+  // using a fixed one. The max item size set by setSizePctAndMaxItemSize is
+  // where it starts. It is recomputed every @windowSize inserts and stays
+  // within [minSmallItemMaxSize, maxSmallItemMaxSize]. Items on the wrong
+  // side of a changed max item size move engines when they are looked up.
+  // @throw std::invalid_argument if the bounds are empty or windowSize is 0.
+  BigHashConfig& enableAdaptiveSmallItemMaxSize(uint64_t minSmallItemMaxSize,
+                                                uint64_t maxSmallItemMaxSize,
+                                                uint64_t windowSize);
+
   bool isBloomFilterEnabled() const { return bucketBfSize_ > 0; }
 
+  bool isAdaptiveSmallItemMaxSizeEnabled() const {
+    return adaptiveWindowSize_ > 0;
+  }
+
   unsigned int getSizePct() const { return sizePct_; }
 
   uint32_t getBucketSize() const { return bucketSize_; }
@@ -405,6 +447,12 @@ class BigHashConfig {
 
   uint64_t getSmallItemMaxSize() const { return smallItemMaxSize_; }
 
+  uint64_t getMinSmallItemMaxSize() const { return minSmallItemMaxSize_; }
+
+  uint64_t getMaxSmallItemMaxSize() const { return maxSmallItemMaxSize_; }
+
+  uint64_t getAdaptiveWindowSize() const { return adaptiveWindowSize_; }
+
  private:
   // Percentage of how much of the device out of all is given to BigHash
   // engine in Navy, e.g. 50.
@@ -418,6 +466,11 @@ class BigHashConfig {
   uint64_t bucketBfSize_{8};
   // The maximum item size to put into Navy BigHash engine.
   uint64_t smallItemMaxSize_{};
+  // Bounds of the learned maximum item size of BigHash and the number of
+  // inserts between updates. 0 window size means it is not learned.
+  uint64_t minSmallItemMaxSize_{};
+  uint64_t maxSmallItemMaxSize_{};
+  uint64_t adaptiveWindowSize_{0};
 };
 
 // Config for a pair of small,large engines.
@@ -457,6 +510,7 @@ class NavyConfig {
 
   static constexpr folly::StringPiece kAdmPolicyRandom{"random"};
   static constexpr folly::StringPiece kAdmPolicyDynamicRandom{"dynamic_random"};
+  static constexpr uint64_t kDefaultCheckpointLogSize{64 * 1024 * 1024};
 
   bool usesSimpleFile() const noexcept { return !fileName_.empty(); }
   bool usesRaidFiles() const noexcept { return raidPaths_.size() > 0; }
@@ -506,6 +560,14 @@ class NavyConfig {
   // ============ other settings =============
   uint32_t getMaxConcurrentInserts() const { return maxConcurrentInserts_; }
   uint64_t getMaxParcelMemoryMB() const { return maxParcelMemoryMB_; }
+  std::chrono::seconds getCheckpointInterval() const {
+    return checkpointInterval_;
+  }
+  uint64_t getCheckpointLogSize() const { return checkpointLogSize_; }
+  uint64_t getNegativeFilterSizeMB() const { return negativeFilterSizeMB_; }
+  uint32_t getNegativeFilterNumHashes() const {
+    return negativeFilterNumHashes_;
+  }
 
   // Setters:
   // Enable "dynamic_random" admission policy.
@@ -576,6 +638,19 @@ class NavyConfig {
   void setMaxParcelMemoryMB(uint64_t maxParcelMemoryMB) noexcept {
     maxParcelMemoryMB_ = maxParcelMemoryMB;
   }
+  // Checkpoint the Navy state into the metadata every @interval while the
+  // cache is running, and log the changes made after each checkpoint into
+  // @logSize bytes, so that the cache is recovered after an unclean
+  // shutdown. The metadata is grown to hold two checkpoints and the log.
+  // @throw std::invalid_argument if any of the values is 0.
+  void enableCheckpoints(std::chrono::seconds interval,
+                         uint64_t logSize = kDefaultCheckpointLogSize);
+  // Answer lookups of keys that are in neither engine from a @sizeMB filter
+  // in memory that sets @numHashes counters per key. Takes about 4 bytes per
+  // item for a false positive rate of a few percent.
+  // @throw std::invalid_argument if @sizeMB is 0 or @numHashes is not in
+  //        [1, 9].
+  void enableNegativeFilter(uint64_t sizeMB, uint32_t numHashes = 4);
 
   const std::vector<EnginesConfig>& enginesConfigs() const {
     return enginesConfigs_;
@@ -633,6 +708,15 @@ class NavyConfig {
   // Once this is reached, requests will be rejected until the parcel
   // memory usage gets under the limit.
   uint64_t maxParcelMemoryMB_{256};
+  // How often the Navy state is checkpointed. 0 means checkpoints are
+  // disabled and the state is only persisted on a clean shutdown.
+  std::chrono::seconds checkpointInterval_{0};
+  // Size of the log of the changes made after a checkpoint.
+  uint64_t checkpointLogSize_{0};
+  // Size of the negative filter in front of the engines. 0 means the filter
+  // is disabled.
+  uint64_t negativeFilterSizeMB_{0};
+  uint32_t negativeFilterNumHashes_{4};
 };
 } // namespace navy
 } // namespace cachelib
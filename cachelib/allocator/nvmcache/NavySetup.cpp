@@ -104,6 +104,11 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
   }
 
   proto.setBigHash(std::move(bigHash), bigHashConfig.getSmallItemMaxSize());
+  if (bigHashConfig.isAdaptiveSmallItemMaxSizeEnabled()) {
+    proto.setAdaptiveSizeSplit(bigHashConfig.getMinSmallItemMaxSize(),
+                               bigHashConfig.getMaxSmallItemMaxSize(),
+                               bigHashConfig.getAdaptiveWindowSize());
+  }
 
   if (bigHashCacheOffset <= bigHashStartOffsetLimit) {
     throw std::invalid_argument("NVM cache size is not big enough!");
@@ -174,6 +179,10 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
   blockCache->setNumInMemBuffers(blockCacheConfig.getNumInMemBuffers());
   blockCache->setItemDestructorEnabled(itemDestructorEnabled);
   blockCache->setPreciseRemove(blockCacheConfig.isPreciseRemove());
+  if (blockCacheConfig.isReadMergingEnabled()) {
+    blockCache->setReadMerging(blockCacheConfig.getReadMergeWindow(),
+                               blockCacheConfig.getReadaheadSize());
+  }
 
   proto.setBlockCache(std::move(blockCache));
   return blockCacheOffset + blockCacheSize;
@@ -218,6 +227,13 @@ void setupCacheProtos(const navy::NavyConfig& config,
   if (metadataSize == 0) {
     metadataSize = getDefaultMetadataSize(totalCacheSize, ioAlignSize);
   }
+  const uint64_t checkpointLogSize =
+      alignUp(config.getCheckpointLogSize(), ioAlignSize);
+  if (checkpointLogSize > 0) {
+    // Room for the checkpoint being written next to the last one, and for
+    // the log
+    metadataSize = 2 * alignUp(metadataSize, ioAlignSize) + checkpointLogSize;
+  }
   metadataSize = alignUp(metadataSize, ioAlignSize);
   if (metadataSize >= totalCacheSize) {
     throw std::invalid_argument{
@@ -226,6 +242,13 @@ void setupCacheProtos(const navy::NavyConfig& config,
                        totalCacheSize)};
   }
   proto.setMetadataSize(metadataSize);
+  if (checkpointLogSize > 0) {
+    proto.setCheckpoints(checkpointLogSize, config.getCheckpointInterval());
+  }
+  if (config.getNegativeFilterSizeMB() > 0) {
+    proto.setNegativeFilter(config.getNegativeFilterSizeMB() * 1024 * 1024,
+                            config.getNegativeFilterNumHashes());
+  }
 
   // Start offsets are inclusive. End offsets are exclusive.
   // For each engine pair, bigHashStartOffset will be calculated by setting up
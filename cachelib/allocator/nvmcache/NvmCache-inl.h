@@ -27,6 +27,10 @@ std::map<std::string, std::string> NvmCache<C>::Config::serialize() const {
   configMap["encryption"] = deviceEncryptor ? "set" : "empty";
   configMap["truncateItemToOriginalAllocSizeInNvm"] =
       truncateItemToOriginalAllocSizeInNvm ? "true" : "false";
+  configMap["writeBackBatchSize"] = std::to_string(writeBackBatchSize);
+  configMap["writeBackBufferSize"] = std::to_string(writeBackBufferSize);
+  configMap["writeBackMaxDelayMs"] = std::to_string(writeBackMaxDelay.count());
+  configMap["promotionPolicy"] = promotionPolicy ? "set" : "empty";
   return configMap;
 }
 
@@ -65,6 +69,13 @@ typename NvmCache<C>::Config NvmCache<C>::Config::validateAndSetDefaults() {
     }
   }
 
+  if (writeBackBatchSize > 0 && writeBackBufferSize < writeBackBatchSize) {
+    throw std::invalid_argument(folly::sformat(
+        "Write-back buffer of {} puts can not hold a batch of {} puts.",
+        writeBackBufferSize,
+        writeBackBatchSize));
+  }
+
   return *this;
 }
 
@@ -98,11 +109,86 @@ bool NvmCache<C>::hasTombStone(HashedKey hk) {
 }
 
 template <typename C>
-typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
+typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk,
+                                                    bool forWrite) {
   if (!isEnabled()) {
     return WriteHandle{};
   }
 
+  GetCtx* ctx{nullptr};
+  auto hdl = startFind(hk, forWrite, ctx);
+  if (!ctx) {
+    return hdl;
+  }
+
+  auto guard = folly::makeGuard([hk, this]() { removeFromFillMap(hk); });
+
+  runAfterWriteBack(hk, [this, ctx, keyHash = hk.keyHash()]() {
+    navyCache_->lookupAsync(
+        HashedKey::precomputed(ctx->getKey(), keyHash),
+        [this, ctx](navy::Status s, HashedKey k, navy::Buffer v) {
+          this->onGetComplete(*ctx, s, k, v.view());
+        });
+  });
+  guard.dismiss();
+  return hdl;
+}
+
+template <typename C>
+std::vector<typename NvmCache<C>::WriteHandle> NvmCache<C>::findBatch(
+    folly::Range<const HashedKey*> keys) {
+  std::vector<WriteHandle> hdls;
+  hdls.reserve(keys.size());
+  if (!isEnabled()) {
+    hdls.resize(keys.size());
+    return hdls;
+  }
+
+  std::vector<HashedKey> batchKeys;
+  std::vector<navy::LookupCallback> batchCbs;
+  for (const auto hk : keys) {
+    GetCtx* ctx{nullptr};
+    hdls.push_back(startFind(hk, false /* forWrite */, ctx));
+    if (!ctx) {
+      continue;
+    }
+
+    auto guard = folly::makeGuard([hk, this]() { removeFromFillMap(hk); });
+    auto navyKey = HashedKey::precomputed(ctx->getKey(), hk.keyHash());
+    navy::LookupCallback cb = [this, ctx](navy::Status s, HashedKey k,
+                                          navy::Buffer v) {
+      this->onGetComplete(*ctx, s, k, v.view());
+    };
+    // a batched lookup is not ordered with the navy requests for the same
+    // key. Like the fast negative lookup in startFind(), it can not be
+    // trusted when a put for the key may be enqueued already.
+    if (putContexts_[getShardForKey(hk)].hasContexts()) {
+      runAfterWriteBack(hk, [this, navyKey, cb = std::move(cb)]() mutable {
+        navyCache_->lookupAsync(navyKey, std::move(cb));
+      });
+    } else {
+      batchKeys.push_back(navyKey);
+      batchCbs.push_back(std::move(cb));
+    }
+    guard.dismiss();
+  }
+
+  if (!batchKeys.empty()) {
+    auto guard = folly::makeGuard([&batchKeys, this]() {
+      for (const auto hk : batchKeys) {
+        removeFromFillMap(hk);
+      }
+    });
+    navyCache_->lookupBatchAsync(batchKeys, std::move(batchCbs));
+    guard.dismiss();
+  }
+  return hdls;
+}
+
+template <typename C>
+typename NvmCache<C>::WriteHandle NvmCache<C>::startFind(HashedKey hk,
+                                                         bool forWrite,
+                                                         GetCtx*& ctx) {
   util::LatencyTracker tracker(stats().nvmLookupLatency_);
 
   auto shard = getShardForKey(hk);
@@ -112,7 +198,6 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
 
   stats().numNvmGets.inc();
 
-  GetCtx* ctx{nullptr};
   WriteHandle hdl{nullptr};
   {
     auto lock = getFillLockForShard(shard);
@@ -164,8 +249,10 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
     XDCHECK(waitContext);
 
     if (it != fillMap.end()) {
-      ctx = it->second.get();
-      ctx->addWaiter(std::move(waitContext));
+      it->second->addWaiter(std::move(waitContext));
+      if (forWrite) {
+        it->second->markForWrite();
+      }
       stats().numNvmGetCoalesced.inc();
       return hdl;
     }
@@ -173,6 +260,9 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
     // create a context
     auto newCtx = std::make_unique<GetCtx>(
         *this, hk.key(), std::move(waitContext), std::move(tracker));
+    if (forWrite) {
+      newCtx->markForWrite();
+    }
     auto res =
         fillMap.emplace(std::make_pair(newCtx->getKey(), std::move(newCtx)));
     XDCHECK(res.second);
@@ -180,14 +270,6 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
   } // scope for fill lock
 
   XDCHECK(ctx);
-  auto guard = folly::makeGuard([hk, this]() { removeFromFillMap(hk); });
-
-  navyCache_->lookupAsync(
-      HashedKey::precomputed(ctx->getKey(), hk.keyHash()),
-      [this, ctx](navy::Status s, HashedKey k, navy::Buffer v) {
-        this->onGetComplete(*ctx, s, k, v.view());
-      });
-  guard.dismiss();
   return hdl;
 }
 
@@ -254,14 +336,17 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::peek(folly::StringPiece key) {
 
   // no need for fill lock or inspecting the state of other concurrent
   // operations since we only want to check the state for debugging purposes.
-  navyCache_->lookupAsync(
-      HashedKey{key}, [&, this](navy::Status st, HashedKey, navy::Buffer v) {
-        if (st != navy::Status::NotFound) {
-          auto nvmItem = reinterpret_cast<const NvmItem*>(v.data());
-          hdl = createItem(key, *nvmItem);
-        }
-        b.post();
-      });
+  // A put staged for write-back is submitted first so that it is seen.
+  runAfterWriteBack(HashedKey{key}, [&, this]() {
+    navyCache_->lookupAsync(
+        HashedKey{key}, [&, this](navy::Status st, HashedKey, navy::Buffer v) {
+          if (st != navy::Status::NotFound) {
+            auto nvmItem = reinterpret_cast<const NvmItem*>(v.data());
+            hdl = createItem(key, *nvmItem);
+          }
+          b.post();
+        });
+  });
   b.wait();
   return hdl;
 }
@@ -440,6 +525,11 @@ NvmCache<C>::NvmCache(C& c,
       truncate,
       std::move(config.deviceEncryptor),
       itemDestructor_ ? true : false);
+  if (config_.writeBackBatchSize > 0) {
+    writeBack_ = std::make_unique<NvmWriteBack>(
+        *navyCache_, config_.writeBackBatchSize, config_.writeBackBufferSize,
+        config_.writeBackMaxDelay);
+  }
 }
 
 template <typename C>
@@ -553,23 +643,30 @@ void NvmCache<C>::put(WriteHandle& hdl, PutToken token) {
   // eviction, and we should abandon this write to navy since we already
   // reported the key doesn't exist in the cache.
   const bool executed = token.executeIfValid([&]() {
-    auto status = navyCache_->insertAsync(
-        HashedKey::precomputed(ctx.key(), hk.keyHash()), makeBufferView(val),
-        [this, putCleanup, valSize, val](navy::Status st, HashedKey key) {
-          if (st == navy::Status::Ok) {
-            stats().nvmPutSize_.trackValue(valSize);
-          } else if (st == navy::Status::BadState) {
-            // we set disable navy since we got a BadState from navy
-            disableNavy("Delete Failure. BadState");
-          } else {
-            // put failed, DRAM eviction happened and destructor was not
-            // executed. we unconditionally trigger destructor here for cleanup.
-            evictCB(key, makeBufferView(val), navy::DestructorEvent::PutFailed);
-          }
-          putCleanup();
-        });
-
-    if (status == navy::Status::Ok) {
+    const auto navyKey = HashedKey::precomputed(ctx.key(), hk.keyHash());
+    navy::InsertCallback cb = [this, putCleanup, valSize, val](
+                                  navy::Status st, HashedKey key) {
+      if (st == navy::Status::Ok) {
+        stats().nvmPutSize_.trackValue(valSize);
+      } else if (st == navy::Status::BadState) {
+        // we set disable navy since we got a BadState from navy
+        disableNavy("Delete Failure. BadState");
+      } else {
+        // put failed, DRAM eviction happened and destructor was not
+        // executed. we unconditionally trigger destructor here for cleanup.
+        evictCB(key, makeBufferView(val), navy::DestructorEvent::PutFailed);
+      }
+      putCleanup();
+    };
+    // a staged put is written by a later batch, but counts as queued since
+    // lookups and removes for the key wait for it.
+    const bool queued =
+        writeBack_
+            ? writeBack_->stage(navyKey, makeBufferView(val), std::move(cb))
+            : navyCache_->insertAsync(navyKey, makeBufferView(val),
+                                      std::move(cb)) == navy::Status::Ok;
+
+    if (queued) {
       guard.dismiss();
       // mark it as NvmClean and unNvmEvicted if we put it into the queue
       // so handle destruction awares that there's a NVM copy (at least in the
@@ -587,6 +684,10 @@ void NvmCache<C>::put(WriteHandle& hdl, PutToken token) {
   if (!executed) {
     stats().numNvmAbortedPutOnInflightGet.inc();
   }
+
+  if (writeBack_) {
+    writeBack_->maybeSubmit();
+  }
 }
 
 template <typename C>
@@ -631,7 +732,27 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
     return;
   }
 
-  auto it = createItem(hk.key(), *nvmItem);
+  // chained items are always promoted. createItem would add the chain to
+  // the chained item container under the key, where a transient parent
+  // would collide with the chain of a later fill or insert of the key.
+  const bool promote = !config_.promotionPolicy ||
+                       nvmItem->getNumBlobs() > 1 ||
+                       config_.promotionPolicy->shouldPromote(hk);
+  const bool transient = !promote && !ctx.isForWrite();
+
+  WriteHandle it;
+  if (transient) {
+    // a transient fill takes free memory when there is some, e.g. the one
+    // released by the previous transient fill of the class, rather than
+    // evicting a cached item for an item that is not cached.
+    it = createItem(hk.key(), *nvmItem, false /* evict */);
+    if (!it) {
+      numTransientEvictions_.inc();
+    }
+  }
+  if (!it) {
+    it = createItem(hk.key(), *nvmItem);
+  }
   if (!it) {
     stats().numNvmGetMiss.inc();
     stats().numNvmGetMissErrs.inc();
@@ -643,6 +764,10 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
 
   XDCHECK(it->isNvmClean());
 
+  // a transient fill is detached from the fill map while the fill lock is
+  // held so that a later lookup for write does not join it. Destroyed after
+  // the lock is released since that wakes up the waiters.
+  std::unique_ptr<GetCtx> detached;
   auto lock = getFillLock(hk);
   if (hasTombStone(hk) || !ctx.isValid()) {
     // a racing remove or evict while we were filling
@@ -651,9 +776,26 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
     return;
   }
 
+  if (transient) {
+    // serve the item without inserting it. The handle stays nascent, so the
+    // item goes back to the allocator once the last handle is released and
+    // its memory is reused by the next transient fill.
+    numTransientServes_.inc();
+    it.markWentToNvm();
+    ctx.setWriteHandle(std::move(it));
+    auto& map = getFillMap(hk);
+    auto entry = map.find(hk.key());
+    XDCHECK(entry != map.end());
+    detached = std::move(entry->second);
+    map.erase(entry);
+    guard.dismiss();
+    return;
+  }
+
   // by the time we filled from navy, another thread inserted in RAM. We
   // disregard.
   if (CacheAPIWrapperForNvm<C>::insertFromNvm(cache_, it)) {
+    numPromotions_.inc();
     it.markWentToNvm();
     ctx.setWriteHandle(std::move(it));
   }
@@ -661,7 +803,7 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
 
 template <typename C>
 typename NvmCache<C>::WriteHandle NvmCache<C>::createItem(
-    folly::StringPiece key, const NvmItem& nvmItem) {
+    folly::StringPiece key, const NvmItem& nvmItem, bool evict) {
   const size_t numBufs = nvmItem.getNumBlobs();
   // parent item
   XDCHECK_GE(numBufs, 1u);
@@ -672,7 +814,7 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::createItem(
   // size matches the pBlob's size
   auto it = CacheAPIWrapperForNvm<C>::allocateInternal(
       cache_, nvmItem.poolId(), key, pBlob.origAllocSize,
-      nvmItem.getCreationTime(), nvmItem.getExpiryTime());
+      nvmItem.getCreationTime(), nvmItem.getExpiryTime(), evict);
   if (!it) {
     return nullptr;
   }
@@ -842,8 +984,11 @@ void NvmCache<C>::remove(HashedKey hk, DeleteTombStoneGuard tombstone) {
                                static_cast<int>(status)));
   };
 
-  navyCache_->removeAsync(HashedKey::precomputed(ctx.key(), hk.keyHash()),
-                          delCleanup);
+  runAfterWriteBack(hk, [this, &ctx, keyHash = hk.keyHash(),
+                         delCleanup = std::move(delCleanup)]() mutable {
+    navyCache_->removeAsync(HashedKey::precomputed(ctx.key(), keyHash),
+                            std::move(delCleanup));
+  });
 }
 
 template <typename C>
@@ -891,14 +1036,50 @@ bool NvmCache<C>::shutDown() {
 
 template <typename C>
 void NvmCache<C>::flushPendingOps() {
+  if (writeBack_) {
+    writeBack_->drain();
+  }
   navyCache_->flush();
 }
 
+template <typename C>
+void NvmCache<C>::runAfterWriteBack(HashedKey hk, folly::Function<void()> op) {
+  if (writeBack_) {
+    writeBack_->runAfterPending(hk.keyHash(), std::move(op));
+  } else {
+    op();
+  }
+}
+
 template <typename C>
 util::StatsMap NvmCache<C>::getStatsMap() const {
   util::StatsMap statsMap;
   navyCache_->getCounters(statsMap.createCountVisitor());
   statsMap.insertCount("items_tracked_for_destructor", getNvmItemRemovedSize());
+
+  uint64_t tombstoneContended = 0;
+  uint64_t tombstoneOverflows = 0;
+  uint64_t inflightPutContended = 0;
+  uint64_t inflightPutOverflows = 0;
+  for (size_t i = 0; i < kShards; ++i) {
+    tombstoneContended += tombstones_[i].getNumLockContended();
+    tombstoneOverflows += tombstones_[i].getNumOverflows();
+    inflightPutContended += inflightPuts_[i].getNumLockContended();
+    inflightPutOverflows += inflightPuts_[i].getNumOverflows();
+  }
+  statsMap.insertRate("tombstone_lock_contended", tombstoneContended);
+  statsMap.insertRate("tombstone_overflows", tombstoneOverflows);
+  statsMap.insertRate("inflight_put_lock_contended", inflightPutContended);
+  statsMap.insertRate("inflight_put_overflows", inflightPutOverflows);
+  if (writeBack_) {
+    writeBack_->getCounters(statsMap);
+  }
+  statsMap.insertRate("nvm_promotions", numPromotions_.get());
+  statsMap.insertRate("nvm_transient_serves", numTransientServes_.get());
+  statsMap.insertRate("nvm_transient_evictions", numTransientEvictions_.get());
+  if (config_.promotionPolicy) {
+    config_.promotionPolicy->getCounters(statsMap.createCountVisitor());
+  }
   return statsMap;
 }
 
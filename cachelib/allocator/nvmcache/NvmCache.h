@@ -24,6 +24,7 @@
 #include <folly/synchronization/Baton.h>
 
 #include <array>
+#include <chrono>
 #include <mutex>
 #include <stdexcept>
 #include <vector>
@@ -33,6 +34,8 @@
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 #include "cachelib/allocator/nvmcache/NavySetup.h"
 #include "cachelib/allocator/nvmcache/NvmItem.h"
+#include "cachelib/allocator/nvmcache/NvmPromotionPolicy.h"
+#include "cachelib/allocator/nvmcache/NvmWriteBack.h"
 #include "cachelib/allocator/nvmcache/ReqContexts.h"
 #include "cachelib/allocator/nvmcache/TombStones.h"
 #include "cachelib/allocator/nvmcache/WaitContext.h"
@@ -113,6 +116,23 @@ class NvmCache {
     // thread hops by using synchronous methods.
     bool enableFastNegativeLookups{false};
 
+    // (Optional) when non-zero, puts of items evicted from DRAM are staged
+    // and handed to navy in batches of this many puts, so that BlockCache
+    // appends a batch to its region with one allocation. Puts that find
+    // writeBackBufferSize puts staged already are dropped.
+    uint32_t writeBackBatchSize{0};
+    uint32_t writeBackBufferSize{1024};
+    // staged puts that waited this long without a batch being submitted are
+    // submitted anyway. 0 leaves them staged until a batch fills up or a
+    // lookup of one of them.
+    std::chrono::milliseconds writeBackMaxDelay{10};
+
+    // (Optional) decides whether an item found in nvm is inserted into DRAM.
+    // Items that are not promoted are returned in a transient handle that is
+    // not inserted into the cache. Lookups for write and items with chained
+    // items always promote. If not set, every nvm hit is promoted.
+    std::shared_ptr<NvmPromotionPolicy> promotionPolicy{};
+
     // serialize the config for debugging purposes
     std::map<std::string, std::string> serialize() const;
 
@@ -134,8 +154,18 @@ class NvmCache {
 
   // Look up item by key
   // @param key         key to lookup
+  // @param forWrite    whether the caller mutates the item. The item is then
+  //                    inserted into DRAM regardless of the promotion policy.
   // @return            WriteHandle
-  WriteHandle find(HashedKey key);
+  WriteHandle find(HashedKey key, bool forWrite = false);
+
+  // Look up a batch of items by key. Keys that need to be read from navy are
+  // looked up as one navy job so that their reads can be shared. Keys whose
+  // shard has concurrent puts in flight are looked up individually to keep
+  // their ordering with the puts.
+  // @param keys        keys to lookup
+  // @return            a WriteHandle for each key in the same order
+  std::vector<WriteHandle> findBatch(folly::Range<const HashedKey*> keys);
 
   // Returns true if a key is potentially in cache. There is a non-zero chance
   // the key does not exist in cache (e.g. hash collision in NvmCache). This
@@ -261,10 +291,13 @@ class NvmCache {
   //
   // @param key   key for the nvm item
   // @param nvmItem contents for the key
+  // @param evict   if false, the item is only allocated from free memory
   //
   // @param   return an item handle allocated and initialized to the right state
   //          based on the NvmItem
-  WriteHandle createItem(folly::StringPiece key, const NvmItem& nvmItem);
+  WriteHandle createItem(folly::StringPiece key,
+                         const NvmItem& nvmItem,
+                         bool evict = true);
 
   // creates the item into IOBuf from NvmItem, if the item has chained items,
   // chained IOBufs will be created.
@@ -303,6 +336,7 @@ class NvmCache {
     WriteHandle it; // will be set when Context is being filled
     util::LatencyTracker tracker_;
     bool valid_;
+    bool forWrite_{false}; // a waiter mutates the item, it must be promoted
 
     GetCtx(NvmCache& c,
            folly::StringPiece k,
@@ -362,6 +396,10 @@ class NvmCache {
 
     void invalidate() { valid_ = false; }
 
+    void markForWrite() { forWrite_ = true; }
+
+    bool isForWrite() const { return forWrite_; }
+
     bool isValid() const { return valid_; }
   };
 
@@ -422,6 +460,15 @@ class NvmCache {
     return getFillLockForShard(getShardForKey(hk));
   }
 
+  // Do the in-memory part of a lookup: check the RAM cache, join a fill that
+  // is already in progress or create a new one.
+  // @param hk        key to lookup
+  // @param forWrite  whether the item must be promoted into DRAM
+  // @param ctx       set to the fill context if a navy lookup must be issued
+  //                  for the key, nullptr otherwise.
+  // @return          the handle for the key
+  WriteHandle startFind(HashedKey hk, bool forWrite, GetCtx*& ctx);
+
   void onGetComplete(GetCtx& ctx,
                      navy::Status s,
                      HashedKey key,
@@ -429,6 +476,10 @@ class NvmCache {
 
   void evictCB(HashedKey hk, navy::BufferView val, navy::DestructorEvent e);
 
+  // Runs @op, which issues a navy request for @hk, once a put of the key
+  // staged for write-back has been inserted; right away otherwise.
+  void runAfterWriteBack(HashedKey hk, folly::Function<void()> op);
+
   static navy::BufferView makeBufferView(folly::ByteRange b) {
     return navy::BufferView{b.size(), b.data()};
   }
@@ -473,6 +524,16 @@ class NvmCache {
 
   std::unique_ptr<cachelib::navy::AbstractCache> navyCache_;
 
+  // stages puts into batches when write-back batching is enabled. declared
+  // after navyCache_ since it refers to it.
+  std::unique_ptr<NvmWriteBack> writeBack_;
+
+  // nvm hits inserted into DRAM and served from a transient handle instead
+  AtomicCounter numPromotions_;
+  AtomicCounter numTransientServes_;
+  // transient serves that found no free memory and evicted from DRAM
+  AtomicCounter numTransientEvictions_;
+
   friend class tests::NvmCacheTest;
   FRIEND_TEST(CachelibAdminTest, WorkingSetAnalysisLoggingTest);
 };
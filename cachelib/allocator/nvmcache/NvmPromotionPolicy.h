@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+#include <folly/lang/Align.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/CountMinSketch.h"
+#include "cachelib/common/Hash.h"
+#include "cachelib/common/PercentileStats.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Abstract base class of a policy deciding whether an item found in nvm is
+// promoted into DRAM. An item that is not promoted is served from a
+// transient handle that is not inserted into the cache, so that reads of
+// items that are not hot do not evict the DRAM working set.
+class NvmPromotionPolicy {
+ public:
+  virtual ~NvmPromotionPolicy() = default;
+
+  // Called for every hit in nvm. Figure out whether the item should be
+  // inserted into DRAM.
+  virtual bool shouldPromote(HashedKey hk) = 0;
+
+  // Exports policy stats via CounterVisitor.
+  virtual void getCounters(const util::CounterVisitor& visitor) const = 0;
+};
+
+// Promotes an item once it has been hit in nvm @threshold times, counted
+// by a CountMinSketch. Counts are halved every time a shard of the sketch
+// has seen as many hits as it has counters, so that the frequencies follow
+// recent accesses instead of the whole history.
+class FrequencyPromotionPolicy final : public NvmPromotionPolicy {
+ public:
+  // @param threshold         number of nvm hits, including the current
+  //                          one, after which the item is promoted.
+  // @param numTrackedKeys    number of keys the sketch is sized for.
+  //
+  // @throw std::invalid_argument if threshold or numTrackedKeys are 0
+  FrequencyPromotionPolicy(uint8_t threshold, size_t numTrackedKeys)
+      : threshold_{threshold} {
+    if (threshold == 0 || numTrackedKeys == 0) {
+      throw std::invalid_argument(folly::sformat(
+          "Invalid promotion threshold {} or number of tracked keys {}",
+          threshold, numTrackedKeys));
+    }
+    const auto width = static_cast<uint32_t>(
+        std::max<size_t>(numTrackedKeys / kShards, kMinShardWidth));
+    for (auto& shard : shards_) {
+      shard.sketch = util::CountMinSketch8{width, kSketchDepth};
+      shard.decayWindow = width;
+    }
+  }
+
+  bool shouldPromote(HashedKey hk) override {
+    auto& shard = shards_[hk.keyHash() % kShards];
+    uint8_t count = 0;
+    {
+      std::lock_guard<std::mutex> l{shard.mutex};
+      shard.sketch.increment(hk.keyHash());
+      count = shard.sketch.getCount(hk.keyHash());
+      if (++shard.numHits >= shard.decayWindow) {
+        shard.sketch.decayCountsBy(0.5);
+        shard.numHits = 0;
+        numDecays_.inc();
+      }
+    }
+    if (count >= threshold_) {
+      numPromoted_.inc();
+      return true;
+    }
+    numRejected_.inc();
+    return false;
+  }
+
+  void getCounters(const util::CounterVisitor& visitor) const override {
+    visitor("nvm_promotion_freq_promoted", numPromoted_.get(),
+            util::CounterVisitor::CounterType::RATE);
+    visitor("nvm_promotion_freq_rejected", numRejected_.get(),
+            util::CounterVisitor::CounterType::RATE);
+    visitor("nvm_promotion_freq_decays", numDecays_.get(),
+            util::CounterVisitor::CounterType::RATE);
+  }
+
+ private:
+  static constexpr size_t kShards = 64;
+  static constexpr uint32_t kSketchDepth = 4;
+  static constexpr size_t kMinShardWidth = 1024;
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    std::mutex mutex;
+    util::CountMinSketch8 sketch;
+    // hits counted since the last decay and the number of hits after which
+    // the counts are decayed.
+    uint64_t numHits{0};
+    uint64_t decayWindow{0};
+  };
+
+  const uint8_t threshold_;
+  std::array<Shard, kShards> shards_;
+
+  AtomicCounter numPromoted_;
+  AtomicCounter numRejected_;
+  AtomicCounter numDecays_;
+};
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/MPMCQueue.h>
+#include <folly/lang/Align.h>
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PeriodicWorker.h"
+#include "cachelib/common/Utils.h"
+#include "cachelib/navy/AbstractCache.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Stages the puts of items evicted from DRAM and hands them to navy in
+// batches, so that the large item engine can append a batch to a region
+// with one allocation instead of one per item. Staging is a lock-free
+// bounded queue; a put that finds it full is dropped. A batch is submitted
+// once enough puts are staged, or by a background flush once staged puts
+// have waited for the max delay without any batch being submitted.
+//
+// A batch is inserted by one navy job that is not ordered with the navy
+// requests for the same keys. To keep ordering, callers route lookups and
+// removes through runAfterPending(), which defers them until the staged or
+// in-flight put of the key completes. Pending puts are counted in a table
+// of atomic counters indexed by key hash, so staging never takes a lock and
+// a lookup with no pending put on its counter runs without one. Keys that
+// share a counter merely delay each other.
+//
+// Staging is shared by the engine pairs rather than split per pair: which
+// pair a key goes to is decided inside navy, and the driver already splits
+// every batch into one job per engine pair.
+class NvmWriteBack : public PeriodicWorker {
+ public:
+  using Op = folly::Function<void()>;
+
+  // @param navyCache   navy cache the batches are inserted into
+  // @param batchSize   number of staged puts that triggers a batch
+  // @param capacity    max number of staged puts, beyond which puts are
+  //                    dropped
+  // @param maxDelay    how long staged puts may wait for a batch to fill up
+  //                    before they are submitted anyway. 0 means they wait
+  //                    until a batch fills up or a lookup needs them.
+  NvmWriteBack(navy::AbstractCache& navyCache,
+               uint32_t batchSize,
+               uint32_t capacity,
+               std::chrono::milliseconds maxDelay)
+      : navyCache_{navyCache},
+        batchSize_{batchSize},
+        queue_{capacity},
+        pending_{std::make_unique<std::atomic<uint32_t>[]>(kPendingCounters)} {
+    XDCHECK_GT(batchSize_, 0u);
+    XDCHECK_GE(capacity, batchSize_);
+    // a put waits at most two intervals: one without a batch being
+    // submitted, then the flush.
+    if (maxDelay.count() > 0) {
+      start(std::max(maxDelay / 2, std::chrono::milliseconds{1}),
+            "NvmWriteBack");
+    }
+  }
+
+  ~NvmWriteBack() override { stop(); }
+
+  // Stages a put. @hk and @value must stay valid until @cb is invoked. @cb
+  // is invoked with the status of the insert, including Rejected if navy
+  // does not accept the put once its batch is submitted.
+  //
+  // @return false if the buffer is full and the put was dropped. @cb is not
+  //         invoked in that case.
+  bool stage(HashedKey hk, navy::BufferView value, navy::InsertCallback cb) {
+    getCounter(hk.keyHash()).fetch_add(1);
+    if (!queue_.writeIfNotFull(Entry{hk, value, std::move(cb)})) {
+      numDropped_.inc();
+      releasePending(hk.keyHash());
+      return false;
+    }
+    numStaged_.inc();
+    return true;
+  }
+
+  // Submits a batch if enough puts are staged.
+  void maybeSubmit() {
+    if (queue_.sizeGuess() >= static_cast<ssize_t>(batchSize_)) {
+      submit(batchSize_);
+    }
+  }
+
+  // Submits all the staged puts.
+  void drain() {
+    while (!queue_.isEmpty()) {
+      submit(batchSize_);
+    }
+  }
+
+  // Runs @op once the put of the key with @keyHash has been completed by
+  // navy, or right away if there is none. Submits the staged puts if @op
+  // has to wait.
+  void runAfterPending(uint64_t keyHash, Op op) {
+    const auto idx = getCounterIndex(keyHash);
+    if (pending_[idx].load() == 0) {
+      op();
+      return;
+    }
+
+    auto& shard = getShard(idx);
+    {
+      std::unique_lock<std::mutex> l{shard.mutex};
+      // announce the waiter before checking the counter again, so that a
+      // release that drops the counter to 0 either sees the waiter or is
+      // seen here.
+      shard.numWaiting.fetch_add(1);
+      if (pending_[idx].load() == 0) {
+        shard.numWaiting.fetch_sub(1);
+        l.unlock();
+        op();
+        return;
+      }
+      shard.waiters.push_back(Waiter{idx, std::move(op)});
+    }
+    numDeferred_.inc();
+    drain();
+  }
+
+  void getCounters(util::StatsMap& statsMap) const {
+    statsMap.insertRate("nvm_writeback_staged", numStaged_.get());
+    statsMap.insertRate("nvm_writeback_batches", numBatches_.get());
+    statsMap.insertRate("nvm_writeback_dropped", numDropped_.get());
+    statsMap.insertRate("nvm_writeback_deferred", numDeferred_.get());
+    statsMap.insertRate("nvm_writeback_deadline_flushes",
+                        numDeadlineFlushes_.get());
+  }
+
+ private:
+  struct Entry {
+    HashedKey hk{HashedKey::precomputed({}, 0)};
+    navy::BufferView value;
+    navy::InsertCallback cb;
+  };
+
+  // an operation waiting for the puts counted by a pending counter
+  struct Waiter {
+    uint32_t counter{0};
+    Op op;
+  };
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    std::mutex mutex;
+    // number of waiters, read without the mutex by releases
+    std::atomic<uint32_t> numWaiting{0};
+    // in the order they were deferred
+    std::vector<Waiter> waiters;
+  };
+
+  static constexpr uint32_t kPendingCounters = 1u << 16;
+  static constexpr size_t kShards = 256;
+
+  static uint32_t getCounterIndex(uint64_t keyHash) {
+    return static_cast<uint32_t>(keyHash % kPendingCounters);
+  }
+
+  std::atomic<uint32_t>& getCounter(uint64_t keyHash) {
+    return pending_[getCounterIndex(keyHash)];
+  }
+
+  Shard& getShard(uint32_t counterIndex) {
+    return shards_[counterIndex % kShards];
+  }
+
+  // submits the staged puts if they waited a whole interval without any
+  // batch being submitted.
+  void work() final {
+    const auto numBatches = numBatches_.get();
+    if (numBatches == lastNumBatches_ && !queue_.isEmpty()) {
+      numDeadlineFlushes_.inc();
+      drain();
+    }
+    lastNumBatches_ = numBatches_.get();
+  }
+
+  // releases one put of the key hash and runs the operations that waited
+  // for its counter once no put is left on it.
+  void releasePending(uint64_t keyHash) {
+    const auto idx = getCounterIndex(keyHash);
+    if (pending_[idx].fetch_sub(1) != 1) {
+      return;
+    }
+    auto& shard = getShard(idx);
+    if (shard.numWaiting.load() == 0) {
+      return;
+    }
+
+    std::vector<Op> ops;
+    {
+      std::lock_guard<std::mutex> l{shard.mutex};
+      auto& waiters = shard.waiters;
+      auto ready = std::stable_partition(
+          waiters.begin(), waiters.end(), [this](const Waiter& w) {
+            return pending_[w.counter].load() != 0;
+          });
+      for (auto it = ready; it != waiters.end(); ++it) {
+        ops.push_back(std::move(it->op));
+      }
+      waiters.erase(ready, waiters.end());
+      shard.numWaiting.fetch_sub(static_cast<uint32_t>(ops.size()));
+    }
+    for (auto& op : ops) {
+      op();
+    }
+  }
+
+  // dequeues up to @maxEntries staged puts and inserts them as one batch.
+  void submit(uint32_t maxEntries) {
+    std::vector<HashedKey> keys;
+    std::vector<navy::BufferView> values;
+    std::vector<navy::InsertCallback> cbs;
+    Entry entry;
+    while (keys.size() < maxEntries && queue_.read(entry)) {
+      keys.push_back(entry.hk);
+      values.push_back(entry.value);
+      cbs.push_back([this, cb = std::move(entry.cb)](navy::Status status,
+                                                     HashedKey hk) mutable {
+        // the key may not outlive the callback
+        const auto keyHash = hk.keyHash();
+        cb(status, hk);
+        releasePending(keyHash);
+      });
+    }
+    if (keys.empty()) {
+      return;
+    }
+
+    numBatches_.inc();
+    navyCache_.insertBatchAsync(keys, values, std::move(cbs));
+  }
+
+  navy::AbstractCache& navyCache_;
+  const uint32_t batchSize_;
+  folly::MPMCQueue<Entry> queue_;
+  // number of staged or in-flight puts per key hash counter
+  std::unique_ptr<std::atomic<uint32_t>[]> pending_;
+  std::array<Shard, kShards> shards_;
+
+  // batches submitted as of the previous run of the flush. Only used by the
+  // worker thread.
+  uint64_t lastNumBatches_{0};
+
+  AtomicCounter numStaged_;
+  AtomicCounter numBatches_;
+  AtomicCounter numDropped_;
+  AtomicCounter numDeferred_;
+  AtomicCounter numDeadlineFlushes_;
+};
+
+} // namespace cachelib
+} // namespace facebook
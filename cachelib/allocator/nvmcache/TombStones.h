@@ -15,14 +15,20 @@
  */
 
 #pragma once
-#include <folly/container/F14Map.h>
+#include <fmt/format.h>
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/lang/Align.h>
 #include <glog/logging.h>
+#include <gtest/gtest_prod.h>
 
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <mutex>
+#include <stdexcept>
 #include <utility>
-
-#include "folly/Range.h"
+#include <vector>
 
 namespace facebook {
 namespace cachelib {
@@ -30,29 +36,41 @@ namespace cachelib {
 // Utility that helps us track in flight deletes. We maintain a count per key
 // and check for presence against the count to resolve multiple concurrent
 // deletes for the same key in flight.
+//
+// Keys are tracked in a few inline slots, so neither adding nor removing a
+// tombstone allocates unless more than kInlineSlots distinct keys are in
+// flight at once. A slot is matched by a 64-bit hash of the key and then by
+// the key itself. The slot does not copy the key: it links the guards of its
+// tombstones and compares against the key copy of the first one.
 class alignas(folly::hardware_destructive_interference_size) TombStones {
  public:
   class Guard;
 
+  // max size of a key a tombstone can be added for
+  static constexpr size_t kMaxKeySize = 255;
+
+  // number of keys tracked without allocating
+  static constexpr size_t kInlineSlots = 4;
+
   // adds an instance of  key
   // @param key  key for the record
   // @return a valid Guard representing the tombstone
-  Guard add(folly::StringPiece key) {
-    std::lock_guard<std::mutex> l(mutex_);
-    auto it = keys_.find(key);
+  // @throw std::invalid_argument if the key is longer than kMaxKeySize
+  Guard add(folly::StringPiece key) { return add(key, hashKey(key)); }
 
-    if (it == keys_.end()) {
-      it = keys_.insert(std::make_pair(key.toString(), 0)).first;
-    }
+  // checks if there is a key present and returns true if so.
+  bool isPresent(folly::StringPiece key) {
+    return isPresent(key, hashKey(key));
+  }
 
-    ++it->second;
-    return Guard(it->first, *this);
+  // @return number of times a caller had to wait for the lock
+  uint64_t getNumLockContended() const noexcept {
+    return numLockContended_.load(std::memory_order_relaxed);
   }
 
-  // checks if there is a key present and returns true if so.
-  bool isPresent(folly::StringPiece key) {
-    std::lock_guard<std::mutex> l(mutex_);
-    return keys_.count(key) != 0;
+  // @return number of keys that did not fit in the inline slots
+  uint64_t getNumOverflows() const noexcept {
+    return numOverflows_.load(std::memory_order_relaxed);
   }
 
   // Guard that wraps around the tombstone record. Removes the key from the
@@ -63,7 +81,7 @@ class alignas(folly::hardware_destructive_interference_size) TombStones {
     Guard() {}
     ~Guard() {
       if (tombstones_) {
-        tombstones_->remove(key_);
+        tombstones_->remove(*this);
         tombstones_ = nullptr;
       }
     }
@@ -72,10 +90,16 @@ class alignas(folly::hardware_destructive_interference_size) TombStones {
     Guard(const Guard&) = delete;
     Guard& operator=(const Guard&&) = delete;
 
-    // allow moving
+    // allow moving. The guard takes the place of the other one in its slot.
     Guard(Guard&& other) noexcept
-        : key_{std::move(other.key_)}, tombstones_(other.tombstones_) {
-      other.tombstones_ = nullptr;
+        : keySize_{other.keySize_},
+          hash_{other.hash_},
+          tombstones_(other.tombstones_) {
+      std::memcpy(key_.data(), other.key_.data(), keySize_);
+      if (tombstones_) {
+        tombstones_->replace(other, *this);
+        other.tombstones_ = nullptr;
+      }
     }
     Guard& operator=(Guard&& other) noexcept {
       if (this != &other) {
@@ -85,43 +109,173 @@ class alignas(folly::hardware_destructive_interference_size) TombStones {
       return *this;
     }
 
-    folly::StringPiece key() const noexcept { return key_; }
+    folly::StringPiece key() const noexcept {
+      return folly::StringPiece{key_.data(), keySize_};
+    }
 
     explicit operator bool() const noexcept { return tombstones_ != nullptr; }
 
    private:
     // only tombstone can create a guard.
     friend TombStones;
-    Guard(folly::StringPiece key, TombStones& t) noexcept
-        : key_(key), tombstones_(&t) {}
+    Guard(folly::StringPiece key, uint64_t hash, TombStones& t) noexcept
+        : keySize_(key.size()), hash_(hash), tombstones_(&t) {
+      std::memcpy(key_.data(), key.data(), keySize_);
+    }
 
-    // key for the tombstone
-    folly::StringPiece key_;
+    // key for the tombstone. Kept inline so that the guard does not allocate.
+    std::array<char, kMaxKeySize> key_;
+    size_t keySize_{0};
+
+    // hash the tombstone is recorded under
+    uint64_t hash_{0};
 
     // tombstone record
     TombStones* tombstones_{nullptr};
+
+    // other guards for the same key, protected by the tombstones' mutex
+    Guard* prev_{nullptr};
+    Guard* next_{nullptr};
   };
 
  private:
-  // removes an instance of key. if the count drops to 0, we remove the key
-  void remove(folly::StringPiece key) {
-    std::lock_guard<std::mutex> l(mutex_);
-    auto it = keys_.find(key);
-    if (it == keys_.end() || it->second == 0) {
+  FRIEND_TEST(TombStoneTest, HashCollision);
+
+  // a key hash and the guards of the tombstones for it. A slot without
+  // guards is free.
+  struct Slot {
+    uint64_t hash{0};
+    Guard* guards{nullptr};
+  };
+
+  static uint64_t hashKey(folly::StringPiece key) noexcept {
+    return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+  }
+
+  Guard add(folly::StringPiece key, uint64_t hash) {
+    if (key.size() > kMaxKeySize) {
+      throw std::invalid_argument(
+          fmt::format("Key too long for a tombstone: {}", key.size()));
+    }
+    Guard guard(key, hash, *this);
+    auto l = lock();
+    auto* slot = findSlot(key, hash);
+    if (slot == nullptr) {
+      slot = addSlot(hash);
+    }
+    guard.next_ = slot->guards;
+    if (slot->guards) {
+      slot->guards->prev_ = &guard;
+    }
+    slot->guards = &guard;
+    l.unlock();
+    return guard;
+  }
+
+  bool isPresent(folly::StringPiece key, uint64_t hash) {
+    auto l = lock();
+    return findSlot(key, hash) != nullptr;
+  }
+
+  // acquire the lock, counting the times it was held by someone else
+  std::unique_lock<std::mutex> lock() {
+    std::unique_lock<std::mutex> l(mutex_, std::try_to_lock);
+    if (!l.owns_lock()) {
+      numLockContended_.fetch_add(1, std::memory_order_relaxed);
+      l.lock();
+    }
+    return l;
+  }
+
+  // @return the slot of the key, nullptr if there is none. The hash is
+  //         compared first and the key only when the hashes match.
+  Slot* findSlot(folly::StringPiece key, uint64_t hash) {
+    for (auto& slot : slots_) {
+      if (slot.hash == hash && slot.guards && slot.guards->key() == key) {
+        return &slot;
+      }
+    }
+    for (auto& slot : overflow_) {
+      if (slot.hash == hash && slot.guards->key() == key) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+
+  // @return a free slot for the hash
+  Slot* addSlot(uint64_t hash) {
+    for (auto& slot : slots_) {
+      if (slot.guards == nullptr) {
+        slot.hash = hash;
+        return &slot;
+      }
+    }
+    // the overflow keeps its capacity, so this allocates only when the
+    // shard sees more keys in flight than it ever had before.
+    numOverflows_.fetch_add(1, std::memory_order_relaxed);
+    overflow_.push_back(Slot{hash, nullptr});
+    return &overflow_.back();
+  }
+
+  // @return the slot the guard is linked in
+  Slot& getSlot(const Guard& guard) {
+    auto* slot = findSlot(guard.key(), guard.hash_);
+    if (slot == nullptr) {
       // this is not supposed to happen if guards are destroyed appropriately
       throw std::runtime_error(fmt::format(
-          "Invalid state. Key: {}. State: {}", key,
-          it == keys_.end() ? "does not exist" : "exists, but count is 0"));
+          "Invalid state. Key: {}. State: does not exist", guard.key()));
+    }
+    return *slot;
+  }
+
+  // links the moved-to guard in place of the moved-from one
+  void replace(Guard& from, Guard& to) {
+    auto l = lock();
+    to.prev_ = from.prev_;
+    to.next_ = from.next_;
+    if (to.prev_) {
+      to.prev_->next_ = &to;
+    } else {
+      getSlot(from).guards = &to;
     }
+    if (to.next_) {
+      to.next_->prev_ = &to;
+    }
+    from.prev_ = from.next_ = nullptr;
+  }
+
+  // removes an instance of key. if no guard is left, we remove the key
+  void remove(Guard& guard) {
+    auto l = lock();
+    auto& slot = getSlot(guard);
+    if (guard.prev_) {
+      guard.prev_->next_ = guard.next_;
+    } else {
+      slot.guards = guard.next_;
+    }
+    if (guard.next_) {
+      guard.next_->prev_ = guard.prev_;
+    }
+    guard.prev_ = guard.next_ = nullptr;
 
-    if (--(it->second) == 0) {
-      keys_.erase(it);
+    // inline slots are freed by losing their last guard, overflow slots
+    // are removed.
+    const bool inOverflow = &slot >= overflow_.data() &&
+                            &slot < overflow_.data() + overflow_.size();
+    if (slot.guards == nullptr && inOverflow) {
+      slot = overflow_.back();
+      overflow_.pop_back();
     }
   }
 
-  // mutex protecting the map below
+  // mutex protecting the slots and the guard links
   std::mutex mutex_;
-  folly::F14NodeMap<std::string, uint64_t> keys_;
+  std::array<Slot, kInlineSlots> slots_{};
+  std::vector<Slot> overflow_;
+
+  std::atomic<uint64_t> numLockContended_{0};
+  std::atomic<uint64_t> numOverflows_{0};
 };
 
 } // namespace cachelib
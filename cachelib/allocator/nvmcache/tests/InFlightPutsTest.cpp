@@ -14,9 +14,11 @@
  * limitations under the License.
  */
 
+#include <folly/Format.h>
 #include <folly/Random.h>
 #include <gtest/gtest.h>
 
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -154,6 +156,40 @@ TEST(InFlightPutsTest, InvalidationAndCreate) {
   ASSERT_TRUE(token.executeIfValid(fn));
   ASSERT_TRUE(executed);
 }
+TEST(InFlightPutsTest, Overflow) {
+  InFlightPuts p;
+  const size_t nKeys = InFlightPuts::kInlineSlots * 4;
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < nKeys; i++) {
+    keys.push_back(folly::sformat("key_{}", i));
+  }
+
+  std::vector<InFlightPuts::PutToken> tokens;
+  for (const auto& key : keys) {
+    tokens.push_back(p.tryAcquireToken(key));
+    ASSERT_TRUE(tokens.back().isValid());
+    ASSERT_FALSE(p.tryAcquireToken(key).isValid());
+  }
+  EXPECT_EQ(nKeys - InFlightPuts::kInlineSlots, p.getNumOverflows());
+  EXPECT_EQ(0, p.getNumLockContended());
+
+  // invalidate every other put
+  for (size_t i = 0; i < nKeys; i += 2) {
+    p.invalidateToken(keys[i]);
+  }
+  for (size_t i = 0; i < nKeys; i++) {
+    bool executed = false;
+    EXPECT_EQ(i % 2 == 1,
+              tokens[i].executeIfValid([&]() { executed = true; }));
+    EXPECT_EQ(i % 2 == 1, executed);
+  }
+  tokens.clear();
+
+  for (const auto& key : keys) {
+    ASSERT_TRUE(p.tryAcquireToken(key).isValid());
+  }
+}
+
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
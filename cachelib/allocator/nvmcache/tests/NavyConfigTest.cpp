@@ -51,6 +51,8 @@ const uint32_t blockCacheCleanRegions = 4;
 const bool blockCacheDataChecksum = true;
 const std::vector<unsigned int> blockCacheSegmentedFifoSegmentRatio = {111, 222,
                                                                        333};
+const std::chrono::microseconds blockCacheReadMergeWindow{50};
+const uint32_t blockCacheReadaheadSize = 256 * 1024;
 
 class DummyReinsertionPolicy : public BlockCacheReinsertionPolicy {
  public:
@@ -67,6 +69,10 @@ const uint64_t bigHashSmallItemMaxSize = 512;
 
 const uint32_t maxConcurrentInserts = 50000;
 const uint64_t maxParcelMemoryMB = 512;
+const std::chrono::seconds checkpointInterval{30};
+const uint64_t checkpointLogSize = 16 * 1024 * 1024;
+const uint64_t negativeFilterSizeMB = 128;
+const uint32_t negativeFilterNumHashes = 6;
 
 // Job scheduler settings
 const unsigned int readerThreads = 40;
@@ -95,7 +101,8 @@ void setBlockCacheTestSettings(NavyConfig& config) {
       .enableHitsBasedReinsertion(blockCacheReinsertionHitsThreshold)
       .setCleanRegions(blockCacheCleanRegions)
       .setRegionSize(blockCacheRegionSize)
-      .setDataChecksum(blockCacheDataChecksum);
+      .setDataChecksum(blockCacheDataChecksum)
+      .enableReadMerging(blockCacheReadMergeWindow, blockCacheReadaheadSize);
 }
 
 void setBigHashTestSettings(NavyConfig& config) {
@@ -118,6 +125,8 @@ void setTestNavyConfig(NavyConfig& config) {
   setJobSchedulerTestSettings(config);
   config.setMaxConcurrentInserts(maxConcurrentInserts);
   config.setMaxParcelMemoryMB(maxParcelMemoryMB);
+  config.enableCheckpoints(checkpointInterval, checkpointLogSize);
+  config.enableNegativeFilter(negativeFilterSizeMB, negativeFilterNumHashes);
 }
 } // namespace
 TEST(NavyConfigTest, DefaultVal) {
@@ -138,6 +147,8 @@ TEST(NavyConfigTest, DefaultVal) {
   EXPECT_TRUE(blockCacheConfig.getSFifoSegmentRatio().empty());
   EXPECT_EQ(blockCacheConfig.getDataChecksum(), true);
   EXPECT_EQ(blockCacheConfig.getNumInMemBuffers(), 2);
+  EXPECT_FALSE(blockCacheConfig.isReadMergingEnabled());
+  EXPECT_EQ(blockCacheConfig.getReadaheadSize(), 0);
 
   const auto& bigHashConfig = config.bigHash();
   EXPECT_EQ(bigHashConfig.getBucketSize(), 4096);
@@ -193,14 +204,24 @@ TEST(NavyConfigTest, Serialization) {
   expectedConfigMap["navyConfig::blockCacheDataChecksum"] = "true";
   expectedConfigMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       "111,222,333";
+  expectedConfigMap["navyConfig::blockCacheReadMerging"] = "true";
+  expectedConfigMap["navyConfig::blockCacheReadMergeWindowUs"] = "50";
+  expectedConfigMap["navyConfig::blockCacheReadaheadSize"] = "262144";
 
   expectedConfigMap["navyConfig::bigHashSizePct"] = "50";
   expectedConfigMap["navyConfig::bigHashBucketSize"] = "1024";
   expectedConfigMap["navyConfig::bigHashBucketBfSize"] = "4";
   expectedConfigMap["navyConfig::bigHashSmallItemMaxSize"] = "512";
+  expectedConfigMap["navyConfig::bigHashMinSmallItemMaxSize"] = "0";
+  expectedConfigMap["navyConfig::bigHashMaxSmallItemMaxSize"] = "0";
+  expectedConfigMap["navyConfig::bigHashAdaptiveWindowSize"] = "0";
 
   expectedConfigMap["navyConfig::maxConcurrentInserts"] = "50000";
   expectedConfigMap["navyConfig::maxParcelMemoryMB"] = "512";
+  expectedConfigMap["navyConfig::checkpointIntervalSec"] = "30";
+  expectedConfigMap["navyConfig::checkpointLogSize"] = "16777216";
+  expectedConfigMap["navyConfig::negativeFilterSizeMB"] = "128";
+  expectedConfigMap["navyConfig::negativeFilterNumHashes"] = "6";
 
   expectedConfigMap["navyConfig::readerThreads"] = "40";
   expectedConfigMap["navyConfig::writerThreads"] = "40";
@@ -291,6 +312,14 @@ TEST(NavyConfigTest, BlockCache) {
   EXPECT_EQ(config.blockCache().getSFifoSegmentRatio(),
             blockCacheSegmentedFifoSegmentRatio);
 
+  // test read merging
+  config.blockCache().enableReadMerging(blockCacheReadMergeWindow,
+                                        blockCacheReadaheadSize);
+  EXPECT_TRUE(config.blockCache().isReadMergingEnabled());
+  EXPECT_EQ(config.blockCache().getReadMergeWindow(),
+            blockCacheReadMergeWindow);
+  EXPECT_EQ(config.blockCache().getReadaheadSize(), blockCacheReadaheadSize);
+
   auto customPolicy = std::make_shared<DummyReinsertionPolicy>();
 
   // test cannot enable both hits-based and probability-based reinsertion policy
@@ -354,6 +383,20 @@ TEST(NavyConfigTest, BigHash) {
   EXPECT_EQ(config.bigHash().getBucketSize(), bigHashBucketSize);
   EXPECT_EQ(config.bigHash().getBucketBfSize(), bigHashBucketBfSize);
   EXPECT_EQ(config.bigHash().getSmallItemMaxSize(), bigHashSmallItemMaxSize);
+  EXPECT_FALSE(config.bigHash().isAdaptiveSmallItemMaxSizeEnabled());
+
+  EXPECT_THROW(config.bigHash().enableAdaptiveSmallItemMaxSize(0, 1024, 100),
+               std::invalid_argument);
+  EXPECT_THROW(
+      config.bigHash().enableAdaptiveSmallItemMaxSize(1024, 512, 100),
+      std::invalid_argument);
+  EXPECT_THROW(config.bigHash().enableAdaptiveSmallItemMaxSize(256, 1024, 0),
+               std::invalid_argument);
+  config.bigHash().enableAdaptiveSmallItemMaxSize(256, 1024, 100);
+  EXPECT_TRUE(config.bigHash().isAdaptiveSmallItemMaxSizeEnabled());
+  EXPECT_EQ(config.bigHash().getMinSmallItemMaxSize(), 256);
+  EXPECT_EQ(config.bigHash().getMaxSmallItemMaxSize(), 1024);
+  EXPECT_EQ(config.bigHash().getAdaptiveWindowSize(), 100);
 }
 
 TEST(NavyConfigTest, JobScheduler) {
@@ -372,6 +415,26 @@ TEST(NavyConfigTest, OtherSettings) {
   config.setMaxParcelMemoryMB(maxParcelMemoryMB);
   EXPECT_EQ(config.getMaxConcurrentInserts(), maxConcurrentInserts);
   EXPECT_EQ(config.getMaxParcelMemoryMB(), maxParcelMemoryMB);
+
+  EXPECT_EQ(config.getCheckpointInterval().count(), 0);
+  EXPECT_EQ(config.getCheckpointLogSize(), 0);
+  EXPECT_THROW(config.enableCheckpoints(std::chrono::seconds{0}),
+               std::invalid_argument);
+  EXPECT_THROW(config.enableCheckpoints(checkpointInterval, 0),
+               std::invalid_argument);
+  config.enableCheckpoints(checkpointInterval, checkpointLogSize);
+  EXPECT_EQ(config.getCheckpointInterval(), checkpointInterval);
+  EXPECT_EQ(config.getCheckpointLogSize(), checkpointLogSize);
+
+  EXPECT_EQ(config.getNegativeFilterSizeMB(), 0);
+  EXPECT_THROW(config.enableNegativeFilter(0), std::invalid_argument);
+  EXPECT_THROW(config.enableNegativeFilter(negativeFilterSizeMB, 0),
+               std::invalid_argument);
+  EXPECT_THROW(config.enableNegativeFilter(negativeFilterSizeMB, 10),
+               std::invalid_argument);
+  config.enableNegativeFilter(negativeFilterSizeMB, negativeFilterNumHashes);
+  EXPECT_EQ(config.getNegativeFilterSizeMB(), negativeFilterSizeMB);
+  EXPECT_EQ(config.getNegativeFilterNumHashes(), negativeFilterNumHashes);
 }
 } // namespace tests
 } // namespace cachelib
@@ -16,8 +16,12 @@
 
 #include <folly/Random.h>
 #include <gtest/gtest.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#endif
 
 #include <climits>
+#include <cstring>
 #include <set>
 #include <thread>
 
@@ -231,6 +235,460 @@ TEST_F(NvmCacheTest, EvictToNvmGet) {
   ASSERT_EQ(0, nvm.getHandleCountForThread());
 }
 
+TEST_F(NvmCacheTest, FindAsync) {
+  // Disable bighash since we're only testing large items here
+  this->config_.bigHash().setSizePctAndMaxItemSize(0, 100);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->makeCache();
+
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  const auto evictBefore = this->evictionCount();
+  const int nKeys = 1024;
+  for (unsigned int i = 0; i < nKeys; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto it = nvm.allocate(pid, key, 15 * 1024);
+    ASSERT_NE(nullptr, it);
+    std::memcpy(it->getMemory(), key.data(), key.size());
+    nvm.insertOrReplace(it);
+    // flush periodically for the same reason as in EvictToNvmGet
+    if (i % 100 == 0) {
+      nvm.flushNvmCache();
+    }
+  }
+  nvm.flushNvmCache();
+
+  const auto nEvictions = this->evictionCount() - evictBefore;
+  ASSERT_LT(0, nEvictions);
+
+  // the first keys were evicted to nvm and are filled from there without
+  // blocking the caller
+  size_t numNotReady = 0;
+  for (unsigned int i = 0; i < std::min<uint64_t>(nEvictions, 10); i++) {
+    auto key = folly::sformat("key{}", i);
+    auto sf = nvm.findAsync(key);
+    if (!sf.isReady()) {
+      numNotReady++;
+    }
+    auto hdl = std::move(sf).get();
+    ASSERT_NE(nullptr, hdl) << key;
+    EXPECT_TRUE(hdl.wentToNvm());
+    EXPECT_EQ(key, folly::StringPiece(
+                       reinterpret_cast<const char*>(hdl->getMemory()),
+                       key.size()));
+  }
+  EXPECT_LT(0, numNotReady);
+
+  // items in RAM are returned right away
+  {
+    auto key = folly::sformat("key{}", nKeys - 1);
+    auto sf = nvm.findAsync(key);
+    ASSERT_TRUE(sf.isReady());
+    auto hdl = std::move(sf).get();
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_FALSE(hdl.wentToNvm());
+  }
+
+  EXPECT_EQ(nullptr, nvm.findAsync("missing").get());
+
+#if FOLLY_HAS_COROUTINES
+  {
+    auto key = folly::sformat("key{}", std::min<uint64_t>(nEvictions, 10));
+    auto hdl = folly::coro::blockingWait(nvm.co_find(key));
+    ASSERT_NE(nullptr, hdl) << key;
+    EXPECT_EQ(key, folly::StringPiece(
+                       reinterpret_cast<const char*>(hdl->getMemory()),
+                       key.size()));
+    EXPECT_EQ(nullptr, folly::coro::blockingWait(nvm.co_find("missing")));
+  }
+#endif
+
+  ASSERT_EQ(0, nvm.getNumActiveHandles());
+  ASSERT_EQ(0, nvm.getHandleCountForThread());
+}
+
+TEST_F(NvmCacheTest, FindBatch) {
+  // Disable bighash since we're only testing large items here
+  this->config_.bigHash().setSizePctAndMaxItemSize(0, 100);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->makeCache();
+
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  const auto evictBefore = this->evictionCount();
+  const int nKeys = 1024;
+  for (unsigned int i = 0; i < nKeys; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto it = nvm.allocate(pid, key, 15 * 1024);
+    ASSERT_NE(nullptr, it);
+    std::memcpy(it->getMemory(), key.data(), key.size());
+    nvm.insertOrReplace(it);
+    if (i % 100 == 0) {
+      nvm.flushNvmCache();
+    }
+  }
+  nvm.flushNvmCache();
+
+  const auto nEvictions = this->evictionCount() - evictBefore;
+  ASSERT_LT(10, nEvictions);
+
+  // items evicted one after the other sit next to each other on the device.
+  // Mix them with items in RAM, a duplicate and a key that does not exist.
+  std::vector<std::string> keyStrs;
+  for (unsigned int i = 0; i < 10; i++) {
+    keyStrs.push_back(folly::sformat("key{}", i));
+  }
+  keyStrs.push_back(folly::sformat("key{}", nKeys - 1));
+  keyStrs.push_back("key0");
+  keyStrs.push_back("missing");
+  std::vector<LruAllocator::Key> keys(keyStrs.begin(), keyStrs.end());
+
+  auto handles = nvm.findBatch(keys);
+  ASSERT_EQ(keys.size(), handles.size());
+  for (size_t i = 0; i + 1 < keys.size(); i++) {
+    auto& hdl = handles[i];
+    hdl.wait();
+    ASSERT_NE(nullptr, hdl) << keyStrs[i];
+    EXPECT_EQ(keyStrs[i] != keyStrs[10], hdl.wentToNvm()) << keyStrs[i];
+    EXPECT_EQ(keyStrs[i],
+              folly::StringPiece(
+                  reinterpret_cast<const char*>(hdl->getMemory()),
+                  keyStrs[i].size()));
+  }
+  handles.back().wait();
+  EXPECT_EQ(nullptr, handles.back());
+  handles.clear();
+
+  // the items are in RAM now
+  for (unsigned int i = 0; i < 10; i++) {
+    auto hdl = this->fetch(folly::sformat("key{}", i), true /* ramOnly */);
+    EXPECT_NE(nullptr, hdl);
+  }
+
+  auto rates = nvm.getNvmCacheStatsMap().getRates();
+  EXPECT_LE(1, rates["navy_bc_batch_lookups"]);
+  EXPECT_LT(0, rates["navy_bc_batch_merged_reads"]);
+
+  ASSERT_EQ(0, nvm.getNumActiveHandles());
+  ASSERT_EQ(0, nvm.getHandleCountForThread());
+}
+
+TEST_F(NvmCacheTest, WriteBackDeadlineFlush) {
+  this->config_.bigHash().setSizePctAndMaxItemSize(0, 100);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  // batches never fill up, so only the deadline submits the puts
+  nvmConfig.writeBackBatchSize = 4096;
+  nvmConfig.writeBackBufferSize = 4096;
+  nvmConfig.writeBackMaxDelay = std::chrono::milliseconds{10};
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->makeCache();
+
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  const auto evictBefore = this->evictionCount();
+  for (unsigned int i = 0; this->evictionCount() - evictBefore < 10; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto it = nvm.allocate(pid, key, 15 * 1024);
+    ASSERT_NE(nullptr, it);
+    nvm.insertOrReplace(it);
+  }
+
+  // no lookup or flush submits the staged puts
+  /* sleep override */
+  std::this_thread::sleep_for(std::chrono::milliseconds{200});
+  auto rates = nvm.getNvmCacheStatsMap().getRates();
+  EXPECT_LT(0, rates["nvm_writeback_staged"]);
+  EXPECT_LT(0, rates["nvm_writeback_batches"]);
+  EXPECT_LT(0, rates["nvm_writeback_deadline_flushes"]);
+}
+
+TEST_F(NvmCacheTest, WriteBackBatching) {
+  // Disable bighash so that all the puts go to BlockCache as batches
+  this->config_.bigHash().setSizePctAndMaxItemSize(0, 100);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  nvmConfig.writeBackBatchSize = 4;
+  nvmConfig.writeBackBufferSize = 64;
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->makeCache();
+
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  const auto evictBefore = this->evictionCount();
+  const int nKeys = 1024;
+  for (unsigned int i = 0; i < nKeys; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto it = nvm.allocate(pid, key, 15 * 1024);
+    ASSERT_NE(nullptr, it);
+    std::memcpy(it->getMemory(), key.data(), key.size());
+    nvm.insertOrReplace(it);
+  }
+  ASSERT_LT(10, this->evictionCount() - evictBefore);
+
+  // without flushing, the puts of the last evictions may still be staged.
+  // Finding them submits the staged puts before looking them up.
+  int nFound = 0;
+  for (unsigned int i = 0; i < nKeys; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto hdl = this->fetch(key, false /* ramOnly */);
+    hdl.wait();
+    if (hdl) {
+      nFound++;
+      EXPECT_EQ(key, folly::StringPiece(
+                         reinterpret_cast<const char*>(hdl->getMemory()),
+                         key.size()));
+    }
+  }
+  EXPECT_LT(10, nFound);
+
+  nvm.flushNvmCache();
+  auto rates = nvm.getNvmCacheStatsMap().getRates();
+  EXPECT_LT(0, rates["nvm_writeback_staged"]);
+  EXPECT_LT(0, rates["nvm_writeback_batches"]);
+  EXPECT_EQ(0, rates["nvm_writeback_dropped"]);
+  EXPECT_LT(0, rates["navy_bc_batch_inserts"]);
+  EXPECT_GE(rates["nvm_writeback_staged"], rates["navy_bc_batch_inserts"]);
+
+  ASSERT_EQ(0, nvm.getNumActiveHandles());
+  ASSERT_EQ(0, nvm.getHandleCountForThread());
+}
+
+TEST_F(NvmCacheTest, FrequencyPromotion) {
+  // Disable bighash since we're only testing large items here
+  this->config_.bigHash().setSizePctAndMaxItemSize(0, 100);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  // promote items on their second hit in nvm
+  nvmConfig.promotionPolicy =
+      std::make_shared<FrequencyPromotionPolicy>(2, 1000);
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->makeCache();
+
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  const auto evictBefore = this->evictionCount();
+  const int nKeys = 1024;
+  for (unsigned int i = 0; i < nKeys; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto it = nvm.allocate(pid, key, 15 * 1024);
+    ASSERT_NE(nullptr, it);
+    std::memcpy(it->getMemory(), key.data(), key.size());
+    nvm.insertOrReplace(it);
+    if (i % 100 == 0) {
+      nvm.flushNvmCache();
+    }
+  }
+  nvm.flushNvmCache();
+  ASSERT_LT(10, this->evictionCount() - evictBefore);
+
+  // the first hit is served without inserting the item into DRAM
+  {
+    auto hdl = this->fetch("key0", false /* ramOnly */);
+    hdl.wait();
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_TRUE(hdl.wentToNvm());
+    EXPECT_EQ("key0", folly::StringPiece(
+                          reinterpret_cast<const char*>(hdl->getMemory()), 4));
+    EXPECT_EQ(nullptr, this->fetch("key0", true /* ramOnly */));
+  }
+  EXPECT_EQ(nullptr, this->fetch("key0", true /* ramOnly */));
+
+  // the second one promotes it
+  {
+    auto hdl = this->fetch("key0", false /* ramOnly */);
+    hdl.wait();
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_TRUE(hdl.wentToNvm());
+  }
+  EXPECT_NE(nullptr, this->fetch("key0", true /* ramOnly */));
+
+  // a lookup for write always promotes
+  {
+    auto hdl = this->fetchToWrite("key1", false /* ramOnly */);
+    hdl.wait();
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_TRUE(hdl.wentToNvm());
+  }
+  EXPECT_NE(nullptr, this->fetch("key1", true /* ramOnly */));
+
+  auto rates = nvm.getNvmCacheStatsMap().getRates();
+  EXPECT_EQ(1, rates["nvm_transient_serves"]);
+  EXPECT_EQ(2, rates["nvm_promotions"]);
+  EXPECT_EQ(1, rates["nvm_promotion_freq_promoted"]);
+  EXPECT_EQ(2, rates["nvm_promotion_freq_rejected"]);
+
+  ASSERT_EQ(0, nvm.getNumActiveHandles());
+  ASSERT_EQ(0, nvm.getHandleCountForThread());
+}
+
+TEST_F(NvmCacheTest, TransientFillsReuseFreeMemory) {
+  this->config_.bigHash().setSizePctAndMaxItemSize(0, 100);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  // never promote
+  nvmConfig.promotionPolicy =
+      std::make_shared<FrequencyPromotionPolicy>(255, 1000);
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->makeCache();
+
+  auto& nvm = this->cache();
+  auto pid = this->poolId();
+
+  const int nKeys = 1024;
+  for (unsigned int i = 0; i < nKeys; i++) {
+    auto key = folly::sformat("key{}", i);
+    auto it = nvm.allocate(pid, key, 15 * 1024);
+    ASSERT_NE(nullptr, it);
+    nvm.insertOrReplace(it);
+    if (i % 100 == 0) {
+      nvm.flushNvmCache();
+    }
+  }
+  nvm.flushNvmCache();
+
+  // DRAM is full, so the first transient fill evicts. The next ones take the
+  // memory released by the previous one.
+  const auto evictBefore = this->evictionCount();
+  for (unsigned int i = 0; i < 3; i++) {
+    auto key = folly::sformat("key{}", i);
+    ASSERT_EQ(nullptr, this->fetch(key, true /* ramOnly */));
+    auto hdl = this->fetch(key, false /* ramOnly */);
+    hdl.wait();
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_TRUE(hdl.wentToNvm());
+  }
+  EXPECT_EQ(evictBefore + 1, this->evictionCount());
+
+  auto rates = nvm.getNvmCacheStatsMap().getRates();
+  EXPECT_EQ(3, rates["nvm_transient_serves"]);
+  EXPECT_EQ(1, rates["nvm_transient_evictions"]);
+
+  ASSERT_EQ(0, nvm.getNumActiveHandles());
+  ASSERT_EQ(0, nvm.getHandleCountForThread());
+}
+
+TEST_F(NvmCacheTest, ChainedItemsAlwaysPromote) {
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  // never promote plain items
+  nvmConfig.promotionPolicy =
+      std::make_shared<FrequencyPromotionPolicy>(255, 1000);
+  this->allocConfig_.enableNvmCache(nvmConfig);
+  this->getConfig().configureChainedItems();
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  std::string key = "foobar";
+  {
+    auto it = cache.allocate(pid, key, 1024);
+    ASSERT_NE(nullptr, it);
+    for (int i = 0; i < 4; i++) {
+      auto chainedIt = cache.allocateChainedItem(it, 512);
+      ASSERT_TRUE(chainedIt);
+      cache.addChainedItem(it, std::move(chainedIt));
+    }
+    cache.insertOrReplace(it);
+  }
+  this->pushToNvmCacheFromRamForTesting(key);
+  this->removeFromRamForTesting(key);
+
+  // two reads of the key in flight at once. Neither may leave a transient
+  // parent behind whose chain the other one links onto.
+  std::vector<WriteHandle> hdls(2);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < hdls.size(); i++) {
+    threads.emplace_back([&, i] {
+      hdls[i] = this->fetch(key, false /* ramOnly */);
+      hdls[i].wait();
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& hdl : hdls) {
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_EQ(4u, cache.viewAsChainedAllocs(hdl).computeChainLength());
+  }
+  hdls.clear();
+
+  EXPECT_NE(nullptr, this->fetch(key, true /* ramOnly */));
+  auto rates = cache.getNvmCacheStatsMap().getRates();
+  EXPECT_EQ(0, rates["nvm_transient_serves"]);
+
+  ASSERT_EQ(0, cache.getNumActiveHandles());
+  ASSERT_EQ(0, cache.getHandleCountForThread());
+}
+
+TEST_F(NvmCacheTest, SizeSplitMigrationKeepsItem) {
+  // the split starts at the BigHash max item size. One window of small
+  // items halves it, so the large item inserted first belongs in BlockCache
+  // afterwards and moves there when it is looked up.
+  constexpr uint64_t kWindow = 64;
+  this->config_.bigHash()
+      .setSizePctAndMaxItemSize(50, 2048)
+      .setBucketSize(4096)
+      .enableAdaptiveSmallItemMaxSize(128, 2048, kWindow);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig = config_;
+  this->allocConfig_.enableNvmCache(nvmConfig);
+
+  std::atomic<int> numDestructed{0};
+  this->allocConfig_.setRemoveCallback({});
+  this->allocConfig_.setItemDestructor([&](const DestructorData& data) {
+    if (data.context == DestructorContext::kRemovedFromNVM ||
+        data.context == DestructorContext::kEvictedFromNVM) {
+      ++numDestructed;
+    }
+  });
+  auto& nvm = this->makeCache();
+  auto pid = this->poolId();
+
+  auto insertToNvm = [&](const std::string& key, uint32_t size) {
+    auto it = nvm.allocate(pid, key, size);
+    ASSERT_NE(nullptr, it);
+    std::memcpy(it->getMemory(), key.data(), key.size());
+    nvm.insertOrReplace(it);
+    ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key));
+    this->removeFromRamForTesting(key);
+  };
+  insertToNvm("large", 1500);
+  for (uint64_t i = 1; i < kWindow; i++) {
+    insertToNvm(folly::sformat("small{}", i), 100);
+  }
+  nvm.flushNvmCache();
+  auto counts = nvm.getNvmCacheStatsMap().getCounts();
+  ASSERT_EQ(1024, counts["navy_split_threshold"]);
+
+  numDestructed = 0;
+  for (int i = 0; i < 2; i++) {
+    auto hdl = this->fetch("large", false /* ramOnly */);
+    hdl.wait();
+    ASSERT_NE(nullptr, hdl);
+    EXPECT_EQ("large", folly::StringPiece(
+                           reinterpret_cast<const char*>(hdl->getMemory()), 5));
+    hdl.reset();
+    // the second lookup finds the item in BlockCache
+    nvm.flushNvmCache();
+    this->removeFromRamForTesting("large");
+  }
+  EXPECT_EQ(0, numDestructed);
+  auto rates = nvm.getNvmCacheStatsMap().getRates();
+  EXPECT_EQ(1, rates["navy_split_migrations"]);
+
+  ASSERT_EQ(0, nvm.getNumActiveHandles());
+  ASSERT_EQ(0, nvm.getHandleCountForThread());
+}
+
 TEST_F(NvmCacheTest, EvictToNvmGetCheckCtime) {
   auto& nvm = this->cache();
   auto pid = this->poolId();
@@ -1572,7 +2030,12 @@ TEST_F(NvmCacheTest, NavyStats) {
   EXPECT_TRUE(cs("navy_bc_inserts"));
   EXPECT_TRUE(cs("navy_bc_insert_hash_collisions"));
   EXPECT_TRUE(cs("navy_bc_succ_inserts"));
+  EXPECT_TRUE(cs("navy_bc_batch_inserts"));
+  EXPECT_TRUE(cs("navy_bc_batch_inserted_items"));
   EXPECT_TRUE(cs("navy_bc_lookups"));
+  EXPECT_TRUE(cs("navy_bc_batch_lookups"));
+  EXPECT_TRUE(cs("navy_bc_batch_reads"));
+  EXPECT_TRUE(cs("navy_bc_batch_merged_reads"));
   EXPECT_TRUE(cs("navy_bc_lookup_false_positives"));
   EXPECT_TRUE(cs("navy_bc_lookup_entry_header_checksum_errors"));
   EXPECT_TRUE(cs("navy_bc_lookup_value_checksum_errors"));
@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <random>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -120,6 +121,74 @@ TEST(TombStoneTest, Move) {
   ASSERT_FALSE(t.isPresent(key));
 }
 
+TEST(TombStoneTest, Overflow) {
+  TombStones t;
+  const size_t nKeys = TombStones::kInlineSlots * 4;
+  std::vector<TombStones::Guard> guards;
+  for (size_t i = 0; i < nKeys; i++) {
+    guards.push_back(t.add(std::to_string(i)));
+  }
+  for (size_t i = 0; i < nKeys; i++) {
+    ASSERT_TRUE(t.isPresent(std::to_string(i)));
+  }
+  EXPECT_EQ(nKeys - TombStones::kInlineSlots, t.getNumOverflows());
+
+  // release from the middle so that both inline and overflow slots free up
+  for (size_t i = nKeys / 2; i < nKeys; i++) {
+    guards[i] = TombStones::Guard{};
+    ASSERT_FALSE(t.isPresent(std::to_string(i)));
+  }
+  for (size_t i = 0; i < nKeys / 2; i++) {
+    ASSERT_TRUE(t.isPresent(std::to_string(i)));
+  }
+  guards.clear();
+  for (size_t i = 0; i < nKeys; i++) {
+    ASSERT_FALSE(t.isPresent(std::to_string(i)));
+  }
+}
+
+TEST(TombStoneTest, GuardOwnsKey) {
+  TombStones t;
+  TombStones::Guard guard;
+  {
+    std::string key(TombStones::kMaxKeySize, 'a');
+    guard = t.add(key);
+    key.assign(key.size(), 'b');
+  }
+  EXPECT_EQ(std::string(TombStones::kMaxKeySize, 'a'), guard.key());
+  EXPECT_TRUE(t.isPresent(guard.key()));
+
+  EXPECT_THROW(t.add(std::string(TombStones::kMaxKeySize + 1, 'a')),
+               std::invalid_argument);
+}
+
 } // namespace tests
+
+// Outside of the tests namespace so that it can be a friend of TombStones
+TEST(TombStoneTest, HashCollision) {
+  TombStones t;
+  // two keys recorded under the same hash
+  auto a = t.add("a", 1);
+  auto b1 = t.add("b", 1);
+  auto b2 = t.add("b", 1);
+  EXPECT_EQ(0, t.getNumOverflows());
+  EXPECT_TRUE(t.isPresent("a", 1));
+  EXPECT_TRUE(t.isPresent("b", 1));
+  EXPECT_FALSE(t.isPresent("c", 1));
+
+  {
+    auto moved = std::move(a);
+    EXPECT_TRUE(t.isPresent("a", 1));
+  }
+  EXPECT_FALSE(t.isPresent("a", 1));
+  EXPECT_TRUE(t.isPresent("b", 1));
+
+  // the key is still compared once its first guard is gone
+  b2 = TombStones::Guard{};
+  EXPECT_TRUE(t.isPresent("b", 1));
+  EXPECT_FALSE(t.isPresent("c", 1));
+  b1 = TombStones::Guard{};
+  EXPECT_FALSE(t.isPresent("b", 1));
+}
 } // namespace cachelib
 } // namespace facebook
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+namespace {
+std::vector<uint32_t> makeSamples(const std::vector<uint32_t>& sizes,
+                                  size_t numEach) {
+  std::vector<uint32_t> samples;
+  for (const auto size : sizes) {
+    samples.insert(samples.end(), numEach, size);
+  }
+  return samples;
+}
+} // namespace
+
+TEST(AllocClassOptimizerTest, InvalidArgs) {
+  const auto samples = makeSamples({100, 200}, 10);
+  EXPECT_THROW(AllocClassOptimizer::computeAllocSizes(samples, 0, Slab::kSize),
+               std::invalid_argument);
+  EXPECT_THROW(AllocClassOptimizer::computeAllocSizes(samples, 4, 0),
+               std::invalid_argument);
+  EXPECT_THROW(
+      AllocClassOptimizer::computeAllocSizes(samples, 4, Slab::kSize + 1),
+      std::invalid_argument);
+}
+
+TEST(AllocClassOptimizerTest, FitsDistinctSizes) {
+  const uint32_t maxAllocSize = 1024 * 1024;
+  const auto samples = makeSamples({104, 1000, 5000}, 100);
+  const auto sizes =
+      AllocClassOptimizer::computeAllocSizes(samples, 8, maxAllocSize);
+
+  // the largest size is always kept and every sample has an aligned class
+  // that fits it within the slack of its slab.
+  ASSERT_FALSE(sizes.empty());
+  EXPECT_EQ(maxAllocSize, *sizes.rbegin());
+  for (const auto sample : {104u, 1000u, 5000u}) {
+    auto it = sizes.lower_bound(sample);
+    ASSERT_NE(sizes.end(), it);
+    EXPECT_EQ(Slab::kSize / sample, Slab::kSize / *it);
+  }
+  for (const auto size : sizes) {
+    EXPECT_EQ(0, size % MemoryAllocator::kAlignment);
+    EXPECT_GE(size, Slab::kMinAllocSize);
+  }
+}
+
+TEST(AllocClassOptimizerTest, RespectsNumClasses) {
+  std::vector<uint32_t> samples;
+  for (uint32_t size = 100; size < 20000; size += 8) {
+    samples.push_back(size);
+  }
+  for (unsigned int numClasses : {1u, 2u, 5u, 20u}) {
+    const auto sizes =
+        AllocClassOptimizer::computeAllocSizes(samples, numClasses, 20000);
+    EXPECT_LE(sizes.size(), numClasses);
+    EXPECT_EQ(20000, *sizes.rbegin());
+  }
+
+  // more classes never waste more.
+  double prevWaste = std::numeric_limits<double>::max();
+  for (unsigned int numClasses : {1u, 2u, 5u, 20u, 40u}) {
+    const auto sizes =
+        AllocClassOptimizer::computeAllocSizes(samples, numClasses, 20000);
+    const auto waste = AllocClassOptimizer::expectedWaste(
+        samples, std::vector<uint32_t>(sizes.begin(), sizes.end()));
+    EXPECT_LE(waste, prevWaste);
+    prevWaste = waste;
+  }
+}
+
+TEST(AllocClassOptimizerTest, BeatsStaticFactor) {
+  // sizes clustered in between the classes generated by a 1.25 factor
+  std::vector<uint32_t> samples;
+  for (uint32_t i = 0; i < 1000; i++) {
+    samples.push_back(300 + i % 16);
+    samples.push_back(2100 + i % 32);
+    samples.push_back(9000 + i % 64);
+  }
+  const auto staticSizes = MemoryAllocator::generateAllocSizes(
+      1.25, Slab::kSize, 72, true /* reduceFragmentation */);
+  const auto tuned = AllocClassOptimizer::computeAllocSizes(
+      samples, static_cast<unsigned int>(staticSizes.size()), Slab::kSize);
+
+  const auto staticWaste = AllocClassOptimizer::expectedWaste(
+      samples, std::vector<uint32_t>(staticSizes.begin(), staticSizes.end()));
+  const auto tunedWaste = AllocClassOptimizer::expectedWaste(
+      samples, std::vector<uint32_t>(tuned.begin(), tuned.end()));
+  EXPECT_LT(tunedWaste, staticWaste / 2);
+}
+
+TEST(AllocClassTunerTest, ReconfigurePool) {
+  LruAllocator::Config config;
+  config.setCacheSize(20 * Slab::kSize);
+  LruAllocator alloc(config);
+  const auto pid = alloc.addPool(
+      "default", alloc.getCacheMemoryStats().ramCacheSize, {1024, 4096});
+
+  const uint32_t valSize = 500;
+  const auto requiredSize = LruAllocator::Item::getRequiredSize(
+      folly::sformat("key_{:06d}", 0), valSize);
+  for (int i = 0; i < 1000; i++) {
+    auto handle = alloc.allocate(pid, folly::sformat("key_{:06d}", i), valSize);
+    ASSERT_NE(nullptr, handle);
+    alloc.insertOrReplace(handle);
+  }
+  const auto& pool = alloc.getPool(pid);
+  const auto oldCid = pool.getAllocationClassId(requiredSize);
+
+  // the largest class can not shrink
+  EXPECT_THROW(alloc.reconfigurePoolAllocSizes(pid, {1024}),
+               std::invalid_argument);
+  EXPECT_THROW(alloc.reconfigurePoolAllocSizes(pid, {}),
+               std::invalid_argument);
+
+  const uint32_t newSize = util::getAlignedSize(
+      requiredSize, static_cast<uint32_t>(MemoryAllocator::kAlignment));
+  alloc.reconfigurePoolAllocSizes(pid, {newSize, 4096});
+  EXPECT_FALSE(pool.isActiveAllocationClass(oldCid));
+  const auto newCid = pool.getAllocationClassId(requiredSize);
+  EXPECT_NE(oldCid, newCid);
+  EXPECT_EQ(newSize, pool.getAllocationClass(newCid).getAllocSize());
+
+  // items from before stay readable and new ones go to the new class
+  for (int i = 0; i < 1000; i++) {
+    EXPECT_NE(nullptr, alloc.find(folly::sformat("key_{:06d}", i)));
+  }
+  auto handle = alloc.allocate(pid, folly::sformat("key_{:06d}", 1000),
+                               valSize);
+  ASSERT_NE(nullptr, handle);
+  EXPECT_EQ(newCid, alloc.getAllocInfo(handle->getMemory()).classId);
+}
+
+TEST(AllocClassTunerTest, MovesItemsOutOfRetiredClass) {
+  LruAllocator::Config config;
+  config.setCacheSize(20 * Slab::kSize);
+  config.enableMovingOnSlabRelease(
+      [](LruAllocator::Item& oldItem, LruAllocator::Item& newItem,
+         LruAllocator::Item* /* parentItem */) {
+        std::memcpy(newItem.getMemory(), oldItem.getMemory(),
+                    oldItem.getSize());
+      });
+  LruAllocator alloc(config);
+  const auto pid = alloc.addPool(
+      "default", alloc.getCacheMemoryStats().ramCacheSize, {1024, 4096});
+
+  const uint32_t valSize = 500;
+  const auto requiredSize = LruAllocator::Item::getRequiredSize(
+      folly::sformat("key_{:06d}", 0), valSize);
+  for (int i = 0; i < 1000; i++) {
+    const auto key = folly::sformat("key_{:06d}", i);
+    auto handle = alloc.allocate(pid, key, valSize);
+    ASSERT_NE(nullptr, handle);
+    std::memcpy(handle->getMemory(), key.data(), key.size());
+    alloc.insertOrReplace(handle);
+  }
+  const auto& pool = alloc.getPool(pid);
+  const auto oldCid = pool.getAllocationClassId(requiredSize);
+
+  const uint32_t newSize = util::getAlignedSize(
+      requiredSize, static_cast<uint32_t>(MemoryAllocator::kAlignment));
+  alloc.reconfigurePoolAllocSizes(pid, {newSize, 4096});
+  const auto newCid = pool.getAllocationClassId(requiredSize);
+
+  // the items move to the new class, which has its own MM container
+  while (pool.getAllocationClass(oldCid).getNumSlabs() > 0) {
+    AllocClassTunerAPIWrapper<LruAllocator>::releaseSlab(alloc, pid, oldCid);
+  }
+  for (int i = 0; i < 1000; i++) {
+    const auto key = folly::sformat("key_{:06d}", i);
+    auto handle = alloc.find(key);
+    ASSERT_NE(nullptr, handle);
+    EXPECT_EQ(newCid, alloc.getAllocInfo(handle->getMemory()).classId);
+    EXPECT_EQ(key, folly::StringPiece(
+                       reinterpret_cast<const char*>(handle->getMemory()),
+                       key.size()));
+  }
+  EXPECT_EQ(1000u, alloc.getPoolStats(pid).numItems());
+}
+
+TEST(AllocClassTunerTest, TunesPoolInBackground) {
+  LruAllocator::Config config;
+  config.setCacheSize(40 * Slab::kSize);
+  AllocClassTunerConfig tunerConfig;
+  tunerConfig.sampleRate = 1;
+  tunerConfig.minSamples = 1000;
+  tunerConfig.slabsPerIteration = 4;
+  config.enableAllocClassTuning(std::chrono::milliseconds{10}, tunerConfig);
+  LruAllocator alloc(config);
+  const auto pid =
+      alloc.addPool("default", alloc.getCacheMemoryStats().ramCacheSize);
+
+  // values whose sizes fall in between the default classes
+  const std::vector<uint32_t> valSizes = {1700, 7300};
+  int numAllocs = 0;
+  auto fill = [&](int num) {
+    for (int i = 0; i < num; i++, numAllocs++) {
+      const auto valSize = valSizes[numAllocs % valSizes.size()];
+      auto handle =
+          alloc.allocate(pid, folly::sformat("key_{:08d}", numAllocs), valSize);
+      if (handle) {
+        alloc.insertOrReplace(handle);
+      }
+    }
+  };
+
+  fill(5000);
+  for (int i = 0; i < 200; i++) {
+    if (alloc.getAllocClassTunerStats().numReconfigurations > 0) {
+      break;
+    }
+    fill(100);
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  const auto& pool = alloc.getPool(pid);
+  auto hasRetiredSlabs = [&]() {
+    for (ClassId cid = 0;
+         static_cast<unsigned int>(cid) < pool.getNumClassId(); cid++) {
+      if (!pool.isActiveAllocationClass(cid) &&
+          pool.getAllocationClass(cid).getNumSlabs() > 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+  for (int i = 0; i < 500 && hasRetiredSlabs(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+
+  const auto stats = alloc.getGlobalCacheStats().allocClassTunerStats;
+  EXPECT_GE(stats.numReconfigurations, 1);
+  EXPECT_GT(stats.numSlabsReleased, 0);
+  EXPECT_EQ(0, stats.numSlabReleaseErrors);
+  EXPECT_LT(stats.lastWastePerAllocAfter, stats.lastWastePerAllocBefore);
+  EXPECT_FALSE(hasRetiredSlabs());
+
+  // every value now lands in a class that fits it tightly
+  for (const auto valSize : valSizes) {
+    const auto requiredSize = LruAllocator::Item::getRequiredSize(
+        folly::sformat("key_{:08d}", 0), valSize);
+    const auto cid = pool.getAllocationClassId(requiredSize);
+    const auto allocSize = pool.getAllocationClass(cid).getAllocSize();
+    EXPECT_EQ(Slab::kSize / requiredSize, Slab::kSize / allocSize);
+  }
+  EXPECT_TRUE(alloc.stopAllocClassTuner());
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
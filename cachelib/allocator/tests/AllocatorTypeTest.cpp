@@ -121,6 +121,7 @@ TYPED_TEST(BaseAllocatorTest, SerializationMMConfig) {
   this->testSerializationMMConfig();
 }
 
+
 TYPED_TEST(BaseAllocatorTest, testSerializationWithFragmentation) {
   this->testSerializationWithFragmentation();
 }
@@ -50,6 +50,31 @@ TEST_F(CacheAllocatorConfigTest, MultipleTier1Config) {
   config.validateMemoryTiers();
 }
 
+TEST_F(CacheAllocatorConfigTest, MultipleTier2Config) {
+  AllocatorT::Config config;
+  // Accepts a DRAM tier on top of a file-backed tier
+  config.setCacheSize(defaultTotalSize)
+      .configureMemoryTiers(
+          {MemoryTierCacheConfig::fromShm().setRatio(1),
+           MemoryTierCacheConfig::fromFile("/tmp/tier1").setRatio(2)});
+  config.validateMemoryTiers();
+  EXPECT_TRUE(config.getMemoryTierConfigs()[1].isFileBacked());
+}
+
+TEST_F(CacheAllocatorConfigTest, MultipleTierPersistence) {
+  AllocatorT::Config config;
+  // Throws if multiple tiers are combined with persistence
+  config.setCacheSize(defaultTotalSize)
+      .enableCachePersistence("/tmp/cache-dir")
+      .configureMemoryTiers({MemoryTierCacheConfig::fromShm().setRatio(1),
+                             MemoryTierCacheConfig::fromShm().setRatio(1)});
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+}
+
+TEST_F(CacheAllocatorConfigTest, FileTierEmptyPath) {
+  EXPECT_THROW(MemoryTierCacheConfig::fromFile(""), std::invalid_argument);
+}
+
 TEST_F(CacheAllocatorConfigTest, InvalidTierRatios) {
   AllocatorT::Config config;
   EXPECT_THROW(config.configureMemoryTiers(generateTierConfigs(
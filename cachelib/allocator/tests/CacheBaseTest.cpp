@@ -45,6 +45,13 @@ class CacheBaseTest : public CacheBase, public SlabAllocatorTestBase {
       const override {
     return {};
   }
+  std::unordered_map<std::string, uint64_t> getKeyPrefixStatsMap()
+      const override {
+    return {};
+  }
+  PoolMissRatioCurve getPoolMissRatioCurve(PoolId) const override {
+    return {};
+  }
   CacheMetadata getCacheMetadata() const noexcept override { return {}; }
   GlobalCacheStats getGlobalCacheStats() const override { return {}; }
   SlabReleaseStats getSlabReleaseStats() const override { return {}; }
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <folly/Format.h>
+
 #include <future>
 #include <mutex>
 #include <thread>
@@ -202,5 +204,46 @@ TEST(ItemTest, ToString) {
       new (buffer) ChainedItem(dummyCompressedPtr, valueSize, now);
   chainedItem->toString();
 }
+
+TEST(ItemTest, CompactFIFOHookLayout) {
+  using SieveItem = SieveAllocator::Item;
+  using SieveCompactItem = SieveCompactAllocator::Item;
+  using ClockCompactItem = ClockCompactAllocator::Item;
+  static_assert(32 == sizeof(SieveItem), "default item is 32 bytes");
+  static_assert(28 == sizeof(SieveCompactItem), "compact item is 28 bytes");
+  static_assert(28 == sizeof(ClockCompactItem), "compact item is 28 bytes");
+
+  constexpr uint32_t bufferSize = 100;
+  char buffer[bufferSize];
+  const uint32_t valueSize = bufferSize / 2;
+  const folly::StringPiece key = "helloworld";
+  const uint32_t now = util::getCurrentTimeSec();
+
+  auto item = new (buffer) SieveCompactItem(key, valueSize, now, 0);
+  ASSERT_EQ(key, item->getKey());
+  ASSERT_EQ(now, item->getCreationTime());
+  ASSERT_EQ(valueSize, item->getSize());
+}
+
+TEST(ItemTest, CompactFIFOHookAllocator) {
+  SieveCompactAllocator::Config config;
+  config.setCacheSize(10 * Slab::kSize);
+  SieveCompactAllocator alloc(config);
+  const auto pid =
+      alloc.addPool("default", alloc.getCacheMemoryStats().ramCacheSize);
+
+  // overfill the pool so that items get evicted through the compact hook.
+  const uint32_t valSize = 1000;
+  const size_t numItems = 20 * Slab::kSize / valSize;
+  for (size_t i = 0; i < numItems; i++) {
+    auto handle = alloc.allocate(pid, folly::sformat("key_{}", i), valSize);
+    ASSERT_NE(nullptr, handle);
+    alloc.insertOrReplace(handle);
+  }
+  EXPECT_NE(nullptr, alloc.find(folly::sformat("key_{}", numItems - 1)));
+
+  const auto stats = alloc.getPoolStats(pid);
+  EXPECT_GT(stats.numEvictions(), 0);
+}
 } // namespace cachelib
 } // namespace facebook
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+#include "cachelib/allocator/KeyPrefixStats.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+namespace {
+KeyPrefixStatsConfig makeConfig(size_t maxPrefixes) {
+  KeyPrefixStatsConfig config;
+  config.prefixExtractor = KeyPrefixStatsConfig::delimiterExtractor(':');
+  config.maxPrefixes = maxPrefixes;
+  return config;
+}
+} // namespace
+
+TEST(KeyPrefixStatsTest, InvalidConfig) {
+  EXPECT_THROW(KeyPrefixStats{KeyPrefixStatsConfig{}}, std::invalid_argument);
+  EXPECT_THROW(KeyPrefixStats{makeConfig(0)}, std::invalid_argument);
+}
+
+TEST(KeyPrefixStatsTest, Counters) {
+  KeyPrefixStats stats{makeConfig(8)};
+  stats.recordGet("a:1", true);
+  stats.recordGet("a:2", false);
+  stats.recordMiss("a:1");
+  stats.recordAllocation("a:3", 100);
+  stats.recordAllocation("b:1", 50);
+  stats.recordEviction("b:1");
+  // keys without a prefix are not accounted
+  stats.recordGet("nodelimiter", true);
+
+  auto result = stats.getStats();
+  ASSERT_EQ(2, result.size());
+  EXPECT_EQ(2, result["a"].gets);
+  EXPECT_EQ(2, result["a"].misses);
+  EXPECT_EQ(1, result["a"].allocs);
+  EXPECT_EQ(100, result["a"].allocBytes);
+  EXPECT_EQ(0, result["a"].evictions);
+  EXPECT_EQ(0, result["b"].gets);
+  EXPECT_EQ(50, result["b"].allocBytes);
+  EXPECT_EQ(1, result["b"].evictions);
+
+  auto statsMap = stats.getStatsMap();
+  EXPECT_EQ(2, statsMap["a.gets"]);
+  EXPECT_EQ(1, statsMap["b.evictions"]);
+}
+
+TEST(KeyPrefixStatsTest, LongPrefixesAreTruncated) {
+  KeyPrefixStats stats{makeConfig(8)};
+  const std::string prefix(2 * KeyPrefixStats::kMaxPrefixLen, 'x');
+  stats.recordGet(prefix + ":a", true);
+  stats.recordGet(prefix + "y:b", true);
+
+  auto result = stats.getStats();
+  ASSERT_EQ(1, result.size());
+  EXPECT_EQ(2, result[prefix.substr(0, KeyPrefixStats::kMaxPrefixLen)].gets);
+}
+
+TEST(KeyPrefixStatsTest, KeepsHeavyPrefixes) {
+  KeyPrefixStats stats{makeConfig(4)};
+  // a few heavy prefixes among many light ones
+  for (int i = 0; i < 1000; i++) {
+    for (int heavy = 0; heavy < 3; heavy++) {
+      stats.recordGet(folly::sformat("heavy{}:k", heavy), true);
+    }
+    stats.recordGet(folly::sformat("light{}:k", i), true);
+  }
+
+  auto result = stats.getStats();
+  EXPECT_LE(result.size(), 5);
+  uint64_t total = 0;
+  for (const auto& [prefix, counters] : result) {
+    total += counters.gets;
+  }
+  // every get is accounted, under its prefix or the other prefix
+  EXPECT_EQ(4000, total);
+  for (int heavy = 0; heavy < 3; heavy++) {
+    EXPECT_EQ(1000, result[folly::sformat("heavy{}", heavy)].gets);
+  }
+  EXPECT_GT(result[KeyPrefixStats::kOtherPrefix.str()].gets, 0);
+}
+
+TEST(KeyPrefixStatsTest, ThreadsThatExit) {
+  KeyPrefixStats stats{makeConfig(4)};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&stats, t]() {
+      for (int i = 0; i < 100; i++) {
+        stats.recordGet("shared:k", true);
+        stats.recordGet(folly::sformat("thread{}:k", t), false);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  auto result = stats.getStats();
+  EXPECT_LE(result.size(), 5);
+  EXPECT_EQ(800, result["shared"].gets);
+  uint64_t misses = 0;
+  for (const auto& [prefix, counters] : result) {
+    misses += counters.misses;
+  }
+  EXPECT_EQ(800, misses);
+}
+
+TEST(KeyPrefixStatsTest, CacheAllocator) {
+  LruAllocator::Config config;
+  config.setCacheSize(10 * Slab::kSize);
+  config.enableKeyPrefixStats(makeConfig(8));
+  LruAllocator alloc(config);
+  const auto pid =
+      alloc.addPool("default", alloc.getCacheMemoryStats().ramCacheSize);
+
+  // fill the cache with one tenant and push it out with another
+  for (int i = 0; i < 40000; i++) {
+    auto handle = alloc.allocate(pid, folly::sformat("a:{}", i), 1000);
+    ASSERT_NE(nullptr, handle);
+    alloc.insertOrReplace(handle);
+  }
+  for (int i = 0; i < 40000; i++) {
+    auto handle = alloc.allocate(pid, folly::sformat("b:{}", i), 1000);
+    ASSERT_NE(nullptr, handle);
+    alloc.insertOrReplace(handle);
+  }
+  EXPECT_NE(nullptr, alloc.find("b:39999"));
+  EXPECT_EQ(nullptr, alloc.find("a:0"));
+  EXPECT_EQ(nullptr, alloc.find("c:0"));
+
+  auto result = alloc.getKeyPrefixStats();
+  EXPECT_EQ(40000, result["a"].allocs);
+  EXPECT_EQ(40000 * 1000, result["a"].allocBytes);
+  EXPECT_GT(result["a"].evictions, 0);
+  EXPECT_EQ(1, result["a"].gets);
+  EXPECT_EQ(1, result["a"].misses);
+  EXPECT_EQ(1, result["b"].gets);
+  EXPECT_EQ(0, result["b"].misses);
+  EXPECT_EQ(1, result["c"].misses);
+
+  EXPECT_EQ(40000, alloc.getKeyPrefixStatsMap()["a.allocs"]);
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
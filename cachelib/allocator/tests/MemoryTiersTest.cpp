@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+template <typename AllocatorT>
+class MemoryTiersTest : public testing::Test {
+ public:
+  MemoryTiersTest() : cacheDir_(util::getUniqueTempDir("MemoryTiersTest")) {
+    util::makeDir(cacheDir_);
+  }
+
+  ~MemoryTiersTest() override {
+    try {
+      util::removePath(cacheDir_);
+    } catch (...) {
+    }
+  }
+
+ protected:
+  // two tiers of equal size: the top one on the heap and the lower one
+  // backed by a file.
+  typename AllocatorT::Config makeConfig() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(kNumSlabs * Slab::kSize)
+        .configureMemoryTiers(
+            {MemoryTierCacheConfig::fromShm().setRatio(1),
+             MemoryTierCacheConfig::fromFile(cacheDir_ + "/tier1")
+                 .setRatio(1)});
+    return config;
+  }
+
+  // fill the cache with more items than the top tier can hold and return
+  // the keys in insertion order.
+  std::vector<std::string> fill(AllocatorT& alloc, PoolId pid) {
+    std::vector<std::string> keys;
+    const size_t numItems = 2 * kNumSlabs * Slab::kSize / kValSize;
+    for (size_t i = 0; i < numItems; i++) {
+      auto key = folly::sformat("key_{}", i);
+      auto handle = alloc.allocate(pid, key, kValSize);
+      if (!handle) {
+        continue;
+      }
+      std::memset(handle->getMemory(), static_cast<int>(i & 0xff), kValSize);
+      alloc.insertOrReplace(handle);
+      keys.push_back(std::move(key));
+    }
+    return keys;
+  }
+
+  static constexpr size_t kNumSlabs = 20;
+  static constexpr size_t kValSize = 4000;
+
+  const std::string cacheDir_;
+};
+
+using LruMemoryTiersTest = MemoryTiersTest<LruAllocator>;
+
+TEST_F(LruMemoryTiersTest, DemoteOnEviction) {
+  auto config = makeConfig();
+  LruAllocator alloc(config);
+  ASSERT_EQ(2u, alloc.getNumTiers());
+
+  const size_t poolSize = alloc.getCacheMemoryStats().ramCacheSize;
+  const auto pid = alloc.addPool("default", poolSize);
+  const auto keys = fill(alloc, pid);
+  ASSERT_FALSE(keys.empty());
+
+  const auto stats = alloc.getGlobalCacheStats();
+  EXPECT_GT(stats.numTierDemotions, 0);
+
+  // items that were demoted rather than evicted are still readable and
+  // keep their contents.
+  size_t numFound = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto handle = alloc.find(keys[i]);
+    if (!handle) {
+      continue;
+    }
+    ++numFound;
+    const auto* data =
+        reinterpret_cast<const uint8_t*>(handle->getMemory());
+    EXPECT_EQ(static_cast<uint8_t>(std::stoul(keys[i].substr(4)) & 0xff),
+              data[0]);
+    EXPECT_EQ(data[0], data[kValSize - 1]);
+  }
+  EXPECT_GT(numFound, stats.numTierDemotions / 2);
+}
+
+TEST_F(LruMemoryTiersTest, PromoteOnHit) {
+  auto config = makeConfig();
+  config.enablePromotionOnHit();
+  LruAllocator alloc(config);
+
+  const size_t poolSize = alloc.getCacheMemoryStats().ramCacheSize;
+  const auto pid = alloc.addPool("default", poolSize);
+  const auto keys = fill(alloc, pid);
+
+  // the oldest surviving item has been demoted to the lower tier.
+  for (const auto& key : keys) {
+    auto handle = alloc.peek(key);
+    if (!handle) {
+      continue;
+    }
+    ASSERT_EQ(1, alloc.getTierId(*handle));
+    handle.reset();
+
+    const auto before = alloc.getGlobalCacheStats().numTierPromotions;
+    auto found = alloc.find(key);
+    ASSERT_NE(nullptr, found);
+    EXPECT_EQ(0, alloc.getTierId(*found));
+    EXPECT_EQ(before + 1, alloc.getGlobalCacheStats().numTierPromotions);
+    return;
+  }
+  FAIL() << "no item survived in the lower tier";
+}
+
+TEST_F(LruMemoryTiersTest, RemoveFromLowerTier) {
+  auto config = makeConfig();
+  LruAllocator alloc(config);
+
+  const size_t poolSize = alloc.getCacheMemoryStats().ramCacheSize;
+  const auto pid = alloc.addPool("default", poolSize);
+  const auto keys = fill(alloc, pid);
+
+  for (const auto& key : keys) {
+    auto handle = alloc.peek(key);
+    if (!handle || alloc.getTierId(*handle) != 1) {
+      continue;
+    }
+    handle.reset();
+    EXPECT_EQ(LruAllocator::RemoveRes::kSuccess, alloc.remove(key));
+    EXPECT_EQ(nullptr, alloc.find(key));
+    return;
+  }
+  FAIL() << "no item survived in the lower tier";
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+#include "cachelib/allocator/CacheAllocator.h"
+#include "cachelib/allocator/MissRatioCurveEstimator.h"
+#include "cachelib/allocator/MissRatioCurveOptimizeStrategy.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+TEST(MissRatioCurveTest, InvalidConfig) {
+  MissRatioCurveConfig config;
+  config.sampleRate = 0;
+  EXPECT_THROW(MissRatioCurveEstimator{config}, std::invalid_argument);
+  config.sampleRate = 1.5;
+  EXPECT_THROW(MissRatioCurveEstimator{config}, std::invalid_argument);
+  config.sampleRate = 0.1;
+  config.maxSampledKeys = 0;
+  EXPECT_THROW(MissRatioCurveEstimator{config}, std::invalid_argument);
+}
+
+TEST(MissRatioCurveTest, Buckets) {
+  for (size_t i = 0; i + 1 < MissRatioCurveEstimator::kNumBuckets; i++) {
+    const auto upper = MissRatioCurveEstimator::getBucketUpperBound(i);
+    EXPECT_EQ(i, MissRatioCurveEstimator::getBucketIndex(upper));
+    EXPECT_EQ(i + 1, MissRatioCurveEstimator::getBucketIndex(upper + 1));
+  }
+  EXPECT_EQ(MissRatioCurveEstimator::kNumBuckets - 1,
+            MissRatioCurveEstimator::getBucketIndex(UINT64_MAX));
+}
+
+TEST(MissRatioCurveTest, CurveInterpolation) {
+  PoolMissRatioCurve curve;
+  EXPECT_EQ(1.0, curve.getMissRatio(100));
+  curve.points = {{100, 0.8}, {200, 0.4}};
+  EXPECT_DOUBLE_EQ(0.9, curve.getMissRatio(50));
+  EXPECT_DOUBLE_EQ(0.8, curve.getMissRatio(100));
+  EXPECT_DOUBLE_EQ(0.6, curve.getMissRatio(150));
+  EXPECT_DOUBLE_EQ(0.4, curve.getMissRatio(1000));
+}
+
+TEST(MissRatioCurveTest, CyclicScan) {
+  // a loop over more keys than fit misses on every access until the whole
+  // loop fits.
+  MissRatioCurveConfig config;
+  config.sampleRate = 0.1;
+  PoolMissRatioCurves curves{config};
+  constexpr int kNumKeys = 10000;
+  constexpr uint32_t kSize = 100;
+  for (int round = 0; round < 20; round++) {
+    for (int i = 0; i < kNumKeys; i++) {
+      curves.recordAccess(0, folly::sformat("key_{}", i), kSize);
+    }
+  }
+
+  const auto curve = curves.getCurve(0);
+  EXPECT_DOUBLE_EQ(0.1, curve.sampleRate);
+  EXPECT_NEAR(20 * kNumKeys, curve.numAccesses, 2 * kNumKeys);
+  EXPECT_GT(curve.getMissRatio(kNumKeys * kSize / 2), 0.95);
+  EXPECT_LT(curve.getMissRatio(2 * kNumKeys * kSize), 0.1);
+
+  // nothing recorded for other pools
+  EXPECT_TRUE(curves.getCurve(1).points.empty());
+  EXPECT_TRUE(curves.getCurve(-1).points.empty());
+}
+
+TEST(MissRatioCurveTest, UniformAccesses) {
+  // with uniformly random accesses, the miss ratio falls linearly with the
+  // fraction of the keys that fit.
+  MissRatioCurveConfig config;
+  config.sampleRate = 0.2;
+  PoolMissRatioCurves curves{config};
+  constexpr int kNumKeys = 10000;
+  constexpr uint32_t kSize = 100;
+  std::mt19937_64 gen{1};
+  std::uniform_int_distribution<int> dist{0, kNumKeys - 1};
+  for (int i = 0; i < 40 * kNumKeys; i++) {
+    curves.recordAccess(0, folly::sformat("key_{}", dist(gen)), kSize);
+  }
+
+  const auto curve = curves.getCurve(0);
+  for (double frac : {0.25, 0.5, 0.75}) {
+    EXPECT_NEAR(1 - frac, curve.getMissRatio(frac * kNumKeys * kSize), 0.1)
+        << frac;
+  }
+}
+
+TEST(MissRatioCurveTest, BoundedSampledKeys) {
+  // sampling every key of a large keyspace lowers the rate to stay within
+  // the bound on sampled keys.
+  MissRatioCurveConfig config;
+  config.sampleRate = 1.0;
+  config.maxSampledKeys = 1000;
+  PoolMissRatioCurves curves{config};
+  constexpr int kNumKeys = 20000;
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < kNumKeys; i++) {
+      curves.recordAccess(0, folly::sformat("key_{}", i), 100);
+    }
+  }
+
+  const auto curve = curves.getCurve(0);
+  EXPECT_LT(curve.sampleRate, 0.1);
+  EXPECT_GT(curve.sampleRate, 0.02);
+  EXPECT_LT(curve.getMissRatio(kNumKeys * 100 * 9 / 10), 0.5);
+  EXPECT_GT(curve.getMissRatio(kNumKeys * 100 / 2), 0.9);
+}
+
+TEST(MissRatioCurveTest, CacheAllocatorPools) {
+  LruAllocator::Config config;
+  config.setCacheSize(20 * Slab::kSize);
+  MissRatioCurveConfig mrcConfig;
+  mrcConfig.sampleRate = 1.0;
+  config.enableMissRatioCurveEstimation(mrcConfig);
+  LruAllocator alloc(config);
+  const auto size = alloc.getCacheMemoryStats().ramCacheSize / 2;
+  const auto small = alloc.addPool("small", size);
+  const auto large = alloc.addPool("large", size);
+
+  auto access = [&](PoolId pid, int key) {
+    const auto keyStr = folly::sformat("{}_{}", pid, key);
+    if (alloc.find(keyStr)) {
+      return;
+    }
+    auto handle = alloc.allocate(pid, keyStr, 1000);
+    if (handle) {
+      alloc.insertOrReplace(handle);
+    }
+  };
+
+  // one pool loops over keys that fit in it, and the other accesses more
+  // keys than fit at random.
+  std::mt19937_64 gen{1};
+  std::uniform_int_distribution<int> dist{0, 79999};
+  for (int round = 0; round < 5; round++) {
+    for (int i = 0; i < 100; i++) {
+      access(small, i);
+    }
+    for (int i = 0; i < 80000; i++) {
+      access(large, dist(gen));
+    }
+  }
+
+  const auto smallCurve = alloc.getPoolMissRatioCurve(small);
+  const auto largeCurve = alloc.getPoolMissRatioCurve(large);
+  ASSERT_FALSE(smallCurve.points.empty());
+  ASSERT_FALSE(largeCurve.points.empty());
+  EXPECT_LT(smallCurve.getMissRatio(size), 0.3);
+  EXPECT_GT(largeCurve.getMissRatio(size), 0.3);
+  EXPECT_LT(largeCurve.getMissRatio(3 * size), 0.3);
+  EXPECT_GT(largeCurve.getMissRatio(size / 2), largeCurve.getMissRatio(size));
+
+  // memory goes from the pool that does not need it to the one that does
+  MissRatioCurveOptimizeStrategy strategy{
+      MissRatioCurveOptimizeStrategy::Config{1, 1000, 0.1}};
+  const auto ctx = strategy.pickVictimAndReceiverRegularPools(alloc);
+  EXPECT_EQ(small, ctx.victimPoolId);
+  EXPECT_EQ(large, ctx.receiverPoolId);
+}
+
+TEST(MissRatioCurveTest, StrategyNeedsEstimation) {
+  LruAllocator::Config config;
+  auto enableOptimizer = [&config]() {
+    config.enablePoolOptimizer(
+        std::make_shared<MissRatioCurveOptimizeStrategy>(),
+        std::chrono::seconds{1}, std::chrono::seconds{1}, 0);
+  };
+  EXPECT_THROW(enableOptimizer(), std::invalid_argument);
+  config.enableMissRatioCurveEstimation();
+  EXPECT_NO_THROW(enableOptimizer());
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
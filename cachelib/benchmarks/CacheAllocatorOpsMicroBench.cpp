@@ -56,7 +56,11 @@ clang-format on
 namespace facebook {
 namespace cachelib {
 namespace {
-std::unique_ptr<LruAllocator> getCache(unsigned int htPower = 20) {
+std::unique_ptr<LruAllocator> getCache(
+    unsigned int htPower = 20,
+    uint32_t latencySampleRate = 1,
+    util::LatencyHistogram::Clock latencyClock =
+        util::LatencyHistogram::Clock::kSteady) {
   LruAllocator::Config config;
   config.setCacheSize(1024 * 1024 * 1024);
   // Hashtable: 1024 ht locks, 1M buckets
@@ -67,6 +71,7 @@ std::unique_ptr<LruAllocator> getCache(unsigned int htPower = 20) {
   // Disable background workers
   config.enablePoolRebalancing({}, std::chrono::seconds{0});
   config.enableItemReaperInBackground(std::chrono::seconds{0});
+  config.setLatencyTracking(latencySampleRate, latencyClock);
 
   auto cache = std::make_unique<LruAllocator>(config);
   cache->addPool("default", cache->getCacheMemoryStats().ramCacheSize);
@@ -248,11 +253,14 @@ void runFindMissMultiThreads(int numThreads, bool isPeek) {
 
 void runAllocateMultiThreads(int numThreads,
                              bool preFillupCache,
-                             std::vector<uint32_t> payloadSizes) {
+                             std::vector<uint32_t> payloadSizes,
+                             uint32_t latencySampleRate = 1,
+                             util::LatencyHistogram::Clock latencyClock =
+                                 util::LatencyHistogram::Clock::kSteady) {
   constexpr uint64_t kLoops = 1;
   constexpr uint64_t kObjects = 100'000;
 
-  auto cache = getCache();
+  auto cache = getCache(20, latencySampleRate, latencyClock);
   std::vector<std::string> keys;
   for (uint64_t i = 0; i < kObjects; i++) {
     // Length of key should be 10 bytes
@@ -303,9 +311,12 @@ void runAllocateMultiThreads(int numThreads,
   }
 
   {
-    Timer t{folly::sformat("Allocate - {} - {: <2} Threads, {: <2} Sizes",
-                           preFillupCache ? "Eviction" : "New     ", numThreads,
-                           payloadSizes.size()),
+    Timer t{folly::sformat(
+                "Allocate - {} - {: <2} Threads, {: <2} Sizes, 1/{: <3} {}",
+                preFillupCache ? "Eviction" : "New     ", numThreads,
+                payloadSizes.size(), latencySampleRate,
+                latencyClock == util::LatencyHistogram::Clock::kTsc ? "TSC"
+                                                                    : "Steady"),
             totalItemsPerThread};
     sp.reached(0); // Start the operations
     for (auto& w : ws) {
@@ -372,6 +383,17 @@ int main(int argc, char** argv) {
       }
     }
   }
+
+  printMsg("Becnhmarks (Allocate Latency Tracking)");
+  for (auto t : threads) {
+    std::cout << "---------\n";
+    for (uint32_t rate : {1u, 16u, 128u}) {
+      for (auto clock : {util::LatencyHistogram::Clock::kSteady,
+                         util::LatencyHistogram::Clock::kTsc}) {
+        runAllocateMultiThreads(t, true, {1000}, rate, clock);
+      }
+    }
+  }
   printMsg("Becnhmarks have completed");
 }
 
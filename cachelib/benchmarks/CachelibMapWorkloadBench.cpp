@@ -36,6 +36,10 @@
 DEFINE_int32(num_keys, 100, "number of keys used to populate the maps");
 DEFINE_int32(num_ops, 100 * 1000, "number of operations");
 DEFINE_double(write_rate, 0.05, "rate of writes");
+DEFINE_int32(batch_size, 32, "number of entries read or written per request");
+DEFINE_int32(num_batch_keys,
+             50 * 1000,
+             "number of keys in the map used for the batch benchmarks");
 
 namespace facebook {
 namespace cachelib {
@@ -48,6 +52,7 @@ using CachelibMap = Map<uint32_t, Value, LruAllocator>;
 using StdUnorderedMap = datatypebench::StdUnorderedMap;
 
 constexpr folly::StringPiece kClMap = "cachelib_map";
+constexpr folly::StringPiece kClBatchMap = "cachelib_batch_map";
 constexpr folly::StringPiece kStdUnorderedMap = "std_unordered_map";
 constexpr folly::StringPiece kFrozenStdUnorderedMap = "frozen_unordered_map";
 const std::string kFollyCacheStdUnorderedMap = "folly_cache_std_unordered_map";
@@ -88,6 +93,16 @@ void setup() {
     cache->insert(m.viewWriteHandle());
   }
 
+  // insert a large CachelibMap to read batches from
+  {
+    auto m = CachelibMap::create(*cache, poolId, kClBatchMap);
+    Value val;
+    for (int key = 0; key < FLAGS_num_batch_keys; ++key) {
+      m.insert(key, val);
+    }
+    cache->insert(m.viewWriteHandle());
+  }
+
   // insert StdUnorderedMap
   {
     StdUnorderedMap m;
@@ -133,6 +148,76 @@ void benchCachelibMap() {
   }
 }
 
+// Each request reads batch_size random entries, like a request reading the
+// neighbours of a node from an adjacency list.
+template <typename ReadBatchFn>
+void benchCachelibMapReads(ReadBatchFn readBatch) {
+  std::vector<uint32_t> keys(FLAGS_batch_size);
+  std::mt19937 gen{1};
+  std::uniform_int_distribution<uint32_t> keyDist{
+      0, static_cast<uint32_t>(FLAGS_num_batch_keys - 1)};
+  std::vector<std::vector<uint32_t>> requests;
+  {
+    folly::BenchmarkSuspender suspender;
+    for (int i = 0; i < FLAGS_num_ops / FLAGS_batch_size; ++i) {
+      for (auto& key : keys) {
+        key = keyDist(gen);
+      }
+      requests.push_back(keys);
+    }
+  }
+
+  for (const auto& request : requests) {
+    auto it = cache->findImpl(kClBatchMap, AccessMode::kRead);
+    XDCHECK(it);
+    auto m = CachelibMap::fromWriteHandle(*cache, std::move(it));
+    readBatch(m, request);
+  }
+}
+
+void benchCachelibMapFindLoop() {
+  benchCachelibMapReads(
+      [](const CachelibMap& m, const std::vector<uint32_t>& keys) {
+        for (const auto key : keys) {
+          folly::doNotOptimizeAway(m.find(key));
+        }
+      });
+}
+
+void benchCachelibMapFindMany() {
+  benchCachelibMapReads(
+      [](const CachelibMap& m, const std::vector<uint32_t>& keys) {
+        folly::doNotOptimizeAway(m.findMany(folly::range(keys)));
+      });
+}
+
+// Each request builds a map of batch_size entries from scratch.
+template <typename InsertBatchFn>
+void benchCachelibMapWrites(InsertBatchFn insertBatch) {
+  std::vector<std::pair<uint32_t, Value>> entries;
+  for (int i = 0; i < FLAGS_batch_size; ++i) {
+    entries.emplace_back(i, Value{});
+  }
+  for (int i = 0; i < FLAGS_num_ops / FLAGS_batch_size; ++i) {
+    auto m = CachelibMap::create(*cache, poolId, "cachelib_write_map");
+    XDCHECK(!m.isNullWriteHandle());
+    insertBatch(m, entries);
+  }
+}
+
+void benchCachelibMapInsertLoop() {
+  benchCachelibMapWrites([](CachelibMap& m, const auto& entries) {
+    for (const auto& [key, value] : entries) {
+      m.insert(key, value);
+    }
+  });
+}
+
+void benchCachelibMapInsertMany() {
+  benchCachelibMapWrites(
+      [](CachelibMap& m, const auto& entries) { m.insertMany(entries); });
+}
+
 void benchStdMap() {
   auto getMap = [] {
     auto it = cache->find(kStdUnorderedMap);
@@ -220,6 +305,18 @@ BENCHMARK_RELATIVE(std_unordered_mao_on_folly_evcting_cache_map) {
   cl::benchFollyCacheStdMap();
 }
 
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(cachelib_map_find_loop) { cl::benchCachelibMapFindLoop(); }
+BENCHMARK_RELATIVE(cachelib_map_find_many) { cl::benchCachelibMapFindMany(); }
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(cachelib_map_insert_loop) { cl::benchCachelibMapInsertLoop(); }
+BENCHMARK_RELATIVE(cachelib_map_insert_many) {
+  cl::benchCachelibMapInsertMany();
+}
+
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
   cl::setup();
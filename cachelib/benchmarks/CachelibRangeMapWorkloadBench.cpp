@@ -47,6 +47,8 @@
 DEFINE_int32(num_keys, 100, "number of keys used to populate the maps");
 DEFINE_int32(num_ops, 100 * 1000, "number of operations");
 DEFINE_double(write_rate, 0.05, "rate of writes");
+DEFINE_int32(num_scan_keys, 10 * 1000, "number of keys in the scanned map");
+DEFINE_int32(scan_length, 1000, "number of entries read per range scan");
 
 namespace facebook {
 namespace cachelib {
@@ -56,9 +58,17 @@ struct Value {
 };
 
 using CachelibRangeMap = RangeMap<uint32_t, Value, LruAllocator>;
+
+// value of the entries read by range scans
+struct ScanValue {
+  static constexpr size_t kValueSize = 256;
+  std::array<uint8_t, kValueSize> _;
+};
+using CachelibScanMap = RangeMap<uint32_t, ScanValue, LruAllocator>;
 using StdMap = datatypebench::StdMap;
 
 constexpr folly::StringPiece kClMap = "cachelib_map";
+constexpr folly::StringPiece kClScanMap = "cachelib_scan_map";
 constexpr folly::StringPiece kStdMap = "std_unordered_map";
 constexpr folly::StringPiece kFrozenStdMap = "frozen_unordered_map";
 const std::string kFollyCacheStdMap = "folly_cache_std_unordered_map";
@@ -99,6 +109,16 @@ void setup() {
     cache->insert(m.viewWriteHandle());
   }
 
+  // insert a larger CachelibRangeMap for range scans
+  {
+    auto m = CachelibScanMap::create(*cache, poolId, kClScanMap);
+    ScanValue val;
+    for (int key = 0; key < FLAGS_num_scan_keys; ++key) {
+      m.insert(key, val);
+    }
+    cache->insert(m.viewWriteHandle());
+  }
+
   // insert StdMap
   {
     StdMap m;
@@ -143,6 +163,40 @@ void benchCachelibRangeMap() {
   }
 }
 
+// Each request reads scan_length consecutive entries into an IOBuf, as
+// when sending them over the network.
+template <typename ScanFn>
+void benchCachelibRangeMapScan(ScanFn scan) {
+  const int numStarts = FLAGS_num_scan_keys - FLAGS_scan_length;
+  XDCHECK_GT(numStarts, 0);
+  for (int i = 0; i < FLAGS_num_ops / FLAGS_scan_length; ++i) {
+    auto it = cache->findImpl(kClScanMap, AccessMode::kRead);
+    XDCHECK(it);
+    const auto m = CachelibScanMap::fromWriteHandle(*cache, std::move(it));
+    const uint32_t start = (i * 7919) % numStarts;
+    auto range = m.rangeLookup(start, start + FLAGS_scan_length - 1);
+    folly::doNotOptimizeAway(scan(m, range));
+  }
+}
+
+void benchCachelibRangeMapScanCopy() {
+  benchCachelibRangeMapScan([](const CachelibScanMap&, auto range) {
+    auto buf = folly::IOBuf::create(FLAGS_scan_length *
+                                    sizeof(CachelibScanMap::EntryKeyValue));
+    for (const auto& kv : range) {
+      std::memcpy(buf->writableTail(), &kv, sizeof(kv));
+      buf->append(sizeof(kv));
+    }
+    return buf;
+  });
+}
+
+void benchCachelibRangeMapScanExport() {
+  benchCachelibRangeMapScan([](const CachelibScanMap& m, auto range) {
+    return m.exportRange(range);
+  });
+}
+
 void benchStdMap() {
   auto getMap = [] {
     auto it = cache->find(kStdMap);
@@ -229,6 +283,15 @@ BENCHMARK_RELATIVE(std_map_on_folly_evcting_cache_map) {
   cl::benchFollyCacheStdMap();
 }
 
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(cachelib_range_map_scan_copy) {
+  cl::benchCachelibRangeMapScanCopy();
+}
+BENCHMARK_RELATIVE(cachelib_range_map_scan_export) {
+  cl::benchCachelibRangeMapScanExport();
+}
+
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
   cl::setup();
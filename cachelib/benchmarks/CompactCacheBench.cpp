@@ -19,6 +19,9 @@
 #include <gflags/gflags.h>
 
 #include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 #include "cachelib/allocator/CacheAllocator.h"
 #include "cachelib/compact_cache/CCacheCreator.h"
@@ -30,6 +33,10 @@ DEFINE_double(miss_percentage, 0.05, "Percentage of misses in read operations");
 DEFINE_uint64(cache_size, 10UL * 1024UL * 1024UL * 1024UL, "size of cache");
 DEFINE_uint64(num_keys, 10UL * 1000UL * 1000UL, "number of keys");
 DEFINE_uint64(num_ops, 100UL * 1000UL * 1000UL, "number of operations");
+DEFINE_uint64(num_threads, 16, "number of threads for the concurrent reads");
+DEFINE_uint64(num_hot_keys,
+              1000,
+              "number of keys the concurrent reads are spread over");
 
 inline uint32_t getKey(uint32_t i) { return i % FLAGS_num_keys; }
 
@@ -128,6 +135,112 @@ void runCacheRW(bool isItemCache) {
   }
 }
 
+// 16 byte values, the typical use of compact caches with values
+struct Value16 {
+  uint64_t a;
+  uint64_t b;
+};
+
+// Many threads reading and occasionally writing a small set of hot keys in a
+// compact cache, with either the bucket locks or optimistic reads.
+void runConcurrentReads(bool optimisticReads) {
+  using Key = CacheTestImpl<8>::Key;
+  using CCacheType =
+      typename CCacheCreator<CCacheAllocator, Key, Value16>::type;
+  const auto numThreads = FLAGS_num_threads;
+  const auto numOpsPerThread = FLAGS_num_ops / numThreads;
+  const auto numHotKeys = static_cast<uint32_t>(FLAGS_num_hot_keys);
+  const auto writePct = FLAGS_write_percentage;
+
+  std::unique_ptr<LruAllocator> cache;
+  CCacheType* ccache = nullptr;
+  BENCHMARK_SUSPEND {
+    LruAllocator::Config config;
+    config.size = 1024UL * 1024UL * 1024UL;
+    config.enableCompactCache();
+    cache = std::make_unique<LruAllocator>(config);
+    ccache = cache->template addCompactCache<CCacheType>(
+        "compact_cache", cache->getCacheMemoryStats().ramCacheSize,
+        true /* allowPromotions */, optimisticReads);
+    for (uint32_t i = 1; i <= numHotKeys; ++i) {
+      const Value16 val{i, i};
+      ccache->set(Key{i}, &val);
+    }
+  }
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < numThreads; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937 gen(static_cast<uint32_t>(t));
+      std::uniform_int_distribution<uint32_t> keyDist(1, numHotKeys);
+      std::bernoulli_distribution writeDist(writePct);
+      Value16 val{};
+      for (uint64_t i = 0; i < numOpsPerThread; ++i) {
+        const Key key{keyDist(gen)};
+        if (writeDist(gen)) {
+          ccache->set(key, &val);
+        } else {
+          ccache->get(key, &val);
+        }
+      }
+      folly::doNotOptimizeAway(val);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  BENCHMARK_SUSPEND { cache.reset(); }
+}
+
+// Lookups in a full compact cache, with the default buckets or the ones that
+// match keys with vector instructions.
+template <size_t KeySize, bool Simd>
+void runBucketScan() {
+  using Key = typename CacheTestImpl<KeySize>::Key;
+  using CCacheType = typename std::conditional<
+      Simd,
+      typename CCacheSimdCreator<CCacheAllocator, Key, Value16>::type,
+      typename CCacheCreator<CCacheAllocator, Key, Value16>::type>::type;
+  const auto numKeys = static_cast<uint32_t>(FLAGS_num_keys);
+  const auto numOps = FLAGS_num_ops;
+
+  std::unique_ptr<LruAllocator> cache;
+  CCacheType* ccache = nullptr;
+  std::vector<uint32_t> keys;
+  BENCHMARK_SUSPEND {
+    LruAllocator::Config config;
+    config.size = FLAGS_cache_size;
+    config.enableCompactCache();
+    cache = std::make_unique<LruAllocator>(config);
+    ccache = cache->template addCompactCache<CCacheType>(
+        "compact_cache", cache->getCacheMemoryStats().ramCacheSize);
+    for (uint32_t i = 1; i <= numKeys; ++i) {
+      const Value16 val{i, i};
+      ccache->set(Key{i}, &val);
+    }
+    // misses go to keys that were never inserted
+    std::mt19937 gen(0);
+    std::bernoulli_distribution missDist(FLAGS_miss_percentage);
+    std::uniform_int_distribution<uint32_t> keyDist(1, numKeys);
+    keys.reserve(numOps);
+    for (uint64_t i = 0; i < numOps; ++i) {
+      keys.push_back(missDist(gen) ? numKeys + keyDist(gen) : keyDist(gen));
+    }
+  }
+
+  Value16 val{};
+  for (const auto k : keys) {
+    ccache->get(Key{k}, &val, nullptr, false /* shouldPromote */);
+  }
+  folly::doNotOptimizeAway(val);
+
+  BENCHMARK_SUSPEND {
+    keys.clear();
+    cache.reset();
+  }
+}
+
 BENCHMARK(ItemCache10) { runCacheRW<10>(true); }
 BENCHMARK_RELATIVE(CompactCache10) { runCacheRW<10>(false); }
 BENCHMARK(ItemCache32) { runCacheRW<32>(true); }
@@ -140,6 +253,14 @@ BENCHMARK(ItemCache200) { runCacheRW<200>(true); }
 BENCHMARK_RELATIVE(CompactCache200) { runCacheRW<200>(false); }
 BENCHMARK(ItemCache400) { runCacheRW<200>(true); }
 BENCHMARK_RELATIVE(CompactCache400) { runCacheRW<200>(false); }
+BENCHMARK_DRAW_LINE();
+BENCHMARK(CompactCacheScan8) { runBucketScan<8, false>(); }
+BENCHMARK_RELATIVE(CompactCacheSimdScan8) { runBucketScan<8, true>(); }
+BENCHMARK(CompactCacheScan16) { runBucketScan<16, false>(); }
+BENCHMARK_RELATIVE(CompactCacheSimdScan16) { runBucketScan<16, true>(); }
+BENCHMARK_DRAW_LINE();
+BENCHMARK(CompactCacheLockedReads) { runConcurrentReads(false); }
+BENCHMARK_RELATIVE(CompactCacheOptimisticReads) { runConcurrentReads(true); }
 
 int main(int argc, char** argv) {
   folly::init(&argc, &argv);
@@ -0,0 +1,586 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/dynamic.h>
+#include <folly/init/Init.h>
+#include <folly/json.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cachelib/common/BloomFilter.h"
+#include "cachelib/navy/AbstractCache.h"
+#include "cachelib/navy/Factory.h"
+#include "cachelib/navy/bighash/BigHash.h"
+#include "cachelib/navy/block_cache/BlockCache.h"
+#include "cachelib/navy/block_cache/FifoPolicy.h"
+#include "cachelib/navy/block_cache/LruPolicy.h"
+#include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/Hash.h"
+#include "cachelib/navy/common/Utils.h"
+#include "cachelib/navy/scheduler/JobScheduler.h"
+
+// Runs the navy engines in isolation against a memory or a direct IO file
+// device, and sweeps the item size, the reader and writer thread counts, the
+// number of in-memory buffers, the eviction policy and the admission policy.
+//
+// Each run starts from an empty device and prefills it, then the reader and
+// writer threads run their ops concurrently. For every run, the throughput,
+// the p50/p99/p999 latency of lookups and inserts, the write amplification and
+// the engine counters (including the RegionManager ones of BlockCache) are
+// reported as JSON.
+//
+// Example:
+//   navy-bench --engines=block_cache --item_sizes=4096,65536 \
+//     --reader_threads=1,8 --writer_threads=1 --eviction_policies=lru,fifo \
+//     --json_output=/tmp/navy.json
+
+using namespace facebook::cachelib;
+using namespace facebook::cachelib::navy;
+
+DEFINE_string(engines,
+              "block_cache,big_hash,driver",
+              "Comma separated engines to run: block_cache, big_hash, driver");
+DEFINE_string(item_sizes, "1024,16384", "Comma separated value sizes, bytes");
+DEFINE_string(reader_threads, "1,4", "Comma separated reader thread counts");
+DEFINE_string(writer_threads, "1,4", "Comma separated writer thread counts");
+DEFINE_string(num_in_mem_buffers,
+              "4",
+              "Comma separated numbers of BlockCache in-memory buffers");
+DEFINE_string(eviction_policies,
+              "lru",
+              "Comma separated BlockCache eviction policies: lru, fifo");
+DEFINE_string(admission_policies,
+              "none",
+              "Comma separated driver admission policies: none, random");
+DEFINE_double(admission_probability,
+              0.5,
+              "Probability of admitting an item with the random admission "
+              "policy");
+DEFINE_string(device_path,
+              "",
+              "File to run on with direct IO. Memory device if empty.");
+DEFINE_uint64(device_size_mb, 256, "Size of the device, MB");
+DEFINE_uint32(io_align_size, 4096, "Device IO alignment size, bytes");
+DEFINE_uint32(region_size_mb, 4, "BlockCache region size, MB");
+DEFINE_uint32(bucket_size, 4096, "BigHash bucket size, bytes");
+DEFINE_uint32(big_hash_size_pct,
+              10,
+              "Driver only: percent of the device used by BigHash");
+DEFINE_uint32(small_item_max_size,
+              2048,
+              "Driver only: items up to this size go to BigHash");
+DEFINE_uint64(negative_filter_mb,
+              0,
+              "Driver only: size of the negative filter, MB. 0 disables it");
+DEFINE_uint64(num_keys, 100000, "Number of distinct keys");
+DEFINE_uint64(ops_per_thread, 20000, "Number of ops run by each thread");
+DEFINE_string(json_output,
+              "",
+              "File to write the JSON results to. stdout if empty.");
+
+namespace {
+constexpr uint64_t kMetadataSize{4 * 1024 * 1024};
+
+std::vector<std::string> splitStrings(const std::string& flag) {
+  std::vector<std::string> values;
+  folly::split(',', flag, values, true /* ignoreEmpty */);
+  return values;
+}
+
+std::vector<uint32_t> splitInts(const std::string& flag) {
+  std::vector<uint32_t> values;
+  for (const auto& value : splitStrings(flag)) {
+    values.push_back(folly::to<uint32_t>(value));
+  }
+  return values;
+}
+
+struct BenchConfig {
+  std::string engine;
+  uint32_t itemSize{};
+  uint32_t readers{};
+  uint32_t writers{};
+  // BlockCache and driver only
+  uint32_t numInMemBuffers{};
+  std::string evictionPolicy;
+  // driver only
+  std::string admissionPolicy;
+
+  folly::dynamic toDynamic() const {
+    folly::dynamic d = folly::dynamic::object;
+    d["engine"] = engine;
+    d["item_size"] = itemSize;
+    d["reader_threads"] = readers;
+    d["writer_threads"] = writers;
+    if (engine != "big_hash") {
+      d["num_in_mem_buffers"] = numInMemBuffers;
+      d["eviction_policy"] = evictionPolicy;
+    }
+    if (engine == "driver") {
+      d["admission_policy"] = admissionPolicy;
+    }
+    return d;
+  }
+};
+
+// The engine under test, seen through the ops the benchmark runs on it.
+struct Target {
+  // Destroyed in reverse order: the engines before the scheduler that runs
+  // their jobs, and the device last.
+  std::unique_ptr<Device> device;
+  std::unique_ptr<JobScheduler> scheduler;
+  std::unique_ptr<Engine> engine;
+  std::unique_ptr<AbstractCache> cache;
+
+  // Device the engine writes to, owned by the driver for driver runs.
+  Device* devicePtr{};
+  // Space the items are cached in.
+  uint64_t cacheSize{};
+
+  Status insert(HashedKey hk, BufferView value) {
+    return cache ? cache->insert(hk, value) : engine->insert(hk, value);
+  }
+
+  Status lookup(HashedKey hk, Buffer& value) {
+    return cache ? cache->lookup(hk, value) : engine->lookup(hk, value);
+  }
+
+  // Writes everything buffered to the device.
+  void flush() {
+    if (cache) {
+      cache->flush();
+      return;
+    }
+    scheduler->finish();
+    engine->flush();
+    scheduler->finish();
+  }
+
+  void getCounters(const CounterVisitor& visitor) const {
+    if (cache) {
+      cache->getCounters(visitor);
+    } else {
+      engine->getCounters(visitor);
+    }
+  }
+};
+
+std::unique_ptr<Device> makeDevice() {
+  const uint64_t size = FLAGS_device_size_mb * 1024 * 1024;
+  if (FLAGS_device_path.empty()) {
+    return createMemoryDevice(size, nullptr /* encryption */,
+                              FLAGS_io_align_size);
+  }
+  return createFileDevice(FLAGS_device_path, size, true /* truncate */,
+                          FLAGS_io_align_size, nullptr /* encryption */,
+                          0 /* max device write size */);
+}
+
+std::unique_ptr<EvictionPolicy> makeEvictionPolicy(const std::string& name,
+                                                   uint32_t numRegions) {
+  if (name == "fifo") {
+    return std::make_unique<FifoPolicy>();
+  }
+  if (name == "lru") {
+    return std::make_unique<LruPolicy>(numRegions);
+  }
+  throw std::invalid_argument(
+      folly::sformat("Unknown eviction policy: {}", name));
+}
+
+Target makeBlockCache(const BenchConfig& bench) {
+  Target target;
+  target.device = makeDevice();
+  target.devicePtr = target.device.get();
+  target.scheduler = createOrderedThreadPoolJobScheduler(
+      1 /* reader threads */, 2 /* writer threads */, 10 /* shard power */);
+
+  BlockCache::Config config;
+  config.device = target.device.get();
+  config.checksum = true;
+  config.regionSize = uint64_t{FLAGS_region_size_mb} * 1024 * 1024;
+  config.cacheSize =
+      target.device->getSize() / config.regionSize * config.regionSize;
+  config.evictionPolicy =
+      makeEvictionPolicy(bench.evictionPolicy, config.getNumRegions());
+  config.scheduler = target.scheduler.get();
+  config.cleanRegionsPool = std::max(1u, bench.numInMemBuffers / 2);
+  config.numInMemBuffers = bench.numInMemBuffers;
+  target.cacheSize = config.cacheSize;
+  target.engine = std::make_unique<BlockCache>(std::move(config));
+  return target;
+}
+
+Target makeBigHash(const BenchConfig& /* bench */) {
+  constexpr uint32_t kNumHashes = 4;
+  constexpr uint32_t kBitsPerHash = 16;
+
+  Target target;
+  target.device = makeDevice();
+  target.devicePtr = target.device.get();
+  target.scheduler = createOrderedThreadPoolJobScheduler(
+      1 /* reader threads */, 1 /* writer threads */, 10 /* shard power */);
+
+  BigHash::Config config;
+  config.bucketSize = FLAGS_bucket_size;
+  config.cacheSize =
+      target.device->getSize() / config.bucketSize * config.bucketSize;
+  config.device = target.device.get();
+  config.bloomFilter = std::make_unique<BloomFilter>(
+      config.numBuckets(), kNumHashes, kBitsPerHash);
+  target.cacheSize = config.cacheSize;
+  target.engine = std::make_unique<BigHash>(std::move(config.validate()));
+  return target;
+}
+
+Target makeDriver(const BenchConfig& bench) {
+  Target target;
+  auto device = makeDevice();
+  target.devicePtr = device.get();
+  const uint64_t regionSize = uint64_t{FLAGS_region_size_mb} * 1024 * 1024;
+  const uint64_t cacheSize = device->getSize() - kMetadataSize;
+  const uint64_t bigHashSize = cacheSize * FLAGS_big_hash_size_pct / 100 /
+                               FLAGS_bucket_size * FLAGS_bucket_size;
+  // BlockCache regions start region aligned after BigHash
+  const uint64_t blockCacheOffset =
+      (kMetadataSize + bigHashSize + regionSize - 1) / regionSize * regionSize;
+  const uint64_t blockCacheSize =
+      (device->getSize() - blockCacheOffset) / regionSize * regionSize;
+  target.cacheSize = bigHashSize + blockCacheSize;
+
+  auto blockCache = createBlockCacheProto();
+  blockCache->setLayout(blockCacheOffset, blockCacheSize, regionSize);
+  blockCache->setChecksum(true);
+  if (bench.evictionPolicy == "fifo") {
+    blockCache->setFifoEvictionPolicy();
+  } else if (bench.evictionPolicy == "lru") {
+    blockCache->setLruEvictionPolicy();
+  } else {
+    throw std::invalid_argument(folly::sformat(
+        "Unknown eviction policy: {}", bench.evictionPolicy));
+  }
+  blockCache->setCleanRegionsPool(std::max(1u, bench.numInMemBuffers / 2));
+  blockCache->setNumInMemBuffers(bench.numInMemBuffers);
+
+  auto enginePair = createEnginePairProto();
+  enginePair->setBlockCache(std::move(blockCache));
+  if (bigHashSize > 0) {
+    auto bigHash = createBigHashProto();
+    bigHash->setLayout(kMetadataSize, bigHashSize, FLAGS_bucket_size);
+    bigHash->setBloomFilter(4 /* hashes */, 16 /* bits per hash */);
+    enginePair->setBigHash(std::move(bigHash), FLAGS_small_item_max_size);
+  }
+
+  auto proto = createCacheProto();
+  proto->setDevice(std::move(device));
+  proto->setMetadataSize(kMetadataSize);
+  proto->setJobScheduler(createOrderedThreadPoolJobScheduler(
+      std::max(1u, bench.readers), std::max(1u, bench.writers),
+      10 /* shard power */));
+  proto->addEnginePair(std::move(enginePair));
+  if (FLAGS_negative_filter_mb > 0) {
+    proto->setNegativeFilter(FLAGS_negative_filter_mb * 1024 * 1024,
+                             4 /* hashes */);
+  }
+  if (bench.admissionPolicy == "random") {
+    RandomAPConfig config;
+    config.setAdmProbability(FLAGS_admission_probability);
+    proto->setRejectRandomAdmissionPolicy(config);
+  } else if (bench.admissionPolicy != "none") {
+    throw std::invalid_argument(folly::sformat(
+        "Unknown admission policy: {}", bench.admissionPolicy));
+  }
+  target.cache = createCache(std::move(proto));
+  return target;
+}
+
+Target makeTarget(const BenchConfig& bench) {
+  if (bench.engine == "block_cache") {
+    return makeBlockCache(bench);
+  }
+  if (bench.engine == "big_hash") {
+    return makeBigHash(bench);
+  }
+  if (bench.engine == "driver") {
+    return makeDriver(bench);
+  }
+  throw std::invalid_argument(
+      folly::sformat("Unknown engine: {}", bench.engine));
+}
+
+std::string makeKey(uint64_t k) { return folly::sformat("key_{:012}", k); }
+
+// Inserts @hk, retrying while the engine has no space available for now.
+Status insertWithRetry(Target& target, HashedKey hk, BufferView value) {
+  Status status;
+  while ((status = target.insert(hk, value)) == Status::Retry) {
+    std::this_thread::yield();
+  }
+  return status;
+}
+
+// Latencies of one op type, in nanoseconds.
+struct Latencies {
+  std::vector<uint64_t> samples;
+
+  void add(std::chrono::nanoseconds latency) {
+    samples.push_back(latency.count());
+  }
+
+  void merge(const Latencies& other) {
+    samples.insert(samples.end(), other.samples.begin(), other.samples.end());
+  }
+
+  // Sorts the samples; the percentiles are in microseconds.
+  folly::dynamic toDynamic() {
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [this](double p) {
+      if (samples.empty()) {
+        return 0.0;
+      }
+      const auto idx = std::min<size_t>(
+          samples.size() - 1, static_cast<size_t>(p * samples.size()));
+      return samples[idx] / 1000.0;
+    };
+    folly::dynamic d = folly::dynamic::object;
+    d["p50"] = percentile(0.5);
+    d["p99"] = percentile(0.99);
+    d["p999"] = percentile(0.999);
+    return d;
+  }
+};
+
+struct ThreadStats {
+  Latencies latencies;
+  uint64_t ops{0};
+  uint64_t succeeded{0};
+  // bytes of the key and value of successful inserts
+  uint64_t logicalBytes{0};
+};
+
+folly::dynamic runBench(const BenchConfig& bench) {
+  auto target = makeTarget(bench);
+  const Buffer value = [&bench] {
+    Buffer buffer{bench.itemSize};
+    for (size_t i = 0; i < buffer.size(); i++) {
+      buffer.data()[i] = static_cast<uint8_t>(i * 31);
+    }
+    return buffer;
+  }();
+
+  // Fill the cache once over without measuring
+  const uint64_t prefillKeys = std::min<uint64_t>(
+      FLAGS_num_keys, target.cacheSize / std::max(1u, bench.itemSize));
+  for (uint64_t k = 0; k < prefillKeys; k++) {
+    const auto key = makeKey(k);
+    insertWithRetry(target, HashedKey{key}, value.view());
+  }
+  target.flush();
+  const uint64_t bytesWrittenBefore = target.devicePtr->getBytesWritten();
+
+  std::vector<ThreadStats> readerStats(bench.readers);
+  std::vector<ThreadStats> writerStats(bench.writers);
+  std::atomic<bool> start{false};
+
+  auto runReader = [&](uint32_t idx) {
+    auto& stats = readerStats[idx];
+    while (!start) {
+      std::this_thread::yield();
+    }
+    for (uint64_t i = 0; i < FLAGS_ops_per_thread; i++) {
+      const auto key = makeKey(folly::Random::rand64(FLAGS_num_keys));
+      Buffer buffer;
+      const auto begin = getSteadyClock();
+      const auto status = target.lookup(HashedKey{key}, buffer);
+      stats.latencies.add(getSteadyClock() - begin);
+      stats.ops++;
+      if (status == Status::Ok) {
+        stats.succeeded++;
+      }
+    }
+  };
+
+  // Each writer owns the keys equal to its index modulo the writer count,
+  // so that no two writers insert the same key concurrently.
+  auto runWriter = [&](uint32_t idx) {
+    auto& stats = writerStats[idx];
+    const uint64_t keysPerWriter = std::max<uint64_t>(
+        1, FLAGS_num_keys / bench.writers);
+    while (!start) {
+      std::this_thread::yield();
+    }
+    for (uint64_t i = 0; i < FLAGS_ops_per_thread; i++) {
+      const auto key = makeKey(
+          folly::Random::rand64(keysPerWriter) * bench.writers + idx);
+      const auto begin = getSteadyClock();
+      const auto status =
+          insertWithRetry(target, HashedKey{key}, value.view());
+      stats.latencies.add(getSteadyClock() - begin);
+      stats.ops++;
+      if (status == Status::Ok) {
+        stats.succeeded++;
+        stats.logicalBytes += key.size() + value.size();
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < bench.readers; i++) {
+    threads.emplace_back(runReader, i);
+  }
+  for (uint32_t i = 0; i < bench.writers; i++) {
+    threads.emplace_back(runWriter, i);
+  }
+  const auto begin = getSteadyClock();
+  start = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto elapsed = getSteadyClock() - begin;
+  target.flush();
+  const uint64_t bytesWritten =
+      target.devicePtr->getBytesWritten() - bytesWrittenBefore;
+
+  ThreadStats lookups;
+  for (const auto& stats : readerStats) {
+    lookups.latencies.merge(stats.latencies);
+    lookups.ops += stats.ops;
+    lookups.succeeded += stats.succeeded;
+  }
+  ThreadStats inserts;
+  for (const auto& stats : writerStats) {
+    inserts.latencies.merge(stats.latencies);
+    inserts.ops += stats.ops;
+    inserts.succeeded += stats.succeeded;
+    inserts.logicalBytes += stats.logicalBytes;
+  }
+
+  const double elapsedSecs =
+      std::chrono::duration<double>(elapsed).count();
+  auto rate = [elapsedSecs](uint64_t ops) {
+    return elapsedSecs > 0 ? ops / elapsedSecs : 0.0;
+  };
+
+  folly::dynamic result = folly::dynamic::object;
+  result["config"] = bench.toDynamic();
+  result["elapsed_secs"] = elapsedSecs;
+  result["lookup_ops_per_sec"] = rate(lookups.ops);
+  result["insert_ops_per_sec"] = rate(inserts.ops);
+  result["total_ops_per_sec"] = rate(lookups.ops + inserts.ops);
+  result["lookup_latency_us"] = lookups.latencies.toDynamic();
+  result["insert_latency_us"] = inserts.latencies.toDynamic();
+  result["hit_ratio"] =
+      lookups.ops > 0 ? static_cast<double>(lookups.succeeded) / lookups.ops
+                      : 0.0;
+  result["inserts_succeeded"] = inserts.succeeded;
+  result["logical_bytes_written"] = inserts.logicalBytes;
+  result["device_bytes_written"] = bytesWritten;
+  result["write_amplification"] =
+      inserts.logicalBytes > 0
+          ? static_cast<double>(bytesWritten) / inserts.logicalBytes
+          : 0.0;
+
+  folly::dynamic counters = folly::dynamic::object;
+  target.getCounters({[&counters](folly::StringPiece name, double count) {
+    counters[name] = count;
+  }});
+  result["counters"] = std::move(counters);
+  return result;
+}
+
+// Returns all the configs to run for @engine.
+std::vector<BenchConfig> makeSweep(const std::string& engine) {
+  // Only BlockCache has in-memory buffers and an eviction policy, and only
+  // the driver has an admission policy.
+  const bool hasRegions = engine != "big_hash";
+  const auto numInMemBuffers =
+      hasRegions ? splitInts(FLAGS_num_in_mem_buffers)
+                 : std::vector<uint32_t>{0};
+  const auto evictionPolicies =
+      hasRegions ? splitStrings(FLAGS_eviction_policies)
+                 : std::vector<std::string>{""};
+  const auto admissionPolicies =
+      engine == "driver" ? splitStrings(FLAGS_admission_policies)
+                         : std::vector<std::string>{"none"};
+
+  std::vector<BenchConfig> sweep;
+  for (auto itemSize : splitInts(FLAGS_item_sizes)) {
+    if (engine == "big_hash" && itemSize >= FLAGS_bucket_size) {
+      std::cerr << folly::sformat(
+                       "Skipping item size {} for big_hash, bucket size {}",
+                       itemSize, FLAGS_bucket_size)
+                << std::endl;
+      continue;
+    }
+    for (auto readers : splitInts(FLAGS_reader_threads)) {
+      for (auto writers : splitInts(FLAGS_writer_threads)) {
+        if (readers + writers == 0) {
+          continue;
+        }
+        for (auto buffers : numInMemBuffers) {
+          for (const auto& eviction : evictionPolicies) {
+            for (const auto& admission : admissionPolicies) {
+              sweep.push_back(BenchConfig{engine, itemSize, readers, writers,
+                                          buffers, eviction, admission});
+            }
+          }
+        }
+      }
+    }
+  }
+  return sweep;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  folly::dynamic results = folly::dynamic::array;
+  for (const auto& engine : splitStrings(FLAGS_engines)) {
+    for (const auto& bench : makeSweep(engine)) {
+      std::cerr << "Running " << folly::toJson(bench.toDynamic()) << std::endl;
+      results.push_back(runBench(bench));
+    }
+  }
+
+  folly::dynamic report = folly::dynamic::object;
+  report["device"] = FLAGS_device_path.empty() ? "memory" : FLAGS_device_path;
+  report["device_size_mb"] = FLAGS_device_size_mb;
+  report["num_keys"] = FLAGS_num_keys;
+  report["ops_per_thread"] = FLAGS_ops_per_thread;
+  report["results"] = std::move(results);
+
+  const auto json = folly::toPrettyJson(report);
+  if (FLAGS_json_output.empty()) {
+    std::cout << json << std::endl;
+  } else if (!folly::writeFile(json, FLAGS_json_output.c_str())) {
+    std::cerr << "Failed to write " << FLAGS_json_output << std::endl;
+    return 1;
+  }
+  return 0;
+}
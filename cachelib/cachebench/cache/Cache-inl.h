@@ -92,6 +92,32 @@ Cache<Allocator>::Cache(const CacheConfig& config,
     allocatorConfig_.configureMemoryTiers(config_.memoryTierConfigs);
   }
 
+  if (config_.promoteOnHit) {
+    allocatorConfig_.enablePromotionOnHit();
+  }
+
+  if (config_.allocClassTuningIntervalMs > 0) {
+    AllocClassTunerConfig tunerConfig;
+    tunerConfig.sampleRate = config_.allocClassTunerSampleRate;
+    allocatorConfig_.enableAllocClassTuning(
+        std::chrono::milliseconds(config_.allocClassTuningIntervalMs),
+        tunerConfig);
+  }
+
+  if (!config_.keyPrefixStatsDelimiter.empty()) {
+    KeyPrefixStatsConfig prefixConfig;
+    prefixConfig.prefixExtractor = KeyPrefixStatsConfig::delimiterExtractor(
+        config_.keyPrefixStatsDelimiter[0]);
+    prefixConfig.maxPrefixes = config_.keyPrefixStatsMaxPrefixes;
+    allocatorConfig_.enableKeyPrefixStats(std::move(prefixConfig));
+  }
+
+  if (config_.missRatioCurveSampleRate > 0) {
+    MissRatioCurveConfig mrcConfig;
+    mrcConfig.sampleRate = config_.missRatioCurveSampleRate;
+    allocatorConfig_.enableMissRatioCurveEstimation(mrcConfig);
+  }
+
   auto cleanupGuard = folly::makeGuard([&] {
     if (!nvmCacheFilePath_.empty()) {
       util::removePath(nvmCacheFilePath_);
@@ -626,6 +652,9 @@ Stats Cache<Allocator>::getStats() const {
 
   ret.numEvictions = aggregate.numEvictions();
   ret.numItems = aggregate.numItems();
+  ret.ramFragmentationBytes = aggregate.totalFragmentation();
+  ret.ramAllocatedBytes =
+      aggregate.poolUsableSize - aggregate.freeMemoryBytes();
   ret.evictAttempts = cacheStats.evictionAttempts;
   ret.allocAttempts = cacheStats.allocAttempts;
   ret.allocFailures = cacheStats.allocFailures;
@@ -661,6 +690,10 @@ Stats Cache<Allocator>::getStats() const {
   ret.moveSuccessesForSlabRelease = rebalanceStats.numMoveSuccesses;
   ret.evictionAttemptsForSlabRelease = rebalanceStats.numEvictionAttempts;
   ret.evictionSuccessesForSlabRelease = rebalanceStats.numEvictionSuccesses;
+  ret.numAllocClassReconfigurations =
+      cacheStats.allocClassTunerStats.numReconfigurations;
+  ret.numAllocClassSlabsReleased =
+      cacheStats.allocClassTunerStats.numSlabsReleased;
 
   ret.inconsistencyCount = getInconsistencyCount();
   ret.isNvmCacheDisabled = isNvmCacheDisabled();
@@ -676,6 +709,12 @@ Stats Cache<Allocator>::getStats() const {
   if (config_.printNvmCounters) {
     ret.nvmCounters = cache_->getNvmCacheStatsMap().toMap();
   }
+  ret.keyPrefixStats = cache_->getKeyPrefixStats();
+  if (config_.missRatioCurveSampleRate > 0) {
+    for (const auto pid : pools_) {
+      ret.poolMissRatioCurves.push_back(cache_->getPoolMissRatioCurve(pid));
+    }
+  }
 
   // nvm stats from navy
   if (!isRamOnly() && !navyStats.empty()) {
@@ -18,6 +18,11 @@
 #include <folly/Benchmark.h>
 #include <gflags/gflags.h>
 
+#include <algorithm>
+#include <vector>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/KeyPrefixStats.h"
 #include "cachelib/common/PercentileStats.h"
 
 DECLARE_bool(report_api_latency);
@@ -35,6 +40,13 @@ struct Stats {
 
   std::vector<double> poolUsageFraction;
 
+  // bytes lost to allocations being larger than the items in them
+  uint64_t ramFragmentationBytes{0};
+  uint64_t ramAllocatedBytes{0};
+
+  uint64_t numAllocClassReconfigurations{0};
+  uint64_t numAllocClassSlabsReleased{0};
+
   uint64_t numCacheGets{0};
   uint64_t numCacheGetMiss{0};
   uint64_t numCacheEvictions{0};
@@ -108,6 +120,12 @@ struct Stats {
   // errors from the nvm engine.
   std::unordered_map<std::string, double> nvmErrors;
 
+  // counters of the heaviest key prefixes, if enabled.
+  std::unordered_map<std::string, KeyPrefixCounters> keyPrefixStats;
+
+  // estimated miss ratio curve of each pool, if enabled.
+  std::vector<PoolMissRatioCurve> poolMissRatioCurves;
+
   void render(std::ostream& out) const {
     auto totalMisses = getTotalMisses();
     const double overallHitRatio = invertPctFn(totalMisses, numCacheGets);
@@ -131,6 +149,21 @@ struct Stats {
           << std::endl;
     }
 
+    if (ramAllocatedBytes > 0) {
+      constexpr double MB = 1024.0 * 1024;
+      out << folly::sformat("RAM Fragmentation : {:.2f} MB, {:.2f}% of used",
+                            ramFragmentationBytes / MB,
+                            pctFn(ramFragmentationBytes, ramAllocatedBytes))
+          << std::endl;
+    }
+
+    if (numAllocClassReconfigurations > 0) {
+      out << folly::sformat(
+                 "Alloc class reconfigurations: {:,}, slabs released: {:,}",
+                 numAllocClassReconfigurations, numAllocClassSlabsReleased)
+          << std::endl;
+    }
+
     if (numCacheGets > 0) {
       out << folly::sformat("Cache Gets    : {:,}", numCacheGets) << std::endl;
       out << folly::sformat("Hit Ratio     : {:6.2f}%", overallHitRatio)
@@ -289,6 +322,46 @@ struct Stats {
       }
     }
 
+    if (!keyPrefixStats.empty()) {
+      std::vector<std::pair<std::string, KeyPrefixCounters>> prefixes(
+          keyPrefixStats.begin(), keyPrefixStats.end());
+      std::sort(prefixes.begin(), prefixes.end(),
+                [](const auto& a, const auto& b) {
+                  return a.second.weight() > b.second.weight();
+                });
+      constexpr double MB = 1024.0 * 1024;
+      out << "== Key Prefix Stats ==" << std::endl;
+      for (const auto& [prefix, counters] : prefixes) {
+        out << folly::sformat(
+                   "{:20} Gets: {:,} Hit Ratio: {:6.2f}% Allocs: {:,} "
+                   "({:.2f} MB) Evictions: {:,}",
+                   prefix, counters.gets,
+                   invertPctFn(counters.misses, counters.gets), counters.allocs,
+                   counters.allocBytes / MB, counters.evictions)
+            << std::endl;
+      }
+    }
+
+    if (!poolMissRatioCurves.empty()) {
+      constexpr double MB = 1024.0 * 1024;
+      out << "== Miss Ratio Curves ==" << std::endl;
+      for (size_t pid = 0; pid < poolMissRatioCurves.size(); pid++) {
+        const auto& curve = poolMissRatioCurves[pid];
+        out << folly::sformat("Pool {} Accesses: {:,}", pid,
+                              curve.numAccesses)
+            << std::endl;
+        // one point per power of two keeps the output short
+        for (const auto& [size, missRatio] : curve.points) {
+          if ((size & (size - 1)) != 0) {
+            continue;
+          }
+          out << folly::sformat("  {:10.2f} MB : {:6.2f}%", size / MB,
+                                missRatio * 100)
+              << std::endl;
+        }
+      }
+    }
+
     if (numRamDestructorCalls > 0 || numNvmDestructorCalls > 0) {
       out << folly::sformat("Destructor executed from RAM {}, from NVM {}",
                             numRamDestructorCalls, numNvmDestructorCalls)
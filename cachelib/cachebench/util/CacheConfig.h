@@ -49,7 +49,9 @@ struct MemoryTierConfig : public JSONConfig {
 
   // Returns MemoryTierCacheConfig parsed from JSON config
   MemoryTierCacheConfig getMemoryTierCacheConfig() {
-    MemoryTierCacheConfig config = MemoryTierCacheConfig::fromShm();
+    MemoryTierCacheConfig config = file.empty()
+                                       ? MemoryTierCacheConfig::fromShm()
+                                       : MemoryTierCacheConfig::fromFile(file);
     config.setRatio(ratio);
     config.setMemBind(NumaBitMask(memBindNodes));
     return config;
@@ -59,6 +61,9 @@ struct MemoryTierConfig : public JSONConfig {
   size_t ratio{0};
   // Allocate memory only from specified NUMA nodes
   std::string memBindNodes{""};
+  // If set, back this tier with a file at this path (e.g. on tmpfs or a
+  // DAX mount) instead of shared memory
+  std::string file{""};
 };
 
 struct CacheConfig : public JSONConfig {
@@ -218,6 +223,28 @@ struct CacheConfig : public JSONConfig {
   // Use Posix Shm instead of SysVShm
   bool usePosixShm{false};
 
+  // With multiple memory tiers, move items hit in a lower tier to the top
+  bool promoteOnHit{false};
+
+  // If enabled, the allocation classes of each pool are tuned to the sampled
+  // item sizes every this many milliseconds. Not used when its value is 0.
+  uint32_t allocClassTuningIntervalMs{0};
+
+  // one out of this many allocations is sampled for allocation class tuning
+  uint32_t allocClassTunerSampleRate{100};
+
+  // If set, gets, allocations and evictions are accounted by the part of the
+  // key before the first occurrence of this delimiter. Only the first
+  // character is used.
+  std::string keyPrefixStatsDelimiter{};
+
+  // max number of key prefixes reported
+  uint32_t keyPrefixStatsMaxPrefixes{16};
+
+  // If non-zero, the miss ratio curve of each pool is estimated from this
+  // fraction of the keys and reported.
+  double missRatioCurveSampleRate{0};
+
   // Memory tiers configs
   std::vector<MemoryTierCacheConfig> memoryTierConfigs{};
 
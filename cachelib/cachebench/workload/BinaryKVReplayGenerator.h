@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <folly/Format.h>
+#include <folly/ScopeGuard.h>
+#include <folly/String.h>
+#include <folly/ThreadLocal.h>
+#include <folly/hash/Hash.h>
+#include <folly/lang/Aligned.h>
+#include <folly/logging/xlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <charconv>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cachelib/cachebench/util/Exceptions.h"
+#include "cachelib/cachebench/util/Request.h"
+#include "cachelib/cachebench/workload/ReplayGeneratorBase.h"
+#include "cachelib/common/CompilerUtils.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+// One request of a trace in the oracleGeneral format, as laid out in the
+// file. The traces are a flat array of these records.
+struct CACHELIB_PACKED_ATTR OracleGeneralRecord {
+  uint32_t timestamp;
+  uint64_t objId;
+  uint32_t objSize;
+  int64_t nextAccessVtime;
+};
+static_assert(sizeof(OracleGeneralRecord) == 24,
+              "oracleGeneral records are 24 bytes");
+
+// Read-only memory mapping of a binary trace made of OracleGeneralRecord.
+class BinaryTraceFile {
+ public:
+  // @throw std::runtime_error if the file can not be opened or mapped
+  explicit BinaryTraceFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error(folly::sformat(
+          "Failed to open trace file {}: {}", path, folly::errnoStr(errno)));
+    }
+    SCOPE_EXIT { ::close(fd); };
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+      throw std::runtime_error(folly::sformat(
+          "Failed to stat trace file {}: {}", path, folly::errnoStr(errno)));
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ % sizeof(OracleGeneralRecord) != 0) {
+      XLOGF(WARN, "Trace file {} has a partial record at the end, ignoring it",
+            path);
+    }
+    numRecords_ = size_ / sizeof(OracleGeneralRecord);
+    if (numRecords_ == 0) {
+      return;
+    }
+
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      throw std::runtime_error(folly::sformat(
+          "Failed to map trace file {}: {}", path, folly::errnoStr(errno)));
+    }
+    // the trace is read front to back
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = reinterpret_cast<const uint8_t*>(addr);
+  }
+
+  ~BinaryTraceFile() {
+    if (data_ != nullptr) {
+      ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+  }
+
+  BinaryTraceFile(const BinaryTraceFile&) = delete;
+  BinaryTraceFile& operator=(const BinaryTraceFile&) = delete;
+
+  size_t getNumRecords() const noexcept { return numRecords_; }
+
+  OracleGeneralRecord getRecord(size_t idx) const noexcept {
+    XDCHECK_LT(idx, numRecords_);
+    OracleGeneralRecord record;
+    std::memcpy(&record, data_ + idx * sizeof(record), sizeof(record));
+    return record;
+  }
+
+ private:
+  const uint8_t* data_{nullptr};
+  size_t size_{0};
+  size_t numRecords_{0};
+};
+
+// BinaryKVReplayGenerator replays traces in the binary oracleGeneral format.
+// The trace files are mapped in memory, so records are never parsed.
+//
+// There is no generator thread: stressors read the records straight from
+// the mapping. With the strict serialization mode, every stressor scans the
+// whole trace and issues the requests whose key hashes to it, so that the
+// requests for a key are issued in order by a single stressor. Otherwise
+// each stressor replays a contiguous range of the records.
+//
+// Like KVReplayGenerator, the key population can be amplified with
+// ampFactor, which replays every record once per stream with a 4-digit
+// stream suffix appended to the key. All requests are gets; use
+// enableLookaside to fill the cache on misses.
+class BinaryKVReplayGenerator : public ReplayGeneratorBase {
+ public:
+  explicit BinaryKVReplayGenerator(const StressorConfig& config)
+      : ReplayGeneratorBase(config),
+        ampFactor_(config.replayGeneratorConfig.ampFactor) {
+    if (numShards_ == 0) {
+      throw std::invalid_argument("Binary replay needs at least one thread");
+    }
+    if (ampFactor_ == 0 || ampFactor_ > kMaxAmpFactor) {
+      throw std::invalid_argument(folly::sformat(
+          "Invalid amp factor {} for binary replay, must be in [1, {}]",
+          ampFactor_, kMaxAmpFactor));
+    }
+
+    std::vector<std::string> fileNames = config.traceFileNames;
+    if (!config.traceFileName.empty()) {
+      fileNames = {config.traceFileName};
+    }
+    size_t numRecords = 0;
+    for (const auto& fileName : fileNames) {
+      const auto path = fileName[0] == '/'
+                            ? fileName
+                            : folly::sformat("{}/{}", config.configPath,
+                                             fileName);
+      files_.emplace_back(std::make_unique<BinaryTraceFile>(path));
+      numRecords += files_.back()->getNumRecords();
+    }
+    if (numRecords == 0) {
+      throw std::invalid_argument("Binary replay needs a non-empty trace");
+    }
+
+    for (uint32_t i = 0; i < numShards_; ++i) {
+      stressorCtxs_.emplace_back(std::make_unique<StressorCtx>(i));
+    }
+
+    XLOGF(INFO,
+          "Started BinaryKVReplayGenerator ({} records, amp factor {}, # of "
+          "stressor threads {})",
+          numRecords, ampFactor_, numShards_);
+  }
+
+  // getReq returns the next request of the calling stressor's shard.
+  // The request stays valid until the stressor asks for kMaxOutstanding
+  // more requests.
+  const Request& getReq(
+      uint8_t,
+      std::mt19937_64&,
+      std::optional<uint64_t> lastRequestId = std::nullopt) override;
+
+  void renderStats(uint64_t, std::ostream& out) const override {
+    uint64_t numReqs = 0;
+    for (const auto& ctx : stressorCtxs_) {
+      numReqs += ctx->numReqs_.load(std::memory_order_relaxed);
+    }
+    out << std::endl << "== BinaryKVReplayGenerator Stats ==" << std::endl;
+    out << folly::sformat("{}: {:.2f} million", "Total Processed Samples",
+                          static_cast<double>(numReqs) / 1e6)
+        << std::endl;
+  }
+
+  // max number of requests of a stressor that can be outstanding at once
+  static constexpr size_t kMaxOutstanding = 1024;
+
+  // the stream suffix has 4 decimal digits
+  static constexpr uint32_t kMaxAmpFactor = 10000;
+
+ private:
+  // a request along with the key and sizes it refers to
+  struct ReqSlot {
+    std::string key_;
+    std::vector<size_t> sizes_{1};
+    Request req_{key_, sizes_.begin(), sizes_.end(), OpType::kGet};
+  };
+
+  struct StressorCtx {
+    explicit StressorCtx(uint32_t id) : id_(id) {}
+
+    const uint32_t id_;
+
+    // next file to open and the range of its records this stressor reads.
+    // That is the whole file in strict mode.
+    size_t nextFileIdx_{0};
+    size_t fileIdx_{0};
+    size_t recordIdx_{0};
+    size_t recordEnd_{0};
+
+    // record being replayed and its current stream
+    OracleGeneralRecord record_{};
+    uint32_t ampIdx_{0};
+    bool hasRecord_{false};
+
+    // whether any request was issued since the trace was last started over
+    bool issuedInPass_{false};
+
+    size_t nextSlot_{0};
+    std::vector<std::unique_ptr<ReqSlot>> slots_;
+
+    std::atomic<uint64_t> numReqs_{0};
+  };
+
+  // move the stressor to its next request. In strict mode, requests for
+  // keys owned by other stressors are skipped.
+  // @return false if the stressor has no request left
+  bool advance(StressorCtx& ctx);
+
+  // move the stressor to its range of the next trace file.
+  // @return false if the trace is over
+  bool openNextFile(StressorCtx& ctx);
+
+  uint32_t getOwner(uint64_t objId, uint32_t ampIdx) const {
+    return folly::hash::hash_128_to_64(objId, ampIdx) % numShards_;
+  }
+
+  void fillKey(const StressorCtx& ctx, std::string& key) const {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof(buf), ctx.record_.objId);
+    if (ampFactor_ > 1) {
+      uint32_t suffix = ctx.ampIdx_;
+      for (int i = 3; i >= 0; i--) {
+        res.ptr[i] = static_cast<char>('0' + suffix % 10);
+        suffix /= 10;
+      }
+      res.ptr += 4;
+    }
+    key.assign(buf, res.ptr);
+  }
+
+  StressorCtx& getStressorCtx() {
+    if (!stressorIdx_.get()) {
+      stressorIdx_.reset(new uint32_t(incrementalIdx_++));
+    }
+    XCHECK_LT(*stressorIdx_, numShards_);
+    return *stressorCtxs_[*stressorIdx_];
+  }
+
+  const uint32_t ampFactor_;
+
+  std::vector<std::unique_ptr<BinaryTraceFile>> files_;
+
+  // Used to assign stressorIdx_
+  std::atomic<uint32_t> incrementalIdx_{0};
+
+  // A sticky index assigned to each stressor threads that calls into
+  // the generator.
+  folly::ThreadLocalPtr<uint32_t> stressorIdx_;
+
+  std::vector<std::unique_ptr<StressorCtx>> stressorCtxs_;
+};
+
+inline bool BinaryKVReplayGenerator::openNextFile(StressorCtx& ctx) {
+  if (ctx.nextFileIdx_ == files_.size()) {
+    // stop rather than spin when a pass over the trace has nothing for this
+    // stressor
+    if (!repeatTraceReplay_ || !ctx.issuedInPass_) {
+      return false;
+    }
+    ctx.nextFileIdx_ = 0;
+    ctx.issuedInPass_ = false;
+  }
+
+  ctx.fileIdx_ = ctx.nextFileIdx_++;
+  const size_t numRecords = files_[ctx.fileIdx_]->getNumRecords();
+  if (mode_ == ReplayGeneratorConfig::SerializeMode::strict) {
+    ctx.recordIdx_ = 0;
+    ctx.recordEnd_ = numRecords;
+  } else {
+    ctx.recordIdx_ = numRecords * ctx.id_ / numShards_;
+    ctx.recordEnd_ = numRecords * (ctx.id_ + 1) / numShards_;
+  }
+  return true;
+}
+
+inline bool BinaryKVReplayGenerator::advance(StressorCtx& ctx) {
+  const bool strict = mode_ == ReplayGeneratorConfig::SerializeMode::strict;
+  while (true) {
+    if (ctx.hasRecord_ && ctx.ampIdx_ + 1 < ampFactor_) {
+      ctx.ampIdx_++;
+    } else {
+      while (ctx.recordIdx_ == ctx.recordEnd_) {
+        if (!openNextFile(ctx)) {
+          return false;
+        }
+      }
+      ctx.record_ = files_[ctx.fileIdx_]->getRecord(ctx.recordIdx_++);
+      ctx.ampIdx_ = 0;
+      ctx.hasRecord_ = true;
+    }
+    if (!strict || getOwner(ctx.record_.objId, ctx.ampIdx_) == ctx.id_) {
+      ctx.issuedInPass_ = true;
+      return true;
+    }
+  }
+}
+
+inline const Request& BinaryKVReplayGenerator::getReq(
+    uint8_t, std::mt19937_64&, std::optional<uint64_t>) {
+  auto& ctx = getStressorCtx();
+  if (shouldShutdown() || !advance(ctx)) {
+    throw cachelib::cachebench::EndOfTrace("Test stopped or EOF reached");
+  }
+
+  if (ctx.slots_.size() < kMaxOutstanding) {
+    ctx.slots_.emplace_back(std::make_unique<ReqSlot>());
+  }
+  auto& slot = *ctx.slots_[ctx.nextSlot_++ % kMaxOutstanding];
+
+  fillKey(ctx, slot.key_);
+  slot.sizes_[0] = ctx.record_.objSize;
+  slot.req_.timestamp = ctx.record_.timestamp;
+  ctx.numReqs_.store(ctx.numReqs_.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+  return slot.req_;
+}
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <map>
+#include <set>
+#include <thread>
+
+#include "cachelib/cachebench/workload/BinaryKVReplayGenerator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace tests {
+
+namespace {
+// writes a trace of numRecords records where record i is for object
+// i % numObjects of size 100 + i, at timestamp 1000 + i.
+std::string writeTrace(size_t numRecords, uint64_t numObjects) {
+  static std::atomic<int> fileId{0};
+  const auto path = folly::sformat("/tmp/binary-replay-test-{}-{}",
+                                   ::getpid(), fileId++);
+  std::vector<OracleGeneralRecord> records;
+  for (size_t i = 0; i < numRecords; i++) {
+    OracleGeneralRecord record;
+    record.timestamp = static_cast<uint32_t>(1000 + i);
+    record.objId = i % numObjects;
+    record.objSize = static_cast<uint32_t>(100 + i);
+    record.nextAccessVtime = -1;
+    records.push_back(record);
+  }
+  folly::File file(path, O_WRONLY | O_CREAT | O_TRUNC);
+  const auto size = records.size() * sizeof(OracleGeneralRecord);
+  EXPECT_EQ(static_cast<ssize_t>(size),
+            folly::writeFull(file.fd(), records.data(), size));
+  return path;
+}
+
+StressorConfig makeConfig(const std::string& path, uint32_t numThreads) {
+  StressorConfig config;
+  config.generator = "binary-replay";
+  config.traceFileName = path;
+  config.numThreads = numThreads;
+  return config;
+}
+} // namespace
+
+TEST(BinaryKVReplayGeneratorTest, ReplayInOrder) {
+  const auto path = writeTrace(10, 4);
+  SCOPE_EXIT { ::unlink(path.c_str()); };
+  auto config = makeConfig(path, 1);
+  config.replayGeneratorConfig.ampFactor = 2;
+  BinaryKVReplayGenerator replayer{config};
+  std::mt19937_64 gen;
+
+  for (size_t i = 0; i < 10; i++) {
+    for (size_t stream = 0; stream < 2; stream++) {
+      const auto& req = replayer.getReq(0, gen, std::nullopt);
+      EXPECT_EQ(folly::sformat("{}{:04d}", i % 4, stream), req.key);
+      EXPECT_EQ(100 + i, *req.sizeBegin);
+      EXPECT_EQ(1000 + i, req.timestamp);
+      EXPECT_EQ(OpType::kGet, req.getOp());
+    }
+  }
+  EXPECT_THROW(replayer.getReq(0, gen, std::nullopt), EndOfTrace);
+  replayer.markShutdown();
+}
+
+TEST(BinaryKVReplayGeneratorTest, RepeatTrace) {
+  const auto path = writeTrace(3, 3);
+  SCOPE_EXIT { ::unlink(path.c_str()); };
+  auto config = makeConfig(path, 1);
+  config.repeatTraceReplay = true;
+  BinaryKVReplayGenerator replayer{config};
+  std::mt19937_64 gen;
+
+  for (size_t i = 0; i < 10; i++) {
+    const auto& req = replayer.getReq(0, gen, std::nullopt);
+    EXPECT_EQ(folly::sformat("{}", i % 3), req.key);
+  }
+  replayer.markShutdown();
+  EXPECT_THROW(replayer.getReq(0, gen, std::nullopt), EndOfTrace);
+}
+
+TEST(BinaryKVReplayGeneratorTest, InvalidConfig) {
+  const auto path = writeTrace(3, 3);
+  SCOPE_EXIT { ::unlink(path.c_str()); };
+  auto config = makeConfig(path, 1);
+  config.replayGeneratorConfig.ampFactor = 0;
+  EXPECT_THROW(BinaryKVReplayGenerator{config}, std::invalid_argument);
+
+  config = makeConfig(path, 0);
+  EXPECT_THROW(BinaryKVReplayGenerator{config}, std::invalid_argument);
+
+  config = makeConfig("/tmp/binary-replay-test-does-not-exist", 1);
+  EXPECT_THROW(BinaryKVReplayGenerator{config}, std::runtime_error);
+}
+
+// every request is issued by exactly one stressor, and with strict
+// serialization all requests for a key come from the same one.
+void testSharding(const std::string& mode, size_t numRecords) {
+  const auto path = writeTrace(numRecords, 50);
+  SCOPE_EXIT { ::unlink(path.c_str()); };
+  constexpr uint32_t kNumThreads = 4;
+  auto config = makeConfig(path, kNumThreads);
+  config.replayGeneratorConfig.ampFactor = 3;
+  config.replayGeneratorConfig.replaySerializationMode = mode;
+  BinaryKVReplayGenerator replayer{config};
+
+  std::vector<std::vector<std::string>> keys(kNumThreads);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      std::mt19937_64 gen;
+      while (true) {
+        try {
+          keys[t].push_back(replayer.getReq(0, gen, std::nullopt).key);
+        } catch (const EndOfTrace&) {
+          break;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  replayer.markShutdown();
+
+  size_t numReqs = 0;
+  std::map<std::string, std::set<uint32_t>> keyShards;
+  for (uint32_t t = 0; t < kNumThreads; t++) {
+    numReqs += keys[t].size();
+    for (const auto& key : keys[t]) {
+      keyShards[key].insert(t);
+    }
+  }
+  EXPECT_EQ(numRecords * 3, numReqs);
+  EXPECT_EQ(50 * 3, keyShards.size());
+  if (mode == "strict") {
+    for (const auto& [key, shards] : keyShards) {
+      EXPECT_EQ(1, shards.size()) << key;
+    }
+  }
+}
+
+TEST(BinaryKVReplayGeneratorTest, StrictSharding) {
+  testSharding("strict", 1000);
+}
+
+TEST(BinaryKVReplayGeneratorTest, RangeSharding) {
+  testSharding("none", 1001);
+}
+
+// a stressor that finishes early does not hold up the others in strict mode
+TEST(BinaryKVReplayGeneratorTest, StrictFinishedStressor) {
+  const size_t numRecords = 40000;
+  const auto path = writeTrace(numRecords, 1000);
+  SCOPE_EXIT { ::unlink(path.c_str()); };
+  BinaryKVReplayGenerator replayer{makeConfig(path, 2)};
+
+  std::thread([&] {
+    std::mt19937_64 gen;
+    replayer.getReq(0, gen, std::nullopt);
+    replayer.markFinish();
+  }).join();
+
+  size_t numReqs = 1;
+  std::thread([&] {
+    std::mt19937_64 gen;
+    while (true) {
+      try {
+        replayer.getReq(0, gen, std::nullopt);
+        numReqs++;
+      } catch (const EndOfTrace&) {
+        break;
+      }
+    }
+  }).join();
+  replayer.markShutdown();
+  EXPECT_LT(numReqs, numRecords);
+  EXPECT_GT(numReqs, numRecords / 4);
+}
+
+} // namespace tests
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
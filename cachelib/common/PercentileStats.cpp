@@ -16,6 +16,8 @@
 
 #include "cachelib/common/PercentileStats.h"
 
+#include <thread>
+
 namespace facebook {
 namespace cachelib {
 namespace util {
@@ -72,6 +74,117 @@ void PercentileStats::visitQuantileEstimates(const CounterVisitor& visitor,
           static_cast<double>(rst.p999999));
   visitor(folly::sformat(fmt, prefix, "max"), static_cast<double>(rst.p100));
 }
+
+uint64_t LatencyHistogram::getBucketLowerBound(size_t idx) noexcept {
+  if (idx < kSubBuckets) {
+    return idx;
+  }
+  const uint64_t shift = idx / kSubBuckets - 1;
+  return (kSubBuckets + idx % kSubBuckets) << shift;
+}
+
+uint64_t LatencyHistogram::getBucketUpperBound(size_t idx) noexcept {
+  if (idx < kSubBuckets) {
+    return idx;
+  }
+  const uint64_t shift = idx / kSubBuckets - 1;
+  return getBucketLowerBound(idx) + (1ULL << shift) - 1;
+}
+
+std::atomic<double> LatencyHistogram::nanosPerTscTick_{0.0};
+
+double LatencyHistogram::calibrateTsc() {
+  static const double nanosPerTick = []() {
+    const auto beginTime = std::chrono::steady_clock::now();
+    const auto beginTicks = folly::hardware_timestamp();
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    const auto endTicks = folly::hardware_timestamp();
+    const auto endTime = std::chrono::steady_clock::now();
+    const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           endTime - beginTime)
+                           .count();
+    if (endTicks <= beginTicks || nanos <= 0) {
+      return 0.0;
+    }
+    const auto value = static_cast<double>(nanos) /
+                       static_cast<double>(endTicks - beginTicks);
+    nanosPerTscTick_.store(value, std::memory_order_relaxed);
+    return value;
+  }();
+  return nanosPerTick;
+}
+
+void LatencyHistogram::setClock(Clock clock) {
+  if (clock == Clock::kTsc && calibrateTsc() == 0.0) {
+    XLOG(WARN) << "TSC is not usable for latency tracking, using "
+                  "steady_clock instead";
+    clock = Clock::kSteady;
+  }
+  clock_.store(clock, std::memory_order_release);
+}
+
+PercentileStats::Estimates LatencyHistogram::estimate() {
+  const auto total = buckets_.getSnapshot();
+
+  std::lock_guard<std::mutex> l(windowMutex_);
+  if (!windowBase_) {
+    windowBase_ = std::make_unique<Buckets>();
+  }
+  Buckets delta;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    delta.counts[i] = total.counts[i] - windowBase_->counts[i];
+  }
+  delta.count = total.count - windowBase_->count;
+  delta.sum = total.sum - windowBase_->sum;
+
+  const auto now = std::chrono::steady_clock::now();
+  if (now - windowStart_ >= windowSize_) {
+    *windowBase_ = total;
+    windowStart_ = now;
+  }
+  if (delta.count == 0) {
+    return lastEstimates_;
+  }
+
+  // the value of the bucket holding the sample of the given rank.
+  std::array<uint64_t, std::tuple_size<decltype(PercentileStats::kQuantiles)>::value>
+      values{};
+  uint64_t seen = 0;
+  size_t q = 0;
+  for (size_t i = 0; i < kNumBuckets && q < values.size(); i++) {
+    seen += delta.counts[i];
+    const auto mid = getBucketLowerBound(i) +
+                     (getBucketUpperBound(i) - getBucketLowerBound(i)) / 2;
+    while (q < values.size()) {
+      const auto rank = std::min<uint64_t>(
+          delta.count - 1,
+          static_cast<uint64_t>(PercentileStats::kQuantiles[q] *
+                                static_cast<double>(delta.count)));
+      if (rank >= seen) {
+        break;
+      }
+      values[q++] = mid;
+    }
+  }
+
+  lastEstimates_ = {delta.sum / delta.count,
+                    values[0],
+                    values[1],
+                    values[2],
+                    values[3],
+                    values[4],
+                    values[5],
+                    values[6],
+                    values[7],
+                    values[8],
+                    values[9],
+                    values[10],
+                    values[11],
+                    values[12],
+                    values[13]};
+  return lastEstimates_;
+}
 } // namespace util
 } // namespace cachelib
 } // namespace facebook
@@ -24,8 +24,16 @@
 #pragma GCC diagnostic ignored "-Wconversion"
 #include <folly/stats/QuantileEstimator.h>
 #pragma GCC diagnostic pop
+#include <folly/chrono/Hardware.h>
 #include <folly/logging/xlog.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "cachelib/common/FastStats.h"
 #include "cachelib/common/Utils.h"
 
 namespace facebook {
@@ -99,16 +107,197 @@ class PercentileStats {
   }
 
  private:
+  friend class LatencyHistogram;
+
   static const std::array<double, 14> kQuantiles;
   static constexpr int kDefaultWindowSize = 1;
 
   folly::SlidingWindowQuantileEstimator<> estimator_;
 };
 
+// Latency histogram with log-linear buckets, meant for trackers on hot paths
+// where the cost of PercentileStats::trackValue shows. Every thread counts
+// into its own buckets, which are merged only when estimates are requested.
+// Values are nanoseconds; a bucket spans at most 1/16 of its lower bound
+// and values beyond 2^36 ns (~68s) are counted in the last bucket.
+//
+// Only one out of every N latencies can be tracked (see shouldSample()), and
+// latencies can be measured with the TSC instead of steady_clock. Both are
+// meant to be set up before the histogram is used, since switching to the
+// TSC calibrates it first.
+class LatencyHistogram {
+ public:
+  enum class Clock { kSteady, kTsc };
+
+  // 528 buckets, which keeps the counts of a thread at about 4KB.
+  static constexpr uint32_t kSubBucketBits = 4;
+  static constexpr uint64_t kSubBuckets = 1ULL << kSubBucketBits;
+  static constexpr uint32_t kMaxValueBits = 36;
+  static constexpr uint64_t kMaxValue = (1ULL << kMaxValueBits) - 1;
+  static constexpr size_t kNumBuckets =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+  // @param windowSize  estimates cover the latencies tracked since the
+  //                    previous estimate that was at least this long ago.
+  explicit LatencyHistogram(
+      std::chrono::seconds windowSize =
+          std::chrono::seconds{PercentileStats::kDefaultWindowSize})
+      : windowSize_{windowSize},
+        windowStart_{std::chrono::steady_clock::now()} {}
+
+  // track one out of every _sampleRate_ latencies. 0 and 1 track all.
+  void setSampleRate(uint32_t sampleRate) noexcept {
+    sampleRate_.store(sampleRate, std::memory_order_relaxed);
+  }
+  uint32_t getSampleRate() const noexcept {
+    return sampleRate_.load(std::memory_order_relaxed);
+  }
+
+  // Switching to the TSC calibrates it against steady_clock the first time,
+  // which sleeps for 10ms. Stays on steady_clock if the TSC is not usable.
+  void setClock(Clock clock);
+  Clock getClock() const noexcept {
+    // pairs with setClock() so that the TSC is calibrated when it is read
+    return clock_.load(std::memory_order_acquire);
+  }
+
+  // @return true if the latency about to be measured should be tracked.
+  bool shouldSample() noexcept {
+    const auto rate = sampleRate_.load(std::memory_order_relaxed);
+    if (rate <= 1) {
+      return true;
+    }
+    return ++buckets_.tlStats().numCalls % rate == 0;
+  }
+
+  // @return the current time in ticks of the configured clock.
+  uint64_t now() const noexcept {
+    if (getClock() == Clock::kTsc) {
+      return folly::hardware_timestamp();
+    }
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+  }
+
+  // @return nanoseconds elapsed since _begin_, which was returned by now().
+  uint64_t elapsedNanos(uint64_t begin) const noexcept {
+    const auto end = now();
+    if (end <= begin) {
+      return 0;
+    }
+    if (getClock() == Clock::kTsc) {
+      return static_cast<uint64_t>(static_cast<double>(end - begin) *
+                                   getNanosPerTscTick());
+    }
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::duration(
+                   static_cast<std::chrono::steady_clock::rep>(end - begin)))
+        .count();
+  }
+
+  // track a latency in nanoseconds.
+  void trackValue(uint64_t value) noexcept {
+    auto& buckets = buckets_.tlStats();
+    ++buckets.counts[getBucketIndex(value)];
+    ++buckets.count;
+    buckets.sum += value;
+  }
+
+  // Return the estimates over the current window. When nothing was tracked
+  // in it, the estimates of the previous window are returned. Bucket
+  // midpoints stand in for the values, so estimates are within 1/32 of the
+  // tracked latencies.
+  PercentileStats::Estimates estimate();
+
+  void visitQuantileEstimator(
+      const std::function<void(folly::StringPiece, double)>& visitor,
+      folly::StringPiece statPrefix) {
+    visitQuantileEstimator(CounterVisitor{visitor}, statPrefix);
+  }
+
+  void visitQuantileEstimator(const CounterVisitor& visitor,
+                              folly::StringPiece statPrefix) {
+    auto rst = estimate();
+    PercentileStats::visitQuantileEstimates(visitor, rst, statPrefix);
+  }
+
+  // @return the number of latencies tracked over the lifetime.
+  uint64_t getCount() const { return buckets_.getSnapshot().count; }
+
+  static size_t getBucketIndex(uint64_t value) noexcept {
+    value = std::min(value, kMaxValue);
+    if (value < kSubBuckets) {
+      return static_cast<size_t>(value);
+    }
+    const uint32_t msb = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+    const uint32_t shift = msb - kSubBucketBits;
+    return static_cast<size_t>((shift + 1) * kSubBuckets +
+                               ((value >> shift) - kSubBuckets));
+  }
+
+  // smallest and largest value counted in the bucket.
+  static uint64_t getBucketLowerBound(size_t idx) noexcept;
+  static uint64_t getBucketUpperBound(size_t idx) noexcept;
+
+  // nanoseconds per TSC tick, or 0 until the TSC has been calibrated by
+  // setClock(). Never blocks.
+  static double getNanosPerTscTick() noexcept {
+    return nanosPerTscTick_.load(std::memory_order_relaxed);
+  }
+
+  // calibrate the TSC against steady_clock. Only the first call measures;
+  // later ones return the same result.
+  //
+  // @return nanoseconds per TSC tick, or 0 if the TSC is not usable
+  static double calibrateTsc();
+
+ private:
+  struct Buckets {
+    std::array<uint64_t, kNumBuckets> counts{};
+    uint64_t count{0};
+    uint64_t sum{0};
+    // calls to shouldSample() from the thread, used for sampling.
+    uint64_t numCalls{0};
+
+    Buckets& operator+=(const Buckets& other) {
+      for (size_t i = 0; i < kNumBuckets; i++) {
+        counts[i] += other.counts[i];
+      }
+      count += other.count;
+      sum += other.sum;
+      return *this;
+    }
+  };
+
+  static std::atomic<double> nanosPerTscTick_;
+
+  std::atomic<uint32_t> sampleRate_{1};
+  std::atomic<Clock> clock_{Clock::kSteady};
+
+  FastStats<Buckets> buckets_;
+
+  const std::chrono::seconds windowSize_;
+
+  // protects the window state below
+  std::mutex windowMutex_;
+  // totals at the start of the current window, allocated by the first
+  // estimate() so that histograms never read do not pay for it.
+  std::unique_ptr<Buckets> windowBase_;
+  std::chrono::steady_clock::time_point windowStart_;
+  PercentileStats::Estimates lastEstimates_{};
+};
+
 class LatencyTracker {
  public:
   explicit LatencyTracker(PercentileStats& stats)
       : stats_(&stats), begin_(std::chrono::steady_clock::now()) {}
+  // tracks the latency only if the histogram samples it.
+  explicit LatencyTracker(LatencyHistogram& histogram) {
+    if (histogram.shouldSample()) {
+      histogram_ = &histogram;
+      beginTicks_ = histogram.now();
+    }
+  }
   LatencyTracker() {}
   ~LatencyTracker() {
     if (stats_) {
@@ -117,6 +306,8 @@ class LatencyTracker {
           std::chrono::duration_cast<std::chrono::nanoseconds>(tp - begin_)
               .count();
       stats_->trackValue(static_cast<double>(diffNanos), tp);
+    } else if (histogram_) {
+      histogram_->trackValue(histogram_->elapsedNanos(beginTicks_));
     }
   }
 
@@ -124,8 +315,12 @@ class LatencyTracker {
   LatencyTracker& operator=(const LatencyTracker&) = delete;
 
   LatencyTracker(LatencyTracker&& rhs) noexcept
-      : stats_(rhs.stats_), begin_(rhs.begin_) {
+      : stats_(rhs.stats_),
+        histogram_(rhs.histogram_),
+        begin_(rhs.begin_),
+        beginTicks_(rhs.beginTicks_) {
     rhs.stats_ = nullptr;
+    rhs.histogram_ = nullptr;
   }
 
   LatencyTracker& operator=(LatencyTracker&& rhs) noexcept {
@@ -138,7 +333,9 @@ class LatencyTracker {
 
  private:
   PercentileStats* stats_{nullptr};
+  LatencyHistogram* histogram_{nullptr};
   std::chrono::time_point<std::chrono::steady_clock> begin_;
+  uint64_t beginTicks_{0};
 };
 } // namespace util
 } // namespace cachelib
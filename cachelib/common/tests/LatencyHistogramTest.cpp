@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "cachelib/common/PercentileStats.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+using util::LatencyHistogram;
+
+TEST(LatencyHistogramTest, Buckets) {
+  // small values have a bucket of their own
+  for (uint64_t v = 0; v < LatencyHistogram::kSubBuckets; v++) {
+    EXPECT_EQ(v, LatencyHistogram::getBucketIndex(v));
+  }
+
+  for (size_t i = 0; i < LatencyHistogram::kNumBuckets; i++) {
+    const auto lower = LatencyHistogram::getBucketLowerBound(i);
+    const auto upper = LatencyHistogram::getBucketUpperBound(i);
+    EXPECT_EQ(i, LatencyHistogram::getBucketIndex(lower));
+    EXPECT_EQ(i, LatencyHistogram::getBucketIndex(upper));
+    EXPECT_LE(upper - lower, lower / LatencyHistogram::kSubBuckets);
+    if (i + 1 < LatencyHistogram::kNumBuckets) {
+      EXPECT_EQ(upper + 1, LatencyHistogram::getBucketLowerBound(i + 1));
+    }
+  }
+
+  // large values end up in the last bucket
+  EXPECT_EQ(LatencyHistogram::kNumBuckets - 1,
+            LatencyHistogram::getBucketIndex(LatencyHistogram::kMaxValue));
+  EXPECT_EQ(LatencyHistogram::kNumBuckets - 1,
+            LatencyHistogram::getBucketIndex(UINT64_MAX));
+}
+
+TEST(LatencyHistogramTest, Estimates) {
+  LatencyHistogram histogram{std::chrono::seconds{0}};
+  auto rst = histogram.estimate();
+  EXPECT_EQ(0, rst.p50);
+
+  for (uint64_t v = 1; v <= 10000; v++) {
+    histogram.trackValue(v * 100);
+  }
+  rst = histogram.estimate();
+  auto near = [](uint64_t expected, uint64_t actual) {
+    EXPECT_NEAR(static_cast<double>(expected), static_cast<double>(actual),
+                static_cast<double>(expected) / 32);
+  };
+  near(500050, rst.avg);
+  near(100, rst.p0);
+  near(500000, rst.p50);
+  near(900000, rst.p90);
+  near(990000, rst.p99);
+  near(1000000, rst.p100);
+  EXPECT_EQ(10000, histogram.getCount());
+
+  // nothing new tracked returns the last estimates
+  auto again = histogram.estimate();
+  EXPECT_EQ(rst.p50, again.p50);
+
+  // only values tracked since the last window count
+  for (int i = 0; i < 100; i++) {
+    histogram.trackValue(7);
+  }
+  rst = histogram.estimate();
+  EXPECT_EQ(7, rst.p0);
+  EXPECT_EQ(7, rst.p100);
+  EXPECT_EQ(7, rst.avg);
+}
+
+TEST(LatencyHistogramTest, MultipleThreads) {
+  LatencyHistogram histogram{std::chrono::seconds{0}};
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 8; t++) {
+    threads.emplace_back([&histogram, t]() {
+      for (int i = 0; i < 1000; i++) {
+        histogram.trackValue(t + 1);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // the threads are gone but what they tracked is kept
+  EXPECT_EQ(8000, histogram.getCount());
+  const auto rst = histogram.estimate();
+  EXPECT_EQ(1, rst.p0);
+  EXPECT_EQ(8, rst.p100);
+}
+
+TEST(LatencyHistogramTest, Sampling) {
+  LatencyHistogram histogram;
+  histogram.setSampleRate(10);
+  for (int i = 0; i < 1000; i++) {
+    util::LatencyTracker tracker{histogram};
+  }
+  EXPECT_EQ(100, histogram.getCount());
+
+  histogram.setSampleRate(1);
+  for (int i = 0; i < 1000; i++) {
+    util::LatencyTracker tracker{histogram};
+  }
+  EXPECT_EQ(1100, histogram.getCount());
+}
+
+TEST(LatencyHistogramTest, Clocks) {
+  for (auto clock :
+       {LatencyHistogram::Clock::kSteady, LatencyHistogram::Clock::kTsc}) {
+    LatencyHistogram histogram{std::chrono::seconds{0}};
+    histogram.setClock(clock);
+    {
+      util::LatencyTracker tracker{histogram};
+      std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+    const auto rst = histogram.estimate();
+    EXPECT_GE(rst.p50, 15'000'000);
+    EXPECT_LE(rst.p50, 2'000'000'000);
+  }
+}
+
+TEST(LatencyHistogramTest, TscCalibration) {
+  LatencyHistogram histogram;
+  histogram.setClock(LatencyHistogram::Clock::kTsc);
+  // the TSC is calibrated by setClock() and never from a tracker
+  if (histogram.getClock() == LatencyHistogram::Clock::kTsc) {
+    EXPECT_GT(LatencyHistogram::getNanosPerTscTick(), 0.0);
+  } else {
+    EXPECT_EQ(0.0, LatencyHistogram::getNanosPerTscTick());
+  }
+  EXPECT_EQ(LatencyHistogram::getNanosPerTscTick(),
+            LatencyHistogram::calibrateTsc());
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -21,8 +21,12 @@
  */
 
 #include <folly/logging/xlog.h>
+#include <folly/portability/Asm.h>
 
+#include <cstring>
+#include <type_traits>
 #include <typeinfo>
+#include <utility>
 
 #include "cachelib/common/Hash.h"
 
@@ -126,18 +130,37 @@ void callReplaceCb(const typename CC::ReplaceCb& cb,
   cb(key);
 }
 
+/** Whether the bucket descriptor B implements its own lookup through
+ * B::find(Bucket*, const Key&). */
+template <typename B, typename = void>
+struct HasBucketFind : std::false_type {};
+template <typename B>
+struct HasBucketFind<B,
+                     std::void_t<decltype(B::find(
+                         std::declval<typename B::Bucket*>(),
+                         std::declval<const typename B::Key&>()))>>
+    : std::true_type {};
+
 } // namespace detail
 
 template <typename C, typename A, typename B>
-CompactCache<C, A, B>::CompactCache(Allocator& allocator, bool allowPromotions)
-    : CompactCache(allocator, nullptr, nullptr, nullptr, allowPromotions) {}
+CompactCache<C, A, B>::CompactCache(Allocator& allocator,
+                                    bool allowPromotions,
+                                    bool optimisticReads)
+    : CompactCache(allocator,
+                   nullptr,
+                   nullptr,
+                   nullptr,
+                   allowPromotions,
+                   optimisticReads) {}
 
 template <typename C, typename A, typename B>
 CompactCache<C, A, B>::CompactCache(Allocator& allocator,
                                     RemoveCb removeCb,
                                     ReplaceCb replaceCb,
                                     ValidCb validCb,
-                                    bool allowPromotions)
+                                    bool allowPromotions,
+                                    bool optimisticReads)
     : allocator_(allocator),
       locks_(10 /* hashpower */, std::make_shared<MurmurHash2>()),
       removeCb_(removeCb),
@@ -146,6 +169,7 @@ CompactCache<C, A, B>::CompactCache(Allocator& allocator,
       bucketsPerChunk_(allocator_.getChunkSize() / sizeof(Bucket)),
       stats_{},
       allowPromotions_(allowPromotions),
+      optimisticReads_(optimisticReads),
       numChunks_(allocator_.getNumChunks()),
       pendingNumChunks_(0) {
   allocator_.attach(this);
@@ -367,7 +391,8 @@ CCacheReturn CompactCache<C, A, B>::get(
     size_t* size,
     bool shouldPromote) {
   int rv = callBucketFn(key,
-                        Operation::READ,
+                        optimisticReads_ ? Operation::READ_OPTIMISTIC
+                                         : Operation::READ,
                         timeout,
                         &SelfType::bucketGet,
                         val,
@@ -380,7 +405,7 @@ template <typename C, typename A, typename B>
 CCacheReturn CompactCache<C, A, B>::exists(
     const Key& key, const std::chrono::microseconds& timeout) {
   int rv = callBucketFn(key,
-                        Operation::READ,
+                        Operation::READ_OPTIMISTIC,
                         timeout,
                         &SelfType::bucketGet,
                         nullptr /* val */,
@@ -448,12 +473,17 @@ int CompactCache<C, A, B>::callBucketFn(
    * regarding whether we're allowed to modify the bucket in any way,
    * meaning we take an exclusive lock, or not, meaning we take a
    * shared lock for reads without promotion. We may need to promote
-   * in a second pass in the latter case. */
+   * in a second pass in the latter case. Optimistic reads take no lock
+   * unless the bucket keeps changing under them. They copy the bucket, so
+   * they only apply to the small buckets of fixed size values. */
   BucketReturn rv;
-  bool immutable_bucket = (op == Operation::READ);
+  bool immutable_bucket = (op != Operation::WRITE);
 
   /* 4) Call the request handler. */
-  if (immutable_bucket) {
+  if (kValuesFixedSize && op == Operation::READ_OPTIMISTIC &&
+      tryReadOptimistically(bucket, key, rv, f, args...)) {
+    /* the handler was called on a consistent copy of the bucket */
+  } else if (immutable_bucket) {
     auto lock = locks_.lockShared(timeout, bucket);
     if (!lock.locked()) {
       XDCHECK(timeout > std::chrono::microseconds::zero());
@@ -476,7 +506,7 @@ int CompactCache<C, A, B>::callBucketFn(
   /* 5.5) Promote if necessary from a read operation */
   if (UNLIKELY(rv == BucketReturn::PROMOTE)) {
     XDCHECK(immutable_bucket);
-    XDCHECK_EQ(op, Operation::READ);
+    XDCHECK_NE(op, Operation::WRITE);
 
     rv = BucketReturn::FOUND;
 
@@ -513,6 +543,38 @@ int CompactCache<C, A, B>::callBucketFn(
   return toInt(rv);
 }
 
+template <typename C, typename A, typename B>
+template <typename Fn, typename... Args>
+bool CompactCache<C, A, B>::tryReadOptimistically(Bucket* bucket,
+                                                  const Key& key,
+                                                  BucketReturn& rv,
+                                                  Fn f,
+                                                  Args... args) {
+  static_assert(std::is_trivially_copyable<Bucket>::value,
+                "Optimistic reads copy buckets byte by byte");
+  const auto& lock = locks_.getLockForRead(bucket);
+  typename std::aligned_storage<sizeof(Bucket), alignof(Bucket)>::type copy;
+  Bucket* snapshot = reinterpret_cast<Bucket*>(&copy);
+
+  for (unsigned int i = 0; i < kMaxOptimisticReadAttempts; i++) {
+    if (i > 0) {
+      ++stats_.tlStats().optimisticReadRetries;
+      folly::asm_volatile_pause();
+    }
+    const uint32_t version = lock.readBegin();
+    if (version & 1) {
+      continue;
+    }
+    std::memcpy(snapshot, bucket, sizeof(Bucket));
+    if (lock.readValidate(version)) {
+      rv = (this->*f)(snapshot, key, args...);
+      return true;
+    }
+  }
+  ++stats_.tlStats().optimisticReadFallbacks;
+  return false;
+}
+
 template <typename C, typename A, typename B>
 typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindChunk(
     size_t numChunks, const Key& key) {
@@ -662,10 +724,15 @@ CompactCache<C, A, B>::bucketPromote(Bucket* bucket, const Key& key) {
 }
 
 /** This iterates on all the entries in the bucket and compare their keys
- *  with the key until a match is found. */
+ *  with the key until a match is found, unless the bucket descriptor provides
+ *  its own lookup. */
 template <typename C, typename A, typename B>
 typename CompactCache<C, A, B>::EntryHandle CompactCache<C, A, B>::bucketFind(
     Bucket* bucket, const Key& key) {
+  if constexpr (detail::HasBucketFind<BucketDescriptor>::value) {
+    return BucketDescriptor::find(bucket, key);
+  }
+
   for (EntryHandle handle = BucketDescriptor::first(bucket); handle;
        handle.next()) {
     if (handle.key() == key) {
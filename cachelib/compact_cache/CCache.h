@@ -123,7 +123,9 @@ class CompactCache : public ICompactCache {
   constexpr static bool kHasValues = C::kHasValues;
   constexpr static bool kValuesFixedSize = C::kValuesFixedSize;
 
-  enum Operation { READ, WRITE };
+  // READ_OPTIMISTIC reads a copy of the bucket taken without locking it and
+  // falls back to READ when writers keep the bucket busy.
+  enum Operation { READ, WRITE, READ_OPTIMISTIC };
 
   /** Type of the callbacks called when an entry is removed.
    * The type of the callback depends on the type of the values in this
@@ -166,8 +168,12 @@ class CompactCache : public ICompactCache {
    *                        the allocator for the lifetime of the compact cache.
    * @param allowPromotions Whether we should allow promotions on read
    *                        operations. True by default
+   * @param optimisticReads Whether get() reads buckets without locking them.
+   *                        False by default
    */
-  explicit CompactCache(Allocator& allocator, bool allowPromotions = true);
+  explicit CompactCache(Allocator& allocator,
+                        bool allowPromotions = true,
+                        bool optimisticReads = false);
 
   /**
    * Construct a new compact cache instance with callbacks to track when
@@ -182,12 +188,18 @@ class CompactCache : public ICompactCache {
    *                        valid
    * @param allowPromotions Whether we should allow promotions on read
    *                        operations. True by default
+   * @param optimisticReads Whether get() reads buckets without locking them,
+   *                        validating the copy it read against the bucket
+   *                        lock's version instead. Suits caches with a high
+   *                        read rate. Only applies to fixed size values.
+   *                        False by default
    */
   CompactCache(Allocator& allocator,
                RemoveCb removeCb,
                ReplaceCb replaceCb,
                ValidCb validCb,
-               bool allowPromotions = true);
+               bool allowPromotions = true,
+               bool optimisticReads = false);
 
   /**
    * Destructor will detach the allocator. Only after a CompactCache instance
@@ -332,7 +344,9 @@ class CompactCache : public ICompactCache {
 
   /**
    * Check if the key exists in the compact cache. Useful if the caller wants
-   * to check for only existence and not copy the value out.
+   * to check for only existence and not copy the value out. For fixed size
+   * values, this never writes to the bucket or its lock unless concurrent
+   * writes keep the bucket busy.
    *
    * @param key             key of the entry
    * @param timeout         if greater than 0, take a timed lock
@@ -543,6 +557,24 @@ class CompactCache : public ICompactCache {
    */
   EntryHandle bucketFind(Bucket* bucket, const Key& key);
 
+  /**
+   * Copy the bucket without locking it and call the request handler on the
+   * copy if no writer modified the bucket while it was copied.
+   *
+   * @param bucket  Bucket to read.
+   * @param rv      Set to the result of the handler if it was called.
+   * @param f       Read only handler, same as for callBucketFn.
+   *
+   * @return true if the handler was called on a consistent copy, false if
+   *         the bucket was busy for every attempt.
+   */
+  template <typename Fn, typename... Args>
+  bool tryReadOptimistically(Bucket* bucket,
+                             const Key& key,
+                             BucketReturn& rv,
+                             Fn f,
+                             Args... args);
+
   /**
    * Data for a compact cache instance.
    * The arena must remain alive (i.e. not free'd) during the lifetime of the
@@ -559,6 +591,11 @@ class CompactCache : public ICompactCache {
   util::FastStats<CCacheStats> stats_;
   const bool allowPromotions_; /**< Whether promotions are allowed on read
                                     operations */
+  const bool optimisticReads_; /**< Whether get() reads without locking */
+
+  /** Max number of times an optimistic read is attempted before falling back
+   * to the bucket lock. */
+  static constexpr unsigned int kMaxOptimisticReadAttempts = 4;
 
  protected:
   // expose these two fields for test hack
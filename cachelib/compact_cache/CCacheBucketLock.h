@@ -18,12 +18,88 @@
 
 #include <folly/SharedMutex.h>
 
+#include <atomic>
+
 #include "cachelib/common/Hash.h"
 #include "cachelib/common/Mutex.h"
 
 namespace facebook {
 namespace cachelib {
 
+/**
+ * A shared mutex paired with a version number, so that the buckets it guards
+ * can also be read without taking the lock (seqlock). The version is bumped
+ * when the exclusive lock is acquired and again when it is released, so it is
+ * odd while a writer holds the lock. A reader copies what it needs between
+ * readBegin() and readValidate() and only uses the copy if validation
+ * succeeds. Optimistic readers never write to the lock's cache line.
+ */
+class CCSharedMutex {
+ public:
+  void lock() {
+    mutex_.lock();
+    beginWrite();
+  }
+
+  template <typename Rep, typename Period>
+  bool try_lock_for(const std::chrono::duration<Rep, Period>& timeout) {
+    if (!mutex_.try_lock_for(timeout)) {
+      return false;
+    }
+    beginWrite();
+    return true;
+  }
+
+  void unlock() {
+    endWrite();
+    mutex_.unlock();
+  }
+
+  void lock_shared(folly::SharedMutexToken& token) {
+    mutex_.lock_shared(token);
+  }
+
+  template <typename Rep, typename Period>
+  bool try_lock_shared_for(const std::chrono::duration<Rep, Period>& timeout,
+                           folly::SharedMutexToken& token) {
+    return mutex_.try_lock_shared_for(timeout, token);
+  }
+
+  void unlock_shared(folly::SharedMutexToken& token) {
+    mutex_.unlock_shared(token);
+  }
+
+  // Start an optimistic read.
+  // @return the version to validate the read against, or an odd version if
+  //         a writer holds the lock, in which case the read will not validate.
+  uint32_t readBegin() const noexcept {
+    return version_.load(std::memory_order_acquire);
+  }
+
+  // @return true if no writer held the lock since readBegin() returned
+  //         _version_, meaning that what was read in between is consistent.
+  bool readValidate(uint32_t version) const noexcept {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 &&
+           version_.load(std::memory_order_relaxed) == version;
+  }
+
+ private:
+  void beginWrite() noexcept {
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  void endWrite() noexcept {
+    version_.store(version_.load(std::memory_order_relaxed) + 1,
+                   std::memory_order_release);
+  }
+
+  folly::SharedMutex mutex_;
+  std::atomic<uint32_t> version_{0};
+};
+
 /**
  * CCReadHolder and CCWriteHolder is a duplication of ReadHolder and WriteHolder
  * in SharedMutex. They add the funtionality to do
@@ -34,7 +110,7 @@ namespace cachelib {
 class CCReadHolder {
  public:
   // construct a read lock holder and grab the lock
-  explicit CCReadHolder(folly::SharedMutex& lock) : lock_(&lock) {
+  explicit CCReadHolder(CCSharedMutex& lock) : lock_(&lock) {
     lock_->lock_shared(token_);
   }
 
@@ -42,7 +118,7 @@ class CCReadHolder {
   // 1. try to grab the lock for a duration specified by _timeout_ if _timeout_
   //    is not zero OR
   // 2. just grab the lock
-  CCReadHolder(folly::SharedMutex& lock,
+  CCReadHolder(CCSharedMutex& lock,
                const std::chrono::microseconds& timeout)
       : lock_(&lock) {
     if (timeout == std::chrono::microseconds::zero()) {
@@ -81,7 +157,7 @@ class CCReadHolder {
 
  private:
   // pointer to the lock
-  folly::SharedMutex* lock_;
+  CCSharedMutex* lock_;
 
   // lock token used for faster unlock_shared() to quickly find the right lock
   folly::SharedMutexToken token_;
@@ -92,7 +168,7 @@ class CCWriteHolder {
   CCWriteHolder() : lock_(nullptr) {}
 
   // construct a write lock holder and grab the lock
-  explicit CCWriteHolder(folly::SharedMutex& lock) : lock_(&lock) {
+  explicit CCWriteHolder(CCSharedMutex& lock) : lock_(&lock) {
     lock_->lock();
   }
 
@@ -100,7 +176,7 @@ class CCWriteHolder {
   // 1. try to grab the lock for a duration specified by _timeout_ if _timeout_
   //    is not zero OR
   // 2. just grab the lock
-  CCWriteHolder(folly::SharedMutex& lock,
+  CCWriteHolder(CCSharedMutex& lock,
                 const std::chrono::microseconds& timeout)
       : lock_(&lock) {
     if (timeout == std::chrono::microseconds::zero()) {
@@ -137,10 +213,18 @@ class CCWriteHolder {
 
  private:
   // pointer to the lock
-  folly::SharedMutex* lock_;
+  CCSharedMutex* lock_;
 };
 
-using CCRWBucketLocks =
-    RWBucketLocks<folly::SharedMutex, CCReadHolder, CCWriteHolder>;
+class CCRWBucketLocks
+    : public RWBucketLocks<CCSharedMutex, CCReadHolder, CCWriteHolder> {
+ public:
+  using RWBucketLocks::RWBucketLocks;
+
+  // Get the lock for the bucket to read it optimistically
+  const CCSharedMutex& getLockForRead(void* bucket) noexcept {
+    return getLock(bucket);
+  }
+};
 } // namespace cachelib
 } // namespace facebook
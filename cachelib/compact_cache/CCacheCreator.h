@@ -74,6 +74,26 @@ struct CCacheCreator {
   using type = CompactCache<Descriptor, AllocatorT>;
 };
 
+/* Same as CCacheCreator, but the buckets keep their keys contiguous and
+ * match them with vector instructions. Keys must be 8 or 16 bytes. The bucket
+ * layout differs from the one of CCacheCreator, so a compact cache can not
+ * switch between the two across a warm roll. */
+template <typename AllocatorT, typename KeyT, typename ValueT = NoValue>
+struct CCacheSimdCreator {
+ private:
+  using ValueDesc = typename std::conditional<std::is_integral<ValueT>::value,
+                                              CounterValueDescriptor<ValueT>,
+                                              ValueDescriptor<ValueT>>::type;
+
+  using Descriptor = CompactCacheDescriptor<KeyT, ValueDesc>;
+
+ public:
+  using type =
+      CompactCache<Descriptor,
+                   AllocatorT,
+                   FixedLruSimdBucket<Descriptor, NB_ENTRIES_PER_BUCKET>>;
+};
+
 /**
  * The following trait can be used for creating a compact cache that stores
  * values of a variable size.
@@ -26,10 +26,31 @@
  *
  * This implementation provides an lru mechanism by moving the promoted entry to
  * the top and shifting all the entries that were above it down one position.
+ *
+ * FixedLruSimdBucket is a variant for keys of 8 or 16 bytes that stores the
+ * keys of a bucket contiguously, so that a lookup compares the key against all
+ * of them with a few vector instructions. The LRU order is kept in a separate
+ * array of slot indexes, so that promotions and insertions only shift those
+ * indexes instead of whole entries.
  */
 
+#include <folly/Portability.h>
+#include <folly/lang/Bits.h>
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#if FOLLY_X64
+#include <immintrin.h>
+#endif
+
 namespace facebook {
 namespace cachelib {
+namespace tests {
+class CompactCacheSimdBucket;
+} // namespace tests
 
 template <typename CompactCacheDescriptor, unsigned EntriesPerBucket>
 struct FixedLruBucket {
@@ -277,5 +298,300 @@ struct FixedLruBucket {
     memcpy(destPtr, srcPtr, sizeof(T));
   }
 };
+
+/**
+ * Bucket descriptor with the same LRU semantics as FixedLruBucket, for keys of
+ * 8 or 16 bytes. A bucket stores its keys, then its values, each in an array
+ * indexed by slot. The LRU order is an array of slot indexes, most recently
+ * used first, followed by a bitmask of the occupied slots. A zeroed bucket is
+ * empty.
+ *
+ * Keys are matched by comparing their bytes, like they are hashed to find
+ * their bucket.
+ *
+ * The layout differs from FixedLruBucket, so a compact cache can not switch
+ * between the two descriptors across a warm roll.
+ */
+template <typename CompactCacheDescriptor, unsigned EntriesPerBucket>
+struct FixedLruSimdBucket {
+ public:
+  using Descriptor = CompactCacheDescriptor;
+  using ValueDescriptor = typename Descriptor::ValueDescriptor;
+  using Key = typename Descriptor::Key;
+  using Value = typename ValueDescriptor::Value;
+
+  constexpr static int kEntriesPerBucket = EntriesPerBucket;
+  constexpr static bool kHasValues = Descriptor::kHasValues;
+
+  static_assert(Descriptor::kValuesFixedSize,
+                "This bucket descriptor must be used with values of a fixed"
+                "size");
+  static_assert(sizeof(Key) == 8 || sizeof(Key) == 16,
+                "This bucket descriptor must be used with keys of 8 or 16 "
+                "bytes");
+  static_assert(EntriesPerBucket > 0 && EntriesPerBucket <= 32,
+                "Occupied slots must fit in a 32 bit mask");
+
+  struct Bucket {
+    Key keys[kEntriesPerBucket];
+    /* Expands to NoValue (size 0) if this cache does not store values */
+    Value vals[kEntriesPerBucket];
+    /* Slots of the entries, from most to least recently used. Only the first
+     * popcount(occupied) are meaningful. */
+    uint8_t lru[kEntriesPerBucket];
+    /* Bit i is set if slot i holds an entry. */
+    uint32_t occupied;
+  } __attribute__((__packed__));
+
+  /**
+   * Handle to an entry, identified by its position in the LRU order.
+   * Iterating goes from the most to the least recently used entry.
+   */
+  class EntryHandle {
+   public:
+    /** Return true if the handle points to an entry. */
+    explicit operator bool() const {
+      return pos_ >= 0 && pos_ < numEntries(*bucket_);
+    }
+
+    /** Move to the next entry. Must be called on a valid handle. */
+    void next() {
+      XDCHECK(*this);
+      ++pos_;
+    }
+
+    Key key() const { return bucket_->keys[slot()]; }
+    Value* val() const { return &bucket_->vals[slot()]; }
+    constexpr size_t size() const { return sizeof(Value); }
+
+    EntryHandle() : bucket_(nullptr), pos_(-1) {}
+    EntryHandle(Bucket* bucket, int pos) : bucket_(bucket), pos_(pos) {}
+
+    bool isBucketTail() const { return *this && pos_ == kEntriesPerBucket - 1; }
+
+   private:
+    uint8_t slot() const { return bucket_->lru[pos_]; }
+
+    Bucket* bucket_;
+    int pos_;
+    friend struct FixedLruSimdBucket<CompactCacheDescriptor, EntriesPerBucket>;
+  };
+
+  /** Type of the callback to be called when an entry is evicted. */
+  using EvictionCb = std::function<void(const EntryHandle& handle)>;
+
+  /** Return a handle to the most recently used entry of the bucket. */
+  static EntryHandle first(Bucket* bucket) { return EntryHandle(bucket, 0); }
+
+  static uint32_t nEntriesCapacity(const Bucket& /*bucket*/) {
+    return kEntriesPerBucket;
+  }
+
+  /**
+   * Find the entry for the key.
+   *
+   * @return handle to the entry or an invalid handle if it is not found.
+   */
+  static EntryHandle find(Bucket* bucket, const Key& key) {
+    const uint32_t matches = matchKeys(*bucket, key) & bucket->occupied;
+    if (matches == 0) {
+      return EntryHandle();
+    }
+    const auto slot = static_cast<uint8_t>(folly::findFirstSet(matches) - 1);
+    const int n = numEntries(*bucket);
+    for (int pos = 0; pos < n; pos++) {
+      if (bucket->lru[pos] == slot) {
+        return EntryHandle(bucket, pos);
+      }
+    }
+    XDCHECK(false) << "occupied slot missing from the LRU order";
+    return EntryHandle();
+  }
+
+  /**
+   * Insert a new entry as the most recently used one, evicting the least
+   * recently used entry if the bucket is full.
+   *
+   * @return 1 if an entry was evicted, 0 otherwise.
+   */
+  static bool insert(Bucket* bucket,
+                     const Key& key,
+                     const Value* val,
+                     size_t,
+                     EvictionCb evictionCb) {
+    bool evicted = false;
+    const int n = numEntries(*bucket);
+    uint8_t slot;
+    if (n == kEntriesPerBucket) {
+      XDCHECK(evictionCb);
+      evictionCb(EntryHandle(bucket, kEntriesPerBucket - 1));
+      evicted = true;
+      slot = bucket->lru[kEntriesPerBucket - 1];
+    } else {
+      slot = static_cast<uint8_t>(folly::findFirstSet(~bucket->occupied) - 1);
+      bucket->occupied |= 1u << slot;
+    }
+
+    const int shift = evicted ? kEntriesPerBucket - 1 : n;
+    memmove(&bucket->lru[1], &bucket->lru[0], shift);
+    bucket->lru[0] = slot;
+
+    memcpy(&bucket->keys[slot], &key, sizeof(Key));
+    if (kHasValues) {
+      memcpy(&bucket->vals[slot], val, sizeof(Value));
+    }
+    return evicted ? 1 : 0;
+  }
+
+  /**
+   * Promote an entry to most recently used.
+   *
+   * @param handle Handle of the entry to be promoted. Points to the entry's
+   *               new position after this returns.
+   */
+  static void promote(EntryHandle& handle) {
+    XDCHECK(handle);
+    if (handle.pos_ != 0) {
+      auto* lru = handle.bucket_->lru;
+      const uint8_t slot = lru[handle.pos_];
+      memmove(&lru[1], &lru[0], handle.pos_);
+      lru[0] = slot;
+      handle.pos_ = 0;
+    }
+  }
+
+  static inline bool needs_promote(EntryHandle& handle) {
+    XDCHECK(handle);
+    return handle.pos_ > kEntriesPerBucket / 4;
+  }
+
+  /**
+   * Delete an entry.
+   *
+   * @param handle Handle of the entry to be deleted. After this returns, the
+   *               handle points to the next entry, if any, or is invalid.
+   */
+  static void del(EntryHandle& handle) {
+    XDCHECK(handle);
+    Bucket* bucket = handle.bucket_;
+    const int n = numEntries(*bucket);
+    const uint8_t slot = bucket->lru[handle.pos_];
+    memmove(&bucket->lru[handle.pos_],
+            &bucket->lru[handle.pos_ + 1],
+            n - handle.pos_ - 1);
+    bucket->lru[n - 1] = 0;
+    bucket->occupied &= ~(1u << slot);
+    bzero(&bucket->keys[slot], sizeof(Key));
+    bzero(&bucket->vals[slot], sizeof(Value));
+  }
+
+  /** Update the value of an entry. This never evicts. */
+  static void updateVal(EntryHandle& handle,
+                        const Value* val,
+                        size_t,
+                        EvictionCb /*evictionCb*/) {
+    if (kHasValues) {
+      XDCHECK(val);
+      memcpy(handle.val(), val, sizeof(Value));
+    }
+  }
+
+  /** Copy an entry's value to a buffer. */
+  static void copyVal(Value* val, size_t*, EntryHandle& handle) {
+    XDCHECK(handle);
+    XDCHECK(val);
+    memcpy(val, handle.val(), sizeof(Value));
+  }
+
+ private:
+  friend class tests::CompactCacheSimdBucket;
+
+  /**
+   * Compare the key against the keys of every slot, occupied or not.
+   *
+   * @return bitmask with bit i set if slot i holds the same bytes as the key.
+   */
+  static uint32_t matchKeys(const Bucket& bucket, const Key& key) {
+#if FOLLY_X64
+    if (hasAvx2()) {
+      return matchKeysAvx2(bucket, key);
+    }
+#endif
+    return matchKeysScalar(bucket, key);
+  }
+
+  /* Same as matchKeys(), one slot at a time. */
+  static uint32_t matchKeysScalar(const Bucket& bucket, const Key& key) {
+    return matchKeysFrom(bucket, key, 0, 0);
+  }
+
+#if FOLLY_X64
+  /* Return true if the cpu we run on supports AVX2. The vector path is
+   * compiled for AVX2 through the target attribute, whatever the flags of the
+   * build, and only taken when this returns true. */
+  static bool hasAvx2() {
+    static const bool kHasAvx2 = [] {
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return kHasAvx2;
+  }
+
+  /* Same as matchKeys(), several slots per AVX2 instruction. Must only be
+   * called if hasAvx2() returns true. */
+  __attribute__((__target__("avx2"))) static uint32_t matchKeysAvx2(
+      const Bucket& bucket, const Key& key) {
+    constexpr int kWords = sizeof(Key) / sizeof(uint64_t);
+    // each 256 bit load covers 4 keys of 8 bytes or 2 keys of 16 bytes
+    constexpr int kKeysPerVector = 32 / sizeof(Key);
+    uint64_t needle[kWords];
+    memcpy(needle, &key, sizeof(Key));
+    const auto* words = reinterpret_cast<const uint8_t*>(bucket.keys);
+
+    __m256i pattern;
+    if constexpr (kWords == 1) {
+      pattern = _mm256_set1_epi64x(static_cast<int64_t>(needle[0]));
+    } else {
+      pattern = _mm256_broadcastsi128_si256(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(needle)));
+    }
+    uint32_t matches = 0;
+    int slot = 0;
+    for (; slot + kKeysPerVector <= kEntriesPerBucket;
+         slot += kKeysPerVector) {
+      const __m256i keys = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(words + slot * sizeof(Key)));
+      // one bit per 8 byte word that matches
+      uint32_t eq = static_cast<uint32_t>(_mm256_movemask_pd(
+          _mm256_castsi256_pd(_mm256_cmpeq_epi64(keys, pattern))));
+      if constexpr (kWords == 2) {
+        // a key matches if both of its words do
+        eq &= eq >> 1;
+        eq = (eq & 1) | ((eq >> 1) & 2);
+      }
+      matches |= eq << slot;
+    }
+    return matchKeysFrom(bucket, key, slot, matches);
+  }
+#endif
+
+  static int numEntries(const Bucket& bucket) {
+    return folly::popcount(bucket.occupied);
+  }
+
+  /* Add the slots from @slot onwards that match the key to @matches. */
+  static uint32_t matchKeysFrom(const Bucket& bucket,
+                                const Key& key,
+                                int slot,
+                                uint32_t matches) {
+    const auto* words = reinterpret_cast<const uint8_t*>(bucket.keys);
+    for (; slot < kEntriesPerBucket; slot++) {
+      if (memcmp(words + slot * sizeof(Key), &key, sizeof(Key)) == 0) {
+        matches |= 1u << slot;
+      }
+    }
+    return matches;
+  }
+};
 } // namespace cachelib
 } // namespace facebook
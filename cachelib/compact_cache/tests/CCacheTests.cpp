@@ -16,9 +16,12 @@
 
 #include "cachelib/compact_cache/tests/CCacheTests.h"
 
+#include <folly/Random.h>
 #include <folly/init/Init.h>
 #include <gtest/gtest.h>
 
+#include <random>
+
 #include "cachelib/allocator/CacheAllocator.h"
 #include "cachelib/common/TestUtils.h"
 #include "cachelib/compact_cache/allocators/TestAllocator.h"
@@ -82,6 +85,21 @@ class CompactCacheTests : public ::testing::Test {
     using CC = typename CCacheCreator<T, Buffer<93>, Buffer<13>>::type;
     CompactCacheRunBasicTests<CC>();
   }
+
+  void testSimdKey8() {
+    using CC = typename CCacheSimdCreator<T, Buffer<8>>::type;
+    CompactCacheRunBasicTests<CC>();
+  }
+
+  void testSimdKey8ToInt() {
+    using CC = typename CCacheSimdCreator<T, Buffer<8>, Int>::type;
+    CompactCacheRunBasicTests<CC>();
+  }
+
+  void testSimdKey16ToStr() {
+    using CC = typename CCacheSimdCreator<T, Buffer<16>, Buffer<13>>::type;
+    CompactCacheRunBasicTests<CC>();
+  }
 };
 
 using Allocators = ::testing::Types<TestAllocator>;
@@ -99,6 +117,63 @@ TYPED_TEST(CompactCacheTests, Str2Int) { this->testStr2Int(); }
 
 TYPED_TEST(CompactCacheTests, Str2Str) { this->testStr2Str(); }
 
+TYPED_TEST(CompactCacheTests, SimdKey8) { this->testSimdKey8(); }
+
+TYPED_TEST(CompactCacheTests, SimdKey8ToInt) { this->testSimdKey8ToInt(); }
+
+TYPED_TEST(CompactCacheTests, SimdKey16ToStr) { this->testSimdKey16ToStr(); }
+
+// Friend of FixedLruSimdBucket, to test its private key matching helpers.
+class CompactCacheSimdBucket : public ::testing::Test {
+ protected:
+  // Check that every way of matching a key in a simd bucket agrees with a
+  // plain byte comparison of every slot.
+  template <typename KeyT>
+  static void testMatchKeys() {
+    using BucketDescriptor =
+        typename CCacheSimdCreator<TestAllocator, KeyT>::type::BucketDescriptor;
+    using Bucket = typename BucketDescriptor::Bucket;
+    constexpr int kEntries = BucketDescriptor::kEntriesPerBucket;
+
+    // Bytes are 0 or 1, so that keys often share one of their words, or all
+    // of their bytes with the key looked up
+    std::mt19937 rng(folly::Random::rand32());
+    auto fill = [&rng](void* dst, size_t size) {
+      auto* bytes = reinterpret_cast<uint8_t*>(dst);
+      for (size_t i = 0; i < size; i++) {
+        bytes[i] = rng() % 2;
+      }
+    };
+    for (int i = 0; i < 10000; i++) {
+      Bucket bucket{};
+      fill(bucket.keys, sizeof(bucket.keys));
+      KeyT key;
+      fill(&key, sizeof(KeyT));
+      if (rng() % 2) {
+        memcpy(&bucket.keys[rng() % kEntries], &key, sizeof(KeyT));
+      }
+
+      uint32_t expected = 0;
+      for (int slot = 0; slot < kEntries; slot++) {
+        if (memcmp(&bucket.keys[slot], &key, sizeof(KeyT)) == 0) {
+          expected |= 1u << slot;
+        }
+      }
+      ASSERT_EQ(expected, BucketDescriptor::matchKeysScalar(bucket, key));
+      ASSERT_EQ(expected, BucketDescriptor::matchKeys(bucket, key));
+#if FOLLY_X64
+      if (BucketDescriptor::hasAvx2()) {
+        ASSERT_EQ(expected, BucketDescriptor::matchKeysAvx2(bucket, key));
+      }
+#endif
+    }
+  }
+};
+
+TEST_F(CompactCacheSimdBucket, MatchKeys8) { testMatchKeys<Buffer<8>>(); }
+
+TEST_F(CompactCacheSimdBucket, MatchKeys16) { testMatchKeys<Buffer<16>>(); }
+
 template <typename T>
 class CompactCacheAllocatorTests : public ::testing::Test {};
 
@@ -108,7 +183,8 @@ using CompactCacheTypes = ::testing::Types<
     typename CCacheCreator<CCacheAllocator, Int, Buffer<51>>::type,
     typename CCacheCreator<CCacheAllocator, Buffer<67>>::type,
     typename CCacheCreator<CCacheAllocator, Buffer<17>, Int>::type,
-    typename CCacheCreator<CCacheAllocator, Buffer<93>, Buffer<13>>::type>;
+    typename CCacheCreator<CCacheAllocator, Buffer<93>, Buffer<13>>::type,
+    typename CCacheSimdCreator<CCacheAllocator, Buffer<16>, Int>::type>;
 TYPED_TEST_CASE(CompactCacheAllocatorTests, CompactCacheTypes);
 
 TYPED_TEST(CompactCacheAllocatorTests, warmroll) {
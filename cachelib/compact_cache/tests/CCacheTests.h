@@ -24,7 +24,9 @@
 #include <folly/Random.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <memory>
+#include <thread>
 
 #include "cachelib/compact_cache/CCacheCreator.h"
 
@@ -154,7 +156,8 @@ class TestSetup {
   explicit TestSetup(int nbuckets,
                      bool allowPromotions = true,
                      typename CC::RemoveCb removeCb = 0,
-                     typename CC::ReplaceCb replaceCb = 0)
+                     typename CC::ReplaceCb replaceCb = 0,
+                     bool optimisticReads = false)
       : numChunks_((nbuckets + BUCKETS_PER_CHUNK - 1) / BUCKETS_PER_CHUNK),
         chunkSize_(std::min(nbuckets, BUCKETS_PER_CHUNK) *
                    sizeof(typename CC::Bucket)),
@@ -163,7 +166,8 @@ class TestSetup {
                        removeCb,
                        replaceCb,
                        0 /* validCb */,
-                       allowPromotions)) {
+                       allowPromotions,
+                       optimisticReads)) {
     setup();
   }
 
@@ -607,6 +611,70 @@ static void testTailHits(bool allowPromotions) {
   EXPECT_EQ(expectedTailHits, ccache->getStats().tailHits);
 }
 
+template <typename CC>
+static void testOptimisticReads(bool allowPromotions) {
+  constexpr int numEntries = CC::BucketDescriptor::kEntriesPerBucket;
+  RemoveCbWrapper<CC> removeCb;
+  TestSetup<CC> setup(1, allowPromotions, removeCb.getCallable(),
+                      0 /* replaceCb */, true /* optimisticReads */);
+  auto ccache = setup.getCache();
+
+  typename CC::Value val;
+  typename CC::Value out;
+
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->get(1, &out));
+  ASSERT_TRUE(out.isEmpty());
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->exists(1));
+
+  /** fill the bucket */
+  for (unsigned int i = 1; i <= numEntries; i++) {
+    val = i;
+    ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(i, &val));
+  }
+  for (unsigned int i = 1; i <= numEntries; i++) {
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->exists(i));
+  }
+
+  /** exists never promotes, get does when allowed */
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->get(1, &out));
+  val = 1;
+  ASSERT_EQ(val, out);
+  val = numEntries + 1;
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(numEntries + 1, &val));
+  ASSERT_EQ(1, removeCb.numCalls);
+  typename CC::Key firstKey(1);
+  if (allowPromotions) {
+    ASSERT_NE(firstKey, removeCb.key);
+  } else {
+    ASSERT_EQ(firstKey, removeCb.key);
+  }
+
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->del(numEntries + 1));
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->exists(numEntries + 1));
+  ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->get(numEntries + 1, &out));
+
+  /** readers racing with a writer only ever see whole values */
+  const typename CC::Value val1(0x1111);
+  const typename CC::Value val2(0x2222);
+  ASSERT_EQ(CCacheReturn::FOUND, ccache->set(2, &val1));
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    for (int i = 0; !stop; i++) {
+      ccache->set(2, i % 2 == 0 ? &val2 : &val1);
+    }
+  });
+  for (int i = 0; i < 100000; i++) {
+    typename CC::Value read;
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->get(2, &read));
+    ASSERT_TRUE(read == val1 || read == val2);
+  }
+  stop = true;
+  writer.join();
+
+  const auto stats = ccache->getStats();
+  EXPECT_LE(stats.optimisticReadFallbacks, stats.optimisticReadRetries);
+}
+
 /****************************************************************************/
 /** Main testing functions */
 
@@ -637,6 +705,7 @@ static void CompactCacheRunBasicTestsUtil(bool allowPromotions) {
   testPurgeCallback<CC>(allowPromotions);
   testPromotionMode<CC>(allowPromotions);
   testTailHits<CC>(allowPromotions);
+  testOptimisticReads<CC>(allowPromotions);
 }
 
 /**
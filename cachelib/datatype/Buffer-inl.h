@@ -199,20 +199,91 @@ void BufferManager<C>::compact() {
   // and N is the number of chained items to compact.
   auto allocs = cache_->viewAsWritableChainedAllocs(*parent_);
   for (auto& item : allocs.getChain()) {
-    Buffer* buffer = item.template getMemoryAs<Buffer>();
+    if (item.template getMemoryAs<Buffer>()->wastedBytes() == 0) {
+      continue;
+    }
+    compactBuffer(item);
+  }
+  getBufferCompactionCounters().numFullCompactions.inc();
+}
 
-    if (buffer->wastedBytes() == 0) {
+template <typename C>
+size_t BufferManager<C>::compactIncrementally(size_t maxBytes,
+                                              const CompactionCB& cb) {
+  std::vector<uint32_t> candidates;
+  for (uint32_t i = 0; i < buffers_.size(); i++) {
+    if (getBuffer(i)->wastedBytes() > 0) {
+      candidates.push_back(i);
+    }
+  }
+  if (candidates.empty()) {
+    return 0;
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [this](uint32_t a, uint32_t b) {
+              return getBuffer(a)->wastedBytes() > getBuffer(b)->wastedBytes();
+            });
+
+  auto liveBytesOf = [this](uint32_t index) -> size_t {
+    const Buffer* buffer = getBuffer(index);
+    return buffer->capacity() - buffer->remainingBytes() -
+           buffer->wastedBytes();
+  };
+  auto compactAt = [this, &cb](uint32_t index) {
+    compactBuffer(*buffers_[index]);
+    Buffer* buffer = getBuffer(index);
+    for (auto itr = buffer->begin(); itr != buffer->end(); ++itr) {
+      cb(&*itr, BufferAddr{index, itr.getDataOffset()});
+    }
+  };
+
+  // Skip the buffers that do not fit in what is left of the budget, a later
+  // one with fewer live bytes may still fit.
+  size_t bytesCopied = 0;
+  size_t numCompacted = 0;
+  for (const auto index : candidates) {
+    const size_t liveBytes = liveBytesOf(index);
+    if (bytesCopied + liveBytes > maxBytes) {
       continue;
     }
+    compactAt(index);
+    bytesCopied += liveBytes;
+    numCompacted++;
+  }
 
-    auto tmpBufferStorage = std::make_unique<uint8_t[]>(item.getSize());
-    Buffer* tmpBuffer = new (tmpBufferStorage.get()) Buffer(buffer->capacity());
-    XDCHECK_EQ(buffer->capacity(), tmpBuffer->capacity());
+  // No buffer fits in the budget. Compact the cheapest one so that wasted
+  // space is still reclaimed; this is the only case the step copies more
+  // than maxBytes, and by at most one buffer.
+  if (numCompacted == 0) {
+    compactAt(*std::min_element(candidates.begin(), candidates.end(),
+                                [&liveBytesOf](uint32_t a, uint32_t b) {
+                                  return liveBytesOf(a) < liveBytesOf(b);
+                                }));
+    numCompacted++;
+  }
+  getBufferCompactionCounters().numIncrementalCompactions.inc();
+  return numCompacted;
+}
 
-    buffer->compact(*tmpBuffer);
+template <typename C>
+void BufferManager<C>::compactBuffer(Item& item) {
+  Buffer* buffer = item.template getMemoryAs<Buffer>();
+  const uint32_t wastedBytes = buffer->wastedBytes();
+  const uint32_t liveBytes =
+      buffer->capacity() - buffer->remainingBytes() - wastedBytes;
 
-    new (buffer) Buffer(tmpBuffer->capacity(), *tmpBuffer);
-  }
+  auto tmpBufferStorage = std::make_unique<uint8_t[]>(item.getSize());
+  Buffer* tmpBuffer = new (tmpBufferStorage.get()) Buffer(buffer->capacity());
+  XDCHECK_EQ(buffer->capacity(), tmpBuffer->capacity());
+
+  buffer->compact(*tmpBuffer);
+
+  new (buffer) Buffer(tmpBuffer->capacity(), *tmpBuffer);
+
+  auto& counters = getBufferCompactionCounters();
+  counters.numBuffersCompacted.inc();
+  counters.numBytesCopied.add(liveBytes);
+  counters.numBytesReclaimed.add(wastedBytes);
 }
 
 template <typename C>
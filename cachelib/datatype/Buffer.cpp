@@ -18,7 +18,36 @@
 
 namespace facebook {
 namespace cachelib {
+void BufferCompactionStats::visit(const util::CounterVisitor& visitor) const {
+  visitor("datatype_compaction_full", numFullCompactions,
+          util::CounterVisitor::CounterType::RATE);
+  visitor("datatype_compaction_incremental", numIncrementalCompactions,
+          util::CounterVisitor::CounterType::RATE);
+  visitor("datatype_compaction_buffers", numBuffersCompacted,
+          util::CounterVisitor::CounterType::RATE);
+  visitor("datatype_compaction_bytes_copied", numBytesCopied,
+          util::CounterVisitor::CounterType::RATE);
+  visitor("datatype_compaction_bytes_reclaimed", numBytesReclaimed,
+          util::CounterVisitor::CounterType::RATE);
+}
+
+BufferCompactionStats getBufferCompactionStats() {
+  const auto& counters = detail::getBufferCompactionCounters();
+  BufferCompactionStats stats;
+  stats.numFullCompactions = counters.numFullCompactions.get();
+  stats.numIncrementalCompactions = counters.numIncrementalCompactions.get();
+  stats.numBuffersCompacted = counters.numBuffersCompacted.get();
+  stats.numBytesCopied = counters.numBytesCopied.get();
+  stats.numBytesReclaimed = counters.numBytesReclaimed.get();
+  return stats;
+}
+
 namespace detail {
+BufferCompactionCounters& getBufferCompactionCounters() {
+  static BufferCompactionCounters counters;
+  return counters;
+}
+
 constexpr uint32_t Buffer::kInvalidOffset;
 
 bool Buffer::canAllocate(uint32_t size) const {
@@ -16,13 +16,17 @@
 
 #pragma once
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 #include "cachelib/allocator/TypedHandle.h"
 #include "cachelib/allocator/memory/Slab.h"
+#include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/Exceptions.h"
 #include "cachelib/common/Hash.h"
 #include "cachelib/common/Iterators.h"
+#include "cachelib/common/Utils.h"
 #include "cachelib/datatype/DataTypes.h"
 
 namespace facebook {
@@ -33,7 +37,42 @@ template <typename AllocatorT>
 class BufferManagerTest;
 }
 
+// Compaction work done on the buffers of the data types (Map, RangeMap) in
+// this process.
+struct BufferCompactionStats {
+  // number of times all buffers of a data type were compacted at once
+  uint64_t numFullCompactions{0};
+
+  // number of bounded compaction steps taken as part of a mutation
+  uint64_t numIncrementalCompactions{0};
+
+  // number of buffers compacted by either kind of compaction
+  uint64_t numBuffersCompacted{0};
+
+  // bytes of live allocations moved by compaction
+  uint64_t numBytesCopied{0};
+
+  // bytes of removed allocations reclaimed by compaction
+  uint64_t numBytesReclaimed{0};
+
+  // Export the stats through the visitor
+  void visit(const util::CounterVisitor& visitor) const;
+};
+
+// Get a snapshot of the compaction stats
+BufferCompactionStats getBufferCompactionStats();
+
 namespace detail {
+// Process-wide counters behind BufferCompactionStats
+struct BufferCompactionCounters {
+  AtomicCounter numFullCompactions;
+  AtomicCounter numIncrementalCompactions;
+  AtomicCounter numBuffersCompacted;
+  AtomicCounter numBytesCopied;
+  AtomicCounter numBytesReclaimed;
+};
+BufferCompactionCounters& getBufferCompactionCounters();
+
 class FOLLY_PACK_ATTR Buffer {
  private:
   class Slot;
@@ -383,10 +422,26 @@ class BufferManager {
   // Clone a buffer manager within the same cache under another parent
   BufferManager<C> clone(WriteHandle& parent) const;
 
+  // Max bytes of live allocations an incremental compaction step moves.
+  // Buffers are compacted whole, so a step where no buffer fits in this
+  // budget still moves the live bytes of one buffer.
+  static constexpr size_t kMaxIncrementalCompactionBytes = 256 * 1024;
+
   // Compact buffers underneath. The layout of existing allocations may change
   // as a result.
   void compact();
 
+  // Compact a bounded number of buffers, the ones with most wasted bytes
+  // first. The bound is per buffer: a buffer is compacted only if its live
+  // bytes fit in what is left of maxBytes. If no buffer with wasted bytes
+  // fits, the one with the fewest live bytes is compacted anyway, so a step
+  // moves at most max(maxBytes, live bytes of one buffer). The callback is
+  // invoked for every allocation in a compacted buffer with its new
+  // location, since its old location is no longer valid.
+  //
+  // @return number of buffers compacted
+  size_t compactIncrementally(size_t maxBytes, const CompactionCB& cb);
+
   // Return bytes left unused (can be used for future allocaitons)
   size_t remainingBytes() const;
 
@@ -414,6 +469,9 @@ class BufferManager {
   // Get a buffer corresponding to the chained item index
   Buffer* getBuffer(uint32_t index) const;
 
+  // Compact the buffer held by the chained item in place
+  void compactBuffer(Item& item);
+
   // Get a list of all chained allocs upfront, in reverse order
   void materializeChainedAllocs();
 
@@ -40,7 +40,29 @@ HashTable<Key, Hasher>::HashTable(size_t capacity, const HashTable& other)
 template <typename Key, typename Hasher>
 const typename HashTable<Key, Hasher>::Entry* HashTable<Key, Hasher>::find(
     const Key& key) const {
-  uint32_t index = getDesiredIndex(key);
+  return findFrom(key, getDesiredIndex(key));
+}
+
+template <typename Key, typename Hasher>
+void HashTable<Key, Hasher>::findMany(const Key* keys,
+                                      size_t numKeys,
+                                      const Entry** entries) const {
+  std::array<uint32_t, kPrefetchBatch> indexes;
+  for (size_t i = 0; i < numKeys; i += kPrefetchBatch) {
+    const size_t n = std::min(kPrefetchBatch, numKeys - i);
+    for (size_t j = 0; j < n; ++j) {
+      indexes[j] = getDesiredIndex(keys[i + j]);
+      __builtin_prefetch(&entries_[indexes[j]], 0 /* read */, 3);
+    }
+    for (size_t j = 0; j < n; ++j) {
+      entries[i + j] = findFrom(keys[i + j], indexes[j]);
+    }
+  }
+}
+
+template <typename Key, typename Hasher>
+const typename HashTable<Key, Hasher>::Entry* HashTable<Key, Hasher>::findFrom(
+    const Key& key, uint32_t index) const {
   uint32_t myDistance = 0;
   while (true) {
     auto& e = entries_[index];
@@ -48,7 +70,7 @@ const typename HashTable<Key, Hasher>::Entry* HashTable<Key, Hasher>::find(
       return nullptr;
     }
 
-    if (e.key == key) {
+    if (keyEquals(e.key, key)) {
       return &e;
     }
 
@@ -92,7 +114,7 @@ BufferAddr HashTable<Key, Hasher>::insertOrReplace(Key key, BufferAddr addr) {
     }
 
     // If same key already exists, we abort
-    if (e.key == newE.key) {
+    if (keyEquals(e.key, newE.key)) {
       auto oldAddr = e.addr;
       e = newE;
       return oldAddr;
@@ -156,6 +178,33 @@ uint32_t HashTable<Key, Hasher>::getDesiredIndex(const Key& key) const {
       32);
 }
 
+template <typename Key, typename Hasher>
+inline bool HashTable<Key, Hasher>::keyEquals(const Key& a, const Key& b) {
+  if constexpr (!std::has_unique_object_representations<Key>::value) {
+    return a == b;
+  } else if constexpr (sizeof(Key) == sizeof(uint64_t)) {
+    uint64_t wa;
+    uint64_t wb;
+    std::memcpy(&wa, &a, sizeof(Key));
+    std::memcpy(&wb, &b, sizeof(Key));
+    return wa == wb;
+  } else if constexpr (sizeof(Key) == sizeof(uint32_t)) {
+    uint32_t wa;
+    uint32_t wb;
+    std::memcpy(&wa, &a, sizeof(Key));
+    std::memcpy(&wb, &b, sizeof(Key));
+    return wa == wb;
+#if defined(__SSE2__)
+  } else if constexpr (sizeof(Key) == 16) {
+    const auto va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&a));
+    const auto vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&b));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) == 0xFFFF;
+#endif
+  } else {
+    return std::memcmp(&a, &b, sizeof(Key)) == 0;
+  }
+}
+
 template <typename Key, typename Hasher>
 inline uint32_t HashTable<Key, Hasher>::hash(const Key& key) {
   return Hasher{}(&key, sizeof(Key));
@@ -314,6 +363,43 @@ const typename Map<K, V, C>::EntryValue* Map<K, V, C>::find(
   return findImpl(key);
 }
 
+template <typename K, typename V, typename C>
+void Map<K, V, C>::findManyImpl(folly::Range<const EntryKey*> keys,
+                                const EntryValue** values) const {
+  constexpr size_t kBatch = HashTable::kPrefetchBatch;
+  std::array<const typename HashTable::Entry*, kBatch> entries;
+  for (size_t i = 0; i < keys.size(); i += kBatch) {
+    const size_t n = std::min(kBatch, keys.size() - i);
+    hashtable_->findMany(keys.data() + i, n, entries.data());
+    // the values live in the chained items, prefetch them for the caller.
+    for (size_t j = 0; j < n; ++j) {
+      if (!entries[j]) {
+        values[i + j] = nullptr;
+        continue;
+      }
+      values[i + j] =
+          &bufferManager_.template get<EntryKeyValue>(entries[j]->addr)->value;
+      __builtin_prefetch(values[i + j], 0 /* read */, 3);
+    }
+  }
+}
+
+template <typename K, typename V, typename C>
+std::vector<typename Map<K, V, C>::EntryValue*> Map<K, V, C>::findMany(
+    folly::Range<const EntryKey*> keys) {
+  std::vector<EntryValue*> values(keys.size());
+  findManyImpl(keys, const_cast<const EntryValue**>(values.data()));
+  return values;
+}
+
+template <typename K, typename V, typename C>
+std::vector<const typename Map<K, V, C>::EntryValue*> Map<K, V, C>::findMany(
+    folly::Range<const EntryKey*> keys) const {
+  std::vector<const EntryValue*> values(keys.size());
+  findManyImpl(keys, values.data());
+  return values;
+}
+
 template <typename K, typename V, typename C>
 typename Map<K, V, C>::InsertOrReplaceResult Map<K, V, C>::insertImpl(
     const EntryKey& key, const EntryValue& value) {
@@ -329,9 +415,9 @@ typename Map<K, V, C>::InsertOrReplaceResult Map<K, V, C>::insertImpl(
     chainCloned = true;
   }
 
-  // If wasted space is more than threshold, trigger compaction
+  // If wasted space is more than threshold, compact a few buffers
   if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
-    compact();
+    compactIncrementally();
   }
 
   const uint32_t valueSize = util::getValueSize(value);
@@ -342,20 +428,9 @@ typename Map<K, V, C>::InsertOrReplaceResult Map<K, V, C>::insertImpl(
     // this insert, so that if a user holds an old handle to the Map, that
     // handle will still allow the user to access the old Map.
     if (!chainCloned) {
-      auto newHashTable = detail::copyHashTable<K, C>(*cache_, hashtable_,
-                                                      hashtable_->capacity());
-      if (!newHashTable) {
+      if (!cloneChain()) {
         throw std::bad_alloc();
       }
-
-      auto newBufferManager =
-          bufferManager_.clone(newHashTable.viewWriteHandle());
-      if (newBufferManager.empty()) {
-        throw std::bad_alloc();
-      }
-
-      hashtable_ = std::move(newHashTable);
-      bufferManager_ = BufferManager(*cache_, hashtable_.viewWriteHandle());
       chainCloned = true;
     }
     if (bufferManager_.expand(keySize + valueSize)) {
@@ -397,6 +472,74 @@ bool Map<K, V, C>::insert(const EntryKey& key, const EntryValue& value) {
   return true;
 }
 
+template <typename K, typename V, typename C>
+template <typename EntryRange>
+uint32_t Map<K, V, C>::insertMany(const EntryRange& entries) {
+  // Room is made for every entry, including the ones whose key turns out
+  // to exist already. Skipping those would take another lookup per key.
+  size_t numEntries = 0;
+  size_t numBytes = 0;
+  for (const auto& [key, value] : entries) {
+    const EntryValue& v = value;
+    ++numEntries;
+    numBytes += detail::Buffer::getAllocSize(
+        static_cast<uint32_t>(sizeof(EntryKey) + util::getValueSize(v)));
+  }
+  reserve(numEntries, numBytes);
+
+  uint32_t numInserted = 0;
+  for (const auto& [key, value] : entries) {
+    if (insert(key, value)) {
+      ++numInserted;
+    }
+  }
+  return numInserted;
+}
+
+template <typename K, typename V, typename C>
+void Map<K, V, C>::reserve(size_t numEntries, size_t numBytes) {
+  const auto accessible = hashtable_.viewWriteHandle()->isAccessible();
+  bool chainCloned = false;
+
+  const size_t requiredCapacity =
+      HashTable::computeCapacity(hashtable_->numEntries() + numEntries);
+  if (requiredCapacity > hashtable_->capacity()) {
+    // grow at least as much as a single insert would have
+    const double factor =
+        std::max(2.0, static_cast<double>(requiredCapacity) /
+                          static_cast<double>(hashtable_->capacity()));
+    if (expandHashTable(factor)) {
+      chainCloned = true;
+    }
+  }
+
+  if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
+    compactIncrementally();
+  }
+
+  // An existing buffer is grown in one step to fit the batch, or new
+  // buffers are added once it can not grow any further.
+  const size_t maxExpandSize =
+      BufferManager::kMaxBufferCapacity - detail::Buffer::getAllocSize(0);
+  while (bufferManager_.remainingBytes() < numBytes) {
+    if (!chainCloned) {
+      if (!cloneChain()) {
+        throw std::bad_alloc();
+      }
+      chainCloned = true;
+    }
+    const size_t missing = numBytes - bufferManager_.remainingBytes();
+    if (!bufferManager_.expand(
+            static_cast<uint32_t>(std::min(missing, maxExpandSize)))) {
+      break;
+    }
+  }
+
+  if (chainCloned && accessible) {
+    cache_->insertOrReplace(hashtable_.viewWriteHandle());
+  }
+}
+
 template <typename K, typename V, typename C>
 typename Map<K, V, C>::InsertOrReplaceResult Map<K, V, C>::insertOrReplace(
     const EntryKey& key, const EntryValue& value) {
@@ -451,8 +594,50 @@ void Map<K, V, C>::compact() {
 }
 
 template <typename K, typename V, typename C>
-bool Map<K, V, C>::expandHashTable() {
-  auto newHashTable = detail::expandHashTable<K, C>(*cache_, hashtable_);
+void Map<K, V, C>::compactIncrementally() {
+  // Same as compact() except only the entries that live in the compacted
+  // buffers need their address replaced in the hashtable.
+  bufferManager_.compactIncrementally(
+      BufferManager::kMaxIncrementalCompactionBytes,
+      [this](void* data, detail::BufferAddr addr) {
+        const EntryKey key = reinterpret_cast<EntryKeyValue*>(data)->key;
+        detail::BufferAddr oldAddr;
+        try {
+          oldAddr = hashtable_->insertOrReplace(key, addr);
+        } catch (const std::bad_alloc& ex) {
+          throw std::runtime_error(
+              "hashtable cannot have insufficient space during a compaction");
+        }
+        if (!oldAddr) {
+          throw std::runtime_error(folly::sformat(
+              "old entry is missing, this should never happen. key: {}",
+              key));
+        }
+      });
+}
+
+template <typename K, typename V, typename C>
+bool Map<K, V, C>::cloneChain() {
+  auto newHashTable = detail::copyHashTable<K, C>(*cache_, hashtable_,
+                                                  hashtable_->capacity());
+  if (!newHashTable) {
+    return false;
+  }
+
+  auto newBufferManager = bufferManager_.clone(newHashTable.viewWriteHandle());
+  if (newBufferManager.empty()) {
+    return false;
+  }
+
+  hashtable_ = std::move(newHashTable);
+  bufferManager_ = BufferManager(*cache_, hashtable_.viewWriteHandle());
+  return true;
+}
+
+template <typename K, typename V, typename C>
+bool Map<K, V, C>::expandHashTable(double factor) {
+  auto newHashTable =
+      detail::expandHashTable<K, C>(*cache_, hashtable_, factor);
   if (!newHashTable) {
     return false;
   }
@@ -16,7 +16,18 @@
 
 #pragma once
 
+#include <folly/Range.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "cachelib/allocator/TypedHandle.h"
 #include "cachelib/common/Hash.h"
@@ -45,6 +56,17 @@ class FOLLY_PACK_ATTR HashTable {
     void setNull() { addr = nullptr; }
   };
 
+  // number of keys findMany hashes and prefetches ahead of probing
+  static constexpr size_t kPrefetchBatch = 8;
+
+  // @param numEntries   number of entries the hash table needs to hold
+  // @return  min capacity to hold them without going over the limit
+  static size_t computeCapacity(size_t numEntries) {
+    return std::max(
+        numEntries + 2,
+        static_cast<size_t>(numEntries / kCapacityOverlimitRatio) + 1);
+  }
+
   // @param capacity   number of maximum entries for the hash table
   // @return  bytes required for the hashtable to fit
   static uint32_t computeStorageSize(size_t capacity) {
@@ -64,6 +86,14 @@ class FOLLY_PACK_ATTR HashTable {
   // Find an entry to this key. Nullptr if not found.
   const Entry* find(const Key& key) const;
 
+  // Find the entries of a batch of keys. The slots of up to kPrefetchBatch
+  // keys are prefetched before any of them is probed, so that their cache
+  // misses overlap instead of being paid one after another.
+  // @param keys      keys to look up
+  // @param numKeys   number of keys
+  // @param entries   set to the entry of each key, nullptr if not found
+  void findMany(const Key* keys, size_t numKeys, const Entry** entries) const;
+
   // Insert this key. Replace existing key if present.
   // @return addr of the replaced entry. Nullptr if no existing key.
   // @throw std::bad_alloc if hash table is full and cannot insert
@@ -85,6 +115,14 @@ class FOLLY_PACK_ATTR HashTable {
  private:
   uint32_t getDesiredIndex(const Key& key) const;
 
+  // Find the entry for the key, probing from its desired index.
+  const Entry* findFrom(const Key& key, uint32_t index) const;
+
+  // Keys are hashed by their bytes, so keys without padding are equal
+  // exactly when their bytes are. Those are compared as a word, or with a
+  // single SIMD compare for 16 byte keys, instead of through operator==.
+  static bool keyEquals(const Key& a, const Key& b);
+
   static uint32_t hash(const Key& key);
 
   // Probe distance measures the distance between our current lookup or
@@ -170,6 +208,15 @@ class Map {
   // @param key   key to an entry in this map
   const EntryValue* find(const EntryKey& key) const;
 
+  // Find the values of a batch of keys. Cheaper than calling find() for
+  // each of them since the hash table slots and then the values of several
+  // keys are prefetched together.
+  // @param keys  keys to entries in this map
+  // @return  the value of each key in the same order, nullptr if not found
+  std::vector<EntryValue*> findMany(folly::Range<const EntryKey*> keys);
+  std::vector<const EntryValue*> findMany(
+      folly::Range<const EntryKey*> keys) const;
+
   // Inserts key and value into the map.
   //
   // Insert incurs two lookups on a successful insert. This is due to with
@@ -188,6 +235,23 @@ class Map {
   //                                maximum entry count.
   bool insert(const EntryKey& key, const EntryValue& value);
 
+  // Inserts a batch of keys and values into the map. Room for the whole
+  // batch is made upfront, so the hash table and the value storage grow at
+  // most once instead of possibly several times. Keys that already exist,
+  // including ones repeated in the batch, are left as they are.
+  //
+  // @param entries  range of pairs of key and value. The value can be a
+  //                 std::reference_wrapper for variable sized values.
+  //
+  // @return number of keys inserted
+  // @throw std::bad_alloc if we can't allocate for a value. The entries
+  //                       before it are inserted and the map is still in a
+  //                       valid state.
+  // @throw cachelib::IndexMaxedOut if cachelib::Map has reached its
+  //                                maximum entry count.
+  template <typename EntryRange>
+  uint32_t insertMany(const EntryRange& entries);
+
   // Inserts key and value into the map. Replaces an existing key/value
   // if already exists.
   // @param key    key to the value
@@ -212,6 +276,12 @@ class Map {
   // This doesn't include cachelib item overhead
   size_t sizeInBytes() const;
 
+  // Return bytes left unused (can be used for future entries)
+  size_t remainingBytes() const { return bufferManager_.remainingBytes(); }
+
+  // Returns bytes left behind by removed entries
+  size_t wastedBytes() const { return bufferManager_.wastedBytes(); }
+
   // Return number of elements in this map
   uint32_t size() const { return hashtable_->numEntries(); }
 
@@ -289,8 +359,29 @@ class Map {
   InsertOrReplaceResult insertImpl(const EntryKey& key,
                                    const EntryValue& value);
 
+  // Fill values with the value of each key, nullptr if not found.
+  void findManyImpl(folly::Range<const EntryKey*> keys,
+                    const EntryValue** values) const;
+
+  // Make room for numEntries more entries in the hash table and numBytes
+  // more bytes of keys and values in storage, cloning the chain at most
+  // once. Best effort, inserts still grow the map if needed.
+  // @throw std::bad_alloc if failed to clone the chain
+  void reserve(size_t numEntries, size_t numBytes);
+
+  // Compact the buffers with the most wasted space, moving a bounded amount
+  // of bytes so that a single mutation does not pay for compacting the
+  // whole map.
+  // @throw std::runtime_error on the same conditions as compact()
+  void compactIncrementally();
+
+  // Move to a copy of the hash table and chained items with the same
+  // capacity, so that handles to the old map stay valid.
+  // @return false if failed to allocate the copy
+  bool cloneChain();
+
   // @return false if failed to allocate a bigger item for hash table
-  bool expandHashTable();
+  bool expandHashTable(double factor = 2.0);
 
   // BEGIN private members
   CacheType* cache_{nullptr};
@@ -298,7 +389,7 @@ class Map {
   BufferManager bufferManager_{nullptr};
   // END private members
 
-  // Threshold after which we will trigger compaction automatically
+  // Threshold after which mutations trigger incremental compaction
   static constexpr int kWastedBytesPctThreshold = 50;
   static constexpr uint32_t kDefaultNumEntries = 20;
   static constexpr uint32_t kDefaultNumBytes = kDefaultNumEntries * 8;
@@ -277,7 +277,7 @@ bool RangeMap<K, V, C>::remove(const EntryKey& key) {
 
   bufferManager_.remove(addr);
   if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
-    compact();
+    compactIncrementally();
   }
   return true;
 }
@@ -288,7 +288,7 @@ uint32_t RangeMap<K, V, C>::removeBefore(const EntryKey& key) {
   auto count = index->removeBefore(
       key, [this](auto addr) { bufferManager_.remove(addr); });
   if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
-    compact();
+    compactIncrementally();
   }
   return count;
 }
@@ -361,6 +361,60 @@ RangeMap<K, V, C>::rangeLookupApproximate(const EntryKey& key1,
   return {mutableRange.begin().toConstItr(), mutableRange.end().toConstItr()};
 }
 
+template <typename K, typename V, typename C>
+std::unique_ptr<folly::IOBuf> RangeMap<K, V, C>::exportRange(
+    folly::Range<ConstItr> range) const {
+  if (range.empty()) {
+    return nullptr;
+  }
+
+  // chained items in the order of the buffer manager's item offsets
+  std::vector<const Item*> buffers;
+  auto allocs = cache_->viewAsChainedAllocs(handle_);
+  for (const auto& c : allocs.getChain()) {
+    buffers.push_back(&c);
+  }
+  std::reverse(buffers.begin(), buffers.end());
+
+  // One IOBuf owns a reference to the parent item for each chained item
+  // that has entries in the range. The IOBuf of an entry is a clone of it,
+  // which only takes a reference on the shared IOBuf storage.
+  auto sharedHdl = std::make_shared<ReadHandle>(handle_.clone());
+  std::vector<std::unique_ptr<folly::IOBuf>> owners(buffers.size());
+  auto getOwner = [&](uint32_t itemOffset) -> folly::IOBuf& {
+    auto& owner = owners.at(itemOffset);
+    if (!owner) {
+      const Item* item = buffers[itemOffset];
+      owner = folly::IOBuf::takeOwnership(
+          const_cast<void*>(item->getMemory()), item->getSize(),
+          [](void* /*unused*/, void* userData) {
+            delete reinterpret_cast<std::shared_ptr<ReadHandle>*>(userData);
+          } /* freeFunc */,
+          new std::shared_ptr<ReadHandle>{sharedHdl} /* userData */);
+      owner->markExternallySharedOne();
+    }
+    return *owner;
+  };
+
+  std::unique_ptr<folly::IOBuf> head;
+  for (auto itr = range.begin(); itr != range.end(); ++itr) {
+    const auto addr = itr.getAsBufferAddr();
+    auto& owner = getOwner(addr.getItemOffset());
+    const auto* data = reinterpret_cast<const uint8_t*>(&*itr);
+    const auto size = sizeof(EntryKey) + util::getValueSize(itr->value);
+
+    auto buf = owner.cloneOne();
+    buf->trimStart(data - owner.data());
+    buf->trimEnd(buf->length() - size);
+    if (head) {
+      head->prependChain(std::move(buf));
+    } else {
+      head = std::move(buf);
+    }
+  }
+  return head;
+}
+
 template <typename K, typename V, typename C>
 typename RangeMap<K, V, C>::Itr RangeMap<K, V, C>::begin() {
   auto* index = handle_->template getMemoryAs<BinaryIndex>();
@@ -405,6 +459,17 @@ void RangeMap<K, V, C>::compact() {
   }
 }
 
+template <typename K, typename V, typename C>
+void RangeMap<K, V, C>::compactIncrementally() {
+  auto* index = handle_->template getMemoryAs<BinaryIndex>();
+  bufferManager_.compactIncrementally(
+      BufferManager::kMaxIncrementalCompactionBytes,
+      [index](void* data, detail::BufferAddr addr) {
+        index->insertOrReplace(reinterpret_cast<EntryKeyValue*>(data)->key,
+                               addr);
+      });
+}
+
 template <typename K, typename V, typename C>
 size_t RangeMap<K, V, C>::sizeInBytes() const {
   size_t numBytes = handle_->getSize();
@@ -419,9 +484,9 @@ template <typename K, typename V, typename C>
 typename RangeMap<K, V, C>::InsertOrReplaceResult
 RangeMap<K, V, C>::insertOrReplaceInternal(const EntryKey& key,
                                            const EntryValue& value) {
-  // If wasted space is more than threshold, trigger compaction
+  // If wasted space is more than threshold, compact a few buffers
   if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
-    compact();
+    compactIncrementally();
   }
 
   const auto valueSize = util::getValueSize(value);
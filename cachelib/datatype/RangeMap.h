@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include <folly/io/IOBuf.h>
+
 #include <limits>
+#include <memory>
+#include <vector>
 
 #include "cachelib/allocator/TypedHandle.h"
 #include "cachelib/common/Exceptions.h"
@@ -45,6 +49,7 @@ class RangeMap {
   using EntryValue = V;
   using Cache = C;
   using Item = typename Cache::Item;
+  using ReadHandle = typename Item::ReadHandle;
   using WriteHandle = typename Item::WriteHandle;
 
   struct FOLLY_PACK_ATTR EntryKeyValue {
@@ -130,6 +135,20 @@ class RangeMap {
   folly::Range<ConstItr> rangeLookupApproximate(const EntryKey& key1,
                                                 const EntryKey& key2) const;
 
+  // Export a range of entries as an IOBuf chain without copying them. Each
+  // IOBuf in the chain points to one EntryKeyValue in the memory of the
+  // map, in sorted order. The IOBufs hold a reference to the map's item, so
+  // they stay valid after this map is destroyed or its key is replaced in
+  // cache. Each chained item is wrapped once and shared by the entries in it.
+  //
+  // **WARNING**: like iterators, the exported entries must not be read while
+  // this map is mutated, since compaction moves entries within their
+  // buffers. The IOBufs must also not be written to.
+  //
+  // @param range   a range returned by rangeLookup or rangeLookupApproximate
+  // @return  the IOBuf chain, nullptr if the range is empty.
+  std::unique_ptr<folly::IOBuf> exportRange(folly::Range<ConstItr> range) const;
+
   // Iterate through the map in a sorted order via mutable or const.
   Itr begin();
   Itr end();
@@ -205,6 +224,10 @@ class RangeMap {
   detail::BufferAddr cloneIndexAndAllocate(uint32_t allocSize,
                                            bool expandIndex);
 
+  // Compact the buffers with the most wasted space, moving a bounded amount
+  // of bytes, and point the index at the entries' new locations.
+  void compactIncrementally();
+
   Cache* cache_{nullptr};
   WriteHandle handle_;
   BufferManager bufferManager_{nullptr};
@@ -296,6 +319,9 @@ class BinaryIndexIterator
 
   BinaryIndexIterator<Key, const Value, BufManager> toConstItr();
 
+  // Address of the current entry in the buffer manager.
+  BufferAddr getAsBufferAddr() const { return entry_->addr; }
+
   Value& dereference() const;
   void increment();
   bool equal(const BinaryIndexIterator& other) const;
@@ -17,6 +17,9 @@
 #include <folly/Random.h>
 #include <gmock/gmock.h>
 
+#include <map>
+#include <vector>
+
 #include "cachelib/allocator/Util.h"
 #include "cachelib/allocator/tests/TestBase.h"
 #include "cachelib/datatype/Buffer.h"
@@ -301,6 +304,87 @@ class BufferManagerTest : public ::testing::Test {
     EXPECT_EQ(4, addr.getByteOffset());
   }
 
+  void testIncrementalCompaction() {
+    auto cache = DataTypeTest::createCache<AllocatorT>();
+    const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+    auto parent = cache->allocate(pid, "my_parent", 0);
+
+    using BufferManager = detail::BufferManager<AllocatorT>;
+    auto mgr = BufferManager{*cache, parent, 1000};
+
+    // Fill up two buffers and start a third. Each allocation holds its id.
+    std::vector<detail::BufferAddr> addrs;
+    while (addrs.empty() || addrs.back().getItemOffset() < 2) {
+      auto addr = mgr.allocate(1000);
+      if (!addr) {
+        ASSERT_TRUE(mgr.expand(1000));
+        addr = mgr.allocate(1000);
+      }
+      ASSERT_NE(nullptr, addr);
+      *mgr.template get<uint32_t>(addr) = static_cast<uint32_t>(addrs.size());
+      addrs.push_back(addr);
+    }
+
+    // Waste more space in the first buffer than in the second one
+    std::map<uint32_t, bool> live;
+    size_t wastedInFirst = 0;
+    for (uint32_t id = 0; id < addrs.size(); id++) {
+      const auto itemOffset = addrs[id].getItemOffset();
+      if ((itemOffset == 0 && id % 2 == 0) ||
+          (itemOffset == 1 && id % 4 == 0)) {
+        mgr.remove(addrs[id]);
+        wastedInFirst +=
+            itemOffset == 0 ? detail::Buffer::getAllocSize(1000) : 0;
+      } else {
+        live[id] = true;
+      }
+    }
+    const size_t wastedBytes = mgr.wastedBytes();
+    ASSERT_GT(wastedBytes, wastedInFirst);
+
+    const auto statsBefore = getBufferCompactionStats();
+
+    // The buffer with the fewest live bytes is compacted even if it has more
+    // than maxBytes, so that the step makes progress
+    std::map<uint32_t, detail::BufferAddr> moved;
+    auto cb = [&](void* data, detail::BufferAddr addr) {
+      moved[*reinterpret_cast<uint32_t*>(data)] = addr;
+    };
+    ASSERT_EQ(1, mgr.compactIncrementally(1, cb));
+    EXPECT_EQ(wastedBytes - wastedInFirst, mgr.wastedBytes());
+    ASSERT_FALSE(moved.empty());
+    for (const auto& [id, addr] : moved) {
+      EXPECT_TRUE(live[id]);
+      EXPECT_EQ(0, addrs[id].getItemOffset());
+      EXPECT_EQ(0, addr.getItemOffset());
+      EXPECT_EQ(id, *mgr.template get<uint32_t>(addr));
+    }
+
+    const auto stats = getBufferCompactionStats();
+    EXPECT_EQ(statsBefore.numIncrementalCompactions + 1,
+              stats.numIncrementalCompactions);
+    EXPECT_EQ(statsBefore.numBuffersCompacted + 1, stats.numBuffersCompacted);
+    EXPECT_EQ(statsBefore.numBytesReclaimed + wastedInFirst,
+              stats.numBytesReclaimed);
+    EXPECT_EQ(statsBefore.numBytesCopied +
+                  moved.size() * detail::Buffer::getAllocSize(1000),
+              stats.numBytesCopied);
+    EXPECT_EQ(statsBefore.numFullCompactions, stats.numFullCompactions);
+
+    // The second buffer is the only one left with wasted bytes
+    moved.clear();
+    ASSERT_EQ(1,
+              mgr.compactIncrementally(
+                  BufferManager::kMaxIncrementalCompactionBytes, cb));
+    EXPECT_EQ(0, mgr.wastedBytes());
+    for (const auto& [id, addr] : moved) {
+      EXPECT_TRUE(live[id]);
+      EXPECT_EQ(1, addr.getItemOffset());
+      EXPECT_EQ(id, *mgr.template get<uint32_t>(addr));
+    }
+    EXPECT_EQ(0, mgr.compactIncrementally(1, cb));
+  }
+
   void testClone() {
     typename AllocatorT::Config config;
     config.configureChainedItems();
@@ -391,6 +475,9 @@ TYPED_TEST(BufferManagerTest, FixedSize) { this->testFixedSize(); }
 TYPED_TEST(BufferManagerTest, VariableSize) { this->testVariableSize(); }
 TYPED_TEST(BufferManagerTest, UpperBound) { this->testUpperBound(); }
 TYPED_TEST(BufferManagerTest, Clone) { this->testClone(); }
+TYPED_TEST(BufferManagerTest, IncrementalCompaction) {
+  this->testIncrementalCompaction();
+}
 TYPED_TEST(BufferManagerTest, MaxBufferSize) { this->testMaxBufferSize(); }
 TYPED_TEST(BufferManagerTest, InitialCapacity) { this->testInitialCapacity(); }
 } // namespace tests
@@ -311,6 +311,42 @@ TEST(HashTable, Rehash) {
   ASSERT_THROW(new (buffer3.get()) HTable(50, *ht1), std::invalid_argument);
 }
 
+TEST(HashTable, FindMany) {
+  struct FOLLY_PACK_ATTR WideKey {
+    uint64_t hi;
+    uint64_t lo;
+    bool operator==(const WideKey& rhs) const {
+      return hi == rhs.hi && lo == rhs.lo;
+    }
+  };
+  using HTable = detail::HashTable<WideKey>;
+  auto buffer = std::make_unique<uint8_t[]>(HTable::computeStorageSize(1000));
+  HTable* ht = new (buffer.get()) HTable(1000);
+
+  for (uint32_t i = 0; i < 800; ++i) {
+    ASSERT_EQ(nullptr, ht->insertOrReplace(WideKey{i, i * 3ULL},
+                                           detail::BufferAddr{1, i}));
+  }
+
+  // a batch that is not a multiple of the prefetch batch, with misses that
+  // only differ from hits in one half of the key.
+  std::vector<WideKey> keys;
+  for (uint32_t i = 0; i < 1003; ++i) {
+    keys.push_back(WideKey{i, i % 2 == 0 ? i * 3ULL : i * 3ULL + 1});
+  }
+  std::vector<const HTable::Entry*> entries(keys.size());
+  ht->findMany(keys.data(), keys.size(), entries.data());
+  for (uint32_t i = 0; i < keys.size(); ++i) {
+    if (i < 800 && i % 2 == 0) {
+      ASSERT_NE(nullptr, entries[i]);
+      ASSERT_EQ(detail::BufferAddr(1, i), entries[i]->addr);
+    } else {
+      ASSERT_EQ(nullptr, entries[i]);
+    }
+    ASSERT_EQ(ht->find(keys[i]), entries[i]);
+  }
+}
+
 template <typename AllocatorT>
 class MapTest : public ::testing::Test {
  private:
@@ -604,6 +640,59 @@ class MapTest : public ::testing::Test {
     ASSERT_EQ(sizeInBytes, map.sizeInBytes());
   }
 
+  void testIncrementalCompaction() {
+    auto cache = DataTypeTest::createCache<AllocatorT>();
+    const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+
+    using BasicMap = cachelib::Map<int, Value, AllocatorT>;
+    auto map = BasicMap::create(*cache, pid, "my_map");
+
+    // Spread the map over several chained items
+    const uint32_t numValues = 1000;
+    for (uint32_t key = 0; key < numValues; ++key) {
+      auto v = Value::create(10240);
+      std::memset(&v->data, key % 256, v->len);
+      ASSERT_TRUE(map.insert(key, *v));
+    }
+
+    // Waste most of the space, without compacting
+    for (uint32_t key = 0; key < numValues; ++key) {
+      if (key % 4 != 0) {
+        ASSERT_TRUE(map.erase(key));
+      }
+    }
+    const auto wastedBytes = map.wastedBytes();
+    const auto statsBefore = getBufferCompactionStats();
+
+    // Each insert compacts a few buffers rather than the whole map
+    auto v = Value::create(10240);
+    std::memset(&v->data, 1, v->len);
+    ASSERT_TRUE(map.insert(1, *v));
+    auto stats = getBufferCompactionStats();
+    EXPECT_EQ(statsBefore.numFullCompactions, stats.numFullCompactions);
+    EXPECT_EQ(statsBefore.numIncrementalCompactions + 1,
+              stats.numIncrementalCompactions);
+    EXPECT_GT(stats.numBuffersCompacted, statsBefore.numBuffersCompacted);
+    EXPECT_LT(stats.numBuffersCompacted - statsBefore.numBuffersCompacted,
+              map.sizeInBytes() / 1024 / 1024);
+    EXPECT_GT(map.wastedBytes(), 0);
+    EXPECT_LT(map.wastedBytes(), wastedBytes);
+
+    for (uint32_t key = 0; key < numValues; ++key) {
+      auto* value = map.find(key);
+      if (key % 4 != 0 && key != 1) {
+        EXPECT_EQ(nullptr, value);
+        continue;
+      }
+      ASSERT_NE(nullptr, value);
+      ASSERT_EQ(10240, value->len);
+      const uint8_t expected = key == 1 ? 1 : key % 256;
+      for (uint32_t i = 0; i < value->len; ++i) {
+        ASSERT_EQ(expected, value->data[i]);
+      }
+    }
+  }
+
   void testIterator() {
     auto cache = DataTypeTest::createCache<AllocatorT>();
     const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
@@ -898,6 +987,98 @@ class MapTest : public ::testing::Test {
     ASSERT_EQ(200, itr->value);
   }
 
+  void testFindMany() {
+    auto cache = DataTypeTest::createCache<AllocatorT>();
+    const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+
+    using BasicMap = cachelib::Map<int, int, AllocatorT>;
+    auto map = BasicMap::create(*cache, pid, "my_map");
+    for (int key = 0; key < 100; ++key) {
+      ASSERT_TRUE(map.insert(key, key * 10));
+    }
+
+    std::vector<int> keys;
+    for (int key = 150; key >= 50; --key) {
+      keys.push_back(key);
+    }
+    auto values = map.findMany(folly::range(keys));
+    ASSERT_EQ(keys.size(), values.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      if (keys[i] < 100) {
+        ASSERT_NE(nullptr, values[i]);
+        EXPECT_EQ(keys[i] * 10, *values[i]);
+      } else {
+        EXPECT_EQ(nullptr, values[i]);
+      }
+    }
+
+    // the values are the ones stored in the map
+    *values.back() = 1;
+    EXPECT_EQ(1, *map.find(50));
+
+    const auto& constMap = map;
+    EXPECT_EQ(map.find(60), constMap.findMany(folly::range(keys))[90]);
+    EXPECT_TRUE(map.findMany(folly::Range<const int*>{}).empty());
+  }
+
+  void testInsertMany() {
+    auto cache = DataTypeTest::createCache<AllocatorT>();
+    const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+
+    using BasicMap = cachelib::Map<int, Value, AllocatorT>;
+    auto map = BasicMap::create(*cache, pid, "my_map");
+    auto v = Value::create(100);
+    ASSERT_TRUE(map.insert(0, *v));
+    cache->insert(map.viewWriteHandle());
+    auto oldHandle = cache->findImpl("my_map", AccessMode::kRead);
+    ASSERT_NE(nullptr, oldHandle);
+
+    // one batch that needs a much larger hash table and storage
+    std::vector<std::pair<int, std::reference_wrapper<const Value>>> entries;
+    std::vector<decltype(Value::create(0))> values;
+    for (int key = 0; key < 500; ++key) {
+      values.push_back(Value::create(key % 200));
+      std::memset(values.back()->data, key % 256, values.back()->len);
+      entries.emplace_back(key, *values.back());
+    }
+    // a repeated key keeps its first value
+    entries.emplace_back(10, *v);
+    EXPECT_EQ(499, map.insertMany(entries));
+    EXPECT_EQ(500, map.size());
+
+    for (int key = 1; key < 500; ++key) {
+      const auto* value = map.find(key);
+      ASSERT_NE(nullptr, value);
+      ASSERT_EQ(key % 200, value->len);
+      for (uint32_t i = 0; i < value->len; ++i) {
+        ASSERT_EQ(key % 256, value->data[i]);
+      }
+    }
+
+    // the map in cache is the new one and the old handle still sees the
+    // map as it was before the batch.
+    auto newHandle = cache->findImpl("my_map", AccessMode::kRead);
+    ASSERT_NE(nullptr, newHandle);
+    EXPECT_EQ(500,
+              BasicMap::fromWriteHandle(*cache, std::move(newHandle)).size());
+    const auto oldMap = BasicMap::fromWriteHandle(*cache, std::move(oldHandle));
+    EXPECT_EQ(1, oldMap.size());
+    EXPECT_NE(nullptr, oldMap.find(0));
+
+    // fixed size values can be passed directly
+    using IntMap = cachelib::Map<int, int, AllocatorT>;
+    auto intMap = IntMap::create(*cache, pid, "my_int_map");
+    std::vector<std::pair<int, int>> intEntries;
+    for (int key = 0; key < 1000; ++key) {
+      intEntries.emplace_back(key, -key);
+    }
+    EXPECT_EQ(1000, intMap.insertMany(intEntries));
+    EXPECT_EQ(0, intMap.insertMany(intEntries));
+    for (int key = 0; key < 1000; ++key) {
+      ASSERT_EQ(-key, *intMap.find(key));
+    }
+  }
+
   void testTinyMap() {
     auto cache = DataTypeTest::createCache<AllocatorT>();
     const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
@@ -928,6 +1109,9 @@ TYPED_TEST(MapTest, ManyEntriesFixedUpperBound) {
 }
 TYPED_TEST(MapTest, ManyEntriesVariable) { this->testManyEntriesVariable(); }
 TYPED_TEST(MapTest, Compaction) { this->testCompaction(); }
+TYPED_TEST(MapTest, IncrementalCompaction) {
+  this->testIncrementalCompaction();
+}
 TYPED_TEST(MapTest, Iterator) { this->testIterator(); }
 TYPED_TEST(MapTest, EmptyMapIterator) { this->testEmptyMapIterator(); }
 TYPED_TEST(MapTest, StdContainer) { this->testStdContainer(); }
@@ -938,6 +1122,8 @@ TYPED_TEST(MapTest, ForkChainAtExpandTable) {
 TYPED_TEST(MapTest, ForkChainAtAppend) { this->testForkChainAtAppend(); }
 TYPED_TEST(MapTest, StdAlgorithms) { this->testStdAlgorithms(); }
 TYPED_TEST(MapTest, TinyMap) { this->testTinyMap(); }
+TYPED_TEST(MapTest, FindMany) { this->testFindMany(); }
+TYPED_TEST(MapTest, InsertMany) { this->testInsertMany(); }
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
@@ -585,6 +585,63 @@ TEST(RangeMap, RangeLookupApprox) {
   EXPECT_EQ(10, i);
 }
 
+TEST(RangeMap, ExportRange) {
+  struct Value {
+    uint64_t id;
+    std::array<uint8_t, 1000> data;
+  };
+  using RM = RangeMap<uint64_t, Value, LruAllocator>;
+
+  auto cache = createCache();
+  std::unique_ptr<folly::IOBuf> buf;
+  {
+    auto rm = RM::create(*cache, 0, "range_map");
+    // enough data for the entries to span several chained items
+    Value value;
+    for (uint64_t key = 0; key < 3000; ++key) {
+      value.id = key;
+      value.data.fill(static_cast<uint8_t>(key));
+      ASSERT_TRUE(rm.insert(key, value));
+    }
+    auto allocs = cache->viewAsChainedAllocs(rm.viewWriteHandle());
+    ASSERT_GT(allocs.computeChainLength(), 2);
+    cache->insert(rm.viewWriteHandle());
+
+    const auto& constRm = rm;
+    EXPECT_EQ(nullptr, constRm.exportRange(constRm.rangeLookup(3000, 4000)));
+
+    const auto refCount = rm.viewWriteHandle()->getRefCount();
+    buf = constRm.exportRange(constRm.rangeLookup(100, 2099));
+    ASSERT_NE(nullptr, buf);
+    auto buf2 = constRm.exportRange(constRm.rangeLookupApproximate(2990, 5000));
+    ASSERT_NE(nullptr, buf2);
+    EXPECT_EQ(10, buf2->countChainElements());
+    // one reference per export, shared by all of its chained items
+    EXPECT_EQ(refCount + 2, rm.viewWriteHandle()->getRefCount());
+    buf2.reset();
+    EXPECT_EQ(refCount + 1, rm.viewWriteHandle()->getRefCount());
+  }
+
+  // the entries stay readable after the map is gone from cache
+  cache->remove("range_map");
+  EXPECT_EQ(nullptr, cache->find("range_map"));
+
+  EXPECT_EQ(2000, buf->countChainElements());
+  EXPECT_EQ(2000 * sizeof(RM::EntryKeyValue), buf->computeChainDataLength());
+  uint64_t key = 100;
+  for (const auto& range : *buf) {
+    ASSERT_EQ(sizeof(RM::EntryKeyValue), range.size());
+    RM::EntryKeyValue kv;
+    std::memcpy(&kv, range.data(), sizeof(kv));
+    ASSERT_EQ(key, kv.key);
+    ASSERT_EQ(key, kv.value.id);
+    ASSERT_EQ(static_cast<uint8_t>(key), kv.value.data[999]);
+    ++key;
+  }
+  EXPECT_EQ(2100, key);
+  EXPECT_TRUE(buf->isSharedOne());
+}
+
 TEST(RangeMap, LargeMap) {
   using RM = RangeMap<uint64_t, uint64_t, LruAllocator>;
 
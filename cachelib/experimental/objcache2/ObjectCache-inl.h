@@ -204,7 +204,7 @@ ObjectCache<AllocatorT>::insertOrReplace(folly::StringPiece key,
 
   // update total object size
   if (config_.objectSizeTrackingEnabled) {
-    totalObjectSizeBytes_.fetch_add(objectSize, std::memory_order_relaxed);
+    updateTotalObjectSize(static_cast<int64_t>(objectSize));
   }
 
   // Release the object as it has been successfully inserted to the cache.
@@ -246,7 +246,7 @@ ObjectCache<AllocatorT>::insert(folly::StringPiece key,
   if (success) {
     // update total object size
     if (config_.objectSizeTrackingEnabled) {
-      totalObjectSizeBytes_.fetch_add(objectSize, std::memory_order_relaxed);
+      updateTotalObjectSize(static_cast<int64_t>(objectSize));
     }
     // Release the handle now since we have inserted the handle into the cache,
     // and from now the Cache will be responsible for destroying the object
@@ -260,6 +260,72 @@ ObjectCache<AllocatorT>::insert(folly::StringPiece key,
           std::shared_ptr<T>(ptr, std::move(deleter))};
 }
 
+template <typename AllocatorT>
+template <typename T>
+std::pair<typename ObjectCache<AllocatorT>::AllocStatus, std::shared_ptr<T>>
+ObjectCache<AllocatorT>::insertOrReplace(folly::StringPiece key,
+                                         std::unique_ptr<T> object,
+                                         ObjectMemoryResource& resource,
+                                         uint32_t ttlSecs,
+                                         std::shared_ptr<T>* replacedPtr) {
+  bindMemoryResource(resource);
+  auto res = insertOrReplace(key, std::move(object), sizeof(T), ttlSecs,
+                             replacedPtr);
+  // the object is handed back to the caller and must not be counted anymore.
+  // In every other case it is either in the cache or already destroyed along
+  // with its resource.
+  if (res.first == AllocStatus::kAllocError) {
+    resource.unbind();
+  }
+  return res;
+}
+
+template <typename AllocatorT>
+template <typename T>
+std::pair<typename ObjectCache<AllocatorT>::AllocStatus, std::shared_ptr<T>>
+ObjectCache<AllocatorT>::insert(folly::StringPiece key,
+                                std::unique_ptr<T> object,
+                                ObjectMemoryResource& resource,
+                                uint32_t ttlSecs) {
+  bindMemoryResource(resource);
+  auto res = insert(key, std::move(object), sizeof(T), ttlSecs);
+  // see insertOrReplace
+  if (res.first == AllocStatus::kAllocError) {
+    resource.unbind();
+  }
+  return res;
+}
+
+template <typename AllocatorT>
+void ObjectCache<AllocatorT>::bindMemoryResource(
+    ObjectMemoryResource& resource) {
+  if (!config_.objectSizeTrackingEnabled) {
+    throw std::invalid_argument(
+        "Object size tracking is not enabled but a memory resource is given.");
+  }
+  resource.bind([this](int64_t delta) { updateTotalObjectSize(delta); });
+}
+
+template <typename AllocatorT>
+void ObjectCache<AllocatorT>::updateTotalObjectSize(int64_t delta) {
+  if (delta < 0) {
+    totalObjectSizeBytes_.fetch_sub(static_cast<size_t>(-delta),
+                                    std::memory_order_relaxed);
+    return;
+  }
+  const auto newTotal =
+      totalObjectSizeBytes_.fetch_add(static_cast<size_t>(delta),
+                                      std::memory_order_relaxed) +
+      static_cast<size_t>(delta);
+  // wake the size controller up as soon as the limit is crossed instead of
+  // letting the cache overshoot until its next run
+  const auto limit = config_.cacheSizeLimit;
+  if (sizeController_ && limit > 0 && newTotal > limit &&
+      newTotal - static_cast<size_t>(delta) <= limit) {
+    sizeController_->requestRun();
+  }
+}
+
 template <typename AllocatorT>
 typename AllocatorT::WriteHandle ObjectCache<AllocatorT>::allocateFromL1(
     folly::StringPiece key, uint32_t ttl, uint32_t creationTime) {
@@ -284,6 +350,24 @@ bool ObjectCache<AllocatorT>::allocatePlaceholder(std::string key) {
   return true;
 }
 
+template <typename AllocatorT>
+size_t ObjectCache<AllocatorT>::reserveL1Pool(PoolId pid, size_t numObjects) {
+  numObjects = std::min(numObjects, config_.l1EntriesLimit / l1NumShards_);
+  // the allocations are never inserted, so they go back to the free list of
+  // their allocation class once the handles are dropped
+  std::vector<typename AllocatorT::WriteHandle> hdls;
+  hdls.reserve(numObjects);
+  for (size_t i = 0; i < numObjects; i++) {
+    auto hdl = this->l1Cache_->allocate(pid, getPlaceHolderKey(i),
+                                        sizeof(ObjectCacheItem));
+    if (!hdl) {
+      break;
+    }
+    hdls.push_back(std::move(hdl));
+  }
+  return hdls.size();
+}
+
 template <typename AllocatorT>
 uint32_t ObjectCache<AllocatorT>::getL1AllocSize(uint8_t maxKeySizeBytes) {
   auto requiredSizeBytes = maxKeySizeBytes + sizeof(ObjectCacheItem) +
@@ -329,6 +413,15 @@ void ObjectCache<AllocatorT>::getObjectCacheCounters(
   visitor("objcache.evictions", evictions_.get(),
           util::CounterVisitor::CounterType::RATE);
   visitor("objcache.object_size_bytes", getTotalObjectSize());
+
+  const auto restoreStats = getRestoreStats();
+  visitor("objcache.restore.objects", restoreStats.numRestored);
+  visitor("objcache.restore.expired", restoreStats.numExpired);
+  visitor("objcache.restore.failures", restoreStats.numFailed);
+  visitor("objcache.restore.bytes", restoreStats.numBytes);
+  visitor("objcache.restore.reserved", restoreStats.numReserved);
+  visitor("objcache.restore.duration_ms", restoreStats.duration.count());
+  visitor("objcache.restore.objects_per_sec", restoreStats.objectsPerSec());
 }
 
 template <typename AllocatorT>
@@ -399,8 +492,8 @@ bool ObjectCache<AllocatorT>::persist() {
     return false;
   }
 
-  Persistor persistor(config_.persistThreadCount, config_.persistBaseFilePath,
-                      config_.serializeCb, *this);
+  Persistor persistor(config_.persistThreadCount, config_.persistShardCount,
+                      config_.persistBaseFilePath, config_.serializeCb, *this);
   return persistor.run();
 }
 
@@ -409,8 +502,14 @@ bool ObjectCache<AllocatorT>::recover() {
   if (config_.persistBaseFilePath.empty() || !config_.deserializeCb) {
     return false;
   }
-  Restorer restorer(config_.persistBaseFilePath, config_.deserializeCb, *this);
-  return restorer.run();
+  Restorer restorer(config_.persistBaseFilePath, config_.restoreThreadCount,
+                    config_.deserializeCb, *this);
+  if (!restorer.run()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> l(restoreStatsLock_);
+  restoreStats_ = restorer.getStats();
+  return true;
 }
 
 } // namespace objcache2
@@ -38,6 +38,7 @@
 #include "cachelib/experimental/objcache2/ObjectCacheSizeController.h"
 #include "cachelib/experimental/objcache2/persistence/Persistence.h"
 #include "cachelib/experimental/objcache2/persistence/gen-cpp2/persistent_data_types.h"
+#include "cachelib/experimental/objcache2/util/ObjectMemoryResource.h"
 
 namespace facebook {
 namespace cachelib {
@@ -186,6 +187,32 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
                                                     size_t objectSize = 0,
                                                     uint32_t ttlSecs = 0);
 
+  // Same as above, but the size of the object is the bytes it allocates from
+  // its memory resource plus sizeof(T), instead of a size given by the
+  // caller. The resource stays bound to the cache while the object is in it,
+  // so the total object size follows the object as it grows or shrinks.
+  //
+  // @param resource     the memory resource the object allocates from. It
+  //                     must not be shared with other objects.
+  //
+  // @throw std::invalid_argument if objectSizeTracking is not enabled.
+  template <typename T>
+  std::pair<AllocStatus, std::shared_ptr<T>> insertOrReplace(
+      folly::StringPiece key,
+      std::unique_ptr<T> object,
+      ObjectMemoryResource& resource,
+      uint32_t ttlSecs = 0,
+      std::shared_ptr<T>* replacedPtr = nullptr);
+
+  // Same as above, but the size of the object comes from its memory resource.
+  // See insertOrReplace.
+  template <typename T>
+  std::pair<AllocStatus, std::shared_ptr<T>> insert(
+      folly::StringPiece key,
+      std::unique_ptr<T> object,
+      ObjectMemoryResource& resource,
+      uint32_t ttlSecs = 0);
+
   // Remove an object from cache by its key. No-op if object doesn't exist.
   // @param key   the key to the object.
   void remove(folly::StringPiece key);
@@ -202,6 +229,12 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   // @return false if no recovery happened
   bool recover();
 
+  // @return stats of the last successful recover()
+  RestoreStats getRestoreStats() const {
+    std::lock_guard<std::mutex> l(restoreStatsLock_);
+    return restoreStats_;
+  }
+
   // Get all the stats related to object-cache
   // @param visitor   callback that will be invoked with
   //                  {stat-name, value} for each stat
@@ -258,6 +291,23 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   // @return true if the allocation is successful
   bool allocatePlaceholder(std::string key);
 
+  // Carve the allocations of up to numObjects objects from an L1 pool and
+  // release them, so that restoring the objects takes allocations off the
+  // free list instead of growing the pool one allocation at a time. Capped
+  // at the share of l1EntriesLimit of one pool.
+  //
+  // @return number of allocations reserved
+  size_t reserveL1Pool(PoolId pid, size_t numObjects);
+
+  // Add the delta to the total object size. Wakes up the size controller
+  // when the total goes over the cache size limit.
+  void updateTotalObjectSize(int64_t delta);
+
+  // Report the bytes allocated from the memory resource of an object that is
+  // about to be inserted to the total object size.
+  // @throw std::invalid_argument if objectSizeTracking is not enabled.
+  void bindMemoryResource(ObjectMemoryResource& resource);
+
   // Start size controller
   //
   // @param interval   the period this worker fires
@@ -296,12 +346,16 @@ class ObjectCache : public ObjectCacheBase<AllocatorT> {
   TLCounter replaces_;
   TLCounter removes_;
 
+  mutable std::mutex restoreStatsLock_;
+  RestoreStats restoreStats_;
+
   friend class test::ObjectCacheTest<AllocatorT>;
 
   template <typename AllocatorT2>
   friend class ObjectCacheSizeController;
 
   friend Persistor;
+  friend Restorer;
 };
 } // namespace objcache2
 } // namespace cachelib
@@ -80,6 +80,19 @@ class ObjectCacheBase : public CacheBase {
     return l1Cache_->getEventTrackerStatsMap();
   }
 
+  // @return a map of <prefix>.<stat name> -> stat value for the key prefix
+  // stats. If key prefix stats are not enabled, this will be empty
+  std::unordered_map<std::string, uint64_t> getKeyPrefixStatsMap()
+      const override {
+    return l1Cache_->getKeyPrefixStatsMap();
+  }
+
+  // @return the miss ratio curve estimated for the pool. Empty if miss ratio
+  //         curve estimation is not enabled.
+  PoolMissRatioCurve getPoolMissRatioCurve(PoolId pid) const override {
+    return l1Cache_->getPoolMissRatioCurve(pid);
+  }
+
   // @return the Cache metadata
   CacheMetadata getCacheMetadata() const noexcept override {
     return l1Cache_->getCacheMetadata();
@@ -117,6 +117,18 @@ struct ObjectCacheConfig {
                                        SerializeCb serializeCallback,
                                        DeserializeCb deserializeCallback);
 
+  // Split the persisted objects into this many shard files instead of one
+  // per persist thread. More shards than threads lets a restart restore with
+  // more threads than the shutdown persisted with. A multiple of l1NumShards
+  // makes every shard restore into a single L1 pool.
+  // Persistence must be enabled.
+  ObjectCacheConfig& setPersistShardCount(uint32_t shardCount);
+
+  // Restore the persisted shards with this many threads. 0 restores each
+  // shard in its own thread.
+  // Persistence must be enabled.
+  ObjectCacheConfig& setRestoreThreadCount(uint32_t threadCount);
+
   ObjectCacheConfig& setItemReaperInterval(std::chrono::milliseconds interval);
 
   // With size controller disabled, above this many entries, L1 will start
@@ -175,10 +187,18 @@ struct ObjectCacheConfig {
   // The base file path to save the persistent data for cache persistence.
   // - Metadata will be saved in "baseFilePath";
   // - Objects will be saved in "baseFilePath_i" where i is in
-  //   [0, persistThreadCount)
+  //   [0, persistShardCount), or [0, persistThreadCount) if no shard count
+  //   is set
   // Empty means cache persistence is not enabled.
   std::string persistBaseFilePath{};
 
+  // The number of shard files objects are persisted to. 0 means one per
+  // persist thread.
+  uint32_t persistShardCount{0};
+
+  // The number of threads to restore the shards with. 0 means one per shard.
+  uint32_t restoreThreadCount{0};
+
   // Serialize callback for cache persistence
   SerializeCb serializeCb{};
 
@@ -292,6 +312,29 @@ ObjectCacheConfig<T>& ObjectCacheConfig<T>::enablePersistence(
   return *this;
 }
 
+template <typename T>
+ObjectCacheConfig<T>& ObjectCacheConfig<T>::setPersistShardCount(
+    uint32_t shardCount) {
+  if (persistThreadCount == 0) {
+    throw std::invalid_argument(
+        "Cache persistence must be enabled before setting the shard count");
+  }
+  persistShardCount = shardCount;
+  return *this;
+}
+
+template <typename T>
+ObjectCacheConfig<T>& ObjectCacheConfig<T>::setRestoreThreadCount(
+    uint32_t threadCount) {
+  if (persistThreadCount == 0) {
+    throw std::invalid_argument(
+        "Cache persistence must be enabled before setting the restore thread "
+        "count");
+  }
+  restoreThreadCount = threadCount;
+  return *this;
+}
+
 template <typename T>
 ObjectCacheConfig<T>& ObjectCacheConfig<T>::setItemReaperInterval(
     std::chrono::milliseconds _reaperInterval) {
@@ -19,6 +19,7 @@ namespace cachelib {
 namespace objcache2 {
 template <typename AllocatorT>
 void ObjectCacheSizeController<AllocatorT>::work() {
+  runRequested_.store(false, std::memory_order_relaxed);
   auto currentNumEntries = objCache_.getNumEntries();
   if (currentNumEntries == 0) {
     return;
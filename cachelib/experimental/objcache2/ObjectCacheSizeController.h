@@ -35,6 +35,14 @@ class ObjectCacheSizeController : public PeriodicWorker {
     return currentEntriesLimit_.load(std::memory_order_relaxed);
   }
 
+  // Run the controller now instead of at its next interval. Requests made
+  // before the run starts are coalesced into one.
+  void requestRun() noexcept {
+    if (!runRequested_.exchange(true, std::memory_order_relaxed)) {
+      wakeUp();
+    }
+  }
+
  private:
   void work() override final;
 
@@ -52,6 +60,9 @@ class ObjectCacheSizeController : public PeriodicWorker {
 
   // will be adjusted to control the cache size limit
   std::atomic<size_t> currentEntriesLimit_;
+
+  // whether a run has been requested since the last one started
+  std::atomic<bool> runRequested_{false};
 };
 
 } // namespace objcache2
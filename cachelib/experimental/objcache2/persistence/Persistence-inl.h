@@ -32,18 +32,82 @@ void PersistWorker<ObjectCache>::work() {
     }
 
     // serialize persistentItem
-    persistence::Item persistentItem;
-    persistentItem.key().value() = workUnit.key;
-    persistentItem.objectSize().value() = workUnit.objectSize;
-    persistentItem.expiryTime().value() = workUnit.expiryTime;
-    persistentItem.payload().value().resize(payloadIobuf->length());
-    std::memcpy(persistentItem.payload().value().data(), payloadIobuf->data(),
+    persistentItem_.key().value() = workUnit.key;
+    persistentItem_.objectSize().value() = workUnit.objectSize;
+    persistentItem_.expiryTime().value() = workUnit.expiryTime;
+    persistentItem_.payload().value().resize(payloadIobuf->length());
+    std::memcpy(persistentItem_.payload().value().data(), payloadIobuf->data(),
                 payloadIobuf->length());
-    auto iobuf = Serializer::serializeToIOBuf(persistentItem);
-    recordWriter_->writeRecord(std::move(iobuf));
+    auto iobuf = Serializer::serializeToIOBuf(persistentItem_);
+    const auto idx = workUnit.shard / numWorkers_;
+    XDCHECK_LT(idx, recordWriters_.size());
+    recordWriters_[idx]->writeRecord(std::move(iobuf));
+    numObjects_[idx]++;
   }
 }
 
+template <typename ObjectCache>
+Persistor<ObjectCache>::Persistor(uint32_t threadCount,
+                                  uint32_t shardCount,
+                                  std::string baseFilePath,
+                                  SerializeCb& serializeCb,
+                                  ObjectCache& objCache)
+    : baseFilePath_(std::move(baseFilePath)),
+      shardCount_(shardCount == 0 ? threadCount : shardCount),
+      objCache_(objCache) {
+  // persist metadata. The object counts are filled in once all the objects
+  // are persisted.
+  if (!writeMetadata({})) {
+    initSuccess_ = false;
+    return;
+  }
+
+  // persist objects
+  const uint32_t numWorkers = std::min(threadCount, shardCount_);
+  for (uint32_t i = 0; i < numWorkers; i++) {
+    try {
+      // create new files if not exist or write from the beginning
+      std::vector<folly::File> files;
+      for (uint32_t shard = i; shard < shardCount_; shard += numWorkers) {
+        files.emplace_back(getPersistFilePath(baseFilePath_, shard),
+                           O_CREAT | O_WRONLY | O_TRUNC);
+      }
+      queues_.emplace_back(
+          std::make_unique<folly::MPMCQueue<WorkUnit>>(kQueueSize_));
+      workers_.emplace_back(std::make_unique<PersistWorker>(
+          i, std::move(files), numWorkers, serializeCb, *queues_.back()));
+    } catch (const std::exception& e) {
+      XLOGF(ERR,
+            "Persistor initialization failed: Failed to create persist "
+            "worker {}, reason = {}",
+            i, folly::exceptionStr(e));
+      initSuccess_ = false;
+      break;
+    }
+  }
+}
+
+template <typename ObjectCache>
+bool Persistor<ObjectCache>::writeMetadata(
+    const std::vector<int64_t>& shardNumObjects) {
+  try {
+    // create a new base file if not exist or write from the beginning
+    auto basefile = folly::File(baseFilePath_, O_CREAT | O_WRONLY | O_TRUNC);
+    auto rw = navy::createFileRecordWriter(std::move(basefile));
+    persistence::Metadata metadata;
+    metadata.threadCount().value() = shardCount_;
+    metadata.shardNumObjects().value() = shardNumObjects;
+    auto iobuf = Serializer::serializeToIOBuf(metadata);
+    rw->writeRecord(std::move(iobuf));
+  } catch (const std::exception& e) {
+    XLOGF(ERR,
+          "Persistor failed to write metadata, reason = {}",
+          folly::exceptionStr(e));
+    return false;
+  }
+  return true;
+}
+
 template <typename ObjectCache>
 bool Persistor<ObjectCache>::run() {
   if (!initSuccess_) {
@@ -54,7 +118,8 @@ bool Persistor<ObjectCache>::run() {
     worker->start(kWorkerInterval_, worker->getName());
   }
 
-  // add objects to the queue
+  // add objects to the queue of the worker that owns their shard
+  const auto numWorkers = static_cast<uint32_t>(workers_.size());
   for (auto itr = objCache_.l1Cache_->begin(); itr != objCache_.l1Cache_->end();
        ++itr) {
     // no need to persist if item is already expired
@@ -64,32 +129,44 @@ bool Persistor<ObjectCache>::run() {
     }
     auto itemPtr =
         reinterpret_cast<typename ObjectCache::Item*>(itr->getMemory());
-    WorkUnit unit{itr->getKey(), itemPtr->objectPtr, itemPtr->objectSize,
-                  itr->getExpiryTime()};
-    queue_.write(std::move(unit));
+    const auto key = itr->getKey();
+    const auto shard = static_cast<uint32_t>(
+        MurmurHash2{}(key.data(), key.size()) % shardCount_);
+    WorkUnit unit{key, itemPtr->objectPtr, itemPtr->objectSize,
+                  itr->getExpiryTime(), shard};
+    queues_[shard % numWorkers]->blockingWrite(std::move(unit));
   }
   XLOGF(INFO, "Persistor found {} expired objects", numExpired_);
 
-  // Wait until all items in the queue are consumed and persisted
-  while (!queue_.isEmpty()) {
-    std::this_thread::sleep_for(kSleepInterval_);
+  // Wait until all items in the queues are consumed and persisted
+  for (auto& queue : queues_) {
+    while (!queue->isEmpty()) {
+      std::this_thread::sleep_for(kSleepInterval_);
+    }
   }
 
   // stop all workers
-  for (auto& worker : workers_) {
-    if (!worker->stop()) {
-      XLOG(ERR) << folly::sformat("{} failed to stop", worker->getName());
+  std::vector<int64_t> shardNumObjects(shardCount_, 0);
+  for (uint32_t i = 0; i < numWorkers; i++) {
+    if (!workers_[i]->stop()) {
+      XLOG(ERR) << folly::sformat("{} failed to stop", workers_[i]->getName());
+    }
+    const auto& numObjects = workers_[i]->getNumObjects();
+    for (size_t j = 0; j < numObjects.size(); j++) {
+      shardNumObjects[i + j * numWorkers] = numObjects[j];
     }
   }
-  return true;
+  return writeMetadata(shardNumObjects);
 }
 
 template <typename ObjectCache>
-Restorer<ObjectCache>::Restorer(std::string& baseFilePath,
+Restorer<ObjectCache>::Restorer(const std::string& baseFilePath,
+                                uint32_t threadCount,
                                 DeserializeCb& deserializeCb,
-                                ObjectCache& objCache) {
+                                ObjectCache& objCache)
+    : threadCount_(threadCount), objCache_(objCache) {
   // restore metadata
-  uint32_t threadCount = 0;
+  uint32_t shardCount = 0;
   try {
     auto basefile = folly::File(baseFilePath, O_RDONLY);
     auto rr = navy::createFileRecordReader(std::move(basefile));
@@ -97,7 +174,8 @@ Restorer<ObjectCache>::Restorer(std::string& baseFilePath,
       auto iobuf = rr->readRecord();
       Deserializer deserializer(iobuf->data(), iobuf->data() + iobuf->length());
       auto metadata = deserializer.deserialize<persistence::Metadata>();
-      threadCount = metadata.threadCount().value();
+      shardCount = metadata.threadCount().value();
+      shardNumObjects_ = metadata.shardNumObjects().value();
     }
   } catch (const std::exception& e) {
     XLOGF(ERR,
@@ -108,8 +186,20 @@ Restorer<ObjectCache>::Restorer(std::string& baseFilePath,
     return;
   }
 
+  // restore the largest shards first. Their sizes are unknown if the files
+  // were written by an older version.
+  std::vector<uint32_t> shards(shardCount);
+  std::iota(shards.begin(), shards.end(), 0);
+  if (shardNumObjects_.size() == shardCount) {
+    std::stable_sort(shards.begin(), shards.end(), [&](auto a, auto b) {
+      return shardNumObjects_[a] > shardNumObjects_[b];
+    });
+  } else {
+    shardNumObjects_.clear();
+  }
+
   // restore objects
-  for (uint32_t i = 0; i < threadCount; i++) {
+  for (const auto i : shards) {
     try {
       auto file = folly::File(
           ObjectCache::Persistor::getPersistFilePath(baseFilePath, i),
@@ -130,11 +220,14 @@ Restorer<ObjectCache>::Restorer(std::string& baseFilePath,
 template <typename ObjectCache>
 void RestoreWorker<ObjectCache>::work() {
   uint32_t currentTime = util::getCurrentTimeSec();
+  // reused across records so that its buffers keep their capacity
+  persistence::Item persistentItem;
   while (!recordReader_->isEnd()) {
     auto iobuf = recordReader_->readRecord();
+    numBytes_ += iobuf->computeChainDataLength();
     // deserialize persistentItem
     Deserializer deserializer(iobuf->data(), iobuf->data() + iobuf->length());
-    auto persistentItem = deserializer.deserialize<persistence::Item>();
+    deserializer.deserialize(persistentItem);
     uint32_t expiryTime = persistentItem.expiryTime().value();
     // no need to recover if object is already expired
     if (expiryTime > 0 && expiryTime <= currentTime) {
@@ -147,12 +240,16 @@ void RestoreWorker<ObjectCache>::work() {
       bool success = deserializeCb_(typename ObjectCache::Deserializer(
           persistentItem.key().value(), persistentItem.payload().value(),
           persistentItem.objectSize().value(), ttlSecs, objCache_));
-      if (!success) {
+      if (success) {
+        numRestored_++;
+      } else {
+        numFailed_++;
         XLOG_EVERY_N(INFO, 1000)
             << folly::sformat("{} failed to deserialize object for key = {}",
                               getName(), persistentItem.key().value());
       }
     } catch (const std::exception& e) {
+      numFailed_++;
       XLOG_EVERY_N(INFO, 1000) << folly::sformat(
           "{} failed to deserialize object for key = {}, exception "
           "= {}",
@@ -163,26 +260,88 @@ void RestoreWorker<ObjectCache>::work() {
   }
 }
 
+template <typename ObjectCache>
+uint64_t Restorer<ObjectCache>::reserveL1Pools(uint32_t numThreads) {
+  const auto numPools = objCache_.l1NumShards_;
+  if (shardNumObjects_.empty() || numPools == 0) {
+    return 0;
+  }
+  std::vector<size_t> poolNumObjects(numPools, 0);
+  const auto numShards = shardNumObjects_.size();
+  for (size_t i = 0; i < numShards; i++) {
+    const auto numObjects = static_cast<size_t>(shardNumObjects_[i]);
+    if (numShards % numPools == 0) {
+      poolNumObjects[i % numPools] += numObjects;
+    } else {
+      for (auto& n : poolNumObjects) {
+        n += numObjects / numPools;
+      }
+    }
+  }
+
+  std::atomic<size_t> nextPool{0};
+  std::atomic<uint64_t> numReserved{0};
+  std::vector<std::thread> ts;
+  for (uint32_t t = 0; t < std::min<size_t>(numThreads, numPools); t++) {
+    ts.emplace_back([&]() {
+      for (auto i = nextPool++; i < numPools; i = nextPool++) {
+        numReserved += objCache_.reserveL1Pool(static_cast<PoolId>(i),
+                                               poolNumObjects[i]);
+      }
+    });
+  }
+  for (auto& t : ts) {
+    t.join();
+  }
+  return numReserved;
+}
+
 template <typename ObjectCache>
 bool Restorer<ObjectCache>::run() {
   if (!initSuccess_) {
     return false;
   }
+  const auto startTime = std::chrono::steady_clock::now();
+  const auto numShards = static_cast<uint32_t>(workers_.size());
+  const auto numThreads =
+      threadCount_ == 0 ? numShards : std::min(threadCount_, numShards);
+
+  // carve the allocations of the persisted objects before any of them is
+  // inserted, so that the restore threads do not contend on growing the pools
+  stats_.numReserved = reserveL1Pools(numThreads);
+
+  // start restore threads that each restore the next shard not taken yet
+  std::atomic<uint32_t> nextShard{0};
   std::vector<std::thread> ts;
-  for (size_t i = 0; i < workers_.size(); i++) {
-    ts.emplace_back(std::thread{[&](int i) {
-                                  workers_[i]->work();
-                                  // accumulate expired object number
-                                  numExpired_ += workers_[i]->getNumExpired();
-                                },
-                                i});
+  for (uint32_t t = 0; t < numThreads; t++) {
+    ts.emplace_back([&]() {
+      for (auto i = nextShard++; i < numShards; i = nextShard++) {
+        workers_[i]->work();
+        // accumulate expired object number
+        numExpired_ += workers_[i]->getNumExpired();
+      }
+    });
   }
-
-  // start restoreWorkers in different threads
   for (auto& t : ts) {
     t.join();
   }
-  XLOGF(INFO, "Restorer found {} expired objects", numExpired_);
+
+  stats_.numShards = numShards;
+  stats_.numExpired = numExpired_;
+  for (const auto& worker : workers_) {
+    stats_.numRestored += worker->getNumRestored();
+    stats_.numFailed += worker->getNumFailed();
+    stats_.numBytes += worker->getNumBytes();
+  }
+  stats_.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  XLOGF(INFO,
+        "Restorer restored {} objects from {} shards with {} threads in {} "
+        "ms ({:.0f} objects/s), {} expired, {} failed, {} allocations "
+        "reserved",
+        stats_.numRestored, numShards, numThreads, stats_.duration.count(),
+        stats_.objectsPerSec(), stats_.numExpired, stats_.numFailed,
+        stats_.numReserved);
   return true;
 }
 
@@ -19,10 +19,16 @@
 #include <folly/File.h>
 #include <folly/MPMCQueue.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <numeric>
 #include <string>
 #include <thread>
+#include <vector>
 
+#include "cachelib/common/Hash.h"
 #include "cachelib/common/PeriodicWorker.h"
 #include "cachelib/common/Serialization.h"
 #include "cachelib/common/Time.h"
@@ -34,6 +40,36 @@ namespace facebook {
 namespace cachelib {
 namespace objcache2 {
 
+// Stats of the last recovery of an object cache.
+struct RestoreStats {
+  // number of shard files restored
+  uint64_t numShards{0};
+
+  // number of objects inserted back to the cache
+  uint64_t numRestored{0};
+
+  // number of objects that had expired and were skipped
+  uint64_t numExpired{0};
+
+  // number of objects that failed to deserialize or insert
+  uint64_t numFailed{0};
+
+  // bytes of persisted records read
+  uint64_t numBytes{0};
+
+  // number of L1 allocations carved before restoring the objects
+  uint64_t numReserved{0};
+
+  // wall clock time of the recovery
+  std::chrono::milliseconds duration{0};
+
+  double objectsPerSec() const {
+    return duration.count() == 0 ? 0
+                                 : static_cast<double>(numRestored) * 1000 /
+                                       static_cast<double>(duration.count());
+  }
+};
+
 template <typename ObjectCache>
 class PersistWorker : public PeriodicWorker {
  public:
@@ -42,30 +78,57 @@ class PersistWorker : public PeriodicWorker {
     uintptr_t objectPtr;
     size_t objectSize;
     uint32_t expiryTime;
+    // the shard the object is persisted to
+    uint32_t shard;
   };
 
   using SerializeCb = typename ObjectCache::SerializeCb;
+
+  // @param id          id of the worker
+  // @param files       files of the shards the worker owns. Worker i owns
+  //                    shards i, i + numWorkers, i + 2 * numWorkers, ...
+  // @param numWorkers  total number of persist workers
+  // @param queue       queue of the objects in the shards the worker owns
   explicit PersistWorker(uint32_t id,
-                         folly::File file,
+                         std::vector<folly::File> files,
+                         uint32_t numWorkers,
                          SerializeCb& serializeCb,
                          folly::MPMCQueue<WorkUnit>& queue)
       : id_(id),
+        numWorkers_(numWorkers),
         serializeCb_(serializeCb),
         queue_(queue),
-        recordWriter_(navy::createFileRecordWriter(std::move(file))) {}
+        numObjects_(files.size(), 0) {
+    for (auto& file : files) {
+      recordWriters_.push_back(navy::createFileRecordWriter(std::move(file)));
+    }
+  }
 
   // Consume the MPMC queue to persist objects.
   void work() override;
 
   std::string getName() { return folly::sformat("PersistWorker_{}", id_); }
 
+  // @return number of objects persisted to each shard the worker owns, in
+  //         the order of the files it was given.
+  const std::vector<int64_t>& getNumObjects() const { return numObjects_; }
+
  private:
   uint32_t id_;
+  uint32_t numWorkers_;
   SerializeCb& serializeCb_;
   folly::MPMCQueue<WorkUnit>& queue_;
-  std::unique_ptr<RecordWriter> recordWriter_;
+  std::vector<std::unique_ptr<RecordWriter>> recordWriters_;
+  std::vector<int64_t> numObjects_;
+  // reused across objects so that its buffers keep their capacity
+  persistence::Item persistentItem_;
 };
 
+// Persists the objects of the cache into a number of shard files, each
+// written by one worker. Objects are assigned to shards by the hash of their
+// key, the same way the cache assigns them to its L1 pools, so when the
+// number of shards is a multiple of the number of pools every shard restores
+// into a single pool.
 template <typename ObjectCache>
 class Persistor {
  public:
@@ -73,64 +136,36 @@ class Persistor {
   using WorkUnit = typename PersistWorker::WorkUnit;
   using SerializeCb = typename PersistWorker::SerializeCb;
 
+  // @param threadCount   number of persist workers
+  // @param shardCount    number of shard files. 0 means one per worker.
+  // @param baseFilePath  path of the metadata file. Shard i is written to
+  //                      getPersistFilePath(baseFilePath, i).
   explicit Persistor(uint32_t threadCount,
+                     uint32_t shardCount,
                      std::string baseFilePath,
                      SerializeCb& serializeCb,
-                     ObjectCache& objCache)
-      : queue_(folly::MPMCQueue<WorkUnit>(kQueueSize_)), objCache_(objCache) {
-    // persist metadata
-    try {
-      // create a new base file if not exist or write from the beginning
-      auto basefile = folly::File(baseFilePath, O_CREAT | O_WRONLY | O_TRUNC);
-      auto rw = navy::createFileRecordWriter(std::move(basefile));
-      persistence::Metadata metadata;
-      metadata.threadCount().value() = threadCount;
-      auto iobuf = Serializer::serializeToIOBuf(metadata);
-      rw->writeRecord(std::move(iobuf));
-    } catch (const std::exception& e) {
-      XLOGF(ERR,
-            "Persistor initialization failed: Failed to write metadata, reason "
-            "= {}",
-            folly::exceptionStr(e));
-      initSuccess_ = false;
-      return;
-    }
-
-    // persist objects
-    for (uint32_t i = 0; i < threadCount; i++) {
-      try {
-        // create a new file if not exist or write from the beginning
-        auto file = folly::File(getPersistFilePath(baseFilePath, i),
-                                O_CREAT | O_WRONLY | O_TRUNC);
-        workers_.emplace_back(std::make_unique<PersistWorker>(
-            i, std::move(file), serializeCb, queue_));
-      } catch (const std::exception& e) {
-        XLOGF(ERR,
-              "Persistor initialization failed: Failed to create persist "
-              "worker {}, reason = {}",
-              i, folly::exceptionStr(e));
-        initSuccess_ = false;
-        break;
-      }
-    }
-  }
+                     ObjectCache& objCache);
 
   // Start persist workers in different threads; meanwhile add objects to the
-  // MPMC queue.
+  // MPMC queues.
   // @return false if Persistor initialization failed
   bool run();
 
   // @return number of expired objects that are not persisted.
   uint32_t getNumExpired() { return numExpired_; }
 
-  // @return the file path for ith worker
-  static inline std::string getPersistFilePath(std::string& basePath,
-                                               uint32_t workerId) {
-    return folly::sformat("{}_{}", basePath, workerId);
+  // @return the file path for ith shard
+  static inline std::string getPersistFilePath(const std::string& basePath,
+                                               uint32_t shardId) {
+    return folly::sformat("{}_{}", basePath, shardId);
   }
 
  private:
-  // size of the MPMC Queue
+  // write the metadata file. shardNumObjects is left empty until all the
+  // objects have been persisted.
+  bool writeMetadata(const std::vector<int64_t>& shardNumObjects);
+
+  // size of each MPMC Queue
   static constexpr uint32_t kQueueSize_{1000};
   // persistor sleep interval while waiting for all workers to finish
   static constexpr std::chrono::seconds kSleepInterval_{1};
@@ -138,12 +173,16 @@ class Persistor {
   static constexpr std::chrono::milliseconds kWorkerInterval_{1};
 
   bool initSuccess_{true};
-  folly::MPMCQueue<WorkUnit> queue_;
+  const std::string baseFilePath_;
+  uint32_t shardCount_;
+  // one queue per worker
+  std::vector<std::unique_ptr<folly::MPMCQueue<WorkUnit>>> queues_;
   std::vector<std::unique_ptr<PersistWorker>> workers_;
   ObjectCache& objCache_;
   uint32_t numExpired_{0};
 };
 
+// Restores the objects of one shard file.
 template <typename ObjectCache>
 class RestoreWorker {
  public:
@@ -160,8 +199,17 @@ class RestoreWorker {
   // Restore objects to the cache.
   void work();
 
-  // @return number of expired objects in a worker thread
-  uint32_t getNumExpired() { return numExpired_; }
+  // @return number of expired objects in the shard
+  uint32_t getNumExpired() const { return numExpired_; }
+
+  // @return number of objects inserted to the cache
+  uint64_t getNumRestored() const { return numRestored_; }
+
+  // @return number of objects that failed to be restored
+  uint64_t getNumFailed() const { return numFailed_; }
+
+  // @return bytes of records read
+  uint64_t getNumBytes() const { return numBytes_; }
 
   std::string getName() { return folly::sformat("RestoreWorker_{}", id_); }
 
@@ -171,15 +219,24 @@ class RestoreWorker {
   ObjectCache& objCache_;
   std::unique_ptr<RecordReader> recordReader_;
   uint32_t numExpired_{0};
+  uint64_t numRestored_{0};
+  uint64_t numFailed_{0};
+  uint64_t numBytes_{0};
 };
 
+// Restores the shard files concurrently. Each thread picks the next shard
+// that is not restored yet, largest first when the shard sizes are known, so
+// the threads finish around the same time even if the shards are uneven.
 template <typename ObjectCache>
 class Restorer {
  public:
   using RestoreWorker = RestoreWorker<ObjectCache>;
   using DeserializeCb = typename RestoreWorker::DeserializeCb;
 
-  explicit Restorer(std::string& baseFilePath,
+  // @param baseFilePath  path of the metadata file
+  // @param threadCount   number of restore threads. 0 means one per shard.
+  explicit Restorer(const std::string& baseFilePath,
+                    uint32_t threadCount,
                     DeserializeCb& deserializeCb,
                     ObjectCache& objCache);
 
@@ -190,10 +247,28 @@ class Restorer {
   // @return number of expired objects that are not restored.
   uint32_t getNumExpired() { return numExpired_; }
 
+  // @return stats of the restore. Complete once run() returns.
+  const RestoreStats& getStats() const { return stats_; }
+
  private:
+  // Reserve the L1 allocations of the persisted objects with numThreads
+  // threads, one pool at a time per thread. Objects of a shard land in the
+  // pool of the same index modulo the number of pools when the shard count
+  // is a multiple of it, as both shard by the same key hash; otherwise the
+  // objects are spread evenly across the pools.
+  //
+  // @return number of allocations reserved
+  uint64_t reserveL1Pools(uint32_t numThreads);
+
   bool initSuccess_{true};
+  uint32_t threadCount_;
+  ObjectCache& objCache_;
+  // number of objects persisted in each shard, empty if unknown
+  std::vector<int64_t> shardNumObjects_;
+  // one worker per shard, in the order they are restored
   std::vector<std::unique_ptr<RestoreWorker>> workers_;
   std::atomic<uint32_t> numExpired_{0};
+  RestoreStats stats_;
 };
 
 } // namespace objcache2
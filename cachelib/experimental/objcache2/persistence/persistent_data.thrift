@@ -24,5 +24,10 @@ struct Item {
 }
 
 struct Metadata {
+  // number of object files (shards). Each persist thread used to write
+  // exactly one file, hence the name.
   1: i32 threadCount,
+  // number of objects persisted in each shard. Empty if the persistence did
+  // not complete or was written by an older version.
+  2: list<i64> shardNumObjects,
 }
@@ -16,6 +16,10 @@
 
 #include <gtest/gtest.h>
 
+#include <memory_resource>
+#include <numeric>
+#include <vector>
+
 #include "cachelib/allocator/CacheAllocator.h"
 #include "cachelib/experimental/objcache2/ObjectCache.h"
 #include "cachelib/experimental/objcache2/persistence/gen-cpp2/persistent_data_types.h"
@@ -59,6 +63,11 @@ struct Foo5 : FooBase {
   int e{};
   int f{};
 };
+
+struct PmrFoo {
+  ObjectMemoryResource mr;
+  std::pmr::vector<int> vec{&mr};
+};
 } // namespace
 
 template <typename AllocatorT>
@@ -155,6 +164,9 @@ class ObjectCacheTest : public ::testing::Test {
                        },
                        nullptr),
                    std::invalid_argument);
+      // persistence not enabled
+      EXPECT_THROW(config.setPersistShardCount(4), std::invalid_argument);
+      EXPECT_THROW(config.setRestoreThreadCount(4), std::invalid_argument);
     }
   }
 
@@ -562,6 +574,97 @@ class ObjectCacheTest : public ::testing::Test {
     EXPECT_EQ(3, found2->c);
   }
 
+  void testObjectSizeTrackingMemoryResource() {
+    {
+      // object size tracking is not enabled
+      ObjectCacheConfig config;
+      config.setCacheName("test").setCacheCapacity(10'000).setItemDestructor(
+          [&](ObjectCacheDestructorData data) {
+            data.deleteObject<PmrFoo>();
+          });
+      auto objcache = ObjectCache::create(config);
+      auto foo = std::make_unique<PmrFoo>();
+      auto& mr = foo->mr;
+      ASSERT_THROW(objcache->insertOrReplace("Foo", std::move(foo), mr),
+                   std::invalid_argument);
+    }
+
+    ObjectCacheConfig config;
+    config.setCacheName("test")
+        .setCacheCapacity(10'000 /* l1EntriesLimit*/,
+                          10'000'000 /* cacheSizeLimit */,
+                          100 /* sizeControllerIntervalMs */)
+        .setItemDestructor([&](ObjectCacheDestructorData data) {
+          data.deleteObject<PmrFoo>();
+        });
+    auto objcache = ObjectCache::create(config);
+
+    auto foo1 = std::make_unique<PmrFoo>();
+    foo1->vec.resize(100);
+    auto& mr1 = foo1->mr;
+    auto res = objcache->insertOrReplace("Foo1", std::move(foo1), mr1);
+    ASSERT_EQ(ObjectCache::AllocStatus::kSuccess, res.first);
+    const auto foo1Size = sizeof(PmrFoo) + mr1.getUsedBytes();
+    EXPECT_GE(foo1Size, sizeof(PmrFoo) + 100 * sizeof(int));
+    EXPECT_EQ(foo1Size, objcache->getTotalObjectSize());
+
+    // growing the object after insertion is accounted for right away
+    {
+      auto found = objcache->template findToWrite<PmrFoo>("Foo1");
+      ASSERT_NE(nullptr, found);
+      found->vec.resize(10'000);
+      EXPECT_EQ(sizeof(PmrFoo) + found->mr.getUsedBytes(),
+                objcache->getTotalObjectSize());
+      EXPECT_GE(objcache->getTotalObjectSize(),
+                sizeof(PmrFoo) + 10'000 * sizeof(int));
+    }
+
+    // a duplicate insert leaves the total untouched
+    auto total = objcache->getTotalObjectSize();
+    auto foo2 = std::make_unique<PmrFoo>();
+    foo2->vec.resize(50);
+    auto& mr2 = foo2->mr;
+    res = objcache->insert("Foo1", std::move(foo2), mr2);
+    EXPECT_EQ(ObjectCache::AllocStatus::kKeyAlreadyExists, res.first);
+    EXPECT_EQ(total, objcache->getTotalObjectSize());
+
+    auto foo3 = std::make_unique<PmrFoo>();
+    foo3->vec.resize(50);
+    auto& mr3 = foo3->mr;
+    res = objcache->insert("Foo3", std::move(foo3), mr3);
+    EXPECT_EQ(ObjectCache::AllocStatus::kSuccess, res.first);
+    EXPECT_EQ(total + sizeof(PmrFoo) + mr3.getUsedBytes(),
+              objcache->getTotalObjectSize());
+    res.second.reset();
+
+    // removing the objects releases everything they allocated
+    objcache->remove("Foo1");
+    objcache->remove("Foo3");
+    EXPECT_EQ(0, objcache->getTotalObjectSize());
+  }
+
+  void testSizeControllerWakesUpOverLimit() {
+    ObjectCacheConfig config;
+    config.setCacheName("test")
+        .setCacheCapacity(1'000 /* l1EntriesLimit*/,
+                          100'000 /* cacheSizeLimit */,
+                          3'600'000 /* sizeControllerIntervalMs */)
+        .setItemDestructor(
+            [&](ObjectCacheDestructorData data) { data.deleteObject<Foo>(); });
+    auto objcache = ObjectCache::create(config);
+
+    // go over the limit long before the controller's next scheduled run
+    for (int i = 0; i < 200; i++) {
+      objcache->insertOrReplace(folly::sformat("key_{}", i),
+                                std::make_unique<Foo>(), 1000);
+    }
+    for (int i = 0; i < 100 && objcache->getCurrentEntriesLimit() == 1'000;
+         i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    }
+    EXPECT_LT(objcache->getCurrentEntriesLimit(), 1'000);
+  }
+
   void testPersistence() {
     auto persistBaseFilePath = std::tmpnam(nullptr);
     ThriftFoo foo1;
@@ -879,6 +982,82 @@ class ObjectCacheTest : public ::testing::Test {
     }
   }
 
+  void testPersistenceSharded() {
+    ObjectCacheConfig config;
+    auto persistBaseFilePath = std::tmpnam(nullptr);
+    int objectNum = 1000;
+    size_t totalObjectSize = 0;
+
+    config.setCacheName("test")
+        .setCacheCapacity(10'000 /*l1EntriesLimit*/)
+        .setNumShards(4)
+        .setItemDestructor([&](ObjectCacheDestructorData data) {
+          data.deleteObject<ThriftFoo>();
+        })
+        .enablePersistence(
+            3 /* threadCount */, persistBaseFilePath,
+            [&](typename ObjectCache::Serializer serializer) {
+              return serializer.template serialize<ThriftFoo>();
+            },
+            [&](typename ObjectCache::Deserializer deserializer) {
+              return deserializer.template deserialize<ThriftFoo>();
+            })
+        .setPersistShardCount(16);
+    config.objectSizeTrackingEnabled = true;
+
+    {
+      auto objcache = ObjectCache::create(config);
+      for (int i = 0; i < objectNum; i++) {
+        int objectSize = i + 10;
+        auto object = std::make_unique<ThriftFoo>();
+        object->a().value() = i;
+        objcache->insertOrReplace(folly::sformat("key_{}", i),
+                                  std::move(object), objectSize);
+        totalObjectSize += objectSize;
+      }
+      ASSERT_EQ(objcache->persist(), true);
+    }
+
+    // every shard has a file and the metadata knows its size
+    {
+      auto rr = navy::createFileRecordReader(
+          folly::File(persistBaseFilePath, O_RDONLY));
+      auto iobuf = rr->readRecord();
+      Deserializer deserializer(iobuf->data(), iobuf->data() + iobuf->length());
+      auto metadata = deserializer.deserialize<persistence::Metadata>();
+      EXPECT_EQ(16, metadata.threadCount().value());
+      const auto& shardNumObjects = metadata.shardNumObjects().value();
+      ASSERT_EQ(16, shardNumObjects.size());
+      EXPECT_EQ(objectNum, std::accumulate(shardNumObjects.begin(),
+                                           shardNumObjects.end(), 0L));
+    }
+
+    // restore with a different number of threads than persisted with
+    for (uint32_t restoreThreads : {0u, 1u, 5u}) {
+      config.setRestoreThreadCount(restoreThreads);
+      auto objcache = ObjectCache::create(config);
+      ASSERT_EQ(objcache->recover(), true);
+      for (int i = 0; i < objectNum; i++) {
+        auto found =
+            objcache->template find<ThriftFoo>(folly::sformat("key_{}", i));
+        ASSERT_NE(nullptr, found);
+        EXPECT_EQ(i, found->a_ref());
+      }
+      EXPECT_EQ(objcache->getNumEntries(), objectNum);
+      EXPECT_EQ(objcache->getTotalObjectSize(), totalObjectSize);
+
+      const auto stats = objcache->getRestoreStats();
+      EXPECT_EQ(16, stats.numShards);
+      EXPECT_EQ(objectNum, stats.numRestored);
+      EXPECT_EQ(0, stats.numExpired);
+      EXPECT_EQ(0, stats.numFailed);
+      EXPECT_GT(stats.numBytes, 0);
+      // the pools were grown for the persisted objects up front
+      EXPECT_GT(stats.numReserved, 0);
+      EXPECT_LE(stats.numReserved, objectNum);
+    }
+  }
+
   void testMultithreadReplace() {
     // Sanity test to see if insertOrReplace across multiple
     // threads are safe.
@@ -1102,6 +1281,12 @@ TYPED_TEST(ObjectCacheTest, ObjectSizeTrackingBasics) {
 TYPED_TEST(ObjectCacheTest, ObjectSizeTrackingUniqueInsert) {
   this->testObjectSizeTrackingUniqueInsert();
 }
+TYPED_TEST(ObjectCacheTest, ObjectSizeTrackingMemoryResource) {
+  this->testObjectSizeTrackingMemoryResource();
+}
+TYPED_TEST(ObjectCacheTest, SizeControllerWakesUpOverLimit) {
+  this->testSizeControllerWakesUpOverLimit();
+}
 TYPED_TEST(ObjectCacheTest, Persistence) { this->testPersistence(); }
 TYPED_TEST(ObjectCacheTest, PersistenceMultiType) {
   this->testPersistenceMultiType();
@@ -1109,6 +1294,9 @@ TYPED_TEST(ObjectCacheTest, PersistenceMultiType) {
 TYPED_TEST(ObjectCacheTest, PersistenceHighLoad) {
   this->testPersistenceHighLoad();
 }
+TYPED_TEST(ObjectCacheTest, PersistenceSharded) {
+  this->testPersistenceSharded();
+}
 
 TYPED_TEST(ObjectCacheTest, MultithreadReplace) {
   this->testMultithreadReplace();
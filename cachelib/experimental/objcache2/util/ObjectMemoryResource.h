@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+
+namespace facebook {
+namespace cachelib {
+namespace objcache2 {
+
+// A memory resource that counts the bytes allocated through it. Use this
+// class to get the exact size of an object instead of estimating it with
+// ThreadMemoryTracker: give each object its own resource, allocate the
+// object's members (e.g. std::pmr containers) from it, and insert the object
+// together with its resource. The cache then sees every later allocation or
+// deallocation of the object as soon as it happens.
+//
+// The resource must outlive every allocation made from it; declaring it as
+// the first member of the object does that.
+// Example:
+//      struct Foo {
+//        ObjectMemoryResource mr;
+//        std::pmr::vector<int> vec{&mr};
+//      };
+//      auto foo = std::make_unique<Foo>();
+//      auto& mr = foo->mr;
+//      objcache->insertOrReplace(key, std::move(foo), mr);
+class ObjectMemoryResource : public std::pmr::memory_resource {
+ public:
+  using ChangeCb = std::function<void(int64_t)>;
+
+  explicit ObjectMemoryResource(
+      std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+      : upstream_(upstream) {}
+
+  ObjectMemoryResource(const ObjectMemoryResource&) = delete;
+  ObjectMemoryResource& operator=(const ObjectMemoryResource&) = delete;
+
+  // @return bytes currently allocated through the resource.
+  size_t getUsedBytes() const noexcept {
+    return usedBytes_.load(std::memory_order_relaxed);
+  }
+
+  // Report the bytes used so far and every change after that to the
+  // callback. Must not be called concurrently with allocations.
+  void bind(ChangeCb cb) {
+    onChange_ = std::move(cb);
+    onChange_(static_cast<int64_t>(getUsedBytes()));
+  }
+
+  // Take back the bytes reported to the callback and stop reporting.
+  void unbind() {
+    if (onChange_) {
+      onChange_(-static_cast<int64_t>(getUsedBytes()));
+      onChange_ = nullptr;
+    }
+  }
+
+ private:
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    auto* p = upstream_->allocate(bytes, alignment);
+    usedBytes_.fetch_add(bytes, std::memory_order_relaxed);
+    if (onChange_) {
+      onChange_(static_cast<int64_t>(bytes));
+    }
+    return p;
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    upstream_->deallocate(p, bytes, alignment);
+    usedBytes_.fetch_sub(bytes, std::memory_order_relaxed);
+    if (onChange_) {
+      onChange_(-static_cast<int64_t>(bytes));
+    }
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* const upstream_;
+  std::atomic<size_t> usedBytes_{0};
+  ChangeCb onChange_;
+};
+} // namespace objcache2
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+#include <vector>
+
+#include "cachelib/experimental/objcache2/util/ObjectMemoryResource.h"
+
+namespace facebook {
+namespace cachelib {
+namespace objcache2 {
+namespace test {
+TEST(ObjectMemoryResourceTest, Basic) {
+  ObjectMemoryResource mr;
+  EXPECT_EQ(0, mr.getUsedBytes());
+  {
+    std::pmr::vector<uint64_t> vec{&mr};
+    vec.reserve(100);
+    EXPECT_EQ(100 * sizeof(uint64_t), mr.getUsedBytes());
+    vec.shrink_to_fit();
+    EXPECT_EQ(0, mr.getUsedBytes());
+    vec.reserve(10);
+    EXPECT_EQ(10 * sizeof(uint64_t), mr.getUsedBytes());
+  }
+  EXPECT_EQ(0, mr.getUsedBytes());
+}
+
+TEST(ObjectMemoryResourceTest, Bind) {
+  int64_t total = 0;
+  ObjectMemoryResource mr;
+  std::pmr::vector<uint64_t> vec{&mr};
+  vec.reserve(10);
+
+  // the bytes used so far are reported when binding
+  mr.bind([&](int64_t delta) { total += delta; });
+  EXPECT_EQ(10 * sizeof(uint64_t), total);
+
+  // and every change after that
+  vec.reserve(100);
+  EXPECT_EQ(100 * sizeof(uint64_t), total);
+  EXPECT_EQ(mr.getUsedBytes(), total);
+
+  // unbinding takes the reported bytes back and stops reporting
+  mr.unbind();
+  EXPECT_EQ(0, total);
+  vec.reserve(1000);
+  EXPECT_EQ(0, total);
+  EXPECT_EQ(1000 * sizeof(uint64_t), mr.getUsedBytes());
+}
+
+TEST(ObjectMemoryResourceTest, Upstream) {
+  std::pmr::monotonic_buffer_resource upstream;
+  ObjectMemoryResource mr{&upstream};
+  std::pmr::vector<uint32_t> vec{&mr};
+  vec.reserve(16);
+  EXPECT_EQ(16 * sizeof(uint32_t), mr.getUsedBytes());
+  EXPECT_TRUE(mr.is_equal(mr));
+  EXPECT_FALSE(mr.is_equal(upstream));
+}
+} // namespace test
+} // namespace objcache2
+} // namespace cachelib
+} // namespace facebook
@@ -23,6 +23,7 @@
 #include <functional>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 #include "cachelib/navy/common/Buffer.h"
 #include "cachelib/navy/common/Hash.h"
@@ -76,6 +77,18 @@ class AbstractCache {
                              BufferView value,
                              InsertCallback cb) = 0;
 
+  // Asynchronously inserts a batch of entries as a single job so that they
+  // are appended to the device together. Invokes @cbs[i] on a worker thread
+  // when @keys[i] is inserted, or with Rejected if the entry is not
+  // accepted. The job is not ordered with other operations on the same keys.
+  //
+  // @keys and @values must be valid until the callback of the entry is
+  // invoked, no copy is made.
+  virtual void insertBatchAsync(
+      const std::vector<HashedKey>& keys,
+      const std::vector<BufferView>& values,
+      std::vector<InsertCallback> cbs) = 0;
+
   // Looks up value. Returns non-null buffer if found.
   // Returns: Ok, NotFound, DeviceError
   virtual Status lookup(HashedKey key, Buffer& value) = 0;
@@ -87,6 +100,14 @@ class AbstractCache {
   // is user responsibility to make a copy if needed (capture in callback).
   virtual void lookupAsync(HashedKey key, LookupCallback cb) = 0;
 
+  // Asynchronously looks up a batch of keys as a single job so that their
+  // index entries are resolved together and reads to nearby locations are
+  // shared. Invokes @cbs[i] with the result for @keys[i] on a worker thread.
+  //
+  // See @lookupAsync about @key lifetime.
+  virtual void lookupBatchAsync(std::vector<HashedKey> keys,
+                                std::vector<LookupCallback> cbs) = 0;
+
   // Removes from the index, space reused after reclamation.
   // Returns: Ok, NotFound
   virtual Status remove(HashedKey key) = 0;
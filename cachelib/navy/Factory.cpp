@@ -17,6 +17,7 @@
 #include "cachelib/navy/Factory.h"
 
 #include <folly/Format.h>
+#include <folly/Optional.h>
 #include <folly/Random.h>
 
 #include <stdexcept>
@@ -28,6 +29,7 @@
 #include "cachelib/navy/block_cache/FifoPolicy.h"
 #include "cachelib/navy/block_cache/LruPolicy.h"
 #include "cachelib/navy/driver/Driver.h"
+#include "cachelib/navy/engine/AdaptiveSizeSplit.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 
 /* O_DIRECT not available on Mac OS */
@@ -113,6 +115,13 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
     config_.preciseRemove = preciseRemove;
   }
 
+  void setReadMerging(std::chrono::microseconds mergeWindow,
+                      uint32_t readaheadSize) override {
+    config_.readMerging = true;
+    config_.readMergerConfig.mergeWindow = mergeWindow;
+    config_.readMergerConfig.readaheadSize = readaheadSize;
+  }
+
   std::unique_ptr<Engine> create(JobScheduler& scheduler,
                                  ExpiredCheck checkExpired,
                                  DestructorCallback cb) && {
@@ -183,6 +192,7 @@ class EnginePairProtoImpl final : public EnginePairProto {
     bigHashProto_ = std::move(proto.bigHashProto_);
     blockCacheProto_ = std::move(proto.blockCacheProto_);
     smallItemMaxSize_ = proto.smallItemMaxSize_;
+    sizeSplitConfig_ = proto.sizeSplitConfig_;
   }
 
   void setBigHash(std::unique_ptr<BigHashProto> proto,
@@ -195,6 +205,16 @@ class EnginePairProtoImpl final : public EnginePairProto {
     blockCacheProto_ = std::move(proto);
   }
 
+  void setAdaptiveSizeSplit(uint32_t minSmallItemMaxSize,
+                            uint32_t maxSmallItemMaxSize,
+                            uint64_t windowSize) override {
+    AdaptiveSizeSplit::Config config;
+    config.minSmallItemMaxSize = minSmallItemMaxSize;
+    config.maxSmallItemMaxSize = maxSmallItemMaxSize;
+    config.windowSize = windowSize;
+    sizeSplitConfig_ = config;
+  }
+
   EnginePair create(Device* device,
                     ExpiredCheck checkExpired,
                     DestructorCallback destructorCb,
@@ -219,14 +239,21 @@ class EnginePairProtoImpl final : public EnginePairProto {
       }
     }
 
+    std::unique_ptr<AdaptiveSizeSplit> sizeSplit;
+    if (sizeSplitConfig_) {
+      sizeSplit = std::make_unique<AdaptiveSizeSplit>(*sizeSplitConfig_,
+                                                      smallItemMaxSize_);
+    }
+
     return EnginePair{std::move(bh), std::move(bc), smallItemMaxSize_,
-                      &scheduler};
+                      &scheduler, std::move(sizeSplit)};
   }
 
  private:
   std::unique_ptr<BigHashProto> bigHashProto_;
   std::unique_ptr<BlockCacheProto> blockCacheProto_;
   uint32_t smallItemMaxSize_;
+  folly::Optional<AdaptiveSizeSplit::Config> sizeSplitConfig_;
 };
 
 class CacheProtoImpl final : public CacheProto {
@@ -248,6 +275,17 @@ class CacheProtoImpl final : public CacheProto {
 
   void setMetadataSize(size_t size) override { config_.metadataSize = size; }
 
+  void setCheckpoints(uint64_t logSize,
+                      std::chrono::seconds interval) override {
+    config_.checkpointLogSize = logSize;
+    config_.checkpointInterval = interval;
+  }
+
+  void setNegativeFilter(uint64_t size, uint32_t numHashes) override {
+    config_.negativeFilterSize = size;
+    config_.negativeFilterNumHashes = numHashes;
+  }
+
   void setExpiredCheck(ExpiredCheck checkExpired) override {
     checkExpired_ = std::move(checkExpired);
   }
@@ -82,6 +82,13 @@ class BlockCacheProto {
 
   // (Optional) Set if the preciseRemove flag.
   virtual void setPreciseRemove(bool preciseRemove) = 0;
+
+  // (Optional) Share device reads among concurrent reads of adjacent or
+  // overlapping entries. A read waits up to @mergeWindow for reads to merge
+  // with, and reads smaller than @readaheadSize are extended to it within
+  // the region. See ReadMerger.
+  virtual void setReadMerging(std::chrono::microseconds mergeWindow,
+                              uint32_t readaheadSize) = 0;
 };
 
 // BigHash engine proto. BigHash is used to cache small objects (under 2KB)
@@ -118,6 +125,14 @@ class EnginePairProto {
   // Set up big hash engine.
   virtual void setBigHash(std::unique_ptr<BigHashProto> proto,
                           uint32_t smallItemMaxSize) = 0;
+
+  // Learn the max item size of the big hash engine from the workload. It
+  // starts at the smallItemMaxSize of setBigHash, stays within
+  // [minSmallItemMaxSize, maxSmallItemMaxSize] and is recomputed every
+  // @windowSize inserts.
+  virtual void setAdaptiveSizeSplit(uint32_t minSmallItemMaxSize,
+                                    uint32_t maxSmallItemMaxSize,
+                                    uint64_t windowSize) = 0;
 };
 
 // Cache object prototype. Setup cache desired parameters and pass proto to
@@ -139,6 +154,16 @@ class CacheProto {
   // Sets metadata size.
   virtual void setMetadataSize(size_t metadataSize) = 0;
 
+  // (Optional) Checkpoint the engines state into the metadata every
+  // @interval, and log the changes made after a checkpoint into the last
+  // @logSize bytes of the metadata.
+  virtual void setCheckpoints(uint64_t logSize,
+                              std::chrono::seconds interval) = 0;
+
+  // (Optional) Answer lookups of keys that are in no engine from a
+  // negative filter of @size bytes that sets @numHashes counters per key.
+  virtual void setNegativeFilter(uint64_t size, uint32_t numHashes) = 0;
+
   // Set JobScheduler for async function calls.
   virtual void setJobScheduler(std::unique_ptr<JobScheduler> ex) = 0;
 
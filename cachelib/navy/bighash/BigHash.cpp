@@ -262,6 +262,9 @@ bool BigHash::recover(RecordReader& rr) {
       bloomFilter_->recover<ProtoSerializer>(rr);
       XLOG(INFO, "Recovered bloom filter");
     }
+    if (negativeFilter_) {
+      addKeysToNegativeFilter();
+    }
   } catch (const std::exception& e) {
     XLOGF(ERR, "Exception: {}", e.what());
     XLOG(ERR, "Failed to recover bighash. Resetting cache.");
@@ -273,6 +276,17 @@ bool BigHash::recover(RecordReader& rr) {
   return true;
 }
 
+bool BigHash::replayCheckpointLog(
+    const std::vector<CheckpointLog::Record>& /* records */) {
+  if (bloomFilter_) {
+    for (uint32_t i = 0; i < bloomFilter_->numFilters(); i++) {
+      bloomFilter_->clear(i);
+    }
+    XLOG(INFO, "Cleared bloom filter after checkpoint recovery");
+  }
+  return true;
+}
+
 Status BigHash::insert(HashedKey hk, BufferView value) {
   const auto bid = getBucketId(hk);
   insertCount_.inc();
@@ -287,11 +301,15 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
   // we copy the items and trigger the destructorCb after bucket lock is
   // released to avoid possible heavy operations or locks in the destrcutor.
   std::vector<std::tuple<Buffer, Buffer, DestructorEvent>> removedItems;
-  DestructorCallback cb =
-      [&removedItems](HashedKey key, BufferView val, DestructorEvent event) {
-        // must make a copy for the key, o/w data might be deleted
-        removedItems.emplace_back(Buffer{makeView(key.key())}, val, event);
-      };
+  std::vector<uint64_t> removedKeyHashes;
+  DestructorCallback cb = [&removedItems, &removedKeyHashes](
+                              HashedKey key,
+                              BufferView val,
+                              DestructorEvent event) {
+    // must make a copy for the key, o/w data might be deleted
+    removedItems.emplace_back(Buffer{makeView(key.key())}, val, event);
+    removedKeyHashes.push_back(key.keyHash());
+  };
 
   {
     std::unique_lock<folly::SharedMutex> lock{getMutex(bid)};
@@ -318,6 +336,10 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
         bfRebuild(bid, bucket);
       }
     }
+    // Added before the write makes the key visible
+    if (negativeFilter_) {
+      negativeFilter_->add(hk.keyHash());
+    }
 
     const auto res = writeBucket(bid, std::move(buffer));
     if (!res) {
@@ -329,6 +351,11 @@ Status BigHash::insert(HashedKey hk, BufferView value) {
     }
   }
 
+  if (negativeFilter_) {
+    for (auto keyHash : removedKeyHashes) {
+      negativeFilter_->remove(keyHash);
+    }
+  }
   for (const auto& item : removedItems) {
     destructorCb_(makeHK(std::get<0>(item)) /* key */,
                   std::get<1>(item).view() /* value */,
@@ -406,6 +433,14 @@ Status BigHash::lookup(HashedKey hk, Buffer& value) {
 }
 
 Status BigHash::remove(HashedKey hk) {
+  return removeImpl(hk, true /* callDestructor */);
+}
+
+Status BigHash::removeMoved(HashedKey hk) {
+  return removeImpl(hk, false /* callDestructor */);
+}
+
+Status BigHash::removeImpl(HashedKey hk, bool callDestructor) {
   const auto bid = getBucketId(hk);
   removeCount_.inc();
 
@@ -456,7 +491,10 @@ Status BigHash::remove(HashedKey hk) {
     }
   }
 
-  if (!valueCopy.isNull()) {
+  if (negativeFilter_) {
+    negativeFilter_->remove(hk.keyHash());
+  }
+  if (callDestructor && !valueCopy.isNull()) {
     destructorCb_(hk, valueCopy.view(), DestructorEvent::Removed);
   }
 
@@ -494,6 +532,26 @@ void BigHash::bfRebuild(BucketId bid, const Bucket* bucket) {
   }
 }
 
+void BigHash::addKeysToNegativeFilter() {
+  // BigHash keeps no keys in memory. Read them from every bucket.
+  for (uint32_t i = 0; i < numBuckets_; i++) {
+    BucketId bid{i};
+    std::shared_lock<folly::SharedMutex> lock{getMutex(bid)};
+    auto buffer = readBucket(bid);
+    if (buffer.isNull()) {
+      ioErrorCount_.inc();
+      throw std::runtime_error{
+          folly::sformat("failed to read bucket {} for negative filter", i)};
+    }
+    const auto* bucket = reinterpret_cast<const Bucket*>(buffer.data());
+    for (auto itr = bucket->getFirst(); !itr.done();
+         itr = bucket->getNext(itr)) {
+      negativeFilter_->add(itr.keyHash());
+    }
+  }
+  XLOGF(INFO, "Added keys of {} buckets to the negative filter", numBuckets_);
+}
+
 void BigHash::flush() {
   XLOG(INFO, "Flush big hash");
   device_.flush();
@@ -111,6 +111,10 @@ class BigHash final : public Engine {
   // and DeviceError on error.
   Status remove(HashedKey hk) override;
 
+  // Removes an entry that was copied to the other engine, without calling
+  // the destructor callback.
+  Status removeMoved(HashedKey hk) override;
+
   // flush the device file
   void flush() override;
 
@@ -125,12 +129,29 @@ class BigHash final : public Engine {
   // @return true if recovery succeed, false o/w.
   bool recover(RecordReader& rr) override;
 
+  // buckets are written in place, so only the bloom filter can be behind the
+  // device after a checkpoint. It is cleared and rebuilt as buckets are
+  // written again.
+  bool replayCheckpointLog(
+      const std::vector<CheckpointLog::Record>& records) override;
+
+  // Keeps @filter up to date with the keys written to buckets. Recovery reads
+  // every bucket to add the recovered keys.
+  void setNegativeFilter(NegativeFilter* filter) override {
+    negativeFilter_ = filter;
+  }
+
   // returns BigHash stats to the visitor
   void getCounters(const CounterVisitor& visitor) const override;
 
   // return the maximum allowed item size
   uint64_t getMaxItemSize() const override;
 
+  // return the number of bytes written to the device for bucket updates
+  uint64_t getPhysicalWrittenBytes() const override {
+    return physicalWrittenCount_.get();
+  }
+
   // return how manu times a lookup is rejected by the bloom filter
   uint64_t bfRejectCount() const { return bfRejectCount_.get(); }
 
@@ -162,6 +183,10 @@ class BigHash final : public Engine {
   Buffer readBucket(BucketId bid);
   bool writeBucket(BucketId bid, Buffer buffer);
 
+  // Removes an entry, calling the destructor callback for it if
+  // @callDestructor is set.
+  Status removeImpl(HashedKey hk, bool callDestructor);
+
   // The corresponding r/w bucket lock must be held during the entire
   // duration of the read and write operations. For example, during write,
   // if write lock is dropped after a bucket is read from device, user
@@ -184,6 +209,10 @@ class BigHash final : public Engine {
 
   double bfFalsePositivePct() const;
   void bfRebuild(BucketId bid, const Bucket* bucket);
+
+  // Adds the keys in all the buckets to negativeFilter_. Throws if a bucket
+  // cannot be read.
+  void addKeysToNegativeFilter();
   bool bfReject(BucketId bid, uint64_t keyHash) const;
 
   // Use birthday paradox to estimate number of mutexes given number of parallel
@@ -199,6 +228,7 @@ class BigHash final : public Engine {
   const uint64_t cacheBaseOffset_{};
   const uint64_t numBuckets_{};
   std::unique_ptr<BloomFilter> bloomFilter_;
+  NegativeFilter* negativeFilter_{nullptr};
   std::chrono::nanoseconds generationTime_{};
   Device& device_;
   std::unique_ptr<folly::SharedMutex[]> mutex_{
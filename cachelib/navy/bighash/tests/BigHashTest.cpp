@@ -444,6 +444,39 @@ TEST(BigHash, Recovery) {
   EXPECT_EQ(makeView("12345"), value.view());
 }
 
+TEST(BigHash, NegativeFilter) {
+  BigHash::Config config;
+  setLayout(config, 64, 1);
+  auto device = createMemoryDevice(config.cacheSize, nullptr /* encryption */);
+  config.device = device.get();
+
+  NegativeFilter filter{4096, 4};
+  BigHash bh(std::move(config));
+  bh.setNegativeFilter(&filter);
+
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key1"), makeView("12345")));
+  EXPECT_TRUE(filter.couldExist(makeHK("key1").keyHash()));
+  EXPECT_EQ(Status::Ok, bh.remove(makeHK("key1")));
+  EXPECT_FALSE(filter.couldExist(makeHK("key1").keyHash()));
+
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key1"), makeView("12345")));
+  // Evicts key1
+  EXPECT_EQ(Status::Ok, bh.insert(makeHK("key2"), makeView("123456789")));
+  EXPECT_FALSE(filter.couldExist(makeHK("key1").keyHash()));
+  EXPECT_TRUE(filter.couldExist(makeHK("key2").keyHash()));
+
+  folly::IOBufQueue queue;
+  auto rw = createMemoryRecordWriter(queue);
+  bh.persist(*rw);
+
+  // Recovery reads the keys from the buckets
+  filter.reset();
+  auto rr = createMemoryRecordReader(queue);
+  ASSERT_TRUE(bh.recover(*rr));
+  EXPECT_FALSE(filter.couldExist(makeHK("key1").keyHash()));
+  EXPECT_TRUE(filter.couldExist(makeHK("key2").keyHash()));
+}
+
 TEST(BigHash, RecoveryBadConfig) {
   folly::IOBufQueue queue;
   {
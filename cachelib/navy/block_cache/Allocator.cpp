@@ -47,14 +47,14 @@ Allocator::Allocator(RegionManager& regionManager, uint16_t numPriorities)
 }
 
 std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocate(
-    uint32_t size, uint16_t priority) {
+    uint32_t size, uint16_t priority, uint32_t numItems) {
   XDCHECK_LT(priority, allocators_.size());
   RegionAllocator* ra = &allocators_[priority];
   if (size == 0 || size > regionManager_.regionSize()) {
     return std::make_tuple(RegionDescriptor{OpenStatus::Error}, size,
                            RelAddress());
   }
-  return allocateWith(*ra, size);
+  return allocateWith(*ra, size, numItems);
 } // namespace cachelib
 
 // Allocates using region allocator @ra. If region is full, we take another
@@ -64,12 +64,12 @@ std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocate(
 // new reclamation job to refill it. Caller must close the region after data
 // written to the slot.
 std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocateWith(
-    RegionAllocator& ra, uint32_t size) {
+    RegionAllocator& ra, uint32_t size, uint32_t numItems) {
   LockGuard l{ra.getLock()};
   RegionId rid = ra.getAllocationRegion();
   if (rid.valid()) {
     auto& region = regionManager_.getRegion(rid);
-    auto [desc, addr] = region.openAndAllocate(size);
+    auto [desc, addr] = region.openAndAllocate(size, numItems);
     XDCHECK_NE(OpenStatus::Retry, desc.status());
     if (desc.isReady()) {
       return std::make_tuple(std::move(desc), size, addr);
@@ -96,7 +96,7 @@ std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocateWith(
 
   // Replace with a reclaimed region and allocate
   ra.setAllocationRegion(rid);
-  auto [desc, addr] = region.openAndAllocate(size);
+  auto [desc, addr] = region.openAndAllocate(size, numItems);
   XDCHECK_EQ(OpenStatus::Ready, desc.status());
   return std::make_tuple(std::move(desc), size, addr);
 }
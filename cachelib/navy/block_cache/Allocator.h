@@ -96,8 +96,10 @@ class Allocator {
   // When allocating with a priority, the priority must NOT exceed the
   // max priority which is (@numPriorities - 1) specified when constructing
   // this allocator.
+  // @numItems is the number of entries the caller writes back to back into
+  // the slot, so that a batch of entries is appended with one allocation.
   std::tuple<RegionDescriptor, uint32_t, RelAddress> allocate(
-      uint32_t size, uint16_t priority);
+      uint32_t size, uint16_t priority, uint32_t numItems = 1);
 
   // Closes the region.
   void close(RegionDescriptor&& rid);
@@ -123,7 +125,7 @@ class Allocator {
   // Allocates @size bytes in region allocator @ra. If succeed (enough space),
   // returns region descriptor, size and address.
   std::tuple<RegionDescriptor, uint32_t, RelAddress> allocateWith(
-      RegionAllocator& ra, uint32_t size);
+      RegionAllocator& ra, uint32_t size, uint32_t numItems);
 
   RegionManager& regionManager_;
   // Multiple allocators when we use priority-based allocation
@@ -17,10 +17,13 @@
 #include "cachelib/navy/block_cache/BlockCache.h"
 
 #include <folly/ScopeGuard.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
 #include <folly/logging/xlog.h>
 
 #include <algorithm>
 #include <cstring>
+#include <limits>
 #include <numeric>
 #include <utility>
 
@@ -37,6 +40,9 @@ constexpr uint32_t BlockCache::kMaxItemSize;
 constexpr uint32_t BlockCache::kFormatVersion;
 constexpr uint32_t BlockCache::kDefReadBufferSize;
 constexpr uint16_t BlockCache::kDefaultItemPriority;
+constexpr uint32_t BlockCache::kMaxBatchReadGap;
+constexpr uint32_t BlockCache::kMaxBatchReadSize;
+constexpr uint32_t BlockCache::kBatchAppendsPerRegion;
 
 BlockCache::Config& BlockCache::Config::validate() {
   XDCHECK_NE(scheduler, nullptr);
@@ -67,6 +73,9 @@ BlockCache::Config& BlockCache::Config::validate() {
   if (numPriorities == 0) {
     throw std::invalid_argument("allocator must have at least one priority");
   }
+  if (readMerging) {
+    readMergerConfig.validate();
+  }
 
   reinsertionConfig.validate();
 
@@ -142,6 +151,9 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
       allocator_{regionManager_, config.numPriorities},
       reinsertionPolicy_{makeReinsertionPolicy(config.reinsertionConfig)} {
   validate(config);
+  if (config.readMerging) {
+    regionManager_.enableReadMerging(config.readMergerConfig);
+  }
   XLOG(INFO, "Block cache created");
   XDCHECK_NE(readBufferSize_, 0u);
 }
@@ -189,30 +201,98 @@ Status BlockCache::insert(HashedKey hk, BufferView value) {
   // After allocation a region is opened for writing. Until we close it, the
   // region would not be reclaimed and index never gets an invalid entry.
   const auto status = writeEntry(addr, slotSize, hk, value);
-  auto newObjSizeHint = encodeSizeHint(slotSize);
   if (status == Status::Ok) {
-    const auto lr = index_.insert(
-        hk.keyHash(), encodeRelAddress(addr.add(slotSize)), newObjSizeHint);
-    // We replaced an existing key in the index
-    uint64_t newObjSize = decodeSizeHint(newObjSizeHint);
-    uint64_t oldObjSize = 0;
-    if (lr.found()) {
-      oldObjSize = decodeSizeHint(lr.sizeHint());
-      holeSizeTotal_.add(oldObjSize);
-      holeCount_.inc();
-      insertHashCollisionCount_.inc();
-    }
-    succInsertCount_.inc();
-    if (newObjSize < oldObjSize) {
-      usedSizeBytes_.sub(oldObjSize - newObjSize);
-    } else {
-      usedSizeBytes_.add(newObjSize - oldObjSize);
-    }
+    addToIndex(hk, addr.add(slotSize), slotSize);
   }
   allocator_.close(std::move(desc));
   return status;
 }
 
+void BlockCache::insertBatch(const std::vector<HashedKey>& keys,
+                             const std::vector<BufferView>& values,
+                             std::vector<Status>& statuses) {
+  XDCHECK_EQ(keys.size(), values.size());
+  statuses.assign(keys.size(), Status::Ok);
+  const uint32_t maxGroupSize =
+      std::max<uint32_t>(regionSize_ / kBatchAppendsPerRegion, allocAlignSize_);
+
+  for (size_t first = 0; first < keys.size();) {
+    uint32_t groupSize = 0;
+    size_t last = first;
+    while (last < keys.size()) {
+      const auto size =
+          serializedSize(keys[last].key().size(), values[last].size());
+      if (last > first && groupSize + size > maxGroupSize) {
+        break;
+      }
+      groupSize += size;
+      last++;
+    }
+
+    // a large entry takes a group of its own and goes through the regular
+    // insert, which also rejects entries too large for the cache.
+    if (last - first == 1) {
+      statuses[first] = insert(keys[first], values[first]);
+      first = last;
+      continue;
+    }
+
+    auto [desc, slotSize, addr] = allocator_.allocate(
+        groupSize, kDefaultItemPriority, static_cast<uint32_t>(last - first));
+    if (desc.status() != OpenStatus::Ready) {
+      const bool retry = desc.status() == OpenStatus::Retry;
+      for (size_t i = first; i < last; i++) {
+        if (!retry) {
+          allocErrorCount_.inc();
+          insertCount_.inc();
+        }
+        statuses[i] = retry ? Status::Retry : Status::Rejected;
+      }
+      first = last;
+      continue;
+    }
+    XDCHECK_EQ(groupSize, slotSize);
+
+    batchInsertCount_.inc();
+    batchInsertedItemCount_.add(last - first);
+    for (size_t i = first; i < last; i++) {
+      insertCount_.inc();
+      const auto size = serializedSize(keys[i].key().size(), values[i].size());
+      statuses[i] = writeEntry(addr, size, keys[i], values[i]);
+      if (statuses[i] == Status::Ok) {
+        addToIndex(keys[i], addr.add(size), size);
+      }
+      addr = addr.add(size);
+    }
+    allocator_.close(std::move(desc));
+    first = last;
+  }
+}
+
+void BlockCache::addToIndex(HashedKey hk,
+                            RelAddress addrEnd,
+                            uint32_t slotSize) {
+  auto newObjSizeHint = encodeSizeHint(slotSize);
+  const auto lr =
+      index_.insert(hk.keyHash(), encodeRelAddress(addrEnd), newObjSizeHint);
+  // We replaced an existing key in the index
+  uint64_t newObjSize = decodeSizeHint(newObjSizeHint);
+  uint64_t oldObjSize = 0;
+  if (lr.found()) {
+    logRemove(hk.keyHash(), addrEnd.rid().index());
+    oldObjSize = decodeSizeHint(lr.sizeHint());
+    holeSizeTotal_.add(oldObjSize);
+    holeCount_.inc();
+    insertHashCollisionCount_.inc();
+  }
+  succInsertCount_.inc();
+  if (newObjSize < oldObjSize) {
+    usedSizeBytes_.sub(oldObjSize - newObjSize);
+  } else {
+    usedSizeBytes_.add(newObjSize - oldObjSize);
+  }
+}
+
 bool BlockCache::couldExist(HashedKey hk) {
   const auto lr = index_.lookup(hk.keyHash());
   if (!lr.found()) {
@@ -262,6 +342,119 @@ Status BlockCache::lookup(HashedKey hk, Buffer& value) {
   }
 }
 
+void BlockCache::lookupBatch(const std::vector<HashedKey>& keys,
+                             std::vector<Buffer>& values,
+                             std::vector<Status>& statuses) {
+  values.clear();
+  values.resize(keys.size());
+  statuses.assign(keys.size(), Status::NotFound);
+  batchLookupCount_.inc();
+
+  // an entry found in the index and the range of the region read for it,
+  // which ends at the end of the entry.
+  struct Entry {
+    size_t idx;
+    RelAddress addrEnd;
+    uint32_t size;
+
+    uint32_t begin() const { return addrEnd.offset() - size; }
+  };
+
+  const auto seqNumber = regionManager_.getSeqNumber();
+  std::vector<Entry> entries;
+  entries.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    const auto lr = index_.lookup(keys[i].keyHash());
+    if (!lr.found()) {
+      lookupCount_.inc();
+      continue;
+    }
+    // See lookup() about the relative address of the entry end.
+    const auto addrEnd = decodeRelAddress(lr.address());
+    const auto size =
+        std::min(decodeSizeHint(lr.sizeHint()), addrEnd.offset());
+    entries.push_back(Entry{i, addrEnd, size});
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return std::make_pair(a.addrEnd.rid().index(), a.begin()) <
+                     std::make_pair(b.addrEnd.rid().index(), b.begin());
+            });
+
+  for (size_t first = 0; first < entries.size();) {
+    const auto rid = entries[first].addrEnd.rid();
+    size_t last = first + 1;
+    while (last < entries.size() && entries[last].addrEnd.rid() == rid) {
+      last++;
+    }
+
+    // Same as in lookup(), a reclamation that starts after @seqNumber was
+    // taken makes the open fail and the entries are retried.
+    RegionDescriptor desc = regionManager_.openForRead(rid, seqNumber);
+    if (desc.status() != OpenStatus::Ready) {
+      XDCHECK(desc.status() == OpenStatus::Retry);
+      for (size_t i = first; i < last; i++) {
+        statuses[entries[i].idx] = Status::Retry;
+      }
+      first = last;
+      continue;
+    }
+
+    for (size_t runFirst = first; runFirst < last;) {
+      // entries of the region close enough to the previous ones share a read.
+      // Regions still in memory are not read from the device at all.
+      const auto runBegin = entries[runFirst].begin();
+      auto runEnd = entries[runFirst].addrEnd.offset();
+      size_t runLast = runFirst + 1;
+      while (desc.isPhysReadMode() && runLast < last) {
+        const auto& entry = entries[runLast];
+        const auto end = std::max(runEnd, entry.addrEnd.offset());
+        if (entry.begin() > runEnd + kMaxBatchReadGap ||
+            end - runBegin > kMaxBatchReadSize) {
+          break;
+        }
+        runEnd = end;
+        runLast++;
+      }
+
+      if (runLast - runFirst == 1) {
+        const auto& entry = entries[runFirst];
+        statuses[entry.idx] = readEntry(desc, entry.addrEnd, entry.size,
+                                        keys[entry.idx], values[entry.idx]);
+        runFirst = runLast;
+        continue;
+      }
+
+      batchReadCount_.inc();
+      batchMergedReadCount_.add(runLast - runFirst);
+      auto buffer = regionManager_.read(desc, RelAddress{rid, runBegin},
+                                        runEnd - runBegin);
+      for (size_t i = runFirst; i < runLast; i++) {
+        const auto& entry = entries[i];
+        if (buffer.isNull()) {
+          statuses[entry.idx] = Status::DeviceError;
+          continue;
+        }
+        statuses[entry.idx] = parseEntry(
+            desc, entry.addrEnd,
+            Buffer{buffer.view().slice(entry.begin() - runBegin, entry.size)},
+            keys[entry.idx], values[entry.idx]);
+      }
+      runFirst = runLast;
+    }
+
+    for (size_t i = first; i < last; i++) {
+      if (statuses[entries[i].idx] == Status::Ok) {
+        regionManager_.touch(rid);
+        succLookupCount_.inc();
+      }
+      lookupCount_.inc();
+    }
+    regionManager_.close(std::move(desc));
+    first = last;
+  }
+}
+
 std::pair<Status, std::string> BlockCache::getRandomAlloc(Buffer& value) {
   // Get rendom region and offset within the region
   auto rid = regionManager_.getRandomRegion();
@@ -339,10 +532,19 @@ std::pair<Status, std::string> BlockCache::getRandomAlloc(Buffer& value) {
 }
 
 Status BlockCache::remove(HashedKey hk) {
+  return removeImpl(hk, true /* callDestructor */);
+}
+
+Status BlockCache::removeMoved(HashedKey hk) {
+  return removeImpl(hk, false /* callDestructor */);
+}
+
+Status BlockCache::removeImpl(HashedKey hk, bool callDestructor) {
   removeCount_.inc();
 
   Buffer value;
-  if ((itemDestructorEnabled_ && destructorCb_) || preciseRemove_) {
+  if ((callDestructor && itemDestructorEnabled_ && destructorCb_) ||
+      preciseRemove_) {
     Status status = lookup(hk, value);
 
     if (status != Status::Ok) {
@@ -366,12 +568,13 @@ Status BlockCache::remove(HashedKey hk) {
 
   auto lr = index_.remove(hk.keyHash());
   if (lr.found()) {
+    logRemove(hk.keyHash(), CheckpointLog::kNoRegion);
     uint64_t removedObjectSize = decodeSizeHint(lr.sizeHint());
     holeSizeTotal_.add(removedObjectSize);
     holeCount_.inc();
     usedSizeBytes_.sub(removedObjectSize);
     succRemoveCount_.inc();
-    if (!value.isNull() && destructorCb_) {
+    if (callDestructor && !value.isNull() && destructorCb_) {
       destructorCb_(hk, value.view(), DestructorEvent::Removed);
     }
     return Status::Ok;
@@ -631,7 +834,14 @@ Status BlockCache::readEntry(const RegionDescriptor& readDesc,
   if (buffer.isNull()) {
     return Status::DeviceError;
   }
+  return parseEntry(readDesc, addr, std::move(buffer), expected, value);
+}
 
+Status BlockCache::parseEntry(const RegionDescriptor& readDesc,
+                              RelAddress addr,
+                              Buffer buffer,
+                              HashedKey expected,
+                              Buffer& value) {
   auto entryEnd = buffer.data() + buffer.size();
   auto desc = *reinterpret_cast<EntryDesc*>(entryEnd - sizeof(EntryDesc));
   if (desc.csSelf != desc.computeChecksum()) {
@@ -708,6 +918,16 @@ void BlockCache::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_bc_lookups", lookupCount_.get(),
           CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_batch_inserts", batchInsertCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_batch_inserted_items", batchInsertedItemCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_batch_lookups", batchLookupCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_batch_reads", batchReadCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_batch_merged_reads", batchMergedReadCount_.get(),
+          CounterVisitor::CounterType::RATE);
   visitor("navy_bc_lookup_false_positives", lookupFalsePositiveCount_.get(),
           CounterVisitor::CounterType::RATE);
   visitor("navy_bc_lookup_entry_header_checksum_errors",
@@ -809,6 +1029,188 @@ void BlockCache::tryRecover(RecordReader& rr) {
   index_.recover(rr);
 }
 
+void BlockCache::logRemove(uint64_t keyHash, uint32_t regionId) {
+  if (!checkpointLog_) {
+    return;
+  }
+  CheckpointLog::Record record;
+  record.type = CheckpointLog::RecordType::kRemove;
+  record.logId = checkpointLogId_;
+  record.regionId = regionId;
+  record.keyHash = keyHash;
+  // The record must be on the device before the remove or replace completes.
+  // Otherwise the old entry would come back after an unclean shutdown.
+  checkpointLog_->syncUpTo(checkpointLog_->append(record));
+}
+
+void BlockCache::setCheckpointLog(CheckpointLog* log, uint8_t logId) {
+  checkpointLog_ = log;
+  checkpointLogId_ = logId;
+  regionManager_.setCheckpointLog(log, logId);
+}
+
+bool BlockCache::replayCheckpointLog(
+    const std::vector<CheckpointLog::Record>& records) {
+  XLOG(INFO, "Starting block cache checkpoint log replay");
+  constexpr size_t kNoPosition = std::numeric_limits<size_t>::max();
+  // Positions are indices of records in the log. Regions opened before the
+  // checkpoint are taken as opened at its start.
+  struct RegionLog {
+    size_t openPos{0};
+    size_t sealPos{kNoPosition};
+    serialization::Region region;
+  };
+  struct KeyLog {
+    size_t removePos{kNoPosition};
+    size_t movePos{kNoPosition};
+    uint32_t moveRegion{CheckpointLog::kNoRegion};
+  };
+  const auto numRegions = regionManager_.getSize() / regionSize_;
+  folly::F14FastMap<uint32_t, RegionLog> regions;
+  folly::F14FastMap<uint64_t, KeyLog> keys;
+  for (size_t pos = 0; pos < records.size(); pos++) {
+    const auto& record = records[pos];
+    if (record.logId != checkpointLogId_) {
+      continue;
+    }
+    if (record.type != CheckpointLog::RecordType::kRemove &&
+        record.regionId >= numRegions) {
+      XLOGF(ERR, "Invalid region {} in checkpoint log", record.regionId);
+      return false;
+    }
+    switch (record.type) {
+    case CheckpointLog::RecordType::kOpen: {
+      auto& regionLog = regions[record.regionId];
+      regionLog.openPos = pos;
+      regionLog.sealPos = kNoPosition;
+      break;
+    }
+    case CheckpointLog::RecordType::kSeal: {
+      if (record.lastEntryEndOffset > regionSize_) {
+        XLOGF(ERR, "Invalid region {} in checkpoint log", record.regionId);
+        return false;
+      }
+      auto& regionLog = regions[record.regionId];
+      regionLog.sealPos = pos;
+      *regionLog.region.regionId() = record.regionId;
+      *regionLog.region.lastEntryEndOffset() = record.lastEntryEndOffset;
+      regionLog.region.priority() = record.priority;
+      *regionLog.region.numItems() = record.numItems;
+      break;
+    }
+    case CheckpointLog::RecordType::kRemove: {
+      auto& keyLog = keys[record.keyHash];
+      if (record.regionId == CheckpointLog::kNoRegion) {
+        keyLog.removePos = pos;
+      } else {
+        keyLog.movePos = pos;
+        keyLog.moveRegion = record.regionId;
+      }
+      break;
+    }
+    default:
+      XLOGF(ERR,
+            "Unknown checkpoint log record type {}",
+            static_cast<uint32_t>(record.type));
+      return false;
+    }
+  }
+
+  // Entries of the checkpoint index that may be stale: keys changed after
+  // the checkpoint, and entries in regions that were rewritten or reclaimed.
+  for (const auto& [keyHash, keyLog] : keys) {
+    index_.remove(keyHash);
+  }
+  index_.removeIf([this, &regions](uint32_t address) {
+    const auto rid = decodeRelAddress(address).rid();
+    return regions.count(rid.index()) > 0 ||
+           regionManager_.getRegion(rid).getNumItems() == 0;
+  });
+
+  // Regions whose last record is an open lost their content.
+  std::vector<serialization::Region> regionProtos;
+  std::vector<std::pair<size_t, uint32_t>> sealed;
+  for (const auto& [index, regionLog] : regions) {
+    if (regionLog.sealPos == kNoPosition) {
+      serialization::Region empty;
+      *empty.regionId() = index;
+      regionProtos.push_back(empty);
+    } else {
+      regionProtos.push_back(regionLog.region);
+      sealed.emplace_back(regionLog.sealPos, index);
+    }
+  }
+  try {
+    regionManager_.recoverRegions(regionProtos);
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "Exception: {}", e.what());
+    return false;
+  }
+
+  // Add the entries of the sealed regions in the order they were sealed, so
+  // that a key in several regions ends up in the last one written.
+  std::sort(sealed.begin(), sealed.end());
+  uint32_t numEntries = 0;
+  for (const auto& [sealPos, index] : sealed) {
+    const RegionId rid{index};
+    const auto openPos = regions[index].openPos;
+    const auto endOffset =
+        regionManager_.getRegion(rid).getLastEntryEndOffset();
+    if (endOffset == 0) {
+      continue;
+    }
+    auto desc = RegionDescriptor::makeReadDescriptor(
+        OpenStatus::Ready, rid, true /* physReadMode */);
+    auto buffer = regionManager_.read(desc, RelAddress{rid, 0}, endOffset);
+    if (buffer.isNull()) {
+      XLOGF(ERR, "Failed to read region {} for replay", index);
+      return false;
+    }
+
+    folly::F14FastSet<uint64_t> seen;
+    auto offset = endOffset;
+    while (offset > 0) {
+      const auto* entryEnd = buffer.data() + offset;
+      auto entryDesc =
+          *reinterpret_cast<const EntryDesc*>(entryEnd - sizeof(EntryDesc));
+      const auto entrySize =
+          serializedSize(entryDesc.keySize, entryDesc.valueSize);
+      if (entryDesc.csSelf != entryDesc.computeChecksum() ||
+          entrySize > offset) {
+        XLOGF(ERR, "Region {} is corrupted. Aborting replay.", index);
+        return false;
+      }
+      // Entries are scanned from the last one written. A key removed, or
+      // moved to another region, after the region was opened may have been
+      // changed after its entry was written and is dropped.
+      const auto keyHash = entryDesc.keyHash;
+      bool live = seen.insert(keyHash).second;
+      auto it = keys.find(keyHash);
+      if (live && it != keys.end()) {
+        const auto& keyLog = it->second;
+        live = (keyLog.removePos == kNoPosition ||
+                keyLog.removePos < openPos) &&
+               (keyLog.movePos == kNoPosition || keyLog.movePos < openPos ||
+                keyLog.moveRegion == index);
+      }
+      if (live) {
+        index_.insert(keyHash,
+                      encodeRelAddress(RelAddress{rid, offset}),
+                      encodeSizeHint(entrySize));
+        numEntries++;
+      }
+      offset -= entrySize;
+    }
+  }
+  XLOGF(INFO,
+        "Finished block cache checkpoint log replay: {} records, {} regions "
+        "changed, {} entries rebuilt",
+        records.size(),
+        regions.size(),
+        numEntries);
+  return true;
+}
+
 bool BlockCache::isValidRecoveryData(
     const serialization::BlockCacheConfig& recoveredConfig) const {
   return *config_.cacheBaseOffset_ref() ==
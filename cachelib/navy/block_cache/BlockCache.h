@@ -85,6 +85,11 @@ class BlockCache final : public Engine {
     // whether to remove an item by checking the full key.
     bool preciseRemove{false};
 
+    // Whether the device reads of regions are served through a ReadMerger
+    // with @readMergerConfig.
+    bool readMerging{false};
+    ReadMerger::Config readMergerConfig;
+
     // Calculates the total region number.
     uint32_t getNumRegions() const {
       XDCHECK_EQ(0ul, cacheSize % regionSize);
@@ -127,6 +132,18 @@ class BlockCache final : public Engine {
   //          Status::Retry on no space available for now.
   Status insert(HashedKey hk, BufferView value) override;
 
+  // Inserts a batch of entries into BlockCache. Consecutive entries are
+  // appended to the active region with a single allocation and written back
+  // to back into its buffer.
+  //
+  // @param keys      keys of the entries
+  // @param values    values of the entries
+  // @param statuses  resized to the number of keys, the status of the insert
+  //                  of the entry at the same index as returned by insert()
+  void insertBatch(const std::vector<HashedKey>& keys,
+                   const std::vector<BufferView>& values,
+                   std::vector<Status>& statuses) override;
+
   // Looks up a key in BlockCache.
   //
   // @param hk      key to be looked up
@@ -138,6 +155,19 @@ class BlockCache final : public Engine {
   //          Status::DeviceError otherwise.
   Status lookup(HashedKey hk, Buffer& value) override;
 
+  // Looks up a batch of keys in BlockCache. The index entries of all the keys
+  // are resolved first, and entries that lie in the same region close to each
+  // other are read from the device with a single read.
+  //
+  // @param keys      keys to be looked up
+  // @param values    resized to the number of keys, populated with the data
+  //                  read for the key at the same index
+  // @param statuses  resized to the number of keys, the status of the lookup
+  //                  of the key at the same index as returned by lookup()
+  void lookupBatch(const std::vector<HashedKey>& keys,
+                   std::vector<Buffer>& values,
+                   std::vector<Status>& statuses) override;
+
   // Removes a key from BlockCache.
   //
   // @param hk           key to be removed
@@ -145,6 +175,10 @@ class BlockCache final : public Engine {
   // @return Status::Ok if the key is found and Status::NotFound otherwise.
   Status remove(HashedKey hk) override;
 
+  // Removes a key that was copied to the other engine, without calling the
+  // destructor callback.
+  Status removeMoved(HashedKey hk) override;
+
   // Flushes all buffered (in flight) operations in BlockCache.
   void flush() override;
 
@@ -163,6 +197,23 @@ class BlockCache final : public Engine {
   // @return  true if recovery succeeds, false otherwise.
   bool recover(RecordReader& rr) override;
 
+  // Logs removed keys and the regions opened and sealed to @log.
+  void setCheckpointLog(CheckpointLog* log, uint8_t logId) override;
+
+  // Keeps @filter up to date with the keys in the index.
+  void setNegativeFilter(NegativeFilter* filter) override {
+    index_.setNegativeFilter(filter);
+  }
+
+  // Drops the index entries of regions that changed after the checkpoint
+  // and rebuilds them from the content of the regions sealed since.
+  //
+  // @param records   the log of the checkpoint the state was recovered from
+  //
+  // @return  true if the replay succeeds, false otherwise.
+  bool replayCheckpointLog(
+      const std::vector<CheckpointLog::Record>& records) override;
+
   // Exports BlockCache stats via CounterVisitor.
   //
   // @param visitor   CounterVisitor to export stats
@@ -173,6 +224,11 @@ class BlockCache final : public Engine {
     return regionSize_ - sizeof(EntryDesc);
   }
 
+  // Gets the number of bytes written to the device for region flushes.
+  uint64_t getPhysicalWrittenBytes() const override {
+    return regionManager_.getPhysicalWrittenBytes();
+  }
+
   // Gets the alloc alignment size (must be an integral power of two).
   uint32_t getAllocAlignSize() const {
     XDCHECK(folly::isPowTwo(allocAlignSize_));
@@ -204,6 +260,15 @@ class BlockCache final : public Engine {
   static constexpr uint32_t kDefReadBufferSize = 4096;
   // Default priority for an item inserted into block cache
   static constexpr uint16_t kDefaultItemPriority = 0;
+  // Max number of bytes between two entries of a batch lookup for them to be
+  // read from the device with a single read.
+  static constexpr uint32_t kMaxBatchReadGap = 16 * 1024;
+  // Max size of a single device read shared by entries of a batch lookup.
+  static constexpr uint32_t kMaxBatchReadSize = 1024 * 1024;
+  // A batch insert appends at most 1/kBatchAppendsPerRegion of a region at
+  // once. A group that does not fit in the rest of the active region moves
+  // to a new one, so this bounds the space left unused at the region's end.
+  static constexpr uint32_t kBatchAppendsPerRegion = 16;
 
   // When modify @EntryDesc layout, don't forget to bump @kFormatVersion!
   struct EntryDesc {
@@ -246,6 +311,10 @@ class BlockCache final : public Engine {
                     uint32_t slotSize,
                     HashedKey hk,
                     BufferView value);
+  // Adds the entry that was written to the slot ending at @addrEnd to the
+  // index, replacing any previous entry of the key.
+  void addToIndex(HashedKey hk, RelAddress addrEnd, uint32_t slotSize);
+
   // @param readDesc      Descriptor for reading. This must be valid
   // @param addrEnd       End of the entry since the item layout is backward
   // @param approxSize    Approximate size since we got this size from index
@@ -257,6 +326,20 @@ class BlockCache final : public Engine {
                    HashedKey expected,
                    Buffer& value);
 
+  // Parses the entry ending at @addrEnd out of @buffer, which holds the bytes
+  // right before @addrEnd as read from the region. Reads the entry again if
+  // @buffer does not hold all of it.
+  // @param readDesc      Descriptor for reading. This must be valid
+  // @param addrEnd       End of the entry since the item layout is backward
+  // @param buffer        Bytes read from the region that end at @addrEnd
+  // @param expected      We expect the entry's key to match with our key
+  // @param value         We will write the payload into this buffer
+  Status parseEntry(const RegionDescriptor& readDesc,
+                    RelAddress addrEnd,
+                    Buffer buffer,
+                    HashedKey expected,
+                    Buffer& value);
+
   // Allocator reclaim callback
   // Returns number of slots that were successfully evicted
   uint32_t onRegionReclaim(RegionId rid, BufferView buffer);
@@ -272,6 +355,11 @@ class BlockCache final : public Engine {
   // Tries to recover cache. Throws std::exception on failure.
   void tryRecover(RecordReader& rr);
 
+  // Logs @keyHash being removed, or replaced by an entry in region
+  // @regionId, to the checkpoint log if there is one. Returns once the
+  // record is written to the device.
+  void logRemove(uint64_t keyHash, uint32_t regionId);
+
   // The alloc alignment indicates the granularity of read/write. This
   // granuality is less than the device io alignment size because we buffer
   // writes in memory until we fill up a region.
@@ -322,6 +410,10 @@ class BlockCache final : public Engine {
   //         be found or was removed earlier.
   bool removeItem(HashedKey hk, RelAddress currAddr);
 
+  // Removes a key, calling the destructor callback for it if
+  // @callDestructor is set.
+  Status removeImpl(HashedKey hk, bool callDestructor);
+
   void validate(Config& config) const;
 
   // Create the reinsertion policy from config.
@@ -366,9 +458,17 @@ class BlockCache final : public Engine {
   // Make sure that this class member is defined after index_.
   std::shared_ptr<BlockCacheReinsertionPolicy> reinsertionPolicy_;
 
+  CheckpointLog* checkpointLog_{nullptr};
+  uint8_t checkpointLogId_{0};
+
   // thread local counters in synchronized/critical path
   mutable TLCounter lookupCount_;
   mutable TLCounter succLookupCount_;
+  mutable TLCounter batchLookupCount_;
+  mutable TLCounter batchReadCount_;
+  mutable TLCounter batchMergedReadCount_;
+  mutable TLCounter batchInsertCount_;
+  mutable TLCounter batchInsertedItemCount_;
 
   // atomic counters in asynchronized path
   mutable AtomicCounter insertCount_;
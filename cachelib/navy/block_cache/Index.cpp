@@ -91,6 +91,10 @@ Index::LookupResult Index::insert(uint64_t key,
     it.value().totalHits = 0;
     it.value().sizeHint = sizeHint;
   } else {
+    // The filter has to know the key before it can be found
+    if (negativeFilter_) {
+      negativeFilter_->add(key);
+    }
     map.try_emplace(key, address, sizeHint);
   }
   return lr;
@@ -131,6 +135,9 @@ Index::LookupResult Index::remove(uint64_t key) {
 
     trackRemove(it->second.totalHits);
     map.erase(it);
+    if (negativeFilter_) {
+      negativeFilter_->remove(key);
+    }
   }
   return lr;
 }
@@ -143,11 +150,32 @@ bool Index::removeIfMatch(uint64_t key, uint32_t address) {
   if (it != map.end() && it->second.address == address) {
     trackRemove(it->second.totalHits);
     map.erase(it);
+    if (negativeFilter_) {
+      negativeFilter_->remove(key);
+    }
     return true;
   }
   return false;
 }
 
+void Index::removeIf(const std::function<bool(uint32_t address)>& pred) {
+  for (uint32_t i = 0; i < kNumBuckets; i++) {
+    auto lock = std::lock_guard{getMutexOfBucket(i)};
+    auto& map = buckets_[i];
+    for (auto it = map.begin(); it != map.end();) {
+      if (pred(it->second.address)) {
+        const auto removedHash = keyHash(i, it->first);
+        it = map.erase(it);
+        if (negativeFilter_) {
+          negativeFilter_->remove(removedHash);
+        }
+      } else {
+        ++it;
+      }
+    }
+  }
+}
+
 void Index::reset() {
   for (uint32_t i = 0; i < kNumBuckets; i++) {
     auto lock = std::lock_guard{getMutexOfBucket(i)};
@@ -169,15 +197,19 @@ void Index::persist(RecordWriter& rw) const {
   serialization::IndexBucket bucket;
   for (uint32_t i = 0; i < kNumBuckets; i++) {
     *bucket.bucketId() = i;
-    // Convert index entries to thrift objects
-    for (const auto& [key, record] : buckets_[i]) {
-      serialization::IndexEntry entry;
-      entry.key() = key;
-      entry.address() = record.address;
-      entry.sizeHint() = record.sizeHint;
-      entry.totalHits() = record.totalHits;
-      entry.currentHits() = record.currentHits;
-      bucket.entries()->push_back(entry);
+    {
+      // Checkpoints persist the index while it is being modified
+      auto lock = std::shared_lock{getMutexOfBucket(i)};
+      // Convert index entries to thrift objects
+      for (const auto& [key, record] : buckets_[i]) {
+        serialization::IndexEntry entry;
+        entry.key() = key;
+        entry.address() = record.address;
+        entry.sizeHint() = record.sizeHint;
+        entry.totalHits() = record.totalHits;
+        entry.currentHits() = record.currentHits;
+        bucket.entries()->push_back(entry);
+      }
     }
     // Serialize bucket then clear contents to reuse memory.
     serializeProto(bucket, rw);
@@ -196,11 +228,18 @@ void Index::recover(RecordReader& rr) {
                          id)};
     }
     for (auto& entry : *bucket.entries()) {
-      buckets_[id].try_emplace(*entry.key(),
-                               *entry.address(),
-                               *entry.sizeHint(),
-                               *entry.totalHits(),
-                               *entry.currentHits());
+      const auto key = static_cast<uint32_t>(*entry.key());
+      const bool inserted = buckets_[id]
+                                .try_emplace(key,
+                                             *entry.address(),
+                                             *entry.sizeHint(),
+                                             *entry.totalHits(),
+                                             *entry.currentHits())
+                                .second;
+      // Recovery runs before the index is used
+      if (inserted && negativeFilter_) {
+        negativeFilter_->add(keyHash(id, key));
+      }
     }
   }
 }
@@ -30,6 +30,7 @@
 
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/PercentileStats.h"
+#include "cachelib/navy/common/NegativeFilter.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 
 namespace facebook {
@@ -49,7 +50,8 @@ class Index {
 
   // Writes index to a Thrift object one bucket at a time and passes each bucket
   // to @persistCb. The reason for this is because the index can be very large
-  // and serializing everything at once uses a lot of RAM.
+  // and serializing everything at once uses a lot of RAM. Safe to call while
+  // the index is being modified.
   void persist(RecordWriter& rw) const;
 
   // Resets index then inserts entries read from @deserializer. Throws
@@ -142,6 +144,10 @@ class Index {
   // @return true if removed successfully, false otherwise.
   bool removeIfMatch(uint64_t key, uint32_t address);
 
+  // Removes all entries whose address satisfies @pred. Used to drop the
+  // entries of regions that changed after a checkpoint.
+  void removeIf(const std::function<bool(uint32_t address)>& pred);
+
   // Updates hits information of a key.
   void setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits);
 
@@ -154,6 +160,10 @@ class Index {
   // Exports index stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const;
 
+  // Keeps @filter up to date with the keys in the index. Must be set before
+  // the index is used.
+  void setNegativeFilter(NegativeFilter* filter) { negativeFilter_ = filter; }
+
  private:
   static constexpr uint32_t kNumBuckets{64 * 1024};
   static constexpr uint32_t kNumMutexes{1024};
@@ -166,6 +176,11 @@ class Index {
 
   static uint32_t subkey(uint64_t hash) { return hash & 0xffffffffu; }
 
+  // The bits of the key hash kept by the index
+  static uint64_t keyHash(uint32_t bucket, uint32_t subkey) {
+    return (static_cast<uint64_t>(bucket) << 32) | subkey;
+  }
+
   folly::SharedMutex& getMutexOfBucket(uint32_t bucket) const {
     XDCHECK(folly::isPowTwo(kNumMutexes));
     return mutex_[bucket & (kNumMutexes - 1)];
@@ -192,6 +207,8 @@ class Index {
   mutable util::PercentileStats hitsEstimator_{kQuantileWindowSize};
   mutable AtomicCounter unAccessedItems_;
 
+  NegativeFilter* negativeFilter_{nullptr};
+
   static_assert((kNumMutexes & (kNumMutexes - 1)) == 0,
                 "number of mutexes must be power of two");
 };
@@ -30,7 +30,7 @@ uint32_t Region::activeOpenLocked() {
 }
 
 std::tuple<RegionDescriptor, RelAddress> Region::openAndAllocate(
-    uint32_t size) {
+    uint32_t size, uint32_t numItems) {
   std::lock_guard<std::mutex> l{lock_};
   XDCHECK(!(flags_ & kBlockAccess));
   if (!canAllocateLocked(size)) {
@@ -39,7 +39,7 @@ std::tuple<RegionDescriptor, RelAddress> Region::openAndAllocate(
   activeWriters_++;
   return std::make_tuple(
       RegionDescriptor::makeWriteDescriptor(OpenStatus::Ready, regionId_),
-      allocateLocked(size));
+      allocateLocked(size, numItems));
 }
 
 RegionDescriptor Region::openForRead() {
@@ -125,11 +125,11 @@ void Region::close(RegionDescriptor&& desc) {
   }
 }
 
-RelAddress Region::allocateLocked(uint32_t size) {
+RelAddress Region::allocateLocked(uint32_t size, uint32_t numItems) {
   XDCHECK(canAllocateLocked(size));
   auto offset = lastEntryEndOffset_;
   lastEntryEndOffset_ += size;
-  numItems_++;
+  numItems_ += numItems;
   return RelAddress{regionId_, offset};
 }
 
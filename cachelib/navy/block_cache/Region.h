@@ -80,9 +80,11 @@ class Region {
   // thread can be running region reclaim at a time.
   bool readyForReclaim();
 
-  // Opens this region for write and allocate a slot of @size.
+  // Opens this region for write and allocate a slot of @size that holds
+  // @numItems entries back to back.
   // Fail if there's insufficient space.
-  std::tuple<RegionDescriptor, RelAddress> openAndAllocate(uint32_t size);
+  std::tuple<RegionDescriptor, RelAddress> openAndAllocate(
+      uint32_t size, uint32_t numItems = 1);
 
   // Opens this region for reading. Fail if region is blocked.
   RegionDescriptor openForRead();
@@ -217,7 +219,7 @@ class Region {
     return (lastEntryEndOffset_ + size <= regionSize_);
   }
 
-  RelAddress allocateLocked(uint32_t size);
+  RelAddress allocateLocked(uint32_t size, uint32_t numItems);
 
   static constexpr uint32_t kBlockAccess{1u << 0};
   static constexpr uint16_t kPinned{1u << 1};
@@ -98,6 +98,9 @@ void RegionManager::reset() {
     cleanRegions_.clear();
   }
   seqNumber_.store(0, std::memory_order_release);
+  if (readMerger_) {
+    readMerger_->reset();
+  }
 
   // Reset eviction policy
   resetEvictionPolicy();
@@ -153,6 +156,7 @@ void RegionManager::releaseCleanedupRegion(RegionId rid) {
   // below region.reset(). It is similar to the full barrier in openForRead.
   seqNumber_.fetch_add(1, std::memory_order_acq_rel);
 
+  invalidateReads(rid);
   // Reset all region internal state, making it ready to be
   // used by a region allocator.
   region.reset();
@@ -170,9 +174,28 @@ OpenStatus RegionManager::assignBufferToRegion(RegionId rid) {
   }
   auto& region = getRegion(rid);
   region.attachBuffer(std::move(buf));
+  logRegion(CheckpointLog::RecordType::kOpen, rid);
   return OpenStatus::Ready;
 }
 
+void RegionManager::logRegion(CheckpointLog::RecordType type,
+                              RegionId rid) const {
+  if (!checkpointLog_) {
+    return;
+  }
+  const auto& region = getRegion(rid);
+  CheckpointLog::Record record;
+  record.type = type;
+  record.logId = checkpointLogId_;
+  record.regionId = rid.index();
+  if (type == CheckpointLog::RecordType::kSeal) {
+    record.priority = region.getPriority();
+    record.lastEntryEndOffset = region.getLastEntryEndOffset();
+    record.numItems = region.getNumItems();
+  }
+  checkpointLog_->append(record);
+}
+
 std::unique_ptr<Buffer> RegionManager::claimBufferFromPool() {
   std::unique_ptr<Buffer> buf;
   {
@@ -238,9 +261,14 @@ void RegionManager::doFlush(RegionId rid, bool async) {
         numInMemBufCleanupRetries_.inc();
         return JobExitCode::Reschedule;
       }
+      if (checkpointLog_) {
+        // The region must be logged as open before its content is written
+        checkpointLog_->sync();
+      }
       auto res = flushBuffer(rid);
       if (res == Region::FlushRes::kSuccess) {
         flushed = true;
+        logRegion(CheckpointLog::RecordType::kSeal, rid);
       } else {
         // We have a limited retry limit for flush errors due to device
         if (res == Region::FlushRes::kRetryDeviceFailure) {
@@ -387,6 +415,7 @@ void RegionManager::releaseEvictedRegion(RegionId rid,
   // race where a read returns stale data. See openForRead() for details.
   seqNumber_.fetch_add(1, std::memory_order_acq_rel);
 
+  invalidateReads(rid);
   // Reset all region internal state, making it ready to be
   // used by a region allocator.
   region.reset();
@@ -424,6 +453,11 @@ void RegionManager::persist(RecordWriter& rw) const {
     *regionProto.lastEntryEndOffset() = regions_[i]->getLastEntryEndOffset();
     regionProto.priority() = regions_[i]->getPriority();
     *regionProto.numItems() = regions_[i]->getNumItems();
+    // The content of regions with a buffer is not on the device yet, so
+    // the log of the checkpoint being written starts with them open.
+    if (regions_[i]->hasBuffer()) {
+      logRegion(CheckpointLog::RecordType::kOpen, RegionId{i});
+    }
   }
   serializeProto(regionData, rw);
 }
@@ -453,11 +487,33 @@ void RegionManager::recover(RecordReader& rr) {
     regions_[index] =
         std::make_unique<Region>(regionProto, *regionData.regionSize());
   }
+  if (readMerger_) {
+    readMerger_->reset();
+  }
 
   // Reset policy and reinitialize it per the recovered state
   resetEvictionPolicy();
 }
 
+void RegionManager::recoverRegions(
+    const std::vector<serialization::Region>& regions) {
+  for (auto regionProto : regions) {
+    uint32_t index = *regionProto.regionId();
+    if (index >= numRegions_ ||
+        static_cast<uint32_t>(*regionProto.lastEntryEndOffset()) >
+            regionSize_) {
+      throw std::invalid_argument(
+          "Could not recover RegionManager. Invalid RegionId.");
+    }
+    if (numPriorities_ > 0 && regionProto.priority() >= numPriorities_) {
+      regionProto.priority() = numPriorities_ - 1;
+    }
+    regions_[index] = std::make_unique<Region>(regionProto, regionSize_);
+    invalidateReads(RegionId{index});
+  }
+  resetEvictionPolicy();
+}
+
 void RegionManager::resetEvictionPolicy() {
   XDCHECK_GT(numRegions_, 0u);
 
@@ -518,9 +574,22 @@ Buffer RegionManager::read(const RegionDescriptor& desc,
   }
   XDCHECK(isValidIORange(addr.offset(), size));
 
+  if (readMerger_) {
+    // Readahead stays within the data written to the region
+    return readMerger_->read(
+        physicalOffset(addr),
+        size,
+        physicalOffset(RelAddress{rid, region.getLastEntryEndOffset()}));
+  }
   return device_.read(physicalOffset(addr), size);
 }
 
+void RegionManager::invalidateReads(RegionId rid) const {
+  if (readMerger_) {
+    readMerger_->invalidate(physicalOffset(RelAddress{rid, 0}), regionSize_);
+  }
+}
+
 void RegionManager::flush() { device_.flush(); }
 
 void RegionManager::getCounters(const CounterVisitor& visitor) const {
@@ -547,6 +616,9 @@ void RegionManager::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_bc_inmem_cleanup_retries", numInMemBufCleanupRetries_.get(),
           CounterVisitor::CounterType::RATE);
+  if (readMerger_) {
+    readMerger_->getCounters(visitor);
+  }
   policy_->getCounters(visitor);
 }
 } // namespace navy
@@ -29,7 +29,9 @@
 #include "cachelib/navy/block_cache/Region.h"
 #include "cachelib/navy/block_cache/Types.h"
 #include "cachelib/navy/common/Buffer.h"
+#include "cachelib/navy/common/CheckpointLog.h"
 #include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/ReadMerger.h"
 #include "cachelib/navy/common/Types.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
 #include "cachelib/navy/serialization/RecordIO.h"
@@ -217,9 +219,35 @@ class RegionManager {
   // failure.
   void recover(RecordReader& rr);
 
+  // Replaces the state of @regions with the one recovered from a checkpoint
+  // log and reinitializes the eviction policy.
+  void recoverRegions(const std::vector<serialization::Region>& regions);
+
+  // Logs the regions opened and sealed to @log with @logId so that the
+  // regions changed after a checkpoint can be told apart on recovery.
+  void setCheckpointLog(CheckpointLog* log, uint8_t logId) {
+    checkpointLog_ = log;
+    checkpointLogId_ = logId;
+  }
+
+  // Serves the device reads of regions through a ReadMerger with @config,
+  // so that concurrent reads of adjacent entries share a device read. Reads
+  // are sharded by region.
+  //
+  // @throw std::invalid_argument on bad config
+  void enableReadMerging(ReadMerger::Config config) {
+    config.shardSize = regionSize_;
+    readMerger_ = std::make_unique<ReadMerger>(device_, std::move(config));
+  }
+
   // Exports RegionManager stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const;
 
+  // Returns the number of bytes written to the device so far.
+  uint64_t getPhysicalWrittenBytes() const {
+    return physicalWrittenCount_.get();
+  }
+
   // Opens a region for reading and returns the region descriptor.
   //
   // @param rid         region ID
@@ -261,8 +289,15 @@ class RegionManager {
   bool deviceWrite(RelAddress addr, BufferView buf);
 
   bool isValidIORange(uint32_t offset, uint32_t size) const;
+
+  // Drops the data of region @rid held by the read merger before the region
+  // is reused.
+  void invalidateReads(RegionId rid) const;
   OpenStatus assignBufferToRegion(RegionId rid);
 
+  // Appends a record of @type for region @rid to the checkpoint log, if any.
+  void logRegion(CheckpointLog::RecordType type, RegionId rid) const;
+
   // Initializes the eviction policy. Even on a clean start, we will track all
   // the regions. The difference is that these regions will have no items in
   // them and can be evicted right away.
@@ -274,6 +309,8 @@ class RegionManager {
   const uint64_t regionSize_{};
   const uint64_t baseOffset_{};
   Device& device_;
+  // null unless read merging is enabled
+  std::unique_ptr<ReadMerger> readMerger_;
   const std::unique_ptr<EvictionPolicy> policy_;
   std::unique_ptr<std::unique_ptr<Region>[]> regions_;
   mutable AtomicCounter externalFragmentation_;
@@ -313,6 +350,9 @@ class RegionManager {
   // Locking order is region lock, followed by bufferMutex_;
   mutable std::mutex bufferMutex_;
   std::vector<std::unique_ptr<Buffer>> buffers_;
+
+  CheckpointLog* checkpointLog_{nullptr};
+  uint8_t checkpointLogId_{0};
 };
 } // namespace navy
 } // namespace cachelib
@@ -234,6 +234,158 @@ TEST(BlockCache, InsertLookup) {
   EXPECT_EQ(0, hits[3]);
 }
 
+TEST(BlockCache, LookupBatch) {
+  std::vector<CacheEntry> log;
+  std::vector<uint32_t> hits(4);
+  auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto ex = makeJobScheduler();
+  auto config = makeConfig(*ex, std::move(policy), *device);
+  auto engine = makeEngine(std::move(config));
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+
+  // Fill up the first region and write one entry into the second region
+  BufferGen bg;
+  for (size_t i = 0; i < 17; i++) {
+    CacheEntry e{bg.gen(8), bg.gen(800)};
+    EXPECT_EQ(Status::Ok, driver->insertAsync(e.key(), e.value(), nullptr));
+    log.push_back(std::move(e));
+  }
+  driver->flush();
+
+  // look up the entries out of order along with a key that does not exist
+  CacheEntry missing{bg.gen(8), bg.gen(800)};
+  std::vector<HashedKey> keys{missing.key()};
+  for (size_t i = 17; i-- > 0;) {
+    keys.push_back(log[i].key());
+  }
+  std::vector<Status> statuses(keys.size(), Status::BadState);
+  std::vector<Buffer> values(keys.size());
+  std::vector<LookupCallback> cbs;
+  for (size_t i = 0; i < keys.size(); i++) {
+    cbs.push_back([&statuses, &values, i](Status status, HashedKey,
+                                          Buffer value) {
+      statuses[i] = status;
+      values[i] = std::move(value);
+    });
+  }
+  driver->lookupBatchAsync(keys, std::move(cbs));
+  driver->flush();
+
+  EXPECT_EQ(Status::NotFound, statuses[0]);
+  for (size_t i = 1; i < keys.size(); i++) {
+    ASSERT_EQ(Status::Ok, statuses[i]);
+    EXPECT_EQ(log[17 - i].value(), values[i].view());
+  }
+  EXPECT_EQ(16, hits[0]);
+  EXPECT_EQ(1, hits[1]);
+
+  // the entries of the first region are read with a single read, and the
+  // entry alone in the second region on its own.
+  driver->getCounters({[](folly::StringPiece name, double count) {
+    if (name == "navy_bc_batch_lookups" || name == "navy_bc_batch_reads") {
+      EXPECT_EQ(1, count);
+    } else if (name == "navy_bc_batch_merged_reads") {
+      EXPECT_EQ(16, count);
+    } else if (name == "navy_bc_lookups") {
+      EXPECT_EQ(18, count);
+    } else if (name == "navy_bc_succ_lookups") {
+      EXPECT_EQ(17, count);
+    }
+  }});
+}
+
+TEST(BlockCache, ReadMergingReadahead) {
+  std::vector<CacheEntry> log;
+  std::vector<uint32_t> hits(4);
+  auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto ex = makeJobScheduler();
+  auto config = makeConfig(*ex, std::move(policy), *device);
+  config.readMerging = true;
+  config.readMergerConfig.readaheadSize = kRegionSize;
+  auto engine = makeEngine(std::move(config));
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+
+  // Fill up the first region and write one entry into the second region
+  BufferGen bg;
+  for (size_t i = 0; i < 17; i++) {
+    CacheEntry e{bg.gen(8), bg.gen(800)};
+    EXPECT_EQ(Status::Ok, driver->insertAsync(e.key(), e.value(), nullptr));
+    log.push_back(std::move(e));
+  }
+  driver->flush();
+
+  // The first lookup reads the whole first region ahead, and the entries
+  // written after it are served from the readahead.
+  for (size_t i = 0; i < 17; i++) {
+    Buffer value;
+    EXPECT_EQ(Status::Ok, driver->lookup(log[i].key(), value));
+    EXPECT_EQ(log[i].value(), value.view());
+  }
+  driver->getCounters({[](folly::StringPiece name, double count) {
+    if (name == "navy_read_merge_device_reads") {
+      EXPECT_EQ(1, count);
+    } else if (name == "navy_readahead_hits") {
+      EXPECT_EQ(15, count);
+    } else if (name == "navy_readahead_bytes") {
+      EXPECT_EQ(15 * 1024, count);
+    }
+  }});
+}
+
+TEST(BlockCache, InsertBatch) {
+  std::vector<CacheEntry> log;
+  std::vector<uint32_t> hits(4);
+  auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto ex = makeJobScheduler();
+  auto config = makeConfig(*ex, std::move(policy), *device);
+  auto engine = makeEngine(std::move(config));
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+
+  // 8 entries that take 512 bytes each, appended two at a time since a
+  // batch append is limited to 1/16 of the region, then an entry that takes
+  // the whole append size and is inserted on its own.
+  BufferGen bg;
+  for (size_t i = 0; i < 8; i++) {
+    log.emplace_back(bg.gen(8), bg.gen(100));
+  }
+  log.emplace_back(bg.gen(8), bg.gen(800));
+
+  std::vector<HashedKey> keys;
+  std::vector<BufferView> values;
+  std::vector<Status> statuses(log.size(), Status::BadState);
+  std::vector<InsertCallback> cbs;
+  for (size_t i = 0; i < log.size(); i++) {
+    keys.push_back(log[i].key());
+    values.push_back(log[i].value());
+    cbs.push_back(
+        [&statuses, i](Status status, HashedKey) { statuses[i] = status; });
+  }
+  driver->insertBatchAsync(keys, values, std::move(cbs));
+  driver->flush();
+
+  for (size_t i = 0; i < log.size(); i++) {
+    ASSERT_EQ(Status::Ok, statuses[i]);
+    Buffer value;
+    EXPECT_EQ(Status::Ok, driver->lookup(log[i].key(), value));
+    EXPECT_EQ(log[i].value(), value.view());
+  }
+
+  driver->getCounters({[](folly::StringPiece name, double count) {
+    if (name == "navy_bc_batch_inserts") {
+      EXPECT_EQ(4, count);
+    } else if (name == "navy_bc_batch_inserted_items") {
+      EXPECT_EQ(8, count);
+    } else if (name == "navy_bc_inserts" || name == "navy_bc_succ_inserts") {
+      EXPECT_EQ(9, count);
+    } else if (name == "navy_inserts" || name == "navy_succ_inserts") {
+      EXPECT_EQ(9, count);
+    }
+  }});
+}
+
 TEST(BlockCache, InsertLookupSync) {
   std::vector<CacheEntry> log;
   std::vector<uint32_t> hits(4);
@@ -1698,6 +1850,142 @@ TEST(BlockCache, RecoveryCorruptedData) {
   EXPECT_FALSE(driver->recover());
 }
 
+TEST(BlockCache, CheckpointLogReplay) {
+  std::vector<uint32_t> hits(4);
+  const uint32_t ioAlignSize = 4096;
+  const uint64_t logSize = 64 * 1024;
+  const uint64_t metadataSize = 4 * 1024 * 1024;
+  auto device = createMemoryDevice(
+      metadataSize + kDeviceSize, nullptr /* encryption */, ioAlignSize);
+  auto makeCache = [&](BlockCache*& cache, JobScheduler*& scheduler) {
+    auto ex = makeJobScheduler();
+    scheduler = ex.get();
+    auto config = makeConfig(
+        *ex, std::make_unique<NiceMock<MockPolicy>>(&hits), *device);
+    config.numInMemBuffers = 2;
+    auto engine = makeEngine(std::move(config), metadataSize);
+    cache = static_cast<BlockCache*>(engine.get());
+    return makeDriver(std::move(engine), std::move(ex));
+  };
+
+  BufferGen bg;
+  std::vector<CacheEntry> log;
+  BlockCache* cache{};
+  JobScheduler* ex{};
+  {
+    CheckpointLog checkpointLog{*device, 0, logSize};
+    auto driver = makeCache(cache, ex);
+    cache->setCheckpointLog(&checkpointLog, 0);
+
+    // The first region is written while the checkpoint is taken
+    checkpointLog.begin(1);
+    for (size_t i = 0; i < 4; i++) {
+      CacheEntry e{bg.gen(8), bg.gen(3200)};
+      EXPECT_EQ(Status::Ok, driver->insert(e.key(), e.value()));
+      log.push_back(std::move(e));
+    }
+    driver->flush();
+    {
+      auto rw = createMetadataRecordWriter(
+          *device, metadataSize - logSize, logSize);
+      cache->persist(*rw);
+    }
+    EXPECT_TRUE(checkpointLog.commit());
+
+    // Fill the second region
+    for (size_t i = 0; i < 4; i++) {
+      CacheEntry e{bg.gen(8), bg.gen(3200)};
+      EXPECT_EQ(Status::Ok, driver->insert(e.key(), e.value()));
+      log.push_back(std::move(e));
+    }
+    EXPECT_EQ(Status::Ok, driver->remove(log[0].key()));
+    // Seals the second region. The new value is left in the in-memory buffer
+    // of the third region.
+    CacheEntry e{log[1].key(), bg.gen(3200)};
+    EXPECT_EQ(Status::Ok, driver->insert(e.key(), e.value()));
+    ex->finish();
+    EXPECT_TRUE(checkpointLog.sync());
+    // Navy goes down without flushing the third region
+  }
+
+  CheckpointLog checkpointLog{*device, 0, logSize};
+  auto driver = makeCache(cache, ex);
+  std::vector<CheckpointLog::Record> records;
+  ASSERT_TRUE(checkpointLog.recover(1, records));
+  auto rr =
+      createMetadataRecordReader(*device, metadataSize - logSize, logSize);
+  ASSERT_TRUE(cache->recover(*rr));
+  ASSERT_TRUE(cache->replayCheckpointLog(records));
+
+  Buffer value;
+  // Removed
+  EXPECT_EQ(Status::NotFound, driver->lookup(log[0].key(), value));
+  // The old value is stale and the new one was lost
+  EXPECT_EQ(Status::NotFound, driver->lookup(log[1].key(), value));
+  for (size_t i = 2; i < log.size(); i++) {
+    EXPECT_EQ(Status::Ok, driver->lookup(log[i].key(), value));
+    EXPECT_EQ(log[i].value(), value.view());
+  }
+}
+
+TEST(BlockCache, CheckpointLogRemoveIsDurable) {
+  std::vector<uint32_t> hits(4);
+  const uint32_t ioAlignSize = 4096;
+  const uint64_t logSize = 64 * 1024;
+  const uint64_t metadataSize = 4 * 1024 * 1024;
+  auto device = createMemoryDevice(
+      metadataSize + kDeviceSize, nullptr /* encryption */, ioAlignSize);
+  auto makeCache = [&](BlockCache*& cache) {
+    auto ex = makeJobScheduler();
+    auto config = makeConfig(
+        *ex, std::make_unique<NiceMock<MockPolicy>>(&hits), *device);
+    auto engine = makeEngine(std::move(config), metadataSize);
+    cache = static_cast<BlockCache*>(engine.get());
+    return makeDriver(std::move(engine), std::move(ex));
+  };
+
+  BufferGen bg;
+  std::vector<CacheEntry> log;
+  BlockCache* cache{};
+  {
+    CheckpointLog checkpointLog{*device, 0, logSize};
+    auto driver = makeCache(cache);
+    cache->setCheckpointLog(&checkpointLog, 0);
+    checkpointLog.begin(1);
+    for (size_t i = 0; i < 4; i++) {
+      CacheEntry e{bg.gen(8), bg.gen(3200)};
+      EXPECT_EQ(Status::Ok, driver->insert(e.key(), e.value()));
+      log.push_back(std::move(e));
+    }
+    driver->flush();
+    {
+      auto rw = createMetadataRecordWriter(
+          *device, metadataSize - logSize, logSize);
+      cache->persist(*rw);
+    }
+    EXPECT_TRUE(checkpointLog.commit());
+
+    // Navy goes down right after the remove, without syncing the log
+    EXPECT_EQ(Status::Ok, driver->remove(log[0].key()));
+  }
+
+  CheckpointLog checkpointLog{*device, 0, logSize};
+  auto driver = makeCache(cache);
+  std::vector<CheckpointLog::Record> records;
+  ASSERT_TRUE(checkpointLog.recover(1, records));
+  auto rr =
+      createMetadataRecordReader(*device, metadataSize - logSize, logSize);
+  ASSERT_TRUE(cache->recover(*rr));
+  ASSERT_TRUE(cache->replayCheckpointLog(records));
+
+  Buffer value;
+  EXPECT_EQ(Status::NotFound, driver->lookup(log[0].key(), value));
+  for (size_t i = 1; i < log.size(); i++) {
+    EXPECT_EQ(Status::Ok, driver->lookup(log[i].key(), value));
+    EXPECT_EQ(log[i].value(), value.view());
+  }
+}
+
 TEST(BlockCache, NoJobsOnStartup) {
   std::vector<uint32_t> hits(4);
   auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
@@ -197,6 +197,44 @@ TEST(Index, ThreadSafe) {
   EXPECT_EQ(200, index.peek(key).currentHits());
 }
 
+TEST(Index, NegativeFilter) {
+  NegativeFilter filter{64 * 1024, 4};
+  Index index;
+  index.setNegativeFilter(&filter);
+  for (uint64_t i = 0; i < 16; i++) {
+    // Bits above the 48 kept by the index are ignored
+    index.insert(i << 56 | i << 32 | i, i, 0);
+  }
+  for (uint64_t i = 0; i < 16; i++) {
+    EXPECT_TRUE(filter.couldExist(i << 32 | i));
+  }
+  EXPECT_FALSE(filter.couldExist(100));
+
+  // Overwriting keeps the key
+  index.insert(1ULL << 32 | 1, 100, 0);
+  index.remove(1ULL << 32 | 1);
+  EXPECT_FALSE(filter.couldExist(1ULL << 32 | 1));
+  EXPECT_FALSE(index.removeIfMatch(2ULL << 32 | 2, 100));
+  EXPECT_TRUE(filter.couldExist(2ULL << 32 | 2));
+  EXPECT_TRUE(index.removeIfMatch(2ULL << 32 | 2, 2));
+  EXPECT_FALSE(filter.couldExist(2ULL << 32 | 2));
+  index.removeIf([](uint32_t address) { return address == 3; });
+  EXPECT_FALSE(filter.couldExist(3ULL << 32 | 3));
+
+  folly::IOBufQueue ioq;
+  auto rw = createMemoryRecordWriter(ioq);
+  index.persist(*rw);
+
+  auto rr = createMemoryRecordReader(ioq);
+  NegativeFilter newFilter{64 * 1024, 4};
+  Index newIndex;
+  newIndex.setNegativeFilter(&newFilter);
+  newIndex.recover(*rr);
+  for (uint64_t i = 0; i < 16; i++) {
+    EXPECT_EQ(i > 3 || i == 0, newFilter.couldExist(i << 32 | i));
+  }
+}
+
 } // namespace tests
 } // namespace navy
 } // namespace cachelib
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/common/CheckpointLog.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "cachelib/navy/common/Hash.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace {
+constexpr uint32_t kBlockMagic = 0x4e43504c;
+constexpr uint32_t kMinBlockSize = 4096;
+constexpr uint64_t kMinBlocksPerStream = 4;
+// number of blocks read at once on recovery
+constexpr uint64_t kReadBlocks = 256;
+
+// The block marks the checkpoint of the stream as committed.
+constexpr uint32_t kFlagCommit = 1;
+// The stream ran out of space. Records appended after this block are lost.
+constexpr uint32_t kFlagOverflow = 2;
+
+struct BlockHeader {
+  uint32_t magic{};
+  // checksum of the block after this field
+  uint32_t checksum{};
+  uint64_t checkpointId{};
+  // position of the block in the stream
+  uint64_t index{};
+  uint32_t numRecords{};
+  uint32_t flags{};
+};
+static_assert(sizeof(BlockHeader) == 32, "BlockHeader size is 32 bytes");
+
+constexpr size_t kChecksumEnd = offsetof(BlockHeader, checksum) +
+                                sizeof(BlockHeader::checksum);
+
+uint32_t blockChecksum(const uint8_t* block, uint32_t blockSize) {
+  return checksum(BufferView{blockSize - kChecksumEnd, block + kChecksumEnd});
+}
+} // namespace
+
+CheckpointLog::CheckpointLog(Device& device, uint64_t baseOffset, uint64_t size)
+    : device_{device},
+      baseOffset_{baseOffset},
+      blockSize_{std::max(device.getIOAlignmentSize(), kMinBlockSize)},
+      blocksPerStream_{size / 2 / blockSize_},
+      recordsPerBlock_{static_cast<uint32_t>(
+          (blockSize_ - sizeof(BlockHeader)) / sizeof(Record))} {
+  if (baseOffset_ % blockSize_ != 0 ||
+      blocksPerStream_ < kMinBlocksPerStream) {
+    throw std::invalid_argument(folly::sformat(
+        "checkpoint log of {} bytes at offset {} should be aligned to {} "
+        "bytes and fit at least {} blocks",
+        size,
+        baseOffset_,
+        blockSize_,
+        2 * kMinBlocksPerStream));
+  }
+  pending_.reserve(recordsPerBlock_);
+}
+
+uint64_t CheckpointLog::append(const Record& record) {
+  if (!logging_.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  recordCount_.inc();
+  std::lock_guard<std::mutex> l{mutex_};
+  pending_.push_back(record);
+  return ++lastSeq_;
+}
+
+bool CheckpointLog::sync() {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  return syncLocked();
+}
+
+bool CheckpointLog::syncUpTo(uint64_t seq) {
+  if (syncedSeq_.load(std::memory_order_acquire) >= seq) {
+    return true;
+  }
+  std::lock_guard<std::mutex> w{writeMutex_};
+  // another caller may have written the record while we waited
+  if (syncedSeq_.load(std::memory_order_acquire) >= seq) {
+    return true;
+  }
+  return syncLocked();
+}
+
+bool CheckpointLog::syncLocked() {
+  uint64_t lastSeq{};
+  auto records = takePending(lastSeq);
+  return writePendingLocked(records, lastSeq);
+}
+
+std::vector<CheckpointLog::Record> CheckpointLog::takePending(
+    uint64_t& lastSeq) {
+  std::vector<Record> records;
+  records.reserve(recordsPerBlock_);
+  std::lock_guard<std::mutex> l{mutex_};
+  records.swap(pending_);
+  lastSeq = lastSeq_;
+  return records;
+}
+
+bool CheckpointLog::writePendingLocked(const std::vector<Record>& records,
+                                       uint64_t lastSeq,
+                                       const Stream* skip) {
+  bool written = true;
+  if (!records.empty()) {
+    for (auto& stream : streams_) {
+      if (stream.active && &stream != skip) {
+        written &= writeRecords(stream, records);
+      }
+    }
+    updateLoggingLocked();
+  }
+  syncedSeq_.store(lastSeq, std::memory_order_release);
+  return written;
+}
+
+void CheckpointLog::updateLoggingLocked() {
+  logging_.store(streams_[0].active || streams_[1].active,
+                 std::memory_order_release);
+}
+
+bool CheckpointLog::writeRecords(Stream& stream,
+                                 const std::vector<Record>& records) {
+  for (const auto& record : records) {
+    stream.tail.push_back(record);
+    if (stream.tail.size() == recordsPerBlock_) {
+      if (!writeBlock(stream, 0 /* flags */)) {
+        return false;
+      }
+      closeTail(stream);
+    }
+  }
+  // The partial block is written now and rewritten as more records come
+  return stream.tail.empty() || writeBlock(stream, 0 /* flags */);
+}
+
+void CheckpointLog::closeTail(Stream& stream) {
+  if (!stream.tail.empty()) {
+    stream.tail.clear();
+    stream.nextBlock++;
+  }
+}
+
+bool CheckpointLog::writeBlock(Stream& stream, uint32_t flags) {
+  XDCHECK(stream.active);
+  XDCHECK_LE(stream.tail.size(), recordsPerBlock_);
+  const auto streamIdx = static_cast<uint32_t>(&stream - streams_.data());
+  const Record* records = stream.tail.data();
+  auto numRecords = static_cast<uint32_t>(stream.tail.size());
+  // The last block is kept for the overflow mark, so that recovery can tell
+  // a full log from one that lost records.
+  if (stream.nextBlock + 1 >= blocksPerStream_) {
+    XLOGF(ERR,
+          "Log of checkpoint {} is full. It can no longer be recovered.",
+          stream.checkpointId);
+    overflowCount_.inc();
+    stream.active = false;
+    records = nullptr;
+    numRecords = 0;
+    flags = kFlagOverflow;
+  }
+
+  BlockHeader header;
+  header.magic = kBlockMagic;
+  header.checkpointId = stream.checkpointId;
+  header.index = stream.nextBlock;
+  header.numRecords = numRecords;
+  header.flags = flags;
+
+  auto buffer = device_.makeIOBuffer(blockSize_);
+  std::memset(buffer.data(), 0, blockSize_);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  if (numRecords > 0) {
+    std::memcpy(buffer.data() + sizeof(header),
+                records,
+                numRecords * sizeof(Record));
+  }
+  header.checksum = blockChecksum(buffer.data(), blockSize_);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+
+  const auto offset = streamOffset(streamIdx) + stream.nextBlock * blockSize_;
+  if (!device_.write(offset, std::move(buffer))) {
+    XLOGF(ERR,
+          "Failed to write the log of checkpoint {} at offset {}",
+          stream.checkpointId,
+          offset);
+    errorCount_.inc();
+    stream.active = false;
+    return false;
+  }
+  blockCount_.inc();
+  return stream.active;
+}
+
+void CheckpointLog::begin(uint64_t checkpointId) {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  uint64_t lastSeq{};
+  std::vector<Record> records;
+  auto& next = streams_[1 - current_];
+  {
+    std::lock_guard<std::mutex> l{mutex_};
+    // records buffered so far were appended before the checkpoint started
+    records.swap(pending_);
+    lastSeq = lastSeq_;
+    next = Stream{checkpointId, 0, true, {}};
+    logging_.store(true, std::memory_order_release);
+  }
+  writePendingLocked(records, lastSeq, &next);
+}
+
+bool CheckpointLog::commit() {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  syncLocked();
+  auto& next = streams_[1 - current_];
+  if (!next.active) {
+    return false;
+  }
+  closeTail(next);
+  if (!writeBlock(next, kFlagCommit)) {
+    updateLoggingLocked();
+    return false;
+  }
+  next.nextBlock++;
+  device_.flush();
+  streams_[current_].active = false;
+  current_ = 1 - current_;
+  updateLoggingLocked();
+  return true;
+}
+
+void CheckpointLog::abort() {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  streams_[1 - current_].active = false;
+  updateLoggingLocked();
+}
+
+void CheckpointLog::clear() {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  for (auto& stream : streams_) {
+    stream.active = false;
+  }
+  updateLoggingLocked();
+  std::lock_guard<std::mutex> l{mutex_};
+  pending_.clear();
+  syncedSeq_.store(lastSeq_, std::memory_order_release);
+}
+
+bool CheckpointLog::needsCheckpoint() const {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  const auto& stream = streams_[current_];
+  return !stream.active || stream.nextBlock * 2 >= blocksPerStream_;
+}
+
+bool CheckpointLog::recover(uint64_t checkpointId,
+                            std::vector<Record>& records) {
+  std::lock_guard<std::mutex> w{writeMutex_};
+  auto buffer = device_.makeIOBuffer(kReadBlocks * blockSize_);
+  for (uint32_t s = 0; s < streams_.size(); s++) {
+    std::vector<Record> streamRecords;
+    bool committed = false;
+    bool end = false;
+    uint64_t index = 0;
+    while (!end && index < blocksPerStream_) {
+      const auto numBlocks = std::min(kReadBlocks, blocksPerStream_ - index);
+      if (!device_.read(streamOffset(s) + index * blockSize_,
+                        numBlocks * blockSize_,
+                        buffer.data())) {
+        errorCount_.inc();
+        break;
+      }
+      for (uint64_t i = 0; i < numBlocks; i++) {
+        const uint8_t* block = buffer.data() + i * blockSize_;
+        BlockHeader header;
+        std::memcpy(&header, block, sizeof(header));
+        if (header.magic != kBlockMagic ||
+            header.checkpointId != checkpointId || header.index != index ||
+            header.numRecords > recordsPerBlock_ ||
+            header.checksum != blockChecksum(block, blockSize_)) {
+          end = true;
+          break;
+        }
+        if (header.flags & kFlagOverflow) {
+          committed = false;
+          end = true;
+          break;
+        }
+        committed |= (header.flags & kFlagCommit) != 0;
+        const auto* first =
+            reinterpret_cast<const Record*>(block + sizeof(header));
+        streamRecords.insert(
+            streamRecords.end(), first, first + header.numRecords);
+        index++;
+      }
+    }
+    if (!committed) {
+      continue;
+    }
+
+    records = std::move(streamRecords);
+    streams_[s] = Stream{checkpointId, index, true, {}};
+    streams_[1 - s].active = false;
+    current_ = s;
+    updateLoggingLocked();
+    std::lock_guard<std::mutex> l{mutex_};
+    pending_.clear();
+    syncedSeq_.store(lastSeq_, std::memory_order_release);
+    return true;
+  }
+  return false;
+}
+
+void CheckpointLog::getCounters(const CounterVisitor& visitor) const {
+  visitor("navy_checkpoint_log_records",
+          recordCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_checkpoint_log_blocks",
+          blockCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_checkpoint_log_errors", errorCount_.get());
+  visitor("navy_checkpoint_log_overflows", overflowCount_.get());
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/Types.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// Log of the changes made to the engines after a checkpoint of their state
+// was written to the metadata area. After an unclean shutdown, the state is
+// recovered from the last committed checkpoint and the changes in its log.
+//
+// The log area is split into two streams so that the log of the last
+// committed checkpoint is kept while the next checkpoint is being written.
+// Records are written in blocks of the device IO alignment size. Each block
+// carries the checkpoint id, its position in the stream and a checksum, so a
+// stream is read up to the first block that is torn or left over from an
+// older checkpoint. The last block of a stream is rewritten in place with
+// the records synced since, until it is full.
+//
+// Appending only takes a short lock on the buffer; the device writes are
+// serialized separately, so that appenders do not wait for them. Callers
+// that sync at the same time share the block writes.
+//
+// Thread safe.
+class CheckpointLog {
+ public:
+  enum class RecordType : uint8_t {
+    // A region was opened for writes. Its entries written before the
+    // checkpoint may not be on the device.
+    kOpen = 1,
+    // The in-memory buffer of a region was written to the device.
+    kSeal = 2,
+    // A key was removed, or replaced by a newer value written to region
+    // @regionId.
+    kRemove = 3,
+  };
+
+  // Region id of a record for a key that was removed.
+  static constexpr uint32_t kNoRegion = 0xffffffffu;
+
+  struct Record {
+    RecordType type{};
+    // the engine the record belongs to
+    uint8_t logId{};
+    uint16_t priority{};
+    uint32_t regionId{kNoRegion};
+    uint32_t lastEntryEndOffset{};
+    uint32_t numItems{};
+    uint64_t keyHash{};
+  };
+  static_assert(sizeof(Record) == 24, "Record size is 24 bytes");
+
+  // The log takes [@baseOffset, @baseOffset + @size) of @device.
+  //
+  // @throw std::invalid_argument if the area does not fit 2 streams of at
+  //        least 4 blocks each.
+  CheckpointLog(Device& device, uint64_t baseOffset, uint64_t size);
+
+  CheckpointLog(const CheckpointLog&) = delete;
+  CheckpointLog& operator=(const CheckpointLog&) = delete;
+
+  // Adds a record to the logs being written. Records are buffered until
+  // sync() or syncUpTo() is called. Records appended while there is no
+  // checkpoint are dropped.
+  //
+  // Returns the sequence number of the record for syncUpTo(), or 0 if the
+  // record was dropped.
+  uint64_t append(const Record& record);
+
+  // Writes the buffered records. Returns false on a device error, after
+  // which the checkpoints whose log could not be written are dropped.
+  bool sync();
+
+  // Returns once the record with sequence number @seq and the ones appended
+  // before it are written to the device, writing the buffered records
+  // unless another caller already did. Returns false on a device error.
+  bool syncUpTo(uint64_t seq);
+
+  // Starts the log of checkpoint @checkpointId. Until commit() or abort(),
+  // records also go to the log of the last committed checkpoint, which stays
+  // recoverable in case the new one is not completed.
+  void begin(uint64_t checkpointId);
+
+  // Marks the checkpoint started by the last begin() as complete and stops
+  // logging for the previous one. The checkpoint must be written to the
+  // device before. Returns false if the log could not be written, in which
+  // case the checkpoint cannot be recovered.
+  bool commit();
+
+  // Drops the log started by the last begin().
+  void abort();
+
+  // Stops logging for all checkpoints, e.g. when the engines were reset and
+  // none of the checkpoints matches their state anymore.
+  void clear();
+
+  // Returns true if there is no committed checkpoint being logged, or if its
+  // log is half full and a new checkpoint should be taken before it runs out
+  // of space.
+  bool needsCheckpoint() const;
+
+  // Reads the log of committed checkpoint @checkpointId into @records in the
+  // order they were appended. Returns false if there is no complete log of
+  // the checkpoint. On success, the checkpoint becomes the current one and
+  // further records are appended to its log.
+  bool recover(uint64_t checkpointId, std::vector<Record>& records);
+
+  // Exports log stats via CounterVisitor.
+  void getCounters(const CounterVisitor& visitor) const;
+
+ private:
+  struct Stream {
+    uint64_t checkpointId{};
+    // position of the block being filled
+    uint64_t nextBlock{};
+    bool active{false};
+    // records of the block being filled, already written to the device
+    std::vector<Record> tail;
+  };
+
+  // Writes the tail records of @stream and @flags to the block at its end.
+  // Marks the stream overflowed and inactive if only the last block is
+  // left. Returns false if the stream could not be written.
+  bool writeBlock(Stream& stream, uint32_t flags);
+
+  // Adds @records to the tail of @stream and writes the blocks they fill.
+  bool writeRecords(Stream& stream, const std::vector<Record>& records);
+
+  // Starts a new block for the next records of @stream, keeping the partial
+  // block at its end as it is.
+  void closeTail(Stream& stream);
+
+  uint64_t streamOffset(uint32_t stream) const {
+    return baseOffset_ + stream * blocksPerStream_ * blockSize_;
+  }
+
+  // Writes the buffered records to the active streams. Must be called with
+  // writeMutex_ held.
+  bool syncLocked();
+
+  // Takes the buffered records and the sequence number of the last one.
+  std::vector<Record> takePending(uint64_t& lastSeq);
+
+  // Writes @records to the active streams other than @skip and marks the
+  // records up to @lastSeq as synced. Must be called with writeMutex_ held.
+  bool writePendingLocked(const std::vector<Record>& records,
+                          uint64_t lastSeq,
+                          const Stream* skip = nullptr);
+
+  // Updates logging_ after the streams changed. Must be called with
+  // writeMutex_ held.
+  void updateLoggingLocked();
+
+  Device& device_;
+  const uint64_t baseOffset_{};
+  const uint32_t blockSize_{};
+  const uint64_t blocksPerStream_{};
+  const uint32_t recordsPerBlock_{};
+
+  // serializes the device writes. Guards streams_ and current_. Taken
+  // before mutex_ when both are needed.
+  mutable std::mutex writeMutex_;
+  std::array<Stream, 2> streams_;
+  // stream of the last committed checkpoint
+  uint32_t current_{0};
+  // true if any stream is active, i.e. appended records are kept
+  std::atomic<bool> logging_{false};
+
+  // guards the buffered records and lastSeq_
+  mutable std::mutex mutex_;
+  std::vector<Record> pending_;
+  // sequence number of the last record appended
+  uint64_t lastSeq_{0};
+  // sequence number of the last record written to the device
+  std::atomic<uint64_t> syncedSeq_{0};
+
+  mutable AtomicCounter recordCount_;
+  mutable AtomicCounter blockCount_;
+  mutable AtomicCounter errorCount_;
+  mutable AtomicCounter overflowCount_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/common/NegativeFilter.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+
+#include <stdexcept>
+
+#include "cachelib/common/Hash.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace {
+// The key hash bits kept by the BlockCache index
+constexpr uint64_t kKeyHashMask{(1ULL << 48) - 1};
+} // namespace
+
+NegativeFilter::NegativeFilter(uint64_t sizeBytes, uint32_t numHashes)
+    : numBlocks_{sizeBytes / sizeof(Block)}, numHashes_{numHashes} {
+  if (numBlocks_ == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Negative filter size {} is smaller than a block", sizeBytes));
+  }
+  if (numHashes_ == 0 || numHashes_ > kMaxNumHashes) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid number of negative filter hashes {}, max {}",
+                       numHashes_,
+                       kMaxNumHashes));
+  }
+  blocks_ = std::make_unique<Block[]>(numBlocks_);
+  reset();
+  XLOGF(INFO,
+        "Negative filter: {} bytes, {} hashes",
+        getByteSize(),
+        numHashes_);
+}
+
+NegativeFilter::Block& NegativeFilter::getBlock(uint64_t keyHash) const {
+  return blocks_[hashInt(keyHash & kKeyHashMask) % numBlocks_];
+}
+
+uint64_t NegativeFilter::probeHash(uint64_t keyHash) {
+  // Independent of the block choice
+  return hashInt(hashInt(keyHash & kKeyHashMask));
+}
+
+void NegativeFilter::add(uint64_t keyHash) {
+  auto& block = getBlock(keyHash);
+  auto probes = probeHash(keyHash);
+  for (uint32_t i = 0; i < numHashes_; i++, probes >>= kProbeBits) {
+    const uint32_t counter = probes & ((1u << kProbeBits) - 1);
+    auto& word = block.words[counter / kCountersPerWord];
+    const uint32_t shift = counter % kCountersPerWord * kCounterBits;
+    auto value = word.load(std::memory_order_relaxed);
+    do {
+      if (((value >> shift) & kCounterMax) == kCounterMax) {
+        saturatedCount_.inc();
+        break;
+      }
+    } while (!word.compare_exchange_weak(
+        value, value + (1ULL << shift), std::memory_order_acq_rel));
+  }
+}
+
+void NegativeFilter::remove(uint64_t keyHash) {
+  auto& block = getBlock(keyHash);
+  auto probes = probeHash(keyHash);
+  for (uint32_t i = 0; i < numHashes_; i++, probes >>= kProbeBits) {
+    const uint32_t counter = probes & ((1u << kProbeBits) - 1);
+    auto& word = block.words[counter / kCountersPerWord];
+    const uint32_t shift = counter % kCountersPerWord * kCounterBits;
+    auto value = word.load(std::memory_order_relaxed);
+    do {
+      const auto count = (value >> shift) & kCounterMax;
+      // A saturated counter has lost track of its keys
+      if (count == kCounterMax) {
+        break;
+      }
+      XDCHECK_GT(count, 0u);
+      if (count == 0) {
+        break;
+      }
+    } while (!word.compare_exchange_weak(
+        value, value - (1ULL << shift), std::memory_order_acq_rel));
+  }
+}
+
+bool NegativeFilter::couldExist(uint64_t keyHash) const {
+  lookupCount_.inc();
+  const auto& block = getBlock(keyHash);
+  auto probes = probeHash(keyHash);
+  for (uint32_t i = 0; i < numHashes_; i++, probes >>= kProbeBits) {
+    const uint32_t counter = probes & ((1u << kProbeBits) - 1);
+    const auto value =
+        block.words[counter / kCountersPerWord].load(std::memory_order_acquire);
+    if (((value >> (counter % kCountersPerWord * kCounterBits)) &
+         kCounterMax) == 0) {
+      negativeCount_.inc();
+      return false;
+    }
+  }
+  return true;
+}
+
+void NegativeFilter::reset() {
+  for (uint64_t i = 0; i < numBlocks_; i++) {
+    for (auto& word : blocks_[i].words) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void NegativeFilter::getCounters(const CounterVisitor& visitor) const {
+  const auto negatives = negativeCount_.get();
+  const auto falsePositives = falsePositiveCount_.get();
+  visitor("navy_neg_filter_lookups", lookupCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_neg_filter_negatives", negatives,
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_neg_filter_false_positives", falsePositives,
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_neg_filter_saturated", saturatedCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  // Share of the missing keys looked up that the filter let through
+  visitor("navy_neg_filter_false_positive_pct",
+          negatives + falsePositives > 0
+              ? 100.0 * falsePositives / (negatives + falsePositives)
+              : 0.0);
+  visitor("navy_neg_filter_size_bytes", getByteSize());
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
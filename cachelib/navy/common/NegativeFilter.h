@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/navy/common/Types.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// Counting blocked bloom filter over the keys held by the engines, used to
+// answer lookups of missing keys without going to the engines.
+//
+// Each key maps to one 64 byte block (a cache line) and sets @numHashes
+// 4-bit counters within it, so a check is at most one cache miss. Counters
+// are updated with CAS and read without locks. The engines add a key before
+// it becomes visible and remove it after it is gone, so the filter never has
+// false negatives. A counter that overflows sticks at its max value and is
+// never decremented, which only costs false positives.
+//
+// Only the low 48 bits of the key hash are used, which are the bits the
+// BlockCache index keeps, so that the filter can be rebuilt from the index
+// on recovery.
+//
+// Thread safe.
+class NegativeFilter {
+ public:
+  // Creates a filter of @sizeBytes (rounded down to whole blocks) that sets
+  // @numHashes counters per key.
+  //
+  // @throw std::invalid_argument on bad config
+  NegativeFilter(uint64_t sizeBytes, uint32_t numHashes);
+  NegativeFilter(const NegativeFilter&) = delete;
+  NegativeFilter& operator=(const NegativeFilter&) = delete;
+
+  // Adds a key to the filter. Must be called before the key can be found in
+  // an engine.
+  void add(uint64_t keyHash);
+
+  // Removes a key added earlier. Must be called after the key can no longer
+  // be found in the engine it was added for.
+  void remove(uint64_t keyHash);
+
+  // Returns false if the key is definitely not in any engine.
+  bool couldExist(uint64_t keyHash) const;
+
+  // Zeroes all the counters. Must not race with add() or remove().
+  void reset();
+
+  // Records that a key the filter let through was not found.
+  void recordFalsePositive() { falsePositiveCount_.inc(); }
+
+  uint64_t getByteSize() const { return numBlocks_ * sizeof(Block); }
+
+  // Exports filter stats via CounterVisitor.
+  void getCounters(const CounterVisitor& visitor) const;
+
+  static constexpr uint32_t kMaxNumHashes{9};
+
+ private:
+  static constexpr uint32_t kWordsPerBlock{8};
+  static constexpr uint32_t kCountersPerWord{16};
+  static constexpr uint32_t kCounterBits{4};
+  static constexpr uint64_t kCounterMax{0xf};
+  // 7 bits of the probe hash pick one of the 128 counters of a block
+  static constexpr uint32_t kProbeBits{7};
+  static_assert(kProbeBits * kMaxNumHashes <= 64,
+                "Probes must fit in the probe hash");
+
+  struct alignas(64) Block {
+    std::atomic<uint64_t> words[kWordsPerBlock];
+  };
+  static_assert(sizeof(Block) == 64, "Block must be one cache line");
+
+  Block& getBlock(uint64_t keyHash) const;
+
+  // Returns the probe hash of a key. Each probe takes kProbeBits of it.
+  static uint64_t probeHash(uint64_t keyHash);
+
+  const uint64_t numBlocks_{};
+  const uint32_t numHashes_{};
+  std::unique_ptr<Block[]> blocks_;
+
+  mutable AtomicCounter lookupCount_;
+  mutable AtomicCounter negativeCount_;
+  mutable AtomicCounter falsePositiveCount_;
+  mutable AtomicCounter saturatedCount_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/common/ReadMerger.h"
+
+#include <folly/Format.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+ReadMerger::Config& ReadMerger::Config::validate() {
+  if (mergeWindow.count() < 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid read merge window {}us", mergeWindow.count()));
+  }
+  if (maxMergeSize == 0) {
+    throw std::invalid_argument("Max merge size must be positive");
+  }
+  if (readaheadSize > maxMergeSize) {
+    throw std::invalid_argument(
+        folly::sformat("Readahead size {} is larger than max merge size {}",
+                       readaheadSize,
+                       maxMergeSize));
+  }
+  if (readaheadSize > 0 && numReadaheadBuffers == 0) {
+    throw std::invalid_argument("Readahead needs at least one buffer");
+  }
+  return *this;
+}
+
+ReadMerger::ReadMerger(Device& device, Config config)
+    : device_{device},
+      config_{std::move(config.validate())},
+      alignment_{device.getIOAlignmentSize()},
+      numReadaheadBuffersPerShard_{
+          config_.shardSize == 0
+              ? config_.numReadaheadBuffers
+              : std::max<uint32_t>(
+                    1,
+                    static_cast<uint32_t>(
+                        (config_.numReadaheadBuffers + kNumShards - 1) /
+                        kNumShards))} {}
+
+Buffer ReadMerger::copyOut(const Buffer& buffer,
+                           uint64_t begin,
+                           uint64_t offset,
+                           uint32_t size) {
+  XDCHECK_GE(offset, begin);
+  XDCHECK_LE(offset - begin + size, buffer.size());
+  return Buffer{buffer.view().slice(offset - begin, size)};
+}
+
+std::shared_ptr<const Buffer> ReadMerger::findReadahead(const Shard& shard,
+                                                        uint64_t offset,
+                                                        uint32_t size,
+                                                        uint64_t& begin) {
+  for (const auto& ra : shard.readahead) {
+    if (ra.begin <= offset && offset + size <= ra.end) {
+      begin = ra.begin;
+      return ra.buffer;
+    }
+  }
+  return nullptr;
+}
+
+std::shared_ptr<ReadMerger::PendingRead> ReadMerger::findPending(
+    Shard& shard, uint64_t begin, uint64_t end) const {
+  for (const auto& pending : shard.pending) {
+    if (pending->begin <= begin && end <= pending->end) {
+      return pending;
+    }
+  }
+  // Extend a read that is not issued yet to the adjacent or overlapping
+  // range. Gaps are never read.
+  for (const auto& pending : shard.pending) {
+    if (pending->issued || begin > pending->end || pending->begin > end) {
+      continue;
+    }
+    const auto newBegin = std::min(begin, pending->begin);
+    const auto newEnd = std::max(end, pending->end);
+    if (newEnd - newBegin <= config_.maxMergeSize) {
+      pending->begin = newBegin;
+      pending->end = newEnd;
+      return pending;
+    }
+  }
+  return nullptr;
+}
+
+Buffer ReadMerger::read(uint64_t offset, uint32_t size, uint64_t limit) {
+  XDCHECK_LE(offset + size, device_.getSize());
+  const uint64_t alignedBegin = offset / alignment_ * alignment_;
+  const uint64_t alignedEnd =
+      (offset + size + alignment_ - 1) / alignment_ * alignment_;
+
+  auto& shard = getShard(offset);
+  std::unique_lock<std::mutex> lock{shard.mutex};
+  uint64_t begin = 0;
+  if (auto buffer = findReadahead(shard, offset, size, begin)) {
+    lock.unlock();
+    readaheadHits_.inc();
+    return copyOut(*buffer, begin, offset, size);
+  }
+
+  shard.numReads++;
+  if (auto pending = findPending(shard, alignedBegin, alignedEnd)) {
+    mergeHits_.inc();
+    shard.doneCv.wait(lock, [&pending] { return pending->done; });
+    shard.numReads--;
+    auto buffer = pending->buffer;
+    begin = pending->begin;
+    lock.unlock();
+    if (!buffer) {
+      return Buffer{};
+    }
+    return copyOut(*buffer, begin, offset, size);
+  }
+
+  auto pending = std::make_shared<PendingRead>();
+  pending->begin = alignedBegin;
+  pending->end = alignedEnd;
+  if (alignedEnd - alignedBegin < config_.readaheadSize) {
+    const uint64_t readaheadEnd = std::min<uint64_t>(
+        alignedBegin + config_.readaheadSize, limit / alignment_ * alignment_);
+    pending->end = std::max(alignedEnd, readaheadEnd);
+  }
+  const bool readahead = pending->end > alignedEnd;
+  shard.pending.push_back(pending);
+
+  // Reads to merge with are only likely to arrive while others are in
+  // flight, so a lone read does not wait for them.
+  if (config_.mergeWindow.count() > 0 && shard.numReads > 1) {
+    lock.unlock();
+    std::this_thread::sleep_for(config_.mergeWindow);
+    lock.lock();
+  }
+  // No read can be merged into this one from here on
+  pending->issued = true;
+  const uint64_t readBegin = pending->begin;
+  const uint64_t readSize = pending->end - pending->begin;
+  lock.unlock();
+
+  deviceReads_.inc();
+  auto readBuffer = device_.makeIOBuffer(readSize);
+  std::shared_ptr<const Buffer> buffer;
+  if (device_.read(readBegin, readSize, readBuffer.data())) {
+    buffer = std::make_shared<const Buffer>(std::move(readBuffer));
+  }
+
+  lock.lock();
+  pending->buffer = buffer;
+  pending->done = true;
+  shard.numReads--;
+  shard.pending.erase(
+      std::find(shard.pending.begin(), shard.pending.end(), pending));
+  if (buffer && readahead) {
+    shard.readahead.push_back(
+        ReadaheadBuffer{readBegin, readBegin + readSize, buffer});
+    if (shard.readahead.size() > numReadaheadBuffersPerShard_) {
+      shard.readahead.pop_front();
+    }
+    readaheadBytes_.add(readBegin + readSize - alignedEnd);
+  }
+  lock.unlock();
+  shard.doneCv.notify_all();
+
+  if (!buffer) {
+    return Buffer{};
+  }
+  return copyOut(*buffer, readBegin, offset, size);
+}
+
+void ReadMerger::invalidate(uint64_t offset, uint64_t size) {
+  // A buffer is kept by the shard of the read it was extended from, which
+  // may not be the shard of @offset, so all the shards are checked.
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    auto& readahead = shard.readahead;
+    readahead.erase(std::remove_if(readahead.begin(),
+                                   readahead.end(),
+                                   [offset, size](const ReadaheadBuffer& ra) {
+                                     return ra.begin < offset + size &&
+                                            offset < ra.end;
+                                   }),
+                    readahead.end());
+  }
+}
+
+void ReadMerger::reset() {
+  for (auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    shard.readahead.clear();
+  }
+}
+
+void ReadMerger::getCounters(const CounterVisitor& visitor) const {
+  visitor("navy_read_merge_device_reads", deviceReads_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_read_merge_hits", mergeHits_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_readahead_hits", readaheadHits_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_readahead_bytes", readaheadBytes_.get(),
+          CounterVisitor::CounterType::RATE);
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/lang/Align.h>
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/navy/common/Buffer.h"
+#include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/Types.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// Serves device reads, sharing one device read among concurrent reads of
+// adjacent or overlapping ranges.
+//
+// A read that is covered by a read in flight waits for it instead of issuing
+// its own. The first read of a range (the leader) waits up to the merge window
+// before it is issued if other reads of its shard are in flight, so that reads
+// of adjacent ranges arriving in the meantime are merged into it; a read with
+// nothing else in flight is issued right away. With readahead, a small read is
+// extended up to the readahead size and the data is kept in a few buffers for
+// the reads of the data written after it.
+//
+// Reads are sharded by the range of shardSize bytes they start in (a region
+// for BlockCache), and each shard has its own lock, reads in flight and
+// readahead buffers. Reads are only merged with reads of the same shard.
+//
+// The caller must make sure the data in range is not rewritten while it is
+// being read, and call invalidate() before rewriting data that may be held in
+// the readahead buffers.
+//
+// Thread safe.
+class ReadMerger {
+ public:
+  struct Config {
+    // How long the leader of a read waits for reads to merge with. 0 only
+    // shares reads that are already in flight.
+    std::chrono::microseconds mergeWindow{0};
+
+    // Max size of a merged read.
+    uint32_t maxMergeSize{1024 * 1024};
+
+    // Reads smaller than this are extended to this size. 0 disables
+    // readahead.
+    uint32_t readaheadSize{0};
+
+    // Number of readahead buffers kept, split evenly across the shards with
+    // at least one per shard.
+    uint32_t numReadaheadBuffers{32};
+
+    // Size of the device ranges reads are sharded by. 0 puts all the reads
+    // in one shard.
+    uint64_t shardSize{0};
+
+    // Checks invariants. Throws exception if failed.
+    Config& validate();
+  };
+
+  // @throw std::invalid_argument on bad config
+  ReadMerger(Device& device, Config config);
+  ReadMerger(const ReadMerger&) = delete;
+  ReadMerger& operator=(const ReadMerger&) = delete;
+
+  // Reads @size bytes at @offset of the device. Readahead never goes past
+  // @limit, the end of the data that can be read.
+  //
+  // On success the returned buffer will have same size as "size" argument.
+  // An empty buffer is returned in case of error.
+  Buffer read(uint64_t offset, uint32_t size, uint64_t limit);
+
+  // Drops the readahead data in [@offset, @offset + @size).
+  void invalidate(uint64_t offset, uint64_t size);
+
+  // Drops all the readahead data.
+  void reset();
+
+  // Exports read merging stats via CounterVisitor.
+  void getCounters(const CounterVisitor& visitor) const;
+
+ private:
+  // A device read in flight. [begin, end) is aligned to the device IO
+  // alignment and can grow until the read is issued.
+  struct PendingRead {
+    uint64_t begin{};
+    uint64_t end{};
+    bool issued{false};
+    bool done{false};
+    // valid once done; empty if the read failed
+    std::shared_ptr<const Buffer> buffer;
+  };
+
+  // Data kept from a read that was extended for readahead.
+  struct ReadaheadBuffer {
+    uint64_t begin{};
+    uint64_t end{};
+    std::shared_ptr<const Buffer> buffer;
+  };
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    std::mutex mutex;
+    // signaled whenever a pending read is done
+    std::condition_variable doneCv;
+    std::vector<std::shared_ptr<PendingRead>> pending;
+    // oldest first
+    std::deque<ReadaheadBuffer> readahead;
+    // reads that missed the readahead and are not done yet
+    uint32_t numReads{0};
+  };
+
+  static constexpr size_t kNumShards{64};
+
+  // Copies [@offset, @offset + @size) out of @buffer that starts at @begin.
+  static Buffer copyOut(const Buffer& buffer,
+                        uint64_t begin,
+                        uint64_t offset,
+                        uint32_t size);
+
+  Shard& getShard(uint64_t offset) {
+    return config_.shardSize == 0
+               ? shards_[0]
+               : shards_[offset / config_.shardSize % kNumShards];
+  }
+
+  // Returns the readahead buffer holding [@offset, @offset + @size), if any.
+  // Caller must hold the shard mutex.
+  static std::shared_ptr<const Buffer> findReadahead(const Shard& shard,
+                                                     uint64_t offset,
+                                                     uint32_t size,
+                                                     uint64_t& begin);
+
+  // Returns a read in flight that covers or can be extended to cover
+  // [@begin, @end), if any. Caller must hold the shard mutex.
+  std::shared_ptr<PendingRead> findPending(Shard& shard,
+                                           uint64_t begin,
+                                           uint64_t end) const;
+
+  Device& device_;
+  const Config config_;
+  const uint64_t alignment_{};
+  // readahead buffers kept per shard
+  const uint32_t numReadaheadBuffersPerShard_{};
+
+  std::array<Shard, kNumShards> shards_;
+
+  mutable AtomicCounter deviceReads_;
+  mutable AtomicCounter mergeHits_;
+  mutable AtomicCounter readaheadHits_;
+  mutable AtomicCounter readaheadBytes_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "cachelib/navy/common/CheckpointLog.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+constexpr uint32_t kBlockSize = 4096;
+// 8 blocks per stream
+constexpr uint64_t kLogSize = 16 * kBlockSize;
+constexpr uint64_t kBaseOffset = 2 * kBlockSize;
+constexpr uint64_t kDeviceSize = kBaseOffset + kLogSize;
+// records after the 32 byte block header
+constexpr uint64_t kRecordsPerBlock =
+    (kBlockSize - 32) / sizeof(CheckpointLog::Record);
+
+CheckpointLog::Record makeRemove(uint64_t keyHash) {
+  CheckpointLog::Record record;
+  record.type = CheckpointLog::RecordType::kRemove;
+  record.keyHash = keyHash;
+  return record;
+}
+
+std::vector<uint64_t> keyHashes(const std::vector<CheckpointLog::Record>& rs) {
+  std::vector<uint64_t> keys;
+  for (const auto& r : rs) {
+    keys.push_back(r.keyHash);
+  }
+  return keys;
+}
+} // namespace
+
+TEST(CheckpointLog, InvalidConfig) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  EXPECT_THROW(CheckpointLog(*device, kBaseOffset, 6 * kBlockSize),
+               std::invalid_argument);
+  EXPECT_THROW(CheckpointLog(*device, kBaseOffset + 1, kLogSize - kBlockSize),
+               std::invalid_argument);
+  EXPECT_NO_THROW(CheckpointLog(*device, kBaseOffset, 8 * kBlockSize));
+}
+
+TEST(CheckpointLog, RecoverCommitted) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    // Dropped: there is no checkpoint yet
+    log.append(makeRemove(1));
+    EXPECT_TRUE(log.needsCheckpoint());
+    log.begin(100);
+    log.append(makeRemove(2));
+    log.append(makeRemove(3));
+    EXPECT_TRUE(log.commit());
+    EXPECT_FALSE(log.needsCheckpoint());
+    log.append(makeRemove(4));
+    EXPECT_TRUE(log.sync());
+    // Not synced, lost
+    log.append(makeRemove(5));
+  }
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_FALSE(log.recover(200, records));
+  EXPECT_TRUE(log.recover(100, records));
+  EXPECT_EQ((std::vector<uint64_t>{2, 3, 4}), keyHashes(records));
+  EXPECT_EQ(CheckpointLog::RecordType::kRemove, records[0].type);
+  EXPECT_EQ(CheckpointLog::kNoRegion, records[0].regionId);
+
+  // Logging continues into the recovered checkpoint
+  log.append(makeRemove(6));
+  EXPECT_TRUE(log.sync());
+  CheckpointLog other{*device, kBaseOffset, kLogSize};
+  EXPECT_TRUE(other.recover(100, records));
+  EXPECT_EQ((std::vector<uint64_t>{2, 3, 4, 6}), keyHashes(records));
+}
+
+TEST(CheckpointLog, UncommittedCheckpoint) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    log.begin(100);
+    EXPECT_TRUE(log.commit());
+    log.append(makeRemove(1));
+    log.begin(200);
+    // Goes to the logs of both checkpoints
+    log.append(makeRemove(2));
+    EXPECT_TRUE(log.sync());
+  }
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_FALSE(log.recover(200, records));
+  EXPECT_TRUE(log.recover(100, records));
+  EXPECT_EQ((std::vector<uint64_t>{1, 2}), keyHashes(records));
+}
+
+TEST(CheckpointLog, CommitSwitchesLog) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    log.begin(100);
+    EXPECT_TRUE(log.commit());
+    log.append(makeRemove(1));
+    log.begin(200);
+    log.append(makeRemove(2));
+    EXPECT_TRUE(log.commit());
+    log.append(makeRemove(3));
+    EXPECT_TRUE(log.sync());
+    log.begin(300);
+    log.abort();
+    log.append(makeRemove(4));
+    EXPECT_TRUE(log.sync());
+  }
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_FALSE(log.recover(300, records));
+  EXPECT_TRUE(log.recover(200, records));
+  EXPECT_EQ((std::vector<uint64_t>{2, 3, 4}), keyHashes(records));
+}
+
+TEST(CheckpointLog, SyncUpTo) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    // Dropped: there is no checkpoint yet
+    EXPECT_EQ(0u, log.append(makeRemove(1)));
+    log.begin(100);
+    EXPECT_TRUE(log.commit());
+    const auto seq2 = log.append(makeRemove(2));
+    const auto seq3 = log.append(makeRemove(3));
+    EXPECT_LT(seq2, seq3);
+    // Writes both records
+    EXPECT_TRUE(log.syncUpTo(seq2));
+    EXPECT_TRUE(log.syncUpTo(seq3));
+    // Rewrites the partial block
+    EXPECT_TRUE(log.syncUpTo(log.append(makeRemove(4))));
+    EXPECT_FALSE(log.needsCheckpoint());
+  }
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_TRUE(log.recover(100, records));
+  EXPECT_EQ((std::vector<uint64_t>{2, 3, 4}), keyHashes(records));
+}
+
+TEST(CheckpointLog, ConcurrentSync) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  constexpr uint64_t kThreads = 4;
+  constexpr uint64_t kRecordsPerThread = 100;
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    log.begin(100);
+    EXPECT_TRUE(log.commit());
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < kThreads; t++) {
+      threads.emplace_back([&log, t] {
+        for (uint64_t i = 0; i < kRecordsPerThread; i++) {
+          const auto seq = log.append(makeRemove(t * kRecordsPerThread + i));
+          EXPECT_TRUE(log.syncUpTo(seq));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_TRUE(log.recover(100, records));
+  auto keys = keyHashes(records);
+  std::sort(keys.begin(), keys.end());
+  ASSERT_EQ(kThreads * kRecordsPerThread, keys.size());
+  for (uint64_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(i, keys[i]);
+  }
+}
+
+TEST(CheckpointLog, Overflow) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    log.begin(100);
+    EXPECT_TRUE(log.commit());
+    // The commit block and 3 blocks of records fill half of the log. Syncing
+    // rewrites the partial block, so it takes no block of its own.
+    uint64_t key = 0;
+    for (; key < 3 * kRecordsPerBlock; key++) {
+      EXPECT_FALSE(log.needsCheckpoint());
+      EXPECT_TRUE(log.syncUpTo(log.append(makeRemove(key))));
+    }
+    EXPECT_TRUE(log.needsCheckpoint());
+    for (; key < 6 * kRecordsPerBlock; key++) {
+      log.append(makeRemove(key));
+    }
+    EXPECT_TRUE(log.sync());
+    // The last block is taken by the overflow mark
+    log.append(makeRemove(key));
+    EXPECT_FALSE(log.sync());
+    EXPECT_TRUE(log.needsCheckpoint());
+  }
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_FALSE(log.recover(100, records));
+}
+
+TEST(CheckpointLog, TornBlock) {
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  {
+    CheckpointLog log{*device, kBaseOffset, kLogSize};
+    log.begin(100);
+    EXPECT_TRUE(log.commit());
+    for (uint64_t key = 0; key < kRecordsPerBlock; key++) {
+      log.append(makeRemove(key));
+    }
+    EXPECT_TRUE(log.sync());
+    log.append(makeRemove(kRecordsPerBlock));
+    EXPECT_TRUE(log.sync());
+  }
+
+  // The first checkpoint is logged to the second stream. Corrupt the record
+  // of its third block.
+  const uint64_t blockOffset = kBaseOffset + kLogSize / 2 + 2 * kBlockSize;
+  Buffer block{kBlockSize};
+  ASSERT_TRUE(device->read(blockOffset, kBlockSize, block.data()));
+  block.data()[kBlockSize / 2] ^= 0xff;
+  block.data()[40] ^= 0xff;
+  ASSERT_TRUE(device->write(blockOffset, std::move(block)));
+
+  CheckpointLog log{*device, kBaseOffset, kLogSize};
+  std::vector<CheckpointLog::Record> records;
+  EXPECT_TRUE(log.recover(100, records));
+  EXPECT_EQ(kRecordsPerBlock, records.size());
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
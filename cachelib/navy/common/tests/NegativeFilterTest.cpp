@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "cachelib/common/Hash.h"
+#include "cachelib/navy/common/NegativeFilter.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+double getCounter(const NegativeFilter& filter, folly::StringPiece counter) {
+  double value = 0;
+  filter.getCounters({[&](folly::StringPiece name, double count) {
+    if (name == counter) {
+      value = count;
+    }
+  }});
+  return value;
+}
+} // namespace
+
+TEST(NegativeFilter, InvalidConfig) {
+  EXPECT_THROW(NegativeFilter(32, 4), std::invalid_argument);
+  EXPECT_THROW(NegativeFilter(4096, 0), std::invalid_argument);
+  EXPECT_THROW(NegativeFilter(4096, NegativeFilter::kMaxNumHashes + 1),
+               std::invalid_argument);
+  NegativeFilter filter{4096 + 10, 4};
+  EXPECT_EQ(4096, filter.getByteSize());
+}
+
+TEST(NegativeFilter, AddRemove) {
+  NegativeFilter filter{64 * 1024, 4};
+  for (uint64_t i = 0; i < 1000; i++) {
+    EXPECT_FALSE(filter.couldExist(hashInt(i)));
+  }
+  for (uint64_t i = 0; i < 1000; i++) {
+    filter.add(hashInt(i));
+  }
+  for (uint64_t i = 0; i < 1000; i++) {
+    EXPECT_TRUE(filter.couldExist(hashInt(i)));
+  }
+  // Added twice, so one remove keeps the key
+  filter.add(hashInt(0));
+  filter.remove(hashInt(0));
+  EXPECT_TRUE(filter.couldExist(hashInt(0)));
+
+  for (uint64_t i = 0; i < 1000; i++) {
+    filter.remove(hashInt(i));
+  }
+  for (uint64_t i = 0; i < 1000; i++) {
+    EXPECT_FALSE(filter.couldExist(hashInt(i)));
+  }
+  EXPECT_EQ(0, getCounter(filter, "navy_neg_filter_saturated"));
+
+  filter.add(hashInt(1));
+  filter.reset();
+  EXPECT_FALSE(filter.couldExist(hashInt(1)));
+}
+
+TEST(NegativeFilter, UsesIndexBits) {
+  NegativeFilter filter{4096, 4};
+  const uint64_t keyHash = 0xabcd'1234'5678'9abcULL;
+  filter.add(keyHash);
+  // Same low 48 bits, as recovered from the BlockCache index
+  EXPECT_TRUE(filter.couldExist(keyHash & 0xffff'ffff'ffffULL));
+  filter.remove(keyHash & 0xffff'ffff'ffffULL);
+  EXPECT_FALSE(filter.couldExist(keyHash));
+}
+
+TEST(NegativeFilter, Saturation) {
+  // One block: every key shares the same counters
+  NegativeFilter filter{64, NegativeFilter::kMaxNumHashes};
+  for (uint64_t i = 0; i < 1000; i++) {
+    filter.add(hashInt(i));
+  }
+  EXPECT_GT(getCounter(filter, "navy_neg_filter_saturated"), 0);
+  for (uint64_t i = 0; i < 1000; i++) {
+    filter.remove(hashInt(i));
+  }
+  // Saturated counters are never decremented, so removes never cause false
+  // negatives for keys still in the filter
+  filter.add(hashInt(2000));
+  filter.remove(hashInt(1));
+  EXPECT_TRUE(filter.couldExist(hashInt(2000)));
+}
+
+TEST(NegativeFilter, FalsePositiveRate) {
+  // 8 counters per key
+  constexpr uint64_t kNumKeys{64 * 1024};
+  NegativeFilter filter{kNumKeys * 4, 5};
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    filter.add(hashInt(i));
+  }
+  uint64_t falsePositives = 0;
+  for (uint64_t i = kNumKeys; i < 2 * kNumKeys; i++) {
+    if (filter.couldExist(hashInt(i))) {
+      filter.recordFalsePositive();
+      falsePositives++;
+    }
+  }
+  EXPECT_LT(falsePositives, kNumKeys / 20);
+  EXPECT_EQ(falsePositives,
+            getCounter(filter, "navy_neg_filter_false_positives"));
+  EXPECT_EQ(kNumKeys - falsePositives,
+            getCounter(filter, "navy_neg_filter_negatives"));
+  EXPECT_DOUBLE_EQ(100.0 * falsePositives / kNumKeys,
+                   getCounter(filter, "navy_neg_filter_false_positive_pct"));
+}
+
+TEST(NegativeFilter, ConcurrentUpdates) {
+  NegativeFilter filter{16 * 1024, 4};
+  constexpr uint64_t kKeysPerThread{10000};
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < 4; t++) {
+    threads.emplace_back([&filter, t] {
+      for (uint64_t i = 0; i < kKeysPerThread; i++) {
+        filter.add(hashInt(t * kKeysPerThread + i));
+      }
+      for (uint64_t i = 0; i < kKeysPerThread; i += 2) {
+        filter.remove(hashInt(t * kKeysPerThread + i));
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (uint64_t i = 1; i < 4 * kKeysPerThread; i += 2) {
+    EXPECT_TRUE(filter.couldExist(hashInt(i)));
+  }
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "cachelib/navy/common/ReadMerger.h"
+#include "cachelib/navy/testing/MockDevice.h"
+
+using testing::_;
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+constexpr uint64_t kDeviceSize{64 * 1024};
+constexpr uint32_t kIOAlignSize{1024};
+
+uint8_t byteAt(uint64_t offset) {
+  return static_cast<uint8_t>(offset * 7 + offset / 256);
+}
+
+// Fills the device so that reads at different offsets tell apart.
+void fillDevice(MockDevice& device) {
+  auto buffer = device.makeIOBuffer(kDeviceSize);
+  for (uint64_t i = 0; i < kDeviceSize; i++) {
+    buffer.data()[i] = byteAt(i);
+  }
+  ASSERT_TRUE(device.getRealDeviceRef().write(0, std::move(buffer)));
+}
+
+void expectData(const Buffer& buffer, uint64_t offset, uint32_t size) {
+  Buffer expected{size};
+  for (uint32_t i = 0; i < size; i++) {
+    expected.data()[i] = byteAt(offset + i);
+  }
+  EXPECT_EQ(expected.view(), buffer.view());
+}
+
+double getCounter(const ReadMerger& merger, folly::StringPiece counter) {
+  double value = 0;
+  merger.getCounters({[&](folly::StringPiece name, double count) {
+    if (name == counter) {
+      value = count;
+    }
+  }});
+  return value;
+}
+} // namespace
+
+TEST(ReadMerger, InvalidConfig) {
+  ReadMerger::Config config;
+  config.readaheadSize = 2 * config.maxMergeSize;
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+  config.readaheadSize = 8 * 1024;
+  config.numReadaheadBuffers = 0;
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+  config.numReadaheadBuffers = 1;
+  config.mergeWindow = std::chrono::microseconds{-1};
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+  config.mergeWindow = std::chrono::microseconds{10};
+  EXPECT_NO_THROW(config.validate());
+}
+
+TEST(ReadMerger, UnalignedRead) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger merger{device, ReadMerger::Config{}};
+
+  EXPECT_CALL(device, readImpl(1024, 2048, _));
+  expectData(merger.read(1500, 1000, kDeviceSize), 1500, 1000);
+  EXPECT_EQ(1, getCounter(merger, "navy_read_merge_device_reads"));
+  EXPECT_EQ(0, getCounter(merger, "navy_read_merge_hits"));
+}
+
+TEST(ReadMerger, Readahead) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger::Config config;
+  config.readaheadSize = 8 * 1024;
+  ReadMerger merger{device, std::move(config)};
+  const uint64_t limit = 32 * 1024;
+
+  testing::InSequence seq;
+  EXPECT_CALL(device, readImpl(0, 8 * 1024, _));
+  EXPECT_CALL(device, readImpl(7 * 1024, 8 * 1024, _));
+  // Readahead stops at the limit
+  EXPECT_CALL(device, readImpl(30 * 1024, 2 * 1024, _));
+
+  expectData(merger.read(100, 500, limit), 100, 500);
+  // Served from the readahead
+  expectData(merger.read(4096, 1024, limit), 4096, 1024);
+  // Goes past the readahead
+  expectData(merger.read(8000, 1000, limit), 8000, 1000);
+  expectData(merger.read(30 * 1024, 512, limit), 30 * 1024, 512);
+
+  EXPECT_EQ(3, getCounter(merger, "navy_read_merge_device_reads"));
+  EXPECT_EQ(1, getCounter(merger, "navy_readahead_hits"));
+  EXPECT_EQ(7 * 1024 + 6 * 1024 + 1024,
+            getCounter(merger, "navy_readahead_bytes"));
+}
+
+TEST(ReadMerger, Invalidate) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger::Config config;
+  config.readaheadSize = 8 * 1024;
+  ReadMerger merger{device, std::move(config)};
+
+  EXPECT_CALL(device, readImpl(0, 8 * 1024, _)).Times(3);
+  expectData(merger.read(0, 100, kDeviceSize), 0, 100);
+  expectData(merger.read(2048, 100, kDeviceSize), 2048, 100);
+  EXPECT_EQ(1, getCounter(merger, "navy_readahead_hits"));
+
+  // Dropped since it overlaps the readahead buffer
+  merger.invalidate(4096, 1024);
+  expectData(merger.read(2048, 100, kDeviceSize), 2048, 100);
+  // Does not overlap
+  merger.invalidate(8 * 1024, 1024);
+  expectData(merger.read(0, 100, kDeviceSize), 0, 100);
+  EXPECT_EQ(2, getCounter(merger, "navy_readahead_hits"));
+
+  merger.reset();
+  expectData(merger.read(0, 100, kDeviceSize), 0, 100);
+  EXPECT_EQ(2, getCounter(merger, "navy_readahead_hits"));
+}
+
+TEST(ReadMerger, SharesReadInFlight) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger merger{device, ReadMerger::Config{}};
+
+  // The first read is held until the second one waits for it
+  std::atomic<bool> inFlight{false};
+  EXPECT_CALL(device, readImpl(0, 4096, _))
+      .WillOnce(testing::Invoke([&](uint64_t offset, uint32_t size, void* buf) {
+        inFlight = true;
+        while (getCounter(merger, "navy_read_merge_hits") == 0) {
+          std::this_thread::yield();
+        }
+        return device.getRealDeviceRef().read(offset, size, buf);
+      }));
+
+  std::thread leader{[&merger] {
+    expectData(merger.read(0, 4096, kDeviceSize), 0, 4096);
+  }};
+  while (!inFlight) {
+    std::this_thread::yield();
+  }
+  expectData(merger.read(1500, 1024, kDeviceSize), 1500, 1024);
+  leader.join();
+
+  EXPECT_EQ(1, getCounter(merger, "navy_read_merge_device_reads"));
+  EXPECT_EQ(1, getCounter(merger, "navy_read_merge_hits"));
+}
+
+TEST(ReadMerger, MergesAdjacentReads) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger::Config config;
+  config.mergeWindow = std::chrono::milliseconds{500};
+  ReadMerger merger{device, std::move(config)};
+
+  // A read held in flight, so that the leader waits for reads to merge with
+  std::atomic<bool> inFlight{false};
+  std::atomic<bool> release{false};
+  EXPECT_CALL(device, readImpl(32 * 1024, 4096, _))
+      .WillOnce(testing::Invoke([&](uint64_t offset, uint32_t size, void* buf) {
+        inFlight = true;
+        while (!release) {
+          std::this_thread::yield();
+        }
+        return device.getRealDeviceRef().read(offset, size, buf);
+      }));
+  std::thread other{[&merger] {
+    expectData(merger.read(32 * 1024, 4096, kDeviceSize), 32 * 1024, 4096);
+  }};
+  while (!inFlight) {
+    std::this_thread::yield();
+  }
+
+  EXPECT_CALL(device, readImpl(0, 8 * 1024, _));
+  std::thread leader{[&merger] {
+    expectData(merger.read(0, 4096, kDeviceSize), 0, 4096);
+  }};
+  // Arrives within the merge window of the first read
+  std::this_thread::sleep_for(std::chrono::milliseconds{50});
+  expectData(merger.read(4096, 4096, kDeviceSize), 4096, 4096);
+  leader.join();
+  release = true;
+  other.join();
+
+  EXPECT_EQ(2, getCounter(merger, "navy_read_merge_device_reads"));
+  EXPECT_EQ(1, getCounter(merger, "navy_read_merge_hits"));
+}
+
+TEST(ReadMerger, LoneReadSkipsMergeWindow) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger::Config config;
+  config.mergeWindow = std::chrono::seconds{60};
+  ReadMerger merger{device, std::move(config)};
+
+  EXPECT_CALL(device, readImpl(0, 4096, _));
+  const auto start = std::chrono::steady_clock::now();
+  expectData(merger.read(0, 4096, kDeviceSize), 0, 4096);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds{30});
+}
+
+TEST(ReadMerger, ShardsByRange) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  fillDevice(device);
+  ReadMerger::Config config;
+  config.readaheadSize = 8 * 1024;
+  config.shardSize = 16 * 1024;
+  ReadMerger merger{device, std::move(config)};
+
+  // Each read is extended within its own shard
+  EXPECT_CALL(device, readImpl(0, 8 * 1024, _)).Times(2);
+  EXPECT_CALL(device, readImpl(16 * 1024, 8 * 1024, _));
+  expectData(merger.read(0, 100, 16 * 1024), 0, 100);
+  expectData(merger.read(16 * 1024, 100, 32 * 1024), 16 * 1024, 100);
+  expectData(merger.read(2048, 100, 16 * 1024), 2048, 100);
+  expectData(merger.read(18 * 1024, 100, 32 * 1024), 18 * 1024, 100);
+  EXPECT_EQ(2, getCounter(merger, "navy_readahead_hits"));
+
+  // Only the readahead of the first shard is dropped
+  merger.invalidate(0, 16 * 1024);
+  expectData(merger.read(2048, 100, 16 * 1024), 2048, 100);
+  expectData(merger.read(18 * 1024, 100, 32 * 1024), 18 * 1024, 100);
+  EXPECT_EQ(3, getCounter(merger, "navy_readahead_hits"));
+}
+
+TEST(ReadMerger, ReadError) {
+  MockDevice device{kDeviceSize, kIOAlignSize};
+  ReadMerger::Config config;
+  config.readaheadSize = 8 * 1024;
+  ReadMerger merger{device, std::move(config)};
+
+  EXPECT_CALL(device, readImpl(0, 8 * 1024, _))
+      .WillOnce(testing::Return(false))
+      .WillOnce(testing::Return(true));
+  EXPECT_TRUE(merger.read(0, 1024, kDeviceSize).isNull());
+  // Nothing was kept from the failed read
+  EXPECT_EQ(1024, merger.read(0, 1024, kDeviceSize).size());
+  EXPECT_EQ(0, getCounter(merger, "navy_readahead_hits"));
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -20,10 +20,14 @@
 #include <folly/Range.h>
 #include <folly/synchronization/Baton.h>
 
+#include <algorithm>
+
 #include "cachelib/common/Serialization.h"
 #include "cachelib/navy/admission_policy/DynamicRandomAP.h"
 #include "cachelib/navy/common/Hash.h"
+#include "cachelib/navy/common/Utils.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
+#include "cachelib/navy/serialization/Serialization.h"
 
 namespace facebook {
 namespace cachelib {
@@ -39,6 +43,23 @@ std::discrete_distribution<size_t> getDist(
   }
   return std::discrete_distribution<size_t>(sizes.begin(), sizes.end());
 }
+
+// How often the checkpoint thread syncs the checkpoint log and checks
+// whether a checkpoint is due.
+constexpr std::chrono::seconds kCheckpointTick{1};
+
+// Size of each of the two checkpoint slots that precede the checkpoint log in
+// the metadata. 0 if checkpoints are disabled or do not fit.
+uint64_t getCheckpointSlotSize(const Driver::Config& config) {
+  if (config.checkpointLogSize == 0 || !config.device ||
+      config.checkpointLogSize >= config.metadataSize) {
+    return 0;
+  }
+  const uint64_t blockSize =
+      std::max<uint64_t>(config.device->getIOAlignmentSize(), 4096);
+  return (config.metadataSize - config.checkpointLogSize) / 2 / blockSize *
+         blockSize;
+}
 } // namespace
 
 Driver::Config& Driver::Config::validate() {
@@ -52,6 +73,24 @@ Driver::Config& Driver::Config::validate() {
   if (enginePairs.size() > 1 && (!selector)) {
     throw std::invalid_argument("More than one engine pairs with no selector.");
   }
+  if (negativeFilterSize > 0 &&
+      (negativeFilterNumHashes == 0 ||
+       negativeFilterNumHashes > NegativeFilter::kMaxNumHashes)) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid number of negative filter hashes {}",
+                       negativeFilterNumHashes));
+  }
+  if (checkpointLogSize > 0) {
+    if (getCheckpointSlotSize(*this) == 0) {
+      throw std::invalid_argument(folly::sformat(
+          "Metadata size {} is too small for a checkpoint log of {} bytes",
+          metadataSize,
+          checkpointLogSize));
+    }
+    if (checkpointInterval.count() <= 0) {
+      throw std::invalid_argument("Checkpoint interval must be positive.");
+    }
+  }
   return *this;
 }
 
@@ -62,6 +101,8 @@ Driver::Driver(Config&& config, ValidConfigTag)
     : maxConcurrentInserts_{config.maxConcurrentInserts},
       maxParcelMemory_{config.maxParcelMemory},
       metadataSize_{config.metadataSize},
+      checkpointSlotSize_{getCheckpointSlotSize(config)},
+      checkpointInterval_{config.checkpointInterval},
       device_{std::move(config.device)},
       scheduler_{std::move(config.scheduler)},
       selector_{std::move(config.selector)},
@@ -70,9 +111,30 @@ Driver::Driver(Config&& config, ValidConfigTag)
   getRandomAllocDist = getDist(enginePairs_);
   XLOGF(INFO, "Max concurrent inserts: {}", maxConcurrentInserts_);
   XLOGF(INFO, "Max parcel memory: {}", maxParcelMemory_);
+  if (config.negativeFilterSize > 0) {
+    negativeFilter_ = std::make_unique<NegativeFilter>(
+        config.negativeFilterSize, config.negativeFilterNumHashes);
+    for (auto& p : enginePairs_) {
+      p.setNegativeFilter(negativeFilter_.get());
+    }
+  }
+  if (checkpointSlotSize_ > 0) {
+    checkpointLog_ =
+        std::make_unique<CheckpointLog>(*device_,
+                                        2 * checkpointSlotSize_,
+                                        metadataSize_ - 2 * checkpointSlotSize_);
+    for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
+      enginePairs_[idx].setCheckpointLog(checkpointLog_.get(), idx);
+    }
+    XLOGF(INFO,
+          "Checkpoint every {}s, slot size: {}",
+          checkpointInterval_.count(),
+          checkpointSlotSize_);
+  }
 }
 
 Driver::~Driver() {
+  stopCheckpointThread();
   XLOG(INFO, "Driver: finish scheduler");
   scheduler_->finish();
   XLOG(INFO, "Driver: finish scheduler successful");
@@ -93,7 +155,14 @@ bool Driver::isItemLarge(HashedKey key, BufferView value) const {
 }
 
 bool Driver::couldExist(HashedKey hk) {
-  return enginePairs_[selectEnginePair(hk)].couldExist(hk);
+  if (negativeFilter_ && !negativeFilter_->couldExist(hk.keyHash())) {
+    return false;
+  }
+  const bool couldExist = enginePairs_[selectEnginePair(hk)].couldExist(hk);
+  if (negativeFilter_ && !couldExist) {
+    negativeFilter_->recordFalsePositive();
+  }
+  return couldExist;
 }
 
 Status Driver::insert(HashedKey key, BufferView value) {
@@ -167,15 +236,154 @@ Status Driver::insertAsync(HashedKey hk, BufferView value, InsertCallback cb) {
   return Status::Ok;
 }
 
+void Driver::insertBatchAsync(const std::vector<HashedKey>& keys,
+                              const std::vector<BufferView>& values,
+                              std::vector<InsertCallback> cbs) {
+  XDCHECK_EQ(keys.size(), values.size());
+  XDCHECK_EQ(keys.size(), cbs.size());
+  std::vector<HashedKey> rejectedKeys;
+  std::vector<InsertCallback> rejectedCbs;
+  std::vector<std::vector<HashedKey>> pairKeys(enginePairs_.size());
+  std::vector<std::vector<BufferView>> pairValues(enginePairs_.size());
+  std::vector<std::vector<InsertCallback>> pairCbs(enginePairs_.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    const auto hk = keys[i];
+    const auto value = values[i];
+    if (hk.key().size() > kMaxKeySize) {
+      rejectedCount_.inc();
+      rejectedBytes_.add(hk.key().size() + value.size());
+      rejectedKeys.push_back(hk);
+      rejectedCbs.push_back(std::move(cbs[i]));
+      continue;
+    }
+    if (!admissionTest(hk, value)) {
+      rejectedKeys.push_back(hk);
+      rejectedCbs.push_back(std::move(cbs[i]));
+      continue;
+    }
+
+    const auto idx = selectEnginePair(hk);
+    pairKeys[idx].push_back(hk);
+    pairValues[idx].push_back(value);
+    pairCbs[idx].push_back(
+        [this, totalSize = hk.key().size() + value.size(),
+         cb = std::move(cbs[i])](Status s, HashedKey hashedKey) mutable {
+          if (cb) {
+            cb(s, hashedKey);
+          }
+          parcelMemory_.sub(totalSize);
+          concurrentInserts_.dec();
+        });
+  }
+  for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
+    if (!pairKeys[idx].empty()) {
+      enginePairs_[idx].scheduleInsertBatch(std::move(pairKeys[idx]),
+                                            std::move(pairValues[idx]),
+                                            std::move(pairCbs[idx]));
+    }
+  }
+  // complete the rejected entries on a worker thread like the accepted ones
+  if (!rejectedKeys.empty()) {
+    scheduler_->enqueue(
+        [keys = std::move(rejectedKeys),
+         cbs = std::move(rejectedCbs)]() mutable {
+          for (size_t i = 0; i < keys.size(); i++) {
+            if (cbs[i]) {
+              cbs[i](Status::Rejected, keys[i]);
+            }
+          }
+          return JobExitCode::Done;
+        },
+        "insertBatchRejected",
+        JobType::Write);
+  }
+}
+
 Status Driver::lookup(HashedKey hk, Buffer& value) {
-  return enginePairs_[selectEnginePair(hk)].lookupSync(hk, value);
+  if (negativeFilter_ && !negativeFilter_->couldExist(hk.keyHash())) {
+    return Status::NotFound;
+  }
+  const auto status = enginePairs_[selectEnginePair(hk)].lookupSync(hk, value);
+  if (negativeFilter_ && status == Status::NotFound) {
+    negativeFilter_->recordFalsePositive();
+  }
+  return status;
+}
+
+bool Driver::filterLookup(HashedKey hk, LookupCallback& cb) {
+  if (!negativeFilter_) {
+    return true;
+  }
+  if (!negativeFilter_->couldExist(hk.keyHash())) {
+    return false;
+  }
+  cb = [this, cb = std::move(cb)](Status s, HashedKey key,
+                                  Buffer value) mutable {
+    if (s == Status::NotFound) {
+      negativeFilter_->recordFalsePositive();
+    }
+    cb(s, key, std::move(value));
+  };
+  return true;
 }
 
 void Driver::lookupAsync(HashedKey hk, LookupCallback cb) {
   XDCHECK(cb);
+  if (!filterLookup(hk, cb)) {
+    cb(Status::NotFound, hk, Buffer{});
+    return;
+  }
   enginePairs_[selectEnginePair(hk)].scheduleLookup(hk, std::move(cb));
 }
 
+void Driver::lookupBatchAsync(std::vector<HashedKey> keys,
+                              std::vector<LookupCallback> cbs) {
+  XDCHECK_EQ(keys.size(), cbs.size());
+  if (keys.empty()) {
+    return;
+  }
+  if (negativeFilter_) {
+    // Answer the keys the filter rules out and keep the rest in place
+    size_t numKept = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+      XDCHECK(cbs[i]);
+      if (!filterLookup(keys[i], cbs[i])) {
+        cbs[i](Status::NotFound, keys[i], Buffer{});
+        continue;
+      }
+      if (numKept != i) {
+        keys[numKept] = keys[i];
+        cbs[numKept] = std::move(cbs[i]);
+      }
+      numKept++;
+    }
+    if (numKept == 0) {
+      return;
+    }
+    keys.erase(keys.begin() + numKept, keys.end());
+    cbs.erase(cbs.begin() + numKept, cbs.end());
+  }
+  if (enginePairs_.size() == 1) {
+    enginePairs_[0].scheduleLookupBatch(std::move(keys), std::move(cbs));
+    return;
+  }
+
+  std::vector<std::vector<HashedKey>> pairKeys(enginePairs_.size());
+  std::vector<std::vector<LookupCallback>> pairCbs(enginePairs_.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    XDCHECK(cbs[i]);
+    const auto idx = selectEnginePair(keys[i]);
+    pairKeys[idx].push_back(keys[i]);
+    pairCbs[idx].push_back(std::move(cbs[i]));
+  }
+  for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
+    if (!pairKeys[idx].empty()) {
+      enginePairs_[idx].scheduleLookupBatch(std::move(pairKeys[idx]),
+                                            std::move(pairCbs[idx]));
+    }
+  }
+}
+
 Status Driver::remove(HashedKey hk) {
   return enginePairs_[selectEnginePair(hk)].removeSync(hk);
 }
@@ -193,6 +401,10 @@ void Driver::flush() {
 
 void Driver::reset() {
   XLOG(INFO, "Reset Navy");
+  std::unique_lock<std::mutex> lock{checkpointMutex_, std::defer_lock};
+  if (checkpointLog_) {
+    lock.lock();
+  }
   scheduler_->finish();
   for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
     enginePairs_[idx].reset();
@@ -200,9 +412,32 @@ void Driver::reset() {
   if (admissionPolicy_) {
     admissionPolicy_->reset();
   }
+  if (negativeFilter_) {
+    negativeFilter_->reset();
+  }
+  if (checkpointLog_) {
+    // No checkpoint matches the engines anymore
+    checkpointLog_->clear();
+    for (uint32_t slot = 0; slot < 2; slot++) {
+      createMetadataRecordWriter(
+          *device_, checkpointSlotSize_, slot * checkpointSlotSize_)
+          ->invalidate();
+    }
+    checkpointSlot_ = 1;
+    checkpointGeneration_ = 0;
+    lock.unlock();
+    startCheckpointThread();
+  }
 }
 
 void Driver::persist() const {
+  if (checkpointLog_) {
+    stopCheckpointThread();
+    if (!checkpoint(true /* clean */)) {
+      throw std::runtime_error("Failed to checkpoint navy");
+    }
+    return;
+  }
   auto rw = createMetadataRecordWriter(*device_, metadataSize_);
   if (rw) {
     for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
@@ -211,7 +446,169 @@ void Driver::persist() const {
   }
 }
 
+bool Driver::checkpoint(bool clean) const {
+  std::lock_guard<std::mutex> lock{checkpointMutex_};
+  const auto startTime = getSteadyClock();
+  const uint32_t slot = 1 - checkpointSlot_;
+  uint64_t checkpointId = folly::Random::rand64();
+  if (checkpointId == 0) {
+    checkpointId = 1;
+  }
+  serialization::CheckpointHeader header;
+  *header.checkpointId() = static_cast<int64_t>(checkpointId);
+  *header.generation() = static_cast<int64_t>(checkpointGeneration_ + 1);
+  *header.clean() = clean;
+
+  // Changes made from now on go to the log of the new checkpoint.
+  checkpointLog_->begin(checkpointId);
+  try {
+    {
+      auto rw = createMetadataRecordWriter(
+          *device_, checkpointSlotSize_, slot * checkpointSlotSize_);
+      serializeProto(header, *rw);
+      for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
+        enginePairs_[idx].persist(*rw);
+      }
+    }
+    // The checkpoint and the regions it refers to have to be on the device
+    // before it is committed.
+    device_->flush();
+    if (!checkpointLog_->commit()) {
+      throw std::runtime_error("failed to commit the checkpoint log");
+    }
+  } catch (const std::exception& e) {
+    checkpointLog_->abort();
+    checkpointErrorCount_.inc();
+    XLOGF(ERR, "Failed to checkpoint navy: {}", e.what());
+    return false;
+  }
+  checkpointSlot_ = slot;
+  checkpointGeneration_++;
+  checkpointCount_.inc();
+  checkpointDurationUs_.set(toMicros(getSteadyClock() - startTime).count());
+  XLOGF(DBG,
+        "Navy checkpoint {} (generation {}, clean: {}) written to slot {}",
+        checkpointId,
+        checkpointGeneration_,
+        clean,
+        slot);
+  return true;
+}
+
+bool Driver::recoverCheckpoint() {
+  std::lock_guard<std::mutex> lock{checkpointMutex_};
+  std::vector<std::pair<serialization::CheckpointHeader, uint32_t>> headers;
+  for (uint32_t slot = 0; slot < 2; slot++) {
+    try {
+      auto rr = createMetadataRecordReader(
+          *device_, checkpointSlotSize_, slot * checkpointSlotSize_);
+      if (!rr->isEnd()) {
+        headers.emplace_back(
+            deserializeProto<serialization::CheckpointHeader>(*rr), slot);
+      }
+    } catch (const std::exception& e) {
+      XLOGF(ERR, "Invalid checkpoint in slot {}: {}", slot, e.what());
+    }
+  }
+  // Newest checkpoint first
+  std::sort(headers.begin(), headers.end(), [](const auto& a, const auto& b) {
+    return *a.first.generation() > *b.first.generation();
+  });
+
+  for (const auto& [header, slot] : headers) {
+    const auto checkpointId = static_cast<uint64_t>(*header.checkpointId());
+    std::vector<CheckpointLog::Record> records;
+    if (!checkpointLog_->recover(checkpointId, records)) {
+      XLOGF(ERR, "Log of checkpoint {} is incomplete", checkpointId);
+      continue;
+    }
+    bool recovered = true;
+    if (negativeFilter_) {
+      // The engines add the keys they recover
+      negativeFilter_->reset();
+    }
+    try {
+      auto rr = createMetadataRecordReader(
+          *device_, checkpointSlotSize_, slot * checkpointSlotSize_);
+      deserializeProto<serialization::CheckpointHeader>(*rr);
+      for (size_t idx = 0; recovered && idx < enginePairs_.size(); idx++) {
+        recovered = enginePairs_[idx].recover(*rr);
+      }
+      // A clean checkpoint has no log unless navy ran after it was taken
+      const bool replay = !*header.clean() || !records.empty();
+      for (size_t idx = 0; replay && recovered && idx < enginePairs_.size();
+           idx++) {
+        recovered = enginePairs_[idx].replayCheckpointLog(records);
+      }
+    } catch (const std::exception& e) {
+      XLOGF(ERR, "Exception: {}", e.what());
+      recovered = false;
+    }
+    if (recovered) {
+      checkpointSlot_ = slot;
+      checkpointGeneration_ = static_cast<uint64_t>(*header.generation());
+      XLOGF(INFO,
+            "Recovered navy checkpoint {} (clean: {}) with {} log records",
+            checkpointId,
+            *header.clean(),
+            records.size());
+      return true;
+    }
+    for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
+      enginePairs_[idx].reset();
+    }
+  }
+  return false;
+}
+
+void Driver::startCheckpointThread() {
+  std::lock_guard<std::mutex> lock{checkpointThreadMutex_};
+  if (checkpointThread_.joinable()) {
+    return;
+  }
+  stopCheckpoints_ = false;
+  checkpointThread_ = std::thread{[this] { checkpointLoop(); }};
+}
+
+void Driver::stopCheckpointThread() const {
+  {
+    std::lock_guard<std::mutex> lock{checkpointThreadMutex_};
+    stopCheckpoints_ = true;
+  }
+  checkpointCv_.notify_all();
+  if (checkpointThread_.joinable()) {
+    checkpointThread_.join();
+  }
+}
+
+void Driver::checkpointLoop() {
+  auto lastCheckpoint = getSteadyClockSeconds();
+  std::unique_lock<std::mutex> lock{checkpointThreadMutex_};
+  while (!checkpointCv_.wait_for(
+      lock, kCheckpointTick, [this] { return stopCheckpoints_; })) {
+    lock.unlock();
+    // Removes are synced as they complete. This writes the region records
+    // buffered since the last tick.
+    checkpointLog_->sync();
+    const auto now = getSteadyClockSeconds();
+    if (now - lastCheckpoint >= checkpointInterval_ ||
+        checkpointLog_->needsCheckpoint()) {
+      checkpoint(false /* clean */);
+      lastCheckpoint = now;
+    }
+    lock.lock();
+  }
+}
+
 bool Driver::recover() {
+  if (checkpointLog_) {
+    const bool recovered = recoverCheckpoint();
+    if (!recovered) {
+      reset();
+    }
+    startCheckpointThread();
+    return recovered;
+  }
   auto rr = createMetadataRecordReader(*device_, metadataSize_);
   if (!rr) {
     return false;
@@ -219,6 +616,10 @@ bool Driver::recover() {
   if (rr->isEnd()) {
     return false;
   }
+  if (negativeFilter_) {
+    // The engines add the keys they recover
+    negativeFilter_->reset();
+  }
   // Because we insert item and remove from the other engine, partial recovery
   // is potentially possible.
   bool recovered = true;
@@ -281,6 +682,19 @@ void Driver::getCounters(const CounterVisitor& visitor) const {
   visitor("navy_parcel_memory", parcelMemory_.get());
   visitor("navy_concurrent_inserts", concurrentInserts_.get());
 
+  if (checkpointLog_) {
+    visitor("navy_checkpoints", checkpointCount_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_checkpoint_errors", checkpointErrorCount_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_checkpoint_duration_us", checkpointDurationUs_.get());
+    checkpointLog_->getCounters(visitor);
+  }
+
+  if (negativeFilter_) {
+    negativeFilter_->getCounters(visitor);
+  }
+
   scheduler_->getCounters(visitor);
   if (enginePairs_.size() > 1) {
     for (size_t idx = 0; idx < enginePairs_.size(); idx++) {
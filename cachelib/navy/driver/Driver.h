@@ -18,8 +18,12 @@
 
 #include <gtest/gtest_prod.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include "cachelib/common/AtomicCounter.h"
@@ -27,7 +31,9 @@
 #include "cachelib/navy/AbstractCache.h"
 #include "cachelib/navy/admission_policy/AdmissionPolicy.h"
 #include "cachelib/navy/common/Buffer.h"
+#include "cachelib/navy/common/CheckpointLog.h"
 #include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/NegativeFilter.h"
 #include "cachelib/navy/engine/Engine.h"
 #include "cachelib/navy/engine/EnginePair.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
@@ -52,6 +58,16 @@ class Driver final : public AbstractCache {
     uint32_t maxConcurrentInserts{1'000'000};
     uint64_t maxParcelMemory{256 << 20}; // 256MB
     size_t metadataSize{};
+    // Size of the checkpoint log at the end of the metadata. If set, the
+    // engines state is checkpointed into the metadata every
+    // @checkpointInterval while navy is running, so that it can be recovered
+    // after an unclean shutdown.
+    uint64_t checkpointLogSize{};
+    std::chrono::seconds checkpointInterval{};
+    // Size of the negative filter that answers lookups of keys not in any
+    // engine without going to the engines. 0 disables the filter.
+    uint64_t negativeFilterSize{};
+    uint32_t negativeFilterNumHashes{4};
 
     EnginePairSelector selector{};
 
@@ -76,6 +92,7 @@ class Driver final : public AbstractCache {
   // synchronous fast lookup if a key probably exists in the cache,
   // it can return a false positive result. this provides an optimization
   // to skip the heavy lookup operation when key doesn't exist in the cache.
+  // With the negative filter, most missing keys are answered by the filter.
   bool couldExist(HashedKey key) override;
 
   // insert a key and value into the cache
@@ -94,19 +111,42 @@ class Driver final : public AbstractCache {
                      BufferView value,
                      InsertCallback cb) override;
 
-  // lookup a key in the cache.
+  // insert a batch of keys and values into the cache asynchronously. Entries
+  // are grouped by engine pair and each group is inserted by one job.
+  // @param keys    the item keys
+  // @param values  the item values
+  // @param cbs     callbacks triggered when the insertion of the entry at the
+  //                same index completes, with Rejected if the entry is not
+  //                admitted
+  void insertBatchAsync(
+      const std::vector<HashedKey>& keys,
+      const std::vector<BufferView>& values,
+      std::vector<InsertCallback> cbs) override;
+
+  // lookup a key in the cache. Keys ruled out by the negative filter are
+  // not looked up in the engines.
   // @param key    the item key to lookup
   // @param value  the returned value for the key if found
   // @return       a status indicates success or failure, and the reason for
   //               failure
   Status lookup(HashedKey key, Buffer& value) override;
 
-  // lookup a key in the cache asynchronously.
+  // lookup a key in the cache asynchronously. Keys ruled out by the
+  // negative filter complete with NotFound inline, on the calling thread.
   // @param key  the item key to lookup
   // @param cb   a callback function be triggered when the lookup complete,
   //             the result will be provided to the function.
   void lookupAsync(HashedKey key, LookupCallback cb) override;
 
+  // lookup a batch of keys in the cache asynchronously. Keys are grouped by
+  // engine pair and each group is looked up by one job. Keys ruled out by
+  // the negative filter complete with NotFound inline.
+  // @param keys  the item keys to lookup
+  // @param cbs   callbacks triggered with the result of the key at the same
+  //              index when its lookup completes.
+  void lookupBatchAsync(std::vector<HashedKey> keys,
+                        std::vector<LookupCallback> cbs) override;
+
   // remove the key from cache
   // @param key  the item key to be removed
   // @return a status indicates success or failure, and the reason for failure
@@ -124,10 +164,13 @@ class Driver final : public AbstractCache {
   // Reset navy cache to the initial state.
   void reset() override;
 
-  // persist the navy engines state
+  // persist the navy engines state. With checkpoints enabled, this takes a
+  // final checkpoint that is recovered without replaying its log.
   void persist() const override;
 
-  // recover the navy engines state
+  // recover the navy engines state. With checkpoints enabled, this recovers
+  // the last complete checkpoint and replays its log, then starts taking
+  // checkpoints periodically.
   bool recover() override;
 
   // returns the size of the device
@@ -158,11 +201,33 @@ class Driver final : public AbstractCache {
 
   void updateLookupStats(Status status) const;
   bool admissionTest(HashedKey hk, BufferView value) const;
+
+  // Returns false if the negative filter rules out @hk. Otherwise wraps @cb
+  // so that a NotFound result is recorded as a filter false positive.
+  bool filterLookup(HashedKey hk, LookupCallback& cb);
   size_t selectEnginePair(HashedKey hk) const;
 
+  // Writes the engines state into the checkpoint slot not holding the last
+  // committed checkpoint and commits it. A @clean checkpoint is taken with
+  // no operations in flight. Returns true on success.
+  bool checkpoint(bool clean) const;
+
+  // Recovers the engines from the newest checkpoint that is complete,
+  // falling back to the older one. Returns true on success.
+  bool recoverCheckpoint();
+
+  // Starts the thread taking checkpoints if it is not running.
+  void startCheckpointThread();
+  void stopCheckpointThread() const;
+  void checkpointLoop();
+
   const uint32_t maxConcurrentInserts_{};
   const uint64_t maxParcelMemory_{};
   const size_t metadataSize_{};
+  // With checkpoints enabled, the metadata holds two checkpoint slots of
+  // @checkpointSlotSize_ followed by the checkpoint log.
+  const uint64_t checkpointSlotSize_{};
+  const std::chrono::seconds checkpointInterval_{};
 
   std::unique_ptr<Device> device_;
   std::unique_ptr<JobScheduler> scheduler_;
@@ -187,6 +252,24 @@ class Driver final : public AbstractCache {
   mutable AtomicCounter parcelMemory_; // In bytes
   mutable AtomicCounter concurrentInserts_;
 
+  // nullptr if the negative filter is disabled
+  std::unique_ptr<NegativeFilter> negativeFilter_;
+
+  // nullptr if checkpoints are disabled
+  std::unique_ptr<CheckpointLog> checkpointLog_;
+  // serializes checkpoints, recovery and reset
+  mutable std::mutex checkpointMutex_;
+  // slot and generation of the last committed checkpoint
+  mutable uint32_t checkpointSlot_{1};
+  mutable uint64_t checkpointGeneration_{0};
+  mutable std::thread checkpointThread_;
+  mutable std::mutex checkpointThreadMutex_;
+  mutable std::condition_variable checkpointCv_;
+  mutable bool stopCheckpoints_{false};
+  mutable AtomicCounter checkpointCount_;
+  mutable AtomicCounter checkpointErrorCount_;
+  mutable AtomicCounter checkpointDurationUs_;
+
   FRIEND_TEST(Driver, MultiRecovery);
 };
 } // namespace navy
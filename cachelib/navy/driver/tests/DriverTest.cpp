@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <folly/synchronization/Baton.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -62,6 +63,9 @@ class MockEngine final : public Engine {
           auto entry =
               std::make_pair(std::move(keybuffer), std::move(valbuffer));
           auto entryHK = makeHK(entry.first); // Capture before std::move
+          if (negativeFilter_ && cache_.find(entryHK) == cache_.end()) {
+            negativeFilter_->add(entryHK.keyHash());
+          }
           cache_[entryHK] = std::move(entry);
           return Status::Ok;
         }));
@@ -125,6 +129,10 @@ class MockEngine final : public Engine {
     return std::make_pair(Status::NotFound, "");
   }
 
+  void setNegativeFilter(NegativeFilter* filter) override {
+    negativeFilter_ = filter;
+  }
+
   // Returns true if key found and can be actually evicted in the real world
   bool evict(HashedKey key) {
     auto itr = cache_.find(key);
@@ -133,6 +141,9 @@ class MockEngine final : public Engine {
     }
     auto value = std::move(itr->second.second);
     cache_.erase(itr);
+    if (negativeFilter_) {
+      negativeFilter_->remove(key.keyHash());
+    }
     if (destructorCb_) {
       destructorCb_(key, value.view(), DestructorEvent::Removed);
     }
@@ -146,6 +157,7 @@ class MockEngine final : public Engine {
   const DestructorCallback destructorCb_{};
   std::unordered_map<HashedKey, EntryType, HashedKeyHash> cache_;
   const uint64_t itemMaxSize_;
+  NegativeFilter* negativeFilter_{nullptr};
 };
 
 std::unique_ptr<JobScheduler> makeJobScheduler() {
@@ -260,6 +272,138 @@ TEST(Driver, CouldExistLargeWithNoopEngine) {
   testCouldExistWithOneEngine(false);
 }
 
+TEST(Driver, NegativeFilter) {
+  BufferGen bg;
+  auto smallValue = bg.gen(16);
+  auto largeValue = bg.gen(32);
+
+  auto bc = std::make_unique<MockEngine>();
+  auto si = std::make_unique<MockEngine>();
+  {
+    testing::InSequence inSeq;
+    EXPECT_CALL(*si, insert(makeHK("key"), smallValue.view()));
+    EXPECT_CALL(*bc, remove(makeHK("key")));
+    // Only keys that pass the filter reach the engines
+    EXPECT_CALL(*si, couldExist(makeHK("key")));
+    EXPECT_CALL(*bc, lookup(makeHK("key"), _));
+    EXPECT_CALL(*si, lookup(makeHK("key"), _));
+    EXPECT_CALL(*bc, insert(makeHK("key"), largeValue.view()));
+    EXPECT_CALL(*si, remove(makeHK("key")));
+    EXPECT_CALL(*si, couldExist(makeHK("key")));
+    EXPECT_CALL(*bc, couldExist(makeHK("key")));
+    EXPECT_CALL(*si, remove(makeHK("key")));
+    EXPECT_CALL(*bc, remove(makeHK("key")));
+  }
+
+  auto ex = makeJobScheduler();
+  auto config = makeDriverConfig(std::move(bc), std::move(si), std::move(ex));
+  config.negativeFilterSize = 64 * 1024;
+  auto driver = std::make_unique<Driver>(std::move(config));
+
+  EXPECT_FALSE(driver->couldExist(makeHK("key")));
+  EXPECT_EQ(Status::Ok, driver->insert(makeHK("key"), smallValue.view()));
+  EXPECT_TRUE(driver->couldExist(makeHK("key")));
+  Buffer valueLookup;
+  EXPECT_EQ(Status::Ok, driver->lookup(makeHK("key"), valueLookup));
+  EXPECT_EQ(smallValue.view(), valueLookup.view());
+  EXPECT_EQ(Status::NotFound, driver->lookup(makeHK("key1"), valueLookup));
+
+  // Moving the key to the other engine keeps it in the filter
+  EXPECT_EQ(Status::Ok, driver->insert(makeHK("key"), largeValue.view()));
+  EXPECT_TRUE(driver->couldExist(makeHK("key")));
+  EXPECT_EQ(Status::Ok, driver->remove(makeHK("key")));
+  EXPECT_FALSE(driver->couldExist(makeHK("key")));
+
+  double negatives = 0;
+  double falsePositives = -1;
+  driver->getCounters({[&](folly::StringPiece name, double value) {
+    if (name == "navy_neg_filter_negatives") {
+      negatives = value;
+    } else if (name == "navy_neg_filter_false_positives") {
+      falsePositives = value;
+    }
+  }});
+  EXPECT_EQ(3, negatives);
+  EXPECT_EQ(0, falsePositives);
+}
+
+TEST(Driver, NegativeFilterAsync) {
+  BufferGen bg;
+  auto value = bg.gen(16);
+
+  auto bc = std::make_unique<MockEngine>();
+  auto si = std::make_unique<MockEngine>();
+  {
+    testing::InSequence inSeq;
+    EXPECT_CALL(*si, insert(makeHK("key"), value.view()));
+    EXPECT_CALL(*bc, remove(makeHK("key")));
+    // Only keys that pass the filter reach the engines
+    EXPECT_CALL(*bc, lookup(makeHK("key"), _));
+    EXPECT_CALL(*si, lookup(makeHK("key"), _));
+    EXPECT_CALL(*bc, lookup(makeHK("key"), _));
+    EXPECT_CALL(*si, lookup(makeHK("key"), _));
+  }
+
+  auto ex = makeJobScheduler();
+  auto config = makeDriverConfig(std::move(bc), std::move(si), std::move(ex));
+  config.negativeFilterSize = 64 * 1024;
+  auto driver = std::make_unique<Driver>(std::move(config));
+  EXPECT_EQ(Status::Ok, driver->insert(makeHK("key"), value.view()));
+
+  // Ruled out keys complete before lookupAsync returns
+  Status missStatus{Status::Ok};
+  driver->lookupAsync(makeHK("key1"),
+                      [&missStatus](Status s, HashedKey, Buffer) {
+                        missStatus = s;
+                      });
+  EXPECT_EQ(Status::NotFound, missStatus);
+
+  folly::Baton<> done;
+  driver->lookupAsync(makeHK("key"), [&](Status s, HashedKey, Buffer v) {
+    EXPECT_EQ(Status::Ok, s);
+    EXPECT_EQ(value.view(), v.view());
+    done.post();
+  });
+  done.wait();
+
+  missStatus = Status::Ok;
+  done.reset();
+  std::vector<LookupCallback> cbs;
+  cbs.push_back([&](Status s, HashedKey, Buffer v) {
+    EXPECT_EQ(Status::Ok, s);
+    EXPECT_EQ(value.view(), v.view());
+    done.post();
+  });
+  cbs.push_back(
+      [&missStatus](Status s, HashedKey, Buffer) { missStatus = s; });
+  driver->lookupBatchAsync({makeHK("key"), makeHK("key2")}, std::move(cbs));
+  EXPECT_EQ(Status::NotFound, missStatus);
+  done.wait();
+
+  double negatives = 0;
+  double falsePositives = -1;
+  driver->getCounters({[&](folly::StringPiece name, double count) {
+    if (name == "navy_neg_filter_negatives") {
+      negatives = count;
+    } else if (name == "navy_neg_filter_false_positives") {
+      falsePositives = count;
+    }
+  }});
+  EXPECT_EQ(2, negatives);
+  EXPECT_EQ(0, falsePositives);
+}
+
+TEST(Driver, NegativeFilterBadConfig) {
+  auto ex = makeJobScheduler();
+  auto config = makeDriverConfig(std::make_unique<MockEngine>(),
+                                 std::make_unique<MockEngine>(),
+                                 std::move(ex));
+  config.negativeFilterSize = 64 * 1024;
+  config.negativeFilterNumHashes = 0;
+  EXPECT_THROW(std::make_unique<Driver>(std::move(config)),
+               std::invalid_argument);
+}
+
 TEST(Driver, SmallItem) {
   BufferGen bg;
   auto value = bg.gen(16);
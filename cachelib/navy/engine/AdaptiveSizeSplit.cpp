@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/engine/AdaptiveSizeSplit.h"
+
+#include <folly/Format.h>
+
+#include <algorithm>
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace {
+// granularity of the tracked item sizes and so of the learned threshold
+constexpr uint64_t kMinTrackedSize = 64;
+constexpr double kSizeFactor = 1.25;
+// items larger than this multiple of the max threshold are all counted in the
+// largest size bucket
+constexpr uint64_t kTrackedSizeMultiple = 4;
+// bounds of the weight given to the difference in hits per device byte
+// written between the engines
+constexpr double kMinHitDensityWeight = 0.5;
+constexpr double kMaxHitDensityWeight = 2.0;
+} // namespace
+
+AdaptiveSizeSplit::AdaptiveSizeSplit(const Config& config,
+                                     uint32_t initialThreshold)
+    : config_{config},
+      threshold_{initialThreshold},
+      sizeDist_{kMinTrackedSize,
+                std::max<uint64_t>(kMinTrackedSize + 1,
+                                   uint64_t{config.maxSmallItemMaxSize} *
+                                       kTrackedSizeMultiple),
+                kSizeFactor} {
+  if (config_.minSmallItemMaxSize == 0 ||
+      config_.minSmallItemMaxSize > config_.maxSmallItemMaxSize) {
+    throw std::invalid_argument(folly::sformat(
+        "invalid adaptive small item max size bounds: [{}, {}]",
+        config_.minSmallItemMaxSize,
+        config_.maxSmallItemMaxSize));
+  }
+  if (config_.windowSize == 0) {
+    throw std::invalid_argument(
+        "adaptive size split window size should be non-zero");
+  }
+  if (initialThreshold < config_.minSmallItemMaxSize ||
+      initialThreshold > config_.maxSmallItemMaxSize) {
+    throw std::invalid_argument(folly::sformat(
+        "small item max size {} is out of the adaptive bounds [{}, {}]",
+        initialThreshold,
+        config_.minSmallItemMaxSize,
+        config_.maxSmallItemMaxSize));
+  }
+}
+
+bool AdaptiveSizeSplit::recordInsert(uint32_t size, bool large) {
+  const uint64_t maxTracked =
+      uint64_t{config_.maxSmallItemMaxSize} * kTrackedSizeMultiple;
+  sizeDist_.addSize(std::min<uint64_t>(size, maxTracked));
+  (large ? largeBytes_ : smallBytes_).add(size);
+  return windowInserts_.fetch_add(1, std::memory_order_relaxed) + 1 ==
+         config_.windowSize;
+}
+
+uint32_t AdaptiveSizeSplit::thresholdForShare(double targetShare) const {
+  const auto snapshot = sizeDist_.getSnapshot();
+  int64_t total = 0;
+  for (const auto& kv : snapshot) {
+    total += kv.second;
+  }
+  const double target = targetShare * static_cast<double>(total);
+  int64_t cumulative = 0;
+  for (const auto& kv : snapshot) {
+    cumulative += kv.second;
+    if (static_cast<double>(cumulative) >= target) {
+      return static_cast<uint32_t>(
+          std::min<int64_t>(kv.first, config_.maxSmallItemMaxSize));
+    }
+  }
+  return config_.maxSmallItemMaxSize;
+}
+
+uint32_t AdaptiveSizeSplit::retune(const EngineUsage& small,
+                                   const EngineUsage& large) {
+  std::unique_lock<std::mutex> lock{retuneMutex_, std::try_to_lock};
+  if (!lock.owns_lock()) {
+    return getThreshold();
+  }
+
+  const uint64_t smallBytes = smallBytes_.get();
+  const uint64_t largeBytes = largeBytes_.get();
+  const uint64_t smallHits = smallHits_.get();
+  const uint64_t largeHits = largeHits_.get();
+
+  // Weight the engines by the hits they return per byte they write to the
+  // device. This accounts for both the write amplification of an engine and
+  // how useful the items it holds are. The device counters can go backwards
+  // after an engine reset, in which case the window is not weighted.
+  double weight = 1.0;
+  if (physicalStartValid_ && small.physicalWritten >= smallPhysicalStart_ &&
+      large.physicalWritten >= largePhysicalStart_) {
+    const uint64_t smallPhysical = small.physicalWritten - smallPhysicalStart_;
+    const uint64_t largePhysical = large.physicalWritten - largePhysicalStart_;
+    smallWriteAmpPct_.store(
+        smallBytes > 0 ? smallPhysical * 100 / smallBytes : 0,
+        std::memory_order_relaxed);
+    largeWriteAmpPct_.store(
+        largeBytes > 0 ? largePhysical * 100 / largeBytes : 0,
+        std::memory_order_relaxed);
+    if (smallPhysical > 0 && largePhysical > 0 && smallHits + largeHits > 0) {
+      const double smallDensity =
+          (smallHits + 1.0) / static_cast<double>(smallPhysical);
+      const double largeDensity =
+          (largeHits + 1.0) / static_cast<double>(largePhysical);
+      weight = std::clamp(smallDensity / largeDensity,
+                          kMinHitDensityWeight,
+                          kMaxHitDensityWeight);
+    }
+  }
+  smallPhysicalStart_ = small.physicalWritten;
+  largePhysicalStart_ = large.physicalWritten;
+  physicalStartValid_ = true;
+
+  const uint32_t current = getThreshold();
+  uint32_t next = current;
+  if (small.size + large.size > 0 && smallBytes + largeBytes > 0) {
+    const double spaceShare = static_cast<double>(small.size) /
+                              static_cast<double>(small.size + large.size);
+    next = thresholdForShare(std::min(1.0, spaceShare * weight));
+    // move gradually so that a single unusual window does not send most of
+    // the items to the other engine
+    next = static_cast<uint32_t>(
+        std::clamp<uint64_t>(next, current / 2, uint64_t{current} * 2));
+    next = std::clamp(
+        next, config_.minSmallItemMaxSize, config_.maxSmallItemMaxSize);
+  }
+  threshold_.store(next, std::memory_order_relaxed);
+
+  sizeDist_.reset();
+  smallBytes_.set(0);
+  largeBytes_.set(0);
+  smallHits_.set(0);
+  largeHits_.set(0);
+  windowInserts_.store(0, std::memory_order_relaxed);
+  retuneCount_.inc();
+  return next;
+}
+
+void AdaptiveSizeSplit::getCounters(const CounterVisitor& visitor) const {
+  visitor("navy_split_threshold", getThreshold());
+  visitor("navy_split_retunes",
+          retuneCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_split_small_write_amp_pct",
+          smallWriteAmpPct_.load(std::memory_order_relaxed));
+  visitor("navy_split_large_write_amp_pct",
+          largeWriteAmpPct_.load(std::memory_order_relaxed));
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
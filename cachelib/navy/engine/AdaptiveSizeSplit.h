@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/navy/common/SizeDistribution.h"
+#include "cachelib/navy/common/Types.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+// Learns the size threshold that splits items between the small item engine
+// (BigHash) and the large item engine (BlockCache) of an EnginePair.
+//
+// Over a window of inserts it tracks the size distribution of the inserted
+// items together with the hits and the device bytes written by each engine.
+// At the end of a window the threshold is moved so that the share of the
+// inserted bytes routed to the small item engine matches its share of the
+// device space, weighted by how many hits each engine returns per byte it
+// writes to the device. The threshold moves by at most a factor of two per
+// window and stays within the configured bounds.
+class AdaptiveSizeSplit {
+ public:
+  struct Config {
+    // the bounds of the threshold. The upper bound must not exceed the max
+    // item size of the small item engine.
+    uint32_t minSmallItemMaxSize{};
+    uint32_t maxSmallItemMaxSize{};
+
+    // number of inserts after which the threshold is recomputed
+    uint64_t windowSize{100000};
+  };
+
+  // Device usage of an engine sampled at the end of a window.
+  struct EngineUsage {
+    // usable device space of the engine
+    uint64_t size{};
+
+    // cumulative device bytes written by the engine
+    uint64_t physicalWritten{};
+  };
+
+  // @throw std::invalid_argument if the config is invalid or
+  //        @initialThreshold is out of its bounds.
+  AdaptiveSizeSplit(const Config& config, uint32_t initialThreshold);
+
+  AdaptiveSizeSplit(const AdaptiveSizeSplit&) = delete;
+  AdaptiveSizeSplit& operator=(const AdaptiveSizeSplit&) = delete;
+
+  // the current threshold. Items of a size (key + value) larger than this
+  // belong in the large item engine.
+  uint32_t getThreshold() const {
+    return threshold_.load(std::memory_order_relaxed);
+  }
+
+  // the upper bound of the threshold
+  uint32_t getMaxThreshold() const { return config_.maxSmallItemMaxSize; }
+
+  // Records an insert of @size bytes routed to the large item engine if
+  // @large is true. Returns true when the insert completes the window and
+  // the caller should retune().
+  bool recordInsert(uint32_t size, bool large);
+
+  // Records a lookup hit served by the large item engine if @large is true.
+  void recordHit(bool large) {
+    (large ? largeHits_ : smallHits_).inc();
+  }
+
+  // Recomputes the threshold from the stats of the current window and starts
+  // a new one. Concurrent calls are ignored. Returns the threshold in effect.
+  uint32_t retune(const EngineUsage& small, const EngineUsage& large);
+
+  // Exports the threshold and the tuning stats via CounterVisitor.
+  void getCounters(const CounterVisitor& visitor) const;
+
+ private:
+  // the smallest threshold for which the items of that size or below make up
+  // at least @targetShare of the bytes inserted in the window.
+  uint32_t thresholdForShare(double targetShare) const;
+
+  const Config config_;
+
+  std::atomic<uint32_t> threshold_{};
+
+  // inserts of the window. The window ends when it reaches windowSize.
+  std::atomic<uint64_t> windowInserts_{0};
+
+  // bytes inserted in the window per item size
+  SizeDistribution sizeDist_;
+
+  AtomicCounter smallBytes_;
+  AtomicCounter largeBytes_;
+  AtomicCounter smallHits_;
+  AtomicCounter largeHits_;
+
+  // serializes retune() and guards the fields below
+  std::mutex retuneMutex_;
+
+  // device bytes written by each engine at the start of the window
+  uint64_t smallPhysicalStart_{0};
+  uint64_t largePhysicalStart_{0};
+  bool physicalStartValid_{false};
+
+  // write amplification of each engine in the last window, in percent
+  std::atomic<uint64_t> smallWriteAmpPct_{0};
+  std::atomic<uint64_t> largeWriteAmpPct_{0};
+
+  AtomicCounter retuneCount_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -16,8 +16,12 @@
 
 #pragma once
 
+#include <vector>
+
 #include "cachelib/navy/AbstractCache.h"
+#include "cachelib/navy/common/CheckpointLog.h"
 #include "cachelib/navy/common/Hash.h"
+#include "cachelib/navy/common/NegativeFilter.h"
 
 namespace facebook {
 namespace cachelib {
@@ -38,12 +42,46 @@ class Engine {
   // remains available via lookup.
   virtual Status insert(HashedKey hk, BufferView value) = 0;
 
+  // Inserts a batch of entries. @statuses is resized to the number of keys
+  // and holds the result of the insert of the entry at the same index, with
+  // the same statuses as insert(). Engines that can write entries together
+  // override this; by default entries are inserted one at a time.
+  virtual void insertBatch(const std::vector<HashedKey>& keys,
+                           const std::vector<BufferView>& values,
+                           std::vector<Status>& statuses) {
+    statuses.assign(keys.size(), Status::Ok);
+    for (size_t i = 0; i < keys.size(); i++) {
+      statuses[i] = insert(keys[i], values[i]);
+    }
+  }
+
   // Looks up a key in the engine.
   virtual Status lookup(HashedKey hk, Buffer& value) = 0;
 
+  // Looks up a batch of keys. @values and @statuses are resized to the
+  // number of keys and hold the result of the lookup of the key at the same
+  // index, with the same statuses as lookup(). Engines that can share device
+  // reads between keys override this; by default keys are looked up one at a
+  // time.
+  virtual void lookupBatch(const std::vector<HashedKey>& keys,
+                           std::vector<Buffer>& values,
+                           std::vector<Status>& statuses) {
+    values.clear();
+    values.resize(keys.size());
+    statuses.assign(keys.size(), Status::NotFound);
+    for (size_t i = 0; i < keys.size(); i++) {
+      statuses[i] = lookup(keys[i], values[i]);
+    }
+  }
+
   // Remove must not return Status::Retry.
   virtual Status remove(HashedKey hk) = 0;
 
+  // Removes a key whose item was copied to another engine. Unlike remove(),
+  // it does not call the destructor callback since the item is still cached.
+  // The default is only correct for engines that never call it on remove.
+  virtual Status removeMoved(HashedKey hk) { return remove(hk); }
+
   // Flushes all buffered (in flight) operations
   virtual void flush() = 0;
 
@@ -64,9 +102,33 @@ class Engine {
   // Gets the maximum item size that can be inserted into the engine.
   virtual uint64_t getMaxItemSize() const = 0;
 
+  // Gets the number of bytes the engine has written to the device so far.
+  // Engines that do not write to a device return 0.
+  virtual uint64_t getPhysicalWrittenBytes() const { return 0; }
+
   // Get key and Buffer for a random sample
   virtual std::pair<Status, std::string /* key */> getRandomAlloc(
       Buffer& value) = 0;
+
+  // Logs the changes made after a checkpoint to @log, tagging the records
+  // with @logId. Engines that do not log are recovered only from clean
+  // checkpoints, or from unclean ones by replayCheckpointLog().
+  virtual void setCheckpointLog(CheckpointLog* /* log */,
+                                uint8_t /* logId */) {}
+
+  // Brings the state recovered from a checkpoint taken while the engine was
+  // running up to date with @records, the log of the checkpoint. Called
+  // after a successful recover(). Returns false if the state cannot be made
+  // consistent, in which case the engine has to be reset.
+  virtual bool replayCheckpointLog(
+      const std::vector<CheckpointLog::Record>& /* records */) {
+    return false;
+  }
+
+  // Adds the keys of the engine to @filter before they can be found and
+  // removes them once they are gone, including the keys recovered by
+  // recover(). The default is only correct for engines that hold no keys.
+  virtual void setNegativeFilter(NegativeFilter* /* filter */) {}
 };
 } // namespace navy
 } // namespace cachelib
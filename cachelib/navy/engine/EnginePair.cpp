@@ -16,6 +16,8 @@
 
 #include "cachelib/navy/engine/EnginePair.h"
 
+#include <numeric>
+
 #include "cachelib/navy/engine/NoopEngine.h"
 
 namespace facebook {
@@ -25,19 +27,25 @@ namespace navy {
 EnginePair::EnginePair(std::unique_ptr<Engine> smallItemCache,
                        std::unique_ptr<Engine> largeItemCache,
                        uint32_t smallItemMaxSize,
-                       JobScheduler* scheduler)
+                       JobScheduler* scheduler,
+                       std::unique_ptr<AdaptiveSizeSplit> sizeSplit)
     : smallItemMaxSize_(smallItemCache ? smallItemMaxSize : 0),
       largeItemCache_{std::move(largeItemCache)},
       smallItemCache_{std::move(smallItemCache)},
-      scheduler_(scheduler) {}
+      scheduler_(scheduler),
+      sizeSplit_{std::move(sizeSplit)} {}
 
 bool EnginePair::isItemLarge(HashedKey key, BufferView value) const {
-  return key.key().size() + value.size() > smallItemMaxSize_;
+  return key.key().size() + value.size() > getSmallItemMaxSize();
 }
 
 std::pair<Engine&, Engine&> EnginePair::select(HashedKey key,
                                                BufferView value) const {
-  if (isItemLarge(key, value)) {
+  return select(isItemLarge(key, value));
+}
+
+std::pair<Engine&, Engine&> EnginePair::select(bool large) const {
+  if (large) {
     return {*largeItemCache_, *smallItemCache_};
   } else {
     return {*smallItemCache_, *largeItemCache_};
@@ -60,19 +68,24 @@ Status EnginePair::lookupSync(HashedKey hk, Buffer& value) const {
   while ((status = largeItemCache_->lookup(hk, value)) == Status::Retry) {
     std::this_thread::yield();
   }
+  bool fromLargeItemCache = status != Status::NotFound;
   if (status == Status::NotFound) {
     while ((status = smallItemCache_->lookup(hk, value)) == Status::Retry) {
       std::this_thread::yield();
     }
   }
+  if (sizeSplit_ && status == Status::Ok) {
+    sizeSplit_->recordHit(fromLargeItemCache);
+  }
   updateLookupStats(status);
   return status;
 }
 
 Status EnginePair::insertInternal(HashedKey hk,
                                   BufferView value,
+                                  bool large,
                                   bool& skipInsertion) {
-  auto selection = select(hk, value);
+  auto selection = select(large);
   Status status = Status::Ok;
   if (!skipInsertion) {
     status = selection.first.insert(hk, value);
@@ -81,8 +94,12 @@ Status EnginePair::insertInternal(HashedKey hk,
     }
     skipInsertion = true;
   }
+  return completeInsert(hk, large, status);
+}
+
+Status EnginePair::completeInsert(HashedKey hk, bool large, Status status) {
   if (status != Status::DeviceError) {
-    auto rs = selection.second.remove(hk);
+    auto rs = select(large).second.remove(hk);
     if (rs == Status::Retry) {
       return rs;
     }
@@ -106,13 +123,27 @@ Status EnginePair::insertInternal(HashedKey hk,
   return status;
 }
 
+void EnginePair::recordInsert(HashedKey hk, BufferView value, bool large) {
+  if (!sizeSplit_ ||
+      !sizeSplit_->recordInsert(hk.key().size() + value.size(), large)) {
+    return;
+  }
+  auto threshold = sizeSplit_->retune(
+      {smallItemCache_->getSize(), smallItemCache_->getPhysicalWrittenBytes()},
+      {largeItemCache_->getSize(), largeItemCache_->getPhysicalWrittenBytes()});
+  XLOGF(DBG, "Small item max size retuned to {}", threshold);
+}
+
 void EnginePair::scheduleInsert(HashedKey hk,
                                 BufferView value,
                                 InsertCallback cb) {
   insertCount_.inc();
+  const bool large = isItemLarge(hk, value);
+  recordInsert(hk, value, large);
   scheduler_->enqueueWithKey(
-      [this, cb = std::move(cb), hk, value, skipInsertion = false]() mutable {
-        auto status = insertInternal(hk, value, skipInsertion);
+      [this, cb = std::move(cb), hk, value, large,
+       skipInsertion = false]() mutable {
+        auto status = insertInternal(hk, value, large, skipInsertion);
         if (status == Status::Retry) {
           return JobExitCode::Reschedule;
         }
@@ -128,6 +159,75 @@ void EnginePair::scheduleInsert(HashedKey hk,
       hk.keyHash());
 }
 
+void EnginePair::scheduleInsertBatch(std::vector<HashedKey> keys,
+                                     std::vector<BufferView> values,
+                                     std::vector<InsertCallback> cbs) {
+  XDCHECK_EQ(keys.size(), values.size());
+  XDCHECK_EQ(keys.size(), cbs.size());
+  insertCount_.add(keys.size());
+  std::vector<bool> large(keys.size(), false);
+  for (size_t i = 0; i < keys.size(); i++) {
+    large[i] = isItemLarge(keys[i], values[i]);
+    recordInsert(keys[i], values[i], large[i]);
+  }
+  // indices of the entries not completed yet and the status of their insert
+  // into the selected engine. Entries stay pending across retries until the
+  // other engine no longer has the key.
+  std::vector<size_t> pending(keys.size());
+  std::iota(pending.begin(), pending.end(), 0);
+  std::vector<Status> statuses(keys.size(), Status::Ok);
+  std::vector<bool> inserted(keys.size(), false);
+  scheduler_->enqueue(
+      [this, keys = std::move(keys), values = std::move(values),
+       cbs = std::move(cbs), pending = std::move(pending),
+       statuses = std::move(statuses), inserted = std::move(inserted),
+       large = std::move(large)]() mutable {
+        std::vector<HashedKey> batchKeys;
+        std::vector<BufferView> batchValues;
+        std::vector<size_t> batchIdx;
+        for (auto idx : pending) {
+          if (inserted[idx]) {
+            continue;
+          }
+          if (large[idx]) {
+            batchKeys.push_back(keys[idx]);
+            batchValues.push_back(values[idx]);
+            batchIdx.push_back(idx);
+          } else {
+            statuses[idx] = smallItemCache_->insert(keys[idx], values[idx]);
+            inserted[idx] = statuses[idx] != Status::Retry;
+          }
+        }
+        if (!batchKeys.empty()) {
+          std::vector<Status> batchStatuses;
+          largeItemCache_->insertBatch(batchKeys, batchValues, batchStatuses);
+          for (size_t i = 0; i < batchIdx.size(); i++) {
+            statuses[batchIdx[i]] = batchStatuses[i];
+            inserted[batchIdx[i]] = batchStatuses[i] != Status::Retry;
+          }
+        }
+
+        std::vector<size_t> retry;
+        for (auto idx : pending) {
+          if (!inserted[idx]) {
+            retry.push_back(idx);
+            continue;
+          }
+          auto status = completeInsert(keys[idx], large[idx], statuses[idx]);
+          if (status == Status::Retry) {
+            retry.push_back(idx);
+          } else if (cbs[idx]) {
+            cbs[idx](status, keys[idx]);
+          }
+        }
+        pending = std::move(retry);
+
+        return pending.empty() ? JobExitCode::Done : JobExitCode::Reschedule;
+      },
+      "insertBatch",
+      JobType::Write);
+}
+
 void EnginePair::updateLookupStats(Status status) const {
   switch (status) {
   case Status::Ok:
@@ -142,7 +242,8 @@ void EnginePair::updateLookupStats(Status status) const {
 
 Status EnginePair::lookupInternal(HashedKey hk,
                                   Buffer& value,
-                                  bool& skipLargeItemCache) const {
+                                  bool& skipLargeItemCache,
+                                  bool& fromLargeItemCache) const {
   Status status{Status::NotFound};
   if (!skipLargeItemCache) {
     status = largeItemCache_->lookup(hk, value);
@@ -150,6 +251,7 @@ Status EnginePair::lookupInternal(HashedKey hk,
       return status;
     }
     skipLargeItemCache = true;
+    fromLargeItemCache = status != Status::NotFound;
   }
   if (status == Status::NotFound) {
     status = smallItemCache_->lookup(hk, value);
@@ -157,18 +259,55 @@ Status EnginePair::lookupInternal(HashedKey hk,
       return status;
     }
   }
+  if (sizeSplit_ && status == Status::Ok) {
+    sizeSplit_->recordHit(fromLargeItemCache);
+  }
   updateLookupStats(status);
   return status;
 }
 
+void EnginePair::maybeMigrate(HashedKey hk,
+                              const Buffer& value,
+                              bool fromLargeItemCache) {
+  if (!sizeSplit_) {
+    return;
+  }
+  const bool large = isItemLarge(hk, value.view());
+  if (large == fromLargeItemCache) {
+    return;
+  }
+  auto selection = select(large);
+  if (selection.first.insert(hk, value.view()) != Status::Ok) {
+    return;
+  }
+  // the item stays cached, so neither copy is removed through remove(),
+  // which would report it to the destructor callback as removed.
+  auto status = selection.second.removeMoved(hk);
+  if (status != Status::Ok && status != Status::NotFound) {
+    // A key must only be in one engine, so take the copy back out.
+    XLOGF(ERR, "Migration failed to remove old item: {}", toString(status));
+    selection.first.removeMoved(hk);
+    ioErrorCount_.inc();
+    return;
+  }
+  migrationCount_.inc();
+}
+
 void EnginePair::scheduleLookup(HashedKey hk, LookupCallback cb) {
   scheduler_->enqueueWithKey(
-      [this, cb = std::move(cb), hk, skipLargeItemCache = false]() mutable {
+      [this, cb = std::move(cb), hk, skipLargeItemCache = false,
+       fromLargeItemCache = false]() mutable {
         Buffer value;
-        Status status = lookupInternal(hk, value, skipLargeItemCache);
+        Status status = lookupInternal(
+            hk, value, skipLargeItemCache, fromLargeItemCache);
         if (status == Status::Retry) {
           return JobExitCode::Reschedule;
         }
+        // The job is ordered with the other requests to the key, so the
+        // item can be moved to the engine the threshold selects now.
+        if (status == Status::Ok) {
+          maybeMigrate(hk, value, fromLargeItemCache);
+        }
         if (cb) {
           cb(status, hk, std::move(value));
         }
@@ -180,6 +319,72 @@ void EnginePair::scheduleLookup(HashedKey hk, LookupCallback cb) {
       hk.keyHash());
 }
 
+void EnginePair::scheduleLookupBatch(std::vector<HashedKey> keys,
+                                     std::vector<LookupCallback> cbs) {
+  XDCHECK_EQ(keys.size(), cbs.size());
+  // indices of the keys still to be looked up in either engine. They are
+  // kept across retries so that completed keys are not looked up again.
+  std::vector<size_t> largePending(keys.size());
+  std::iota(largePending.begin(), largePending.end(), 0);
+  scheduler_->enqueue(
+      [this, keys = std::move(keys), cbs = std::move(cbs),
+       largePending = std::move(largePending),
+       smallPending = std::vector<size_t>{}]() mutable {
+        auto complete = [&](size_t idx, Status status, Buffer value,
+                            bool fromLargeItemCache) {
+          if (sizeSplit_ && status == Status::Ok) {
+            sizeSplit_->recordHit(fromLargeItemCache);
+          }
+          updateLookupStats(status);
+          if (cbs[idx]) {
+            cbs[idx](status, keys[idx], std::move(value));
+          }
+        };
+
+        if (!largePending.empty()) {
+          std::vector<HashedKey> batch;
+          batch.reserve(largePending.size());
+          for (auto idx : largePending) {
+            batch.push_back(keys[idx]);
+          }
+          std::vector<Buffer> values;
+          std::vector<Status> statuses;
+          largeItemCache_->lookupBatch(batch, values, statuses);
+
+          std::vector<size_t> retry;
+          for (size_t i = 0; i < largePending.size(); i++) {
+            const auto idx = largePending[i];
+            if (statuses[i] == Status::Retry) {
+              retry.push_back(idx);
+            } else if (statuses[i] == Status::NotFound) {
+              smallPending.push_back(idx);
+            } else {
+              complete(idx, statuses[i], std::move(values[i]), true);
+            }
+          }
+          largePending = std::move(retry);
+        }
+
+        std::vector<size_t> retry;
+        for (auto idx : smallPending) {
+          Buffer value;
+          auto status = smallItemCache_->lookup(keys[idx], value);
+          if (status == Status::Retry) {
+            retry.push_back(idx);
+          } else {
+            complete(idx, status, std::move(value), false);
+          }
+        }
+        smallPending = std::move(retry);
+
+        return largePending.empty() && smallPending.empty()
+                   ? JobExitCode::Done
+                   : JobExitCode::Reschedule;
+      },
+      "lookupBatch",
+      JobType::Read);
+}
+
 Status EnginePair::removeSync(HashedKey hk) {
   Status status{Status::Ok};
   bool skipSmallItemCache = false;
@@ -254,6 +459,23 @@ bool EnginePair::recover(RecordReader& rr) {
   return largeItemCache_->recover(rr) && smallItemCache_->recover(rr);
 }
 
+void EnginePair::setCheckpointLog(CheckpointLog* log, uint32_t index) {
+  XDCHECK_LT(2 * index + 1, 256u);
+  largeItemCache_->setCheckpointLog(log, static_cast<uint8_t>(2 * index));
+  smallItemCache_->setCheckpointLog(log, static_cast<uint8_t>(2 * index + 1));
+}
+
+void EnginePair::setNegativeFilter(NegativeFilter* filter) {
+  largeItemCache_->setNegativeFilter(filter);
+  smallItemCache_->setNegativeFilter(filter);
+}
+
+bool EnginePair::replayCheckpointLog(
+    const std::vector<CheckpointLog::Record>& records) {
+  return largeItemCache_->replayCheckpointLog(records) &&
+         smallItemCache_->replayCheckpointLog(records);
+}
+
 void EnginePair::getCounters(const CounterVisitor& visitor) const {
   visitor(
       "navy_inserts", insertCount_.get(), CounterVisitor::CounterType::RATE);
@@ -273,6 +495,12 @@ void EnginePair::getCounters(const CounterVisitor& visitor) const {
   visitor(
       "navy_io_errors", ioErrorCount_.get(), CounterVisitor::CounterType::RATE);
   visitor("navy_total_usable_size", getUsableSize());
+  if (sizeSplit_) {
+    visitor("navy_split_migrations",
+            migrationCount_.get(),
+            CounterVisitor::CounterType::RATE);
+    sizeSplit_->getCounters(visitor);
+  }
   largeItemCache_->getCounters(visitor);
   smallItemCache_->getCounters(visitor);
 }
@@ -307,6 +535,17 @@ void EnginePair::validate() {
           smallItemCache_->getMaxItemSize(),
           smallItemMaxSize_));
     }
+    if (sizeSplit_ &&
+        sizeSplit_->getMaxThreshold() > smallItemCache_->getMaxItemSize()) {
+      throw std::invalid_argument(folly::sformat(
+          "adaptive small item max size should not exceed {} but is set to "
+          "be up to {}.",
+          smallItemCache_->getMaxItemSize(),
+          sizeSplit_->getMaxThreshold()));
+    }
+  } else if (sizeSplit_) {
+    throw std::invalid_argument(
+        "Adaptive size split is set without a small item cache");
   }
 
   if (!largeItemCache_) {
@@ -20,6 +20,7 @@
 #include <cachelib/navy/common/Buffer.h>
 #include <folly/Random.h>
 
+#include "cachelib/navy/engine/AdaptiveSizeSplit.h"
 #include "cachelib/navy/engine/Engine.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
 
@@ -29,19 +30,26 @@ namespace navy {
 
 // A pair of small and large item engine.
 // A driver must have at least one engine pair.
+//
+// With a @sizeSplit, the max size of the items in the small item engine is
+// learned from the workload instead of being fixed. Items that end up on the
+// wrong side of a moved threshold are migrated lazily when they are looked
+// up.
 class EnginePair {
  public:
   EnginePair(std::unique_ptr<Engine> smallItemCache,
              std::unique_ptr<Engine> largeItemCache,
              uint32_t smallItemMaxSize,
-             JobScheduler* scheduler);
+             JobScheduler* scheduler,
+             std::unique_ptr<AdaptiveSizeSplit> sizeSplit = nullptr);
 
   // Move constructor.
   EnginePair(EnginePair&& ep) noexcept
       : EnginePair(std::move(ep.smallItemCache_),
                    std::move(ep.largeItemCache_),
                    ep.smallItemMaxSize_,
-                   ep.scheduler_) {}
+                   ep.scheduler_,
+                   std::move(ep.sizeSplit_)) {}
 
   // Move assignment operator.
   EnginePair& operator=(EnginePair&& other) = delete;
@@ -63,6 +71,15 @@ class EnginePair {
   // Schedule an insert.
   void scheduleInsert(HashedKey hk, BufferView value, InsertCallback cb);
 
+  // Schedule a single job that inserts all the entries. Large items are
+  // handed to the large item engine as a batch so that they are appended to
+  // a region together. Like scheduleLookupBatch, the job is not ordered with
+  // other requests to the same keys and the caller is responsible for not
+  // issuing any until the callback of the key is invoked.
+  void scheduleInsertBatch(std::vector<HashedKey> keys,
+                           std::vector<BufferView> values,
+                           std::vector<InsertCallback> cbs);
+
   // Perform lookup by keeping retrying until a result (Ok, NotFound, Error) is
   // reached.
   Status lookupSync(HashedKey hk, Buffer& value) const;
@@ -74,6 +91,14 @@ class EnginePair {
   // Schedule a lookup.
   void scheduleLookup(HashedKey hk, LookupCallback cb);
 
+  // Schedule a single job that looks up all the keys. Keys are looked up in
+  // the large item engine as a batch first and the ones it does not have in
+  // the small item engine. Unlike scheduleLookup, the job is not ordered
+  // with other requests to the same keys; callers must only batch keys that
+  // have no concurrent inserts queued.
+  void scheduleLookupBatch(std::vector<HashedKey> keys,
+                           std::vector<LookupCallback> cbs);
+
   // Schedule a remove.
   void scheduleRemove(HashedKey hk, RemoveCallback cb);
 
@@ -89,6 +114,17 @@ class EnginePair {
   // recover the navy engines state
   bool recover(RecordReader& rr);
 
+  // log the changes made to both engines after a checkpoint to @log. @index
+  // is the position of the pair in the driver, which tells the records of
+  // its engines apart.
+  void setCheckpointLog(CheckpointLog* log, uint32_t index);
+
+  // bring the engines recovered from a checkpoint up to date with its log
+  bool replayCheckpointLog(const std::vector<CheckpointLog::Record>& records);
+
+  // keep @filter up to date with the keys of both engines
+  void setNegativeFilter(NegativeFilter* filter);
+
   // returns the navy stats
   void getCounters(const CounterVisitor& visitor) const;
 
@@ -102,23 +138,54 @@ class EnginePair {
   // Update statistics for lookup
   void updateLookupStats(Status status) const;
 
+  // The max size of the items in the small item engine.
+  uint32_t getSmallItemMaxSize() const {
+    return sizeSplit_ ? sizeSplit_->getThreshold() : smallItemMaxSize_;
+  }
+
   // Select engine to insert key/value. Returns a pair:
   //   - first: engine to insert key/value
   //   - second: the other engine to remove key
   std::pair<Engine&, Engine&> select(HashedKey key, BufferView value) const;
 
-  // Perform lookup in a retry friendly manner.
+  // Same as above for an item already known to be large or not. Inserts
+  // select the engines once, as the threshold can move during a retry.
+  std::pair<Engine&, Engine&> select(bool large) const;
+
+  // Perform lookup in a retry friendly manner. @fromLargeItemCache is set
+  // to whether the large item engine has the key.
   Status lookupInternal(HashedKey hk,
                         Buffer& value,
-                        bool& skipLargeItemCache) const;
-
-  // insert an item to one of the engine and remove it from the other.
-  // An option can be specified to skip insertion on retry.
-  Status insertInternal(HashedKey key, BufferView value, bool& skipInsertion);
+                        bool& skipLargeItemCache,
+                        bool& fromLargeItemCache) const;
+
+  // Records an insert selected for the large item engine if @large for the
+  // adaptive size split and retunes the split when a window is complete.
+  void recordInsert(HashedKey hk, BufferView value, bool large);
+
+  // Moves an item found in one engine to the other if the current threshold
+  // no longer selects the engine it was found in. Best effort: the item stays
+  // where it is if the insert into the other engine fails. Must run in a job
+  // ordered by the key.
+  void maybeMigrate(HashedKey hk,
+                    const Buffer& value,
+                    bool fromLargeItemCache);
+
+  // insert an item to the engine selected by @large and remove it from the
+  // other. An option can be specified to skip insertion on retry.
+  Status insertInternal(HashedKey key,
+                        BufferView value,
+                        bool large,
+                        bool& skipInsertion);
+
+  // remove an inserted item from the engine it was not inserted to and
+  // update the insert stats. Returns Retry if the remove needs a retry.
+  Status completeInsert(HashedKey key, bool large, Status status);
 
   // Performa a remove by hashed key in a retry friendly manner.
   Status removeHashedKeyInternal(HashedKey hk, bool& skipSmallItemCache);
 
+  // Initial threshold of sizeSplit_ if it is set.
   const uint32_t smallItemMaxSize_{};
   // Large item cache assumed to have fast response in case entry doesn't
   // exists (check metadata only).
@@ -128,6 +195,8 @@ class EnginePair {
 
   JobScheduler* scheduler_;
 
+  std::unique_ptr<AdaptiveSizeSplit> sizeSplit_;
+
   // These stats are bumped only once per call.
   mutable TLCounter insertCount_;
   mutable TLCounter lookupCount_;
@@ -138,6 +207,7 @@ class EnginePair {
   mutable AtomicCounter succLookupCount_;
   mutable AtomicCounter succRemoveCount_;
   mutable AtomicCounter ioErrorCount_;
+  mutable AtomicCounter migrationCount_;
 };
 } // namespace navy
 } // namespace cachelib
@@ -37,6 +37,10 @@ class NoopEngine final : public Engine {
   void reset() override {}
   void persist(RecordWriter& /* rw */) override {}
   bool recover(RecordReader& /* rr */) override { return true; }
+  bool replayCheckpointLog(
+      const std::vector<CheckpointLog::Record>& /* records */) override {
+    return true;
+  }
   void getCounters(const CounterVisitor& /* visitor */) const override {}
   uint64_t getMaxItemSize() const override { return UINT32_MAX; }
   std::pair<Status, std::string> getRandomAlloc(Buffer&) override {
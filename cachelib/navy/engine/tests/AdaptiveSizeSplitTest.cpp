@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "cachelib/navy/engine/AdaptiveSizeSplit.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+AdaptiveSizeSplit::Config makeConfig(uint64_t windowSize) {
+  AdaptiveSizeSplit::Config config;
+  config.minSmallItemMaxSize = 128;
+  config.maxSmallItemMaxSize = 2048;
+  config.windowSize = windowSize;
+  return config;
+}
+
+// Inserts 100 items of 100 bytes, 100 of 400 bytes and 50 of 1000 bytes, so
+// that they make up 10%, 40% and 50% of the inserted bytes.
+void insertMixedSizes(AdaptiveSizeSplit& split) {
+  for (int i = 0; i < 100; i++) {
+    split.recordInsert(100, false);
+    split.recordInsert(400, false);
+  }
+  for (int i = 0; i < 50; i++) {
+    split.recordInsert(1000, true);
+  }
+}
+} // namespace
+
+TEST(AdaptiveSizeSplit, InvalidConfig) {
+  auto config = makeConfig(100);
+  EXPECT_THROW(AdaptiveSizeSplit(config, 100), std::invalid_argument);
+  EXPECT_THROW(AdaptiveSizeSplit(config, 4096), std::invalid_argument);
+  config.windowSize = 0;
+  EXPECT_THROW(AdaptiveSizeSplit(config, 512), std::invalid_argument);
+  config = makeConfig(100);
+  config.minSmallItemMaxSize = 4096;
+  EXPECT_THROW(AdaptiveSizeSplit(config, 512), std::invalid_argument);
+}
+
+TEST(AdaptiveSizeSplit, Window) {
+  AdaptiveSizeSplit split{makeConfig(3), 512};
+  // nothing inserted in the window leaves the threshold unchanged
+  EXPECT_EQ(512, split.retune({1000, 0}, {1000, 0}));
+
+  EXPECT_FALSE(split.recordInsert(100, false));
+  EXPECT_FALSE(split.recordInsert(100, false));
+  EXPECT_TRUE(split.recordInsert(100, false));
+  EXPECT_FALSE(split.recordInsert(100, false));
+
+  split.retune({1000, 0}, {1000, 0});
+  // the 100 byte items, limited to halving the threshold
+  EXPECT_EQ(256, split.getThreshold());
+  EXPECT_FALSE(split.recordInsert(100, false));
+  EXPECT_FALSE(split.recordInsert(100, false));
+  EXPECT_TRUE(split.recordInsert(100, false));
+}
+
+TEST(AdaptiveSizeSplit, FollowsSpaceShare) {
+  AdaptiveSizeSplit split{makeConfig(1000), 512};
+
+  // Half of the space is small item engine, so half of the bytes should be
+  // in it: the items up to 400 bytes.
+  insertMixedSizes(split);
+  EXPECT_EQ(472, split.retune({1000, 0}, {1000, 0}));
+
+  // No space for small items. The threshold halves per window down to its
+  // lower bound.
+  insertMixedSizes(split);
+  EXPECT_EQ(236, split.retune({0, 0}, {1000, 0}));
+  insertMixedSizes(split);
+  EXPECT_EQ(128, split.retune({0, 0}, {1000, 0}));
+  insertMixedSizes(split);
+  EXPECT_EQ(128, split.retune({0, 0}, {1000, 0}));
+
+  // All of the space is small item engine: the threshold doubles per window
+  // until all the items are small.
+  insertMixedSizes(split);
+  EXPECT_EQ(256, split.retune({1000, 0}, {0, 0}));
+  for (int i = 0; i < 4; i++) {
+    insertMixedSizes(split);
+    split.retune({1000, 0}, {0, 0});
+  }
+  EXPECT_EQ(1151, split.getThreshold());
+}
+
+TEST(AdaptiveSizeSplit, HitDensity) {
+  // 15% of the space is small item engine. Without any hits that would place
+  // 15% of the bytes, the items up to 400 bytes, in it.
+  AdaptiveSizeSplit coldSmall{makeConfig(1000), 512};
+  AdaptiveSizeSplit hotSmall{makeConfig(1000), 512};
+  for (auto* split : {&coldSmall, &hotSmall}) {
+    // establishes the device bytes written at the start of the window
+    split->retune({150, 1000}, {850, 1000});
+    insertMixedSizes(*split);
+  }
+
+  // Both engines wrote as many bytes to the device. The engine with the hits
+  // gets twice its share of the bytes.
+  for (int i = 0; i < 100; i++) {
+    coldSmall.recordHit(true);
+    hotSmall.recordHit(false);
+  }
+  // 7.5% of the bytes: the 100 byte items, limited to halving the threshold
+  EXPECT_EQ(256, coldSmall.retune({150, 2000}, {850, 2000}));
+  // 30% of the bytes: the items up to 400 bytes
+  EXPECT_EQ(472, hotSmall.retune({150, 2000}, {850, 2000}));
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
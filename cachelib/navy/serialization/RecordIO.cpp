@@ -65,9 +65,10 @@ class FileRecordReader final : public RecordReader {
 
 class DeviceMetaDataWriter final : public RecordWriter {
  public:
-  explicit DeviceMetaDataWriter(Device& dev, size_t metadataSize)
+  DeviceMetaDataWriter(Device& dev, size_t metadataSize, uint64_t baseOffset)
       : dev_(dev),
         metadataSize_{metadataSize},
+        baseOffset_{baseOffset},
         blockSize_{dev_.getIOAlignmentSize() >= kBlockSizeDefault
                        ? dev_.getIOAlignmentSize()
                        : kBlockSizeDefault} {}
@@ -80,7 +81,7 @@ class DeviceMetaDataWriter final : public RecordWriter {
         Buffer buffer = dev_.makeIOBuffer(blockSize_);
         memcpy(buffer.data(), bufferData, bufIndex_);
         memset(buffer.data() + bufIndex_, 0, blockSize_ - bufIndex_);
-        dev_.write(offset_, std::move(buffer));
+        dev_.write(baseOffset_ + offset_, std::move(buffer));
         offset_ += blockSize_;
       }
     }
@@ -89,7 +90,7 @@ class DeviceMetaDataWriter final : public RecordWriter {
       // of metadata clear
       Buffer buffer = dev_.makeIOBuffer(blockSize_);
       memset(buffer.data(), 0, blockSize_);
-      dev_.write(offset_, std::move(buffer));
+      dev_.write(baseOffset_ + offset_, std::move(buffer));
     }
   }
 
@@ -113,7 +114,7 @@ class DeviceMetaDataWriter final : public RecordWriter {
       Buffer buffer = dev_.makeIOBuffer(blockSize_);
       memcpy(buffer.data(), bufferData, blockSize_);
 
-      if (!dev_.write(offset_, std::move(buffer))) {
+      if (!dev_.write(baseOffset_ + offset_, std::move(buffer))) {
         throw std::invalid_argument(
             folly::sformat("write failed: offset = {}", offset_));
       }
@@ -150,13 +151,15 @@ class DeviceMetaDataWriter final : public RecordWriter {
   bool invalidate() override {
     Buffer invalidateBuffer{blockSize_, blockSize_};
     memset(invalidateBuffer.data(), 0, blockSize_);
-    return dev_.write(0, std::move(invalidateBuffer));
+    return dev_.write(baseOffset_, std::move(invalidateBuffer));
   }
 
  private:
   static constexpr size_t kBlockSizeDefault = 4096;
   Device& dev_;
   size_t metadataSize_;
+  // offset of the metadata on the device
+  const uint64_t baseOffset_{};
   const size_t blockSize_;
   uint64_t offset_{0};
   uint32_t bufIndex_{0};
@@ -165,9 +168,10 @@ class DeviceMetaDataWriter final : public RecordWriter {
 
 class DeviceMetaDataReader final : public RecordReader {
  public:
-  explicit DeviceMetaDataReader(Device& dev, size_t metadataSize)
+  DeviceMetaDataReader(Device& dev, size_t metadataSize, uint64_t baseOffset)
       : dev_{dev},
         metadataSize_{metadataSize},
+        baseOffset_{baseOffset},
         blockSize_{dev_.getIOAlignmentSize() >= kBlockSizeDefault
                        ? dev_.getIOAlignmentSize()
                        : kBlockSizeDefault} {}
@@ -192,7 +196,7 @@ class DeviceMetaDataReader final : public RecordReader {
           throw std::logic_error("exceeding metadata limit");
         }
         // read from device to the middle of the buffer 'kReadOffset'
-        if (!dev_.read(offset_, blockSize_, bufferData)) {
+        if (!dev_.read(baseOffset_ + offset_, blockSize_, bufferData)) {
           throw std::invalid_argument(
               folly::sformat("read failed: offset = {}", offset_));
         }
@@ -248,7 +252,7 @@ class DeviceMetaDataReader final : public RecordReader {
     if (offset_ + blockSize_ > metadataSize_) {
       return true;
     }
-    auto res = dev_.read(offset_, blockSize_, headerBuf.data());
+    auto res = dev_.read(baseOffset_ + offset_, blockSize_, headerBuf.data());
     if (!res) {
       return true;
     }
@@ -263,6 +267,8 @@ class DeviceMetaDataReader final : public RecordReader {
   static constexpr size_t kBlockSizeDefault = 4096;
   Device& dev_;
   size_t metadataSize_;
+  // offset of the metadata on the device
+  const uint64_t baseOffset_{};
   const size_t blockSize_;
   uint64_t offset_{0};
   uint64_t bufIndex_{blockSize_};
@@ -272,13 +278,15 @@ class DeviceMetaDataReader final : public RecordReader {
 } // namespace
 
 std::unique_ptr<RecordWriter> createMetadataRecordWriter(Device& dev,
-                                                         size_t metadataSize) {
-  return std::make_unique<DeviceMetaDataWriter>(dev, metadataSize);
+                                                         size_t metadataSize,
+                                                         uint64_t baseOffset) {
+  return std::make_unique<DeviceMetaDataWriter>(dev, metadataSize, baseOffset);
 }
 
 std::unique_ptr<RecordReader> createMetadataRecordReader(Device& dev,
-                                                         size_t metadataSize) {
-  return std::make_unique<DeviceMetaDataReader>(dev, metadataSize);
+                                                         size_t metadataSize,
+                                                         uint64_t baseOffset) {
+  return std::make_unique<DeviceMetaDataReader>(dev, metadataSize, baseOffset);
 }
 
 std::unique_ptr<RecordWriter> createFileRecordWriter(int fd) {
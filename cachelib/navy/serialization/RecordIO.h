@@ -29,13 +29,15 @@ namespace cachelib {
 namespace navy {
 // @param dev           The device the record writer will serialize to
 // @param metadataSize  Reserved space on the device for the serialized metadata
-std::unique_ptr<RecordWriter> createMetadataRecordWriter(Device& dev,
-                                                         size_t metadataSize);
+// @param baseOffset    Offset of the reserved space on the device
+std::unique_ptr<RecordWriter> createMetadataRecordWriter(
+    Device& dev, size_t metadataSize, uint64_t baseOffset = 0);
 
 // @param dev           The device the record reader will deserialize from
 // @param metadataSize  Reserved space on the device for the serialized metadata
-std::unique_ptr<RecordReader> createMetadataRecordReader(Device& dev,
-                                                         size_t metadataSize);
+// @param baseOffset    Offset of the reserved space on the device
+std::unique_ptr<RecordReader> createMetadataRecordReader(
+    Device& dev, size_t metadataSize, uint64_t baseOffset = 0);
 
 // @param fd    The file the record writer will serialize to
 std::unique_ptr<RecordWriter> createFileRecordWriter(int fd);
@@ -92,3 +92,9 @@ struct BigHashPersistentData {
   7: map<i64, i64> deprecated_sizeDist,
   8: i64 usedSizeBytes = 0,
 }
+
+struct CheckpointHeader {
+  1: required i64 checkpointId = 0,
+  2: required i64 generation = 0,
+  3: required bool clean = false,
+}
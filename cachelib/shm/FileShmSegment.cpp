@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/shm/FileShmSegment.h"
+
+#include <fcntl.h>
+#include <folly/logging/xlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+
+constexpr static mode_t kRWMode = 0666;
+typedef struct stat stat_t;
+
+namespace detail {
+
+// defined in PosixShmSegment.cpp
+void ftruncateImpl(int fd, size_t size);
+void fstatImpl(int fd, stat_t* buf);
+void* mmapImpl(
+    void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+void munmapImpl(void* addr, size_t length);
+
+int openImpl(const char* path, int flags) {
+  const int fd = open(path, flags, kRWMode);
+  if (fd != -1) {
+    return fd;
+  }
+
+  switch (errno) {
+  case EEXIST:
+  case EMFILE:
+  case ENFILE:
+  case EACCES:
+  case ENOENT:
+  case EISDIR:
+  case ENOSPC:
+    util::throwSystemError(errno);
+    break;
+  case ENAMETOOLONG:
+  case EINVAL:
+    util::throwSystemError(errno, "Invalid file path");
+    break;
+  default:
+    XDCHECK(false);
+    util::throwSystemError(errno, "Invalid errno");
+  }
+  return kInvalidFD;
+}
+
+void fileUnlinkImpl(const char* const path) {
+  const int ret = unlink(path);
+  if (ret == 0) {
+    return;
+  }
+
+  switch (errno) {
+  case ENOENT:
+  case EACCES:
+  case EPERM:
+  case EBUSY:
+    util::throwSystemError(errno);
+    break;
+  case ENAMETOOLONG:
+  case EINVAL:
+    util::throwSystemError(errno, "Invalid file path");
+    break;
+  default:
+    XDCHECK(false);
+    util::throwSystemError(errno, "Invalid errno");
+  }
+}
+
+} // namespace detail
+
+FileShmSegment::FileShmSegment(ShmAttachT,
+                               const std::string& path,
+                               ShmSegmentOpts opts)
+    : ShmBase(std::move(opts), path), fd_(getExisting(getName(), opts_)) {
+  XDCHECK_NE(fd_, kInvalidFD);
+  markActive();
+  createReferenceMapping();
+}
+
+FileShmSegment::FileShmSegment(ShmNewT,
+                               const std::string& path,
+                               size_t size,
+                               ShmSegmentOpts opts)
+    : ShmBase(std::move(opts), path), fd_(createNewSegment(getName())) {
+  markActive();
+  resize(size);
+  XDCHECK(isActive());
+  XDCHECK_NE(fd_, kInvalidFD);
+  // this ensures that the segment lives while the object lives.
+  createReferenceMapping();
+}
+
+FileShmSegment::~FileShmSegment() {
+  try {
+    // delete the reference mapping so the segment can be deleted if its
+    // marked to be.
+    deleteReferenceMapping();
+  } catch (const std::system_error& e) {
+  }
+
+  // need to close the fd without throwing any exceptions. so we call close
+  // directly.
+  if (fd_ != kInvalidFD) {
+    const int ret = close(fd_);
+    if (ret != 0) {
+      XDCHECK_NE(errno, EIO);
+      XDCHECK_NE(errno, EINTR);
+      XDCHECK_EQ(errno, EBADF);
+      XDCHECK(!errno);
+    }
+  }
+}
+
+int FileShmSegment::createNewSegment(const std::string& path) {
+  constexpr static int createFlags = O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC;
+  return detail::openImpl(path.c_str(), createFlags);
+}
+
+int FileShmSegment::getExisting(const std::string& path,
+                                const ShmSegmentOpts& opts) {
+  int flags = (opts.readOnly ? O_RDONLY : O_RDWR) | O_CLOEXEC;
+  return detail::openImpl(path.c_str(), flags);
+}
+
+void FileShmSegment::markForRemoval() {
+  if (isActive()) {
+    // we still have the fd open. so we can use it to perform ftruncate
+    // even after marking for removal through unlink. The fd does not get
+    // recycled until we actually destroy this object.
+    removeByPath(getName());
+    markForRemove();
+  } else {
+    XDCHECK(false);
+  }
+}
+
+bool FileShmSegment::removeByPath(const std::string& path) {
+  try {
+    detail::fileUnlinkImpl(path.c_str());
+    return true;
+  } catch (const std::system_error& e) {
+    // if someone has already unlinked it for us, we just let it pass.
+    if (e.code().value() != ENOENT) {
+      throw;
+    }
+    return false;
+  }
+}
+
+size_t FileShmSegment::getSize() const {
+  if (isActive() || isMarkedForRemoval()) {
+    stat_t buf = {};
+    detail::fstatImpl(fd_, &buf);
+    return buf.st_size;
+  } else {
+    throw std::runtime_error(folly::sformat(
+        "Trying to get size of segment with path {} in an invalid state",
+        getName()));
+  }
+  return 0;
+}
+
+void FileShmSegment::resize(size_t size) const {
+  size = detail::getPageAlignedSize(size, opts_.pageSize);
+  XDCHECK(isActive() || isMarkedForRemoval());
+  if (isActive() || isMarkedForRemoval()) {
+    XDCHECK_NE(fd_, kInvalidFD);
+    detail::ftruncateImpl(fd_, size);
+  } else {
+    throw std::runtime_error(folly::sformat(
+        "Trying to resize segment with path {} in an invalid state",
+        getName()));
+  }
+}
+
+void* FileShmSegment::mapAddress(void* addr) const {
+  size_t size = getSize();
+  if (!detail::isPageAlignedSize(size, opts_.pageSize) ||
+      !detail::isPageAlignedAddr(addr, opts_.pageSize)) {
+    util::throwSystemError(EINVAL, "Address/size not aligned");
+  }
+
+  // huge pages are only available through hugetlbfs mounts, where the page
+  // size is implied by the mount. So we do not pass any MAP_HUGETLB flags.
+  int flags = MAP_SHARED;
+  // If users pass in an address, they must make sure that address is unused.
+  if (addr != nullptr) {
+    flags |= MAP_FIXED;
+  }
+
+  const int prot = opts_.readOnly ? PROT_READ : PROT_WRITE | PROT_READ;
+
+  void* retAddr = detail::mmapImpl(addr, size, prot, flags, fd_, 0);
+  // if there was hint for mapping, then fail if we cannot respect this
+  // because we want to be specific about mapping to exactly that address.
+  if (retAddr != nullptr && addr != nullptr && retAddr != addr) {
+    util::throwSystemError(EINVAL, "Address already mapped");
+  }
+  XDCHECK(retAddr == addr || addr == nullptr);
+  return retAddr;
+}
+
+void FileShmSegment::unMap(void* addr) const {
+  detail::munmapImpl(addr, getSize());
+}
+
+void FileShmSegment::createReferenceMapping() {
+  // create a mapping that lasts the life of this object. mprotect it to
+  // ensure there are no actual accesses.
+  referenceMapping_ = detail::mmapImpl(nullptr, detail::getPageSize(),
+                                       PROT_NONE, MAP_SHARED, fd_, 0);
+
+  XDCHECK(referenceMapping_ != nullptr);
+}
+
+void FileShmSegment::deleteReferenceMapping() const {
+  if (referenceMapping_ != nullptr) {
+    detail::munmapImpl(referenceMapping_, detail::getPageSize());
+  }
+}
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <string>
+
+#include "cachelib/shm/PosixShmSegment.h"
+#include "cachelib/shm/ShmCommon.h"
+
+namespace facebook {
+namespace cachelib {
+
+/* This class lets you manage a memory segment that is backed by a regular file
+ * identified by its path. This is useful for placing a cache memory tier on a
+ * file system other than /dev/shm, e.g. a tmpfs or a DAX mount of a slower
+ * memory device.
+ *
+ * The semantics follow those of the posix segments. The segment is created by
+ * creating and sizing the file. Marking the segment for removal unlinks the
+ * file; the memory is released once the last mapping goes away.
+ */
+class FileShmSegment : public ShmBase {
+ public:
+  // attach to an existing file segment with the given path
+  //
+  // @param path  path of the backing file
+  // @param opts  the options for attaching to the segment.
+  FileShmSegment(ShmAttachT,
+                 const std::string& path,
+                 ShmSegmentOpts opts = {});
+
+  // create a new segment
+  // @param path  path of the backing file. Must not exist.
+  // @param size  The size of the segment. This will be rounded up to the
+  //              nearest page size.
+  FileShmSegment(ShmNewT,
+                 const std::string& path,
+                 size_t size,
+                 ShmSegmentOpts opts = {});
+
+  // destructor
+  ~FileShmSegment() override;
+
+  std::string getKeyStr() const noexcept override { return getName(); }
+
+  // marks the current segment to be removed once it is no longer mapped
+  // by any process in the kernel.
+  void markForRemoval() override;
+
+  // return the current size of the segment. throws std::system_error
+  // with EINVAL if the segment is invalid or  appropriate errno if the
+  // segment exists but we have a bad fd.
+  size_t getSize() const override;
+
+  // attaches the segment from the start to the address space of the
+  // caller. the address must be page aligned.
+  // @param addr   the start of the address for attaching.
+  //
+  // @return  the address where  the segment was mapped to. This will be same
+  // as addr if addr is not nullptr
+  // @throw std::system_error with EINVAL if the segment is not valid or
+  //        address/length are not page aligned.
+  void* mapAddress(void* addr) const override;
+
+  // unmaps the memory from addr up to the given length from the
+  // address space.
+  void unMap(void* addr) const override;
+
+  // useful for removing without attaching
+  // @return true if the file existed. false otherwise
+  static bool removeByPath(const std::string& path);
+
+ private:
+  static int createNewSegment(const std::string& path);
+  static int getExisting(const std::string& path, const ShmSegmentOpts& opts);
+
+  // resize the segment
+  // @param size  the new size
+  // @return none
+  // @throw  Throws std::system_error with appropriate errno
+  void resize(size_t size) const;
+
+  void createReferenceMapping();
+  void deleteReferenceMapping() const;
+
+  // file descriptor associated with the file. This has FD_CLOEXEC set
+  // and once opened, we close this only on destruction of this object
+  int fd_{kInvalidFD};
+};
+} // namespace cachelib
+} // namespace facebook
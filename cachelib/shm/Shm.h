@@ -22,6 +22,7 @@
 #include <system_error>
 
 #include "cachelib/common/Utils.h"
+#include "cachelib/shm/FileShmSegment.h"
 #include "cachelib/shm/PosixShmSegment.h"
 #include "cachelib/shm/ShmCommon.h"
 #include "cachelib/shm/SysVShmSegment.h"
@@ -46,13 +47,17 @@ class ShmSegment {
   // create a new segment with the given key
   // @param name   name of the segment
   // @param size   size of the segment.
-  // @param opts   the options for the segment.
+  // @param opts   the options for the segment. If opts.filePath is set, the
+  //               segment is backed by that file and name is ignored.
   ShmSegment(ShmNewT,
              std::string name,
              size_t size,
              bool usePosix,
              ShmSegmentOpts opts = {}) {
-    if (usePosix) {
+    if (!opts.filePath.empty()) {
+      segment_ = std::make_unique<FileShmSegment>(ShmNew, opts.filePath, size,
+                                                  opts);
+    } else if (usePosix) {
       segment_ = std::make_unique<PosixShmSegment>(ShmNew, std::move(name),
                                                    size, opts);
     } else {
@@ -63,12 +68,16 @@ class ShmSegment {
 
   // attach to an existing segment with the given key
   // @param name   name of the segment
-  // @param opts   the options for the segment.
+  // @param opts   the options for the segment. If opts.filePath is set, the
+  //               segment is backed by that file and name is ignored.
   ShmSegment(ShmAttachT,
              std::string name,
              bool usePosix,
              ShmSegmentOpts opts = {}) {
-    if (usePosix) {
+    if (!opts.filePath.empty()) {
+      segment_ =
+          std::make_unique<FileShmSegment>(ShmAttach, opts.filePath, opts);
+    } else if (usePosix) {
       segment_ =
           std::make_unique<PosixShmSegment>(ShmAttach, std::move(name), opts);
     } else {
@@ -22,6 +22,7 @@
 #include <sys/shm.h>
 #include <sys/stat.h>
 
+#include <string>
 #include <system_error>
 
 #pragma GCC diagnostic push
@@ -128,6 +129,9 @@ struct ShmSegmentOpts {
   bool readOnly{false};
   size_t alignment{1}; // alignment for mapping.
   NumaBitMask memBindNumaNodes;
+  // when non-empty, the segment is backed by a regular file at this path
+  // instead of a posix or sysv shared memory segment.
+  std::string filePath;
 
   explicit ShmSegmentOpts(PageSizeT p) : pageSize(p) {}
   explicit ShmSegmentOpts(PageSizeT p, bool ro) : pageSize(p), readOnly(ro) {}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "cachelib/shm/FileShmSegment.h"
+#include "cachelib/shm/Shm.h"
+#include "cachelib/shm/tests/common.h"
+
+static const std::string pathPrefix = "/tmp/file-shm-test-";
+
+using namespace facebook::cachelib::tests;
+
+using facebook::cachelib::FileShmSegment;
+using facebook::cachelib::ShmAttach;
+using facebook::cachelib::ShmNew;
+using facebook::cachelib::ShmSegment;
+using facebook::cachelib::ShmSegmentOpts;
+
+class FileShmTest : public ShmTestBase {
+ public:
+  FileShmTest() : segmentPath(pathPrefix + std::to_string((int)::getpid())) {}
+  // use a different path for each test process since they could be run in
+  // parallel.
+  const std::string segmentPath{};
+
+ protected:
+  void TearDown() override {
+    try {
+      FileShmSegment::removeByPath(segmentPath);
+    } catch (const std::system_error& e) {
+      if (e.code().value() != ENOENT) {
+        throw;
+      }
+    }
+  }
+};
+
+TEST_F(FileShmTest, CreateInitialSize) {
+  const size_t initialSize = getRandomSize();
+  FileShmSegment s(ShmNew, segmentPath, initialSize);
+  ASSERT_TRUE(s.isActive());
+  ASSERT_EQ(s.getSize(), initialSize) << "Creating segment with size failed";
+  ASSERT_EQ(0, access(segmentPath.c_str(), F_OK));
+}
+
+TEST_F(FileShmTest, CreateExisting) {
+  const size_t size = getRandomSize();
+  FileShmSegment s(ShmNew, segmentPath, size);
+  ASSERT_THROW(FileShmSegment(ShmNew, segmentPath, size), std::system_error);
+}
+
+TEST_F(FileShmTest, AttachAndMap) {
+  const auto size = getRandomSize();
+  const unsigned char magicVal = 'c';
+  {
+    FileShmSegment tmp(ShmNew, segmentPath, size);
+    auto addr = getNewUnmappedAddr();
+    tmp.mapAddress(addr);
+    writeToMemory(addr, size, magicVal);
+    tmp.unMap(addr);
+  }
+
+  FileShmSegment s(ShmAttach, segmentPath);
+  ASSERT_TRUE(s.isActive());
+  ASSERT_EQ(size, s.getSize());
+  auto addr = s.mapAddress(nullptr);
+  ASSERT_NE(addr, nullptr);
+  checkMemory(addr, size, magicVal);
+  s.unMap(addr);
+}
+
+TEST_F(FileShmTest, AttachToInvalidSegment) {
+  ASSERT_THROW(FileShmSegment(ShmAttach, segmentPath), std::system_error);
+}
+
+TEST_F(FileShmTest, RemoveWithMMap) {
+  const size_t size = getRandomSize();
+  FileShmSegment s(ShmNew, segmentPath, size);
+  const unsigned char magicVal = 'c';
+  auto addr = getNewUnmappedAddr();
+  s.mapAddress(addr);
+  writeToMemory(addr, size, magicVal);
+
+  s.markForRemoval();
+  ASSERT_TRUE(s.isMarkedForRemoval());
+  ASSERT_EQ(s.getSize(), size);
+  ASSERT_NE(0, access(segmentPath.c_str(), F_OK));
+
+  // memory that is already mapped can still be accessed
+  checkMemory(addr, size, magicVal);
+  ASSERT_THROW(FileShmSegment(ShmAttach, segmentPath), std::system_error);
+  s.unMap(addr);
+}
+
+TEST_F(FileShmTest, ShmSegmentDispatch) {
+  const size_t size = getRandomSize();
+  ShmSegmentOpts opts;
+  opts.filePath = segmentPath;
+  ShmSegment s(ShmNew, "ignored", size, true /* posix */, opts);
+  ASSERT_EQ(segmentPath, s.getKeyStr());
+  ASSERT_TRUE(s.mapAddress(nullptr));
+  const auto& mapping = s.getCurrentMapping();
+  writeToMemory(mapping.addr, size, 'x');
+  checkMemory(mapping.addr, size, 'x');
+  s.markForRemoval();
+}